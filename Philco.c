@@ -1,11 +1,11 @@
 /**
  * Transmissor IR Universal com Protocolo NEC
- * Formato: NEC<dispositivo>-<funo>
- * Exemplo: NEC80-14 = dispositivo 0x80, funo 0x14
+ * Formato: NEC<dispositivo>-<função>
+ * Exemplo: NEC80-14 = dispositivo 0x80, função 0x14
  * 
- * Compatvel com a biblioteca nec_transmit que usa:
+ * Compatível com a biblioteca nec_transmit que usa:
  * - Portadora de 38.222 kHz
- * - Timing base de 562.5s
+ * - Timing base de 562.5µs
  * - Dois state machines PIO (carrier_burst + carrier_control)
  */
 
@@ -14,79 +14,81 @@
 #include <stdlib.h>
 #include "pico/stdlib.h"
 #include "hardware/pio.h"
+#include "hardware/timer.h"
 #include "nec_transmit.h"
 #include "nec_receive.h"
+#include "ir_commands.h"
+#include "ir_echo.h"
+#include "ir_verify.h"
+#include "ir_boot.h"
 
-// Configurao de pinos
+// Configuração de pinos
 #define IR_TX_PIN 16    // GPIO para LED IR (com resistor ~1.5k?)
 #define IR_RX_PIN 15    // GPIO para receptor IR (VS1838B ou similar)
 
-// Estrutura para mapear comandos
-typedef struct {
-    const char *name;
-    const char *protocol_code;
-    uint8_t device;
-    uint16_t function;
-} ir_command_t;
+// Tabela de comandos (ir_commands.c)
+#define NUM_COMMANDS ir_command_count
 
-// Tabela de comandos (baseado na sua lista)
-static const ir_command_t command_table[] = {
-    {"KEY_8",           "NEC80-14",  0x80, 0x14},
-    {"KEY_9",           "NEC80-15",  0x80, 0x15},
-    {"PRENSAR",         "NEC80-16",  0x80, 0x16},
-    {"KEY_INFO",        "NEC80-17",  0x80, 0x17},
-    {"SEIVA",           "NEC80-18",  0x80, 0x18},
-    {"TVAV",            "NEC80-19",  0x80, 0x19},
-    {"ULTIMA",          "NEC80-110", 0x80, 0x110},
-    {"KEY_MUTE",        "NEC80-111", 0x80, 0x111},
-    {"KEY_0",           "NEC80-112", 0x80, 0x112},
-    {"KEY_1",           "NEC80-113", 0x80, 0x113},
-    {"KEY_2",           "NEC80-114", 0x80, 0x114},
-    {"KEY_3",           "NEC80-115", 0x80, 0x115},
-    {"EXPOSICAO",       "NEC80-116", 0x80, 0x116},
-    {"TEMPORIZADOR",    "NEC80-117", 0x80, 0x117},
-    {"KEY_VOLUMEUP",    "NEC80-118", 0x80, 0x118},
-    {"PREF",            "NEC80-119", 0x80, 0x119},
-    {"KEY_VOLUMEDOWN",  "NEC80-121", 0x80, 0x121},
-    {"KEY_POWER",       "NEC80-123", 0x80, 0x123},
-    {"KEY_CHANNELDOWN", "NEC80-124", 0x80, 0x124},
-    {"KEY_CHANNELUP",   "NEC80-125", 0x80, 0x125},
-    {"KEY_4",           "NEC80-128", 0x80, 0x128},
-    {"KEY_5",           "NEC80-129", 0x80, 0x129},
-    {"KEY_6",           "NEC80-130", 0x80, 0x130},
-    {"KEY_7",           "NEC80-131", 0x80, 0x131},
-    {"MAGIA",           "NEC80-191", 0x80, 0x191},
-    {"KEY_MENU",        "NEC80-194", 0x80, 0x194},
-};
-
-#define NUM_COMMANDS (sizeof(command_table) / sizeof(ir_command_t))
-
-// Variveis globais PIO
+// Variáveis globais PIO
 static PIO pio;
 static int tx_sm;
 static int rx_sm;
 
+// Quadros recebidos: o DMA esvazia o FIFO RX mesmo com o loop ocupado
+static nec_rx_stream_t rx_stream;
+
+// Janelas dos próprios envios: o RX no mesmo PIO recebe cada um deles
+static ir_echo_t echo;
+
+// Envio verificado: o eco de cada envio confirma a entrega
+static ir_verify_t verify;
+static bool verify_enabled = false;
+
+/**
+ * Coloca um quadro no transmissor e publica a janela dele
+ */
+static bool transmit_frame(uint32_t frame, void *ctx) {
+    if (pio_sm_is_tx_fifo_full(pio, tx_sm)) {
+        return false;
+    }
+    pio_sm_put(pio, tx_sm, frame);
+    ir_boot_mark(IR_BOOT_FIRST_FRAME);
+    ir_echo_publish(&echo, time_us_64(), IR_ECHO_NEC_FRAME_US, frame);
+    return true;
+}
+
 /**
  * Envia comando IR usando o protocolo NEC
  * 
- * O frame  codificado como:
+ * O frame é codificado como:
  * - address (8 bits)
  * - ~address invertido (8 bits)
  * - data/function (8 bits)  
  * - ~data invertido (8 bits)
  * 
- * A biblioteca cuida automaticamente da modulao 38.222kHz
- * e do timing NEC padro (562.5s base)
+ * A biblioteca cuida automaticamente da modulação 38.222kHz
+ * e do timing NEC padrão (562.5µs base)
+ *
+ * @param command Índice na tabela de comandos (IR_VERIFY_UNLISTED se avulso),
+ *                usado nas estatísticas do envio verificado
  */
-void send_ir_command_NEC(uint8_t device, uint8_t function) {
-    // nec_encode_frame j faz: address | (~address << 8) | data << 16 | (~data << 24)
+void send_ir_command_NEC(uint8_t device, uint8_t function, uint16_t command) {
+    // nec_encode_frame já faz: address | (~address << 8) | data << 16 | (~data << 24)
     uint32_t frame = nec_encode_frame(device, function);
     
     // Envia para o state machine PIO
     // A biblioteca usa 2 state machines:
     // - carrier_control_sm (retornado por nec_tx_init) recebe o frame
     // - carrier_burst_sm (interno) gera a portadora 38.222kHz
-    pio_sm_put(pio, tx_sm, frame);
+    if (verify_enabled) {
+        if (!ir_verify_send(&verify, frame, IR_ECHO_NEC_FRAME_US, command, 0, time_us_64())) {
+            printf("? Envio verificado em andamento, aguarde\n");
+            return;
+        }
+    } else if (!transmit_frame(frame, NULL)) {
+        printf("? Transmissor ocupado\n");
+        return;
+    }
     
     printf("? Enviado: Device=0x%02X, Function=0x%02X (Frame=0x%08X)\n", 
            device, function, frame);
@@ -101,7 +103,7 @@ bool parse_protocol(const char *protocol, uint8_t *device, uint8_t *function) {
         return false;
     }
     
-    // Encontra o hfen
+    // Encontra o hífen
     const char *dash = strchr(protocol + 3, '-');
     if (!dash) {
         return false;
@@ -124,12 +126,7 @@ bool parse_protocol(const char *protocol, uint8_t *device, uint8_t *function) {
  * Busca comando por nome
  */
 const ir_command_t* find_command_by_name(const char *name) {
-    for (size_t i = 0; i < NUM_COMMANDS; i++) {
-        if (strcasecmp(command_table[i].name, name) == 0) {
-            return &command_table[i];
-        }
-    }
-    return NULL;
+    return ir_find_command(name);
 }
 
 /**
@@ -139,7 +136,7 @@ bool send_by_protocol(const char *protocol) {
     uint8_t device, function;
     if (parse_protocol(protocol, &device, &function)) {
         printf("Enviando protocolo: %s\n", protocol);
-        send_ir_command_NEC(device, function);
+        send_ir_command_NEC(device, function, IR_VERIFY_UNLISTED);
         return true;
     }
     return false;
@@ -152,41 +149,74 @@ bool send_by_name(const char *name) {
     const ir_command_t *cmd = find_command_by_name(name);
     if (cmd) {
         printf("Enviando comando: %s (%s)\n", cmd->name, cmd->protocol_code);
-        send_ir_command_NEC(cmd->device, cmd->function);
+        send_ir_command_NEC(cmd->device, cmd->function, (uint16_t)(cmd - ir_command_table));
         return true;
     }
     return false;
 }
 
 /**
- * Lista todos os comandos disponveis
+ * Lista todos os comandos disponíveis
  */
 void list_commands() {
-    printf("\n=== Comandos Disponveis ===\n");
+    printf("\n=== Comandos Disponíveis ===\n");
     for (size_t i = 0; i < NUM_COMMANDS; i++) {
         printf("%2zu. %-18s %s\n", i+1, 
-               command_table[i].name, 
-               command_table[i].protocol_code);
+               ir_command_table[i].name, 
+               ir_command_table[i].protocol_code);
     }
     printf("\n");
 }
 
+static void print_stats_line(const char *name, const ir_verify_stats_t *s) {
+    printf("  %-18s %4lu pedidos %4lu entregues (%3u%%) %4lu de primeira %4lu transmissões %4lu falhas\n",
+           name, s->requests, s->delivered, ir_verify_success_pct(s), s->first_try, s->attempts, s->failed);
+}
+
 /**
- * Menu de ajuda
+ * Estatísticas do envio verificado (só comandos já usados)
+ */
+void print_verify_stats() {
+    printf("\n=== Entrega por comando ===\n");
+    for (size_t i = 0; i < NUM_COMMANDS && i < IR_VERIFY_COMMANDS; i++) {
+        if (verify.commands[i].requests) {
+            print_stats_line(ir_command_table[i].name, &verify.commands[i]);
+        }
+    }
+    if (verify.commands[IR_VERIFY_UNLISTED].requests) {
+        print_stats_line("(avulsos)", &verify.commands[IR_VERIFY_UNLISTED]);
+    }
+    printf("=== Entrega por canal ===\n");
+    for (int i = 0; i < IR_VERIFY_CHANNELS; i++) {
+        if (verify.channels[i].requests) {
+            char name[16];
+            snprintf(name, sizeof(name), "TX%d (GPIO %d)", i, IR_TX_PIN);
+            print_stats_line(name, &verify.channels[i]);
+        }
+    }
+    printf("Confirmações tardias: %lu\n\n", verify.late_echoes);
+}
+
+/**
+ * Menu de ajuda (guardado no console de boot até o host conectar)
  */
 void show_help() {
-    printf("\n=== Transmissor IR - Protocolo NEC ===\n");
-    printf("Comandos:\n");
-    printf("  list                  - Lista todos os comandos\n");
-    printf("  send <nome>           - Envia comando por nome\n");
-    printf("  protocol <NECxx-yy>   - Envia por cdigo de protocolo\n");
-    printf("  raw <device> <func>   - Envia valores diretos (hex)\n");
-    printf("  help                  - Mostra esta ajuda\n");
-    printf("\nExemplos:\n");
-    printf("  send KEY_POWER\n");
-    printf("  protocol NEC80-123\n");
-    printf("  raw 80 14\n");
-    printf("\n> ");
+    ir_boot_printf("\n=== Transmissor IR - Protocolo NEC ===\n");
+    ir_boot_printf("Comandos:\n");
+    ir_boot_printf("  list                  - Lista todos os comandos\n");
+    ir_boot_printf("  send <nome>           - Envia comando por nome\n");
+    ir_boot_printf("  protocol <NECxx-yy>   - Envia por código de protocolo\n");
+    ir_boot_printf("  raw <device> <func>   - Envia valores diretos (hex)\n");
+    ir_boot_printf("  echo                  - Estatísticas da supressão de eco\n");
+    ir_boot_printf("  verify <on|off>       - Envio verificado pelo receptor, com repetição\n");
+    ir_boot_printf("  stats                 - Taxa de entrega por comando e por canal\n");
+    ir_boot_printf("  boot                  - Tempos do boot (motores IR, primeiro quadro, console)\n");
+    ir_boot_printf("  help                  - Mostra esta ajuda\n");
+    ir_boot_printf("\nExemplos:\n");
+    ir_boot_printf("  send KEY_POWER\n");
+    ir_boot_printf("  protocol NEC80-123\n");
+    ir_boot_printf("  raw 80 14\n");
+    ir_boot_printf("\n> ");
 }
 
 /**
@@ -197,7 +227,7 @@ void process_command(char *line) {
     char *newline = strchr(line, '\n');
     if (newline) *newline = '\0';
     
-    // Remove espaos iniciais
+    // Remove espaços iniciais
     while (*line == ' ') line++;
     
     if (strlen(line) == 0) {
@@ -215,7 +245,7 @@ void process_command(char *line) {
         char *name = strtok(NULL, " ");
         if (name) {
             if (!send_by_name(name)) {
-                printf("? Comando no encontrado: %s\n", name);
+                printf("? Comando não encontrado: %s\n", name);
             }
         } else {
             printf("? Uso: send <nome>\n");
@@ -225,7 +255,7 @@ void process_command(char *line) {
         char *protocol = strtok(NULL, " ");
         if (protocol) {
             if (!send_by_protocol(protocol)) {
-                printf("? Protocolo invlido: %s\n", protocol);
+                printf("? Protocolo inválido: %s\n", protocol);
             }
         } else {
             printf("? Uso: protocol <NECxx-yy>\n");
@@ -238,11 +268,30 @@ void process_command(char *line) {
             uint8_t device = (uint8_t)strtol(device_str, NULL, 16);
             uint8_t function = (uint8_t)strtol(func_str, NULL, 16);
             printf("Enviando raw: Device=0x%02X, Function=0x%02X\n", device, function);
-            send_ir_command_NEC(device, function);
+            send_ir_command_NEC(device, function, IR_VERIFY_UNLISTED);
         } else {
             printf("? Uso: raw <device> <function> (valores em hex)\n");
         }
         
+    } else if (strcasecmp(cmd, "echo") == 0) {
+        printf("Envios: %lu | Ecos descartados: %lu | Sobrepostos: %lu | Externos: %lu\n",
+               echo.published, echo.echoes, echo.overlaps, echo.external);
+        printf("Quadros perdidos no anel de RX: %lu vez(es)\n", rx_stream.overflows);
+        
+    } else if (strcasecmp(cmd, "verify") == 0) {
+        char *mode = strtok(NULL, " ");
+        if (mode && (strcasecmp(mode, "on") == 0 || strcasecmp(mode, "off") == 0)) {
+            verify_enabled = strcasecmp(mode, "on") == 0;
+        }
+        printf("Envio verificado: %s (até %u tentativas)\n", verify_enabled ? "ligado" : "desligado",
+               verify.max_attempts);
+        
+    } else if (strcasecmp(cmd, "stats") == 0) {
+        print_verify_stats();
+        
+    } else if (strcasecmp(cmd, "boot") == 0) {
+        ir_boot_report();
+        
     } else if (strcasecmp(cmd, "help") == 0) {
         show_help();
         
@@ -255,34 +304,50 @@ void process_command(char *line) {
 
 int main() {
     stdio_init_all();
-    sleep_ms(2000);
-    
-    printf("\n\n??????????????????????????????????????????\n");
-    printf("?  Transmissor IR - Protocolo NEC       ?\n");
-    printf("?  Raspberry Pi Pico                     ?\n");
-    printf("??????????????????????????????????????????\n\n");
+    ir_boot_init();
 
+    // Motores IR primeiro, sem esperar a USB: o texto fica guardado até o
+    // host abrir a porta
     pio = pio0;
+    ir_echo_init(&echo, 0);
+    ir_verify_init(&verify, transmit_frame, NULL, 0);
     
     // Inicializa transmissor NEC
     // nec_tx_init configura DOIS state machines:
     // 1. carrier_burst_sm - gera portadora 38.222kHz no pino IR_TX_PIN
     // 2. carrier_control_sm - controla timing dos pulsos (retorna este SM)
     tx_sm = nec_tx_init(pio, IR_TX_PIN);
+    if (tx_sm != -1) {
+        ir_boot_mark(IR_BOOT_TX_READY);
+    }
     
     // Inicializa receptor NEC (opcional, para debug/feedback)
     rx_sm = nec_rx_init(pio, IR_RX_PIN);
+    if (rx_sm != -1 && !nec_rx_stream_init(&rx_stream, pio, rx_sm)) {
+        rx_sm = -1;                             // Sem canais de DMA livres
+    }
+    if (rx_sm != -1) {
+        ir_boot_mark(IR_BOOT_RX_READY);
+    }
+    
+    ir_boot_printf("\n\n??????????????????????????????????????????\n");
+    ir_boot_printf("?  Transmissor IR - Protocolo NEC       ?\n");
+    ir_boot_printf("?  Raspberry Pi Pico                     ?\n");
+    ir_boot_printf("??????????????????????????????????????????\n\n");
 
     if (tx_sm == -1 || rx_sm == -1) {
-        printf("? ERRO: No foi possvel configurar o PIO\n");
-        printf("  Certifique-se que h state machines disponveis no PIO0\n");
-        printf("  TX requer 2 SMs, RX requer 1 SM = total 3 SMs necessrios\n");
+        ir_boot_printf("? ERRO: Não foi possível configurar o PIO\n");
+        ir_boot_printf("  Certifique-se que há state machines disponíveis no PIO0\n");
+        ir_boot_printf("  TX requer 2 SMs, RX requer 1 SM e 2 canais de DMA = total 3 SMs necessários\n");
+        while (!ir_boot_poll()) {
+            sleep_ms(10);
+        }
         return -1;
     }
 
-    printf("? PIO configurado com sucesso!\n");
-    printf("  TX: GPIO %d | RX: GPIO %d\n", IR_TX_PIN, IR_RX_PIN);
-    printf("  %zu comandos carregados\n\n", NUM_COMMANDS);
+    ir_boot_printf("? PIO configurado com sucesso!\n");
+    ir_boot_printf("  TX: GPIO %d | RX: GPIO %d\n", IR_TX_PIN, IR_RX_PIN);
+    ir_boot_printf("  %zu comandos carregados\n\n", NUM_COMMANDS);
     
     show_help();
 
@@ -292,7 +357,9 @@ int main() {
 
     // Loop principal
     while (true) {
-        // L caractere da entrada
+        ir_boot_poll();
+        
+        // Lê caractere da entrada
         int c = getchar_timeout_us(1000);
         
         if (c != PICO_ERROR_TIMEOUT) {
@@ -316,16 +383,36 @@ int main() {
             }
         }
         
-        // Verifica recepo IR
-        if (!pio_sm_is_rx_fifo_empty(pio, rx_sm)) {
-            uint32_t rx_frame = pio_sm_get(pio, rx_sm);
-            uint8_t rx_device, rx_function;
+        // Verifica recepção IR
+        nec_rx_event_t rx;
+        while (nec_rx_stream_next(&rx_stream, &rx)) {
+            // O quadro termina de chegar quando o PIO o entrega ao FIFO, que
+            // é o instante gravado pelo DMA
+            uint64_t rx_end = rx.time_us;
+            ir_echo_result_t origem = ir_echo_classify(&echo, rx_end - IR_ECHO_NEC_FRAME_US, rx_end, rx.frame);
             
-            if (nec_decode_frame(rx_frame, &rx_device, &rx_function)) {
-                printf("\n[RX] NEC%02X-%d (Device=0x%02X, Function=0x%02X)\n> ", 
-                       rx_device, rx_function, rx_device, rx_function);
+            // Eco do próprio envio: confirma o envio verificado e não é mostrado
+            if (origem == IR_ECHO_SELF) {
+                ir_verify_on_rx(&verify, rx.frame, rx_end);
+            } else if (rx.valid) {
+                printf("\n[RX%s] NEC%02X-%d (Device=0x%02X, Function=0x%02X)\n> ", 
+                       origem == IR_ECHO_OVERLAP ? " durante envio" : "",
+                       rx.address, rx.data, rx.address, rx.data);
             }
         }
+        
+        // Prazos e repetições do envio verificado
+        switch (ir_verify_poll(&verify, time_us_64())) {
+            case IR_VERIFY_DELIVERED:
+                printf("\n? Entrega confirmada (tentativa %u, %llu ms)\n> ", verify.last_attempts,
+                       (unsigned long long)(verify.last_latency_us / 1000));
+                break;
+            case IR_VERIFY_FAILED:
+                printf("\n? Sem confirmação após %u tentativas\n> ", verify.last_attempts);
+                break;
+            default:
+                break;
+        }
     }
 
     return 0;
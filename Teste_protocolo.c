@@ -3,18 +3,31 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 #include "pico/stdlib.h"
 #include "pico/time.h"
 #include "hardware/gpio.h"
 #include "custom_ir.h"
+#include "ac_state.h"
+#include "ir_scheduler.h"
+#include "ir_scene.h"
+#include "ir_boot.h"
 
-// Configuraes
-#define IR_PIN 16          // Pino para sada IR
+// Configurações
+#define IR_PIN 16          // Pino para saída IR
 #define LED_PIN 25        // LED onboard do Pico
-#define BUTTON_PIN 17     // Pino do boto para teste
+#define BUTTON_PIN 17     // Pino do botão para teste
 
 int current_state_novo = 20;
 
+// Estado desejado x enviado (rajadas de toques viram um único envio)
+static ac_reconciler_t ac;
+
+// Cenas (sequências de comandos) rodando pela agenda, sem bloquear o laço
+static ir_scheduler_t agenda;
+static ir_scene_engine_t cenas;
+static uint32_t cenas_recusadas = 0;    // Último valor de cenas.unsupported já avisado
+
 // Estados do sistema
 typedef enum {
     STATE_OFF,
@@ -26,7 +39,7 @@ typedef enum {
 
 static system_state_t current_state = STATE_OFF;
 
-// Callback para boto
+// Callback para botão
 void button_callback(uint gpio, uint32_t events) {
     static uint32_t last_time = 0;
     uint32_t current_time = to_ms_since_boot(get_absolute_time());
@@ -37,13 +50,15 @@ void button_callback(uint gpio, uint32_t events) {
     }
     last_time = current_time;
     
-    // Avana para o prximo estado
+    // Avança para o próximo estado
     current_state = (current_state + 1) % STATE_MAX;
     
 }
 
 void comando_ir(){
-    // Executa ao baseada no estado
+    uint32_t now = to_ms_since_boot(get_absolute_time());
+
+    // Mudança de estado pelo botão: só atualiza o estado desejado
     if (current_state_novo != current_state){
 
         current_state_novo = current_state;
@@ -52,25 +67,25 @@ void comando_ir(){
         case STATE_OFF:
             printf("Estado: DESLIGADO\n");
             gpio_put(LED_PIN, 0);
-            turn_off_ac();
+            ac_reconciler_set_power(&ac, false, now);
             break;
             
         case State_on:
             printf("Estado: LIGADO\n");
             gpio_put(LED_PIN, 1);
-            turn_on_ac();
+            ac_reconciler_set_power(&ac, true, now);
             break;
             
         case Temp_20:
-            printf("Estado: LIGADO - 20C\n");
+            printf("Estado: LIGADO - 20°C\n");
             gpio_put(LED_PIN, 1);
-            set_temp_20c();
+            ac_reconciler_set_temp(&ac, 20, now);
             break;
 
         case Temp_22:
-            printf("Estado: LIGADO - 22C\n");
+            printf("Estado: LIGADO - 22°C\n");
             gpio_put(LED_PIN, 1);
-            set_temp_22c();
+            ac_reconciler_set_temp(&ac, 22, now);
             break;
             
         default:
@@ -78,30 +93,55 @@ void comando_ir(){
     }
     }
 
+    // Passado o intervalo sem toques, envia só o necessário para o estado final
+    ir_signal_type_t commands[AC_MAX_COMMANDS];
+    size_t n = ac_reconciler_poll(&ac, now, commands);
+    for (size_t i = 0; i < n; i++) {
+        send_ir_command(commands[i]);
+    }
+    if (n > 0) {
+        printf("Enviado(s) %d quadro(s) | pedidos: %lu, envios: %lu, descartados: %lu\n",
+               (int)n, (unsigned long)ac.changes, (unsigned long)ac.commits, (unsigned long)ac.suppressed);
+    }
 }
-// Configurao do boto
+// Configuração do botão
 void setup_button() {
     gpio_init(BUTTON_PIN);
     gpio_set_dir(BUTTON_PIN, GPIO_IN);
     gpio_pull_up(BUTTON_PIN);
     
-    // Configurar interrupo
+    // Configurar interrupção
     gpio_set_irq_enabled_with_callback(BUTTON_PIN, GPIO_IRQ_EDGE_FALL, true, &button_callback);
 }
 
-// Menu de comandos via UART
+// Menu de comandos via UART (guardado no console de boot até o host conectar)
 void show_menu() {
-    printf("\n=== CONTROLE IR - AR CONDICIONADO ===\n");
-    printf("1 - Ligar AC\n");
-    printf("2 - Desligar AC\n");
-    printf("3 - Temperatura 22C\n");
-    printf("4 - Temperatura 20C\n");
-    printf("5 - Ventilador Nvel 1\n");
-    printf("6 - Ventilador Nvel 2\n");
-    printf("7 - Mostrar estado atual\n");
-    printf("0 - Mostrar menu\n");
-    printf("====================================\n");
-    printf("Digite uma opo: ");
+    ir_boot_printf("\n=== CONTROLE IR - AR CONDICIONADO ===\n");
+    ir_boot_printf("1 - Ligar AC\n");
+    ir_boot_printf("2 - Desligar AC\n");
+    ir_boot_printf("3 - Temperatura 22°C\n");
+    ir_boot_printf("4 - Temperatura 20°C\n");
+    ir_boot_printf("5 - Ventilador Nível 1\n");
+    ir_boot_printf("6 - Ventilador Nível 2\n");
+    ir_boot_printf("7 - Mostrar estado atual\n");
+    ir_boot_printf("0 - Mostrar menu\n");
+    ir_boot_printf("====================================\n");
+    ir_boot_printf("Digite uma opção: ");
+}
+
+// Inicia uma cena de custom_ir.c pelo nome
+void iniciar_cena(const char *nome) {
+    const ir_named_scene_t *lista;
+    size_t n = get_scenes(&lista);
+    for (size_t i = 0; i < n; i++) {
+        if (strcmp(lista[i].name, nome) == 0) {
+            if (ir_scene_start(&cenas, lista[i].code, lista[i].length) < 0) {
+                printf("Nenhuma cena livre, tente mais tarde\n");
+            }
+            return;
+        }
+    }
+    printf("Cena não encontrada: %s\n", nome);
 }
 
 // Processa comandos do teclado
@@ -112,45 +152,47 @@ void process_uart_input() {
     }
     
     printf("%c\n", ch);
+
+    uint32_t now = to_ms_since_boot(get_absolute_time());
     
     switch (ch) {
         case '1':
-            printf("Enviando comando: LIGAR\n");
-            turn_on_ac();
-            current_state = State_on;
+            printf("Pedido: LIGAR\n");
+            ac_reconciler_set_power(&ac, true, now);
+            current_state = current_state_novo = State_on;
             gpio_put(LED_PIN, 1);
             break;
             
         case '2':
-            printf("Enviando comando: DESLIGAR\n");
-            turn_off_ac();
-            current_state = STATE_OFF;
+            printf("Pedido: DESLIGAR\n");
+            ac_reconciler_set_power(&ac, false, now);
+            current_state = current_state_novo = STATE_OFF;
             gpio_put(LED_PIN, 0);
             break;
             
         case '3':
-            printf("Enviando comando: TEMPERATURA 22C\n");
-            set_temp_22c();
+            printf("Pedido: TEMPERATURA 22°C\n");
+            ac_reconciler_set_temp(&ac, 22, now);
             break;
             
         case '4':
-            printf("Enviando comando: TEMPERATURA 20C\n");
-            set_temp_20c();
+            printf("Pedido: TEMPERATURA 20°C\n");
+            ac_reconciler_set_temp(&ac, 20, now);
             break;
             
         case '5':
-            printf("Enviando comando: VENTILADOR NVEL 1\n");
-            set_fan_level_1();
+            printf("Pedido: VENTILADOR NÍVEL 1\n");
+            ac_reconciler_set_fan(&ac, 1, now);
             break;
             
         case '6':
-            printf("Enviando comando: VENTILADOR NVEL 2\n");
-            set_fan_level_2();
+            printf("Pedido: VENTILADOR NÍVEL 2\n");
+            ac_reconciler_set_fan(&ac, 2, now);
             break;
             
         case '7':
-            printf("Iniciando demonstrao automtica...\n");
-            ir_demo();
+            printf("Iniciando demonstração automática...\n");
+            iniciar_cena("scene_demo");
             break;
             
         case '8':
@@ -160,10 +202,10 @@ void process_uart_input() {
                     printf("DESLIGADO\n");
                     break;
                 case State_on:
-                    printf("LIGADO - 22C - Fan 1\n");
+                    printf("LIGADO - 22°C - Fan 1\n");
                     break;
                 case Temp_20:
-                    printf("LIGADO - 20C - Fan 2\n");
+                    printf("LIGADO - 20°C - Fan 2\n");
                     break;
                 default:
                     printf("DESCONHECIDO\n");
@@ -176,7 +218,7 @@ void process_uart_input() {
             break;
             
         default:
-            printf("Opo invlida! Digite '0' para ver o menu.\n");
+            printf("Opção inválida! Digite '0' para ver o menu.\n");
             break;
     }
 }
@@ -184,26 +226,31 @@ void process_uart_input() {
 int main() {
     // Inicializar stdio
     stdio_init_all();
+    ir_boot_init();
     
-    // Aguardar conexo USB (opcional)
-    sleep_ms(2000);
-    
-    printf("\n\n=== SISTEMA IR PARA AR CONDICIONADO ===\n");
-    printf("Raspberry Pi Pico - Protocolo Customizado\n\n");
+    // Sistema IR primeiro, sem esperar a USB: o texto fica guardado até o
+    // host abrir a porta
+    bool ir_ok = custom_ir_init(IR_PIN);
+    if (ir_ok) {
+        ir_boot_mark(IR_BOOT_TX_READY);
+    }
     
     // Configurar LED
     gpio_init(LED_PIN);
     gpio_set_dir(LED_PIN, GPIO_OUT);
     gpio_put(LED_PIN, 0);
     
-    // Configurar boto
+    ir_boot_printf("\n\n=== SISTEMA IR PARA AR CONDICIONADO ===\n");
+    ir_boot_printf("Raspberry Pi Pico - Protocolo Customizado\n\n");
+    
+    // Configurar botão
     setup_button();
-    printf("Boto configurado no pino %d\n", BUTTON_PIN);
+    ir_boot_printf("Botão configurado no pino %d\n", BUTTON_PIN);
     
-    // Inicializar sistema IR
-    if (!custom_ir_init(IR_PIN)) {
-        printf("ERRO: Falha ao inicializar sistema IR!\n");
+    if (!ir_ok) {
+        ir_boot_printf("ERRO: Falha ao inicializar sistema IR!\n");
         while (1) {
+            ir_boot_poll();
             gpio_put(LED_PIN, 1);
             sleep_ms(100);
             gpio_put(LED_PIN, 0);
@@ -211,23 +258,36 @@ int main() {
         }
     }
     
-    printf("Sistema IR inicializado no pino %d\n", IR_PIN);
-    printf("Pronto para uso!\n");
+    ir_boot_printf("Sistema IR inicializado no pino %d\n", IR_PIN);
+    ir_boot_printf("Pronto para uso!\n");
+
+    ac_reconciler_init(&ac, AC_COMMIT_DELAY_MS);
+    ir_scheduler_init(&agenda, to_ms_since_boot(get_absolute_time()));
+    ir_scene_engine_init(&cenas, &agenda, ir_scene_send_raw, NULL);
     
     // Mostrar menu inicial
     show_menu();
-
-    custom_ir_init(IR_PIN);
     
     // Loop principal
     while (1) {
+        // Texto guardado do boot assim que o host abrir a porta
+        ir_boot_poll();
+        
         // Processar comandos UART
         process_uart_input();
 
-        // Comandos a depender do boto
+        // Comandos a depender do botão
         comando_ir();
+
+        // Passos das cenas vencidos e próximo envio da fila
+        ir_scheduler_advance(&agenda, to_ms_since_boot(get_absolute_time()));
+        ir_scene_pump(&cenas);
+        if (cenas.unsupported != cenas_recusadas) {
+            cenas_recusadas = cenas.unsupported;
+            printf("Cena: quadro sem transmissor para o alvo descartado (%u no total)\n", (unsigned)cenas_recusadas);
+        }
         
-        // Pequena pausa para no sobrecarregar o sistema
+        // Pequena pausa para não sobrecarregar o sistema
         sleep_ms(10);
     }
     
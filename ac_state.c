@@ -0,0 +1,149 @@
+/**
+ * ac_state.c - Reconciliação do estado do ar condicionado
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <string.h>
+
+#include "ac_state.h"
+
+// Estado que cada quadro da biblioteca deixa no aparelho, lido dos bytes 5 a 8
+// decodificados (byte 5: ligado em 0x04; byte 7: 31 - temperatura; byte 8:
+// 0x12 ventilador 1, 0x13 ventilador 2). O de ligar vem em outro modo (byte 6
+// 0x13 e byte 8 0x22), sem nível de ventilador equivalente. Na busca com campos
+// UNSET vale o primeiro da tabela: ventilador 1 sozinho é o quadro de
+// ventilador e 20°C sozinho o de temperatura.
+typedef struct {
+    ir_signal_type_t command;
+    ac_state_t state;
+} ac_frame_t;
+
+static const ac_frame_t frames[] = {
+    {IR_FAN_1, {true, 21, 1}},              // 24 33 0A 12
+    {IR_FAN_2, {true, 21, 2}},              // 24 33 0A 13
+    {IR_TEMP_20, {true, 20, 1}},            // 24 33 0B 12
+    {IR_TEMP_22, {true, 22, 1}},            // 24 33 09 12
+    {IR_ON, {true, 20, AC_FAN_UNSET}},      // 24 13 0B 22
+};
+
+static bool same_state(const ac_state_t *a, const ac_state_t *b) {
+    return a->power == b->power && a->temp_c == b->temp_c && a->fan == b->fan;
+}
+
+// Primeiro quadro com a temperatura e o ventilador pedidos (UNSET aceita qualquer um)
+static const ac_frame_t *find_frame(uint8_t temp_c, uint8_t fan) {
+    for (size_t i = 0; i < sizeof(frames) / sizeof(frames[0]); i++) {
+        const ac_state_t *s = &frames[i].state;
+        if ((temp_c == AC_TEMP_UNSET || s->temp_c == temp_c) && (fan == AC_FAN_UNSET || s->fan == fan)) {
+            return &frames[i];
+        }
+    }
+    return NULL;
+}
+
+static const ac_frame_t *frame_of(ir_signal_type_t command) {
+    for (size_t i = 0; i < sizeof(frames) / sizeof(frames[0]); i++) {
+        if (frames[i].command == command) {
+            return &frames[i];
+        }
+    }
+    return NULL;
+}
+
+bool ac_state_command(const ac_state_t *state, ir_signal_type_t *command) {
+    for (size_t i = 0; i < sizeof(frames) / sizeof(frames[0]); i++) {
+        if (same_state(&frames[i].state, state)) {
+            *command = frames[i].command;
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t ac_state_diff(const ac_state_t *from, const ac_state_t *to, ir_signal_type_t *commands) {
+    // Desligado: só o quadro de desligar importa
+    if (!to->power) {
+        if (!from || from->power) {
+            commands[0] = IR_OFF;
+            return 1;
+        }
+        return 0;
+    }
+
+    // Um quadro sobrescreve o estado inteiro: nunca mais de um por envio
+    if (from && same_state(from, to)) {
+        return 0;
+    }
+    return ac_state_command(to, &commands[0]) ? 1 : 0;
+}
+
+void ac_reconciler_init(ac_reconciler_t *r, uint32_t commit_delay_ms) {
+    memset(r, 0, sizeof(*r));
+    r->commit_delay_ms = commit_delay_ms;
+}
+
+bool ac_reconciler_set(ac_reconciler_t *r, const ac_state_t *desired, uint32_t now_ms) {
+    ac_state_t next = r->desired;
+    next.power = desired->power;
+
+    if (desired->power && (desired->temp_c != AC_TEMP_UNSET || desired->fan != AC_FAN_UNSET)) {
+        // A tecla assume o estado completo do seu quadro
+        const ac_frame_t *frame = find_frame(desired->temp_c, desired->fan);
+        if (!frame) {
+            r->rejected++;
+            return false;
+        }
+        next = frame->state;
+    } else if (desired->power && !r->desired.power) {
+        // Só ligar: o quadro de ligar (já ligado, nada muda)
+        next = frame_of(IR_ON)->state;
+    }
+
+    r->desired = next;
+    r->dirty = true;
+    r->last_change_ms = now_ms;
+    r->changes++;
+    return true;
+}
+
+void ac_reconciler_set_power(ac_reconciler_t *r, bool power, uint32_t now_ms) {
+    ac_state_t state = {.power = power};
+    ac_reconciler_set(r, &state, now_ms);
+}
+
+// Mudar temperatura ou ventilador implica ligar (o quadro já vai com o aparelho ligado)
+bool ac_reconciler_set_temp(ac_reconciler_t *r, uint8_t temp_c, uint32_t now_ms) {
+    ac_state_t state = {.power = true, .temp_c = temp_c};
+    return ac_reconciler_set(r, &state, now_ms);
+}
+
+bool ac_reconciler_set_fan(ac_reconciler_t *r, uint8_t fan, uint32_t now_ms) {
+    ac_state_t state = {.power = true, .fan = fan};
+    return ac_reconciler_set(r, &state, now_ms);
+}
+
+size_t ac_reconciler_poll(ac_reconciler_t *r, uint32_t now_ms, ir_signal_type_t *commands) {
+    if (!r->dirty || now_ms - r->last_change_ms < r->commit_delay_ms) {
+        return 0;
+    }
+    r->dirty = false;
+
+    size_t n = ac_state_diff(r->sent_known ? &r->sent : NULL, &r->desired, commands);
+    if (n == 0) {
+        r->suppressed++;
+        return 0;
+    }
+
+    // Desligado, temperatura e ventilador do aparelho continuam os últimos enviados
+    if (r->desired.power) {
+        r->sent = r->desired;
+    } else {
+        r->sent.power = false;
+    }
+    r->sent_known = true;
+    r->commits++;
+    r->frames += n;
+    return n;
+}
@@ -0,0 +1,126 @@
+/**
+ * ac_state.h - Estado desejado do ar condicionado e envio consolidado
+ *
+ * Os botões e a UART só alteram o estado desejado. Depois de um intervalo sem
+ * novas alterações (commit delay), o reconciliador compara o desejado com o
+ * último estado enviado e escolhe o quadro que leva o aparelho ao estado
+ * final: rajadas de toques viram um único envio, estados intermediários não
+ * são transmitidos e, se nada mudou, nada é enviado.
+ *
+ * Cada quadro Philco carrega o estado completo (ligado, temperatura e
+ * ventilador), então o quadro seguinte sobrescreve tudo o que o anterior
+ * definiu. A biblioteca só tem um quadro por tecla: os de temperatura vão com
+ * o ventilador 1 e os de ventilador com 21°C. Por isso o desejado é sempre o
+ * estado de um desses quadros: uma tecla assume o estado completo do seu
+ * quadro, e uma combinação sem quadro (22°C com ventilador 2) é recusada.
+ * Ligar e mudar a temperatura ao mesmo tempo continua custando um quadro.
+ *
+ * O módulo não lê o relógio: o tempo chega por parâmetro, o que permite
+ * simular rajadas no host com o relógio virtual.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef AC_STATE_H
+#define AC_STATE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "pico/types.h"
+#include "custom_ir.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AC_COMMIT_DELAY_MS 400      // Silêncio dos botões antes de enviar
+#define AC_MAX_COMMANDS 1           // Comandos por envio (o quadro leva o estado completo)
+
+#define AC_TEMP_UNSET 0             // Temperatura ainda não escolhida
+#define AC_FAN_UNSET 0              // Ventilador ainda não escolhido
+
+// Estado do aparelho
+typedef struct {
+    bool power;
+    uint8_t temp_c;     // 20, 21 ou 22 (AC_TEMP_UNSET = não altera)
+    uint8_t fan;        // 1 ou 2 (AC_FAN_UNSET = não altera; no estado de um quadro, modo do quadro de ligar)
+} ac_state_t;
+
+typedef struct {
+    ac_state_t desired;
+    ac_state_t sent;
+    bool sent_known;                // Falso até o primeiro envio (estado do aparelho desconhecido)
+    bool dirty;                     // Desejado alterado desde o último envio
+    uint32_t commit_delay_ms;
+    uint32_t last_change_ms;
+
+    // Contadores
+    uint32_t changes;               // Alterações pedidas
+    uint32_t commits;               // Envios que transmitiram algo
+    uint32_t suppressed;            // Envios descartados (desejado == enviado)
+    uint32_t rejected;              // Pedidos sem quadro na biblioteca
+    uint32_t frames;                // Quadros gerados
+} ac_reconciler_t;
+
+/**
+ * Prepara o reconciliador
+ *
+ * @param r Estado
+ * @param commit_delay_ms Intervalo sem alterações antes de enviar
+ */
+void ac_reconciler_init(ac_reconciler_t *r, uint32_t commit_delay_ms);
+
+/**
+ * Altera o estado desejado (não transmite nada)
+ *
+ * Ligado, o desejado passa a ser o estado do primeiro quadro com a
+ * temperatura e o ventilador pedidos (campos UNSET aceitam qualquer valor).
+ * Sem nenhum dos dois, ligar um aparelho desligado usa o quadro de ligar e,
+ * se já estava ligado, mantém o estado.
+ *
+ * @param desired Novo estado
+ * @param now_ms Instante da alteração
+ * @return false se nenhum quadro da biblioteca deixa o aparelho nesse estado
+ *         (o desejado não muda)
+ */
+bool ac_reconciler_set(ac_reconciler_t *r, const ac_state_t *desired, uint32_t now_ms);
+
+void ac_reconciler_set_power(ac_reconciler_t *r, bool power, uint32_t now_ms);
+bool ac_reconciler_set_temp(ac_reconciler_t *r, uint8_t temp_c, uint32_t now_ms);
+bool ac_reconciler_set_fan(ac_reconciler_t *r, uint8_t fan, uint32_t now_ms);
+
+/**
+ * Verifica se é hora de enviar e calcula os comandos mínimos
+ *
+ * Os comandos devolvidos já são considerados enviados.
+ *
+ * @param now_ms Instante atual
+ * @param commands Recebe os comandos (espaço para AC_MAX_COMMANDS)
+ * @return Quantidade de comandos a transmitir (0 se ainda não é hora ou se nada mudou)
+ */
+size_t ac_reconciler_poll(ac_reconciler_t *r, uint32_t now_ms, ir_signal_type_t *commands);
+
+/**
+ * Quadro da biblioteca que deixa o aparelho exatamente no estado dado
+ *
+ * @return false se nenhum quadro tem esse estado completo
+ */
+bool ac_state_command(const ac_state_t *state, ir_signal_type_t *command);
+
+/**
+ * Calcula o quadro que leva o aparelho de from até to
+ *
+ * @param from Estado atual (NULL = desconhecido)
+ * @return Quantidade de comandos em commands (0 se nada muda ou se nenhum
+ *         quadro tem o estado to)
+ */
+size_t ac_state_diff(const ac_state_t *from, const ac_state_t *to, ir_signal_type_t *commands);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AC_STATE_H
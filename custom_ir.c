@@ -8,234 +8,70 @@
 #include "hardware/clocks.h"
 #include "hardware/pwm.h"
 #include "hardware/gpio.h"
+#include "custom_ir.h"
+#include "ir_scene.h"
+#include "ir_boot.h"
+#include "ir_signals.h"
 
-// Definies do protocolo
+// Definições do protocolo
 #define IR_CARRIER_FREQ 38000  // 38kHz
-#define IR_GPIO_PIN 2          // Pino de sada IR
-
-// Estados dos sinais IR
-typedef enum {
-    IR_OFF,
-    IR_ON,
-    IR_TEMP_22,
-    IR_TEMP_20,
-    IR_FAN_1,
-    IR_FAN_2
-} ir_signal_type_t;
-
-// Estrutura para armazenar sinais RAW
-typedef struct {
-    const uint16_t* data;
-    size_t length;
-} ir_raw_signal_t;
-
-// Sinais RAW (do seu cdigo original)
-static const uint16_t rawSignal_off[] = {
-    3603, 1758, 360, 1359, 404, 1362, 405, 344, 423, 352, 426, 348, 
-    404, 1335, 429, 345, 427, 348, 413, 1338, 404, 1361, 404, 345, 
-    427, 1312, 429, 345, 426, 348, 421, 1319, 428, 1335, 362, 426, 
-    406, 1334, 403, 1333, 405, 345, 427, 347, 408, 1358, 403, 344, 
-    407, 368, 390, 1361, 403, 373, 426, 349, 403, 372, 410, 364, 
-    426, 349, 427, 347, 427, 348, 391, 423, 406, 345, 425, 349, 
-    426, 348, 426, 349, 404, 370, 403, 372, 411, 364, 413, 401, 
-    406, 343, 426, 349, 427, 348, 403, 371, 412, 1354, 403, 344, 
-    426, 349, 415, 399, 405, 344, 403, 372, 403, 1338, 427, 1334, 
-    404, 345, 404, 371, 414, 360, 416, 1336, 403, 1362, 404, 1333, 
-    406, 343, 413, 363, 410, 364, 402, 373, 426, 349, 415, 399, 
-    404, 345, 403, 372, 404, 1336, 427, 1335, 404, 1334, 404, 345, 
-    403, 372, 415, 399, 405, 344, 403, 372, 403, 372, 402, 372, 
-    402, 373, 402, 373, 402, 372, 416, 398, 405, 345, 427, 348, 
-    425, 350, 426, 348, 427, 348, 427, 348, 428, 347, 415, 398, 
-    381, 394, 381, 394, 380, 394, 380, 395, 380, 395, 378, 396, 
-    378, 397, 398, 391, 352, 423, 352, 422, 352, 423, 376, 399, 
-    379, 395, 383, 392, 383, 392, 399, 367, 405, 370, 404, 1331, 
-    402, 1336, 401, 376, 401, 373, 401, 374, 399, 1337, 414
-};
-
-static const uint16_t rawSignal_on[] = {
-    3585, 1762, 354, 1393, 411, 1328, 413, 342, 392, 383, 364, 411, 
-    388, 1369, 409, 346, 365, 410, 445, 1326, 414, 1324, 412, 344, 
-    389, 1368, 408, 347, 366, 409, 365, 1393, 408, 1329, 386, 384, 
-    364, 1393, 410, 1329, 409, 346, 364, 411, 364, 1392, 386, 370, 
-    365, 410, 444, 1327, 410, 346, 363, 412, 363, 412, 363, 411, 
-    364, 410, 364, 411, 364, 411, 442, 347, 364, 410, 365, 410, 
-    363, 411, 391, 384, 364, 411, 365, 410, 363, 411, 447, 342, 
-    365, 410, 364, 1392, 409, 348, 364, 410, 390, 1366, 410, 347, 
-    391, 384, 444, 1326, 411, 1327, 412, 344, 395, 380, 395, 1361, 
-    410, 347, 394, 381, 395, 379, 446, 1324, 384, 1353, 391, 367, 
-    399, 1356, 411, 347, 398, 377, 400, 374, 401, 374, 444, 344, 
-    402, 1353, 414, 344, 403, 372, 403, 372, 429, 1325, 415, 345, 
-    429, 349, 439, 362, 413, 361, 416, 368, 403, 372, 380, 394, 
-    379, 396, 378, 397, 376, 399, 390, 377, 402, 369, 401, 398, 
-    378, 374, 400, 374, 399, 375, 399, 375, 396, 380, 407, 381, 
-    390, 384, 366, 409, 364, 411, 365, 409, 366, 409, 386, 388, 
-    389, 386, 378, 411, 364, 411, 363, 412, 362, 412, 363, 412, 
-    364, 410, 364, 411, 363, 412, 375, 1396, 343, 413, 360, 414, 
-    361, 1396, 343, 1396, 342, 1396, 340, 1398, 340, 416, 368
-};
-
-static const uint16_t temp_para_22[] = {                            
-    3609, 1760, 381, 1338, 403, 1363, 404, 344, 404, 371, 403, 372, 
-    404, 1336, 427, 345, 403, 372, 415, 1335, 404, 1362, 405, 344, 
-    404, 1360, 404, 344, 404, 371, 403, 1362, 403, 1334, 389, 399, 
-    405, 1313, 425, 1334, 405, 344, 403, 372, 403, 1361, 404, 344, 
-    403, 372, 419, 1334, 428, 346, 402, 372, 403, 372, 403, 372, 
-    403, 372, 402, 372, 403, 372, 419, 372, 427, 345, 403, 372, 
-    402, 372, 403, 372, 403, 372, 402, 372, 403, 373, 419, 370, 
-    428, 345, 404, 1361, 404, 344, 403, 372, 423, 1341, 404, 346, 
-    428, 318, 444, 1338, 428, 1334, 403, 370, 381, 394, 380, 1333, 
-    405, 1333, 403, 397, 354, 421, 361, 1365, 400, 400, 353, 422, 
-    377, 1336, 399, 401, 382, 393, 381, 394, 383, 392, 393, 371, 
-    405, 1331, 404, 373, 403, 372, 402, 1333, 403, 374, 400, 375, 
-    398, 376, 410, 379, 396, 378, 394, 381, 392, 383, 389, 385, 
-    391, 384, 391, 384, 392, 382, 379, 410, 390, 385, 364, 411, 
-    363, 411, 363, 412, 365, 410, 389, 386, 362, 413, 375, 414, 
-    360, 414, 362, 414, 361, 414, 359, 416, 358, 435, 340, 435, 
-    340, 438, 350, 436, 338, 437, 337, 437, 337, 438, 337, 438, 
-    336, 439, 335, 440, 335, 482, 306, 1404, 333, 1406, 331, 1432, 
-    306, 445, 329, 470, 305, 445, 330, 469, 305, 1444, 303
-};
+#define IR_GPIO_PIN 2          // Pino de saída IR
 
-static const uint16_t temp_para_21[] = {
-    3611, 1759, 413, 1311, 428, 1332, 406, 344, 403, 371, 405, 370, 
-    427, 1336, 405, 345, 427, 347, 445, 1310, 428, 1333, 405, 345, 
-    420, 1343, 405, 344, 426, 349, 427, 1336, 405, 1333, 389, 375, 
-    428, 1335, 406, 1332, 406, 343, 427, 348, 422, 1341, 406, 344, 
-    404, 371, 445, 1308, 429, 345, 427, 347, 426, 349, 427, 348, 
-    425, 349, 427, 348, 421, 354, 444, 345, 427, 347, 412, 363, 
-    426, 348, 427, 348, 405, 370, 403, 371, 427, 348, 445, 344, 
-    428, 346, 410, 1354, 405, 345, 402, 372, 403, 1360, 405, 345, 
-    426, 349, 444, 1308, 429, 1334, 405, 344, 427, 348, 427, 348, 
-    425, 1338, 405, 344, 403, 372, 420, 370, 428, 1334, 405, 344, 
-    427, 1337, 404, 345, 406, 369, 403, 372, 428, 346, 415, 1338, 
-    429, 345, 428, 1311, 429, 348, 427, 1308, 429, 371, 381, 393, 
-    381, 394, 389, 400, 377, 398, 353, 421, 377, 398, 377, 398, 
-    378, 376, 400, 371, 402, 374, 416, 372, 402, 372, 402, 373, 
-    400, 375, 400, 374, 399, 376, 397, 377, 397, 378, 413, 376, 
-    396, 378, 392, 383, 391, 383, 390, 385, 391, 384, 392, 382, 
-    393, 382, 403, 387, 390, 383, 364, 411, 363, 412, 363, 412, 
-    372, 402, 390, 385, 387, 388, 377, 1395, 343, 1395, 366, 389, 
-    362, 1396, 340, 1398, 340, 1398, 341, 1398, 340, 438, 344
-};
+// Sinais RAW (do seu código original), na biblioteca compactada de
+// ir_siglib.h: as tabelas são geradas no build pelo ir_sigc a partir de
+// captures/philco_ac.txt (ir_signals.h, resíduos de 8 us)
+#define LIBRARY_SIGNALS IR_SIGNALS_COUNT
+#define LIBRARY_TIMINGS IR_SIGNALS_TIMINGS
 
-static const uint16_t temp_para_20[] = {                             
-    3611, 1759, 364, 1356, 428, 1314, 428, 344, 427, 317, 461, 300, 
-    474, 1308, 430, 345, 427, 349, 421, 1327, 405, 1339, 428, 344, 
-    412, 1326, 428, 346, 427, 348, 427, 1311, 430, 1312, 386, 424, 
-    406, 1308, 429, 1311, 428, 344, 403, 371, 427, 1312, 429, 345, 
-    410, 364, 417, 1334, 404, 373, 422, 352, 427, 348, 428, 347, 
-    426, 349, 427, 347, 427, 348, 392, 422, 405, 345, 428, 346, 
-    428, 346, 427, 348, 427, 349, 426, 347, 410, 365, 417, 397, 
-    406, 344, 428, 1311, 429, 344, 403, 372, 427, 1311, 429, 345, 
-    403, 373, 415, 1336, 429, 1336, 403, 345, 404, 372, 404, 1337, 
-    426, 1334, 404, 346, 404, 396, 399, 1325, 429, 1311, 429, 371, 
-    377, 1335, 405, 395, 353, 422, 351, 423, 352, 424, 400, 388, 
-    383, 1329, 400, 401, 385, 389, 386, 1326, 402, 400, 385, 389, 
-    409, 345, 446, 341, 403, 370, 406, 370, 404, 369, 404, 371, 
-    402, 373, 401, 373, 401, 373, 443, 349, 396, 376, 395, 380, 
-    393, 382, 390, 384, 391, 384, 392, 383, 392, 383, 379, 430, 
-    370, 384, 364, 410, 362, 413, 363, 412, 367, 408, 389, 386, 
-    361, 414, 378, 430, 342, 433, 342, 415, 360, 433, 340, 434, 
-    340, 435, 339, 435, 340, 438, 350, 1399, 338, 438, 337, 437, 
-    337, 1401, 337, 439, 335, 440, 335, 440, 334, 1439, 307
+// Captura usada por cada comando (índice na biblioteca)
+static const uint8_t command_signals[] = {
+    [IR_OFF] = IR_SIGNALS_RAWSIGNAL_OFF,
+    [IR_ON] = IR_SIGNALS_RAWSIGNAL_ON,
+    [IR_TEMP_22] = IR_SIGNALS_TEMP_PARA_22,
+    [IR_TEMP_20] = IR_SIGNALS_TEMP_PARA_20,
+    [IR_FAN_1] = IR_SIGNALS_FAN_1,
+    [IR_FAN_2] = IR_SIGNALS_FAN_2
 };
 
-static const uint16_t fan_1[] = {                                   
-    3612, 1760, 430, 1315, 426, 1288, 446, 353, 426, 349, 426, 349, 
-    426, 1284, 449, 354, 425, 350, 433, 1319, 424, 1286, 449, 353, 
-    426, 1285, 448, 353, 427, 349, 425, 1285, 448, 1290, 462, 354, 
-    426, 1286, 448, 1289, 448, 354, 426, 349, 425, 1285, 447, 356, 
-    426, 349, 434, 1317, 424, 351, 426, 349, 425, 349, 426, 349, 
-    426, 349, 425, 350, 425, 350, 435, 353, 425, 350, 424, 350, 
-    425, 350, 425, 349, 425, 350, 425, 350, 424, 351, 436, 353, 
-    425, 349, 424, 1287, 353, 449, 422, 353, 422, 1287, 375, 428, 
-    420, 355, 437, 1315, 351, 1360, 373, 429, 415, 359, 418, 1293, 
-    374, 1364, 373, 429, 384, 391, 438, 351, 416, 1294, 376, 426, 
-    379, 1332, 376, 426, 353, 422, 354, 420, 378, 397, 439, 350, 
-    382, 1328, 398, 405, 352, 422, 353, 1358, 399, 403, 353, 421, 
-    354, 421, 439, 350, 380, 394, 376, 399, 353, 422, 353, 421, 
-    379, 396, 353, 422, 353, 422, 438, 351, 380, 394, 378, 397, 
-    376, 398, 378, 397, 377, 398, 377, 397, 379, 396, 437, 352, 
-    380, 394, 380, 395, 378, 397, 379, 395, 381, 394, 382, 393, 
-    384, 390, 434, 355, 413, 362, 413, 361, 414, 360, 416, 359, 
-    415, 360, 416, 358, 417, 358, 427, 362, 417, 357, 417, 358, 
-    417, 1295, 439, 362, 415, 361, 414, 338, 434, 1299, 449
-};
+#define COMMANDS (sizeof(command_signals) / sizeof(command_signals[0]))
 
-static const uint16_t fan_2[] = {                                     
-    3612, 2002, 181, 1323, 419, 1292, 447, 353, 420, 354, 421, 354, 
-    420, 1320, 421, 352, 420, 2108, 420, 1291, 448, 353, 420, 1319, 
-    421, 353, 419, 354, 421, 1319, 421, 2105, 419, 1321, 420, 1290, 
-    448, 353, 419, 355, 420, 1320, 421, 353, 419, 2108, 421, 353, 
-    420, 355, 420, 354, 420, 355, 420, 354, 421, 355, 420, 1142, 
-    419, 357, 419, 355, 420, 355, 420, 355, 419, 356, 419, 355, 
-    420, 1142, 421, 355, 420, 1295, 445, 353, 420, 355, 419, 1294, 
-    447, 353, 420, 2106, 422, 1289, 449, 353, 420, 355, 419, 1292, 
-    449, 1288, 451, 352, 419, 649, 121, 373, 420, 1294, 448, 352, 
-    420, 1290, 451, 351, 421, 354, 420, 355, 420, 355, 429, 1323, 
-    422, 1288, 451, 352, 420, 354, 421, 1289, 452, 351, 421, 353, 
-    422, 354, 430, 358, 421, 354, 421, 353, 423, 352, 422, 353, 
-    421, 354, 422, 352, 422, 353, 431, 357, 422, 353, 423, 352, 
-    423, 351, 423, 352, 424, 351, 423, 351, 424, 351, 434, 355, 
-    425, 350, 425, 349, 426, 349, 425, 350, 425, 349, 425, 350, 
-    425, 350, 437, 351, 426, 349, 425, 349, 426, 349, 424, 351, 
-    423, 273, 500, 268, 506, 270, 514, 1295, 446, 354, 420, 354, 
-    421, 1293, 445, 353, 420, 354, 421, 354, 422, 1293, 452
-};
+// Cópias expandidas para quem precisa do vetor inteiro (get_raw_signal,
+// get_captured_signals); o envio lê direto da biblioteca
+static uint16_t unpacked_timings[LIBRARY_TIMINGS];
+static ir_raw_signal_t ir_signals[COMMANDS];
+static ir_named_signal_t captured_signals[LIBRARY_SIGNALS];
+static bool unpacked = false;
 
-static const uint16_t fan_3[] = {
-    3610, 1759, 434, 1312, 349, 1361, 375, 427, 414, 362, 421, 353, 
-    420, 1291, 372, 430, 422, 353, 436, 1316, 353, 1356, 355, 448, 
-    425, 1284, 358, 446, 426, 349, 425, 1285, 381, 1357, 464, 353, 
-    425, 1285, 411, 1327, 410, 392, 426, 349, 426, 1285, 407, 395, 
-    425, 350, 435, 1316, 417, 358, 425, 350, 425, 349, 426, 349, 
-    425, 350, 425, 350, 424, 351, 435, 353, 425, 350, 423, 351, 
-    423, 352, 423, 352, 421, 353, 420, 355, 419, 356, 438, 350, 
-    422, 353, 414, 1296, 376, 427, 411, 363, 411, 1300, 376, 426, 
-    385, 391, 438, 1286, 378, 1360, 376, 426, 381, 393, 383, 1328, 
-    376, 1363, 401, 400, 381, 394, 439, 350, 382, 1328, 377, 425, 
-    381, 1331, 383, 418, 382, 392, 384, 392, 385, 389, 436, 1289, 
-    404, 397, 389, 1323, 408, 392, 416, 1296, 411, 390, 418, 357, 
-    417, 358, 429, 360, 417, 357, 418, 357, 417, 357, 418, 357, 
-    417, 358, 416, 359, 415, 338, 449, 360, 415, 339, 435, 339, 
-    437, 339, 435, 340, 433, 341, 433, 343, 431, 344, 448, 358, 
-    410, 365, 382, 393, 378, 397, 375, 399, 378, 397, 378, 397, 
-    378, 398, 388, 398, 345, 430, 344, 431, 370, 405, 372, 402, 
-    345, 430, 340, 435, 340, 437, 379, 1370, 343, 1395, 343, 433, 
-    340, 1397, 340, 435, 341, 434, 340, 435, 338, 1404, 342
+// Cenas (bytecode de ir_scene.h), executadas pelo motor de cenas sem bloquear
+static const uint8_t scene_demo[] = {
+    IR_SCENE_SEND_AC(IR_ON),
+    IR_SCENE_WAIT_MS(2000),
+    IR_SCENE_SEND_AC(IR_TEMP_22),
+    IR_SCENE_WAIT_MS(2000),
+    IR_SCENE_SEND_AC(IR_FAN_1),
+    IR_SCENE_WAIT_MS(2000),
+    IR_SCENE_SEND_AC(IR_OFF),
+    IR_SCENE_END
 };
 
-static const uint16_t fan_4[] = {                                  // aparece um circulo, e fica mais fraco
-    3605, 3506, 419, 1319, 419, 620, 158, 642, 145, 630, 141, 1307, 
-    419, 619, 159, 2104, 419, 1320, 419, 619, 154, 1320, 420, 619, 
-    154, 646, 111, 1337, 420, 3846, 419, 1319, 419, 595, 178, 622, 
-    153, 1320, 419, 594, 179, 2110, 419, 571, 202, 621, 154, 595, 
-    179, 597, 178, 596, 179, 594, 180, 1437, 105, 596, 200, 596, 
-    179, 573, 202, 570, 204, 571, 204, 545, 230, 1435, 109, 566, 
-    228, 1320, 420, 353, 420, 544, 231, 1320, 419, 353, 420, 2109, 
-    420, 1293, 445, 352, 421, 423, 351, 1321, 419, 1291, 448, 352, 
-    420, 2109, 419, 1291, 448, 352, 421, 1320, 420, 352, 420, 355, 
-    420, 354, 421, 1337, 226, 355, 420, 353, 421, 355, 421, 1319, 
-    421, 351, 422, 353, 421, 1145, 418, 354, 421, 354, 421, 354, 
-    420, 354, 421, 354, 421, 354, 421, 1142, 421, 354, 420, 356, 
-    419, 356, 420, 355, 419, 356, 419, 356, 419, 1143, 420, 355, 
-    421, 354, 421, 354, 421, 354, 420, 354, 422, 353, 422, 353, 
-    432, 356, 422, 353, 423, 352, 423, 352, 423, 351, 424, 351, 
-    424, 350, 425, 350, 435, 1290, 451, 1287, 450, 1288, 450, 352, 
-    426, 349, 425, 350, 449, 326, 449, 1261, 485
+// Liga o ar em 22 graus e desliga depois de uma hora (quadros NEC, como os
+// da TV, precisam de uma função de envio com transmissor NEC)
+static const uint8_t scene_sala[] = {
+    IR_SCENE_SEND_AC(IR_ON),
+    IR_SCENE_WAIT_MS(2000),
+    IR_SCENE_SEND_AC(IR_TEMP_22),
+    IR_SCENE_WAIT_S(3600),
+    IR_SCENE_SEND_AC(IR_OFF),
+    IR_SCENE_END
 };
 
-// Mapeamento dos sinais
-static const ir_raw_signal_t ir_signals[] = {
-    [IR_OFF] = {rawSignal_off, sizeof(rawSignal_off) / sizeof(uint16_t)},
-    [IR_ON] = {rawSignal_on, sizeof(rawSignal_on) / sizeof(uint16_t)},
-    [IR_TEMP_22] = {temp_para_22, sizeof(temp_para_22) / sizeof(uint16_t)},
-    [IR_TEMP_20] = {temp_para_20, sizeof(temp_para_20) / sizeof(uint16_t)},
-    [IR_FAN_1] = {fan_1, sizeof(fan_1) / sizeof(uint16_t)},
-    [IR_FAN_2] = {fan_2, sizeof(fan_2) / sizeof(uint16_t)}
+#define SCENE(code) {#code, code, sizeof(code)}
+static const ir_named_scene_t scenes[] = {
+    SCENE(scene_demo),
+    SCENE(scene_sala)
 };
 
-// Variveis globais para PWM
+// Variáveis globais para PWM
 static uint pwm_slice;
 static bool ir_initialized = false;
 
@@ -243,7 +79,7 @@ static bool ir_initialized = false;
  * Inicializa o sistema IR
  */
 bool custom_ir_init(uint gpio_pin) {
-    // Configurar o pino como sada PWM
+    // Configurar o pino como saída PWM
     gpio_set_function(gpio_pin, GPIO_FUNC_PWM);
     pwm_slice = pwm_gpio_to_slice_num(gpio_pin);
     
@@ -277,17 +113,51 @@ static inline void ir_carrier_off() {
     }
 }
 
+// Correção de transmissão (esticamento 0: tempos como estão)
+static ir_calib_t tx_calib;
+
+void custom_ir_set_tx_calib(const ir_calib_t* calib) {
+    ir_calib_t none = {0};
+    tx_calib = calib ? *calib : none;
+}
+
+// Origem dos tempos: vetor em RAM ou sinal da biblioteca lido em fluxo
+typedef struct {
+    const uint16_t* array;              // NULL: lê de reader
+    size_t index;
+    ir_siglib_reader_t reader;
+    bool mark;                          // O próximo tempo é uma marca
+} signal_source_t;
+
+static inline uint16_t source_next(signal_source_t* source) {
+    uint16_t us = source->array ? source->array[source->index++] : ir_siglib_next(&source->reader);
+    bool mark = source->mark;
+    source->mark = !mark;
+    return tx_calib.stretch_us ? ir_calib_correct_us(&tx_calib, us, mark) : us;
+}
+
+// Estado do envio assíncrono (alterado no callback do alarme)
+static signal_source_t async_source;
+static size_t async_length;
+static size_t async_index;
+static volatile bool async_busy = false;
+
 /**
- * Envia um sinal RAW
+ * Envio bloqueante dos tempos da origem
  */
-void send_raw_signal(const uint16_t* signal, size_t length) {
-    if (!ir_initialized) {
-        return;
+static void send_source(signal_source_t* source, size_t length) {
+    // Aguarda um envio assíncrono em andamento
+    while (async_busy) {
+        sleep_us(100);
     }
     
-    bool carrier_state = true; // Comea com carrier ligado
+    bool carrier_state = true; // Começa com carrier ligado
+    ir_boot_mark(IR_BOOT_FIRST_FRAME);
     
     for (size_t i = 0; i < length; i++) {
+        // Lido antes de alternar o carrier, para não alongar o tempo
+        uint16_t duration = source_next(source);
+
         if (carrier_state) {
             ir_carrier_on();
         } else {
@@ -295,7 +165,7 @@ void send_raw_signal(const uint16_t* signal, size_t length) {
         }
         
         // Delay em microssegundos
-        sleep_us(signal[i]);
+        sleep_us(duration);
         
         // Alterna o estado do carrier
         carrier_state = !carrier_state;
@@ -306,21 +176,158 @@ void send_raw_signal(const uint16_t* signal, size_t length) {
 }
 
 /**
- * Envia um comando especfico
+ * Envia um sinal RAW
+ */
+void send_raw_signal(const uint16_t* signal, size_t length) {
+    if (!ir_initialized) {
+        return;
+    }
+    signal_source_t source = {.array = signal, .mark = true};
+    send_source(&source, length);
+}
+
+/**
+ * Fim do tempo atual: alterna o carrier e agenda o próximo tempo
+ */
+static int64_t async_step(alarm_id_t id, void *user_data) {
+    async_index++;
+    if (async_index >= async_length) {
+        ir_carrier_off();
+        async_busy = false;
+        return 0;
+    }
+
+    if (async_index % 2 == 0) {
+        ir_carrier_on();
+    } else {
+        ir_carrier_off();
+    }
+
+    // Negativo: relativo ao vencimento anterior, sem acumular atraso
+    return -(int64_t)source_next(&async_source);
+}
+
+/**
+ * Liga o carrier e agenda o fim do primeiro tempo da origem assíncrona
+ */
+static bool start_async(size_t length) {
+    async_source.mark = true;
+    async_length = length;
+    async_index = 0;
+    async_busy = true;
+
+    ir_boot_mark(IR_BOOT_FIRST_FRAME);
+    ir_carrier_on();
+    if (add_alarm_in_us(source_next(&async_source), async_step, NULL, true) < 0) {
+        ir_carrier_off();
+        async_busy = false;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Envia um sinal RAW sem bloquear
+ */
+bool send_raw_signal_async(const uint16_t* signal, size_t length) {
+    if (!ir_initialized || async_busy || length == 0) {
+        return false;
+    }
+    async_source.array = signal;
+    async_source.index = 0;
+    return start_async(length);
+}
+
+/**
+ * Envia uma captura da biblioteca sem bloquear
+ */
+bool send_captured_signal_async(size_t index) {
+    if (!ir_initialized || async_busy || !ir_siglib_open(&async_source.reader, &ir_signals_library, index) ||
+        ir_siglib_remaining(&async_source.reader) == 0) {
+        return false;
+    }
+    async_source.array = NULL;
+    return start_async(ir_siglib_remaining(&async_source.reader));
+}
+
+bool send_ir_command_async(ir_signal_type_t command) {
+    if (command >= COMMANDS) {
+        return false;
+    }
+    return send_captured_signal_async(command_signals[command]);
+}
+
+bool ir_send_busy(void) {
+    return async_busy;
+}
+
+/**
+ * Envia um comando específico
  */
 bool send_ir_command(ir_signal_type_t command) {
-    if (!ir_initialized || command >= sizeof(ir_signals) / sizeof(ir_signals[0])) {
+    if (!ir_initialized || command >= COMMANDS) {
         return false;
     }
     
-    const ir_raw_signal_t* signal = &ir_signals[command];
-    send_raw_signal(signal->data, signal->length);
+    signal_source_t source = {.array = NULL, .mark = true};
+    ir_siglib_open(&source.reader, &ir_signals_library, command_signals[command]);
+    send_source(&source, ir_siglib_remaining(&source.reader));
     
     return true;
 }
 
 /**
- * Funes de convenincia para cada comando
+ * Expande a biblioteca nas cópias em RAM (uma vez só)
+ */
+static void unpack_library(void) {
+    if (unpacked) {
+        return;
+    }
+    size_t used = 0;
+    for (size_t i = 0; i < LIBRARY_SIGNALS; i++) {
+        uint16_t* data = &unpacked_timings[used];
+        size_t length = ir_siglib_unpack(&ir_signals_library, i, data, LIBRARY_TIMINGS - used);
+        captured_signals[i].name = ir_signals_library.signals[i].name;
+        captured_signals[i].signal.data = data;
+        captured_signals[i].signal.length = length;
+        used += length;
+    }
+    for (size_t c = 0; c < COMMANDS; c++) {
+        ir_signals[c] = captured_signals[command_signals[c]].signal;
+    }
+    unpacked = true;
+}
+
+/**
+ * Sinal RAW associado a um comando
+ */
+const ir_raw_signal_t* get_raw_signal(ir_signal_type_t command) {
+    if (command >= COMMANDS) {
+        return NULL;
+    }
+    unpack_library();
+    return &ir_signals[command];
+}
+
+/**
+ * Lista de todas as capturas
+ */
+size_t get_captured_signals(const ir_named_signal_t** signals) {
+    unpack_library();
+    *signals = captured_signals;
+    return LIBRARY_SIGNALS;
+}
+
+const ir_siglib_t* get_signal_library(void) {
+    return &ir_signals_library;
+}
+
+int get_command_signal(ir_signal_type_t command) {
+    return command < COMMANDS ? command_signals[command] : -1;
+}
+
+/**
+ * Funções de conveniência para cada comando
  */
 void turn_off_ac() {
     send_ir_command(IR_OFF);
@@ -347,35 +354,9 @@ void set_fan_level_2() {
 }
 
 /**
- * Exemplo de uso
+ * Lista das cenas
  */
-void ir_demo() {
-    // Inicializar o sistema IR no pino 2
-    if (!custom_ir_init(IR_GPIO_PIN)) {
-        printf("Erro ao inicializar IR\n");
-        return;
-    }
-    
-    printf("Sistema IR inicializado. Demonstrao:\n");
-    
-    // Ligar o ar condicionado
-    printf("Ligando ar condicionado...\n");
-    turn_on_ac();
-    sleep_ms(2000);
-    
-    // Definir temperatura para 22C
-    printf("Definindo temperatura para 22C...\n");
-    set_temp_22c();
-    sleep_ms(2000);
-    
-    // Definir ventilador para nvel 1
-    printf("Definindo ventilador para nvel 1...\n");
-    set_fan_level_1();
-    sleep_ms(2000);
-    
-    // Desligar
-    printf("Desligando ar condicionado...\n");
-    turn_off_ac();
-    
-    printf("Demonstrao concluda!\n");
+size_t get_scenes(const ir_named_scene_t** list) {
+    *list = scenes;
+    return sizeof(scenes) / sizeof(scenes[0]);
 }
\ No newline at end of file
@@ -12,18 +12,21 @@
 #include <stdbool.h>
 #include <stddef.h>
 
+#include "ir_siglib.h"
+#include "ir_calib.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-// Tipos de sinais IR disponveis
+// Tipos de sinais IR disponíveis
 typedef enum {
     IR_OFF,      // Desligar ar condicionado
     IR_ON,       // Ligar ar condicionado
-    IR_TEMP_22,  // Temperatura 22C
-    IR_TEMP_20,  // Temperatura 20C
-    IR_FAN_1,    // Ventilador nvel 1
-    IR_FAN_2     // Ventilador nvel 2
+    IR_TEMP_22,  // Temperatura 22°C
+    IR_TEMP_20,  // Temperatura 20°C
+    IR_FAN_1,    // Ventilador nível 1
+    IR_FAN_2     // Ventilador nível 2
 } ir_signal_type_t;
 
 // Estrutura para sinais RAW
@@ -32,14 +35,40 @@ typedef struct {
     size_t length;
 } ir_raw_signal_t;
 
+// Sinal RAW com o nome da captura de origem
+typedef struct {
+    const char* name;
+    ir_raw_signal_t signal;
+} ir_named_signal_t;
+
+// Cena em bytecode (ir_scene.h) com o nome
+typedef struct {
+    const char* name;
+    const uint8_t* code;
+    size_t length;
+} ir_named_scene_t;
+
 /**
  * Inicializa o sistema IR no pino especificado
  * 
- * @param gpio_pin Pino GPIO para sada IR (recomendado: 2)
- * @return true se inicializado com sucesso, false caso contrrio
+ * @param gpio_pin Pino GPIO para saída IR (recomendado: 2)
+ * @return true se inicializado com sucesso, false caso contrário
  */
 bool custom_ir_init(uint gpio_pin);
 
+/**
+ * Correção marca/espaço aplicada aos tempos enviados
+ *
+ * Para capturas gravadas sem correção (a biblioteca gerada das capturas,
+ * sinais copiados do receptor.c antes da calibração): tira delas o
+ * esticamento do sensor que as gravou. Os sinais aprendidos com a correção
+ * do receptor já saem no nominal e não precisam dela.
+ *
+ * @param calib Correção do sensor (IR_SIGNALS_STRETCH_US para a biblioteca),
+ *              ou NULL para enviar os tempos como estão
+ */
+void custom_ir_set_tx_calib(const ir_calib_t* calib);
+
 /**
  * Envia um sinal RAW diretamente
  * 
@@ -49,14 +78,82 @@ bool custom_ir_init(uint gpio_pin);
 void send_raw_signal(const uint16_t* signal, size_t length);
 
 /**
- * Envia um comando especfico pr-definido
+ * Inicia o envio de um sinal RAW sem bloquear
+ *
+ * Cada transição do carrier é feita por um alarme, e o próximo alarme é
+ * agendado a partir do vencimento do anterior, então os atrasos de
+ * atendimento não se acumulam ao longo do quadro. O array precisa continuar
+ * válido até o fim do envio.
+ *
+ * @param signal Array com os tempos em microssegundos
+ * @param length Quantidade de elementos no array
+ * @return false se o IR não foi inicializado ou já há um envio em andamento
+ */
+bool send_raw_signal_async(const uint16_t* signal, size_t length);
+
+/**
+ * Inicia o envio de uma captura da biblioteca sem bloquear
+ *
+ * Os tempos são lidos da biblioteca compactada um a um, no próprio alarme
+ * que alterna o carrier, sem cópia em RAM.
+ *
+ * @param index Índice em get_captured_signals()
+ * @return false se o índice não existe, o IR não foi inicializado ou já há
+ *         um envio em andamento
+ */
+bool send_captured_signal_async(size_t index);
+
+/**
+ * Inicia o envio de um comando pré-definido sem bloquear
+ */
+bool send_ir_command_async(ir_signal_type_t command);
+
+/**
+ * Indica se há um envio assíncrono em andamento
+ */
+bool ir_send_busy(void);
+
+/**
+ * Envia um comando específico pré-definido
  * 
  * @param command Tipo do comando a ser enviado
- * @return true se enviado com sucesso, false caso contrrio
+ * @return true se enviado com sucesso, false caso contrário
  */
 bool send_ir_command(ir_signal_type_t command);
 
-// Funes de convenincia para comandos especficos
+/**
+ * Retorna o sinal RAW associado a um comando
+ *
+ * Esta função e get_captured_signals() expandem a biblioteca compactada em
+ * cópias na RAM (cerca de 4 KB) na primeira chamada; para enviar, prefira
+ * send_ir_command() e send_captured_signal_async(), que leem direto da
+ * biblioteca.
+ * 
+ * @param command Tipo do comando
+ * @return Ponteiro para o sinal, ou NULL se o comando não existir
+ */
+const ir_raw_signal_t* get_raw_signal(ir_signal_type_t command);
+
+/**
+ * Retorna todas as capturas RAW conhecidas (inclusive as sem comando)
+ * 
+ * @param signals Recebe o ponteiro para o array de capturas
+ * @return Quantidade de capturas
+ */
+size_t get_captured_signals(const ir_named_signal_t** signals);
+
+/**
+ * Biblioteca compactada com todas as capturas (mesma ordem de
+ * get_captured_signals())
+ */
+const ir_siglib_t* get_signal_library(void);
+
+/**
+ * Índice na biblioteca da captura usada por um comando, ou -1
+ */
+int get_command_signal(ir_signal_type_t command);
+
+// Funções de conveniência para comandos específicos
 
 /**
  * Desliga o ar condicionado
@@ -69,29 +166,33 @@ void turn_off_ac(void);
 void turn_on_ac(void);
 
 /**
- * Define temperatura para 22C
+ * Define temperatura para 22°C
  */
 void set_temp_22c(void);
 
 /**
- * Define temperatura para 20C
+ * Define temperatura para 20°C
  */
 void set_temp_20c(void);
 
 /**
- * Define ventilador para nvel 1
+ * Define ventilador para nível 1
  */
 void set_fan_level_1(void);
 
 /**
- * Define ventilador para nvel 2
+ * Define ventilador para nível 2
  */
 void set_fan_level_2(void);
 
 /**
- * Funo de demonstrao do sistema IR
+ * Retorna as cenas gravadas junto com os sinais (a antiga demonstração é a
+ * cena "scene_demo")
+ * 
+ * @param scenes Recebe o ponteiro para o array de cenas
+ * @return Quantidade de cenas
  */
-void ir_demo(void);
+size_t get_scenes(const ir_named_scene_t** scenes);
 
 #ifdef __cplusplus
 }
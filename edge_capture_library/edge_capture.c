@@ -0,0 +1,87 @@
+/**
+ * edge_capture.c - Medição por PIO + DMA da duração de cada nível do receptor IR
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+#include "hardware/dma.h"
+#include "hardware/clocks.h"
+
+#include "edge_capture.h"
+#include "edge_capture.pio.h"
+
+#define EDGE_CAP_DMA_COUNT 0xFFFFFFFFu  // Transferências por disparo (rearmado ao esgotar)
+
+int edge_cap_init(PIO pio, uint pin) {
+    gpio_disable_pulls(pin);
+
+    if (!pio_can_add_program(pio, &edge_capture_program)) {
+        return -1;
+    }
+    uint offset = pio_add_program(pio, &edge_capture_program);
+
+    int sm = pio_claim_unused_sm(pio, true);
+    if (sm == -1) {
+        return -1;
+    }
+
+    float div = clock_get_hz(clk_sys) / (1e6f * edge_capture_TICKS_PER_US);
+    edge_capture_program_init(pio, sm, offset, pin, div);
+    return sm;
+}
+
+uint32_t edge_cap_duration_us(uint32_t word) {
+    return ((word & ~EDGE_CAP_LEVEL_BIT) + edge_capture_OVERHEAD_TICKS / edge_capture_TICKS_PER_US) &
+           ~EDGE_CAP_LEVEL_BIT;
+}
+
+bool edge_cap_stream_init(edge_cap_stream_t *stream, PIO pio, uint sm) {
+    memset(stream, 0, sizeof(*stream));
+    stream->pio = pio;
+    stream->sm = sm;
+    stream->dma_chan = dma_claim_unused_channel(false);
+    if (stream->dma_chan < 0) {
+        return false;
+    }
+
+    dma_channel_config c = dma_channel_get_default_config(stream->dma_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, true);
+    channel_config_set_ring(&c, true, EDGE_CAP_RING_BITS);
+    channel_config_set_dreq(&c, pio_get_dreq(pio, sm, false));
+    dma_channel_configure(stream->dma_chan, &c, stream->ring, &pio->rxf[sm], EDGE_CAP_DMA_COUNT, true);
+    return true;
+}
+
+// Palavras escritas pelo DMA desde o início (módulo 2^32)
+static uint32_t words_written(edge_cap_stream_t *stream) {
+    uint32_t written = stream->armed_total + (EDGE_CAP_DMA_COUNT - dma_channel_hw_addr(stream->dma_chan)->transfer_count);
+    if (!dma_channel_is_busy(stream->dma_chan)) {
+        // Contagem esgotada: rearma, o endereço continua no mesmo ponto do anel
+        stream->armed_total = written;
+        dma_channel_set_trans_count(stream->dma_chan, EDGE_CAP_DMA_COUNT, true);
+    }
+    return written;
+}
+
+size_t edge_cap_stream_read(edge_cap_stream_t *stream, uint32_t *words, size_t max) {
+    uint32_t written = words_written(stream);
+
+    if (written - stream->read_total > EDGE_CAP_RING_WORDS) {
+        stream->overflows++;
+        stream->read_total = written - EDGE_CAP_RING_WORDS;
+    }
+
+    size_t n = 0;
+    while (n < max && stream->read_total != written) {
+        words[n++] = stream->ring[stream->read_total % EDGE_CAP_RING_WORDS];
+        stream->read_total++;
+    }
+    return n;
+}
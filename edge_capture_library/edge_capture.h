@@ -0,0 +1,87 @@
+/**
+ * edge_capture.h - Medição por PIO + DMA da duração de cada nível do receptor IR
+ *
+ * Uma state machine mede cada trecho em nível alto ou baixo do pino com
+ * resolução de 1 us e um canal de DMA copia as medidas para um anel na RAM,
+ * então nenhuma borda se perde (nem as de pulsos de ruído de poucos us) e a
+ * CPU só trabalha quando lê o anel. O pino é apenas lido: a captura por IRQ
+ * do receptor.c continua funcionando no mesmo GPIO.
+ *
+ * Serve aos diagnósticos do sensor (ir_health.c). O programa ocupa 15 das 32
+ * instruções de um PIO.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef EDGE_CAPTURE_H
+#define EDGE_CAPTURE_H
+
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define EDGE_CAP_RING_BITS 10           // Anel do DMA: 2^10 bytes alinhados
+#define EDGE_CAP_RING_WORDS ((1u << EDGE_CAP_RING_BITS) / sizeof(uint32_t))
+#define EDGE_CAP_LEVEL_BIT (1u << 31)   // Bit da palavra com o nível do trecho
+
+// Anel preenchido pelo DMA (mesmo esquema do pulse_distance_receive)
+typedef struct {
+    uint32_t ring[EDGE_CAP_RING_WORDS] __attribute__((aligned(1u << EDGE_CAP_RING_BITS)));
+    PIO pio;
+    uint sm;
+    int dma_chan;
+    uint32_t read_total;                // Palavras consumidas desde o início
+    uint32_t armed_total;               // Palavras escritas antes do último rearme do DMA
+    uint32_t overflows;                 // Vezes que o DMA deu a volta no anel antes da leitura
+} edge_cap_stream_t;
+
+/**
+ * Carrega o programa, configura uma state machine livre e a liga
+ *
+ * A primeira medida sai na primeira borda de descida depois do pino ficar
+ * em nível alto.
+ *
+ * @return Número da state machine, ou -1 se não houver espaço no PIO
+ */
+int edge_cap_init(PIO pio, uint pin);
+
+/**
+ * Liga um canal de DMA do FIFO RX da state machine ao anel do stream
+ *
+ * @param stream Estrutura com o anel (precisa continuar válida)
+ * @return false se não houver canal de DMA livre
+ */
+bool edge_cap_stream_init(edge_cap_stream_t *stream, PIO pio, uint sm);
+
+/**
+ * Copia as medidas novas do anel, sem bloquear
+ *
+ * Se o DMA deu a volta desde a última leitura, overflows é incrementado e a
+ * leitura continua pela medida mais antiga que restou.
+ *
+ * @param words Recebe até max palavras (ver edge_cap_level/edge_cap_duration_us)
+ * @return Quantidade de palavras
+ */
+size_t edge_cap_stream_read(edge_cap_stream_t *stream, uint32_t *words, size_t max);
+
+/**
+ * Nível do trecho medido (true = alto, o repouso do receptor)
+ */
+static inline bool edge_cap_level(uint32_t word) {
+    return (word & EDGE_CAP_LEVEL_BIT) != 0;
+}
+
+/**
+ * Duração do trecho em us (módulo 2^31: trechos de mais de 35 minutos dão a volta)
+ */
+uint32_t edge_cap_duration_us(uint32_t word);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // EDGE_CAPTURE_H
@@ -0,0 +1,601 @@
+/**
+ * ir_analyze.c - Análise em lote de logs de captura (várias threads)
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ir_analyze.h"
+#include "ir_capfile.h"
+#include "nec_receive.h"
+#include "philco_ac.h"
+
+// t / 50 = (t * 5243) >> 18: o excesso de 5243 / 2^18 sobre 1/50 é 4,6e-7,
+// menos de 0,031 em 65535, e a parte fracionária de t / 50 não passa de 0,98
+#define QUANT_MUL 5243u
+#define QUANT_SHIFT 18
+
+#define NEC_TIMINGS 67                   // Cabeçalho, 32 bits e pulso final
+#define NEC_BITS 32
+#define PULSE_SPLIT_BIN 23               // Espaço de bit 1 (1125 us entre 560 e 1690)
+#define GENERIC_MIN_BITS 8
+#define GENERIC_MIN_SPREAD_BINS 4        // Diferença mínima entre os dois níveis de bit
+#define TABLE_MIN_CAPACITY 256
+#define MIN_BYTES_PER_THREAD 4096        // Abaixo disso mais threads só custam criação
+
+typedef struct {
+    const uint8_t *data;
+    size_t size;                         // Buffer inteiro: o último vetor pode passar de end
+    size_t start;                        // Bytes, ou quadros no arquivo de capturas
+    size_t end;
+    ir_analyze_format_t format;
+    const ir_capfile_t *capfile;
+    ir_analyze_stats_t stats;
+    bool ok;
+} worker_t;
+
+// ---------------------------------------------------------------------------
+// Tabela de comandos
+// ---------------------------------------------------------------------------
+
+static inline size_t command_bytes(const ir_analyze_command_t *c) {
+    return (c->bits + 7u) / 8u;
+}
+
+static uint64_t command_hash(const ir_analyze_command_t *c) {
+    uint64_t h = 0xcbf29ce484222325ull;
+    h = (h ^ c->protocol) * 0x100000001b3ull;
+    h = (h ^ c->bits) * 0x100000001b3ull;
+    for (size_t i = 0; i < command_bytes(c); i++) {
+        h = (h ^ c->bytes[i]) * 0x100000001b3ull;
+    }
+    return h;
+}
+
+static inline bool command_equal(const ir_analyze_command_t *a, const ir_analyze_command_t *b) {
+    return a->protocol == b->protocol && a->bits == b->bits && memcmp(a->bytes, b->bytes, command_bytes(a)) == 0;
+}
+
+static ir_analyze_command_t *find_slot(ir_analyze_command_t *table, size_t capacity,
+                                       const ir_analyze_command_t *c) {
+    size_t mask = capacity - 1;
+    for (size_t i = command_hash(c) & mask;; i = (i + 1) & mask) {
+        if (table[i].count == 0 || command_equal(&table[i], c)) {
+            return &table[i];
+        }
+    }
+}
+
+static bool grow_table(ir_analyze_stats_t *st) {
+    size_t capacity = st->command_capacity ? st->command_capacity * 2 : TABLE_MIN_CAPACITY;
+    ir_analyze_command_t *table = calloc(capacity, sizeof(ir_analyze_command_t));
+    if (!table) {
+        return false;
+    }
+    for (size_t i = 0; i < st->command_capacity; i++) {
+        if (st->commands[i].count) {
+            *find_slot(table, capacity, &st->commands[i]) = st->commands[i];
+        }
+    }
+    free(st->commands);
+    st->commands = table;
+    st->command_capacity = capacity;
+    return true;
+}
+
+static bool add_command(ir_analyze_stats_t *st, const ir_analyze_command_t *c, uint64_t count) {
+    // Carga máxima de 3/4
+    if ((st->command_count + 1) * 4 > st->command_capacity * 3 && !grow_table(st)) {
+        return false;
+    }
+    ir_analyze_command_t *slot = find_slot(st->commands, st->command_capacity, c);
+    if (slot->count == 0) {
+        *slot = *c;
+        slot->count = 0;
+        st->command_count++;
+    }
+    slot->count += count;
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Decodificação
+// ---------------------------------------------------------------------------
+
+void ir_analyze_quantize(const uint16_t *in, size_t count, uint8_t *bins) {
+    for (size_t i = 0; i < count; i++) {
+        uint32_t b = ((uint32_t)in[i] * QUANT_MUL) >> QUANT_SHIFT;
+        bins[i] = (uint8_t)(b < IR_ANALYZE_BINS - 1 ? b : IR_ANALYZE_BINS - 1);
+    }
+}
+
+// 32 bits pela faixa dos espaços, LSB primeiro (NEC e Samsung)
+static bool decode_pulse_distance_32(const uint8_t *bins, size_t count, uint32_t *word) {
+    if (count != NEC_TIMINGS) {
+        return false;
+    }
+    uint32_t w = 0;
+    for (size_t i = 0; i < NEC_BITS; i++) {
+        w |= (uint32_t)(bins[3 + 2 * i] >= PULSE_SPLIT_BIN) << i;
+    }
+    *word = w;
+    return true;
+}
+
+// Bits pela distância de pulso com limiar próprio do quadro; sem dois níveis
+// nos espaços, tenta a largura das marcas
+static bool decode_generic(const uint8_t *bins, size_t count, ir_analyze_command_t *c) {
+    for (size_t first = 3; first >= 2; first--) {
+        uint8_t lo = 0xFF, hi = 0;
+        for (size_t i = first; i < count; i += 2) {
+            lo = bins[i] < lo ? bins[i] : lo;
+            hi = bins[i] > hi ? bins[i] : hi;
+        }
+        size_t bits = (count - first + 1) / 2;
+        if (bits < GENERIC_MIN_BITS || hi - lo < GENERIC_MIN_SPREAD_BINS) {
+            continue;
+        }
+        if (bits > IR_ANALYZE_MAX_BYTES * 8) {
+            bits = IR_ANALYZE_MAX_BYTES * 8;
+        }
+        uint8_t split = (uint8_t)((lo + hi + 1) / 2);
+        for (size_t b = 0; b < bits; b++) {
+            c->bytes[b / 8] |= (uint8_t)((bins[first + 2 * b] >= split) << (b % 8));
+        }
+        c->bits = (uint8_t)bits;
+        return true;
+    }
+    return false;
+}
+
+static bool decode_frame(ir_protocol_t protocol, const uint16_t *raw, const uint8_t *bins, size_t count,
+                         ir_analyze_command_t *c) {
+    memset(c, 0, sizeof(*c));
+    c->protocol = (uint8_t)protocol;
+    uint32_t word;
+
+    switch (protocol) {
+        case IR_PROTOCOL_NEC:
+            if (!decode_pulse_distance_32(bins, count, &word) || !nec_decode_frame(word, &c->bytes[0], &c->bytes[1])) {
+                return false;
+            }
+            c->bits = 16;
+            return true;
+
+        case IR_PROTOCOL_SAMSUNG:
+            if (!decode_pulse_distance_32(bins, count, &word) || (uint8_t)(word >> 16) != (uint8_t)~(word >> 24)) {
+                return false;
+            }
+            c->bytes[0] = (uint8_t)word;
+            c->bytes[1] = (uint8_t)(word >> 8);
+            c->bytes[2] = (uint8_t)(word >> 16);
+            c->bits = 24;
+            return true;
+
+        case IR_PROTOCOL_PHILCO_AC: {
+            philco_ac_frame_t frame;
+            if (!philco_ac_decode(raw, count, &frame)) {
+                return false;
+            }
+            memcpy(c->bytes, frame.bytes, PHILCO_AC_FRAME_BYTES);
+            c->bits = PHILCO_AC_FRAME_BITS;
+            return true;
+        }
+
+        default:
+            return decode_generic(bins, count, c);
+    }
+}
+
+static void histogram(ir_analyze_protocol_t *ps, const uint8_t *bins, size_t count) {
+    for (size_t i = 0; i < count; i += 2) {
+        ps->marks[bins[i]]++;
+    }
+    for (size_t i = 1; i < count; i += 2) {
+        ps->spaces[bins[i]]++;
+    }
+}
+
+static bool analyze_frame(ir_analyze_stats_t *st, const uint16_t *raw, size_t count) {
+    uint8_t bins[IR_ANALYZE_MAX_TIMINGS];
+    bool repeat;
+    ir_protocol_t protocol = ir_capture_identify(raw, count, &repeat);
+    ir_analyze_protocol_t *ps = &st->protocols[protocol];
+
+    st->frames++;
+    ps->frames++;
+    ir_analyze_quantize(raw, count, bins);
+    histogram(ps, bins, count);
+    if (repeat) {
+        ps->repeats++;
+        return true;
+    }
+
+    ir_analyze_command_t c;
+    if (!decode_frame(protocol, raw, bins, count, &c)) {
+        // Glitch ou borda deslocada: saneia e tenta de novo
+        uint16_t clean[IR_ANALYZE_MAX_TIMINGS];
+        ir_sanitizer_t s;
+        ir_sanitizer_init(&s, IR_ANALYZE_GLITCH_US);
+        size_t n = ir_sanitize(raw, count, clean, &s);
+        ir_analyze_quantize(clean, n, bins);
+        if (!decode_frame(protocol, clean, bins, n, &c)) {
+            ps->failed++;
+            return true;
+        }
+        ps->sanitized++;
+    }
+    ps->decoded++;
+    return add_command(st, &c, 1);
+}
+
+// Divide a captura nos espaços longos
+static bool analyze_capture(ir_analyze_stats_t *st, const uint16_t *raw, size_t count) {
+    size_t start = 0;
+    bool ok = true;
+
+    st->captures++;
+    for (size_t i = 1; i < count; i += 2) {
+        if (raw[i] >= IR_ANALYZE_FRAME_GAP_US) {
+            ok &= analyze_frame(st, raw + start, i - start);
+            start = i + 1;
+        }
+    }
+    if (start < count) {
+        ok &= analyze_frame(st, raw + start, count - start);
+    }
+    return ok;
+}
+
+// ---------------------------------------------------------------------------
+// Formatos
+// ---------------------------------------------------------------------------
+
+// Início de um vetor "[] = {" ou "[N] = {" em [p, end); *body recebe o que
+// vem depois da chave (pode passar de end, até limit)
+static const uint8_t *find_array(const uint8_t *p, const uint8_t *end, const uint8_t *limit,
+                                 const uint8_t **body) {
+    static const char marker[] = "] = {";
+    const size_t marker_len = sizeof(marker) - 1;
+
+    while (p < end && (p = memchr(p, '[', (size_t)(end - p))) != NULL) {
+        const uint8_t *q = p + 1;
+        while (q < limit && *q >= '0' && *q <= '9') {
+            q++;
+        }
+        if ((size_t)(limit - q) >= marker_len && memcmp(q, marker, marker_len) == 0) {
+            *body = q + marker_len;
+            return p;
+        }
+        p++;
+    }
+    return NULL;
+}
+
+static void run_text(worker_t *w) {
+    const uint8_t *limit = w->data + w->size;
+    const uint8_t *end = w->data + w->end;
+    const uint8_t *p = w->data + w->start;
+    const uint8_t *body;
+    uint16_t raw[IR_ANALYZE_MAX_TIMINGS];
+
+    while ((p = find_array(p, end, limit, &body)) != NULL) {
+        size_t count = 0;
+        bool overflow = false;
+        uint32_t value = 0;
+        bool in_number = false;
+        const uint8_t *q = body;
+
+        for (; q < limit && *q != '}'; q++) {
+            if (*q >= '0' && *q <= '9') {
+                value = value * 10 + (uint32_t)(*q - '0');
+                in_number = true;
+                continue;
+            }
+            if (in_number) {
+                if (count < IR_ANALYZE_MAX_TIMINGS) {
+                    raw[count++] = (uint16_t)(value > UINT16_MAX ? UINT16_MAX : value);
+                } else {
+                    overflow = true;
+                }
+                value = 0;
+                in_number = false;
+            }
+        }
+        if (in_number && count < IR_ANALYZE_MAX_TIMINGS) {
+            raw[count++] = (uint16_t)(value > UINT16_MAX ? UINT16_MAX : value);
+        }
+
+        if (q == limit || overflow || count == 0) {
+            w->stats.malformed++;
+        } else {
+            w->ok &= analyze_capture(&w->stats, raw, count);
+        }
+        p = q < end ? q : end;
+    }
+}
+
+static inline uint16_t read_le16(const uint8_t *p) {
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+static void run_binary(worker_t *w) {
+    uint16_t raw[IR_ANALYZE_MAX_TIMINGS];
+    size_t off = w->start;
+
+    while (off < w->end) {
+        size_t count = read_le16(w->data + off);
+        const uint8_t *p = w->data + off + 2;
+        off += 2 + 2 * count;
+        if (count == 0 || count > IR_ANALYZE_MAX_TIMINGS) {
+            w->stats.malformed++;
+            continue;
+        }
+        for (size_t i = 0; i < count; i++) {
+            raw[i] = read_le16(p + 2 * i);
+        }
+        w->ok &= analyze_capture(&w->stats, raw, count);
+    }
+}
+
+static void run_capfile(worker_t *w) {
+    uint16_t raw[IR_ANALYZE_MAX_TIMINGS];
+
+    for (size_t i = w->start; i < w->end; i++) {
+        ir_capfile_frame_t frame;
+        if (!ir_capfile_frame(w->capfile, i, &frame) || frame.count == 0 || frame.count > IR_ANALYZE_MAX_TIMINGS) {
+            w->stats.malformed++;
+            continue;
+        }
+        size_t count = ir_capfile_decode(&frame, raw, IR_ANALYZE_MAX_TIMINGS);
+        w->ok &= analyze_capture(&w->stats, raw, count);
+    }
+}
+
+static void *run_worker(void *arg) {
+    worker_t *w = arg;
+    if (w->format == IR_ANALYZE_BINARY) {
+        run_binary(w);
+    } else if (w->format == IR_ANALYZE_CAPFILE) {
+        run_capfile(w);
+    } else {
+        run_text(w);
+    }
+    return NULL;
+}
+
+// Fronteiras de registro do binário mais próximas de partes iguais
+static bool split_binary(const uint8_t *data, size_t size, worker_t *workers, unsigned threads) {
+    size_t off = 0;
+    unsigned next = 1;
+
+    workers[0].start = 0;
+    while (off < size) {
+        if (size - off < 2 || size - off < 2 + 2 * (size_t)read_le16(data + off)) {
+            return false;
+        }
+        while (next < threads && off >= size / threads * next) {
+            workers[next - 1].end = off;
+            workers[next++].start = off;
+        }
+        off += 2 + 2 * (size_t)read_le16(data + off);
+    }
+    while (next < threads) {
+        workers[next - 1].end = size;
+        workers[next++].start = size;
+    }
+    workers[threads - 1].end = size;
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// API
+// ---------------------------------------------------------------------------
+
+void ir_analyze_init(ir_analyze_stats_t *stats) {
+    memset(stats, 0, sizeof(*stats));
+}
+
+void ir_analyze_free(ir_analyze_stats_t *stats) {
+    free(stats->commands);
+    ir_analyze_init(stats);
+}
+
+bool ir_analyze_merge(ir_analyze_stats_t *dst, const ir_analyze_stats_t *src) {
+    dst->captures += src->captures;
+    dst->frames += src->frames;
+    dst->malformed += src->malformed;
+    for (size_t p = 0; p < IR_PROTOCOL_COUNT; p++) {
+        ir_analyze_protocol_t *d = &dst->protocols[p];
+        const ir_analyze_protocol_t *s = &src->protocols[p];
+        d->frames += s->frames;
+        d->decoded += s->decoded;
+        d->repeats += s->repeats;
+        d->failed += s->failed;
+        d->sanitized += s->sanitized;
+        for (size_t b = 0; b < IR_ANALYZE_BINS; b++) {
+            d->marks[b] += s->marks[b];
+            d->spaces[b] += s->spaces[b];
+        }
+    }
+    for (size_t i = 0; i < src->command_capacity; i++) {
+        if (src->commands[i].count && !add_command(dst, &src->commands[i], src->commands[i].count)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ir_analyze_buffer(const uint8_t *data, size_t size, ir_analyze_format_t format, unsigned threads,
+                       ir_analyze_stats_t *stats) {
+    if (threads > IR_ANALYZE_MAX_THREADS) {
+        threads = IR_ANALYZE_MAX_THREADS;
+    }
+    if (threads > size / MIN_BYTES_PER_THREAD) {
+        threads = (unsigned)(size / MIN_BYTES_PER_THREAD);
+    }
+    if (threads == 0) {
+        threads = 1;
+    }
+
+    ir_capfile_t capfile;
+    size_t units = size;
+    if (format == IR_ANALYZE_CAPFILE) {
+        if (ir_capfile_open(&capfile, data, size) != IR_CAPFILE_OK) {
+            return false;
+        }
+        units = capfile.frame_count;
+    }
+
+    worker_t *workers = calloc(threads, sizeof(worker_t));
+    pthread_t ids[IR_ANALYZE_MAX_THREADS];
+    if (!workers) {
+        return false;
+    }
+    for (unsigned t = 0; t < threads; t++) {
+        workers[t].data = data;
+        workers[t].size = size;
+        workers[t].start = units / threads * t;
+        workers[t].end = t + 1 < threads ? units / threads * (t + 1) : units;
+        workers[t].format = format;
+        workers[t].capfile = &capfile;
+        workers[t].ok = true;
+        ir_analyze_init(&workers[t].stats);
+    }
+
+    bool ok = format != IR_ANALYZE_BINARY || split_binary(data, size, workers, threads);
+    if (ok) {
+        // A thread chamadora fica com a primeira faixa
+        unsigned started = 1;
+        for (; started < threads; started++) {
+            if (pthread_create(&ids[started], NULL, run_worker, &workers[started]) != 0) {
+                break;
+            }
+        }
+        run_worker(&workers[0]);
+        for (unsigned t = started; t < threads; t++) {
+            run_worker(&workers[t]);
+        }
+        for (unsigned t = 1; t < started; t++) {
+            pthread_join(ids[t], NULL);
+        }
+    }
+
+    for (unsigned t = 0; t < threads; t++) {
+        if (ok) {
+            ok = workers[t].ok && ir_analyze_merge(stats, &workers[t].stats);
+        }
+        ir_analyze_free(&workers[t].stats);
+    }
+    free(workers);
+    return ok;
+}
+
+uint64_t ir_analyze_duplicates(const ir_analyze_stats_t *stats) {
+    uint64_t decoded = 0;
+    for (size_t p = 0; p < IR_PROTOCOL_COUNT; p++) {
+        decoded += stats->protocols[p].decoded;
+    }
+    return decoded - stats->command_count;
+}
+
+// ---------------------------------------------------------------------------
+// Relatório
+// ---------------------------------------------------------------------------
+
+// Mais frequente primeiro; empate pela chave, para a saída não depender da tabela
+static int compare_command(const void *a, const void *b) {
+    const ir_analyze_command_t *ca = *(const ir_analyze_command_t *const *)a;
+    const ir_analyze_command_t *cb = *(const ir_analyze_command_t *const *)b;
+    if (ca->count != cb->count) {
+        return ca->count < cb->count ? 1 : -1;
+    }
+    if (ca->protocol != cb->protocol) {
+        return ca->protocol - cb->protocol;
+    }
+    if (ca->bits != cb->bits) {
+        return ca->bits - cb->bits;
+    }
+    return memcmp(ca->bytes, cb->bytes, command_bytes(ca));
+}
+
+static void print_command(const ir_analyze_command_t *c, FILE *out) {
+    fprintf(out, "  %-12s ", ir_protocol_name((ir_protocol_t)c->protocol));
+    switch (c->protocol) {
+        case IR_PROTOCOL_NEC:
+            fprintf(out, "end 0x%02X cmd 0x%02X", c->bytes[0], c->bytes[1]);
+            break;
+        case IR_PROTOCOL_SAMSUNG:
+            fprintf(out, "end 0x%02X%02X cmd 0x%02X", c->bytes[1], c->bytes[0], c->bytes[2]);
+            break;
+        default:
+            fprintf(out, "%3u bits", c->bits);
+            for (size_t i = 0; i < command_bytes(c); i++) {
+                fprintf(out, " %02X", c->bytes[i]);
+            }
+            break;
+    }
+    fprintf(out, "  x%llu\n", (unsigned long long)c->count);
+}
+
+static void print_bins(const char *protocol, const char *kind, const uint64_t *bins, FILE *out) {
+    uint64_t total = 0;
+    for (size_t b = 0; b < IR_ANALYZE_BINS; b++) {
+        total += bins[b];
+    }
+    for (size_t b = 0; b < IR_ANALYZE_BINS; b++) {
+        if (total && bins[b] * 1000 >= total) {
+            fprintf(out, "  %-12s %-6s %5zu-%-5zu us %6.2f%%\n", protocol, kind, b * IR_ANALYZE_BIN_US,
+                    b + 1 < IR_ANALYZE_BINS ? (b + 1) * IR_ANALYZE_BIN_US - 1 : UINT16_MAX,
+                    100.0 * (double)bins[b] / (double)total);
+        }
+    }
+}
+
+void ir_analyze_print(const ir_analyze_stats_t *stats, FILE *out, size_t top) {
+    fprintf(out, "Capturas: %llu | Quadros: %llu | Descartados: %llu\n\n",
+            (unsigned long long)stats->captures, (unsigned long long)stats->frames,
+            (unsigned long long)stats->malformed);
+
+    fprintf(out, "  %-12s %12s %12s %12s %12s %12s\n", "protocolo", "quadros", "decod.", "repet.", "falhas",
+            "saneados");
+    for (size_t p = 0; p < IR_PROTOCOL_COUNT; p++) {
+        const ir_analyze_protocol_t *ps = &stats->protocols[p];
+        if (ps->frames) {
+            fprintf(out, "  %-12s %12llu %12llu %12llu %12llu %12llu\n", ir_protocol_name((ir_protocol_t)p),
+                    (unsigned long long)ps->frames, (unsigned long long)ps->decoded,
+                    (unsigned long long)ps->repeats, (unsigned long long)ps->failed,
+                    (unsigned long long)ps->sanitized);
+        }
+    }
+
+    fprintf(out, "\nComandos distintos: %zu | Duplicados: %llu\n", stats->command_count,
+            (unsigned long long)ir_analyze_duplicates(stats));
+    const ir_analyze_command_t **sorted = malloc((stats->command_count + 1) * sizeof(*sorted));
+    if (sorted) {
+        size_t n = 0;
+        for (size_t i = 0; i < stats->command_capacity; i++) {
+            if (stats->commands[i].count) {
+                sorted[n++] = &stats->commands[i];
+            }
+        }
+        qsort(sorted, n, sizeof(*sorted), compare_command);
+        for (size_t i = 0; i < n && i < top; i++) {
+            print_command(sorted[i], out);
+        }
+        free(sorted);
+    }
+
+    fprintf(out, "\nTempos (faixas de %d us com pelo menos 0,1%%):\n", IR_ANALYZE_BIN_US);
+    for (size_t p = 0; p < IR_PROTOCOL_COUNT; p++) {
+        const ir_analyze_protocol_t *ps = &stats->protocols[p];
+        if (ps->frames) {
+            print_bins(ir_protocol_name((ir_protocol_t)p), "marca", ps->marks, out);
+            print_bins(ir_protocol_name((ir_protocol_t)p), "espaço", ps->spaces, out);
+        }
+    }
+}
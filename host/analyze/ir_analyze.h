@@ -0,0 +1,140 @@
+/**
+ * ir_analyze.h - Análise em lote de logs de captura no host
+ *
+ * Lê logs com milhões de quadros em dois formatos:
+ *
+ *  - texto: a saída do receptor.c (ou de vários, concatenada), de onde cada
+ *    vetor "rawSignalN[] = { ... };" é extraído; comentários e demais linhas
+ *    são ignorados;
+ *  - binário: registros de uint16_t little-endian, a quantidade de tempos
+ *    seguida dos tempos (marca, espaço, marca, ...);
+ *  - arquivo de capturas (ir_capfile.h): cada quadro do índice é uma captura.
+ *
+ * Cada captura é dividida em quadros nos espaços de pelo menos
+ * IR_ANALYZE_FRAME_GAP_US. Cada quadro é classificado pelo cabeçalho
+ * (ir_capture_identify()), quantizado em faixas de IR_ANALYZE_BIN_US para os
+ * histogramas de marcas e espaços do protocolo e decodificado:
+ *
+ *  - NEC e Samsung: 32 bits pelas faixas dos espaços, conferindo os
+ *    complementos (nec_decode_frame() no NEC);
+ *  - Philco AC: philco_ac_decode(), com assinatura e checksum;
+ *  - desconhecido: bits por distância de pulso, com o limiar no meio entre o
+ *    menor e o maior espaço do quadro.
+ *
+ * Quadro que não decodifica passa por ir_sanitize() e é tentado de novo. Os
+ * comandos decodificados vão para uma tabela hash; quadros repetidos do mesmo
+ * comando contam como duplicados.
+ *
+ * O arquivo é dividido em faixas de bytes, uma por thread. No texto, cada
+ * thread fica com os vetores que começam na sua faixa (o último pode passar
+ * do fim dela); no binário, uma leitura sequencial só dos tamanhos acha as
+ * fronteiras de registro; no arquivo de capturas, o índice é dividido em
+ * partes iguais. Cada thread acumula estatísticas próprias, somadas
+ * no fim, então o resultado não depende da quantidade de threads.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef IR_ANALYZE_H
+#define IR_ANALYZE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "ir_capture.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define IR_ANALYZE_MAX_THREADS 64
+#define IR_ANALYZE_MAX_TIMINGS 1024       // Mesmo limite do receptor.c (MAX_TRANSITIONS)
+#define IR_ANALYZE_FRAME_GAP_US 5000      // Espaço que separa quadros de uma captura
+#define IR_ANALYZE_BIN_US 50              // Largura das faixas dos histogramas
+#define IR_ANALYZE_BINS 256               // Tempos acima de 12,75 ms caem na última faixa
+#define IR_ANALYZE_MAX_BYTES 14           // Maior comando guardado (quadro Philco)
+#define IR_ANALYZE_GLITCH_US 100          // Pulso curto para o saneamento (mesmo do receptor.c)
+
+typedef enum {
+    IR_ANALYZE_TEXT,
+    IR_ANALYZE_BINARY,
+    IR_ANALYZE_CAPFILE
+} ir_analyze_format_t;
+
+// Contadores e distribuição de tempos de um protocolo
+typedef struct {
+    uint64_t frames;
+    uint64_t decoded;
+    uint64_t repeats;                     // Códigos de repetição (sem comando)
+    uint64_t failed;
+    uint64_t sanitized;                   // Decodificados só depois do saneamento
+    uint64_t marks[IR_ANALYZE_BINS];
+    uint64_t spaces[IR_ANALYZE_BINS];
+} ir_analyze_protocol_t;
+
+// Comando decodificado (chave da tabela hash)
+typedef struct {
+    uint64_t count;                       // 0 = posição livre
+    uint8_t protocol;
+    uint8_t bits;
+    uint8_t bytes[IR_ANALYZE_MAX_BYTES];
+} ir_analyze_command_t;
+
+typedef struct {
+    uint64_t captures;
+    uint64_t frames;
+    uint64_t malformed;                   // Vetores ou registros descartados
+    ir_analyze_protocol_t protocols[IR_PROTOCOL_COUNT];
+
+    // Tabela hash aberta (capacidade em potência de 2)
+    ir_analyze_command_t *commands;
+    size_t command_capacity;
+    size_t command_count;
+} ir_analyze_stats_t;
+
+void ir_analyze_init(ir_analyze_stats_t *stats);
+
+void ir_analyze_free(ir_analyze_stats_t *stats);
+
+/**
+ * Analisa um log inteiro na memória, somando o resultado em stats
+ *
+ * @param threads Quantidade de threads (limitada a IR_ANALYZE_MAX_THREADS)
+ * @return false se faltou memória, o binário termina no meio de um registro ou
+ *         o arquivo de capturas é inválido
+ */
+bool ir_analyze_buffer(const uint8_t *data, size_t size, ir_analyze_format_t format, unsigned threads,
+                       ir_analyze_stats_t *stats);
+
+/**
+ * Soma src em dst
+ *
+ * @return false se faltou memória
+ */
+bool ir_analyze_merge(ir_analyze_stats_t *dst, const ir_analyze_stats_t *src);
+
+/**
+ * Faixa de IR_ANALYZE_BIN_US de cada tempo (t / 50, exato para todo uint16_t,
+ * por multiplicação e deslocamento para o compilador vetorizar)
+ */
+void ir_analyze_quantize(const uint16_t *in, size_t count, uint8_t *bins);
+
+/**
+ * Quadros decodificados que repetem um comando já visto
+ */
+uint64_t ir_analyze_duplicates(const ir_analyze_stats_t *stats);
+
+/**
+ * Imprime totais, os top comandos mais frequentes e as faixas de tempo com
+ * pelo menos 0,1% dos tempos de cada protocolo
+ */
+void ir_analyze_print(const ir_analyze_stats_t *stats, FILE *out, size_t top);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IR_ANALYZE_H
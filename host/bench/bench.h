@@ -0,0 +1,132 @@
+/**
+ * bench.h - Benchmarks do projeto no host
+ *
+ * Cada suíte mede uma parte do código do firmware compilada sobre o shim de
+ * host/sdk e registra resultados com bench_report(). O ir_bench imprime os
+ * resultados em JSON estável (ordenado por nome) e, com --compare, aponta
+ * regressões em relação a um baseline salvo.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    BENCH_LOWER_IS_BETTER,
+    BENCH_HIGHER_IS_BETTER
+} bench_better_t;
+
+typedef void (*bench_fn_t)(void *ctx);
+
+// Evita que o compilador elimine o trabalho medido
+extern volatile uint32_t bench_sink;
+
+// Execuções curtas (--quick)
+extern bool bench_quick;
+
+/**
+ * Registra um resultado
+ *
+ * @param name Nome estável no formato "suite.caso"
+ * @param value Valor medido
+ * @param unit Unidade (ex: "ns/op", "us", "%")
+ * @param better Direção considerada melhora
+ */
+void bench_report(const char *name, double value, const char *unit, bench_better_t better);
+
+/**
+ * Registra uma verificação: se alguma falhar, o ir_bench termina com código 1
+ * (é o que o ctest confere)
+ */
+void bench_check(const char *name, bool ok);
+
+/**
+ * Mede o tempo de relógio (CLOCK_MONOTONIC, não de CPU) de fn, que executa
+ * ops_per_call operações por chamada
+ *
+ * @return Mediana de 5 amostras, em nanossegundos por operação
+ */
+double bench_ns_per_op(bench_fn_t fn, void *ctx, uint64_t ops_per_call);
+
+/**
+ * Mede fn com bench_ns_per_op() e registra o resultado em "ns/op"
+ */
+void bench_time(const char *name, bench_fn_t fn, void *ctx, uint64_t ops_per_call);
+
+/**
+ * Gerador pseudoaleatório determinístico (xorshift32)
+ */
+static inline uint32_t bench_rand(uint32_t *state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+// Pulso abaixo do qual o saneamento considera glitch (mesmo valor do ir_sigc)
+#define BENCH_GLITCH_US 100
+
+/**
+ * Decodificador do quadro Philco por limiar fixo, sem tolerância a ruído
+ *
+ * @return true se assinatura e checksum conferem
+ */
+bool bench_philco_hard_decode(const uint16_t *raw, size_t count, uint8_t *bytes);
+
+/**
+ * Transmissão por bit-banging do emissor.c original (carrier de 38 kHz com
+ * busy-wait de meio período); o pino precisa estar configurado como saída
+ */
+void bench_emissor_transmit(unsigned tx_pin, const uint16_t *signal, size_t length);
+
+/**
+ * Tempos de marca/espaço a partir de bordas no formato do ir_txcheck, com o
+ * mesmo critério do analisador (marca da primeira subida até a última descida)
+ */
+size_t bench_demodulate(const uint32_t *edges, size_t count, uint16_t *timings, size_t max);
+
+// Suítes
+void bench_suite_nec(void);
+void bench_suite_raw(void);
+void bench_suite_app(void);
+void bench_suite_philco(void);
+void bench_suite_sanitize(void);
+void bench_suite_ac(void);
+void bench_suite_sched(void);
+void bench_suite_scene(void);
+void bench_suite_log(void);
+void bench_suite_echo(void);
+void bench_suite_fusion(void);
+void bench_suite_txcheck(void);
+void bench_suite_verify(void);
+void bench_suite_channel(void);
+void bench_suite_protocol(void);
+void bench_suite_siglib(void);
+void bench_suite_analyze(void);
+void bench_suite_capfile(void);
+void bench_suite_boot(void);
+void bench_suite_pdrx(void);
+void bench_suite_pdtx(void);
+void bench_suite_slottx(void);
+void bench_suite_necrx(void);
+void bench_suite_health(void);
+void bench_suite_codedb(void);
+void bench_suite_calib(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BENCH_H
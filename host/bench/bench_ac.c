@@ -0,0 +1,233 @@
+/**
+ * bench_ac.c - Tempo de transmissão economizado pelo reconciliador (ac_state.c)
+ *
+ * Simula, no relógio virtual, o laço principal do Teste_protocolo.c (uma
+ * volta a cada 10 ms) recebendo rajadas de toques roteirizadas. O modo
+ * direto envia um quadro a cada mudança de estado, como o código antigo; o
+ * modo reconciliado passa pelo ac_reconciler_t. O tempo de transmissão é o
+ * tempo virtual gasto dentro de send_ir_command(). Um modelo do aparelho
+ * aplica os bytes decodificados de cada quadro recebido (o quadro Philco
+ * carrega o estado completo) para conferir que os dois modos terminam no
+ * mesmo estado e que o estado que o reconciliador registra como enviado é o
+ * do aparelho.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <stdio.h>
+
+#include "bench.h"
+#include "pico/stdlib.h"
+#include "hardware/timer.h"
+#include "host_sdk.h"
+#include "custom_ir.h"
+#include "philco_ac.h"
+#include "ac_state.h"
+
+#define BENCH_IR_PIN 2
+#define LOOP_TICK_MS 10
+#define MAX_PRESSES 2048
+
+// Estados do botão do Teste_protocolo.c, na ordem do ciclo
+typedef enum {
+    PRESS_OFF,
+    PRESS_ON,
+    PRESS_TEMP_20,
+    PRESS_TEMP_22,
+    PRESS_FAN_1,
+    PRESS_FAN_2
+} press_t;
+
+typedef struct {
+    uint32_t time_ms;
+    press_t press;
+} event_t;
+
+typedef struct {
+    const char *name;
+    uint32_t min_gap_ms;     // Intervalo entre toques da rajada
+    uint32_t max_gap_ms;
+    uint32_t max_burst;      // Toques por rajada (1 a max_burst)
+    bool cycle;              // Botão que cicla OFF/ON/20/22; senão, teclas de temperatura e ventilador
+} storm_t;
+
+typedef struct {
+    uint64_t airtime_us;
+    uint32_t frames;
+    ac_state_t unit;         // Estado do aparelho após receber os quadros
+    uint32_t sent_mismatches; // Envios em que o registrado pelo reconciliador difere do aparelho
+} run_result_t;
+
+static event_t events[MAX_PRESSES];
+static size_t event_count;
+
+// Estado do aparelho depois de cada quadro da biblioteca, decodificado
+static ac_state_t frame_states[IR_FAN_2 + 1];
+static bool frames_ok;
+
+/**
+ * Rajadas de toques separadas por alguns segundos de pausa
+ */
+static void build_storm(const storm_t *storm, uint32_t seed) {
+    uint32_t t = 1000;
+    uint32_t cycle_state = PRESS_OFF;
+    event_count = 0;
+
+    while (event_count < MAX_PRESSES - 8) {
+        uint32_t presses = 1 + bench_rand(&seed) % storm->max_burst;
+        for (uint32_t i = 0; i < presses; i++) {
+            press_t press;
+            if (storm->cycle) {
+                cycle_state = (cycle_state + 1) % (PRESS_TEMP_22 + 1);
+                press = (press_t)cycle_state;
+            } else {
+                press = (press_t)(PRESS_TEMP_20 + bench_rand(&seed) % 4);
+            }
+            events[event_count].time_ms = t;
+            events[event_count].press = press;
+            event_count++;
+            t += storm->min_gap_ms + bench_rand(&seed) % (storm->max_gap_ms - storm->min_gap_ms + 1);
+        }
+        t += 2000 + bench_rand(&seed) % 3000;
+        if (bench_quick && event_count > 200) {
+            break;
+        }
+    }
+}
+
+/**
+ * O que o aparelho guarda de um quadro: ligado (byte 5), temperatura (byte 7,
+ * 31 - °C) e ventilador (byte 8; fora de 0x12/0x13 é outro modo)
+ */
+static ac_state_t state_from_bytes(const uint8_t *bytes) {
+    ac_state_t state = {
+        .power = (bytes[5] & 0x04) != 0,
+        .temp_c = (uint8_t)(31 - (bytes[7] & 0x1F)),
+        .fan = bytes[8] == 0x12 ? 1 : (bytes[8] == 0x13 ? 2 : AC_FAN_UNSET),
+    };
+    return state;
+}
+
+static void decode_frames(void) {
+    frames_ok = true;
+    for (int command = IR_OFF; command <= IR_FAN_2; command++) {
+        const ir_raw_signal_t *signal = get_raw_signal((ir_signal_type_t)command);
+        philco_ac_frame_t frame;
+        if (!signal || !philco_ac_decode(signal->data, signal->length, &frame)) {
+            frames_ok = false;
+            continue;
+        }
+        frame_states[command] = state_from_bytes(frame.bytes);
+    }
+}
+
+// O quadro substitui o estado inteiro do aparelho (desligado mantém o resto)
+static void unit_apply(ac_state_t *unit, ir_signal_type_t command) {
+    const ac_state_t *state = &frame_states[command];
+    if (state->power) {
+        *unit = *state;
+    } else {
+        unit->power = false;
+    }
+}
+
+static void transmit(run_result_t *r, ir_signal_type_t command) {
+    uint64_t start = time_us_64();
+    send_ir_command(command);
+    r->airtime_us += time_us_64() - start;
+    r->frames++;
+    unit_apply(&r->unit, command);
+}
+
+static void request(ac_reconciler_t *ac, press_t press, uint32_t now) {
+    switch (press) {
+        case PRESS_OFF: ac_reconciler_set_power(ac, false, now); break;
+        case PRESS_ON: ac_reconciler_set_power(ac, true, now); break;
+        case PRESS_TEMP_20: ac_reconciler_set_temp(ac, 20, now); break;
+        case PRESS_TEMP_22: ac_reconciler_set_temp(ac, 22, now); break;
+        case PRESS_FAN_1: ac_reconciler_set_fan(ac, 1, now); break;
+        case PRESS_FAN_2: ac_reconciler_set_fan(ac, 2, now); break;
+    }
+}
+
+/**
+ * Laço principal: processa os toques vencidos e, no modo reconciliado,
+ * consulta o reconciliador a cada volta
+ */
+static bool same_state(const ac_state_t *a, const ac_state_t *b) {
+    return a->power == b->power && (!a->power || (a->temp_c == b->temp_c && a->fan == b->fan));
+}
+
+static void run_storm(bool reconcile, run_result_t *r, ac_reconciler_t *ac) {
+    static const ir_signal_type_t direct[] = {IR_OFF, IR_ON, IR_TEMP_20, IR_TEMP_22, IR_FAN_1, IR_FAN_2};
+    size_t next = 0;
+
+    host_sdk_reset();
+    custom_ir_init(BENCH_IR_PIN);
+    ac_reconciler_init(ac, AC_COMMIT_DELAY_MS);
+    *r = (run_result_t){0};
+
+    uint32_t end = events[event_count - 1].time_ms + 2 * AC_COMMIT_DELAY_MS;
+    for (uint32_t now = to_ms_since_boot(get_absolute_time()); now < end;
+         now = to_ms_since_boot(get_absolute_time())) {
+        while (next < event_count && events[next].time_ms <= now) {
+            if (reconcile) {
+                request(ac, events[next].press, now);
+            } else {
+                transmit(r, direct[events[next].press]);
+            }
+            next++;
+        }
+        if (reconcile) {
+            ir_signal_type_t commands[AC_MAX_COMMANDS];
+            size_t n = ac_reconciler_poll(ac, now, commands);
+            for (size_t i = 0; i < n; i++) {
+                transmit(r, commands[i]);
+            }
+            if (n > 0 && !same_state(&ac->sent, &r->unit)) {
+                r->sent_mismatches++;
+            }
+        }
+        sleep_ms(LOOP_TICK_MS);
+    }
+}
+
+void bench_suite_ac(void) {
+    static const storm_t storms[] = {
+        {"button_cycle", 120, 350, 6, true},
+        {"keys", 80, 300, 8, false},
+    };
+    char name[64];
+
+    decode_frames();
+    bench_report("ac.library_frames_decoded", frames_ok ? 1 : 0, "bool", BENCH_HIGHER_IS_BETTER);
+
+    for (size_t s = 0; s < count_of(storms); s++) {
+        run_result_t direct_result;
+        run_result_t reconciled;
+        ac_reconciler_t ac;
+
+        build_storm(&storms[s], 0xAC0000u + (uint32_t)s);
+        run_storm(false, &direct_result, &ac);
+        run_storm(true, &reconciled, &ac);
+
+        snprintf(name, sizeof(name), "ac.%s_direct_airtime_ms", storms[s].name);
+        bench_report(name, direct_result.airtime_us / 1000.0, "ms", BENCH_LOWER_IS_BETTER);
+        snprintf(name, sizeof(name), "ac.%s_reconciled_airtime_ms", storms[s].name);
+        bench_report(name, reconciled.airtime_us / 1000.0, "ms", BENCH_LOWER_IS_BETTER);
+        snprintf(name, sizeof(name), "ac.%s_airtime_saved_pct", storms[s].name);
+        bench_report(name, 100.0 * (1.0 - (double)reconciled.airtime_us / (double)direct_result.airtime_us), "%",
+                     BENCH_HIGHER_IS_BETTER);
+        snprintf(name, sizeof(name), "ac.%s_frames_per_burst", storms[s].name);
+        bench_report(name, (double)reconciled.frames / (double)(ac.commits + ac.suppressed), "frames",
+                     BENCH_LOWER_IS_BETTER);
+        snprintf(name, sizeof(name), "ac.%s_suppressed", storms[s].name);
+        bench_report(name, ac.suppressed, "count", BENCH_HIGHER_IS_BETTER);
+        snprintf(name, sizeof(name), "ac.%s_final_state_ok", storms[s].name);
+        bench_report(name, same_state(&direct_result.unit, &reconciled.unit) ? 1 : 0, "bool",
+                     BENCH_HIGHER_IS_BETTER);
+        snprintf(name, sizeof(name), "ac.%s_sent_mismatches", storms[s].name);
+        bench_report(name, reconciled.sent_mismatches, "count", BENCH_LOWER_IS_BETTER);
+    }
+}
@@ -0,0 +1,262 @@
+/**
+ * bench_analyze.c - Vazão do analisador de logs com 1 a 8 threads
+ *
+ * Monta na memória um log sintético no formato impresso pelo receptor.c e o
+ * mesmo log em binário: capturas NEC (quadro e repetições, de um conjunto
+ * pequeno de comandos), as capturas Philco conhecidas e quadros de largura de
+ * pulso sem protocolo reconhecido, todos passados pelo canal IR virtual no
+ * modelo de sala. Mede nanossegundos por quadro com 1, 2, 4 e 8 threads em
+ * cada formato e o ganho de 4 threads sobre 1 (limitado pelos núcleos da
+ * máquina), e confere que o resultado não muda com a quantidade de threads
+ * nem com o formato, que a quantização bate com a divisão para todo uint16_t
+ * e que nenhum quadro NEC decodifica num comando que não foi enviado.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "pico/stdlib.h"
+#include "nec_transmit.h"
+#include "custom_ir.h"
+#include "ir_channel.h"
+#include "ir_analyze.h"
+
+#define CAPTURES 8000
+#define CAPTURES_QUICK 1000
+#define NEC_COMMANDS 16
+#define MAX_REPEATS 3
+#define GAP_US 40000
+#define WIDTH_BITS 20                    // Quadro de largura de pulso (sem protocolo)
+#define TEXT_PER_CAPTURE 6400            // Pior caso de texto por captura
+#define QUANT_TIMINGS 1024
+
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+    ir_analyze_format_t format;
+    unsigned threads;
+} run_t;
+
+static const unsigned thread_counts[] = {1, 2, 4, 8};
+
+// Mesmo modelo de sala do bench_channel.c
+static const ir_channel_model_t room = {
+    .mark_stretch_us = 40,
+    .jitter_us = 15,
+    .dropout_ppm = 500,
+    .glitch_per_s = 4,
+    .glitch_us = 60,
+    .echo_delay_us = 30,
+    .echo_pct = 20,
+};
+
+static ir_channel_t channel;
+static uint16_t nec_commands[NEC_COMMANDS];
+
+// Acrescenta um quadro que passou pelo canal, separado do anterior pelo gap
+static size_t append_frame(uint16_t *raw, size_t count, const uint16_t *tx, size_t n) {
+    if (count > 0) {
+        raw[count++] = GAP_US;
+    }
+    return count + ir_channel_apply(&channel, tx, n, raw + count, IR_ANALYZE_MAX_TIMINGS - count);
+}
+
+static size_t make_capture(uint16_t *raw, uint32_t *seed) {
+    static const uint16_t repeat_code[] = {9000, 2250, 560};
+    uint16_t tx[IR_ANALYZE_MAX_TIMINGS];
+    uint32_t r = bench_rand(seed);
+    size_t count = 0;
+
+    if (r % 100 < 60) {
+        uint16_t command = nec_commands[(r >> 8) % NEC_COMMANDS];
+        size_t n = ir_channel_nec_waveform(nec_encode_frame((uint8_t)(command >> 8), (uint8_t)command), tx);
+        count = append_frame(raw, count, tx, n);
+        for (uint32_t i = (r >> 16) % (MAX_REPEATS + 1); i > 0; i--) {
+            count = append_frame(raw, count, repeat_code, count_of(repeat_code));
+        }
+    } else if (r % 100 < 85) {
+        const ir_named_signal_t *signals;
+        size_t total = get_captured_signals(&signals);
+        const ir_raw_signal_t *s = &signals[(r >> 8) % total].signal;
+        count = append_frame(raw, count, s->data, s->length);
+    } else {
+        // Cabeçalho de 2400 us e bits pela largura da marca
+        size_t n = 0;
+        tx[n++] = 2400;
+        tx[n++] = 600;
+        for (int b = 0; b < WIDTH_BITS; b++) {
+            tx[n++] = (r >> (b % 24)) & 1 ? 1200 : 600;
+            tx[n++] = 600;
+        }
+        tx[n++] = 600;
+        count = append_frame(raw, count, tx, n);
+    }
+    return count;
+}
+
+static size_t write_text(char *out, int index, const uint16_t *raw, size_t count) {
+    char *p = out;
+    p += sprintf(p, "// Sinal %d: bench\n// Tempos: %zu\nuint16_t rawSignal%d[] = {\n", index, count, index);
+    for (size_t i = 0; i < count; i++) {
+        p += sprintf(p, "%s%u%s", i % 12 == 0 ? "    " : "", raw[i],
+                     i + 1 < count ? (i % 12 == 11 ? ",\n" : ", ") : "\n");
+    }
+    p += sprintf(p, "};\n#define RAW_SIGNAL%d_LENGTH %zu\n\n", index, count);
+    return (size_t)(p - out);
+}
+
+static size_t write_binary(uint8_t *out, const uint16_t *raw, size_t count) {
+    out[0] = (uint8_t)count;
+    out[1] = (uint8_t)(count >> 8);
+    for (size_t i = 0; i < count; i++) {
+        out[2 + 2 * i] = (uint8_t)raw[i];
+        out[3 + 2 * i] = (uint8_t)(raw[i] >> 8);
+    }
+    return 2 + 2 * count;
+}
+
+static void run_analyze(void *ctx) {
+    const run_t *run = ctx;
+    ir_analyze_stats_t stats;
+    ir_analyze_init(&stats);
+    ir_analyze_buffer(run->data, run->size, run->format, run->threads, &stats);
+    bench_sink += (uint32_t)stats.frames;
+    ir_analyze_free(&stats);
+}
+
+static void run_quantize(void *ctx) {
+    uint16_t *in = ctx;
+    uint8_t bins[QUANT_TIMINGS];
+    ir_analyze_quantize(in, QUANT_TIMINGS, bins);
+    bench_sink += bins[QUANT_TIMINGS - 1];
+}
+
+// Mesmos contadores, histogramas e comandos
+static bool same_stats(const ir_analyze_stats_t *a, const ir_analyze_stats_t *b) {
+    if (a->captures != b->captures || a->frames != b->frames || a->malformed != b->malformed ||
+        a->command_count != b->command_count || memcmp(a->protocols, b->protocols, sizeof(a->protocols)) != 0) {
+        return false;
+    }
+    for (size_t i = 0; i < a->command_capacity; i++) {
+        const ir_analyze_command_t *c = &a->commands[i];
+        bool found = c->count == 0;
+        for (size_t j = 0; !found && j < b->command_capacity; j++) {
+            const ir_analyze_command_t *d = &b->commands[j];
+            found = d->count == c->count && d->protocol == c->protocol && d->bits == c->bits &&
+                    memcmp(d->bytes, c->bytes, sizeof(c->bytes)) == 0;
+        }
+        if (!found) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Quadros NEC decodificados num comando que não está no conjunto enviado
+static uint64_t wrong_nec_frames(const ir_analyze_stats_t *stats) {
+    uint64_t wrong = 0;
+    for (size_t i = 0; i < stats->command_capacity; i++) {
+        const ir_analyze_command_t *c = &stats->commands[i];
+        if (c->count == 0 || c->protocol != IR_PROTOCOL_NEC) {
+            continue;
+        }
+        bool sent = false;
+        for (size_t k = 0; k < NEC_COMMANDS; k++) {
+            sent |= nec_commands[k] == (uint16_t)(c->bytes[0] << 8 | c->bytes[1]);
+        }
+        wrong += sent ? 0 : c->count;
+    }
+    return wrong;
+}
+
+void bench_suite_analyze(void) {
+    const size_t captures = bench_quick ? CAPTURES_QUICK : CAPTURES;
+    char *text = malloc(captures * TEXT_PER_CAPTURE);
+    uint8_t *binary = malloc(captures * (2 + 2 * IR_ANALYZE_MAX_TIMINGS));
+    uint16_t raw[IR_ANALYZE_MAX_TIMINGS];
+    size_t text_size = 0;
+    size_t binary_size = 0;
+    uint32_t seed = 0xA7A1123u;
+
+    if (!text || !binary) {
+        fprintf(stderr, "bench: sem memória para o log\n");
+        exit(2);
+    }
+    for (size_t k = 0; k < NEC_COMMANDS; k++) {
+        nec_commands[k] = (uint16_t)bench_rand(&seed);
+    }
+    ir_channel_init(&channel, &room, 0x5EED0200u);
+    for (size_t i = 0; i < captures; i++) {
+        size_t count = make_capture(raw, &seed);
+        text_size += write_text(text + text_size, (int)i + 1, raw, count);
+        binary_size += write_binary(binary + binary_size, raw, count);
+    }
+
+    // Referência: uma thread sobre o texto
+    ir_analyze_stats_t reference;
+    ir_analyze_init(&reference);
+    ir_analyze_buffer((const uint8_t *)text, text_size, IR_ANALYZE_TEXT, 1, &reference);
+
+    uint64_t decoded = 0;
+    for (size_t p = 0; p < IR_PROTOCOL_COUNT; p++) {
+        decoded += reference.protocols[p].decoded;
+    }
+    uint64_t commands = reference.frames - reference.protocols[IR_PROTOCOL_NEC].repeats;
+    bench_report("analyze.decoded_pct", 100.0 * decoded / commands, "%", BENCH_HIGHER_IS_BETTER);
+    bench_report("analyze.wrong_nec_frames", (double)wrong_nec_frames(&reference), "frames",
+                 BENCH_LOWER_IS_BETTER);
+
+    // Resultado igual com qualquer quantidade de threads e nos dois formatos
+    uint32_t mismatch = 0;
+    for (size_t t = 0; t < count_of(thread_counts); t++) {
+        for (int f = 0; f < 2; f++) {
+            ir_analyze_stats_t stats;
+            ir_analyze_init(&stats);
+            bool ok = f == 0 ? ir_analyze_buffer((const uint8_t *)text, text_size, IR_ANALYZE_TEXT,
+                                                 thread_counts[t], &stats)
+                             : ir_analyze_buffer(binary, binary_size, IR_ANALYZE_BINARY, thread_counts[t], &stats);
+            mismatch += !ok || !same_stats(&reference, &stats);
+            ir_analyze_free(&stats);
+        }
+    }
+    bench_report("analyze.thread_mismatch", mismatch, "runs", BENCH_LOWER_IS_BETTER);
+
+    uint32_t quant_mismatch = 0;
+    for (uint32_t v = 0; v <= UINT16_MAX; v++) {
+        uint16_t in = (uint16_t)v;
+        uint8_t bin;
+        ir_analyze_quantize(&in, 1, &bin);
+        uint32_t expected = v / IR_ANALYZE_BIN_US;
+        quant_mismatch += bin != (expected < IR_ANALYZE_BINS - 1 ? expected : IR_ANALYZE_BINS - 1);
+    }
+    bench_report("analyze.quantize_mismatch", quant_mismatch, "values", BENCH_LOWER_IS_BETTER);
+    uint16_t *quant_in = malloc(QUANT_TIMINGS * sizeof(uint16_t));
+    for (size_t i = 0; i < QUANT_TIMINGS; i++) {
+        quant_in[i] = (uint16_t)(bench_rand(&seed) % 10000);
+    }
+    bench_time("analyze.quantize_per_timing", run_quantize, quant_in, QUANT_TIMINGS);
+    free(quant_in);
+
+    double text_ns[count_of(thread_counts)];
+    for (size_t t = 0; t < count_of(thread_counts); t++) {
+        char name[64];
+        run_t run = {(const uint8_t *)text, text_size, IR_ANALYZE_TEXT, thread_counts[t]};
+        text_ns[t] = bench_ns_per_op(run_analyze, &run, reference.frames);
+        snprintf(name, sizeof(name), "analyze.text_per_frame_%ut", thread_counts[t]);
+        bench_report(name, text_ns[t], "ns/op", BENCH_LOWER_IS_BETTER);
+
+        run = (run_t){binary, binary_size, IR_ANALYZE_BINARY, thread_counts[t]};
+        snprintf(name, sizeof(name), "analyze.binary_per_frame_%ut", thread_counts[t]);
+        bench_time(name, run_analyze, &run, reference.frames);
+    }
+    bench_report("analyze.speedup_4t", text_ns[0] / text_ns[2], "x", BENCH_HIGHER_IS_BETTER);
+
+    ir_analyze_free(&reference);
+    free(binary);
+    free(text);
+}
@@ -0,0 +1,60 @@
+/**
+ * bench_app.c - Busca de comandos por nome e estatísticas das capturas
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "bench.h"
+#include "pico/stdlib.h"
+#include "ir_commands.h"
+#include "ir_capture.h"
+#include "custom_ir.h"
+
+// Nomes digitados que não existem na tabela
+static const char *missing_names[] = {"POWER_OFF", "vol", "CHANNEL_UP", "menuu", "x", "INPUT_HDMI"};
+
+static void run_lookup_hit(void *ctx) {
+    (void)ctx;
+    uint32_t acc = 0;
+    for (size_t i = 0; i < ir_command_count; i++) {
+        const ir_command_t *cmd = ir_find_command(ir_command_table[i].name);
+        acc += cmd->function;
+    }
+    bench_sink = acc;
+}
+
+static void run_lookup_miss(void *ctx) {
+    (void)ctx;
+    uint32_t acc = 0;
+    for (size_t i = 0; i < count_of(missing_names); i++) {
+        acc += ir_find_command(missing_names[i]) == NULL;
+    }
+    bench_sink = acc;
+}
+
+static void run_capture_stats(void *ctx) {
+    (void)ctx;
+    const ir_named_signal_t *signals;
+    size_t count = get_captured_signals(&signals);
+    ir_capture_stats_t stats;
+    uint32_t acc = 0;
+    for (size_t i = 0; i < count; i++) {
+        ir_capture_compute_stats(signals[i].signal.data, signals[i].signal.length, &stats);
+        acc += stats.mean_us;
+    }
+    bench_sink = acc;
+}
+
+void bench_suite_app(void) {
+    const ir_named_signal_t *signals;
+    size_t count = get_captured_signals(&signals);
+    size_t samples = 0;
+    for (size_t i = 0; i < count; i++) {
+        samples += signals[i].signal.length;
+    }
+
+    bench_time("app.find_command_hit", run_lookup_hit, NULL, ir_command_count);
+    bench_time("app.find_command_miss", run_lookup_miss, NULL, count_of(missing_names));
+    bench_time("app.capture_stats_per_sample", run_capture_stats, NULL, samples);
+}
@@ -0,0 +1,127 @@
+/**
+ * bench_boot.c - Tempo do reset ao primeiro quadro IR (ir_boot.c)
+ *
+ * Reproduz no relógio virtual o início do Teste_protocolo.c com um comando
+ * já na fila da serial ("1", ligar AC) e nenhum host na USB: a sequência
+ * antiga (sleep_ms(2000), depois o PWM) e a nova (PWM primeiro, texto no
+ * console de boot). Mede quando o primeiro quadro começa a sair, quanto texto
+ * fica guardado até o host conectar em 1,5 s, quanto é descartado sem host
+ * até IR_BOOT_CONSOLE_TIMEOUT_MS e o custo de CPU de ir_boot_printf() e da
+ * sequência nova até o primeiro quadro.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "bench.h"
+#include "pico/stdlib.h"
+#include "hardware/timer.h"
+#include "host_sdk.h"
+#include "custom_ir.h"
+#include "ir_boot.h"
+
+#define IR_PIN 2
+#define LEGACY_WAIT_MS 2000
+#define ATTACH_MS 1500
+#define LOOP_MS 10
+#define PRINTF_BATCH 64
+
+static void print_banner(void) {
+    ir_boot_printf("\n\n=== SISTEMA IR PARA AR CONDICIONADO ===\n");
+    ir_boot_printf("Raspberry Pi Pico - Protocolo Customizado\n\n");
+    ir_boot_printf("Sistema IR inicializado no pino %d\n", IR_PIN);
+    ir_boot_printf("Pronto para uso!\n");
+    ir_boot_printf("\n=== CONTROLE IR - AR CONDICIONADO ===\n");
+    ir_boot_printf("1 - Ligar AC\n");
+    ir_boot_printf("2 - Desligar AC\n");
+    ir_boot_printf("3 - Temperatura 22°C\n");
+    ir_boot_printf("4 - Temperatura 20°C\n");
+    ir_boot_printf("5 - Ventilador Nível 1\n");
+    ir_boot_printf("6 - Ventilador Nível 2\n");
+    ir_boot_printf("7 - Mostrar estado atual\n");
+    ir_boot_printf("0 - Mostrar menu\n");
+    ir_boot_printf("====================================\n");
+    ir_boot_printf("Digite uma opção: ");
+}
+
+// Do reset até o primeiro quadro sair; devolve o instante em us
+static uint64_t boot(bool legacy) {
+    host_sdk_reset();
+    host_usb_set_connected(false);
+    host_stdin_push("1");
+
+    stdio_init_all();
+    ir_boot_init();
+    if (legacy) {
+        sleep_ms(LEGACY_WAIT_MS);
+    }
+    custom_ir_init(IR_PIN);
+    ir_boot_mark(IR_BOOT_TX_READY);
+    print_banner();
+
+    // Laço principal: atende a fila da serial a cada LOOP_MS
+    while (!ir_boot_reached(IR_BOOT_FIRST_FRAME)) {
+        ir_boot_poll();
+        if (getchar_timeout_us(0) == '1') {
+            send_ir_command_async(IR_ON);
+        }
+        sleep_ms(LOOP_MS);
+    }
+    uint64_t first_frame_us = ir_boot.stage_us[IR_BOOT_FIRST_FRAME];
+
+    // Termina o envio para não deixar alarmes pendentes
+    while (ir_send_busy()) {
+        host_time_advance_to(host_time_next_alarm());
+    }
+    return first_frame_us;
+}
+
+static void run_boot(void *ctx) {
+    bench_sink += (uint32_t)boot(false);
+}
+
+static void run_printf(void *ctx) {
+    for (int i = 0; i < PRINTF_BATCH; i++) {
+        if (ir_boot.console_used > IR_BOOT_CONSOLE_BYTES - IR_BOOT_LINE_LEN) {
+            ir_boot.console_used = 0;
+        }
+        ir_boot_printf("Tempo %d: %dus (%s->%s)\n", i, 560 + i, "HIGH", "LOW");
+    }
+}
+
+// Console sem host: guardado até ATTACH_MS, descartado no prazo
+static void console_sizes(uint32_t *buffered, uint32_t *expired) {
+    boot(false);
+    host_time_advance_to((uint64_t)ATTACH_MS * 1000);
+    ir_boot_poll();
+    *buffered = (uint32_t)ir_boot.console_used;
+
+    while (time_us_64() < (uint64_t)IR_BOOT_CONSOLE_TIMEOUT_MS * 1000) {
+        sleep_ms(100);
+        ir_boot_poll();
+    }
+    *expired = ir_boot.console_lost;
+}
+
+void bench_suite_boot(void) {
+    bench_report("boot.first_frame_legacy_ms", boot(true) / 1000.0, "ms", BENCH_LOWER_IS_BETTER);
+    bench_report("boot.first_frame_ms", boot(false) / 1000.0, "ms", BENCH_LOWER_IS_BETTER);
+
+    uint32_t buffered, expired;
+    console_sizes(&buffered, &expired);
+    bench_report("boot.console_buffered_bytes", buffered, "bytes", BENCH_LOWER_IS_BETTER);
+    bench_report("boot.console_expired_bytes", expired, "bytes", BENCH_LOWER_IS_BETTER);
+
+    bench_time("boot.to_first_frame", run_boot, NULL, 1);
+
+    host_sdk_reset();
+    host_usb_set_connected(false);
+    ir_boot_init();
+    bench_time("boot.printf_per_line", run_printf, NULL, PRINTF_BATCH);
+
+    host_sdk_reset();
+    ir_boot_init();
+}
@@ -0,0 +1,342 @@
+/**
+ * bench_calib.c - Calibração marca/espaço do receptor (ir_calib.c) no canal
+ * IR virtual
+ *
+ * Mede:
+ *
+ *  - o esticamento estimado nas capturas da biblioteca (o mesmo que o
+ *    ir_sigc grava em ir_signals.h);
+ *  - o erro da estimativa com quadros NEC e Philco passados pelo canal com
+ *    esticamentos conhecidos e saneados como no receptor.c;
+ *  - aprender e reenviar: o controle NEC passa pelo canal até o nosso
+ *    sensor, o sinal aprendido (com e sem correção) volta pelo canal até o
+ *    receptor do aparelho, que confere cada tempo com 25% de tolerância, como
+ *    os decodificadores de aparelhos; resultado é o maior esticamento do
+ *    receptor com 99% de acerto;
+ *  - reenvio das capturas Philco da biblioteca, com e sem a correção de
+ *    transmissão, no mesmo tipo de decodificador;
+ *  - ir_fusion: dois sensores com esticamentos diferentes, cada um com a
+ *    própria estimativa;
+ *  - o custo de acumular um quadro na estimativa.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "pico/stdlib.h"
+#include "nec_transmit.h"
+#include "custom_ir.h"
+#include "philco_ac.h"
+#include "ir_capture.h"
+#include "ir_calib.h"
+#include "ir_fusion.h"
+#include "ir_channel.h"
+#include "ir_signals.h"
+
+#define MAX_TIMINGS 1024
+#define SPEC_TOLERANCE_PCT 25
+#define SWEEP_MIN_PCT 99.0
+#define SWEEP_STEP_US 10
+#define SWEEP_MAX_US 300
+#define ROOM_JITTER_US 15               // Ruído de borda do modelo de sala do bench_channel.c
+#define CALIB_FRAMES 4                  // Quadros NEC da calibração antes de aprender
+
+// Tempos nominais de um protocolo de distância de pulso
+typedef struct {
+    uint16_t header_mark_us;
+    uint16_t header_space_us;
+    uint16_t mark_us;
+    uint16_t zero_space_us;
+    uint16_t one_space_us;
+    uint16_t bits;
+} spec_t;
+
+static const spec_t nec_spec = {9000, 4500, 560, 560, 1690, 32};
+static const spec_t philco_spec = {3600, 1750, 390, 390, 1340, PHILCO_AC_FRAME_BITS};
+
+static uint16_t tx[MAX_TIMINGS];
+static uint16_t learned[MAX_TIMINGS];
+static uint16_t rx[MAX_TIMINGS];
+static uint16_t philco_nominal[MAX_TIMINGS];
+static size_t philco_nominal_count;
+static uint8_t philco_bytes[PHILCO_AC_FRAME_BYTES];
+
+static bool spec_ok(uint32_t value, uint32_t nominal) {
+    uint32_t diff = value > nominal ? value - nominal : nominal - value;
+    return diff * 100 <= nominal * SPEC_TOLERANCE_PCT;
+}
+
+/**
+ * Decodificador de aparelho: cada tempo dentro da tolerância do nominal,
+ * bits a partir do bit 0 do primeiro byte
+ */
+static bool spec_decode(const spec_t *spec, const uint16_t *raw, size_t count, uint8_t *bytes) {
+    if (count < 3u + 2u * spec->bits || !spec_ok(raw[0], spec->header_mark_us) ||
+        !spec_ok(raw[1], spec->header_space_us)) {
+        return false;
+    }
+    memset(bytes, 0, (spec->bits + 7u) / 8u);
+    for (int i = 0; i < spec->bits; i++) {
+        uint16_t mark = raw[2 + 2 * i];
+        uint16_t space = raw[3 + 2 * i];
+        if (!spec_ok(mark, spec->mark_us)) {
+            return false;
+        }
+        if (spec_ok(space, spec->one_space_us)) {
+            bytes[i / 8] |= 1 << (i % 8);
+        } else if (!spec_ok(space, spec->zero_space_us)) {
+            return false;
+        }
+    }
+    return spec_ok(raw[2 + 2 * spec->bits], spec->mark_us);
+}
+
+/**
+ * Forma de onda nominal de um quadro
+ */
+static size_t spec_encode(const spec_t *spec, const uint8_t *bytes, uint16_t *out) {
+    size_t n = 0;
+    out[n++] = spec->header_mark_us;
+    out[n++] = spec->header_space_us;
+    for (int i = 0; i < spec->bits; i++) {
+        out[n++] = spec->mark_us;
+        out[n++] = bytes[i / 8] >> (i % 8) & 1 ? spec->one_space_us : spec->zero_space_us;
+    }
+    out[n++] = spec->mark_us;
+    return n;
+}
+
+/**
+ * Captura pelo nosso sensor como o receptor.c: tempos do canal na
+ * estimativa, correção e saneamento
+ */
+static size_t capture(ir_channel_t *channel, const uint16_t *in, size_t count, ir_calib_estimator_t *e,
+                      const ir_calib_t *calib, uint16_t *out) {
+    size_t n = ir_channel_apply(channel, in, count, out, MAX_TIMINGS);
+    if (e) {
+        ir_calib_add_capture(e, out, n);
+    }
+    ir_calib_apply(calib, out, n);
+    ir_sanitizer_t z;
+    ir_sanitizer_init(&z, BENCH_GLITCH_US);
+    return ir_sanitize(out, n, out, &z);
+}
+
+static size_t nec_frame(uint32_t *seed, uint8_t *bytes) {
+    uint32_t r = bench_rand(seed);
+    size_t n = ir_channel_nec_waveform(nec_encode_frame((uint8_t)r, (uint8_t)(r >> 8)), tx);
+    spec_decode(&nec_spec, tx, n, bytes);
+    return n;
+}
+
+/**
+ * Esticamento estimado pelo sensor em quadros passados pelo canal
+ */
+static ir_calib_t calibrate(const ir_channel_model_t *model, bool philco, uint32_t frames, uint32_t seed) {
+    ir_channel_t channel;
+    ir_calib_estimator_t e;
+    ir_calib_t calib = {0};
+    uint8_t bytes[4];
+
+    ir_channel_init(&channel, model, seed);
+    ir_calib_estimator_init(&e);
+    for (uint32_t f = 0; f < frames; f++) {
+        size_t n = philco ? philco_nominal_count : nec_frame(&seed, bytes);
+        capture(&channel, philco ? philco_nominal : tx, n, &e, &calib, learned);
+    }
+    ir_calib_estimate(&e, &calib);
+    return calib;
+}
+
+/**
+ * Aprende quadros NEC pelo nosso sensor e reenvia ao aparelho (mesmo modelo
+ * de receptor nos dois lados)
+ */
+static double replay_nec_pct(const ir_channel_model_t *model, bool corrected, uint32_t frames) {
+    ir_channel_t sensor;
+    ir_channel_t device;
+    uint32_t seed = 0xCA11B0u;
+    uint32_t ok = 0;
+    ir_calib_t calib = {0};
+
+    if (corrected) {
+        calib = calibrate(model, false, CALIB_FRAMES, 0x5EED0200u);
+    }
+    ir_channel_init(&sensor, model, 0x5EED0201u);
+    ir_channel_init(&device, model, 0x5EED0202u);
+    for (uint32_t f = 0; f < frames; f++) {
+        uint8_t expected[4];
+        uint8_t bytes[4];
+        size_t n = nec_frame(&seed, expected);
+        n = capture(&sensor, tx, n, NULL, &calib, learned);
+        n = ir_channel_apply(&device, learned, n, rx, MAX_TIMINGS);
+        ok += spec_decode(&nec_spec, rx, n, bytes) && memcmp(bytes, expected, sizeof(bytes)) == 0;
+    }
+    return 100.0 * ok / frames;
+}
+
+/**
+ * Reenvia a captura OFF da biblioteca ao aparelho, com ou sem a correção
+ * de transmissão (a mesma conta de custom_ir_set_tx_calib())
+ */
+static double replay_philco_pct(const ir_channel_model_t *model, const ir_calib_t *tx_calib, uint32_t frames) {
+    const ir_raw_signal_t *philco = get_raw_signal(IR_OFF);
+    ir_channel_t device;
+    uint32_t ok = 0;
+
+    memcpy(learned, philco->data, philco->length * sizeof(uint16_t));
+    ir_calib_apply(tx_calib, learned, philco->length);
+    ir_channel_init(&device, model, 0x5EED0300u);
+    for (uint32_t f = 0; f < frames; f++) {
+        uint8_t bytes[PHILCO_AC_FRAME_BYTES];
+        size_t n = ir_channel_apply(&device, learned, philco->length, rx, MAX_TIMINGS);
+        ok += spec_decode(&philco_spec, rx, n, bytes) && memcmp(bytes, philco_bytes, sizeof(bytes)) == 0;
+    }
+    return 100.0 * ok / frames;
+}
+
+typedef double (*replay_fn_t)(const ir_channel_model_t *model, const void *arg, uint32_t frames);
+
+static double replay_nec_raw(const ir_channel_model_t *model, const void *arg, uint32_t frames) {
+    return replay_nec_pct(model, false, frames);
+}
+
+static double replay_nec_corrected(const ir_channel_model_t *model, const void *arg, uint32_t frames) {
+    return replay_nec_pct(model, true, frames);
+}
+
+static double replay_philco(const ir_channel_model_t *model, const void *arg, uint32_t frames) {
+    return replay_philco_pct(model, arg, frames);
+}
+
+/**
+ * Maior esticamento do receptor com pelo menos SWEEP_MIN_PCT de acerto
+ */
+static int max_stretch(replay_fn_t fn, const void *arg, uint32_t frames) {
+    int best = -1;
+    for (int stretch = 0; stretch <= SWEEP_MAX_US; stretch += SWEEP_STEP_US) {
+        ir_channel_model_t m = {.mark_stretch_us = (int16_t)stretch, .jitter_us = ROOM_JITTER_US};
+        if (fn(&m, arg, frames) < SWEEP_MIN_PCT) {
+            break;
+        }
+        best = stretch;
+    }
+    return best;
+}
+
+/**
+ * Dois sensores com esticamentos diferentes vendo os mesmos quadros NEC
+ */
+static int fusion_error_us(uint32_t frames) {
+    static ir_fusion_t fusion;
+    static const uint8_t pins[] = {10, 11};
+    static const int16_t stretches[] = {20, 70};
+    ir_channel_t channels[2];
+    uint32_t seed = 0xF0510Au;
+    uint8_t bytes[4];
+
+    ir_fusion_init(&fusion, pins, 2);
+    for (int s = 0; s < 2; s++) {
+        ir_channel_model_t m = {.mark_stretch_us = stretches[s], .jitter_us = ROOM_JITTER_US};
+        ir_channel_init(&channels[s], &m, 0x5EED0400u + s);
+    }
+
+    uint64_t t = 100000;
+    for (uint32_t f = 0; f < frames; f++) {
+        size_t n = nec_frame(&seed, bytes);
+        for (uint8_t s = 0; s < 2; s++) {
+            size_t count = ir_channel_apply(&channels[s], tx, n, rx, MAX_TIMINGS);
+            uint64_t edge = t;
+            for (size_t i = 0; i < count; i++) {
+                ir_fusion_edge(&fusion, s, i % 2 == 1, edge);
+                edge += rx[i];
+            }
+            ir_fusion_edge(&fusion, s, true, edge);
+        }
+        t += 120000;
+        ir_fusion_poll(&fusion, t);
+        ir_fusion_poll(&fusion, t + IR_FUSION_WINDOW_US);
+        while (ir_fusion_peek(&fusion)) {
+            ir_fusion_release(&fusion);
+        }
+        t += IR_FUSION_WINDOW_US + 10000;
+    }
+
+    int worst = ir_fusion_calibrate(&fusion) == 0x3 ? 0 : 999;
+    for (int s = 0; s < 2; s++) {
+        int error = abs(fusion.sensors[s].calib.stretch_us - stretches[s]);
+        worst = error > worst ? error : worst;
+    }
+    return worst;
+}
+
+typedef struct {
+    const uint16_t *raw;
+    size_t count;
+} add_ctx_t;
+
+static void run_add(void *ctx) {
+    add_ctx_t *a = ctx;
+    ir_calib_estimator_t e;
+    ir_calib_estimator_init(&e);
+    bench_sink += (uint32_t)ir_calib_add_capture(&e, a->raw, a->count);
+}
+
+void bench_suite_calib(void) {
+    uint32_t frames = bench_quick ? 50 : 200;
+
+    // Esticamento que o ir_sigc estimou nas capturas da biblioteca
+    ir_calib_t library_calib = {.stretch_us = IR_SIGNALS_STRETCH_US};
+    bench_report("calib.library_stretch_us", IR_SIGNALS_STRETCH_US, "us", BENCH_LOWER_IS_BETTER);
+
+    // Quadro Philco nominal com os bytes da captura OFF
+    const ir_raw_signal_t *philco = get_raw_signal(IR_OFF);
+    spec_decode(&philco_spec, philco->data, philco->length, philco_bytes);
+    philco_nominal_count = spec_encode(&philco_spec, philco_bytes, philco_nominal);
+
+    // Erro da estimativa em esticamentos conhecidos
+    int nec_error = 0;
+    int philco_error = 0;
+    for (int stretch = 0; stretch <= 120; stretch += 40) {
+        ir_channel_model_t m = {.mark_stretch_us = (int16_t)stretch, .jitter_us = ROOM_JITTER_US};
+        int e = abs(calibrate(&m, false, CALIB_FRAMES, 0x5EED0100u + stretch).stretch_us - stretch);
+        nec_error = e > nec_error ? e : nec_error;
+        e = abs(calibrate(&m, true, 1, 0x5EED0180u + stretch).stretch_us - stretch);
+        philco_error = e > philco_error ? e : philco_error;
+    }
+    bench_report("calib.nec_estimate_error_us", nec_error, "us", BENCH_LOWER_IS_BETTER);
+    bench_report("calib.philco_estimate_error_us", philco_error, "us", BENCH_LOWER_IS_BETTER);
+
+    // Aprender e reenviar
+    bench_report("calib.nec_replay_max_stretch_us", max_stretch(replay_nec_raw, NULL, frames), "us",
+                 BENCH_HIGHER_IS_BETTER);
+    bench_report("calib.nec_replay_corrected_max_stretch_us", max_stretch(replay_nec_corrected, NULL, frames), "us",
+                 BENCH_HIGHER_IS_BETTER);
+
+    // Reenvio da biblioteca Philco
+    ir_calib_t none = {0};
+    bench_report("calib.philco_replay_max_stretch_us", max_stretch(replay_philco, &none, frames), "us",
+                 BENCH_HIGHER_IS_BETTER);
+    bench_report("calib.philco_replay_corrected_max_stretch_us", max_stretch(replay_philco, &library_calib, frames),
+                 "us", BENCH_HIGHER_IS_BETTER);
+
+    bench_report("calib.fusion_estimate_error_us", fusion_error_us(bench_quick ? 8 : 32), "us",
+                 BENCH_LOWER_IS_BETTER);
+
+    // Custo por quadro
+    static add_ctx_t nec_ctx;
+    uint32_t seed = 1;
+    uint8_t bytes[4];
+    nec_ctx.count = nec_frame(&seed, bytes);
+    nec_ctx.raw = tx;
+    bench_time("calib.add_capture_nec", run_add, &nec_ctx, 1);
+    static add_ctx_t philco_ctx;
+    philco_ctx.raw = philco->data;
+    philco_ctx.count = philco->length;
+    bench_time("calib.add_capture_philco", run_add, &philco_ctx, 1);
+}
@@ -0,0 +1,229 @@
+/**
+ * bench_capfile.c - Vazão do arquivo de capturas mapeado em memória
+ *
+ * Grava um arquivo de capturas em TMPDIR (256 MB por padrão, 16 MB com
+ * --quick; IR_BENCH_CAPFILE_MB escolhe outro tamanho, por exemplo 4096 para
+ * um arquivo de vários GB), com quadros NEC, códigos de repetição e as
+ * capturas Philco conhecidas, todos com ruído de borda. Mede a gravação, a
+ * leitura sequencial de todos os tempos pelo mapeamento e o acesso a quadros
+ * sorteados pelo índice, e compara os bytes por tempo com o texto do
+ * receptor.c e com uint16_t. Confere a soma dos tempos lidos com a gravada e
+ * a ida e volta das capturas conhecidas pelo texto.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bench.h"
+#include "pico/stdlib.h"
+#include "nec_transmit.h"
+#include "custom_ir.h"
+#include "ir_channel.h"
+#include "ir_capfile_io.h"
+
+#define FILE_MB 256
+#define FILE_MB_QUICK 16
+#define POOL_FRAMES 256
+#define POOL_MAX_TIMINGS 1024
+#define JITTER_US 15
+#define RANDOM_LOOKUPS 4096
+#define SENSOR_PIN 10
+
+typedef struct {
+    uint16_t raw[POOL_MAX_TIMINGS];
+    size_t count;
+} pool_frame_t;
+
+typedef struct {
+    const ir_capfile_t *file;
+    uint32_t *picks;
+} lookup_t;
+
+static pool_frame_t pool[POOL_FRAMES];
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void make_pool(uint32_t *seed) {
+    static const uint16_t repeat_code[] = {9000, 2250, 560};
+    const ir_named_signal_t *signals;
+    size_t signal_count = get_captured_signals(&signals);
+
+    for (size_t f = 0; f < POOL_FRAMES; f++) {
+        pool_frame_t *p = &pool[f];
+        uint32_t r = bench_rand(seed);
+        if (f % 4 == 0) {
+            const ir_raw_signal_t *s = &signals[r % signal_count].signal;
+            memcpy(p->raw, s->data, s->length * sizeof(uint16_t));
+            p->count = s->length;
+        } else if (f % 4 == 1) {
+            memcpy(p->raw, repeat_code, sizeof(repeat_code));
+            p->count = count_of(repeat_code);
+        } else {
+            p->count = ir_channel_nec_waveform(nec_encode_frame((uint8_t)r, (uint8_t)(r >> 8)), p->raw);
+        }
+        for (size_t i = 0; i < p->count; i++) {
+            p->raw[i] = (uint16_t)(p->raw[i] + bench_rand(seed) % (2 * JITTER_US + 1) - JITTER_US);
+        }
+    }
+}
+
+static uint64_t scan(const ir_capfile_t *file) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < file->frame_count; i++) {
+        ir_capfile_frame_t frame;
+        ir_capfile_cursor_t c;
+        uint32_t v;
+        ir_capfile_frame(file, i, &frame);
+        ir_capfile_cursor_init(&c, &frame);
+        while (ir_capfile_next(&c, &v)) {
+            sum += v;
+        }
+    }
+    return sum;
+}
+
+static void run_scan(void *ctx) {
+    bench_sink += (uint32_t)scan(ctx);
+}
+
+static void run_lookup(void *ctx) {
+    const lookup_t *l = ctx;
+    uint16_t raw[POOL_MAX_TIMINGS];
+    uint32_t sum = 0;
+    for (size_t i = 0; i < RANDOM_LOOKUPS; i++) {
+        ir_capfile_frame_t frame;
+        ir_capfile_frame(l->file, l->picks[i], &frame);
+        size_t n = ir_capfile_decode(&frame, raw, POOL_MAX_TIMINGS);
+        sum += raw[n - 1];
+    }
+    bench_sink += sum;
+}
+
+// Capturas conhecidas: arquivo -> texto -> arquivo, com pino e instante
+static uint32_t text_roundtrip(const char *path, size_t *text_bytes, size_t *timings) {
+    const ir_named_signal_t *signals;
+    size_t count = get_captured_signals(&signals);
+    ir_capfile_writer_t w;
+    ir_capfile_map_t m;
+    uint32_t mismatch = 0;
+
+    ir_capfile_writer_open(&w, path);
+    for (size_t s = 0; s < count; s++) {
+        ir_capfile_writer_add(&w, 1000000u * s, SENSOR_PIN, signals[s].signal.data, signals[s].signal.length);
+    }
+    if (!ir_capfile_writer_close(&w) || ir_capfile_map_open(&m, path) != IR_CAPFILE_OK) {
+        return (uint32_t)count;
+    }
+
+    FILE *tmp = tmpfile();
+    for (size_t i = 0; i < m.file.frame_count; i++) {
+        ir_capfile_frame_t frame;
+        ir_capfile_frame(&m.file, i, &frame);
+        ir_capfile_print_text(tmp, &frame, (unsigned)i + 1);
+    }
+    ir_capfile_map_close(&m);
+    *text_bytes = (size_t)ftell(tmp);
+    char *text = malloc(*text_bytes);
+    rewind(tmp);
+    *text_bytes = fread(text, 1, *text_bytes, tmp);
+    fclose(tmp);
+
+    ir_capfile_text_t t;
+    uint16_t raw[IR_CAPFILE_TEXT_MAX_TIMINGS];
+    size_t n, s = 0;
+    *timings = 0;
+    ir_capfile_text_init(&t, text, *text_bytes);
+    while ((n = ir_capfile_text_next(&t, raw)) > 0 && s < count) {
+        const ir_raw_signal_t *sig = &signals[s].signal;
+        mismatch += n != sig->length || memcmp(raw, sig->data, n * sizeof(uint16_t)) != 0 || !t.has_pin ||
+                    t.pin != SENSOR_PIN || t.time_us != 1000000u * s;
+        *timings += n;
+        s++;
+    }
+    mismatch += (uint32_t)(count - s);
+    free(text);
+    return mismatch;
+}
+
+void bench_suite_capfile(void) {
+    const char *env_mb = getenv("IR_BENCH_CAPFILE_MB");
+    const char *tmpdir = getenv("TMPDIR");
+    uint64_t target = (uint64_t)(env_mb ? atoi(env_mb) : bench_quick ? FILE_MB_QUICK : FILE_MB) << 20;
+    char path[512];
+    uint32_t seed = 0xCAF11E5u;
+
+    snprintf(path, sizeof(path), "%s/ir_bench_capfile.ircap", tmpdir ? tmpdir : "/tmp");
+
+    size_t text_bytes = 0, text_timings = 0;
+    bench_report("capfile.text_roundtrip_mismatch", text_roundtrip(path, &text_bytes, &text_timings), "signals",
+                 BENCH_LOWER_IS_BETTER);
+
+    // Gravação
+    ir_capfile_writer_t w;
+    uint64_t expected_sum = 0, timings = 0, frames = 0;
+    make_pool(&seed);
+    if (!ir_capfile_writer_open(&w, path)) {
+        perror(path);
+        return;
+    }
+    double t0 = now_s();
+    uint64_t time_us = 0;
+    while (w.offset < target) {
+        const pool_frame_t *p = &pool[bench_rand(&seed) % POOL_FRAMES];
+        ir_capfile_writer_add(&w, time_us, SENSOR_PIN, p->raw, p->count);
+        for (size_t i = 0; i < p->count; i++) {
+            expected_sum += p->raw[i];
+        }
+        timings += p->count;
+        frames++;
+        time_us += 120000;
+    }
+    if (!ir_capfile_writer_close(&w)) {
+        fprintf(stderr, "%s: falha na gravação\n", path);
+        remove(path);
+        return;
+    }
+    double write_s = now_s() - t0;
+
+    ir_capfile_map_t m;
+    if (ir_capfile_map_open(&m, path) != IR_CAPFILE_OK) {
+        fprintf(stderr, "%s: não abriu\n", path);
+        remove(path);
+        return;
+    }
+    double mb = (double)m.length / (1 << 20);
+    bench_report("capfile.write_mb_per_s", mb / write_s, "MB/s", BENCH_HIGHER_IS_BETTER);
+    bench_report("capfile.bytes_per_timing", (double)m.length / (double)timings, "bytes", BENCH_LOWER_IS_BETTER);
+    bench_report("capfile.text_bytes_per_timing", (double)text_bytes / (double)text_timings, "bytes",
+                 BENCH_LOWER_IS_BETTER);
+    bench_report("capfile.scan_mismatch", scan(&m.file) != expected_sum || m.file.frame_count != frames, "files",
+                 BENCH_LOWER_IS_BETTER);
+
+    // Leitura sequencial de todos os tempos
+    double ns = bench_ns_per_op(run_scan, &m.file, timings);
+    bench_report("capfile.scan_per_timing", ns, "ns/op", BENCH_LOWER_IS_BETTER);
+    bench_report("capfile.scan_mb_per_s", mb / (ns * (double)timings * 1e-9), "MB/s", BENCH_HIGHER_IS_BETTER);
+
+    // Quadros sorteados pelo índice
+    uint32_t *picks = malloc(RANDOM_LOOKUPS * sizeof(uint32_t));
+    for (size_t i = 0; i < RANDOM_LOOKUPS; i++) {
+        picks[i] = bench_rand(&seed) % m.file.frame_count;
+    }
+    lookup_t lookup = {&m.file, picks};
+    bench_time("capfile.random_frame", run_lookup, &lookup, RANDOM_LOOKUPS);
+
+    free(picks);
+    ir_capfile_map_close(&m);
+    remove(path);
+}
@@ -0,0 +1,196 @@
+/**
+ * bench_channel.c - Tolerância dos decodificadores no canal IR virtual
+ *
+ * Passa quadros pelo canal de host/sim/ir_channel.c e entrega a saída a três
+ * receptores:
+ *
+ *  - nec: forma de onda do nec_carrier_control.pio no modelo do
+ *    nec_receive.pio, conferido com nec_decode_frame();
+ *  - philco_soft: captura OFF do Philco no decodificador de philco_ac.c;
+ *  - philco_hard: a mesma captura no decodificador de limiar fixo;
+ *  - philco_gpio: a mesma captura tocada como bordas na interrupção de GPIO
+ *    do shim, montada por ir_fusion.c e decodificada por philco_ac.c.
+ *
+ * Mede a vazão do canal (quadros NEC por minuto) e, para cada receptor, a
+ * taxa de acerto em um modelo de sala e o maior esticamento de marca e o
+ * maior ruído de borda com pelo menos 99% de acerto.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "bench.h"
+#include "pico/stdlib.h"
+#include "hardware/timer.h"
+#include "host_sdk.h"
+#include "nec_transmit.h"
+#include "nec_receive.h"
+#include "custom_ir.h"
+#include "philco_ac.h"
+#include "ir_fusion.h"
+#include "ir_channel.h"
+
+#define SWEEP_MIN_PCT 99.0
+#define MAX_TIMINGS 1024
+#define SENSOR_PIN 10
+
+typedef enum {
+    RX_NEC,
+    RX_PHILCO_SOFT,
+    RX_PHILCO_HARD,
+    RX_COUNT
+} receiver_t;
+
+static const char *receiver_names[RX_COUNT] = {"nec", "philco_soft", "philco_hard"};
+
+// Sala: o receptor estica as marcas como nas capturas, reflexo forte na
+// parede alongando parte das marcas e uma lâmpada fluorescente de vez em quando
+static const ir_channel_model_t room = {
+    .mark_stretch_us = 40,
+    .jitter_us = 15,
+    .dropout_ppm = 500,
+    .glitch_per_s = 4,
+    .glitch_us = 60,
+    .echo_delay_us = 30,
+    .echo_pct = 20,
+};
+
+static uint16_t rx[MAX_TIMINGS];
+static uint8_t philco_bytes[PHILCO_AC_FRAME_BYTES];
+
+/**
+ * Acertos de um receptor em frames quadros pelo modelo dado
+ */
+static double success_pct(receiver_t receiver, const ir_channel_model_t *model, uint32_t frames) {
+    ir_channel_t channel;
+    uint32_t seed = 0xC4A77E1u;
+    uint32_t ok = 0;
+    const ir_raw_signal_t *philco = get_raw_signal(IR_OFF);
+
+    ir_channel_init(&channel, model, 0x5EED0001u + receiver);
+    for (uint32_t f = 0; f < frames; f++) {
+        if (receiver == RX_NEC) {
+            uint32_t r = bench_rand(&seed);
+            uint8_t address = (uint8_t)r;
+            uint8_t data = (uint8_t)(r >> 8);
+            uint16_t tx[IR_CHANNEL_NEC_TIMINGS];
+            size_t n = ir_channel_nec_waveform(nec_encode_frame(address, data), tx);
+            n = ir_channel_apply(&channel, tx, n, rx, MAX_TIMINGS);
+
+            uint32_t words[4];
+            size_t count = ir_channel_nec_receive(rx, n, words, count_of(words));
+            uint8_t a, d;
+            ok += count == 1 && nec_decode_frame(words[0], &a, &d) && a == address && d == data;
+        } else {
+            size_t n = ir_channel_apply(&channel, philco->data, philco->length, rx, MAX_TIMINGS);
+            if (receiver == RX_PHILCO_SOFT) {
+                philco_ac_frame_t out;
+                ok += philco_ac_decode(rx, n, &out) && memcmp(out.bytes, philco_bytes, sizeof(philco_bytes)) == 0;
+            } else {
+                uint8_t bytes[PHILCO_AC_FRAME_BYTES];
+                ok += bench_philco_hard_decode(rx, n, bytes) && memcmp(bytes, philco_bytes, sizeof(bytes)) == 0;
+            }
+        }
+    }
+    return 100.0 * ok / frames;
+}
+
+/**
+ * Caminho completo pela interrupção de GPIO: canal -> bordas -> ir_fusion
+ */
+static double gpio_success_pct(uint32_t frames) {
+    static ir_fusion_t fusion;
+    static const uint8_t pins[] = {SENSOR_PIN};
+    const ir_raw_signal_t *philco = get_raw_signal(IR_OFF);
+    ir_channel_t channel;
+    uint32_t ok = 0;
+
+    host_sdk_reset();
+    ir_fusion_init(&fusion, pins, 1);
+    ir_fusion_attach_gpio(&fusion);
+    host_gpio_drive(SENSOR_PIN, true);
+    ir_channel_init(&channel, &room, 0x5EED0100u);
+
+    uint64_t t = 100000;
+    for (uint32_t f = 0; f < frames; f++) {
+        size_t n = ir_channel_apply(&channel, philco->data, philco->length, rx, MAX_TIMINGS);
+        t = ir_channel_play(rx, n, SENSOR_PIN, t) + 1000;
+
+        // Silêncio até o quadro fechar e o evento sair
+        const ir_fusion_event_t *ev = NULL;
+        for (uint64_t end = t + IR_FUSION_GAP_US + IR_FUSION_WINDOW_US + 5000; !ev && t < end; t += 1000) {
+            host_time_advance_to(t);
+            ir_fusion_poll(&fusion, time_us_64());
+            ev = ir_fusion_peek(&fusion);
+        }
+        if (ev) {
+            philco_ac_frame_t out;
+            ok += philco_ac_decode(ev->raw, ev->count, &out) && memcmp(out.bytes, philco_bytes, sizeof(philco_bytes)) == 0;
+            ir_fusion_release(&fusion);
+        }
+        t += 50000;
+    }
+    return 100.0 * ok / frames;
+}
+
+typedef struct {
+    ir_channel_t channel;
+    uint16_t tx[IR_CHANNEL_NEC_TIMINGS];
+} throughput_ctx_t;
+
+static void run_apply(void *ctx) {
+    throughput_ctx_t *t = ctx;
+    bench_sink += (uint32_t)ir_channel_apply(&t->channel, t->tx, IR_CHANNEL_NEC_TIMINGS, rx, MAX_TIMINGS);
+}
+
+void bench_suite_channel(void) {
+    uint32_t frames = bench_quick ? 200 : 2000;
+    char name[64];
+
+    // Referência: o quadro que o decodificador recupera da captura sem canal
+    const ir_raw_signal_t *philco = get_raw_signal(IR_OFF);
+    philco_ac_frame_t clean;
+    philco_ac_decode(philco->data, philco->length, &clean);
+    memcpy(philco_bytes, clean.bytes, sizeof(philco_bytes));
+
+    static throughput_ctx_t t;
+    ir_channel_init(&t.channel, &room, 1);
+    ir_channel_nec_waveform(nec_encode_frame(0x80, 0x14), t.tx);
+    double ns = bench_ns_per_op(run_apply, &t, 1);
+    bench_report("channel.apply_nec", ns, "ns/op", BENCH_LOWER_IS_BETTER);
+    bench_report("channel.nec_frames_per_min", 60e9 / ns, "frames/min", BENCH_HIGHER_IS_BETTER);
+
+    for (receiver_t r = RX_NEC; r < RX_COUNT; r++) {
+        snprintf(name, sizeof(name), "channel.%s_room_ok_pct", receiver_names[r]);
+        bench_report(name, success_pct(r, &room, frames), "%", BENCH_HIGHER_IS_BETTER);
+
+        // Esticamento de marca, sem outros efeitos
+        int max_stretch = -1;
+        for (int stretch = 0; stretch <= 400; stretch += 25) {
+            ir_channel_model_t m = {.mark_stretch_us = (int16_t)stretch};
+            if (success_pct(r, &m, frames / 4) < SWEEP_MIN_PCT) {
+                break;
+            }
+            max_stretch = stretch;
+        }
+        snprintf(name, sizeof(name), "channel.%s_max_stretch_us", receiver_names[r]);
+        bench_report(name, max_stretch, "us", BENCH_HIGHER_IS_BETTER);
+
+        // Ruído de borda, com o esticamento da sala
+        int max_jitter = -1;
+        for (int jitter = 0; jitter <= 300; jitter += 25) {
+            ir_channel_model_t m = {.mark_stretch_us = room.mark_stretch_us, .jitter_us = (uint16_t)jitter};
+            if (success_pct(r, &m, frames / 4) < SWEEP_MIN_PCT) {
+                break;
+            }
+            max_jitter = jitter;
+        }
+        snprintf(name, sizeof(name), "channel.%s_max_jitter_us", receiver_names[r]);
+        bench_report(name, max_jitter, "us", BENCH_HIGHER_IS_BETTER);
+    }
+
+    bench_report("channel.philco_gpio_room_ok_pct", gpio_success_pct(frames / 4), "%", BENCH_HIGHER_IS_BETTER);
+}
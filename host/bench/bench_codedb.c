@@ -0,0 +1,461 @@
+/**
+ * bench_codedb.c - Importação LIRC/Pronto e consultas ao banco de códigos
+ *
+ * Gera em memória arquivos .conf do LIRC com centenas de dispositivos (NEC,
+ * distância de pulso no estilo Samsung, RC5, RC6, SIRC e RAW_CODES com
+ * largura de pulso) e códigos Pronto (NEC aprendido e 5000), guardando o
+ * código esperado de cada tecla. Mede a vazão da importação e da montagem
+ * da imagem, confere cada tecla consultada na imagem contra o esperado e
+ * mede a consulta por nomes (dispositivo + tecla, as duas buscas binárias)
+ * e a expansão de um sinal RAW, como o firmware faria sobre a flash.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "nec_transmit.h"
+#include "ir_codedb.h"
+#include "ir_codedb_import.h"
+
+#define LIRC_DEVICES 400
+#define LIRC_DEVICES_QUICK 60
+#define PRONTO_DEVICES 60
+#define PRONTO_DEVICES_QUICK 10
+#define MAX_KEYS_PER_DEVICE 56
+#define MAX_EXPECTED ((LIRC_DEVICES + PRONTO_DEVICES) * MAX_KEYS_PER_DEVICE)
+#define RAW_BITS 24
+#define RAW_TIMINGS (2 + 2 * RAW_BITS + 1)
+#define LOOKUPS 4096
+
+typedef struct {
+    char device[IR_CODEDB_MAX_NAME];
+    char key[IR_CODEDB_MAX_NAME];
+    ir_codedb_protocol_t protocol;
+    uint64_t code;
+    uint16_t raw[RAW_TIMINGS];          // Só RAW
+} expected_t;
+
+typedef struct {
+    char *data;
+    size_t size;
+    size_t capacity;
+} text_t;
+
+static expected_t *expected;
+static size_t expected_count;
+
+static const char *const key_names[] = {
+    "KEY_POWER", "KEY_MUTE", "KEY_VOLUMEUP", "KEY_VOLUMEDOWN", "KEY_CHANNELUP", "KEY_CHANNELDOWN",
+    "KEY_MENU", "KEY_INFO", "KEY_UP", "KEY_DOWN", "KEY_LEFT", "KEY_RIGHT", "KEY_OK", "KEY_EXIT",
+    "KEY_BACK", "KEY_HOME", "KEY_PLAY", "KEY_PAUSE", "KEY_STOP", "KEY_RECORD", "KEY_REWIND",
+    "KEY_FASTFORWARD", "KEY_RED", "KEY_GREEN", "KEY_YELLOW", "KEY_BLUE", "KEY_TV", "KEY_SLEEP",
+};
+
+static void append(text_t *t, const char *fmt, ...) {
+    for (;;) {
+        va_list ap;
+        va_start(ap, fmt);
+        int n = vsnprintf(t->data + t->size, t->capacity - t->size, fmt, ap);
+        va_end(ap);
+        if ((size_t)n < t->capacity - t->size) {
+            t->size += (size_t)n;
+            return;
+        }
+        t->capacity = t->capacity ? t->capacity * 2 : 1 << 20;
+        t->data = realloc(t->data, t->capacity);
+    }
+}
+
+static uint64_t reverse_bits(uint64_t v, unsigned bits) {
+    uint64_t r = 0;
+    for (unsigned i = 0; i < bits; i++) {
+        r = r << 1 | (v >> i & 1);
+    }
+    return r;
+}
+
+static void key_name(char *out, size_t k) {
+    if (k < sizeof(key_names) / sizeof(key_names[0])) {
+        snprintf(out, IR_CODEDB_MAX_NAME, "%s", key_names[k]);
+    } else {
+        snprintf(out, IR_CODEDB_MAX_NAME, "KEY_F%zu", k);
+    }
+}
+
+static expected_t *expect(const char *device, size_t k, ir_codedb_protocol_t protocol, uint64_t code) {
+    expected_t *e = &expected[expected_count++];
+    snprintf(e->device, sizeof(e->device), "%s", device);
+    key_name(e->key, k);
+    e->protocol = protocol;
+    e->code = code;
+    return e;
+}
+
+/**
+ * Um remote do LIRC por dispositivo, do tipo dado por d % 10
+ */
+static void make_lirc(text_t *t, size_t devices, uint32_t *seed) {
+    static const char *const kinds[] = {"nec", "nec", "nec", "nec", "nec", "samsung", "rc5", "rc6", "sirc", "raw"};
+    for (size_t d = 0; d < devices; d++) {
+        const char *kind = kinds[d % 10];
+        char device[IR_CODEDB_MAX_NAME];
+        snprintf(device, sizeof(device), "%s_%04zu", kind, d);
+        size_t keys = 24 + bench_rand(seed) % (MAX_KEYS_PER_DEVICE - 24 + 1);
+        uint8_t address = (uint8_t)bench_rand(seed);
+
+        append(t, "#\n# %s\n#\n\nbegin remote\n\n  name  %s\n", device, device);
+        if (strcmp(kind, "nec") == 0 || strcmp(kind, "samsung") == 0) {
+            bool nec = kind[0] == 'n';
+            append(t, "  bits           16\n  flags SPACE_ENC|CONST_LENGTH\n  eps            30\n  aeps          100\n\n");
+            append(t, "  header       %s\n  one           560  1690\n  zero          560   560\n  ptrail        560\n",
+                   nec ? "9000  4500" : "4500  4500");
+            uint16_t pre = nec ? (uint16_t)(reverse_bits(address, 8) << 8 | reverse_bits(address ^ 0xFF, 8))
+                               : (uint16_t)(reverse_bits(address, 8) << 8 | reverse_bits(address, 8));
+            append(t, "  pre_data_bits   16\n  pre_data       0x%04X\n  gap          108000\n\n  begin codes\n", pre);
+            for (size_t k = 0; k < keys; k++) {
+                uint8_t command = (uint8_t)(k * 7 + 1);
+                uint16_t code = (uint16_t)(reverse_bits(command, 8) << 8 | reverse_bits(command ^ 0xFF, 8));
+                char name[IR_CODEDB_MAX_NAME];
+                key_name(name, k);
+                append(t, "      %-24s 0x%04X\n", name, code);
+                uint64_t full = (uint64_t)pre << 16 | code;
+                expect(device, k, nec ? IR_CODEDB_NEC : IR_CODEDB_PULSE_DISTANCE,
+                       nec ? nec_encode_frame(address, command) : reverse_bits(full, 32));
+            }
+            append(t, "  end codes\n\nend remote\n\n");
+        } else if (strcmp(kind, "rc5") == 0) {
+            append(t, "  bits           13\n  flags RC5|CONST_LENGTH\n  eps            30\n  aeps          100\n\n");
+            append(t, "  one           889   889\n  zero          889   889\n  plead         889\n  gap          113792\n");
+            append(t, "  toggle_bit_mask 0x800\n\n  begin codes\n");
+            for (size_t k = 0; k < keys; k++) {
+                uint8_t command = (uint8_t)(k % 128);
+                uint8_t addr = address & 0x1F;
+                uint32_t code = (uint32_t)(command & 0x40 ? 0 : 1) << 12 | (uint32_t)addr << 6 | (command & 0x3F);
+                char name[IR_CODEDB_MAX_NAME];
+                key_name(name, k);
+                append(t, "      %-24s 0x%04X\n", name, code);
+                expect(device, k, IR_CODEDB_RC5, (uint64_t)addr << 8 | command);
+            }
+            append(t, "  end codes\n\nend remote\n\n");
+        } else if (strcmp(kind, "rc6") == 0) {
+            append(t, "  bits           16\n  flags RC6|CONST_LENGTH\n  eps            30\n  aeps          100\n\n");
+            append(t, "  header       2664   888\n  one           444   444\n  zero          444   444\n");
+            append(t, "  pre_data_bits   5\n  pre_data       0x10\n  gap          105000\n  rc6_mask    0x10000\n\n");
+            append(t, "  begin codes\n");
+            for (size_t k = 0; k < keys; k++) {
+                uint16_t code = (uint16_t)(address << 8 | (k * 3));
+                char name[IR_CODEDB_MAX_NAME];
+                key_name(name, k);
+                append(t, "      %-24s 0x%04X\n", name, code);
+                expect(device, k, IR_CODEDB_RC6, code);
+            }
+            append(t, "  end codes\n\nend remote\n\n");
+        } else if (strcmp(kind, "sirc") == 0) {
+            unsigned bits = d % 3 == 0 ? 12 : d % 3 == 1 ? 15 : 20;
+            append(t, "  bits           %u\n  flags SPACE_ENC|CONST_LENGTH\n  eps            30\n  aeps          100\n\n",
+                   bits);
+            append(t, "  header       2400   600\n  one          1200   600\n  zero          600   600\n");
+            append(t, "  gap          45000\n  min_repeat      2\n\n  begin codes\n");
+            for (size_t k = 0; k < keys; k++) {
+                uint64_t value = (k % 128) | (uint64_t)(address & ((1u << (bits - 7)) - 1)) << 7;
+                char name[IR_CODEDB_MAX_NAME];
+                key_name(name, k);
+                append(t, "      %-24s 0x%llX\n", name, (unsigned long long)reverse_bits(value, bits));
+                expect(device, k, IR_CODEDB_SIRC, value);
+            }
+            append(t, "  end codes\n\nend remote\n\n");
+        } else {
+            // Largura de pulso com cabeçalho: fica RAW
+            append(t, "  flags RAW_CODES\n  eps            30\n  aeps          100\n  frequency    36000\n");
+            append(t, "  gap          40000\n\n  begin raw_codes\n\n");
+            for (size_t k = 0; k < keys; k++) {
+                char name[IR_CODEDB_MAX_NAME];
+                key_name(name, k);
+                expected_t *e = expect(device, k, IR_CODEDB_RAW, 0);
+                uint32_t value = bench_rand(seed);
+                uint16_t *raw = e->raw;
+                size_t n = 0;
+                raw[n++] = 3000;
+                raw[n++] = 3000;
+                for (unsigned i = 0; i < RAW_BITS; i++) {
+                    raw[n++] = value >> i & 1 ? 1500 : 500;
+                    raw[n++] = 1000;
+                }
+                raw[n++] = 500;
+                append(t, "    name %s\n", name);
+                for (size_t i = 0; i < n; i++) {
+                    append(t, "%s%7u%s", i % 6 == 0 ? "   " : "", raw[i], i % 6 == 5 || i == n - 1 ? "\n" : "");
+                }
+                append(t, "\n");
+            }
+            append(t, "  end raw_codes\n\nend remote\n\n");
+        }
+    }
+}
+
+/**
+ * Controle MCE (RC6 modo 6, 32 bits): o LIRC descreve com o mesmo flag RC6,
+ * mas o banco só guarda o modo 0 e as teclas têm de ser recusadas
+ */
+static const char rc6_mce_conf[] =
+    "begin remote\n\n  name  mceusb\n  bits           16\n  flags RC6|CONST_LENGTH\n"
+    "  eps            30\n  aeps          100\n\n  header       2667   889\n"
+    "  one           444   444\n  zero          444   444\n  pre_data_bits   21\n"
+    "  pre_data       0x37FF0\n  gap          105000\n  toggle_bit_mask 0x8000\n"
+    "  rc6_mask    0x100000000\n\n  begin codes\n"
+    "      KEY_POWER                0x7BF3\n      KEY_VOLUMEUP             0x7BEF\n"
+    "      KEY_VOLUMEDOWN           0x7BEE\n      KEY_MUTE                 0x7BF1\n"
+    "  end codes\n\nend remote\n";
+#define RC6_MCE_KEYS 4
+
+/**
+ * Códigos Pronto: NEC aprendido (0000, 38 kHz) e RC5 (5000)
+ */
+static void make_pronto(text_t *t, size_t device, uint32_t *seed, char *name) {
+    snprintf(name, IR_CODEDB_MAX_NAME, "pronto_%04zu", device);
+    size_t keys = 24 + bench_rand(seed) % (MAX_KEYS_PER_DEVICE - 24 + 1);
+    uint8_t address = (uint8_t)bench_rand(seed);
+    bool rc5 = device % 4 == 3;
+    const double unit_us = 0x6D * 0.241246;
+    for (size_t k = 0; k < keys; k++) {
+        char key[IR_CODEDB_MAX_NAME];
+        key_name(key, k);
+        if (rc5) {
+            uint8_t command = (uint8_t)(k % 128);
+            append(t, "%s 5000 0073 0000 0001 %04X %04X\n", key, address & 0x1F, command);
+            expect(name, k, IR_CODEDB_RC5, (uint64_t)(address & 0x1F) << 8 | command);
+            continue;
+        }
+        uint8_t command = (uint8_t)(k * 5 + 3);
+        uint32_t frame = nec_encode_frame(address, command);
+        append(t, "%s 0000 006D 0022 0000 %04X %04X", key, (unsigned)lround(9000 / unit_us),
+               (unsigned)lround(4500 / unit_us));
+        for (unsigned i = 0; i < 32; i++) {
+            append(t, " 0015 %04X", frame >> i & 1 ? 0x0040 : 0x0015);
+        }
+        append(t, " 0015 %04X\n", (unsigned)lround(40000 / unit_us));
+        expect(name, k, IR_CODEDB_NEC, frame);
+    }
+}
+
+typedef struct {
+    const text_t *lirc;
+    const text_t *pronto;
+    const char (*pronto_names)[IR_CODEDB_MAX_NAME];
+    const size_t *pronto_offsets;       // Início do texto de cada dispositivo Pronto
+    size_t pronto_devices;
+} import_ctx_t;
+
+static void import_lirc(ir_codedb_builder_t *b, const import_ctx_t *c) {
+    ir_codedb_import_lirc(b, c->lirc->data, c->lirc->size);
+}
+
+static void import_pronto(ir_codedb_builder_t *b, const import_ctx_t *c) {
+    for (size_t d = 0; d < c->pronto_devices; d++) {
+        ir_codedb_import_pronto(b, c->pronto_names[d], c->pronto->data + c->pronto_offsets[d],
+                                c->pronto_offsets[d + 1] - c->pronto_offsets[d]);
+    }
+}
+
+static void run_import_lirc(void *ctx) {
+    ir_codedb_builder_t b;
+    ir_codedb_builder_init(&b);
+    import_lirc(&b, ctx);
+    bench_sink += b.keys;
+    ir_codedb_builder_free(&b);
+}
+
+static void run_import_pronto(void *ctx) {
+    ir_codedb_builder_t b;
+    ir_codedb_builder_init(&b);
+    import_pronto(&b, ctx);
+    bench_sink += b.keys;
+    ir_codedb_builder_free(&b);
+}
+
+static void run_import_build(void *ctx) {
+    ir_codedb_builder_t b;
+    size_t size;
+    ir_codedb_builder_init(&b);
+    import_lirc(&b, ctx);
+    import_pronto(&b, ctx);
+    uint8_t *image = ir_codedb_build(&b, &size);
+    bench_sink += (uint32_t)size;
+    free(image);
+    ir_codedb_builder_free(&b);
+}
+
+typedef struct {
+    const ir_codedb_t *db;
+    const uint32_t *picks;
+    const int32_t *devices;             // Índice do dispositivo de cada expected
+} lookup_ctx_t;
+
+static void run_lookup(void *ctx) {
+    const lookup_ctx_t *c = ctx;
+    ir_codedb_code_t code;
+    for (size_t i = 0; i < LOOKUPS; i++) {
+        const expected_t *e = &expected[c->picks[i]];
+        bench_sink += ir_codedb_lookup(c->db, e->device, e->key, &code);
+    }
+}
+
+static void run_find_key(void *ctx) {
+    const lookup_ctx_t *c = ctx;
+    ir_codedb_code_t code;
+    for (size_t i = 0; i < LOOKUPS; i++) {
+        const expected_t *e = &expected[c->picks[i]];
+        bench_sink += ir_codedb_find_key(c->db, c->devices[c->picks[i]], e->key, &code);
+    }
+}
+
+typedef struct {
+    ir_codedb_code_t codes[64];
+    size_t count;
+} raw_ctx_t;
+
+static void run_raw_decode(void *ctx) {
+    const raw_ctx_t *c = ctx;
+    uint16_t out[RAW_TIMINGS];
+    for (size_t i = 0; i < c->count; i++) {
+        bench_sink += (uint32_t)ir_codedb_raw_decode(&c->codes[i], out, RAW_TIMINGS);
+    }
+}
+
+static bool raw_matches(const ir_codedb_code_t *code, const uint16_t *raw) {
+    uint16_t out[RAW_TIMINGS];
+    if (ir_codedb_raw_decode(code, out, RAW_TIMINGS) != RAW_TIMINGS) {
+        return false;
+    }
+    for (size_t i = 0; i < RAW_TIMINGS; i++) {
+        uint32_t diff = out[i] > raw[i] ? out[i] - raw[i] : raw[i] - out[i];
+        if (diff * 100 > (uint32_t)raw[i] * IR_CODEDB_LEVEL_TOLERANCE_PCT) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void bench_suite_codedb(void) {
+    size_t lirc_devices = bench_quick ? LIRC_DEVICES_QUICK : LIRC_DEVICES;
+    size_t pronto_devices = bench_quick ? PRONTO_DEVICES_QUICK : PRONTO_DEVICES;
+    uint32_t seed = 0xC0DEDB49u;
+    expected = malloc(MAX_EXPECTED * sizeof(expected_t));
+    expected_count = 0;
+
+    text_t lirc = {0};
+    text_t pronto = {0};
+    static char pronto_names[PRONTO_DEVICES][IR_CODEDB_MAX_NAME];
+    static size_t pronto_offsets[PRONTO_DEVICES + 1];
+    make_lirc(&lirc, lirc_devices, &seed);
+    for (size_t d = 0; d < pronto_devices; d++) {
+        pronto_offsets[d] = pronto.size;
+        make_pronto(&pronto, d, &seed, pronto_names[d]);
+    }
+    pronto_offsets[pronto_devices] = pronto.size;
+    import_ctx_t ictx = {&lirc, &pronto, pronto_names, pronto_offsets, pronto_devices};
+
+    // Vazão (texto por segundo) e montagem
+    double lirc_ns = bench_ns_per_op(run_import_lirc, &ictx, 1);
+    double pronto_ns = bench_ns_per_op(run_import_pronto, &ictx, 1);
+    bench_report("codedb.lirc_import_mb_per_s", (double)lirc.size / (1 << 20) / (lirc_ns * 1e-9), "MB/s",
+                 BENCH_HIGHER_IS_BETTER);
+    bench_report("codedb.pronto_import_mb_per_s", (double)pronto.size / (1 << 20) / (pronto_ns * 1e-9), "MB/s",
+                 BENCH_HIGHER_IS_BETTER);
+    bench_time("codedb.import_build_per_key", run_import_build, &ictx, expected_count);
+
+    ir_codedb_builder_t b;
+    size_t size;
+    ir_codedb_builder_init(&b);
+    import_lirc(&b, &ictx);
+    import_pronto(&b, &ictx);
+    uint8_t *image = ir_codedb_build(&b, &size);
+    ir_codedb_t db;
+    if (!image || ir_codedb_open(&db, image, size) != IR_CODEDB_OK) {
+        fprintf(stderr, "codedb: imagem inválida\n");
+        free(image);
+        ir_codedb_builder_free(&b);
+        free(expected);
+        free(lirc.data);
+        free(pronto.data);
+        return;
+    }
+
+    // Cada tecla consultada na imagem contra o esperado
+    int32_t *devices = malloc(expected_count * sizeof(int32_t));
+    uint32_t errors = 0;
+    uint32_t normalized = 0;
+    uint32_t raw_keys = 0;
+    uint64_t raw_bytes = 0;
+    uint32_t max_keys = 0;
+    raw_ctx_t *raw = calloc(1, sizeof(raw_ctx_t));
+    for (size_t i = 0; i < expected_count; i++) {
+        const expected_t *e = &expected[i];
+        ir_codedb_code_t code;
+        devices[i] = ir_codedb_find_device(&db, e->device);
+        if (!ir_codedb_find_key(&db, devices[i], e->key, &code) || code.protocol != e->protocol) {
+            errors++;
+            continue;
+        }
+        if (code.protocol == IR_CODEDB_RAW) {
+            errors += !raw_matches(&code, e->raw);
+            raw_keys++;
+            raw_bytes += code.raw_size;
+            if (raw->count < sizeof(raw->codes) / sizeof(raw->codes[0])) {
+                raw->codes[raw->count++] = code;
+            }
+        } else {
+            errors += code.code != e->code;
+            normalized++;
+        }
+    }
+    for (uint32_t d = 0; d < db.device_count; d++) {
+        ir_codedb_device_t dev;
+        ir_codedb_device(&db, d, &dev);
+        max_keys = dev.key_count > max_keys ? dev.key_count : max_keys;
+    }
+    bench_report("codedb.import_errors", errors + b.rejected + b.duplicates, "keys", BENCH_LOWER_IS_BETTER);
+    bench_report("codedb.normalized_pct", 100.0 * normalized / expected_count, "%", BENCH_HIGHER_IS_BETTER);
+    bench_report("codedb.bytes_per_key", (double)size / expected_count, "bytes", BENCH_LOWER_IS_BETTER);
+    bench_report("codedb.raw_bytes_per_timing", raw_keys ? (double)raw_bytes / (raw_keys * RAW_TIMINGS) : 0, "bytes",
+                 BENCH_LOWER_IS_BETTER);
+    bench_report("codedb.text_bytes_per_key", (double)(lirc.size + pronto.size) / expected_count, "bytes",
+                 BENCH_LOWER_IS_BETTER);
+    bench_report("codedb.lookup_compares_max", ceil(log2(db.device_count + 1.0)) + ceil(log2(max_keys + 1.0)),
+                 "count", BENCH_LOWER_IS_BETTER);
+
+    // RC6 fora do modo 0: nenhuma tecla entra, todas contadas como recusadas
+    ir_codedb_builder_t mce;
+    ir_codedb_builder_init(&mce);
+    ir_codedb_import_lirc(&mce, rc6_mce_conf, sizeof(rc6_mce_conf) - 1);
+    bench_check("codedb.rc6_mode6_rejected", mce.keys == 0 && mce.rejected == RC6_MCE_KEYS);
+    ir_codedb_builder_free(&mce);
+
+    // Consultas a teclas sorteadas
+    uint32_t *picks = malloc(LOOKUPS * sizeof(uint32_t));
+    for (size_t i = 0; i < LOOKUPS; i++) {
+        picks[i] = bench_rand(&seed) % expected_count;
+    }
+    lookup_ctx_t lctx = {&db, picks, devices};
+    bench_time("codedb.lookup", run_lookup, &lctx, LOOKUPS);
+    bench_time("codedb.find_key", run_find_key, &lctx, LOOKUPS);
+    if (raw->count) {
+        bench_time("codedb.raw_decode_per_timing", run_raw_decode, raw, raw->count * RAW_TIMINGS);
+    }
+
+    free(raw);
+    free(picks);
+    free(devices);
+    free(image);
+    ir_codedb_builder_free(&b);
+    free(expected);
+    free(lirc.data);
+    free(pronto.data);
+}
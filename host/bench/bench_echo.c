@@ -0,0 +1,277 @@
+/**
+ * bench_echo.c - Supressão de eco (ir_echo.c) com TX e RX no mesmo PIO
+ *
+ * Reproduz o laço do Philco.c no relógio virtual com um laço de retorno
+ * simulado: cada quadro escrito no FIFO TX ocupa o ar por um quadro NEC
+ * (em fila, como na state machine) e chega ao FIFO RX logo depois do fim;
+ * quadros de um controle externo chegam em instantes aleatórios, alguns
+ * iguais ao último envio e logo depois dele. Quadros que se cruzam no ar
+ * chegam corrompidos.
+ *
+ * O modo sem supressão mostra quantos ecos o laço antigo processaria como
+ * recebidos; no modo com supressão nenhum eco deve vazar e nenhum quadro
+ * externo limpo deve ser descartado.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "bench.h"
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+#include "hardware/timer.h"
+#include "host_sdk.h"
+#include "nec_transmit.h"
+#include "nec_receive.h"
+#include "ir_echo.h"
+
+#define TX_PIN 16
+#define RX_PIN 15
+#define RX_LATENCY_US 600           // Do fim do quadro até o push no FIFO RX
+#define LOOP_TICK_US 1000           // getchar_timeout_us(1000) do Philco.c
+#define MAX_AIR 64
+#define MAX_PENDING 16
+
+typedef enum {
+    ORIGIN_SELF,
+    ORIGIN_EXTERNAL,
+    ORIGIN_COLLIDED
+} origin_t;
+
+typedef struct {
+    uint64_t start_us;
+    uint64_t end_us;
+    uint32_t frame;
+    bool self;
+    bool delivered;
+} air_frame_t;
+
+typedef struct {
+    uint32_t sent;
+    uint32_t self_leaked;           // Eco entregue como recebido
+    uint32_t self_suppressed;
+    uint32_t external_sent;
+    uint32_t external_accepted;
+    uint32_t external_dropped;      // Quadro externo limpo tomado por eco
+    uint32_t external_tagged;       // Quadro externo limpo marcado como sobreposto
+    uint32_t collided;
+    uint32_t collided_tagged;
+    uint32_t rx_overflow;
+} echo_result_t;
+
+static PIO pio;
+static int tx_sm;
+static int rx_sm;
+
+// Ar: quadros em voo (anel, os mais antigos servem para detectar colisão)
+static air_frame_t air[MAX_AIR];
+static uint32_t air_count;
+static uint64_t tx_busy_until;
+
+// Quadros externos agendados
+static air_frame_t pending[MAX_PENDING];
+static uint32_t pending_count;
+
+// Origem de cada palavra no FIFO RX, na mesma ordem
+static origin_t truth[MAX_AIR];
+static uint32_t truth_head;
+static uint32_t truth_count;
+
+static echo_result_t result;
+
+static void air_add(uint64_t start_us, uint32_t frame, bool self) {
+    air[air_count % MAX_AIR] = (air_frame_t){start_us, start_us + IR_ECHO_NEC_FRAME_US, frame, self, false};
+    air_count++;
+}
+
+static void schedule_external(uint64_t start_us, uint32_t frame) {
+    if (pending_count < MAX_PENDING) {
+        pending[pending_count++] = (air_frame_t){start_us, 0, frame, false, false};
+        result.external_sent++;
+    }
+}
+
+// Entrega no FIFO RX o quadro com o fim mais cedo, se já chegou até to_us
+static bool deliver_next(uint64_t to_us) {
+    uint32_t first = air_count > MAX_AIR ? air_count - MAX_AIR : 0;
+    air_frame_t *next = NULL;
+    for (uint32_t i = first; i < air_count; i++) {
+        air_frame_t *a = &air[i % MAX_AIR];
+        if (!a->delivered && a->end_us + RX_LATENCY_US <= to_us && (!next || a->end_us < next->end_us)) {
+            next = a;
+        }
+    }
+    if (!next) {
+        return false;
+    }
+    next->delivered = true;
+
+    uint32_t frame = next->frame;
+    origin_t origin = next->self ? ORIGIN_SELF : ORIGIN_EXTERNAL;
+    for (uint32_t i = first; i < air_count; i++) {
+        air_frame_t *a = &air[i % MAX_AIR];
+        if (a != next && a->self != next->self && a->start_us < next->end_us && next->start_us < a->end_us) {
+            frame |= a->frame;
+            origin = ORIGIN_COLLIDED;
+        }
+    }
+
+    if (!host_pio_rx_push(pio, rx_sm, frame)) {
+        result.rx_overflow++;
+        return true;
+    }
+    truth[(truth_head + truth_count) % MAX_AIR] = origin;
+    truth_count++;
+    return true;
+}
+
+/**
+ * Laço de retorno: a state machine TX consome o FIFO quando termina o quadro
+ * anterior; o receptor entrega tudo o que terminou
+ */
+static void loopback_ticker(uint64_t from_us, uint64_t to_us) {
+    uint32_t frame;
+    while (tx_busy_until <= to_us && host_pio_tx_pop(pio, tx_sm, &frame)) {
+        uint64_t start = tx_busy_until > from_us ? tx_busy_until : from_us;
+        air_add(start, frame, true);
+        tx_busy_until = start + IR_ECHO_NEC_FRAME_US;
+    }
+    for (uint32_t i = 0; i < pending_count;) {
+        if (pending[i].start_us < to_us) {
+            air_add(pending[i].start_us, pending[i].frame, false);
+            pending[i] = pending[--pending_count];
+        } else {
+            i++;
+        }
+    }
+    while (deliver_next(to_us)) {
+    }
+}
+
+static void run_loopback(bool suppress, uint64_t duration_us, echo_result_t *out) {
+    uint32_t seed = 0xEC40EC40u;
+    ir_echo_t echo;
+
+    host_sdk_reset();
+    pio = pio0;
+    tx_sm = nec_tx_init(pio, TX_PIN);
+    rx_sm = nec_rx_init(pio, RX_PIN);
+    ir_echo_init(&echo, 0);
+    host_sdk_set_ticker(loopback_ticker);
+    air_count = pending_count = truth_head = truth_count = 0;
+    tx_busy_until = 0;
+    result = (echo_result_t){0};
+
+    uint64_t next_send = 200000;
+    uint64_t next_external = 500000;
+    uint32_t last_frame = 0;
+
+    while (time_us_64() < duration_us) {
+        uint64_t now = time_us_64();
+
+        // Envios a cada 0,15-1,2 s; um em cada cinco em dobro (fila do PIO)
+        if (now >= next_send) {
+            uint32_t r = bench_rand(&seed);
+            int copies = r % 5 == 0 ? 2 : 1;
+            last_frame = nec_encode_frame((uint8_t)(r >> 8), (uint8_t)(r >> 16));
+            for (int i = 0; i < copies; i++) {
+                pio_sm_put(pio, tx_sm, last_frame);
+                if (suppress) {
+                    ir_echo_publish(&echo, now, IR_ECHO_NEC_FRAME_US, last_frame);
+                }
+                result.sent++;
+            }
+            // Controle real repetindo o mesmo botão logo depois do envio
+            if (r % 4 == 1) {
+                uint64_t tx_end = (tx_busy_until > now ? tx_busy_until : now) +
+                                  (uint64_t)copies * IR_ECHO_NEC_FRAME_US;
+                schedule_external(tx_end + 30000 + bench_rand(&seed) % 200000, last_frame);
+            }
+            next_send = now + 150000 + bench_rand(&seed) % 1050000;
+        }
+
+        // Controle externo independente, a cada 0,5-3 s
+        if (now >= next_external) {
+            uint32_t r = bench_rand(&seed);
+            schedule_external(now, nec_encode_frame((uint8_t)r, (uint8_t)(r >> 8)));
+            next_external = now + 500000 + bench_rand(&seed) % 2500000;
+        }
+
+        while (!pio_sm_is_rx_fifo_empty(pio, rx_sm)) {
+            uint32_t rx_frame = pio_sm_get(pio, rx_sm);
+            origin_t origin = truth[truth_head];
+            truth_head = (truth_head + 1) % MAX_AIR;
+            truth_count--;
+
+            uint64_t rx_end = time_us_64();
+            ir_echo_result_t r = suppress ? ir_echo_classify(&echo, rx_end - IR_ECHO_NEC_FRAME_US, rx_end, rx_frame)
+                                          : IR_ECHO_EXTERNAL;
+            switch (origin) {
+                case ORIGIN_SELF:
+                    if (r == IR_ECHO_SELF) {
+                        result.self_suppressed++;
+                    } else {
+                        result.self_leaked++;
+                    }
+                    break;
+                case ORIGIN_EXTERNAL:
+                    result.external_accepted += r == IR_ECHO_EXTERNAL;
+                    result.external_dropped += r == IR_ECHO_SELF;
+                    result.external_tagged += r == IR_ECHO_OVERLAP;
+                    break;
+                case ORIGIN_COLLIDED:
+                    result.collided++;
+                    result.collided_tagged += r != IR_ECHO_EXTERNAL;
+                    break;
+            }
+        }
+
+        sleep_us(LOOP_TICK_US);
+    }
+
+    host_sdk_set_ticker(NULL);
+    *out = result;
+}
+
+// ---------------------------------------------------------------------------
+// Custo da classificação
+// ---------------------------------------------------------------------------
+
+static ir_echo_t bench_echo;
+
+static void run_classify(void *ctx) {
+    uint32_t acc = 0;
+    ir_echo_init(&bench_echo, 0);
+    for (uint32_t i = 0; i < 1000; i++) {
+        // Histórico sempre cheio: publica um envio e classifica o eco e um externo
+        uint64_t t = (uint64_t)i * 100000;
+        uint32_t frame = nec_encode_frame((uint8_t)i, (uint8_t)(i >> 3));
+        ir_echo_publish(&bench_echo, t, IR_ECHO_NEC_FRAME_US, frame);
+        acc += ir_echo_classify(&bench_echo, t, t + IR_ECHO_NEC_FRAME_US + 1000, frame);
+        acc += ir_echo_classify(&bench_echo, t + 95000, t + 95000 + IR_ECHO_NEC_FRAME_US, ~frame);
+    }
+    bench_sink = acc;
+}
+
+void bench_suite_echo(void) {
+    uint64_t duration_us = bench_quick ? 60000000ull : 600000000ull;
+    echo_result_t naive;
+    echo_result_t suppressed;
+
+    run_loopback(false, duration_us, &naive);
+    run_loopback(true, duration_us, &suppressed);
+
+    bench_report("echo.sent", suppressed.sent, "count", BENCH_HIGHER_IS_BETTER);
+    bench_report("echo.naive_self_leaked", naive.self_leaked, "count", BENCH_LOWER_IS_BETTER);
+    bench_report("echo.self_leaked", suppressed.self_leaked, "count", BENCH_LOWER_IS_BETTER);
+    bench_report("echo.self_suppressed", suppressed.self_suppressed, "count", BENCH_HIGHER_IS_BETTER);
+    bench_report("echo.external_sent", suppressed.external_sent, "count", BENCH_HIGHER_IS_BETTER);
+    bench_report("echo.external_accepted", suppressed.external_accepted, "count", BENCH_HIGHER_IS_BETTER);
+    bench_report("echo.external_dropped", suppressed.external_dropped, "count", BENCH_LOWER_IS_BETTER);
+    bench_report("echo.external_tagged", suppressed.external_tagged, "count", BENCH_LOWER_IS_BETTER);
+    bench_report("echo.collided", suppressed.collided, "count", BENCH_LOWER_IS_BETTER);
+    bench_report("echo.collided_tagged", suppressed.collided_tagged, "count", BENCH_HIGHER_IS_BETTER);
+    bench_report("echo.rx_overflow", suppressed.rx_overflow, "count", BENCH_LOWER_IS_BETTER);
+
+    bench_time("echo.publish_and_classify", run_classify, NULL, 1000);
+}
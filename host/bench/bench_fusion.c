@@ -0,0 +1,275 @@
+/**
+ * bench_fusion.c - Fusão de vários sensores IR (ir_fusion.c)
+ *
+ * Gera fluxos sintéticos para três sensores a partir das capturas de
+ * custom_ir.c: cada comando chega a cada sensor com um atraso e ruído de
+ * borda próprios, e cada sensor tem seus defeitos (perde comandos, perde o
+ * cabeçalho, vê glitches). As bordas entram pela interrupção de GPIO
+ * simulada e o laço chama ir_fusion_poll() a cada 1 ms.
+ *
+ * Mede se cada comando vira exatamente um evento, com a máscara de sensores
+ * certa, se a melhor cópia confere com a captura original mais vezes que a
+ * de qualquer sensor sozinho, se a saúde de cada sensor reflete a taxa de
+ * perda configurada e o custo de CPU por evento.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "bench.h"
+#include "pico/stdlib.h"
+#include "hardware/timer.h"
+#include "host_sdk.h"
+#include "custom_ir.h"
+#include "ir_scene.h"
+#include "ir_fusion.h"
+
+#define SENSORS 3
+#define MAX_EDGES 4096
+#define POLL_US 1000
+
+typedef struct {
+    uint32_t miss_pct;              // Comandos que o sensor não vê
+    uint32_t leader_loss_pct;       // Comandos vistos sem o cabeçalho
+    uint32_t glitch_pct;            // Marcas partidas por um glitch
+    uint32_t offset_max_us;         // Atraso do sensor em relação ao ar
+} sensor_model_t;
+
+static const sensor_model_t models[SENSORS] = {
+    {5, 0, 0, 100},                 // Frente do aparelho
+    {15, 20, 0, 300},               // Lateral: às vezes só pega o fim do cabeçalho
+    {40, 0, 3, 200},                // Atrás do sofá, com reflexos
+};
+
+static const uint8_t pins[SENSORS] = {10, 11, 12};
+
+typedef struct {
+    uint64_t time_us;
+    uint8_t sensor;
+    bool level;
+} edge_t;
+
+typedef struct {
+    uint64_t start_us;
+    int signal;
+    uint8_t mask;                   // Sensores que receberam
+    bool matched;                   // Já associado a um evento
+} truth_t;
+
+static edge_t edges[MAX_EDGES];
+static size_t edge_count;
+static ir_fusion_t fusion;
+static truth_t *truth;
+static size_t truth_count;
+static size_t truth_next;           // Primeiro comando ainda sem evento possível
+
+// Resultado
+static uint32_t emitted;
+static uint32_t duplicates;
+static uint32_t spurious;
+static uint32_t mask_ok;
+static uint32_t best_ok;
+static double cpu_ns;
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static int compare_edges(const void *a, const void *b) {
+    const edge_t *x = a;
+    const edge_t *y = b;
+    return (x->time_us > y->time_us) - (x->time_us < y->time_us);
+}
+
+static void add_edge(uint64_t time_us, uint8_t sensor, bool level) {
+    if (edge_count < MAX_EDGES) {
+        edges[edge_count++] = (edge_t){time_us, sensor, level};
+    }
+}
+
+/**
+ * Bordas de um comando visto por um sensor (saída ativa em nível baixo)
+ */
+static void sensor_edges(uint8_t sensor, const ir_raw_signal_t *s, uint64_t start_us, uint32_t *seed) {
+    const sensor_model_t *m = &models[sensor];
+    uint64_t t = start_us + bench_rand(seed) % (m->offset_max_us + 1);
+    size_t first = 0;
+
+    if (bench_rand(seed) % 100 < m->leader_loss_pct) {
+        t += s->data[0] + s->data[1];
+        first = 2;
+    }
+    for (size_t i = first; i < s->length; i++) {
+        bool mark = i % 2 == 0;
+        int32_t jitter = (int32_t)(bench_rand(seed) % 31) - 15;
+        add_edge(t + (i == first ? 0 : jitter), sensor, !mark);
+        if (mark && s->data[i] > 200 && bench_rand(seed) % 100 < m->glitch_pct) {
+            uint64_t mid = t + s->data[i] / 2;
+            add_edge(mid, sensor, true);
+            add_edge(mid + 40, sensor, false);
+        }
+        t += s->data[i];
+    }
+    if (s->length % 2 == 1) {
+        add_edge(t, sensor, true);
+    }
+}
+
+static void drain_events(void) {
+    const ir_fusion_event_t *ev;
+    while ((ev = ir_fusion_peek(&fusion)) != NULL) {
+        emitted++;
+
+        // Comando mais próximo do início do evento
+        truth_t *best = NULL;
+        uint64_t best_diff = UINT64_MAX;
+        for (size_t i = truth_next; i < truth_count && truth[i].start_us < ev->start_us + IR_FUSION_WINDOW_US; i++) {
+            uint64_t d = truth[i].start_us > ev->start_us ? truth[i].start_us - ev->start_us
+                                                         : ev->start_us - truth[i].start_us;
+            if (d < best_diff) {
+                best_diff = d;
+                best = &truth[i];
+            }
+        }
+        if (!best || best_diff > IR_FUSION_WINDOW_US) {
+            spurious++;
+        } else if (best->matched) {
+            duplicates++;
+        } else {
+            best->matched = true;
+            mask_ok += ev->sensors == best->mask;
+            best_ok += ir_scene_match_capture(ev->raw, ev->count) == best->signal;
+        }
+        ir_fusion_release(&fusion);
+    }
+}
+
+static uint64_t next_poll_us;
+
+static void advance_polling(uint64_t target_us) {
+    while (next_poll_us <= target_us) {
+        host_time_advance_to(next_poll_us);
+        double t0 = now_ns();
+        ir_fusion_poll(&fusion, time_us_64());
+        cpu_ns += now_ns() - t0;
+        drain_events();
+        next_poll_us += POLL_US;
+    }
+    host_time_advance_to(target_us);
+}
+
+void bench_suite_fusion(void) {
+    uint32_t seed = 0xF0510Au;
+    size_t commands = bench_quick ? 300 : 2000;
+    const ir_named_signal_t *signals;
+    size_t signal_count = get_captured_signals(&signals);
+
+    // Só capturas que o saneamento mantém reconhecíveis como elas mesmas
+    int usable[16];
+    size_t usable_count = 0;
+    static uint16_t clean[1024];
+    for (size_t i = 0; i < signal_count && usable_count < count_of(usable); i++) {
+        ir_sanitizer_t z;
+        ir_sanitizer_init(&z, IR_FUSION_GLITCH_US);
+        size_t n = ir_sanitize(signals[i].signal.data, signals[i].signal.length, clean, &z);
+        if (ir_scene_match_capture(clean, n) == (int)i) {
+            usable[usable_count++] = (int)i;
+        }
+    }
+
+    truth = calloc(commands, sizeof(truth_t));
+    truth_count = commands;
+    truth_next = 0;
+    emitted = duplicates = spurious = mask_ok = best_ok = 0;
+    cpu_ns = 0;
+
+    host_sdk_reset();
+    ir_fusion_init(&fusion, pins, SENSORS);
+    ir_fusion_attach_gpio(&fusion);
+    for (uint8_t i = 0; i < SENSORS; i++) {
+        host_gpio_drive(pins[i], true);
+    }
+    next_poll_us = POLL_US;
+
+    // Cópias de cada sensor que conferem com a captura (comparação com um sensor sozinho)
+    uint32_t sensor_ok[SENSORS] = {0};
+    uint32_t seen_any = 0;
+    static uint16_t copy[1024];
+
+    uint64_t t = 100000;
+    for (size_t c = 0; c < commands; c++) {
+        int sig = usable[bench_rand(&seed) % usable_count];
+        const ir_raw_signal_t *s = &signals[sig].signal;
+        truth[c] = (truth_t){t, sig, 0, false};
+
+        edge_count = 0;
+        for (uint8_t k = 0; k < SENSORS; k++) {
+            if (bench_rand(&seed) % 100 < models[k].miss_pct) {
+                continue;
+            }
+            size_t before = edge_count;
+            sensor_edges(k, s, t, &seed);
+            truth[c].mask |= 1u << k;
+
+            // Como o sensor sozinho veria (mesmo saneamento da fusão)
+            size_t n = 0;
+            for (size_t e = before + 1; e < edge_count && n < count_of(copy); e++) {
+                copy[n++] = (uint16_t)(edges[e].time_us - edges[e - 1].time_us);
+            }
+            ir_sanitizer_t z;
+            ir_sanitizer_init(&z, IR_FUSION_GLITCH_US);
+            n = ir_sanitize(copy, n, copy, &z);
+            sensor_ok[k] += ir_scene_match_capture(copy, n) == sig;
+        }
+        seen_any += truth[c].mask != 0;
+
+        qsort(edges, edge_count, sizeof(edge_t), compare_edges);
+        for (size_t e = 0; e < edge_count; e++) {
+            advance_polling(edges[e].time_us);
+            double t0 = now_ns();
+            host_gpio_drive(pins[edges[e].sensor], edges[e].level);
+            cpu_ns += now_ns() - t0;
+        }
+
+        t += 150000 + bench_rand(&seed) % 550000;
+        if (c > 0) {
+            truth_next = c - 1;
+        }
+    }
+    advance_polling(t);
+
+    uint32_t matched = 0;
+    for (size_t c = 0; c < commands; c++) {
+        matched += truth[c].matched;
+    }
+
+    bench_report("fusion.commands_seen", seen_any, "count", BENCH_HIGHER_IS_BETTER);
+    bench_report("fusion.events", emitted, "count", BENCH_HIGHER_IS_BETTER);
+    bench_report("fusion.events_matched", matched, "count", BENCH_HIGHER_IS_BETTER);
+    bench_report("fusion.duplicates", duplicates, "count", BENCH_LOWER_IS_BETTER);
+    bench_report("fusion.spurious", spurious, "count", BENCH_LOWER_IS_BETTER);
+    bench_report("fusion.sensor_mask_ok", mask_ok, "count", BENCH_HIGHER_IS_BETTER);
+    bench_report("fusion.best_copy_ok", best_ok, "count", BENCH_HIGHER_IS_BETTER);
+    bench_report("fusion.event_drops", fusion.event_drops, "count", BENCH_LOWER_IS_BETTER);
+
+    char name[64];
+    for (uint8_t k = 0; k < SENSORS; k++) {
+        snprintf(name, sizeof(name), "fusion.sensor%u_copy_ok", k);
+        bench_report(name, sensor_ok[k], "count", BENCH_HIGHER_IS_BETTER);
+        snprintf(name, sizeof(name), "fusion.sensor%u_health_pct", k);
+        bench_report(name, ir_fusion_health_pct(&fusion, k), "%", BENCH_HIGHER_IS_BETTER);
+        snprintf(name, sizeof(name), "fusion.sensor%u_busy_drops", k);
+        bench_report(name, fusion.sensors[k].health.busy_drops, "count", BENCH_LOWER_IS_BETTER);
+    }
+
+    bench_report("fusion.cpu_ns_per_event", cpu_ns / commands, "ns", BENCH_LOWER_IS_BETTER);
+
+    free(truth);
+    truth = NULL;
+}
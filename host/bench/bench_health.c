@@ -0,0 +1,300 @@
+/**
+ * bench_health.c - Diagnóstico do sensor IR (ir_health.c + edge_capture)
+ *
+ * Monta traços sintéticos de 10 s da saída do receptor, com resolução de
+ * 1 us: sala quieta, controle NEC pelo canal virtual, sol (pulsos curtos do
+ * AGC do receptor, com e sem controle), lâmpada, sensor travado em nível baixo
+ * e repouso em nível baixo. Para cada traço registra:
+ *
+ *  - o diagnóstico de ir_health.c sobre os trechos exatos, conferido com o
+ *    esperado;
+ *  - quantas bordas o teste antigo (gpio_get a cada 1 ms) veria.
+ *
+ * Depois toca um trecho do traço de controle com sol no pino de um
+ * edge_capture.pio executado pelo shim, com o DMA, e compara as medidas do
+ * PIO com os trechos do traço.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <string.h>
+
+#include "bench.h"
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+#include "host_sdk.h"
+#include "nec_transmit.h"
+#include "ir_channel.h"
+#include "ir_health.h"
+#include "edge_capture.h"
+
+#define WINDOW_US 10000000u
+#define POLL_US 1000                    // sleep_ms(1) do teste antigo
+#define SENSOR_PIN 17
+#define PIO_WINDOW_US 1500000u
+#define MAX_SEGMENTS 65536
+
+typedef enum {
+    TRACE_QUIET,
+    TRACE_REMOTE,
+    TRACE_SUN,
+    TRACE_SUN_REMOTE,
+    TRACE_LAMP,
+    TRACE_STUCK_LOW,
+    TRACE_IDLE_LOW,
+    TRACE_COUNT
+} trace_kind_t;
+
+typedef struct {
+    const char *name;
+    uint16_t remote_presses;            // Teclas (rajadas de quadros NEC)
+    uint16_t noise_per_s;               // Pulsos espúrios por segundo
+    uint16_t noise_min_us;
+    uint16_t noise_max_us;
+    bool stuck_low;                     // Trava em nível baixo na metade da janela
+    bool idle_low;                      // Repouso em nível baixo, picos altos
+    ir_health_status_t expected;
+} trace_t;
+
+static const trace_t traces[TRACE_COUNT] = {
+    [TRACE_QUIET] = {"quiet", 0, 0, 0, 0, false, false, IR_HEALTH_SILENT},
+    [TRACE_REMOTE] = {"remote", 6, 0, 0, 0, false, false, IR_HEALTH_OK},
+    [TRACE_SUN] = {"sun", 0, 40, 5, 120, false, false, IR_HEALTH_NOISY},
+    [TRACE_SUN_REMOTE] = {"sun_remote", 6, 40, 5, 120, false, false, IR_HEALTH_NOISY},
+    [TRACE_LAMP] = {"lamp", 3, 5, 200, 600, false, false, IR_HEALTH_NOISY},
+    [TRACE_STUCK_LOW] = {"stuck_low", 3, 0, 0, 0, true, false, IR_HEALTH_DEAD},
+    [TRACE_IDLE_LOW] = {"idle_low", 0, 20, 50, 300, false, true, IR_HEALTH_DEAD},
+};
+
+// Traço: um bit por us, 1 = marca (pino em nível baixo)
+static uint8_t line[WINDOW_US / 8];
+
+// Trechos do traço (nível, duração) e o que ficou aberto no fim
+static bool seg_level[MAX_SEGMENTS];
+static uint32_t seg_us[MAX_SEGMENTS];
+static size_t seg_count;
+static bool open_level;
+static uint32_t open_us;
+
+static void mark(uint32_t from_us, uint32_t to_us) {
+    for (uint32_t t = from_us; t < to_us && t < WINDOW_US; t++) {
+        line[t / 8] |= (uint8_t)(1u << (t % 8));
+    }
+}
+
+static bool is_mark(uint32_t t) {
+    return (line[t / 8] >> (t % 8)) & 1;
+}
+
+static void build_trace(const trace_t *trace, uint32_t seed) {
+    memset(line, 0, sizeof(line));
+
+    // Teclas: 1 a 5 quadros NEC a cada 108 ms, pelo modelo de sala sem ruído
+    static const ir_channel_model_t sensor = {.mark_stretch_us = 40, .jitter_us = 15};
+    ir_channel_t channel;
+    ir_channel_init(&channel, &sensor, seed);
+    for (uint32_t k = 0; k < trace->remote_presses; k++) {
+        uint32_t r = bench_rand(&seed);
+        uint32_t t = 200000 + k * (WINDOW_US - 1000000) / trace->remote_presses + r % 300000;
+        uint32_t frames = 1 + (r >> 20) % 5;
+        for (uint32_t f = 0; f < frames; f++, t += 108000) {
+            uint16_t tx[IR_CHANNEL_NEC_TIMINGS];
+            uint16_t rx[IR_CHANNEL_MAX_MARKS * 2];
+            size_t n = ir_channel_nec_waveform(nec_encode_frame((uint8_t)r, (uint8_t)(r >> 8)), tx);
+            n = ir_channel_apply(&channel, tx, n, rx, count_of(rx));
+            uint32_t at = t;
+            for (size_t i = 0; i < n; i++) {
+                if (i % 2 == 0) {
+                    mark(at, at + rx[i]);
+                }
+                at += rx[i];
+            }
+        }
+    }
+
+    // Pulsos espúrios com intervalos exponenciais (aproximados)
+    if (trace->noise_per_s) {
+        uint32_t mean_us = 1000000 / trace->noise_per_s;
+        uint32_t t = bench_rand(&seed) % mean_us;
+        while (t < WINDOW_US) {
+            uint32_t width = trace->noise_min_us + bench_rand(&seed) % (trace->noise_max_us - trace->noise_min_us + 1);
+            mark(t, t + width);
+            uint32_t u = bench_rand(&seed) % 1000 + 1;
+            uint32_t log_u = 0;
+            while (u < 1000) {
+                u *= 2;
+                log_u++;
+            }
+            t += width + mean_us * log_u * 7 / 10 + bench_rand(&seed) % (mean_us / 4 + 1);
+        }
+    }
+
+    if (trace->stuck_low) {
+        mark(WINDOW_US / 2, WINDOW_US);
+    }
+    if (trace->idle_low) {
+        // Inverte: os pulsos viram picos em nível alto
+        for (size_t i = 0; i < sizeof(line); i++) {
+            line[i] = (uint8_t)~line[i];
+        }
+    }
+
+    // Trechos
+    seg_count = 0;
+    uint32_t start = 0;
+    for (uint32_t t = 1; t < WINDOW_US; t++) {
+        if (is_mark(t) != is_mark(t - 1) && seg_count < MAX_SEGMENTS) {
+            seg_level[seg_count] = !is_mark(t - 1);
+            seg_us[seg_count] = t - start;
+            seg_count++;
+            start = t;
+        }
+    }
+    open_level = !is_mark(WINDOW_US - 1);
+    open_us = WINDOW_US - start;
+}
+
+// Bordas que o teste antigo contaria: uma leitura por ms
+static uint32_t poll_edges(void) {
+    uint32_t edges = 0;
+    for (uint32_t t = POLL_US; t < WINDOW_US; t += POLL_US) {
+        edges += is_mark(t) != is_mark(t - POLL_US);
+    }
+    return edges;
+}
+
+static ir_health_report_t analyze(void) {
+    ir_health_t h;
+    ir_health_init(&h);
+    for (size_t i = 0; i < seg_count; i++) {
+        ir_health_push(&h, seg_level[i], seg_us[i]);
+    }
+    ir_health_report_t report;
+    ir_health_report(&h, open_level, open_us, &report);
+    return report;
+}
+
+static void run_push(void *ctx) {
+    ir_health_t *h = ctx;
+    ir_health_init(h);
+    for (size_t i = 0; i < seg_count; i++) {
+        ir_health_push(h, seg_level[i], seg_us[i]);
+    }
+    bench_sink += h->noise_marks;
+}
+
+// Medidas do PIO conferidas com os trechos tocados
+typedef struct {
+    edge_cap_stream_t stream;
+    ir_health_t health;
+    size_t index;                       // Próximo trecho esperado
+    bool skip;                          // A primeira medida é o repouso antes da primeira marca
+    uint32_t error_max_us;
+} pio_check_t;
+
+static pio_check_t check;
+
+static void pio_consume(void) {
+    uint32_t words[64];
+    size_t n;
+    while ((n = edge_cap_stream_read(&check.stream, words, count_of(words))) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            uint32_t duration = edge_cap_duration_us(words[i]);
+            ir_health_push(&check.health, edge_cap_level(words[i]), duration);
+            if (check.skip) {
+                check.skip = false;
+                continue;
+            }
+            uint32_t expected = seg_us[check.index++];
+            uint32_t error = duration > expected ? duration - expected : expected - duration;
+            check.error_max_us = error > check.error_max_us ? error : check.error_max_us;
+        }
+    }
+}
+
+/**
+ * Toca os trechos do início do traço no pino, lendo o anel como o laço do
+ * receptor.c, e compara com as medidas do PIO
+ */
+static void run_pio(uint32_t *missed, uint32_t *error_max_us, ir_health_status_t *status) {
+    host_sdk_reset();
+    host_gpio_drive(SENSOR_PIN, true);
+    int sm = edge_cap_init(pio0, SENSOR_PIN);
+    host_pio_simulate(pio0, (uint)sm, true);
+    edge_cap_stream_init(&check.stream, pio0, (uint)sm);
+    ir_health_init(&check.health);
+
+    // Trechos que cabem na janela, começando pela primeira marca; o último
+    // só é medido na borda seguinte
+    size_t first = seg_level[0] ? 1 : 0;
+    size_t last = first;
+    check.index = first;
+    check.skip = true;
+    check.error_max_us = 0;
+    uint64_t t = 20000;
+    host_time_advance_to(t);
+    while (last < seg_count && t + seg_us[last] < PIO_WINDOW_US) {
+        host_gpio_drive(SENSOR_PIN, seg_level[last]);
+        t += seg_us[last];
+        host_time_advance_to(t);
+        last++;
+        pio_consume();
+    }
+    host_gpio_drive(SENSOR_PIN, !seg_level[last - 1]);
+    host_time_advance_us(1000);
+    pio_consume();
+
+    *missed = (uint32_t)(last - check.index) + check.stream.overflows;
+    *error_max_us = check.error_max_us;
+    ir_health_report_t report;
+    ir_health_report(&check.health, gpio_get(SENSOR_PIN), 1000, &report);
+    *status = report.status;
+}
+
+void bench_suite_health(void) {
+    uint32_t correct = 0;
+    uint32_t remote_edges = 0;
+    uint32_t remote_poll_edges = 0;
+    ir_health_report_t remote = {0};
+    ir_health_report_t quiet = {0};
+    ir_health_report_t sun = {0};
+
+    for (int kind = 0; kind < TRACE_COUNT; kind++) {
+        build_trace(&traces[kind], 0x4EA17000u + (uint32_t)kind);
+        ir_health_report_t report = analyze();
+        correct += report.status == traces[kind].expected;
+        if (kind == TRACE_REMOTE) {
+            remote = report;
+            remote_edges = (uint32_t)seg_count;
+            remote_poll_edges = poll_edges();
+        } else if (kind == TRACE_QUIET) {
+            quiet = report;
+        } else if (kind == TRACE_SUN) {
+            sun = report;
+        }
+    }
+
+    bench_report("health.traces", TRACE_COUNT, "count", BENCH_HIGHER_IS_BETTER);
+    bench_report("health.traces_correct", correct, "count", BENCH_HIGHER_IS_BETTER);
+    bench_report("health.poll_edges_seen_pct", 100.0 * remote_poll_edges / remote_edges, "%",
+                 BENCH_HIGHER_IS_BETTER);
+    bench_report("health.remote_noise_per_min", remote.noise_per_min, "count", BENCH_LOWER_IS_BETTER);
+    bench_report("health.remote_signal_bursts", remote.signal_bursts, "count", BENCH_HIGHER_IS_BETTER);
+    bench_report("health.quiet_noise_per_min", quiet.noise_per_min, "count", BENCH_LOWER_IS_BETTER);
+    bench_report("health.sun_noise_per_min", sun.noise_per_min, "count", BENCH_HIGHER_IS_BETTER);
+
+    // PIO + DMA sobre o traço de controle com sol
+    build_trace(&traces[TRACE_SUN_REMOTE], 0x4EA17000u + TRACE_SUN_REMOTE);
+    uint32_t missed;
+    uint32_t error_max_us;
+    ir_health_status_t status;
+    run_pio(&missed, &error_max_us, &status);
+    bench_report("health.pio_segments_missed", missed, "count", BENCH_LOWER_IS_BETTER);
+    bench_report("health.pio_duration_error_max_us", error_max_us, "us", BENCH_LOWER_IS_BETTER);
+    bench_report("health.pio_status_correct", status == IR_HEALTH_NOISY, "bool", BENCH_HIGHER_IS_BETTER);
+
+    // Custo da análise por borda
+    static ir_health_t h;
+    bench_time("health.push", run_push, &h, seg_count);
+}
@@ -0,0 +1,107 @@
+/**
+ * bench_log.c - Log binário adiado (ir_log.c)
+ *
+ * Compara o custo por mensagem de IR_LOG (o que fica no callback) com
+ * snprintf e com fprintf para /dev/null. No host o fprintf só formata e
+ * copia para o buffer do FILE; no Pico o printf ainda espera a USB CDC, então
+ * a diferença real nas interrupções é maior. Também mede o flush por entrada
+ * e a contagem de perdas numa rajada maior que o anel.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "bench.h"
+#include "pico/stdlib.h"
+#include "ir_log.h"
+
+#define BATCH IR_LOG_ENTRIES
+#define BURST 200
+
+static const char FMT[] = "Tempo %d: %dus (%s->%s)\n";
+
+static FILE *null_file;
+static size_t output_bytes;
+static size_t output_calls;
+
+static void null_output(const char *text, size_t length) {
+    output_bytes += length;
+    output_calls++;
+}
+
+static void run_log(void *ctx) {
+    for (uint32_t i = 0; i < BATCH; i++) {
+        IR_LOG_INFO(FMT, i, 560 + i, "HIGH", "LOW");
+    }
+    ir_log.tail = ir_log.head;      // Descarta sem formatar
+}
+
+static void run_snprintf(void *ctx) {
+    char line[IR_LOG_LINE_LEN];
+    for (uint32_t i = 0; i < BATCH; i++) {
+        bench_sink += snprintf(line, sizeof(line), FMT, i, 560 + i, "HIGH", "LOW");
+    }
+}
+
+static void run_fprintf(void *ctx) {
+    for (uint32_t i = 0; i < BATCH; i++) {
+        bench_sink += fprintf(null_file, FMT, i, 560 + i, "HIGH", "LOW");
+    }
+}
+
+static void run_log_flush(void *ctx) {
+    for (uint32_t i = 0; i < BATCH; i++) {
+        IR_LOG_INFO(FMT, i, 560 + i, "HIGH", "LOW");
+    }
+    bench_sink += ir_log_flush(0);
+}
+
+static void run_filtered(void *ctx) {
+    for (uint32_t i = 0; i < BATCH; i++) {
+        IR_LOG_DEBUG(FMT, i, 560 + i, "HIGH", "LOW");
+    }
+}
+
+void bench_suite_log(void) {
+    null_file = fopen("/dev/null", "w");
+
+    ir_log_init(IR_LOG_LEVEL_INFO);
+    ir_log_set_output(null_output);
+    bench_time("log.write", run_log, NULL, BATCH);
+    bench_time("log.write_filtered", run_filtered, NULL, BATCH);
+    bench_time("log.snprintf", run_snprintf, NULL, BATCH);
+    if (null_file) {
+        bench_time("log.fprintf", run_fprintf, NULL, BATCH);
+    }
+    bench_time("log.write_and_flush", run_log_flush, NULL, BATCH);
+
+    // Rajada sem flush (ex: sinal longo com o laço ocupado)
+    ir_log_init(IR_LOG_LEVEL_INFO);
+    ir_log_set_output(null_output);
+    for (uint32_t i = 0; i < BURST; i++) {
+        IR_LOG_INFO(FMT, i, 560 + i, "HIGH", "LOW");
+    }
+    output_calls = 0;
+    size_t flushed = ir_log_flush(0);
+    bench_report("log.burst_flushed", flushed, "count", BENCH_HIGHER_IS_BETTER);
+    bench_report("log.burst_dropped", ir_log.dropped, "count", BENCH_LOWER_IS_BETTER);
+    bench_report("log.burst_drop_notices", output_calls - flushed, "count", BENCH_HIGHER_IS_BETTER);
+
+    // Texto copiado: o buffer de origem muda antes do flush
+    char line[32] = "send KEY_POWER";
+    char out[IR_LOG_LINE_LEN];
+    IR_LOG_TEXT(IR_LOG_LEVEL_INFO, "'%s' %d\n", line, 14);
+    strcpy(line, "xxxxxxxxxxxxxxxxxxxx");
+    ir_log_entry_t *e = &ir_log.ring[ir_log.tail % IR_LOG_ENTRIES];
+    snprintf(out, sizeof(out), e->fmt, e->text, e->args[1]);
+    bench_report("log.text_copy_ok", strcmp(out, "'send KEY_POWER' 14\n") == 0, "bool", BENCH_HIGHER_IS_BETTER);
+    ir_log_flush(0);
+
+    if (null_file) {
+        fclose(null_file);
+    }
+    ir_log_init(IR_LOG_LEVEL_INFO);
+}
@@ -0,0 +1,328 @@
+/**
+ * bench_main.c - Executa as suítes, gera o JSON e compara com um baseline
+ *
+ * Uso: ir_bench [--quick] [--filter <suite>] [--json <arquivo>]
+ *               [--compare <baseline.json>] [--tolerance <fração>]
+ *
+ * O --compare só aceita um baseline gerado no mesmo modo (com ou sem
+ * --quick): as contagens que dependem da carga (quadros enviados, eventos,
+ * comandos suprimidos) mudam com o tamanho da execução e apareceriam como
+ * regressões.
+ *
+ * Uma verificação que falha (bench_check()) faz o ir_bench terminar com
+ * código 1, com ou sem --compare.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bench.h"
+#include "host_sdk.h"
+
+#define MAX_RESULTS 512
+#define NAME_LEN 96
+#define UNIT_LEN 16
+
+typedef struct {
+    char name[NAME_LEN];
+    double value;
+    char unit[UNIT_LEN];
+    bench_better_t better;
+} bench_result_t;
+
+typedef struct {
+    const char *name;
+    void (*run)(void);
+} bench_suite_t;
+
+// Tabela de suítes
+static const bench_suite_t suites[] = {
+    {"nec", bench_suite_nec},
+    {"raw", bench_suite_raw},
+    {"app", bench_suite_app},
+    {"philco", bench_suite_philco},
+    {"sanitize", bench_suite_sanitize},
+    {"ac", bench_suite_ac},
+    {"sched", bench_suite_sched},
+    {"scene", bench_suite_scene},
+    {"log", bench_suite_log},
+    {"echo", bench_suite_echo},
+    {"fusion", bench_suite_fusion},
+    {"txcheck", bench_suite_txcheck},
+    {"verify", bench_suite_verify},
+    {"channel", bench_suite_channel},
+    {"protocol", bench_suite_protocol},
+    {"siglib", bench_suite_siglib},
+    {"analyze", bench_suite_analyze},
+    {"capfile", bench_suite_capfile},
+    {"boot", bench_suite_boot},
+    {"pdrx", bench_suite_pdrx},
+    {"pdtx", bench_suite_pdtx},
+    {"slottx", bench_suite_slottx},
+    {"necrx", bench_suite_necrx},
+    {"health", bench_suite_health},
+    {"codedb", bench_suite_codedb},
+    {"calib", bench_suite_calib},
+};
+
+volatile uint32_t bench_sink;
+bool bench_quick;
+
+static bench_result_t results[MAX_RESULTS];
+static size_t result_count;
+static int failed_checks;
+
+void bench_report(const char *name, double value, const char *unit, bench_better_t better) {
+    if (result_count >= MAX_RESULTS) {
+        fprintf(stderr, "bench: too many results\n");
+        exit(2);
+    }
+    bench_result_t *r = &results[result_count++];
+    snprintf(r->name, NAME_LEN, "%s", name);
+    snprintf(r->unit, UNIT_LEN, "%s", unit);
+    r->value = value;
+    r->better = better;
+    fprintf(stderr, "  %-44s %14.3f %s\n", name, value, unit);
+}
+
+void bench_check(const char *name, bool ok) {
+    if (!ok) {
+        failed_checks++;
+    }
+    fprintf(stderr, "  %-44s %14s\n", name, ok ? "ok" : "FALHOU");
+}
+
+// ---------------------------------------------------------------------------
+// Medição
+// ---------------------------------------------------------------------------
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static int compare_double(const void *a, const void *b) {
+    double da = *(const double *)a;
+    double db = *(const double *)b;
+    return (da > db) - (da < db);
+}
+
+double bench_ns_per_op(bench_fn_t fn, void *ctx, uint64_t ops_per_call) {
+    const double target_ns = bench_quick ? 2e6 : 40e6;
+
+    // Aquece e calibra quantas chamadas cabem em uma amostra
+    double t0 = now_ns();
+    fn(ctx);
+    double single = now_ns() - t0;
+    uint64_t calls = single > 0 ? (uint64_t)(target_ns / single) : 1000;
+    if (calls < 1) {
+        calls = 1;
+    }
+
+    double samples[5];
+    for (int s = 0; s < 5; s++) {
+        t0 = now_ns();
+        for (uint64_t i = 0; i < calls; i++) {
+            fn(ctx);
+        }
+        samples[s] = (now_ns() - t0) / ((double)calls * (double)ops_per_call);
+    }
+    qsort(samples, 5, sizeof(double), compare_double);
+    return samples[2];
+}
+
+void bench_time(const char *name, bench_fn_t fn, void *ctx, uint64_t ops_per_call) {
+    bench_report(name, bench_ns_per_op(fn, ctx, ops_per_call), "ns/op", BENCH_LOWER_IS_BETTER);
+}
+
+// ---------------------------------------------------------------------------
+// JSON
+// ---------------------------------------------------------------------------
+
+static int compare_result(const void *a, const void *b) {
+    return strcmp(((const bench_result_t *)a)->name, ((const bench_result_t *)b)->name);
+}
+
+// Uma entrada por linha, para facilitar diff e a leitura no --compare
+static void write_json(FILE *out) {
+    fprintf(out, "{\n  \"schema\": 1,\n  \"quick\": %s,\n  \"results\": [\n", bench_quick ? "true" : "false");
+    for (size_t i = 0; i < result_count; i++) {
+        const bench_result_t *r = &results[i];
+        fprintf(out, "    {\"name\": \"%s\", \"value\": %.6g, \"unit\": \"%s\", \"better\": \"%s\"}%s\n", r->name,
+                r->value, r->unit, r->better == BENCH_LOWER_IS_BETTER ? "lower" : "higher",
+                i + 1 < result_count ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+}
+
+// Modo em que o baseline foi gerado (sem o campo: execução completa)
+static bool read_json_quick(const char *path) {
+    FILE *in = fopen(path, "r");
+    if (!in) {
+        perror(path);
+        exit(2);
+    }
+    char line[512];
+    bool quick = false;
+    while (fgets(line, sizeof(line), in)) {
+        char value[8];
+        if (sscanf(line, " \"quick\": %7[a-z]", value) == 1) {
+            quick = strcmp(value, "true") == 0;
+            break;
+        }
+    }
+    fclose(in);
+    return quick;
+}
+
+static size_t read_json(const char *path, bench_result_t *out, size_t max) {
+    FILE *in = fopen(path, "r");
+    if (!in) {
+        perror(path);
+        exit(2);
+    }
+    char line[512];
+    size_t n = 0;
+    while (n < max && fgets(line, sizeof(line), in)) {
+        char better[16];
+        bench_result_t *r = &out[n];
+        if (sscanf(line, " {\"name\": \"%95[^\"]\", \"value\": %lf, \"unit\": \"%15[^\"]\", \"better\": \"%15[^\"]\"",
+                   r->name, &r->value, r->unit, better) == 4) {
+            r->better = strcmp(better, "higher") == 0 ? BENCH_HIGHER_IS_BETTER : BENCH_LOWER_IS_BETTER;
+            n++;
+        }
+    }
+    fclose(in);
+    return n;
+}
+
+// Devolve a quantidade de regressões encontradas
+static int compare_with_baseline(const char *path, double tolerance) {
+    static bench_result_t baseline[MAX_RESULTS];
+    size_t count = read_json(path, baseline, MAX_RESULTS);
+    int regressions = 0;
+
+    fprintf(stderr, "\n%-44s %14s %14s %9s  %s\n", "benchmark", "baseline", "atual", "delta", "status");
+    for (size_t i = 0; i < result_count; i++) {
+        const bench_result_t *r = &results[i];
+        const bench_result_t *b = NULL;
+        for (size_t j = 0; j < count; j++) {
+            if (strcmp(baseline[j].name, r->name) == 0) {
+                b = &baseline[j];
+                break;
+            }
+        }
+        if (!b) {
+            fprintf(stderr, "%-44s %14s %14.3f %9s  NOVO\n", r->name, "-", r->value, "-");
+            continue;
+        }
+
+        double delta = b->value != 0 ? (r->value - b->value) / fabs(b->value) : (r->value != 0 ? INFINITY : 0);
+        double worse = r->better == BENCH_LOWER_IS_BETTER ? delta : -delta;
+        const char *status = "ok";
+        if (worse > tolerance) {
+            status = "REGRESSAO";
+            regressions++;
+        } else if (worse < -tolerance) {
+            status = "melhora";
+        }
+        fprintf(stderr, "%-44s %14.3f %14.3f %+8.1f%%  %s\n", r->name, b->value, r->value, delta * 100, status);
+    }
+    for (size_t j = 0; j < count; j++) {
+        bool found = false;
+        for (size_t i = 0; i < result_count && !found; i++) {
+            found = strcmp(baseline[j].name, results[i].name) == 0;
+        }
+        if (!found) {
+            fprintf(stderr, "%-44s %14.3f %14s %9s  AUSENTE\n", baseline[j].name, baseline[j].value, "-", "-");
+        }
+    }
+    fprintf(stderr, "\n%d regressão(ões) acima de %.0f%%\n", regressions, tolerance * 100);
+    return regressions;
+}
+
+// ---------------------------------------------------------------------------
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+            "uso: %s [--quick] [--filter <suite>] [--json <arquivo>]\n"
+            "          [--compare <baseline.json>] [--tolerance <fração>] [--list]\n",
+            argv0);
+}
+
+int main(int argc, char **argv) {
+    const char *json_path = NULL;
+    const char *baseline_path = NULL;
+    const char *filter = NULL;
+    double tolerance = 0.25;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--quick") == 0) {
+            bench_quick = true;
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else if (strcmp(argv[i], "--compare") == 0 && i + 1 < argc) {
+            baseline_path = argv[++i];
+        } else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+            tolerance = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (strcmp(argv[i], "--list") == 0) {
+            for (size_t s = 0; s < sizeof(suites) / sizeof(suites[0]); s++) {
+                printf("%s\n", suites[s].name);
+            }
+            return 0;
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (baseline_path && read_json_quick(baseline_path) != bench_quick) {
+        fprintf(stderr, "%s: baseline gerado %s --quick; rode no mesmo modo para comparar\n", baseline_path,
+                bench_quick ? "sem" : "com");
+        return 2;
+    }
+
+    for (size_t s = 0; s < sizeof(suites) / sizeof(suites[0]); s++) {
+        if (filter && strstr(suites[s].name, filter) == NULL) {
+            continue;
+        }
+        fprintf(stderr, "[%s]\n", suites[s].name);
+        host_sdk_reset();
+        suites[s].run();
+    }
+
+    qsort(results, result_count, sizeof(bench_result_t), compare_result);
+
+    if (json_path) {
+        FILE *out = fopen(json_path, "w");
+        if (!out) {
+            perror(json_path);
+            return 2;
+        }
+        write_json(out);
+        fclose(out);
+    } else {
+        write_json(stdout);
+    }
+
+    int status = 0;
+    if (baseline_path && compare_with_baseline(baseline_path, tolerance) > 0) {
+        status = 1;
+    }
+    if (failed_checks > 0) {
+        fprintf(stderr, "%d verificação(ões) falharam\n", failed_checks);
+        status = 1;
+    }
+    return status;
+}
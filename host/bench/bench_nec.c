@@ -0,0 +1,51 @@
+/**
+ * bench_nec.c - Codificação e validação de quadros NEC
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "bench.h"
+#include "nec_transmit.h"
+#include "nec_receive.h"
+
+#define FRAME_COUNT 4096
+
+static uint32_t valid_frames[FRAME_COUNT];
+static uint32_t noisy_frames[FRAME_COUNT];
+
+// Todos os 65536 pares endereço/dado
+static void run_encode(void *ctx) {
+    (void)ctx;
+    uint32_t acc = 0;
+    for (uint32_t i = 0; i < 65536; i++) {
+        acc ^= nec_encode_frame((uint8_t)i, (uint8_t)(i >> 8));
+    }
+    bench_sink = acc;
+}
+
+static void run_decode(void *ctx) {
+    const uint32_t *frames = ctx;
+    uint32_t acc = 0;
+    uint8_t address, data;
+    for (uint32_t i = 0; i < FRAME_COUNT; i++) {
+        if (nec_decode_frame(frames[i], &address, &data)) {
+            acc += address + data;
+        }
+    }
+    bench_sink = acc;
+}
+
+void bench_suite_nec(void) {
+    uint32_t seed = 0x1234567u;
+    for (uint32_t i = 0; i < FRAME_COUNT; i++) {
+        uint32_t r = bench_rand(&seed);
+        valid_frames[i] = nec_encode_frame((uint8_t)r, (uint8_t)(r >> 8));
+        // Metade dos quadros com um bit trocado (falha na checagem)
+        noisy_frames[i] = valid_frames[i] ^ ((r & 0x10000) ? (1u << (r >> 27)) : 0);
+    }
+
+    bench_time("nec.encode", run_encode, NULL, 65536);
+    bench_time("nec.decode_valid", run_decode, valid_frames, FRAME_COUNT);
+    bench_time("nec.decode_noisy", run_decode, noisy_frames, FRAME_COUNT);
+}
@@ -0,0 +1,242 @@
+/**
+ * bench_necrx.c - Anel de quadros por DMA do nec_receive
+ *
+ * Um produtor simulado entrega quadros NEC no FIFO RX (host_pio_rx_push, como
+ * a state machine faria) em rajadas de tecla segurada, a cada 108 ms, e um
+ * laço principal só olha o receptor entre tarefas lentas (impressão, sleep),
+ * como o Philco.c e o Tranmissor_e_receptor_IR.c:
+ *
+ *  - poll: o laço antigo, esvaziando o FIFO de 8 posições a cada volta;
+ *  - dma: nec_rx_stream_next(), com o DMA esvaziando o FIFO sozinho.
+ *
+ * Registra os quadros perdidos, o erro do instante de cada quadro (o laço
+ * antigo só sabe quando leu) e, com uma parada maior que o anel, o contador
+ * de transbordos e a recuperação. Por fim, toca quadros NEC no pino de um
+ * nec_receive.pio executado pelo shim e confere endereço, dado e instante.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+#include "hardware/dma.h"
+#include "hardware/timer.h"
+#include "host_sdk.h"
+#include "nec_transmit.h"
+#include "nec_receive.h"
+#include "ir_channel.h"
+
+#define RX_PIN 15
+#define FRAME_PERIOD_US 108000
+#define MAX_FRAMES 4096
+
+typedef struct {
+    uint64_t time_us;
+    uint32_t frame;
+} produced_t;
+
+static produced_t produced[MAX_FRAMES];
+static nec_rx_stream_t stream;
+
+/**
+ * Rajadas de 1 a 30 quadros (tecla segurada) separadas por 0,2 a 3 s
+ */
+static size_t make_schedule(uint32_t seed, size_t count) {
+    uint64_t t = 100000;
+    size_t n = 0;
+    while (n < count) {
+        uint32_t r = bench_rand(&seed);
+        uint32_t frame = nec_encode_frame((uint8_t)r, (uint8_t)(r >> 8));
+        uint32_t burst = 1 + (r >> 16) % 30;
+        for (uint32_t i = 0; i < burst && n < count; i++) {
+            produced[n].time_us = t;
+            produced[n].frame = frame;
+            n++;
+            t += FRAME_PERIOD_US;
+        }
+        t += 200000 + bench_rand(&seed) % 2800000;
+    }
+    return n;
+}
+
+typedef struct {
+    uint32_t received;
+    uint32_t lost;
+    uint64_t stamp_error_sum_us;
+    uint32_t stamp_error_max_us;
+} run_result_t;
+
+/**
+ * Produz os quadros e acorda o consumidor a cada volta do laço, que dura de
+ * 1 ms a stall_max_us (uma em cada quatro voltas é uma tarefa lenta)
+ */
+static void run(bool use_dma, size_t count, uint32_t stall_max_us, run_result_t *out) {
+    memset(out, 0, sizeof(*out));
+    host_sdk_reset();
+    int sm = nec_rx_init(pio0, RX_PIN);
+    if (use_dma) {
+        nec_rx_stream_init(&stream, pio0, (uint)sm);
+    }
+
+    uint32_t seed = 0x4EC0046u;
+    size_t next = 0;
+    size_t matched = 0;
+    uint64_t wake = 0;
+
+    while (next < count || wake <= produced[count - 1].time_us + stall_max_us) {
+        if (next < count && produced[next].time_us <= wake) {
+            host_time_advance_to(produced[next].time_us);
+            host_pio_rx_push(pio0, (uint)sm, produced[next].frame);
+            next++;
+            continue;
+        }
+        host_time_advance_to(wake);
+
+        // Consome o que houver e confere com os quadros produzidos em ordem
+        uint32_t frame;
+        uint64_t stamp;
+        nec_rx_event_t event;
+        while (true) {
+            if (use_dma) {
+                if (!nec_rx_stream_next(&stream, &event)) {
+                    break;
+                }
+                frame = event.frame;
+                stamp = event.time_us;
+            } else {
+                if (pio_sm_is_rx_fifo_empty(pio0, (uint)sm)) {
+                    break;
+                }
+                frame = pio_sm_get(pio0, (uint)sm);
+                stamp = time_us_64();
+            }
+            // Os perdidos ficam para trás: procura o quadro pelo instante
+            while (matched < next && !(produced[matched].frame == frame && produced[matched].time_us <= stamp &&
+                                       (use_dma ? produced[matched].time_us == stamp : true))) {
+                matched++;
+            }
+            if (matched == next) {
+                break;
+            }
+            uint32_t error = (uint32_t)(stamp - produced[matched].time_us);
+            out->stamp_error_sum_us += error;
+            out->stamp_error_max_us = error > out->stamp_error_max_us ? error : out->stamp_error_max_us;
+            out->received++;
+            matched++;
+        }
+
+        uint32_t r = bench_rand(&seed);
+        wake += r % 4 == 0 ? 1000 + (r >> 2) % stall_max_us : 1000;
+    }
+    out->lost = (uint32_t)count - out->received;
+}
+
+static void run_next_empty(void *ctx) {
+    nec_rx_event_t event;
+    bench_sink += nec_rx_stream_next(ctx, &event);
+}
+
+typedef struct {
+    uint32_t start;
+    uint32_t events;
+} drain_ctx_t;
+
+static void run_drain(void *ctx) {
+    drain_ctx_t *d = ctx;
+    stream.read_index = d->start;
+    stream.last_stamp = stream.stamps[(d->start + NEC_RX_RING_FRAMES - 1) % NEC_RX_RING_FRAMES];
+    nec_rx_event_t event;
+    for (uint32_t i = 0; i < d->events; i++) {
+        nec_rx_stream_next(&stream, &event);
+        bench_sink += event.data;
+    }
+}
+
+void bench_suite_necrx(void) {
+    size_t count = make_schedule(0x5EED0046u, bench_quick ? 500 : MAX_FRAMES);
+
+    // Laço com tarefas lentas de até 1,5 s: mais que o FIFO, bem menos que o anel
+    run_result_t poll, dma;
+    run(false, count, 1500000, &poll);
+    run(true, count, 1500000, &dma);
+    bench_report("necrx.poll_lost_pct", 100.0 * poll.lost / count, "%", BENCH_LOWER_IS_BETTER);
+    bench_report("necrx.dma_lost_pct", 100.0 * dma.lost / count, "%", BENCH_LOWER_IS_BETTER);
+    bench_report("necrx.poll_stamp_error_mean_us", poll.received ? (double)poll.stamp_error_sum_us / poll.received : 0,
+                 "us", BENCH_LOWER_IS_BETTER);
+    bench_report("necrx.poll_stamp_error_max_us", poll.stamp_error_max_us, "us", BENCH_LOWER_IS_BETTER);
+    bench_report("necrx.dma_stamp_error_max_us", dma.stamp_error_max_us, "us", BENCH_LOWER_IS_BETTER);
+    bench_report("necrx.dma_overflows", stream.overflows, "count", BENCH_LOWER_IS_BETTER);
+
+    // Parada maior que o anel: o contador registra e o consumidor recupera
+    // os quadros mais novos
+    host_sdk_reset();
+    int sm = nec_rx_init(pio0, RX_PIN);
+    nec_rx_stream_init(&stream, pio0, (uint)sm);
+    uint32_t pushed = 0;
+    for (uint32_t i = 0; i < 2 * NEC_RX_RING_FRAMES; i++) {
+        host_time_advance_us(FRAME_PERIOD_US);
+        host_pio_rx_push(pio0, (uint)sm, nec_encode_frame(0x10, (uint8_t)i));
+        pushed++;
+    }
+    uint32_t recovered = 0;
+    uint32_t order_errors = 0;
+    nec_rx_event_t event;
+    uint8_t expected = (uint8_t)(pushed - (NEC_RX_RING_FRAMES - 1));
+    while (nec_rx_stream_next(&stream, &event)) {
+        order_errors += !event.valid || event.data != expected++;
+        recovered++;
+    }
+    host_time_advance_us(FRAME_PERIOD_US);
+    host_pio_rx_push(pio0, (uint)sm, nec_encode_frame(0x10, 0xAA));
+    bool resumed = nec_rx_stream_next(&stream, &event) && event.data == 0xAA;
+    bench_report("necrx.overflow_events", stream.overflows, "count", BENCH_LOWER_IS_BETTER);
+    bench_report("necrx.overflow_recovered_frames", recovered, "count", BENCH_HIGHER_IS_BETTER);
+    bench_report("necrx.overflow_order_errors", order_errors + !resumed, "count", BENCH_LOWER_IS_BETTER);
+
+    // PIO simulado: quadros no pino, instante = fim do último bit
+    uint32_t pio_frames = bench_quick ? 50 : 200;
+    uint32_t pio_errors = 0;
+    int64_t offset_min = INT64_MAX;
+    int64_t offset_max = INT64_MIN;
+    uint32_t seed = 0x4EC1046u;
+    host_sdk_reset();
+    host_gpio_drive(RX_PIN, true);
+    sm = nec_rx_init(pio1, RX_PIN);
+    host_pio_simulate(pio1, (uint)sm, true);
+    nec_rx_stream_init(&stream, pio1, (uint)sm);
+    uint64_t now = 1000;
+    for (uint32_t i = 0; i < pio_frames; i++) {
+        uint32_t r = bench_rand(&seed);
+        uint16_t tx[IR_CHANNEL_NEC_TIMINGS];
+        size_t len = ir_channel_nec_waveform(nec_encode_frame((uint8_t)r, (uint8_t)(r >> 8)), tx);
+        uint64_t end = ir_channel_play(tx, len, RX_PIN, now);
+        now = end + 40000;
+        host_time_advance_to(now);
+
+        bool ok = nec_rx_stream_next(&stream, &event) && event.valid && event.address == (uint8_t)r &&
+                  event.data == (uint8_t)(r >> 8);
+        pio_errors += !ok;
+        if (ok) {
+            int64_t offset = (int64_t)event.time_us - (int64_t)end;
+            offset_min = offset < offset_min ? offset : offset_min;
+            offset_max = offset > offset_max ? offset : offset_max;
+        }
+    }
+    bench_report("necrx.pio_frame_errors", pio_errors, "count", BENCH_LOWER_IS_BETTER);
+    bench_report("necrx.pio_stamp_jitter_us", offset_max >= offset_min ? (double)(offset_max - offset_min) : 0, "us",
+                 BENCH_LOWER_IS_BETTER);
+
+    // Custo do consumidor: anel vazio (a volta comum do laço) e por evento
+    bench_time("necrx.next_empty", run_next_empty, &stream, 1);
+    static drain_ctx_t drain;
+    uint32_t written = (uint32_t)(dma_channel_hw_addr(stream.stamp_chan)->write_addr - (uintptr_t)stream.stamps) /
+                       sizeof(uint32_t);
+    drain.events = 32;
+    drain.start = (written + NEC_RX_RING_FRAMES - drain.events) % NEC_RX_RING_FRAMES;
+    bench_time("necrx.next_event", run_drain, &drain, drain.events);
+}
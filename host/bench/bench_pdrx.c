@@ -0,0 +1,251 @@
+/**
+ * bench_pdrx.c - Receptor PIO + DMA de distância de pulso no PIO simulado
+ *
+ * Toca as capturas de custom_ir.c e quadros NEC como bordas no pino de um
+ * pulse_distance_receive.pio executado instrução a instrução pelo shim
+ * (host_pio_simulate), com o DMA levando as palavras ao anel, e confere cada
+ * quadro com um decodificador de tempos que usa os mesmos limiares:
+ *
+ *  - capture: todas as capturas (inclusive as com defeito), quadro a quadro;
+ *  - philco_room: a captura OFF pelo modelo de sala do bench_channel.c,
+ *    comparada ao decodificador por limiar fixo na mesma saída do canal;
+ *  - nec: quadros aleatórios com PD_RX_CONFIG_NEC, conferidos com
+ *    nec_decode_frame().
+ *
+ * Também registra o trabalho da CPU por quadro das capturas: bordas que a
+ * captura por interrupção atenderia contra palavras entregues pelo DMA, e o
+ * custo de montar um quadro Philco a partir do anel.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "bench.h"
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+#include "host_sdk.h"
+#include "nec_transmit.h"
+#include "nec_receive.h"
+#include "custom_ir.h"
+#include "philco_ac.h"
+#include "ir_channel.h"
+#include "pulse_distance_receive.h"
+
+#define SENSOR_PIN 10
+#define MAX_TIMINGS 1024
+#define MAX_FRAMES 16
+
+static const ir_channel_model_t room = {
+    .mark_stretch_us = 40,
+    .jitter_us = 15,
+    .dropout_ppm = 500,
+    .glitch_per_s = 4,
+    .glitch_us = 60,
+    .echo_delay_us = 30,
+    .echo_pct = 20,
+};
+
+static pd_rx_stream_t stream;
+static pd_rx_config_t config;
+static uint64_t now;
+static uint16_t rx[MAX_TIMINGS];
+
+static void start_receiver(const pd_rx_config_t *c) {
+    host_sdk_reset();
+    host_gpio_drive(SENSOR_PIN, true);
+    config = *c;
+    int sm = pd_rx_init(pio1, SENSOR_PIN, &config);
+    host_pio_simulate(pio1, (uint)sm, true);
+    pd_rx_stream_init(&stream, pio1, (uint)sm);
+    now = 1000;
+}
+
+/**
+ * Toca os tempos no pino e recolhe os quadros que o PIO fechou
+ */
+static size_t receive(const uint16_t *timings, size_t count, pd_rx_frame_t *frames, size_t max) {
+    now = ir_channel_play(timings, count, SENSOR_PIN, now) + pd_rx_frame_gap_us(&config) + 1000;
+    host_time_advance_to(now);
+
+    size_t n = 0;
+    pd_rx_frame_t frame;
+    while (pd_rx_stream_next(&stream, &frame)) {
+        if (n < max) {
+            frames[n++] = frame;
+        }
+    }
+    return n;
+}
+
+/**
+ * Decodificador de tempos com os limiares do programa PIO: cabeçalho pela
+ * marca mínima, bit pelo limiar e fim de quadro pelo silêncio
+ */
+static size_t reference_decode(const uint16_t *timings, size_t count, pd_rx_frame_t *frames, size_t max) {
+    uint32_t gap = pd_rx_frame_gap_us(&config);
+    size_t n = 0;
+    bool in_frame = false;
+    pd_rx_frame_t frame;
+
+    for (size_t i = 0; i < count; i += 2) {
+        if (!in_frame) {
+            if (timings[i] >= config.header_mark_min_us) {
+                in_frame = true;
+                pd_rx_frame_reset(&frame);
+            }
+            continue;
+        }
+        uint32_t space = i + 1 < count ? timings[i + 1] : UINT32_MAX;
+        if (space >= gap) {
+            in_frame = false;
+            if (n < max) {
+                frames[n++] = frame;
+            }
+            continue;
+        }
+        if (frame.bit_count < PD_RX_MAX_BITS) {
+            if (space > config.bit_threshold_us) {
+                frame.bytes[frame.bit_count / 8] |= (uint8_t)(1u << (frame.bit_count % 8));
+            }
+            frame.bit_count++;
+        } else {
+            frame.truncated = true;
+        }
+    }
+    return n;
+}
+
+static bool same_frame(const pd_rx_frame_t *a, const pd_rx_frame_t *b) {
+    return a->bit_count == b->bit_count && memcmp(a->bytes, b->bytes, sizeof(a->bytes)) == 0;
+}
+
+static bool philco_frame_ok(const pd_rx_frame_t *frame, const uint8_t *expected) {
+    return frame->bit_count == PHILCO_AC_FRAME_BITS && philco_ac_frame_ok(frame->bytes) &&
+           (!expected || memcmp(frame->bytes, expected, PHILCO_AC_FRAME_BYTES) == 0);
+}
+
+typedef struct {
+    uint32_t words[8];
+    size_t count;
+} assemble_ctx_t;
+
+static void run_assemble(void *ctx) {
+    assemble_ctx_t *a = ctx;
+    pd_rx_frame_t frame;
+    pd_rx_frame_reset(&frame);
+    for (size_t i = 0; i < a->count; i++) {
+        pd_rx_frame_push_word(&frame, a->words[i]);
+    }
+    bench_sink += frame.bytes[0];
+}
+
+void bench_suite_pdrx(void) {
+    static pd_rx_frame_t got[MAX_FRAMES];
+    static pd_rx_frame_t want[MAX_FRAMES];
+    const ir_named_signal_t *signals;
+    size_t count = get_captured_signals(&signals);
+    pd_rx_config_t philco = PD_RX_CONFIG_PHILCO;
+    pd_rx_config_t nec = PD_RX_CONFIG_NEC;
+
+    // Capturas: o PIO precisa fechar os mesmos quadros que os tempos dão
+    uint32_t mismatches = 0;
+    uint32_t valid = 0;
+    uint32_t hard_valid = 0;
+    uint32_t frames = 0;
+    uint64_t edges = 0;
+    uint64_t words = 0;
+    start_receiver(&philco);
+    for (size_t i = 0; i < count; i++) {
+        const ir_raw_signal_t *s = &signals[i].signal;
+        uint32_t read_before = stream.read_total;
+        size_t n = receive(s->data, s->length, got, MAX_FRAMES);
+        size_t m = reference_decode(s->data, s->length, want, MAX_FRAMES);
+
+        mismatches += n > m ? n - m : m - n;
+        for (size_t f = 0; f < n && f < m; f++) {
+            mismatches += !same_frame(&got[f], &want[f]);
+        }
+        for (size_t f = 0; f < n; f++) {
+            valid += philco_frame_ok(&got[f], NULL);
+        }
+        frames += n;
+        edges += s->length + 1;
+        words += stream.read_total - read_before;
+
+        uint8_t bytes[PHILCO_AC_FRAME_BYTES];
+        hard_valid += bench_philco_hard_decode(s->data, s->length, bytes);
+    }
+    bench_report("pdrx.capture_frame_mismatches", mismatches, "count", BENCH_LOWER_IS_BETTER);
+    bench_report("pdrx.capture_valid_frames", valid, "count", BENCH_HIGHER_IS_BETTER);
+    bench_report("pdrx.capture_hard_decoded", hard_valid, "count", BENCH_HIGHER_IS_BETTER);
+    bench_report("pdrx.overflows", stream.overflows, "count", BENCH_LOWER_IS_BETTER);
+    if (frames > 0) {
+        bench_report("pdrx.capture_irq_edges_per_frame", (double)edges / frames, "count", BENCH_LOWER_IS_BETTER);
+        bench_report("pdrx.capture_dma_words_per_frame", (double)words / frames, "count", BENCH_LOWER_IS_BETTER);
+    }
+
+    // Sala: mesma saída do canal no PIO e no decodificador por limiar fixo
+    uint32_t trials = bench_quick ? 40 : 200;
+    const ir_raw_signal_t *off = get_raw_signal(IR_OFF);
+    philco_ac_frame_t clean;
+    philco_ac_decode(off->data, off->length, &clean);
+    ir_channel_t channel;
+    ir_channel_init(&channel, &room, 0x5EED0043u);
+    uint32_t pio_ok = 0;
+    uint32_t hard_ok = 0;
+    start_receiver(&philco);
+    for (uint32_t t = 0; t < trials; t++) {
+        size_t len = ir_channel_apply(&channel, off->data, off->length, rx, MAX_TIMINGS);
+        size_t n = receive(rx, len, got, MAX_FRAMES);
+        bool ok = false;
+        for (size_t f = 0; f < n && !ok; f++) {
+            ok = philco_frame_ok(&got[f], clean.bytes);
+        }
+        pio_ok += ok;
+
+        uint8_t bytes[PHILCO_AC_FRAME_BYTES];
+        hard_ok += bench_philco_hard_decode(rx, len, bytes) && memcmp(bytes, clean.bytes, sizeof(bytes)) == 0;
+    }
+    bench_report("pdrx.philco_room_ok_pct", 100.0 * pio_ok / trials, "%", BENCH_HIGHER_IS_BETTER);
+    bench_report("pdrx.philco_room_hard_ok_pct", 100.0 * hard_ok / trials, "%", BENCH_HIGHER_IS_BETTER);
+
+    // NEC com a mesma máquina: 32 bits em bytes[0..3]
+    uint32_t nec_frames = bench_quick ? 100 : 500;
+    uint32_t nec_errors = 0;
+    uint32_t seed = 0x4EC0043u;
+    start_receiver(&nec);
+    for (uint32_t f = 0; f < nec_frames; f++) {
+        uint32_t r = bench_rand(&seed);
+        uint8_t address = (uint8_t)r;
+        uint8_t data = (uint8_t)(r >> 8);
+        uint16_t tx[IR_CHANNEL_NEC_TIMINGS];
+        size_t len = ir_channel_nec_waveform(nec_encode_frame(address, data), tx);
+        size_t n = receive(tx, len, got, MAX_FRAMES);
+
+        uint8_t a, d;
+        uint32_t frame = 0;
+        if (n == 1 && got[0].bit_count == 32) {
+            memcpy(&frame, got[0].bytes, sizeof(frame));
+        }
+        nec_errors += !(frame && nec_decode_frame(frame, &a, &d) && a == address && d == data);
+    }
+    bench_report("pdrx.nec_errors", nec_errors, "count", BENCH_LOWER_IS_BETTER);
+
+    // Montagem de um quadro Philco a partir das palavras do anel
+    static assemble_ctx_t assemble;
+    start_receiver(&philco);
+    now = ir_channel_play(off->data, off->length, SENSOR_PIN, now) + pd_rx_frame_gap_us(&philco) + 1000;
+    host_time_advance_to(now);
+    // Palavras do primeiro quadro, até a que o encerra (bit 0 = 0)
+    assemble.count = 0;
+    while (assemble.count < count_of(assemble.words)) {
+        uint32_t word = stream.ring[assemble.count++];
+        if ((word & 1) == 0) {
+            break;
+        }
+    }
+    bench_time("pdrx.assemble_philco_frame", run_assemble, &assemble, 1);
+}
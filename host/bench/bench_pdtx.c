@@ -0,0 +1,221 @@
+/**
+ * bench_pdtx.c - Transmissor PIO de distância de pulso no PIO simulado
+ *
+ * Decodifica cada captura válida de custom_ir.c, envia os bytes pelo
+ * pulse_distance_transmit (as duas state machines executadas instrução a
+ * instrução pelo shim) e registra as bordas no pino pelo hook do shim. As
+ * bordas passam pelo analisador de ir_txcheck.c contra:
+ *
+ *  - capture: o array capturado, que é o que o motor de tempos transmite;
+ *  - nominal: os tempos de PD_TX_CONFIG_PHILCO para os mesmos bits, que
+ *    isolam o arredondamento para períodos do carrier.
+ *
+ * Os tempos demodulados também são decodificados de novo, conferindo que o
+ * quadro saiu com os mesmos bits. Por fim, compara as palavras escritas no
+ * FIFO por quadro com os tempos que o motor por tempos percorre, e mede o
+ * custo de montar as palavras.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+#include "host_sdk.h"
+#include "custom_ir.h"
+#include "philco_ac.h"
+#include "ir_txcheck.h"
+#include "pulse_distance_transmit.h"
+
+#define IR_TX_PIN 2
+#define MAX_EDGES 8192
+#define MAX_TIMINGS 512
+
+static uint32_t edges[MAX_EDGES];
+static ir_txcheck_recorder_t recorder;
+
+static void record_edge(uint gpio, bool level, uint64_t time_us, void *ctx) {
+    (void)ctx;
+    if (gpio == IR_TX_PIN) {
+        ir_txcheck_record(&recorder, level, (uint32_t)time_us);
+    }
+}
+
+size_t bench_demodulate(const uint32_t *e, size_t count, uint16_t *timings, size_t max) {
+    size_t n = 0;
+    uint32_t mark_start = 0;
+    uint32_t last_fall = 0;
+    bool in_mark = false;
+
+    for (size_t i = 0; i < count; i++) {
+        uint32_t t = e[i] >> 1;
+        if ((e[i] & 1) == 0) {
+            last_fall = t;
+            continue;
+        }
+        if (!in_mark) {
+            mark_start = t;
+            in_mark = true;
+        } else if (t - last_fall > IR_TXCHECK_DEMOD_GAP_US) {
+            if (n + 2 <= max) {
+                timings[n++] = (uint16_t)(last_fall - mark_start);
+                timings[n++] = (uint16_t)(t - last_fall);
+            }
+            mark_start = t;
+        }
+    }
+    if (in_mark && n < max) {
+        timings[n++] = (uint16_t)(last_fall - mark_start);
+    }
+    return n;
+}
+
+static size_t nominal_timings(const pd_tx_config_t *c, const uint8_t *bytes, size_t bits, uint16_t *timings) {
+    size_t n = 0;
+    timings[n++] = c->header_mark_us;
+    timings[n++] = c->header_space_us;
+    for (size_t i = 0; i < bits; i++) {
+        timings[n++] = c->bit_mark_us;
+        timings[n++] = (bytes[i / 8] >> (i % 8)) & 1 ? c->one_space_us : c->zero_space_us;
+    }
+    timings[n++] = c->bit_mark_us;
+    return n;
+}
+
+typedef struct {
+    uint32_t timings;
+    uint32_t timings_within;
+    uint32_t count_mismatches;
+    int32_t error_worst_us;
+    double error_abs_sum_us;
+} check_result_t;
+
+static void check(const uint16_t *intended, size_t length, check_result_t *out, ir_txcheck_report_t *r) {
+    if (!ir_txcheck_analyze(edges, recorder.count, intended, length, 0, r)) {
+        out->count_mismatches++;
+        return;
+    }
+    size_t compared = r->measured < r->intended ? r->measured : r->intended;
+    out->timings += compared;
+    out->timings_within += r->within_tolerance;
+    out->count_mismatches += r->measured != r->intended;
+    out->error_abs_sum_us += r->error_abs_mean_us * compared;
+
+    int32_t worst = -r->error_min_us > r->error_max_us ? r->error_min_us : r->error_max_us;
+    if (abs(worst) > abs(out->error_worst_us)) {
+        out->error_worst_us = worst;
+    }
+}
+
+static void report(const char *what, const check_result_t *r) {
+    char name[64];
+    snprintf(name, sizeof(name), "pdtx.%s_error_worst_us", what);
+    bench_report(name, abs(r->error_worst_us), "us", BENCH_LOWER_IS_BETTER);
+    snprintf(name, sizeof(name), "pdtx.%s_error_abs_mean_us", what);
+    bench_report(name, r->timings ? r->error_abs_sum_us / r->timings : 0, "us", BENCH_LOWER_IS_BETTER);
+    snprintf(name, sizeof(name), "pdtx.%s_within_5us_pct", what);
+    bench_report(name, r->timings ? 100.0 * r->timings_within / r->timings : 0, "%", BENCH_HIGHER_IS_BETTER);
+    snprintf(name, sizeof(name), "pdtx.%s_count_mismatches", what);
+    bench_report(name, r->count_mismatches, "count", BENCH_LOWER_IS_BETTER);
+}
+
+typedef struct {
+    pd_tx_t tx;
+    uint8_t bytes[PHILCO_AC_FRAME_BYTES];
+} encode_ctx_t;
+
+static void run_encode(void *ctx) {
+    encode_ctx_t *e = ctx;
+    uint32_t words[PD_TX_MAX_WORDS];
+    size_t n = pd_tx_encode(&e->tx, e->bytes, PHILCO_AC_FRAME_BITS, words);
+    bench_sink += words[n - 2];
+}
+
+void bench_suite_pdtx(void) {
+    static uint16_t nominal[MAX_TIMINGS];
+    static uint16_t measured[MAX_TIMINGS];
+    const ir_named_signal_t *signals;
+    size_t count = get_captured_signals(&signals);
+    pd_tx_config_t philco = PD_TX_CONFIG_PHILCO;
+
+    check_result_t vs_capture = {0};
+    check_result_t vs_nominal = {0};
+    uint32_t frames = 0;
+    uint32_t decode_mismatches = 0;
+    uint64_t words = 0;
+    uint64_t timings = 0;
+    float carrier_hz = 0;
+    float duty_pct = 0;
+    ir_txcheck_recorder_init(&recorder, edges, MAX_EDGES);
+
+    for (size_t i = 0; i < count; i++) {
+        const ir_raw_signal_t *s = &signals[i].signal;
+        uint8_t bytes[PHILCO_AC_FRAME_BYTES];
+        if (!bench_philco_hard_decode(s->data, s->length, bytes)) {
+            continue;               // Capturas com defeito não têm bits para enviar
+        }
+
+        host_sdk_reset();
+        pd_tx_t tx;
+        pd_tx_init(&tx, pio0, IR_TX_PIN, &philco);
+        for (uint sm = 0; sm < 4; sm++) {
+            host_pio_simulate(pio0, sm, pio_sm_is_claimed(pio0, sm));
+        }
+        ir_txcheck_recorder_clear(&recorder);
+        host_sdk_set_edge_hook(record_edge, NULL);
+        host_time_advance_us(1000);
+
+        uint32_t frame_words[PD_TX_MAX_WORDS];
+        words += pd_tx_encode(&tx, bytes, PHILCO_AC_FRAME_BITS, frame_words);
+        timings += s->length;
+        pd_tx_send(&tx, bytes, PHILCO_AC_FRAME_BITS);
+
+        // Quadro inteiro mais o silêncio do fim
+        size_t n = nominal_timings(&philco, bytes, PHILCO_AC_FRAME_BITS, nominal);
+        uint32_t duration = philco.gap_us;
+        for (size_t t = 0; t < n; t++) {
+            duration += nominal[t];
+        }
+        host_time_advance_us(duration + 1000);
+        host_sdk_set_edge_hook(NULL, NULL);
+
+        ir_txcheck_report_t r;
+        check(s->data, s->length, &vs_capture, &r);
+        check(nominal, n, &vs_nominal, &r);
+        if (r.carrier_cycles > 0) {
+            carrier_hz = r.carrier_hz;
+            duty_pct = r.duty_pct;
+        }
+
+        uint8_t again[PHILCO_AC_FRAME_BYTES];
+        size_t m = bench_demodulate(edges, recorder.count, measured, MAX_TIMINGS);
+        decode_mismatches += !(bench_philco_hard_decode(measured, m, again) && memcmp(again, bytes, sizeof(bytes)) == 0);
+        frames++;
+    }
+
+    report("capture", &vs_capture);
+    report("nominal", &vs_nominal);
+    bench_report("pdtx.frames_sent", frames, "count", BENCH_HIGHER_IS_BETTER);
+    bench_report("pdtx.decode_mismatches", decode_mismatches, "count", BENCH_LOWER_IS_BETTER);
+    bench_report("pdtx.carrier_error_hz", fabsf(carrier_hz - 38000.0f), "Hz", BENCH_LOWER_IS_BETTER);
+    bench_report("pdtx.duty_error_pct", fabsf(duty_pct - 50.0f), "%", BENCH_LOWER_IS_BETTER);
+
+    // Trabalho da CPU por quadro: palavras no FIFO contra tempos do array
+    if (frames > 0) {
+        bench_report("pdtx.fifo_words_per_frame", (double)words / frames, "count", BENCH_LOWER_IS_BETTER);
+        bench_report("pdtx.array_timings_per_frame", (double)timings / frames, "count", BENCH_LOWER_IS_BETTER);
+    }
+
+    static encode_ctx_t encode;
+    host_sdk_reset();
+    pd_tx_init(&encode.tx, pio0, IR_TX_PIN, &philco);
+    const ir_raw_signal_t *off = get_raw_signal(IR_OFF);
+    bench_philco_hard_decode(off->data, off->length, encode.bytes);
+    bench_time("pdtx.encode_philco_frame", run_encode, &encode, 1);
+}
@@ -0,0 +1,247 @@
+/**
+ * bench_philco.c - Recuperação de quadros do ar condicionado com ruído
+ *
+ * Gera quadros a partir das capturas válidas de custom_ir.c, injeta jitter,
+ * alongamento de marca, glitches e marcas perdidas e compara o decodificador
+ * por limiar fixo com o decodificador de decisão suave (uma cópia e três
+ * cópias repetidas), além dos dois decodificadores após o saneamento de
+ * ir_capture.c e do decodificador por limiar após o reparo das marcas
+ * perdidas.
+ * As taxas usam semente fixa e são determinísticas.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "bench.h"
+#include "pico/stdlib.h"
+#include "custom_ir.h"
+#include "philco_ac.h"
+#include "ir_capture.h"
+
+#define MAX_REFERENCES 16
+#define MAX_RAW 1024
+#define HARD_THRESHOLD_US 800
+
+typedef struct {
+    uint32_t jitter_us;       // Jitter uniforme +/- em cada tempo
+    uint32_t stretch_us;      // Alongamento máximo das marcas (encurta os espaços)
+    uint32_t glitch_ppm;      // Chance de dividir um tempo com um pulso espúrio
+    uint32_t lost_mark_ppm;   // Chance de uma marca de bit sumir
+} noise_t;
+
+static uint8_t references[MAX_REFERENCES][PHILCO_AC_FRAME_BYTES];
+static size_t reference_count;
+
+static uint16_t raw_buf[MAX_RAW];
+static uint16_t clean_buf[MAX_RAW];
+static size_t raw_len;
+
+/**
+ * Decodificador de referência: limiar fixo no espaço, sem tratar ruído
+ */
+bool bench_philco_hard_decode(const uint16_t *raw, size_t count, uint8_t *bytes) {
+    if (count < 2 + 2 * PHILCO_AC_FRAME_BITS) {
+        return false;
+    }
+    memset(bytes, 0, PHILCO_AC_FRAME_BYTES);
+    for (int i = 0; i < PHILCO_AC_FRAME_BITS; i++) {
+        if (raw[3 + 2 * i] > HARD_THRESHOLD_US) {
+            bytes[i / 8] |= 1 << (i % 8);
+        }
+    }
+    return philco_ac_frame_ok(bytes);
+}
+
+static uint32_t noisy(uint32_t us, int32_t offset, const noise_t *noise, uint32_t *seed) {
+    int32_t value = (int32_t)us + offset;
+    if (noise->jitter_us) {
+        value += (int32_t)(bench_rand(seed) % (2 * noise->jitter_us + 1)) - (int32_t)noise->jitter_us;
+    }
+    return value < 30 ? 30 : (uint32_t)value;
+}
+
+static void emit(uint32_t us) {
+    if (raw_len < MAX_RAW) {
+        raw_buf[raw_len++] = (uint16_t)(us > 0xFFFF ? 0xFFFF : us);
+    }
+}
+
+/**
+ * Emite um tempo, às vezes dividido por um pulso espúrio de nível oposto
+ */
+static void emit_with_glitch(uint32_t us, const noise_t *noise, uint32_t *seed) {
+    if (us > 300 && bench_rand(seed) % 1000000 < noise->glitch_ppm) {
+        uint32_t glitch = 60 + bench_rand(seed) % 120;
+        uint32_t first = 50 + bench_rand(seed) % (us - 200);
+        emit(first);
+        emit(glitch);
+        emit(us - first - glitch / 2);
+        return;
+    }
+    emit(us);
+}
+
+/**
+ * Sintetiza copies cópias do quadro no buffer raw_buf
+ */
+static void synth_frame(const uint8_t *bytes, int copies, const noise_t *noise, uint32_t *seed) {
+    raw_len = 0;
+    for (int c = 0; c < copies; c++) {
+        int32_t stretch = noise->stretch_us ? (int32_t)(bench_rand(seed) % (noise->stretch_us + 1)) : 0;
+        uint32_t pending_space = 0;
+
+        emit(noisy(PHILCO_AC_HDR_MARK, stretch, noise, seed));
+        pending_space = noisy(PHILCO_AC_HDR_SPACE, -stretch, noise, seed);
+
+        for (int i = 0; i <= PHILCO_AC_FRAME_BITS; i++) {
+            uint32_t mark = noisy(PHILCO_AC_BIT_MARK, stretch, noise, seed);
+            // Marca perdida: o espaço anterior, a marca e o próximo espaço viram um só
+            if (i < PHILCO_AC_FRAME_BITS && bench_rand(seed) % 1000000 < noise->lost_mark_ppm) {
+                pending_space += mark;
+            } else {
+                emit_with_glitch(pending_space, noise, seed);
+                emit_with_glitch(mark, noise, seed);
+                pending_space = 0;
+            }
+            if (i == PHILCO_AC_FRAME_BITS) {
+                break;
+            }
+            bool one = bytes[i / 8] & (1 << (i % 8));
+            pending_space += noisy(one ? PHILCO_AC_ONE_SPACE : PHILCO_AC_ZERO_SPACE, -stretch, noise, seed);
+        }
+        if (c + 1 < copies) {
+            emit(PHILCO_AC_FRAME_GAP + 12000);
+        }
+    }
+}
+
+typedef struct {
+    uint32_t trials;
+    uint32_t hard_ok;
+    uint32_t soft_ok;
+    uint32_t soft_repeat_ok;
+    uint32_t sanitized_hard_ok;
+    uint32_t sanitized_soft_ok;
+    uint32_t repaired_hard_ok;
+    uint32_t false_accept;
+} recovery_t;
+
+static void measure_recovery(const noise_t *noise, recovery_t *r) {
+    uint32_t seed = 0xC0FFEEu;
+    philco_ac_frame_t frame;
+    uint8_t bytes[PHILCO_AC_FRAME_BYTES];
+
+    memset(r, 0, sizeof(*r));
+    r->trials = bench_quick ? 300 : 3000;
+
+    for (uint32_t t = 0; t < r->trials; t++) {
+        const uint8_t *ref = references[t % reference_count];
+
+        synth_frame(ref, 1, noise, &seed);
+        if (bench_philco_hard_decode(raw_buf, raw_len, bytes) && memcmp(bytes, ref, sizeof(bytes)) == 0) {
+            r->hard_ok++;
+        }
+        ir_sanitizer_t sanitizer;
+        ir_sanitizer_init(&sanitizer, BENCH_GLITCH_US);
+        size_t clean_len = ir_sanitize(raw_buf, raw_len, clean_buf, &sanitizer);
+        if (bench_philco_hard_decode(clean_buf, clean_len, bytes) && memcmp(bytes, ref, sizeof(bytes)) == 0) {
+            r->sanitized_hard_ok++;
+        }
+        if (philco_ac_decode(clean_buf, clean_len, &frame) && memcmp(frame.bytes, ref, sizeof(bytes)) == 0) {
+            r->sanitized_soft_ok++;
+        }
+        ir_repair_t repair;
+        memcpy(clean_buf, raw_buf, raw_len * sizeof(uint16_t));
+        size_t repaired_len = ir_capture_repair(clean_buf, raw_len, MAX_RAW, philco_ac_check_timings, &repair);
+        if (bench_philco_hard_decode(clean_buf, repaired_len, bytes) && memcmp(bytes, ref, sizeof(bytes)) == 0) {
+            r->repaired_hard_ok++;
+        }
+
+        if (philco_ac_decode(raw_buf, raw_len, &frame)) {
+            if (memcmp(frame.bytes, ref, sizeof(bytes)) == 0) {
+                r->soft_ok++;
+            } else {
+                r->false_accept++;
+            }
+        }
+
+        synth_frame(ref, 3, noise, &seed);
+        if (philco_ac_decode(raw_buf, raw_len, &frame) && memcmp(frame.bytes, ref, sizeof(bytes)) == 0) {
+            r->soft_repeat_ok++;
+        }
+    }
+}
+
+static void report_rate(const char *name, uint32_t ok, uint32_t trials, bench_better_t better) {
+    bench_report(name, 100.0 * ok / trials, "%", better);
+}
+
+static void run_decode(void *ctx) {
+    philco_ac_frame_t frame;
+    (void)ctx;
+    philco_ac_decode(raw_buf, raw_len, &frame);
+    bench_sink = frame.bytes[PHILCO_AC_FRAME_BYTES - 1];
+}
+
+void bench_suite_philco(void) {
+    const ir_named_signal_t *signals;
+    size_t count = get_captured_signals(&signals);
+    philco_ac_frame_t frame;
+    uint8_t bytes[PHILCO_AC_FRAME_BYTES];
+    char name[64];
+
+    // Referências: capturas que o decodificador por limiar já aceita
+    reference_count = 0;
+    for (size_t i = 0; i < count && reference_count < MAX_REFERENCES; i++) {
+        const ir_raw_signal_t *s = &signals[i].signal;
+        if (bench_philco_hard_decode(s->data, s->length, bytes)) {
+            memcpy(references[reference_count++], bytes, sizeof(bytes));
+        }
+    }
+
+    // Capturas reais com defeito
+    for (size_t i = 0; i < count; i++) {
+        const ir_raw_signal_t *s = &signals[i].signal;
+        if (bench_philco_hard_decode(s->data, s->length, bytes)) {
+            continue;
+        }
+        bool ok = philco_ac_decode(s->data, s->length, &frame);
+        snprintf(name, sizeof(name), "philco.capture_%s_recovered", signals[i].name);
+        bench_report(name, ok ? 1 : 0, "bool", BENCH_HIGHER_IS_BETTER);
+    }
+
+    static const struct {
+        const char *name;
+        noise_t noise;
+    } scenarios[] = {
+        {"jitter", {.jitter_us = 300, .stretch_us = 200}},
+        {"glitch", {.jitter_us = 80, .stretch_us = 60, .glitch_ppm = 8000, .lost_mark_ppm = 2000}},
+    };
+
+    for (size_t s = 0; s < count_of(scenarios); s++) {
+        recovery_t r;
+        measure_recovery(&scenarios[s].noise, &r);
+        snprintf(name, sizeof(name), "philco.%s_hard_pct", scenarios[s].name);
+        report_rate(name, r.hard_ok, r.trials, BENCH_HIGHER_IS_BETTER);
+        snprintf(name, sizeof(name), "philco.%s_sanitized_hard_pct", scenarios[s].name);
+        report_rate(name, r.sanitized_hard_ok, r.trials, BENCH_HIGHER_IS_BETTER);
+        snprintf(name, sizeof(name), "philco.%s_sanitized_soft_pct", scenarios[s].name);
+        report_rate(name, r.sanitized_soft_ok, r.trials, BENCH_HIGHER_IS_BETTER);
+        snprintf(name, sizeof(name), "philco.%s_repaired_hard_pct", scenarios[s].name);
+        report_rate(name, r.repaired_hard_ok, r.trials, BENCH_HIGHER_IS_BETTER);
+        snprintf(name, sizeof(name), "philco.%s_soft_pct", scenarios[s].name);
+        report_rate(name, r.soft_ok, r.trials, BENCH_HIGHER_IS_BETTER);
+        snprintf(name, sizeof(name), "philco.%s_soft_x3_pct", scenarios[s].name);
+        report_rate(name, r.soft_repeat_ok, r.trials, BENCH_HIGHER_IS_BETTER);
+        snprintf(name, sizeof(name), "philco.%s_false_accept_pct", scenarios[s].name);
+        report_rate(name, r.false_accept, r.trials, BENCH_LOWER_IS_BETTER);
+    }
+
+    uint32_t seed = 1;
+    synth_frame(references[0], 1, &scenarios[1].noise, &seed);
+    bench_time("philco.decode_frame", run_decode, NULL, 1);
+}
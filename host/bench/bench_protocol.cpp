@@ -0,0 +1,189 @@
+/**
+ * bench_protocol.cpp - Codificadores gerados por ir_protocol.hpp
+ *
+ * Compara cada codificador gerado com o equivalente escrito à mão que já
+ * existe no projeto:
+ *
+ *  - NEC, palavra do PIO: nec_encode_frame();
+ *  - NEC, tempos: ir_channel_nec_waveform() (forma de onda do
+ *    nec_carrier_control.pio);
+ *  - Philco, tempos: laço com as constantes de philco_ac.h, conferido também
+ *    pelo decodificador de philco_ac.c;
+ *  - Samsung: só o gerado (não há codificador à mão).
+ *
+ * Registra as divergências (esperado 0) e o custo por quadro de cada lado.
+ * As constantes do firmware são conferidas na compilação contra as
+ * descrições (NUM_CYCLES vem do cabeçalho gerado do nec_carrier_burst.pio) e
+ * a palavra NEC contra nec_encode_frame() na execução.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <cstring>
+
+#include "bench.h"
+#include "pico/stdlib.h"
+#include "custom_ir.h"
+#include "philco_ac.h"
+#include "ir_channel.h"
+#include "ir_protocol.hpp"
+
+extern "C" {
+#include "nec_transmit.h"
+#include "hardware/clocks.h"            // clock_get_hz() do nec_carrier_burst.pio.h
+#include "nec_carrier_burst.pio.h"
+}
+
+#define FRAMES 256
+#define PHILCO_SIGNATURE_BYTES 5        // Bytes fixos do quadro (frame_signature em philco_ac.c)
+
+using NecEncoder = ir::Encoder<ir::Nec>;
+using PhilcoEncoder = ir::Encoder<ir::PhilcoAc>;
+using SamsungEncoder = ir::Encoder<ir::Samsung>;
+
+// Constantes do firmware conferidas contra as descrições
+static_assert(NecEncoder::bit_mark_cycles == nec_carrier_burst_NUM_CYCLES, "NUM_CYCLES do nec_carrier_burst.pio");
+static_assert(NecEncoder::timings == IR_CHANNEL_NEC_TIMINGS, "tempos do quadro NEC");
+static_assert(NecEncoder::repeat_code()[0] == 9000 && NecEncoder::repeat_code()[1] == 2250, "repetição NEC");
+static_assert(PhilcoEncoder::timings == 2 + 2 * PHILCO_AC_FRAME_BITS + 1, "tempos do quadro Philco");
+static_assert(SamsungEncoder::whole_us && !NecEncoder::whole_us, "arredondamento");
+
+typedef struct {
+    uint8_t nec[FRAMES][2];
+    uint8_t philco[FRAMES][PHILCO_AC_FRAME_BYTES];
+    uint16_t out[PhilcoEncoder::timings];
+    uint32_t words[FRAMES];
+} protocol_ctx_t;
+
+static protocol_ctx_t ctx;
+
+/**
+ * Tempos do quadro Philco como seriam escritos à mão
+ */
+static size_t philco_waveform(const uint8_t *bytes, uint16_t *out) {
+    size_t n = 0;
+    out[n++] = PHILCO_AC_HDR_MARK;
+    out[n++] = PHILCO_AC_HDR_SPACE;
+    for (int i = 0; i < PHILCO_AC_FRAME_BITS; i++) {
+        out[n++] = PHILCO_AC_BIT_MARK;
+        out[n++] = (bytes[i / 8] >> (i % 8)) & 1 ? PHILCO_AC_ONE_SPACE : PHILCO_AC_ZERO_SPACE;
+    }
+    out[n++] = PHILCO_AC_BIT_MARK;
+    return n;
+}
+
+static ir::PhilcoAc::payload_t philco_payload(const uint8_t *bytes) {
+    ir::PhilcoAc::payload_t p;
+    memcpy(p.data(), bytes, p.size());
+    return p;
+}
+
+static void run_nec_word_hand(void *) {
+    for (int f = 0; f < FRAMES; f++) {
+        ctx.words[f] = nec_encode_frame(ctx.nec[f][0], ctx.nec[f][1]);
+    }
+    bench_sink += ctx.words[FRAMES - 1];
+}
+
+static void run_nec_word_gen(void *) {
+    for (int f = 0; f < FRAMES; f++) {
+        ctx.words[f] = NecEncoder::pio_words(ir::Nec::payload(ctx.nec[f][0], ctx.nec[f][1]))[0];
+    }
+    bench_sink += ctx.words[FRAMES - 1];
+}
+
+static void run_nec_timings_hand(void *) {
+    for (int f = 0; f < FRAMES; f++) {
+        ir_channel_nec_waveform(nec_encode_frame(ctx.nec[f][0], ctx.nec[f][1]), ctx.out);
+        bench_sink += ctx.out[IR_CHANNEL_NEC_TIMINGS - 2];
+    }
+}
+
+static void run_nec_timings_gen(void *) {
+    for (int f = 0; f < FRAMES; f++) {
+        NecEncoder::durations(ir::Nec::payload(ctx.nec[f][0], ctx.nec[f][1]), ctx.out);
+        bench_sink += ctx.out[NecEncoder::timings - 2];
+    }
+}
+
+static void run_philco_hand(void *) {
+    for (int f = 0; f < FRAMES; f++) {
+        philco_waveform(ctx.philco[f], ctx.out);
+        bench_sink += ctx.out[PhilcoEncoder::timings - 2];
+    }
+}
+
+static void run_philco_gen(void *) {
+    for (int f = 0; f < FRAMES; f++) {
+        PhilcoEncoder::durations(philco_payload(ctx.philco[f]), ctx.out);
+        bench_sink += ctx.out[PhilcoEncoder::timings - 2];
+    }
+}
+
+static void run_samsung_gen(void *) {
+    for (int f = 0; f < FRAMES; f++) {
+        SamsungEncoder::durations(ir::Samsung::payload(ctx.nec[f][0], ctx.nec[f][1]), ctx.out);
+        bench_sink += ctx.out[SamsungEncoder::timings - 2];
+    }
+}
+
+extern "C" void bench_suite_protocol(void) {
+    uint32_t seed = 0x9E3779B9u;
+
+    // Estados Philco sobre a captura OFF: assinatura mantida, resto aleatório
+    const ir_raw_signal_t *off = get_raw_signal(IR_OFF);
+    philco_ac_frame_t base;
+    philco_ac_decode(off->data, off->length, &base);
+
+    for (int f = 0; f < FRAMES; f++) {
+        uint32_t r = bench_rand(&seed);
+        ctx.nec[f][0] = (uint8_t)r;
+        ctx.nec[f][1] = (uint8_t)(r >> 8);
+
+        uint8_t state[PHILCO_AC_FRAME_BYTES - 1];
+        memcpy(state, base.bytes, sizeof(state));
+        for (size_t i = PHILCO_SIGNATURE_BYTES; i < sizeof(state); i++) {
+            state[i] = (uint8_t)bench_rand(&seed);
+        }
+        ir::PhilcoAc::payload_t p = ir::PhilcoAc::payload(state);
+        memcpy(ctx.philco[f], p.data(), p.size());
+    }
+
+    // Divergências em relação aos codificadores à mão
+    uint32_t nec_mismatch = 0;
+    uint32_t philco_mismatch = 0;
+    uint32_t philco_decoded = 0;
+    for (int f = 0; f < FRAMES; f++) {
+        ir::Nec::payload_t nec = ir::Nec::payload(ctx.nec[f][0], ctx.nec[f][1]);
+        uint32_t word = nec_encode_frame(ctx.nec[f][0], ctx.nec[f][1]);
+        uint16_t hand[PhilcoEncoder::timings];
+        uint16_t gen[PhilcoEncoder::timings];
+
+        ir_channel_nec_waveform(word, hand);
+        NecEncoder::durations(nec, gen);
+        nec_mismatch += NecEncoder::pio_words(nec)[0] != word ||
+                        memcmp(hand, gen, NecEncoder::timings * sizeof(uint16_t)) != 0;
+
+        philco_waveform(ctx.philco[f], hand);
+        PhilcoEncoder::durations(philco_payload(ctx.philco[f]), gen);
+        philco_mismatch += memcmp(hand, gen, PhilcoEncoder::timings * sizeof(uint16_t)) != 0;
+
+        philco_ac_frame_t out;
+        philco_decoded += philco_ac_decode(gen, PhilcoEncoder::timings, &out) &&
+                          memcmp(out.bytes, ctx.philco[f], PHILCO_AC_FRAME_BYTES) == 0;
+    }
+    bench_check("protocol.nec_word_matches_encode_frame",
+                NecEncoder::pio_words(ir::Nec::payload(0x80, 0x14))[0] == nec_encode_frame(0x80, 0x14));
+    bench_report("protocol.nec_mismatch", nec_mismatch, "frames", BENCH_LOWER_IS_BETTER);
+    bench_report("protocol.philco_mismatch", philco_mismatch, "frames", BENCH_LOWER_IS_BETTER);
+    bench_report("protocol.philco_roundtrip_pct", 100.0 * philco_decoded / FRAMES, "%", BENCH_HIGHER_IS_BETTER);
+
+    bench_time("protocol.nec_word_hand", run_nec_word_hand, NULL, FRAMES);
+    bench_time("protocol.nec_word_gen", run_nec_word_gen, NULL, FRAMES);
+    bench_time("protocol.nec_timings_hand", run_nec_timings_hand, NULL, FRAMES);
+    bench_time("protocol.nec_timings_gen", run_nec_timings_gen, NULL, FRAMES);
+    bench_time("protocol.philco_timings_hand", run_philco_hand, NULL, FRAMES);
+    bench_time("protocol.philco_timings_gen", run_philco_gen, NULL, FRAMES);
+    bench_time("protocol.samsung_timings_gen", run_samsung_gen, NULL, FRAMES);
+}
@@ -0,0 +1,144 @@
+/**
+ * bench_raw.c - Expansão dos sinais RAW e agendamento das transmissões
+ *
+ * Mede o custo de CPU de send_ir_command() para cada sinal de ir_signals[]
+ * (o tempo de transmissão em si passa no relógio virtual) e reproduz o laço
+ * do emissor.c: polling a cada 100 ms, intervalo de 7 s e carrier gerado por
+ * bit-banging com busy-wait. As métricas de agendamento são determinísticas.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "bench.h"
+#include "host_sdk.h"
+#include "hardware/timer.h"
+#include "custom_ir.h"
+
+#define IR_GPIO_PIN 2
+#define IR_TX_PIN 16
+
+// Parâmetros do emissor.c
+#define TRANSMISSION_INTERVAL_MS 7000
+#define POLL_INTERVAL_MS 100
+#define IR_CARRIER_FREQ 38000
+#define TX_FRAMES 20
+
+static const char *command_names[] = {"off", "on", "temp_22", "temp_20", "fan_1", "fan_2"};
+
+static uint32_t edge_count;
+
+static void count_edge(uint gpio, bool level, uint64_t time_us, void *ctx) {
+    (void)gpio;
+    (void)level;
+    (void)time_us;
+    (void)ctx;
+    edge_count++;
+}
+
+static void run_send(void *ctx) {
+    ir_signal_type_t command = *(const ir_signal_type_t *)ctx;
+    send_ir_command(command);
+    bench_sink = edge_count;
+}
+
+// ---------------------------------------------------------------------------
+// Modelo do emissor.c
+// ---------------------------------------------------------------------------
+
+// Mesmo algoritmo da antiga transmit_raw_ir_signal()
+void bench_emissor_transmit(uint tx_pin, const uint16_t *signal, size_t length) {
+    uint32_t half_period_us = 1000000 / (IR_CARRIER_FREQ * 2);
+
+    for (size_t i = 0; i < length; i++) {
+        uint32_t duration_us = signal[i];
+        if (i % 2 == 0) {
+            absolute_time_t start_time = get_absolute_time();
+            while (absolute_time_diff_us(start_time, get_absolute_time()) < duration_us) {
+                gpio_put(tx_pin, 1);
+                busy_wait_us_32(half_period_us);
+                gpio_put(tx_pin, 0);
+                busy_wait_us_32(half_period_us);
+            }
+        } else {
+            gpio_put(tx_pin, 0);
+            busy_wait_us_32(duration_us);
+        }
+    }
+    gpio_put(tx_pin, 0);
+}
+
+typedef struct {
+    uint64_t wait_calls;      // Chamadas de espera (sleep/busy-wait)
+    uint64_t lateness_us;     // Soma dos atrasos em relação ao agendamento ideal
+    uint64_t airtime_us;      // Tempo com a CPU presa na transmissão
+    uint64_t overrun_us;      // Tempo de transmissão além da soma dos tempos RAW
+} emissor_stats_t;
+
+static void run_emissor(emissor_stats_t *stats) {
+    const ir_raw_signal_t *signal = get_raw_signal(IR_OFF);
+    uint64_t nominal_us = 0;
+    for (size_t i = 0; i < signal->length; i++) {
+        nominal_us += signal->data[i];
+    }
+
+    host_sdk_reset();
+    gpio_init(IR_TX_PIN);
+    gpio_set_dir(IR_TX_PIN, GPIO_OUT);
+
+    absolute_time_t last_transmission = get_absolute_time();
+    uint32_t frames = 0;
+    *stats = (emissor_stats_t){0};
+
+    while (frames < TX_FRAMES) {
+        absolute_time_t now = get_absolute_time();
+        int64_t elapsed_ms = absolute_time_diff_us(last_transmission, now) / 1000;
+
+        if (elapsed_ms >= TRANSMISSION_INTERVAL_MS) {
+            uint64_t ideal_us = (uint64_t)(frames + 1) * TRANSMISSION_INTERVAL_MS * 1000;
+            uint64_t start_us = to_us_since_boot(now);
+            stats->lateness_us += start_us - ideal_us;
+
+            bench_emissor_transmit(IR_TX_PIN, signal->data, signal->length);
+            frames++;
+
+            uint64_t airtime = to_us_since_boot(get_absolute_time()) - start_us;
+            stats->airtime_us += airtime;
+            stats->overrun_us += airtime - nominal_us;
+            last_transmission = get_absolute_time();
+        }
+        sleep_ms(POLL_INTERVAL_MS);
+    }
+    stats->wait_calls = host_sdk_sleep_calls();
+}
+
+static void run_emissor_bench(void *ctx) {
+    run_emissor(ctx);
+}
+
+void bench_suite_raw(void) {
+    char name[64];
+
+    // Expansão dos sinais pré-definidos com carrier PWM
+    custom_ir_init(IR_GPIO_PIN);
+    host_sdk_set_edge_hook(count_edge, NULL);
+    for (ir_signal_type_t c = IR_OFF; c <= IR_FAN_2; c++) {
+        snprintf(name, sizeof(name), "raw.send_%s", command_names[c]);
+        bench_time(name, run_send, &c, 1);
+
+        edge_count = 0;
+        send_ir_command(c);
+        snprintf(name, sizeof(name), "raw.edges_%s", command_names[c]);
+        bench_report(name, edge_count, "edges", BENCH_LOWER_IS_BETTER);
+    }
+    host_sdk_set_edge_hook(NULL, NULL);
+
+    // Agendamento do emissor.c em tempo virtual
+    emissor_stats_t stats;
+    bench_time("tx.emissor_cpu_per_frame", run_emissor_bench, &stats, TX_FRAMES);
+    bench_report("tx.emissor_wait_calls_per_frame", (double)stats.wait_calls / TX_FRAMES, "calls",
+                 BENCH_LOWER_IS_BETTER);
+    bench_report("tx.emissor_lateness_us", (double)stats.lateness_us / TX_FRAMES, "us", BENCH_LOWER_IS_BETTER);
+    bench_report("tx.emissor_overrun_us", (double)stats.overrun_us / TX_FRAMES, "us", BENCH_LOWER_IS_BETTER);
+    bench_report("tx.emissor_airtime_us", (double)stats.airtime_us / TX_FRAMES, "us", BENCH_LOWER_IS_BETTER);
+}
@@ -0,0 +1,109 @@
+/**
+ * bench_sanitize.c - Reparo e saneamento dos sinais capturados (ir_capture.c)
+ *
+ * Passa cada captura como saiu do receptor (ir_signals_raw, sem o tratamento
+ * do ir_sigc) pelo reparo das marcas perdidas e depois pelo saneamento, e
+ * registra a quantidade de tempos, os ajustes feitos e se o quadro Philco
+ * passa a ser aceito pelo decodificador por limiar. fan_2 e fan_4 perderam
+ * marcas (espaços de ~1140 e ~2100 us) e têm marcas com a borda de início
+ * atrasada: as duas precisam sair do reparo decodificáveis por limiar.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "bench.h"
+#include "pico/stdlib.h"
+#include "philco_ac.h"
+#include "ir_capture.h"
+#include "ir_signals_raw.h"
+
+#define MAX_RAW 1024
+
+static uint16_t raw_buf[MAX_RAW];
+static uint16_t repaired_buf[MAX_RAW];
+static uint16_t clean_buf[MAX_RAW];
+static size_t raw_len;
+
+static void run_sanitize(void *ctx) {
+    (void)ctx;
+    ir_sanitizer_t sanitizer;
+    ir_sanitizer_init(&sanitizer, BENCH_GLITCH_US);
+    bench_sink = ir_sanitize(raw_buf, raw_len, clean_buf, &sanitizer);
+}
+
+static void run_repair(void *ctx) {
+    (void)ctx;
+    ir_repair_t repair;
+    memcpy(repaired_buf, raw_buf, raw_len * sizeof(uint16_t));
+    bench_sink = ir_capture_repair(repaired_buf, raw_len, MAX_RAW, philco_ac_check_timings, &repair);
+}
+
+static void load(size_t index) {
+    raw_len = ir_siglib_unpack(&ir_signals_raw_library, index, raw_buf, MAX_RAW);
+}
+
+void bench_suite_sanitize(void) {
+    const ir_siglib_t *lib = &ir_signals_raw_library;
+    uint8_t bytes[PHILCO_AC_FRAME_BYTES];
+    philco_ac_frame_t frame;
+    uint32_t hard_before = 0;
+    uint32_t hard_repaired = 0;
+    uint32_t hard_after = 0;
+    uint32_t flagged = 0;
+    char name[64];
+
+    for (size_t i = 0; i < lib->signal_count; i++) {
+        const char *signal = lib->signals[i].name;
+        load(i);
+        ir_repair_t repair;
+        memcpy(repaired_buf, raw_buf, raw_len * sizeof(uint16_t));
+        size_t len = ir_capture_repair(repaired_buf, raw_len, MAX_RAW, philco_ac_check_timings, &repair);
+        ir_sanitizer_t sanitizer;
+        ir_sanitizer_init(&sanitizer, BENCH_GLITCH_US);
+        size_t clean_len = ir_sanitize(repaired_buf, len, clean_buf, &sanitizer);
+
+        bool before = bench_philco_hard_decode(raw_buf, raw_len, bytes);
+        bool fixed = bench_philco_hard_decode(repaired_buf, len, bytes);
+        bool after = bench_philco_hard_decode(clean_buf, clean_len, bytes);
+        hard_before += before;
+        hard_repaired += fixed;
+        hard_after += after;
+        flagged += repair.count_mismatch;
+
+        if (strcmp(signal, "fan_2") == 0 || strcmp(signal, "fan_4") == 0) {
+            snprintf(name, sizeof(name), "sanitize.%s_repaired_hard_decodes", signal);
+            bench_check(name, fixed && after);
+        }
+
+        // Detalhe apenas para as capturas com defeito
+        if (before && !repair.count_mismatch) {
+            continue;
+        }
+        snprintf(name, sizeof(name), "sanitize.capture_%s_edge_shifts", signal);
+        bench_report(name, repair.edge_shifts, "count", BENCH_HIGHER_IS_BETTER);
+        snprintf(name, sizeof(name), "sanitize.capture_%s_marks_rebuilt", signal);
+        bench_report(name, repair.marks_rebuilt, "count", BENCH_HIGHER_IS_BETTER);
+        snprintf(name, sizeof(name), "sanitize.capture_%s_unordered", signal);
+        bench_report(name, repair.unordered, "count", BENCH_LOWER_IS_BETTER);
+        snprintf(name, sizeof(name), "sanitize.capture_%s_mismatch", signal);
+        bench_report(name, repair.count_mismatch, "bool", BENCH_LOWER_IS_BETTER);
+        snprintf(name, sizeof(name), "sanitize.capture_%s_soft_after", signal);
+        bench_report(name, philco_ac_decode(clean_buf, clean_len, &frame) ? 1 : 0, "bool", BENCH_HIGHER_IS_BETTER);
+    }
+
+    bench_report("sanitize.captures_hard_before", hard_before, "count", BENCH_HIGHER_IS_BETTER);
+    bench_report("sanitize.captures_hard_repaired", hard_repaired, "count", BENCH_HIGHER_IS_BETTER);
+    bench_report("sanitize.captures_hard_after", hard_after, "count", BENCH_HIGHER_IS_BETTER);
+    bench_report("sanitize.captures_flagged", flagged, "count", BENCH_LOWER_IS_BETTER);
+
+    // Custo por tempo processado: saneamento com a primeira captura (quadro
+    // Philco completo), reparo com a última (fan_4, a que mais perdeu marcas)
+    load(0);
+    bench_time("sanitize.per_sample", run_sanitize, NULL, raw_len);
+    load(lib->signal_count - 1);
+    bench_time("sanitize.repair_per_sample", run_repair, NULL, raw_len);
+}
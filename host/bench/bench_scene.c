@@ -0,0 +1,288 @@
+/**
+ * bench_scene.c - Motor de cenas (ir_scene.c)
+ *
+ * Mede o custo de CPU por instrução de bytecode, quanto tempo o laço
+ * principal fica preso com a demonstração antiga (envios separados por
+ * sleep_ms) e com a mesma sequência como cena, o erro de tempo dos envios da
+ * cena, várias cenas ao mesmo tempo dividindo o transmissor, a recusa dos
+ * quadros NEC pelo ir_scene_send_raw() e a gravação de uma sessão de controle
+ * real seguida da reprodução no relógio virtual.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "bench.h"
+#include "pico/stdlib.h"
+#include "hardware/timer.h"
+#include "host_sdk.h"
+#include "custom_ir.h"
+#include "ir_scene.h"
+
+#define BENCH_IR_PIN 2
+#define LOOP_TICK_MS 10             // Laço do Teste_protocolo.c
+#define MAX_FRAMES 64
+#define SESSION_FRAMES 12
+#define RECORD_CAPACITY 4096
+
+static ir_scheduler_t agenda;
+static ir_scene_engine_t engine;
+
+// Envios entregues pelo motor, com o instante de início
+static uint64_t frame_start_us[MAX_FRAMES];
+static ir_scene_frame_t frame_log[MAX_FRAMES];
+static size_t frame_count;
+
+static ir_scene_send_result_t logging_send(const ir_scene_frame_t *frame, void *ctx) {
+    ir_scene_send_result_t result = ir_scene_send_raw(frame, ctx);
+    if (result != IR_SCENE_SENT) {
+        return result;
+    }
+    if (frame_count < MAX_FRAMES) {
+        frame_start_us[frame_count] = time_us_64();
+        frame_log[frame_count] = *frame;
+        frame_count++;
+    }
+    return IR_SCENE_SENT;
+}
+
+static ir_scene_send_result_t null_send(const ir_scene_frame_t *frame, void *ctx) {
+    return IR_SCENE_SENT;
+}
+
+static void reset_engine(ir_scene_send_fn_t send) {
+    host_sdk_reset();
+    custom_ir_init(BENCH_IR_PIN);
+    ir_scheduler_init(&agenda, time_us_64() / 1000);
+    ir_scene_engine_init(&engine, &agenda, send, NULL);
+    frame_count = 0;
+}
+
+static bool any_running(void) {
+    for (int i = 0; i < IR_SCENE_MAX_RUNNING; i++) {
+        if (ir_scene_running(&engine, i)) {
+            return true;
+        }
+    }
+    return engine.queue_count > 0 || ir_send_busy();
+}
+
+/**
+ * Laço principal dormindo até o próximo evento da agenda (ou alarme do envio)
+ */
+static void run_until_idle(void) {
+    while (any_running()) {
+        ir_scheduler_advance(&agenda, time_us_64() / 1000);
+        if (ir_scene_pump(&engine)) {
+            continue;
+        }
+        uint64_t next_ms = ir_scheduler_next_event_ms(&agenda);
+        best_effort_wfe_or_timeout(next_ms == IR_SCHED_NO_EVENT ? time_us_64() + 1000 : next_ms * 1000);
+    }
+}
+
+static const ir_named_scene_t *find_scene(const char *name) {
+    const ir_named_scene_t *list;
+    size_t n = get_scenes(&list);
+    for (size_t i = 0; i < n; i++) {
+        if (strcmp(list[i].name, name) == 0) {
+            return &list[i];
+        }
+    }
+    return NULL;
+}
+
+// ---------------------------------------------------------------------------
+// Custo por instrução
+// ---------------------------------------------------------------------------
+
+static const uint8_t scene_loop[] = {
+    IR_SCENE_REPEAT(0),
+        IR_SCENE_SEND_AC(IR_ON),
+        IR_SCENE_WAIT_MS(1),
+    IR_SCENE_NEXT,
+    IR_SCENE_END
+};
+
+static void run_steps(void *ctx) {
+    uint32_t before = engine.steps;
+    while (engine.steps - before < 1000) {
+        ir_scheduler_advance(&agenda, ir_scheduler_next_event_ms(&agenda));
+        ir_scene_pump(&engine);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Demonstração: sleep_ms entre envios x cena
+// ---------------------------------------------------------------------------
+
+static double demo_blocking_ms(void) {
+    host_sdk_reset();
+    custom_ir_init(BENCH_IR_PIN);
+    uint64_t start = time_us_64();
+
+    // Sequência da antiga ir_demo()
+    send_ir_command(IR_ON);
+    sleep_ms(2000);
+    send_ir_command(IR_TEMP_22);
+    sleep_ms(2000);
+    send_ir_command(IR_FAN_1);
+    sleep_ms(2000);
+    send_ir_command(IR_OFF);
+    return (time_us_64() - start) / 1000.0;
+}
+
+/**
+ * A mesma sequência como cena, no laço de 10 ms do Teste_protocolo.c
+ *
+ * @param block_max_ms Maior tempo de uma volta do laço (sem o sleep)
+ * @return Maior erro entre o início de cada envio e o instante roteirizado
+ */
+static double demo_scene(double *block_max_ms) {
+    static const uint32_t offsets_ms[] = {0, 2000, 4000, 6000};
+    const ir_named_scene_t *demo = find_scene("scene_demo");
+
+    reset_engine(logging_send);
+    ir_scene_start(&engine, demo->code, demo->length);
+
+    *block_max_ms = 0;
+    while (any_running()) {
+        uint64_t t0 = time_us_64();
+        ir_scheduler_advance(&agenda, t0 / 1000);
+        ir_scene_pump(&engine);
+        double block = (time_us_64() - t0) / 1000.0;
+        if (block > *block_max_ms) {
+            *block_max_ms = block;
+        }
+        sleep_ms(LOOP_TICK_MS);
+    }
+
+    double error_max = 0;
+    for (size_t i = 0; i < frame_count && i < count_of(offsets_ms); i++) {
+        double error = (double)(frame_start_us[i] - frame_start_us[0]) / 1000.0 - offsets_ms[i];
+        error = error < 0 ? -error : error;
+        if (error > error_max) {
+            error_max = error;
+        }
+    }
+    return error_max;
+}
+
+// ---------------------------------------------------------------------------
+// Cenas simultâneas
+// ---------------------------------------------------------------------------
+
+static const uint8_t scene_burst[] = {
+    IR_SCENE_REPEAT(4),
+        IR_SCENE_SEND_AC(IR_FAN_1),
+        IR_SCENE_SEND_AC(IR_FAN_2),
+        IR_SCENE_WAIT_MS(100),
+    IR_SCENE_NEXT,
+    IR_SCENE_END
+};
+
+// Quadros NEC no meio de quadros do ar (sem transmissor NEC no custom_ir.c)
+static const uint8_t scene_nec[] = {
+    IR_SCENE_SEND_NEC(0x80, 0x12),
+    IR_SCENE_SEND_AC(IR_ON),
+    IR_SCENE_REPEAT(3),
+        IR_SCENE_SEND_NEC(0x80, 0x18),
+    IR_SCENE_NEXT,
+    IR_SCENE_END
+};
+
+// ---------------------------------------------------------------------------
+// Gravação e reprodução
+// ---------------------------------------------------------------------------
+
+static uint16_t noisy[1024];
+static uint8_t recorded[RECORD_CAPACITY];
+
+typedef struct {
+    int capture;                    // Índice esperado (-1 = quadro com ruído, gravado com os tempos)
+    size_t length;
+    uint32_t time_ms;
+} session_frame_t;
+
+void bench_suite_scene(void) {
+    uint32_t seed = 0x5CE0E000u;
+
+    reset_engine(null_send);
+    ir_scene_start(&engine, scene_loop, sizeof(scene_loop));
+    bench_time("scene.step", run_steps, NULL, 1000);
+
+    double block_max_ms;
+    double error_ms = demo_scene(&block_max_ms);
+    bench_report("scene.demo_blocking_ms", demo_blocking_ms(), "ms", BENCH_LOWER_IS_BETTER);
+    bench_report("scene.demo_loop_block_max_ms", block_max_ms, "ms", BENCH_LOWER_IS_BETTER);
+    bench_report("scene.demo_step_error_max_ms", error_ms, "ms", BENCH_LOWER_IS_BETTER);
+
+    // Demonstração + três rajadas disputando o transmissor
+    const ir_named_scene_t *demo = find_scene("scene_demo");
+    reset_engine(logging_send);
+    ir_scene_start(&engine, demo->code, demo->length);
+    for (int i = 0; i < IR_SCENE_MAX_RUNNING - 1; i++) {
+        ir_scene_start(&engine, scene_burst, sizeof(scene_burst));
+    }
+    run_until_idle();
+    bench_report("scene.concurrent_frames", frame_count, "count", BENCH_HIGHER_IS_BETTER);
+    bench_report("scene.concurrent_stalls", engine.stalls, "count", BENCH_LOWER_IS_BETTER);
+    bench_report("scene.concurrent_errors", engine.errors, "count", BENCH_LOWER_IS_BETTER);
+
+    // Os quatro quadros NEC são recusados e contados; o do ar sai
+    reset_engine(logging_send);
+    ir_scene_start(&engine, scene_nec, sizeof(scene_nec));
+    run_until_idle();
+    bench_check("scene.nec_frames_unsupported", engine.unsupported == 4 && frame_count == 1);
+
+    // Sessão: capturas conhecidas com pausas de 0,8 a 3 s; algumas com ruído
+    const ir_named_signal_t *signals;
+    size_t signal_count = get_captured_signals(&signals);
+    session_frame_t session[SESSION_FRAMES];
+    ir_scene_recorder_t recorder;
+    size_t raw_bytes = 0;
+    uint32_t t = 0;
+
+    ir_scene_record_init(&recorder, recorded, sizeof(recorded));
+    for (size_t i = 0; i < SESSION_FRAMES; i++) {
+        const ir_raw_signal_t *s = &signals[bench_rand(&seed) % signal_count].signal;
+        bool noise = i % 4 == 3;
+        for (size_t k = 0; k < s->length; k++) {
+            noisy[k] = s->data[k];
+        }
+        if (noise) {
+            noisy[s->length / 2] += 600;
+        }
+        session[i] = (session_frame_t){noise ? -1 : ir_scene_match_capture(s->data, s->length), s->length, t};
+        ir_scene_record_frame(&recorder, noisy, s->length, t);
+        raw_bytes += s->length * sizeof(uint16_t);
+        t += 800 + bench_rand(&seed) % 2200;
+    }
+    size_t recorded_len = ir_scene_record_finish(&recorder);
+    bench_report("scene.record_bytes", recorded_len, "bytes", BENCH_LOWER_IS_BETTER);
+    bench_report("scene.record_raw_bytes", raw_bytes, "bytes", BENCH_LOWER_IS_BETTER);
+    bench_report("scene.record_matched", recorder.matched, "count", BENCH_HIGHER_IS_BETTER);
+
+    reset_engine(logging_send);
+    ir_scene_start(&engine, recorded, recorded_len);
+    run_until_idle();
+
+    double gap_error_max = 0;
+    uint32_t frames_ok = 0;
+    for (size_t i = 0; i < frame_count && i < SESSION_FRAMES; i++) {
+        bool ok = session[i].capture >= 0
+                      ? frame_log[i].target == IR_SCENE_CAPTURE && frame_log[i].code == session[i].capture
+                      : frame_log[i].target == IR_SCENE_INLINE && frame_log[i].raw_length == session[i].length;
+        frames_ok += ok;
+        double error = (double)(frame_start_us[i] - frame_start_us[0]) / 1000.0 - session[i].time_ms;
+        error = error < 0 ? -error : error;
+        if (error > gap_error_max) {
+            gap_error_max = error;
+        }
+    }
+    bench_report("scene.replay_frames_ok", frames_ok, "count", BENCH_HIGHER_IS_BETTER);
+    bench_report("scene.replay_time_error_max_ms", gap_error_max, "ms", BENCH_LOWER_IS_BETTER);
+}
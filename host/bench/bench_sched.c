@@ -0,0 +1,316 @@
+/**
+ * bench_sched.c - Agenda de transmissões (ir_scheduler.c) contra a consulta
+ * periódica do emissor.c antigo
+ *
+ * Centenas de tarefas (periódicas, únicas e diárias) disparam um quadro IR
+ * cada, no relógio virtual. O modo consulta reproduz o laço antigo: a cada
+ * 100 ms verifica todas as tarefas, envia bloqueando e conta o intervalo a
+ * partir do fim do envio. O modo agenda usa ir_scheduler_t, uma fila de envio
+ * e send_raw_signal_async(), dormindo até o próximo evento.
+ *
+ * Jitter é o erro do intervalo entre dois envios da mesma tarefa periódica em
+ * relação ao período; atraso é o erro das tarefas únicas e diárias em relação
+ * ao instante pedido. Com um único transmissor, o que sobra de jitter no modo
+ * agenda vem da fila (quadros que vencem durante outro envio); o atraso da
+ * própria agenda sai em wheel_dispatch_late_max_ms. O custo de CPU é o tempo do host gasto decidindo o que
+ * enviar (varredura ou agenda), por segundo virtual.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "bench.h"
+#include "pico/stdlib.h"
+#include "hardware/timer.h"
+#include "host_sdk.h"
+#include "custom_ir.h"
+#include "ir_scheduler.h"
+
+#define BENCH_IR_PIN 2
+#define POLL_TICK_MS 100
+#define SIM_PERIODIC 200
+#define SIM_ONCE 40
+#define SIM_DAILY 16
+#define SIM_JOBS (SIM_PERIODIC + SIM_ONCE + SIM_DAILY)
+#define SIM_START_OF_DAY_MS (8u * 3600000u)       // Relógio de parede no início: 08:00
+#define MAX_SAMPLES 65536
+#define QUEUE_SIZE 512
+
+typedef struct {
+    ir_job_kind_t kind;
+    uint32_t period_ms;
+    uint64_t at_ms;              // Única/diária: instante pedido (ms desde o boot)
+
+    // Consulta
+    uint64_t last_ms;
+    bool done;
+
+    uint64_t last_start_us;      // Início do envio anterior (0 = nenhum)
+} sim_job_t;
+
+typedef struct {
+    double jitter_ms[MAX_SAMPLES];
+    size_t jitter_count;
+    double late_max_ms;
+    double cpu_ns;
+    uint32_t timer_wakeups;
+    uint32_t dispatch_late_max_ms;   // Agenda: atraso do callback em relação ao vencimento
+} sim_result_t;
+
+static sim_job_t jobs[SIM_JOBS];
+static sim_result_t poll_result;
+static sim_result_t sched_result;
+static ir_scheduler_t agenda;
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(double *values, size_t count, double p) {
+    if (count == 0) {
+        return 0;
+    }
+    qsort(values, count, sizeof(double), compare_double);
+    size_t index = (size_t)(p * (double)(count - 1) + 0.5);
+    return values[index];
+}
+
+static void build_jobs(uint64_t start_ms, uint32_t duration_ms) {
+    uint32_t seed = 0x5C4ED000u;
+    for (size_t i = 0; i < SIM_JOBS; i++) {
+        sim_job_t *job = &jobs[i];
+        *job = (sim_job_t){0};
+        if (i < SIM_PERIODIC) {
+            job->kind = IR_JOB_PERIODIC;
+            job->period_ms = i == 0 ? 7000 : 5000 + bench_rand(&seed) % 295000;
+        } else if (i < SIM_PERIODIC + SIM_ONCE) {
+            job->kind = IR_JOB_ONCE;
+            job->at_ms = start_ms + 1 + bench_rand(&seed) % duration_ms;
+        } else {
+            job->kind = IR_JOB_DAILY;
+            job->at_ms = start_ms + 1 + bench_rand(&seed) % (duration_ms - 1);
+        }
+    }
+}
+
+static void record_start(sim_result_t *r, sim_job_t *job, uint64_t due_us) {
+    uint64_t now = time_us_64();
+    if (job->kind == IR_JOB_PERIODIC) {
+        if (job->last_start_us && r->jitter_count < MAX_SAMPLES) {
+            double interval_ms = (double)(now - job->last_start_us) / 1000.0;
+            double error = interval_ms - job->period_ms;
+            r->jitter_ms[r->jitter_count++] = error < 0 ? -error : error;
+        }
+    } else {
+        double late = ((double)now - (double)due_us) / 1000.0;
+        if (late > r->late_max_ms) {
+            r->late_max_ms = late;
+        }
+    }
+    job->last_start_us = now;
+}
+
+// ---------------------------------------------------------------------------
+// Consulta a cada 100 ms com envio bloqueante (emissor.c antigo)
+// ---------------------------------------------------------------------------
+
+static void run_poll(const ir_raw_signal_t *frame, uint64_t end_ms, sim_result_t *r) {
+    uint64_t start_ms = time_us_64() / 1000;
+    for (size_t i = 0; i < SIM_JOBS; i++) {
+        jobs[i].last_ms = start_ms;
+    }
+
+    static size_t due[SIM_JOBS];
+
+    while (time_us_64() / 1000 < end_ms) {
+        uint64_t now_ms = time_us_64() / 1000;
+        size_t due_count = 0;
+
+        double t0 = now_ns();
+        for (size_t i = 0; i < SIM_JOBS; i++) {
+            sim_job_t *job = &jobs[i];
+            bool is_due;
+            if (job->kind == IR_JOB_PERIODIC) {
+                is_due = now_ms - job->last_ms >= job->period_ms;
+            } else {
+                is_due = !job->done && now_ms >= job->at_ms;
+            }
+            if (is_due) {
+                due[due_count++] = i;
+            }
+        }
+        r->cpu_ns += now_ns() - t0;
+
+        for (size_t d = 0; d < due_count; d++) {
+            sim_job_t *job = &jobs[due[d]];
+            record_start(r, job, job->at_ms * 1000);
+            send_raw_signal(frame->data, frame->length);
+            job->last_ms = time_us_64() / 1000;
+            job->done = true;
+        }
+        sleep_ms(POLL_TICK_MS);
+        r->timer_wakeups++;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Agenda com fila e envio assíncrono
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    size_t job;
+    uint64_t due_us;
+} queued_t;
+
+static queued_t queue[QUEUE_SIZE];
+static size_t queue_head;
+static size_t queue_tail;
+
+static void job_fired(ir_scheduler_t *s, ir_job_id_t id, uint32_t late_ms, void *ctx) {
+    sim_job_t *job = ctx;
+    if (late_ms > sched_result.dispatch_late_max_ms) {
+        sched_result.dispatch_late_max_ms = late_ms;
+    }
+    queue[queue_tail % QUEUE_SIZE] = (queued_t){(size_t)(job - jobs), (s->now_ms - late_ms) * 1000};
+    queue_tail++;
+}
+
+static void run_sched(const ir_raw_signal_t *frame, uint64_t end_ms, sim_result_t *r) {
+    uint64_t start_ms = time_us_64() / 1000;
+    queue_head = queue_tail = 0;
+
+    ir_scheduler_init(&agenda, start_ms);
+    ir_scheduler_set_wall_clock(&agenda, SIM_START_OF_DAY_MS, 1);
+    for (size_t i = 0; i < SIM_JOBS; i++) {
+        sim_job_t *job = &jobs[i];
+        switch (job->kind) {
+            case IR_JOB_PERIODIC:
+                ir_scheduler_every(&agenda, job->period_ms, job_fired, job);
+                break;
+            case IR_JOB_ONCE:
+                ir_scheduler_at(&agenda, job->at_ms, job_fired, job);
+                break;
+            default:
+                ir_scheduler_daily(&agenda, SIM_START_OF_DAY_MS + (uint32_t)(job->at_ms - start_ms),
+                                   IR_SCHED_EVERY_DAY, job_fired, job);
+                break;
+        }
+    }
+
+    uint64_t next_ms = ir_scheduler_next_event_ms(&agenda);
+    while (time_us_64() / 1000 < end_ms) {
+        // Acordadas pelos alarmes do envio não passam pela agenda
+        if (time_us_64() / 1000 >= next_ms) {
+            double t0 = now_ns();
+            ir_scheduler_advance(&agenda, time_us_64() / 1000);
+            next_ms = ir_scheduler_next_event_ms(&agenda);
+            r->cpu_ns += now_ns() - t0;
+        }
+
+        if (queue_head != queue_tail && !ir_send_busy()) {
+            queued_t q = queue[queue_head % QUEUE_SIZE];
+            queue_head++;
+            record_start(r, &jobs[q.job], q.due_us);
+            send_raw_signal_async(frame->data, frame->length);
+            continue;
+        }
+
+        // Os alarmes do envio acordam antes do timeout
+        uint64_t wake_ms = next_ms < end_ms ? next_ms : end_ms;
+        if (best_effort_wfe_or_timeout(wake_ms * 1000)) {
+            r->timer_wakeups++;
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Custo das operações com a agenda carregada
+// ---------------------------------------------------------------------------
+
+#define RESIDENT_JOBS 256
+
+static void noop_job(ir_scheduler_t *s, ir_job_id_t id, uint32_t late_ms, void *ctx) {
+    bench_sink += late_ms;
+}
+
+static void load_resident(uint32_t seed) {
+    ir_scheduler_init(&agenda, 0);
+    for (int i = 0; i < RESIDENT_JOBS; i++) {
+        ir_scheduler_every(&agenda, 1 + bench_rand(&seed) % 600000, noop_job, NULL);
+    }
+}
+
+static void run_insert_cancel(void *ctx) {
+    uint32_t *seed = ctx;
+    for (int i = 0; i < 1000; i++) {
+        ir_job_id_t id = ir_scheduler_at(&agenda, agenda.now_ms + 1 + bench_rand(seed) % 3600000, noop_job, NULL);
+        ir_scheduler_cancel(&agenda, id);
+    }
+}
+
+static void run_fire(void *ctx) {
+    uint32_t *fired = ctx;
+    uint32_t before = agenda.fired;
+    while (agenda.fired - before < 1000) {
+        ir_scheduler_advance(&agenda, ir_scheduler_next_event_ms(&agenda));
+    }
+    *fired += agenda.fired - before;
+}
+
+static void report_result(const char *mode, sim_result_t *r, double seconds) {
+    char name[64];
+    snprintf(name, sizeof(name), "sched.%s_jitter_p50_ms", mode);
+    bench_report(name, percentile(r->jitter_ms, r->jitter_count, 0.50), "ms", BENCH_LOWER_IS_BETTER);
+    snprintf(name, sizeof(name), "sched.%s_jitter_p99_ms", mode);
+    bench_report(name, percentile(r->jitter_ms, r->jitter_count, 0.99), "ms", BENCH_LOWER_IS_BETTER);
+    snprintf(name, sizeof(name), "sched.%s_jitter_max_ms", mode);
+    bench_report(name, percentile(r->jitter_ms, r->jitter_count, 1.0), "ms", BENCH_LOWER_IS_BETTER);
+    snprintf(name, sizeof(name), "sched.%s_late_max_ms", mode);
+    bench_report(name, r->late_max_ms, "ms", BENCH_LOWER_IS_BETTER);
+    snprintf(name, sizeof(name), "sched.%s_cpu_ns_per_s", mode);
+    bench_report(name, r->cpu_ns / seconds, "ns/s", BENCH_LOWER_IS_BETTER);
+    snprintf(name, sizeof(name), "sched.%s_timer_wakeups_per_s", mode);
+    bench_report(name, r->timer_wakeups / seconds, "1/s", BENCH_LOWER_IS_BETTER);
+}
+
+void bench_suite_sched(void) {
+    uint32_t duration_ms = bench_quick ? 600000 : 3600000;
+    const ir_raw_signal_t *frame = get_raw_signal(IR_ON);
+
+    build_jobs(0, duration_ms);
+    host_sdk_reset();
+    custom_ir_init(BENCH_IR_PIN);
+    poll_result = (sim_result_t){0};
+    run_poll(frame, duration_ms, &poll_result);
+
+    build_jobs(0, duration_ms);
+    host_sdk_reset();
+    custom_ir_init(BENCH_IR_PIN);
+    sched_result = (sim_result_t){0};
+    run_sched(frame, duration_ms, &sched_result);
+
+    report_result("poll", &poll_result, duration_ms / 1000.0);
+    report_result("wheel", &sched_result, duration_ms / 1000.0);
+    bench_report("sched.wheel_dispatch_late_max_ms", sched_result.dispatch_late_max_ms, "ms",
+                 BENCH_LOWER_IS_BETTER);
+
+    uint32_t seed = 0x5C4ED001u;
+    load_resident(seed);
+    bench_time("sched.insert_cancel_256", run_insert_cancel, &seed, 1000);
+
+    uint32_t fired = 0;
+    load_resident(seed);
+    bench_time("sched.fire_256", run_fire, &fired, 1000);
+}
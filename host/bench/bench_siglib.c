@@ -0,0 +1,90 @@
+/**
+ * bench_siglib.c - Tamanho e leitura da biblioteca compactada de sinais
+ *
+ * Compara os bytes de flash dos tempos das capturas como vetores uint16_t
+ * (antes) com a biblioteca de ir_siglib.h em custom_ir.c (depois), e com a
+ * mesma biblioteca sem perda (quantum 1) e guardando só os níveis (quantum
+ * 0). Confere que o empacotamento exato devolve os mesmos tempos e mede o
+ * custo de ler um tempo em fluxo, que é o que o alarme do envio assíncrono
+ * paga a cada borda.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <string.h>
+
+#include "bench.h"
+#include "pico/stdlib.h"
+#include "custom_ir.h"
+#include "ir_siglib.h"
+
+static ir_siglib_builder_t builder;
+static ir_siglib_input_t inputs[IR_SIGLIB_MAX_SIGNALS];
+
+static void run_read(void *ctx) {
+    const ir_siglib_t *lib = ctx;
+    uint32_t sum = 0;
+    for (size_t s = 0; s < lib->signal_count; s++) {
+        ir_siglib_reader_t r;
+        ir_siglib_open(&r, lib, s);
+        while (ir_siglib_remaining(&r) > 0) {
+            sum += ir_siglib_next(&r);
+        }
+    }
+    bench_sink += sum;
+}
+
+static void run_array(void *ctx) {
+    (void)ctx;
+    uint32_t sum = 0;
+    for (size_t s = 0; inputs[s].data; s++) {
+        for (size_t i = 0; i < inputs[s].length; i++) {
+            sum += inputs[s].data[i];
+        }
+    }
+    bench_sink += sum;
+}
+
+void bench_suite_siglib(void) {
+    const ir_siglib_t *lib = get_signal_library();
+    const ir_named_signal_t *signals;
+    size_t count = get_captured_signals(&signals);
+    size_t raw_bytes = 0;
+    size_t timings = 0;
+
+    for (size_t s = 0; s < count; s++) {
+        inputs[s].name = signals[s].name;
+        inputs[s].data = signals[s].signal.data;
+        inputs[s].length = signals[s].signal.length;
+        raw_bytes += signals[s].signal.length * sizeof(uint16_t);
+        timings += signals[s].signal.length;
+    }
+
+    size_t packed_bytes = ir_siglib_size(lib);
+    bench_report("siglib.raw_bytes", raw_bytes, "bytes", BENCH_LOWER_IS_BETTER);
+    bench_report("siglib.flash_bytes", packed_bytes, "bytes", BENCH_LOWER_IS_BETTER);
+    bench_report("siglib.ratio", (double)raw_bytes / packed_bytes, "x", BENCH_HIGHER_IS_BETTER);
+
+    // Sem perda: empacotar e expandir tem de devolver os mesmos tempos
+    uint32_t mismatch = 0;
+    if (ir_siglib_pack(&builder, inputs, count, 1)) {
+        bench_report("siglib.exact_bytes", ir_siglib_size(&builder.lib), "bytes", BENCH_LOWER_IS_BETTER);
+        for (size_t s = 0; s < count; s++) {
+            uint16_t out[IR_SIGLIB_MAX_BASE];
+            size_t n = ir_siglib_unpack(&builder.lib, s, out, IR_SIGLIB_MAX_BASE);
+            mismatch += n != inputs[s].length || memcmp(out, inputs[s].data, n * sizeof(uint16_t)) != 0;
+        }
+    } else {
+        mismatch = (uint32_t)count;
+    }
+    bench_report("siglib.exact_mismatch", mismatch, "signals", BENCH_LOWER_IS_BETTER);
+
+    // Só os níveis: sinais limpos, só as diferenças de bits ficam por sinal
+    if (ir_siglib_pack(&builder, inputs, count, 0)) {
+        bench_report("siglib.levels_only_bytes", ir_siglib_size(&builder.lib), "bytes", BENCH_LOWER_IS_BETTER);
+    }
+
+    bench_time("siglib.read_per_timing", run_read, (void *)lib, timings);
+    bench_time("siglib.array_per_timing", run_array, NULL, timings);
+}
@@ -0,0 +1,349 @@
+/**
+ * bench_slottx.c - Transmissor PIO de RC5, RC6 e SIRC no PIO simulado
+ *
+ * Envia quadros aleatórios de cada protocolo pelo slot_transmit (as duas
+ * state machines executadas instrução a instrução pelo shim), com teclas
+ * novas e repetições misturadas, e registra as bordas no pino pelo hook do
+ * shim. Para cada quadro:
+ *
+ *  - monta a forma de onda esperada direto da especificação (unidades com
+ *    marca ou silêncio) e passa as bordas pelo analisador de ir_txcheck.c;
+ *  - arredonda os tempos demodulados para unidades e confere com a mesma
+ *    sequência, o que também confere o toggle do RC5/RC6.
+ *
+ * Com carrier, a marca medida termina na última descida (ir_txcheck.h), então
+ * as marcas saem meio período mais curtas e os espaços meio período mais
+ * longos: cerca de 14 us a 36 kHz e 12,5 us a 40 kHz.
+ *
+ * Também mede o intervalo entre um quadro e a sua repetição, as palavras
+ * escritas no FIFO por quadro contra os tempos de um array equivalente e o
+ * custo de montar as palavras.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+#include "host_sdk.h"
+#include "ir_txcheck.h"
+#include "slot_transmit.h"
+
+#define IR_TX_PIN 3
+#define MAX_EDGES 8192
+#define MAX_UNITS 128
+#define MAX_TIMINGS 128
+
+typedef enum {
+    PROTO_RC5,
+    PROTO_RC6,
+    PROTO_SIRC
+} proto_t;
+
+typedef struct {
+    const char *name;
+    slot_tx_config_t config;
+    uint32_t period_units;              // Início a início das repetições
+} proto_info_t;
+
+static const proto_info_t protos[] = {
+    {"rc5", SLOT_TX_CONFIG_RC5, 128},
+    {"rc6", SLOT_TX_CONFIG_RC6, 240},
+    {"sirc", SLOT_TX_CONFIG_SIRC, 75},
+};
+
+typedef struct {
+    uint8_t address;
+    uint8_t command;
+    uint16_t sirc_address;
+    uint sirc_bits;
+    bool repeat;
+    bool toggle;                        // Toggle esperado (RC5/RC6)
+} frame_t;
+
+static uint32_t edges[MAX_EDGES];
+static ir_txcheck_recorder_t recorder;
+
+static void record_edge(uint gpio, bool level, uint64_t time_us, void *ctx) {
+    (void)ctx;
+    if (gpio == IR_TX_PIN) {
+        ir_txcheck_record(&recorder, level, (uint32_t)time_us);
+    }
+}
+
+static void put(uint8_t *units, size_t *n, bool mark, size_t count) {
+    for (size_t i = 0; i < count && *n < MAX_UNITS; i++) {
+        units[(*n)++] = mark;
+    }
+}
+
+/**
+ * Forma de onda esperada em unidades, pela especificação de cada protocolo
+ */
+static size_t expected_units(proto_t proto, const frame_t *f, uint8_t *units) {
+    size_t n = 0;
+    switch (proto) {
+        case PROTO_RC5: {
+            // S1, S2 (RC5X), toggle, A4..A0, C5..C0; 1 = silêncio e marca
+            uint32_t bits = 1u << 13 | (uint32_t)!(f->command & 0x40) << 12 | (uint32_t)f->toggle << 11 |
+                            (uint32_t)(f->address & 0x1f) << 6 | (f->command & 0x3f);
+            for (int i = 13; i >= 0; i--) {
+                bool one = (bits >> i) & 1;
+                put(units, &n, !one, 1);
+                put(units, &n, one, 1);
+            }
+            break;
+        }
+        case PROTO_RC6: {
+            // Cabeçalho 6 + 2, início 1, modo 000, toggle duplo, A7..A0, C7..C0
+            put(units, &n, true, 6);
+            put(units, &n, false, 2);
+            put(units, &n, true, 1);
+            put(units, &n, false, 1);
+            for (int i = 0; i < 3; i++) {
+                put(units, &n, false, 1);
+                put(units, &n, true, 1);
+            }
+            put(units, &n, f->toggle, 2);
+            put(units, &n, !f->toggle, 2);
+            uint16_t data = (uint16_t)(f->address << 8 | f->command);
+            for (int i = 15; i >= 0; i--) {
+                bool one = (data >> i) & 1;
+                put(units, &n, one, 1);
+                put(units, &n, !one, 1);
+            }
+            break;
+        }
+        case PROTO_SIRC: {
+            // Cabeçalho 4 + 1; bits a partir do menos significativo, 1 = marca dupla
+            put(units, &n, true, 4);
+            put(units, &n, false, 1);
+            uint32_t data = (uint32_t)(f->command & 0x7f) | (uint32_t)f->sirc_address << 7;
+            for (uint i = 0; i < f->sirc_bits; i++) {
+                put(units, &n, true, (data >> i) & 1 ? 2 : 1);
+                put(units, &n, false, 1);
+            }
+            break;
+        }
+    }
+
+    // A medição começa na primeira marca e termina na última
+    while (n > 0 && !units[n - 1]) {
+        n--;
+    }
+    size_t first = 0;
+    while (first < n && !units[first]) {
+        first++;
+    }
+    memmove(units, units + first, n - first);
+    return n - first;
+}
+
+static size_t units_to_timings(const uint8_t *units, size_t n, float unit_us, uint16_t *timings) {
+    size_t count = 0;
+    for (size_t i = 0; i < n;) {
+        size_t run = 1;
+        while (i + run < n && units[i + run] == units[i]) {
+            run++;
+        }
+        timings[count++] = (uint16_t)lroundf(run * unit_us);
+        i += run;
+    }
+    return count;
+}
+
+static size_t timings_to_units(const uint16_t *timings, size_t count, float unit_us, uint8_t *units) {
+    size_t n = 0;
+    for (size_t i = 0; i < count; i++) {
+        put(units, &n, (i & 1) == 0, (size_t)lroundf(timings[i] / unit_us));
+    }
+    return n;
+}
+
+static size_t encode(proto_t proto, slot_tx_t *tx, const frame_t *f, uint32_t *words) {
+    switch (proto) {
+        case PROTO_RC5:
+            return slot_tx_encode_rc5(tx, f->address, f->command, f->repeat, words);
+        case PROTO_RC6:
+            return slot_tx_encode_rc6(tx, f->address, f->command, f->repeat, words);
+        default:
+            return slot_tx_encode_sirc(tx, f->sirc_bits, f->command, f->sirc_address, words);
+    }
+}
+
+static void random_frame(proto_t proto, uint32_t *seed, frame_t *f, bool *toggle) {
+    uint32_t r = bench_rand(seed);
+    f->command = (uint8_t)r;
+    f->repeat = (r >> 8) % 3 == 0;
+    if (proto == PROTO_RC5) {
+        f->address = (uint8_t)((r >> 10) & 0x1f);
+        f->command &= 0x7f;
+    } else {
+        f->address = (uint8_t)(r >> 10);
+    }
+    static const uint sirc_bits[] = {12, 15, 20};
+    f->sirc_bits = sirc_bits[(r >> 18) % 3];
+    f->command &= proto == PROTO_SIRC ? 0x7f : 0xff;
+    f->sirc_address = (uint16_t)((r >> 20) & ((1u << (f->sirc_bits - 7)) - 1));
+
+    if (!f->repeat) {
+        *toggle = !*toggle;
+    }
+    f->toggle = *toggle;
+}
+
+/**
+ * Tempo entre a primeira subida e a primeira subida depois de um silêncio
+ * maior que min_gap_us
+ */
+static int32_t repeat_period(uint32_t min_gap_us) {
+    uint32_t first = 0;
+    uint32_t last = 0;
+    bool started = false;
+    for (size_t i = 0; i < recorder.count; i++) {
+        uint32_t t = edges[i] >> 1;
+        if ((edges[i] & 1) == 0) {
+            last = t;
+            continue;
+        }
+        if (!started) {
+            first = t;
+            started = true;
+        } else if (t - last > min_gap_us) {
+            return (int32_t)(t - first);
+        }
+    }
+    return 0;
+}
+
+typedef struct {
+    proto_t proto;
+    slot_tx_t tx;
+    frame_t frame;
+} encode_ctx_t;
+
+static void run_encode(void *ctx) {
+    encode_ctx_t *e = ctx;
+    uint32_t words[SLOT_TX_MAX_WORDS];
+    size_t n = encode(e->proto, &e->tx, &e->frame, words);
+    bench_sink += words[n - 1];
+}
+
+void bench_suite_slottx(void) {
+    static uint8_t want[MAX_UNITS];
+    static uint8_t got[MAX_UNITS];
+    static uint16_t intended[MAX_TIMINGS];
+    static uint16_t measured[MAX_TIMINGS];
+    char name[64];
+    uint32_t frames = bench_quick ? 20 : 60;
+    ir_txcheck_recorder_init(&recorder, edges, MAX_EDGES);
+
+    for (proto_t p = PROTO_RC5; p <= PROTO_SIRC; p++) {
+        const proto_info_t *info = &protos[p];
+        float unit_us = 1e6f * info->config.unit_cycles / info->config.carrier_hz;
+        uint32_t period_us = (uint32_t)lroundf(info->period_units * unit_us);
+
+        host_sdk_reset();
+        slot_tx_t tx;
+        slot_tx_init(&tx, pio0, IR_TX_PIN, &info->config);
+        for (uint sm = 0; sm < 4; sm++) {
+            host_pio_simulate(pio0, sm, pio_sm_is_claimed(pio0, sm));
+        }
+        host_sdk_set_edge_hook(record_edge, NULL);
+        host_time_advance_us(1000);
+
+        uint32_t seed = 0x510745u + p;
+        bool toggle = false;
+        uint32_t unit_errors = 0;
+        uint32_t count_mismatches = 0;
+        uint32_t compared_total = 0;
+        int32_t error_worst = 0;
+        double error_abs_sum = 0;
+        uint64_t words = 0;
+        uint64_t timings = 0;
+        float carrier_hz = 0;
+        float duty_pct = 0;
+        frame_t f;
+
+        for (uint32_t i = 0; i < frames; i++) {
+            random_frame(p, &seed, &f, &toggle);
+            ir_txcheck_recorder_clear(&recorder);
+            uint32_t frame_words[SLOT_TX_MAX_WORDS];
+            size_t n = encode(p, &tx, &f, frame_words);
+            slot_tx_send_words(&tx, frame_words, n);
+            host_time_advance_us(period_us + 1000);
+            words += n;
+
+            size_t units = expected_units(p, &f, want);
+            size_t length = units_to_timings(want, units, unit_us, intended);
+            timings += length;
+
+            ir_txcheck_report_t r;
+            if (!ir_txcheck_analyze(edges, recorder.count, intended, length, 0, &r)) {
+                count_mismatches++;
+                unit_errors++;
+                continue;
+            }
+            size_t compared = r.measured < r.intended ? r.measured : r.intended;
+            compared_total += compared;
+            count_mismatches += r.measured != r.intended;
+            error_abs_sum += r.error_abs_mean_us * compared;
+            int32_t worst = -r.error_min_us > r.error_max_us ? r.error_min_us : r.error_max_us;
+            if (abs(worst) > abs(error_worst)) {
+                error_worst = worst;
+            }
+            carrier_hz = r.carrier_hz;
+            duty_pct = r.duty_pct;
+
+            size_t m = bench_demodulate(edges, recorder.count, measured, MAX_TIMINGS);
+            size_t got_units = timings_to_units(measured, m, unit_us, got);
+            unit_errors += got_units != units || memcmp(got, want, units) != 0;
+        }
+
+        // Quadro e repetição em seguida: o silêncio do fim separa os inícios
+        ir_txcheck_recorder_clear(&recorder);
+        f.repeat = false;
+        uint32_t frame_words[SLOT_TX_MAX_WORDS];
+        size_t n = encode(p, &tx, &f, frame_words);
+        slot_tx_send_words(&tx, frame_words, n);
+        f.repeat = true;
+        n = encode(p, &tx, &f, frame_words);
+        slot_tx_send_words(&tx, frame_words, n);
+        host_time_advance_us(2 * period_us + 1000);
+        int32_t period_error = repeat_period((uint32_t)(4 * unit_us)) - (int32_t)period_us;
+        host_sdk_set_edge_hook(NULL, NULL);
+
+        snprintf(name, sizeof(name), "slottx.%s_unit_errors", info->name);
+        bench_report(name, unit_errors, "count", BENCH_LOWER_IS_BETTER);
+        snprintf(name, sizeof(name), "slottx.%s_count_mismatches", info->name);
+        bench_report(name, count_mismatches, "count", BENCH_LOWER_IS_BETTER);
+        snprintf(name, sizeof(name), "slottx.%s_error_worst_us", info->name);
+        bench_report(name, abs(error_worst), "us", BENCH_LOWER_IS_BETTER);
+        snprintf(name, sizeof(name), "slottx.%s_error_abs_mean_us", info->name);
+        bench_report(name, compared_total ? error_abs_sum / compared_total : 0, "us", BENCH_LOWER_IS_BETTER);
+        snprintf(name, sizeof(name), "slottx.%s_carrier_error_hz", info->name);
+        bench_report(name, fabsf(carrier_hz - (float)info->config.carrier_hz), "Hz", BENCH_LOWER_IS_BETTER);
+        snprintf(name, sizeof(name), "slottx.%s_duty_error_pct", info->name);
+        bench_report(name, fabsf(duty_pct - 50.0f), "%", BENCH_LOWER_IS_BETTER);
+        snprintf(name, sizeof(name), "slottx.%s_repeat_period_error_us", info->name);
+        bench_report(name, abs(period_error), "us", BENCH_LOWER_IS_BETTER);
+
+        // Trabalho da CPU por quadro: palavras no FIFO contra tempos de um array
+        snprintf(name, sizeof(name), "slottx.%s_fifo_words_per_frame", info->name);
+        bench_report(name, (double)words / frames, "count", BENCH_LOWER_IS_BETTER);
+        snprintf(name, sizeof(name), "slottx.%s_array_timings_per_frame", info->name);
+        bench_report(name, (double)timings / frames, "count", BENCH_LOWER_IS_BETTER);
+    }
+
+    static encode_ctx_t encode_ctx = {
+        .proto = PROTO_RC6,
+        .frame = {.address = 0x00, .command = 0x0c, .repeat = false},
+    };
+    bench_time("slottx.encode_rc6_frame", run_encode, &encode_ctx, 1);
+}
@@ -0,0 +1,163 @@
+/**
+ * bench_txcheck.c - Fidelidade de tempo de cada motor de transmissão
+ *
+ * Registra as bordas que cada motor produz no pino (hook de bordas do shim)
+ * e passa pelo analisador de ir_txcheck.c, contra os sinais pré-definidos de
+ * custom_ir.c:
+ *
+ *  - sync: send_raw_signal(), carrier PWM com sleep_us() entre os tempos;
+ *  - async: send_raw_signal_async(), um alarme por transição;
+ *  - bitbang: o laço do emissor.c original, carrier por busy-wait.
+ *
+ * Os três rodam com o mesmo overshoot de espera (SLEEP_OVERSHOOT_US por
+ * chamada de sleep/busy-wait), que é o que separa um motor que acumula
+ * atrasos de um que agenda pelo vencimento anterior. O motor de PWM só
+ * produz o envelope; frequência e duty dele vêm da configuração do slice.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "pico/stdlib.h"
+#include "hardware/pwm.h"
+#include "host_sdk.h"
+#include "custom_ir.h"
+#include "ir_txcheck.h"
+
+#define IR_GPIO_PIN 2               // PWM (custom_ir.c)
+#define IR_TX_PIN 16                // Bit-banging (emissor.c)
+#define SLEEP_OVERSHOOT_US 4
+#define MAX_EDGES 8192
+
+typedef enum {
+    ENGINE_SYNC,
+    ENGINE_ASYNC,
+    ENGINE_BITBANG
+} engine_t;
+
+static const char *engine_names[] = {"sync", "async", "bitbang"};
+
+static uint32_t edges[MAX_EDGES];
+static ir_txcheck_recorder_t recorder;
+static uint record_pin;
+
+static void record_edge(uint gpio, bool level, uint64_t time_us, void *ctx) {
+    (void)ctx;
+    if (gpio == record_pin) {
+        ir_txcheck_record(&recorder, level, (uint32_t)time_us);
+    }
+}
+
+static void transmit(engine_t engine, const ir_raw_signal_t *s) {
+    switch (engine) {
+        case ENGINE_SYNC:
+            send_raw_signal(s->data, s->length);
+            break;
+        case ENGINE_ASYNC:
+            send_raw_signal_async(s->data, s->length);
+            while (ir_send_busy()) {
+                host_time_advance_to(host_time_next_alarm());
+            }
+            break;
+        case ENGINE_BITBANG:
+            bench_emissor_transmit(IR_TX_PIN, s->data, s->length);
+            break;
+    }
+}
+
+typedef struct {
+    uint32_t timings;
+    uint32_t timings_within;        // |erro| <= IR_TXCHECK_TOLERANCE_US
+    uint32_t count_mismatches;
+    int32_t error_worst_us;         // Maior erro em módulo (com sinal)
+    double error_abs_sum_us;
+    int32_t drift_worst_us;
+    float carrier_hz;
+    float duty_pct;
+} engine_result_t;
+
+static void run_engine(engine_t engine, engine_result_t *out) {
+    memset(out, 0, sizeof(*out));
+
+    for (ir_signal_type_t c = IR_OFF; c <= IR_FAN_2; c++) {
+        const ir_raw_signal_t *s = get_raw_signal(c);
+
+        host_sdk_reset();
+        host_sdk_set_sleep_overhead_us(SLEEP_OVERSHOOT_US);
+        if (engine == ENGINE_BITBANG) {
+            gpio_init(IR_TX_PIN);
+            gpio_set_dir(IR_TX_PIN, GPIO_OUT);
+            record_pin = IR_TX_PIN;
+        } else {
+            custom_ir_init(IR_GPIO_PIN);
+            record_pin = IR_GPIO_PIN;
+        }
+        ir_txcheck_recorder_clear(&recorder);
+        host_sdk_set_edge_hook(record_edge, NULL);
+        host_time_advance_us(1000);
+
+        transmit(engine, s);
+        host_sdk_set_edge_hook(NULL, NULL);
+
+        ir_txcheck_report_t r;
+        if (!ir_txcheck_analyze(edges, recorder.count, s->data, s->length, 0, &r)) {
+            out->count_mismatches++;
+            continue;
+        }
+        size_t compared = r.measured < r.intended ? r.measured : r.intended;
+        out->timings += compared;
+        out->timings_within += r.within_tolerance;
+        out->count_mismatches += r.measured != r.intended;
+        out->error_abs_sum_us += r.error_abs_mean_us * compared;
+
+        int32_t worst = -r.error_min_us > r.error_max_us ? r.error_min_us : r.error_max_us;
+        if (abs(worst) > abs(out->error_worst_us)) {
+            out->error_worst_us = worst;
+        }
+        if (abs(r.drift_final_us) > abs(out->drift_worst_us)) {
+            out->drift_worst_us = r.drift_final_us;
+        }
+        if (r.carrier_cycles > 0) {
+            out->carrier_hz = r.carrier_hz;
+            out->duty_pct = r.duty_pct;
+        } else {
+            uint slice = pwm_gpio_to_slice_num(IR_GPIO_PIN);
+            out->carrier_hz = host_pwm_frequency_hz(slice);
+            out->duty_pct = 100.0f * host_pwm_duty(slice, PWM_CHAN_A);
+        }
+    }
+}
+
+void bench_suite_txcheck(void) {
+    char name[64];
+    ir_txcheck_recorder_init(&recorder, edges, MAX_EDGES);
+
+    for (engine_t e = ENGINE_SYNC; e <= ENGINE_BITBANG; e++) {
+        engine_result_t r;
+        run_engine(e, &r);
+
+        snprintf(name, sizeof(name), "txcheck.%s_error_worst_us", engine_names[e]);
+        bench_report(name, abs(r.error_worst_us), "us", BENCH_LOWER_IS_BETTER);
+        snprintf(name, sizeof(name), "txcheck.%s_error_abs_mean_us", engine_names[e]);
+        bench_report(name, r.timings ? r.error_abs_sum_us / r.timings : 0, "us", BENCH_LOWER_IS_BETTER);
+        snprintf(name, sizeof(name), "txcheck.%s_within_5us_pct", engine_names[e]);
+        bench_report(name, r.timings ? 100.0 * r.timings_within / r.timings : 0, "%", BENCH_HIGHER_IS_BETTER);
+        snprintf(name, sizeof(name), "txcheck.%s_drift_worst_us", engine_names[e]);
+        bench_report(name, abs(r.drift_worst_us), "us", BENCH_LOWER_IS_BETTER);
+        snprintf(name, sizeof(name), "txcheck.%s_count_mismatches", engine_names[e]);
+        bench_report(name, r.count_mismatches, "count", BENCH_LOWER_IS_BETTER);
+
+        // Distância até os 38 kHz e 50% nominais
+        snprintf(name, sizeof(name), "txcheck.%s_carrier_error_hz", engine_names[e]);
+        bench_report(name, r.carrier_hz > 38000.0f ? r.carrier_hz - 38000.0f : 38000.0f - r.carrier_hz, "Hz",
+                     BENCH_LOWER_IS_BETTER);
+        snprintf(name, sizeof(name), "txcheck.%s_duty_error_pct", engine_names[e]);
+        bench_report(name, fabsf(r.duty_pct - 50.0f), "%", BENCH_LOWER_IS_BETTER);
+    }
+}
@@ -0,0 +1,233 @@
+/**
+ * bench_verify.c - Envio verificado (ir_verify.c) sobre um canal com perdas
+ *
+ * Reproduz o laço do Philco.c no relógio virtual: os comandos saem pelo FIFO
+ * TX do PIO simulado, ocupam o ar por um quadro NEC e voltam pelo FIFO RX,
+ * passando pela supressão de eco; o eco próprio confirma a entrega. O canal
+ * perde quadros em rajadas (modelo de Gilbert-Elliott: um estado bom com
+ * poucas perdas e um ruim, como uma pessoa passando na frente do LED), com um
+ * modelo por canal de transmissão.
+ *
+ * Mede a taxa de entrega sem repetição (uma tentativa, o "envia e torce" de
+ * antes) e com repetição, as tentativas e a latência por entrega e as
+ * repetições desperdiçadas (quadro repetido depois que uma cópia já tinha
+ * chegado ao receptor).
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <stdio.h>
+
+#include "bench.h"
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+#include "hardware/timer.h"
+#include "host_sdk.h"
+#include "nec_transmit.h"
+#include "nec_receive.h"
+#include "ir_commands.h"
+#include "ir_echo.h"
+#include "ir_verify.h"
+
+#define TX_PIN 16
+#define RX_PIN 15
+#define RX_LATENCY_US 600           // Do fim do quadro até o push no FIFO RX
+#define LOOP_TICK_US 1000           // getchar_timeout_us(1000) do Philco.c
+#define CHANNELS 2
+#define MAX_AIR 16
+
+typedef struct {
+    uint32_t loss_good_pct;         // Perda no estado bom
+    uint32_t loss_bad_pct;          // Perda no estado ruim
+    uint32_t enter_bad_pct;         // Chance de passar ao estado ruim, por quadro
+    uint32_t leave_bad_pct;         // Chance de voltar ao estado bom, por quadro
+} channel_model_t;
+
+static const channel_model_t models[CHANNELS] = {
+    {2, 60, 3, 30},                 // LED apontado para o aparelho
+    {15, 85, 10, 20},               // LED por reflexão na parede
+};
+
+typedef struct {
+    uint64_t end_us;
+    uint32_t frame;
+    bool lost;
+    bool delivered;
+} air_frame_t;
+
+static PIO pio;
+static int tx_sm;
+static int rx_sm;
+static ir_echo_t echo;
+static ir_verify_t verify;
+
+static air_frame_t air[MAX_AIR];
+static uint32_t air_count;
+static uint64_t tx_busy_until;
+static uint32_t channel_seed;
+static uint8_t current_channel;
+static bool channel_bad[CHANNELS];
+
+// Pedido em andamento
+static bool arrived;                // Alguma cópia já chegou ao receptor
+static uint32_t wasted;
+
+static bool lose_frame(uint8_t channel) {
+    const channel_model_t *m = &models[channel];
+    uint32_t r = bench_rand(&channel_seed) % 100;
+    if (channel_bad[channel]) {
+        channel_bad[channel] = r >= m->leave_bad_pct;
+    } else {
+        channel_bad[channel] = r < m->enter_bad_pct;
+    }
+    return bench_rand(&channel_seed) % 100 < (channel_bad[channel] ? m->loss_bad_pct : m->loss_good_pct);
+}
+
+/**
+ * A state machine TX consome o FIFO quando termina o quadro anterior; o
+ * receptor entrega o que chegou
+ */
+static void channel_ticker(uint64_t from_us, uint64_t to_us) {
+    uint32_t frame;
+    while (tx_busy_until <= to_us && host_pio_tx_pop(pio, tx_sm, &frame)) {
+        uint64_t start = tx_busy_until > from_us ? tx_busy_until : from_us;
+        tx_busy_until = start + IR_ECHO_NEC_FRAME_US;
+        wasted += arrived;
+        air[air_count % MAX_AIR] = (air_frame_t){tx_busy_until, frame, lose_frame(current_channel), false};
+        air_count++;
+    }
+    uint32_t first = air_count > MAX_AIR ? air_count - MAX_AIR : 0;
+    for (uint32_t i = first; i < air_count; i++) {
+        air_frame_t *a = &air[i % MAX_AIR];
+        if (!a->delivered && a->end_us + RX_LATENCY_US <= to_us) {
+            a->delivered = true;
+            if (!a->lost && host_pio_rx_push(pio, rx_sm, a->frame)) {
+                arrived = true;
+            }
+        }
+    }
+}
+
+static bool transmit_frame(uint32_t frame, void *ctx) {
+    (void)ctx;
+    if (pio_sm_is_tx_fifo_full(pio, tx_sm)) {
+        return false;
+    }
+    pio_sm_put(pio, tx_sm, frame);
+    ir_echo_publish(&echo, time_us_64(), IR_ECHO_NEC_FRAME_US, frame);
+    return true;
+}
+
+typedef struct {
+    uint32_t requests;
+    uint32_t delivered;
+    uint32_t attempts;
+    uint32_t wasted;
+    uint64_t latency_sum_us;
+    uint64_t latency_max_us;
+    uint8_t channel_pct[CHANNELS];
+    uint8_t worst_command_pct;
+} verify_result_t;
+
+static void run_channel(uint8_t max_attempts, uint32_t requests, verify_result_t *out) {
+    uint32_t seed = 0x7E51F1EDu;
+
+    host_sdk_reset();
+    pio = pio0;
+    tx_sm = nec_tx_init(pio, TX_PIN);
+    rx_sm = nec_rx_init(pio, RX_PIN);
+    ir_echo_init(&echo, 0);
+    ir_verify_init(&verify, transmit_frame, NULL, max_attempts);
+    host_sdk_set_ticker(channel_ticker);
+    air_count = 0;
+    tx_busy_until = 0;
+    channel_seed = 0xC4A22E15u;
+    for (int i = 0; i < CHANNELS; i++) {
+        channel_bad[i] = false;
+    }
+    wasted = 0;
+    *out = (verify_result_t){0};
+
+    uint64_t next_request = 200000;
+    uint32_t issued = 0;
+
+    while (issued < requests || ir_verify_busy(&verify)) {
+        host_time_advance_us(LOOP_TICK_US);
+        uint64_t now = time_us_64();
+
+        if (!ir_verify_busy(&verify) && issued < requests && now >= next_request) {
+            uint16_t command = (uint16_t)(bench_rand(&seed) % ir_command_count);
+            const ir_command_t *cmd = &ir_command_table[command];
+            current_channel = (uint8_t)(bench_rand(&seed) % CHANNELS);
+            arrived = false;
+            ir_verify_send(&verify, nec_encode_frame(cmd->device, (uint8_t)cmd->function), IR_ECHO_NEC_FRAME_US,
+                           command, current_channel, now);
+            issued++;
+        }
+
+        while (!pio_sm_is_rx_fifo_empty(pio, rx_sm)) {
+            uint32_t rx_frame = pio_sm_get(pio, rx_sm);
+            uint64_t rx_end = time_us_64();
+            if (ir_echo_classify(&echo, rx_end - IR_ECHO_NEC_FRAME_US, rx_end, rx_frame) == IR_ECHO_SELF) {
+                ir_verify_on_rx(&verify, rx_frame, rx_end);
+            }
+        }
+
+        switch (ir_verify_poll(&verify, now)) {
+            case IR_VERIFY_DELIVERED:
+                out->latency_sum_us += verify.last_latency_us;
+                if (verify.last_latency_us > out->latency_max_us) {
+                    out->latency_max_us = verify.last_latency_us;
+                }
+                // fall through
+            case IR_VERIFY_FAILED:
+                next_request = now + 100000 + bench_rand(&seed) % 500000;
+                break;
+            default:
+                break;
+        }
+    }
+    host_sdk_set_ticker(NULL);
+
+    out->worst_command_pct = 100;
+    for (size_t i = 0; i <= IR_VERIFY_COMMANDS; i++) {
+        const ir_verify_stats_t *s = &verify.commands[i];
+        out->requests += s->requests;
+        out->delivered += s->delivered;
+        out->attempts += s->attempts;
+        if (s->requests >= 10 && ir_verify_success_pct(s) < out->worst_command_pct) {
+            out->worst_command_pct = ir_verify_success_pct(s);
+        }
+    }
+    for (int i = 0; i < CHANNELS; i++) {
+        out->channel_pct[i] = ir_verify_success_pct(&verify.channels[i]);
+    }
+    out->wasted = wasted;
+}
+
+void bench_suite_verify(void) {
+    uint32_t requests = bench_quick ? 300 : 2000;
+    verify_result_t once;
+    verify_result_t retry;
+    char name[64];
+
+    run_channel(1, requests, &once);
+    run_channel(IR_VERIFY_ATTEMPTS, requests, &retry);
+
+    bench_report("verify.fire_and_hope_pct", 100.0 * once.delivered / once.requests, "%", BENCH_HIGHER_IS_BETTER);
+    bench_report("verify.delivered_pct", 100.0 * retry.delivered / retry.requests, "%", BENCH_HIGHER_IS_BETTER);
+    for (int i = 0; i < CHANNELS; i++) {
+        snprintf(name, sizeof(name), "verify.channel%d_fire_and_hope_pct", i);
+        bench_report(name, once.channel_pct[i], "%", BENCH_HIGHER_IS_BETTER);
+        snprintf(name, sizeof(name), "verify.channel%d_delivered_pct", i);
+        bench_report(name, retry.channel_pct[i], "%", BENCH_HIGHER_IS_BETTER);
+    }
+    bench_report("verify.worst_command_pct", retry.worst_command_pct, "%", BENCH_HIGHER_IS_BETTER);
+    bench_report("verify.attempts_per_request", (double)retry.attempts / retry.requests, "count",
+                 BENCH_LOWER_IS_BETTER);
+    bench_report("verify.wasted_retries", retry.wasted, "count", BENCH_LOWER_IS_BETTER);
+    bench_report("verify.latency_mean_ms", retry.delivered ? retry.latency_sum_us / 1000.0 / retry.delivered : 0,
+                 "ms", BENCH_LOWER_IS_BETTER);
+    bench_report("verify.latency_max_ms", retry.latency_max_us / 1000.0, "ms", BENCH_LOWER_IS_BETTER);
+}
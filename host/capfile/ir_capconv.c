@@ -0,0 +1,120 @@
+/**
+ * ir_capconv.c - Converte entre o texto do receptor.c e o arquivo de capturas
+ *
+ * Uso: ir_capconv to-bin [--pin <n>] <log.txt> <saida.ircap>
+ *      ir_capconv to-text <entrada.ircap> <saida.txt | ->
+ *
+ * No to-bin, vetores sem o comentário de pino recebem o pino de --pin e o
+ * número de ordem como instante, para manter a ordem original.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "ir_capfile_io.h"
+
+static int to_binary(const char *input, const char *output, uint8_t default_pin) {
+    int fd = open(input, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        perror(input);
+        return 1;
+    }
+    const char *text = st.st_size > 0 ? mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0) : NULL;
+    close(fd);
+    if (text == MAP_FAILED) {
+        perror(input);
+        return 1;
+    }
+
+    ir_capfile_writer_t w;
+    if (!ir_capfile_writer_open(&w, output)) {
+        perror(output);
+        return 1;
+    }
+
+    ir_capfile_text_t t;
+    uint16_t raw[IR_CAPFILE_TEXT_MAX_TIMINGS];
+    size_t count;
+    uint64_t number = 0;
+    ir_capfile_text_init(&t, text, text ? (size_t)st.st_size : 0);
+    while ((count = ir_capfile_text_next(&t, raw)) > 0) {
+        ir_capfile_writer_add(&w, t.has_pin ? t.time_us : number, t.has_pin ? t.pin : default_pin, raw, count);
+        number++;
+    }
+    if (text) {
+        munmap((void *)text, (size_t)st.st_size);
+    }
+    if (!ir_capfile_writer_close(&w)) {
+        fprintf(stderr, "%s: falha na gravação\n", output);
+        return 1;
+    }
+    fprintf(stderr, "%llu quadro(s)\n", (unsigned long long)number);
+    return 0;
+}
+
+static int to_text(const char *input, const char *output) {
+    ir_capfile_map_t m;
+    ir_capfile_status_t status = ir_capfile_map_open(&m, input);
+    if (status != IR_CAPFILE_OK) {
+        fprintf(stderr, "%s: %s\n", input, ir_capfile_status_name(status));
+        return 1;
+    }
+    FILE *out = strcmp(output, "-") == 0 ? stdout : fopen(output, "w");
+    if (!out) {
+        perror(output);
+        ir_capfile_map_close(&m);
+        return 1;
+    }
+
+    int result = 0;
+    for (size_t i = 0; i < m.file.frame_count; i++) {
+        ir_capfile_frame_t frame;
+        if (!ir_capfile_frame(&m.file, i, &frame)) {
+            fprintf(stderr, "%s: quadro %zu fora do arquivo\n", input, i);
+            result = 1;
+            break;
+        }
+        ir_capfile_print_text(out, &frame, (unsigned)i + 1);
+    }
+    if (out != stdout) {
+        fclose(out);
+    }
+    ir_capfile_map_close(&m);
+    return result;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+            "uso: %s to-bin [--pin <n>] <log.txt> <saida.ircap>\n"
+            "     %s to-text <entrada.ircap> <saida.txt | ->\n",
+            argv0, argv0);
+}
+
+int main(int argc, char **argv) {
+    if (argc >= 4 && strcmp(argv[1], "to-bin") == 0) {
+        uint8_t pin = 0;
+        int i = 2;
+        if (strcmp(argv[i], "--pin") == 0 && argc == 6) {
+            pin = (uint8_t)atoi(argv[i + 1]);
+            i += 2;
+        }
+        if (argc - i == 2) {
+            return to_binary(argv[i], argv[i + 1], pin);
+        }
+    } else if (argc == 4 && strcmp(argv[1], "to-text") == 0) {
+        return to_text(argv[2], argv[3]);
+    }
+    usage(argv[0]);
+    return 2;
+}
@@ -0,0 +1,282 @@
+/**
+ * ir_capfile_io.c - Mapeamento, gravador e conversores de texto dos arquivos de captura
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "ir_capfile_io.h"
+
+#define INDEX_MIN_CAPACITY 1024
+
+static const char pin_comment[] = "// Pino: ";
+static const char array_marker[] = "] = {";
+
+// ---------------------------------------------------------------------------
+// Mapeamento
+// ---------------------------------------------------------------------------
+
+ir_capfile_status_t ir_capfile_map_open(ir_capfile_map_t *m, const char *path) {
+    memset(m, 0, sizeof(*m));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return IR_CAPFILE_TRUNCATED;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return IR_CAPFILE_TRUNCATED;
+    }
+    void *addr = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        return IR_CAPFILE_TRUNCATED;
+    }
+
+    ir_capfile_status_t status = ir_capfile_open(&m->file, addr, (size_t)st.st_size);
+    if (status != IR_CAPFILE_OK) {
+        munmap(addr, (size_t)st.st_size);
+        return status;
+    }
+    m->addr = addr;
+    m->length = (size_t)st.st_size;
+    return IR_CAPFILE_OK;
+}
+
+void ir_capfile_map_close(ir_capfile_map_t *m) {
+    if (m->addr) {
+        munmap(m->addr, m->length);
+    }
+    memset(m, 0, sizeof(*m));
+}
+
+// ---------------------------------------------------------------------------
+// Gravação
+// ---------------------------------------------------------------------------
+
+bool ir_capfile_writer_open(ir_capfile_writer_t *w, const char *path) {
+    uint8_t header[IR_CAPFILE_HEADER_SIZE];
+
+    memset(w, 0, sizeof(*w));
+    w->out = fopen(path, "wb");
+    if (!w->out) {
+        return false;
+    }
+
+    // Cabeçalho provisório, regravado no fechamento
+    ir_capfile_put_header(header, 0, IR_CAPFILE_HEADER_SIZE);
+    w->failed = fwrite(header, sizeof(header), 1, w->out) != 1;
+    w->offset = IR_CAPFILE_HEADER_SIZE;
+    return true;
+}
+
+bool ir_capfile_writer_add(ir_capfile_writer_t *w, uint64_t time_us, uint8_t pin, const uint16_t *raw,
+                           size_t count) {
+    uint8_t data[3 * UINT16_MAX];
+
+    if (w->failed || count > UINT16_MAX || w->frames == UINT32_MAX) {
+        w->failed = true;
+        return false;
+    }
+    if (w->frames == w->capacity) {
+        size_t capacity = w->capacity ? w->capacity * 2 : INDEX_MIN_CAPACITY;
+        uint8_t *index = realloc(w->index, capacity * IR_CAPFILE_ENTRY_SIZE);
+        if (!index) {
+            w->failed = true;
+            return false;
+        }
+        w->index = index;
+        w->capacity = capacity;
+    }
+
+    ir_capfile_frame_t frame = {
+        .time_us = time_us,
+        .size = (uint32_t)ir_capfile_encode(raw, count, data),
+        .count = (uint16_t)count,
+        .pin = pin,
+    };
+    if (fwrite(data, 1, frame.size, w->out) != frame.size) {
+        w->failed = true;
+        return false;
+    }
+    ir_capfile_put_entry(w->index + w->frames * IR_CAPFILE_ENTRY_SIZE, w->offset, &frame);
+    w->frames++;
+    w->offset += frame.size;
+    return true;
+}
+
+bool ir_capfile_writer_close(ir_capfile_writer_t *w) {
+    uint8_t header[IR_CAPFILE_HEADER_SIZE];
+    bool ok = !w->failed;
+
+    if (ok) {
+        ir_capfile_put_header(header, (uint32_t)w->frames, w->offset);
+        ok = fwrite(w->index, IR_CAPFILE_ENTRY_SIZE, w->frames, w->out) == w->frames &&
+             fseek(w->out, 0, SEEK_SET) == 0 && fwrite(header, sizeof(header), 1, w->out) == 1;
+    }
+    ok &= fclose(w->out) == 0;
+    free(w->index);
+    memset(w, 0, sizeof(*w));
+    return ok;
+}
+
+// ---------------------------------------------------------------------------
+// Texto
+// ---------------------------------------------------------------------------
+
+void ir_capfile_text_init(ir_capfile_text_t *t, const char *text, size_t length) {
+    t->p = text;
+    t->end = text + length;
+    t->time_us = 0;
+    t->pin = 0;
+    t->has_pin = false;
+    t->name[0] = '\0';
+}
+
+static const char *parse_uint(const char *p, const char *end, uint64_t *value) {
+    uint64_t v = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        v = v * 10 + (uint64_t)(*p++ - '0');
+    }
+    *value = v;
+    return p;
+}
+
+static bool starts_with(const char *p, const char *end, const char *prefix, size_t length) {
+    return (size_t)(end - p) >= length && memcmp(p, prefix, length) == 0;
+}
+
+static bool is_identifier(char c) {
+    return c == '_' || (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+// Identificador que termina logo antes de end (truncado ao tamanho de name)
+static void copy_identifier(char *name, const char *line, const char *end) {
+    const char *start = end;
+    while (start > line && is_identifier(start[-1])) {
+        start--;
+    }
+    size_t length = (size_t)(end - start);
+    length = length < IR_CAPFILE_TEXT_MAX_NAME - 1 ? length : IR_CAPFILE_TEXT_MAX_NAME - 1;
+    memcpy(name, start, length);
+    name[length] = '\0';
+}
+
+// "// Pino: P | Instante: T us"
+static void parse_pin_comment(ir_capfile_text_t *t, const char *p, const char *eol) {
+    uint64_t pin, time_us = 0;
+    p = parse_uint(p + sizeof(pin_comment) - 1, eol, &pin);
+    while (p < eol && (*p < '0' || *p > '9')) {
+        p++;
+    }
+    parse_uint(p, eol, &time_us);
+    t->pin = (uint8_t)pin;
+    t->time_us = time_us;
+    t->has_pin = true;
+}
+
+// Início dos valores de um "[] = {" ou "[N] = {" na linha, ou NULL; bracket
+// recebe a posição do '['
+static const char *find_array(const char *p, const char *eol, const char **bracket) {
+    while ((p = memchr(p, '[', (size_t)(eol - p))) != NULL) {
+        const char *q = p + 1;
+        while (q < eol && *q >= '0' && *q <= '9') {
+            q++;
+        }
+        if (starts_with(q, eol, array_marker, sizeof(array_marker) - 1)) {
+            *bracket = p;
+            return q + sizeof(array_marker) - 1;
+        }
+        p++;
+    }
+    return NULL;
+}
+
+size_t ir_capfile_text_next(ir_capfile_text_t *t, uint16_t *raw) {
+    // O comentário do pino vale só para o vetor seguinte
+    t->time_us = 0;
+    t->pin = 0;
+    t->has_pin = false;
+    t->name[0] = '\0';
+    while (t->p < t->end) {
+        const char *eol = memchr(t->p, '\n', (size_t)(t->end - t->p));
+        eol = eol ? eol : t->end;
+
+        const char *body = NULL;
+        const char *bracket = NULL;
+        if (starts_with(t->p, eol, pin_comment, sizeof(pin_comment) - 1)) {
+            parse_pin_comment(t, t->p, eol);
+        } else if (!starts_with(t->p, eol, "//", 2)) {
+            body = find_array(t->p, eol, &bracket);
+        }
+        if (!body) {
+            t->p = eol < t->end ? eol + 1 : eol;
+            continue;
+        }
+        copy_identifier(t->name, t->p, bracket);
+
+        size_t count = 0;
+        bool overflow = false;
+        const char *p = body;
+        while (p < t->end && *p != '}') {
+            if (*p >= '0' && *p <= '9') {
+                uint64_t v;
+                p = parse_uint(p, t->end, &v);
+                if (count < IR_CAPFILE_TEXT_MAX_TIMINGS) {
+                    raw[count++] = (uint16_t)(v > UINT16_MAX ? UINT16_MAX : v);
+                } else {
+                    overflow = true;
+                }
+            } else {
+                p++;
+            }
+        }
+        t->p = p < t->end ? p + 1 : p;
+        if (count > 0 && !overflow && p < t->end) {
+            return count;
+        }
+    }
+    return 0;
+}
+
+void ir_capfile_print_text(FILE *out, const ir_capfile_frame_t *frame, unsigned number) {
+    ir_capfile_cursor_t c;
+    uint32_t v, total_us = 0;
+    unsigned i = 0;
+
+    // Duração antes dos tempos, como no receptor.c
+    ir_capfile_cursor_init(&c, frame);
+    while (ir_capfile_next(&c, &v)) {
+        total_us += v;
+    }
+
+    fprintf(out, "// Sinal %u: capfile\n", number);
+    fprintf(out, "// Tempos: %u | Duração: %u ms\n", frame->count, total_us / 1000);
+    fprintf(out, "%s%u | Instante: %llu us\n", pin_comment, frame->pin, (unsigned long long)frame->time_us);
+    fprintf(out, "uint16_t rawSignal%u[] = {\n", number);
+    ir_capfile_cursor_init(&c, frame);
+    while (ir_capfile_next(&c, &v)) {
+        if (i % 12 == 0) {
+            fputs("    ", out);
+        }
+        fprintf(out, "%u", v > UINT16_MAX ? UINT16_MAX : v);
+        if (i < frame->count - 1u) {
+            fputs(", ", out);
+        }
+        if (i % 12 == 11 || i == frame->count - 1u) {
+            fputc('\n', out);
+        }
+        i++;
+    }
+    fprintf(out, "};\n#define RAW_SIGNAL%u_LENGTH %u\n\n", number, frame->count);
+}
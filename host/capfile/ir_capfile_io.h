@@ -0,0 +1,103 @@
+/**
+ * ir_capfile_io.h - Arquivos de captura no host: mapeamento, gravação e texto
+ *
+ * ir_capfile_map_open() mapeia o arquivo inteiro (mmap, só leitura) e o abre
+ * com ir_capfile_open(); quadros e tempos são lidos direto do mapeamento, sem
+ * cópia. O gravador escreve os tempos em fluxo e guarda só o índice em
+ * memória (IR_CAPFILE_ENTRY_SIZE bytes por quadro) até fechar o arquivo.
+ *
+ * Os conversores de texto usam o formato de print_raw_signal_data() do
+ * receptor.c ("uint16_t rawSignalN[] = {...};"), com uma linha de comentário
+ * a mais para o pino e o instante, que o leitor de texto reconhece; sem ela o
+ * quadro entra com pino e instante zerados.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef IR_CAPFILE_IO_H
+#define IR_CAPFILE_IO_H
+
+#include <stdio.h>
+
+#include "ir_capfile.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define IR_CAPFILE_TEXT_MAX_TIMINGS 1024      // Mesmo limite do receptor.c
+#define IR_CAPFILE_TEXT_MAX_NAME 32           // Mesmo tamanho do nome no receptor.c
+
+typedef struct {
+    ir_capfile_t file;
+    void *addr;
+    size_t length;
+} ir_capfile_map_t;
+
+typedef struct {
+    FILE *out;
+    uint64_t offset;                          // Próxima posição dos tempos
+    uint8_t *index;
+    size_t frames;
+    size_t capacity;
+    bool failed;
+} ir_capfile_writer_t;
+
+// Leitura dos vetores de um texto na memória
+typedef struct {
+    const char *p;
+    const char *end;
+    uint64_t time_us;                         // Do vetor devolvido ("// Pino: ..." antes dele)
+    uint8_t pin;
+    bool has_pin;                             // O vetor devolvido tinha o comentário
+    char name[IR_CAPFILE_TEXT_MAX_NAME];      // Identificador do vetor devolvido ("rawSignal1")
+} ir_capfile_text_t;
+
+/**
+ * Mapeia e abre um arquivo de capturas
+ *
+ * @return IR_CAPFILE_TRUNCATED também se o arquivo não puder ser lido
+ */
+ir_capfile_status_t ir_capfile_map_open(ir_capfile_map_t *m, const char *path);
+
+void ir_capfile_map_close(ir_capfile_map_t *m);
+
+bool ir_capfile_writer_open(ir_capfile_writer_t *w, const char *path);
+
+/**
+ * Acrescenta um quadro
+ */
+bool ir_capfile_writer_add(ir_capfile_writer_t *w, uint64_t time_us, uint8_t pin, const uint16_t *raw,
+                           size_t count);
+
+/**
+ * Grava o índice e o cabeçalho e fecha o arquivo
+ *
+ * @return false se alguma gravação falhou
+ */
+bool ir_capfile_writer_close(ir_capfile_writer_t *w);
+
+void ir_capfile_text_init(ir_capfile_text_t *t, const char *text, size_t length);
+
+/**
+ * Próximo vetor do texto
+ *
+ * @param raw Recebe até IR_CAPFILE_TEXT_MAX_TIMINGS tempos
+ * @return Quantidade de tempos, 0 no fim do texto (vetores vazios ou grandes
+ *         demais são pulados)
+ */
+size_t ir_capfile_text_next(ir_capfile_text_t *t, uint16_t *raw);
+
+/**
+ * Imprime um quadro no formato do receptor.c
+ *
+ * @param number Número do sinal (rawSignalN)
+ */
+void ir_capfile_print_text(FILE *out, const ir_capfile_frame_t *frame, unsigned number);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IR_CAPFILE_IO_H
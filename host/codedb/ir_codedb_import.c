@@ -0,0 +1,894 @@
+/**
+ * ir_codedb_import.c - Importação LIRC/Pronto e montagem da imagem do banco
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "ir_codedb_import.h"
+#include "ir_capfile.h"
+
+#define NEC_HEADER_MARK_US 9000
+#define NEC_HEADER_SPACE_US 4500
+#define NEC_BIT_MARK_US 560
+#define NEC_ZERO_SPACE_US 560
+#define NEC_ONE_SPACE_US 1690
+#define SIRC_HEADER_MARK_US 2400
+#define SIRC_UNIT_US 600
+#define DEFAULT_CARRIER_HZ 38000        // Padrão do LIRC
+#define MAX_TOKEN 128
+
+void ir_codedb_builder_init(ir_codedb_builder_t *b) {
+    memset(b, 0, sizeof(*b));
+}
+
+void ir_codedb_builder_free(ir_codedb_builder_t *b) {
+    for (size_t d = 0; d < b->device_count; d++) {
+        for (size_t k = 0; k < b->devices[d].key_count; k++) {
+            free(b->devices[d].keys[k].raw);
+        }
+        free(b->devices[d].keys);
+    }
+    free(b->devices);
+    memset(b, 0, sizeof(*b));
+}
+
+static bool near(uint32_t value, uint32_t reference, uint32_t tolerance_pct) {
+    uint64_t diff = value > reference ? value - reference : reference - value;
+    return diff * 100 <= (uint64_t)reference * tolerance_pct;
+}
+
+static inline bool near_protocol(uint32_t value, uint32_t reference) {
+    return near(value, reference, IR_CODEDB_TOLERANCE_PCT);
+}
+
+static ir_codedb_import_device_t *find_or_add_device(ir_codedb_builder_t *b, const char *name) {
+    if (b->last_device < b->device_count && strcasecmp(b->devices[b->last_device].name, name) == 0) {
+        return &b->devices[b->last_device];
+    }
+    for (size_t d = 0; d < b->device_count; d++) {
+        if (strcasecmp(b->devices[d].name, name) == 0) {
+            b->last_device = d;
+            return &b->devices[d];
+        }
+    }
+
+    if (b->device_count == b->device_capacity) {
+        size_t capacity = b->device_capacity ? b->device_capacity * 2 : 64;
+        ir_codedb_import_device_t *grown = realloc(b->devices, capacity * sizeof(*grown));
+        if (!grown) {
+            return NULL;
+        }
+        b->devices = grown;
+        b->device_capacity = capacity;
+    }
+    ir_codedb_import_device_t *d = &b->devices[b->device_count];
+    memset(d, 0, sizeof(*d));
+    snprintf(d->name, sizeof(d->name), "%s", name);
+    b->last_device = b->device_count++;
+    return d;
+}
+
+static ir_codedb_import_key_t *add_key(ir_codedb_builder_t *b, const char *device, const char *name) {
+    ir_codedb_import_device_t *d = find_or_add_device(b, device);
+    if (!d) {
+        return NULL;
+    }
+    if (d->key_count == d->key_capacity) {
+        size_t capacity = d->key_capacity ? d->key_capacity * 2 : 32;
+        ir_codedb_import_key_t *grown = realloc(d->keys, capacity * sizeof(*grown));
+        if (!grown) {
+            return NULL;
+        }
+        d->keys = grown;
+        d->key_capacity = capacity;
+    }
+    ir_codedb_import_key_t *k = &d->keys[d->key_count++];
+    memset(k, 0, sizeof(*k));
+    snprintf(k->name, sizeof(k->name), "%s", name);
+    k->order = b->next_order++;
+    b->keys++;
+    return k;
+}
+
+bool ir_codedb_add_code(ir_codedb_builder_t *b, const char *device, const char *key, ir_codedb_protocol_t protocol,
+                        uint8_t bits, uint64_t code, const ir_codedb_timing_t *timing) {
+    if (protocol >= IR_CODEDB_RAW) {
+        return false;
+    }
+    ir_codedb_import_key_t *k = add_key(b, device, key);
+    if (!k) {
+        return false;
+    }
+    k->protocol = protocol;
+    k->bits = bits;
+    k->code = code;
+    if (protocol == IR_CODEDB_PULSE_DISTANCE) {
+        k->timing = *timing;
+    }
+    b->protocols[protocol]++;
+    return true;
+}
+
+/**
+ * SIRC: cabeçalho de 2,4 ms e bits por largura da marca (1,2 ms = 1), com
+ * espaços de 600 us; o último espaço se confunde com o silêncio
+ */
+static bool decode_sirc(const uint16_t *raw, size_t count, uint64_t *code, uint8_t *bits) {
+    size_t n = (count - 1) / 2;
+    if (count % 2 == 0 || (n != 12 && n != 15 && n != 20) || !near_protocol(raw[0], SIRC_HEADER_MARK_US) ||
+        !near_protocol(raw[1], SIRC_UNIT_US)) {
+        return false;
+    }
+    uint64_t value = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint16_t mark = raw[2 + 2 * i];
+        if (i + 1 < n && !near_protocol(raw[3 + 2 * i], SIRC_UNIT_US)) {
+            return false;
+        }
+        if (near_protocol(mark, 2 * SIRC_UNIT_US)) {
+            value |= 1ull << i;
+        } else if (!near_protocol(mark, SIRC_UNIT_US)) {
+            return false;
+        }
+    }
+    *code = value;
+    *bits = (uint8_t)n;
+    return true;
+}
+
+/**
+ * Distância de pulso: cabeçalho, bits com marcas iguais e dois espaços,
+ * marca final
+ */
+static bool decode_pulse_distance(const uint16_t *raw, size_t count, uint64_t *code, uint8_t *bits,
+                                  ir_codedb_timing_t *t) {
+    size_t n = count >= 3 ? (count - 3) / 2 : 0;
+    if (count % 2 == 0 || n < 8 || n > 64) {
+        return false;
+    }
+
+    uint32_t mark_sum = 0;
+    uint16_t space_min = UINT16_MAX;
+    uint16_t space_max = 0;
+    for (size_t i = 2; i < count; i += 2) {
+        mark_sum += raw[i];
+        if (i + 1 < count) {
+            space_min = raw[i + 1] < space_min ? raw[i + 1] : space_min;
+            space_max = raw[i + 1] > space_max ? raw[i + 1] : space_max;
+        }
+    }
+    uint32_t mark = (mark_sum + (uint32_t)(n + 1) / 2) / (uint32_t)(n + 1);
+    if (raw[0] < 2 * mark || 2u * space_max < 3u * space_min) {
+        return false;                   // Sem cabeçalho, ou um só tipo de espaço
+    }
+
+    uint32_t threshold = ((uint32_t)space_min + space_max) / 2;
+    uint32_t zero_sum = 0, one_sum = 0, ones = 0;
+    uint64_t value = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint16_t space = raw[3 + 2 * i];
+        if (space > threshold) {
+            value |= 1ull << i;
+            one_sum += space;
+            ones++;
+        } else {
+            zero_sum += space;
+        }
+    }
+    uint32_t zero = (zero_sum + (uint32_t)(n - ones) / 2) / (uint32_t)(n - ones);
+    uint32_t one = (one_sum + ones / 2) / ones;
+    for (size_t i = 0; i < n; i++) {
+        if (!near_protocol(raw[3 + 2 * i], value >> i & 1 ? one : zero) || !near_protocol(raw[2 + 2 * i], mark)) {
+            return false;
+        }
+    }
+    if (!near_protocol(raw[count - 1], mark)) {
+        return false;
+    }
+
+    *code = value;
+    *bits = (uint8_t)n;
+    t->header_mark_us = raw[0];
+    t->header_space_us = raw[1];
+    t->bit_mark_us = (uint16_t)mark;
+    t->zero_space_us = (uint16_t)zero;
+    t->one_space_us = (uint16_t)one;
+    return true;
+}
+
+bool ir_codedb_add_raw(ir_codedb_builder_t *b, const char *device, const char *key, const uint16_t *raw,
+                       size_t count, uint32_t carrier_hz, uint32_t gap_us) {
+    if (count == 0 || count > IR_CODEDB_MAX_RAW) {
+        return false;
+    }
+    // O último espaço é o silêncio até o próximo quadro
+    if (count % 2 == 0) {
+        gap_us = gap_us ? gap_us : raw[count - 1];
+        count--;
+    }
+
+    uint64_t code;
+    uint8_t bits;
+    ir_codedb_timing_t t;
+    if (decode_sirc(raw, count, &code, &bits)) {
+        return ir_codedb_add_code(b, device, key, IR_CODEDB_SIRC, bits, code, NULL);
+    }
+    if (decode_pulse_distance(raw, count, &code, &bits, &t)) {
+        if (bits == 32 && near_protocol(t.header_mark_us, NEC_HEADER_MARK_US) &&
+            near_protocol(t.header_space_us, NEC_HEADER_SPACE_US) && near_protocol(t.bit_mark_us, NEC_BIT_MARK_US) &&
+            near_protocol(t.zero_space_us, NEC_ZERO_SPACE_US) && near_protocol(t.one_space_us, NEC_ONE_SPACE_US)) {
+            return ir_codedb_add_code(b, device, key, IR_CODEDB_NEC, 32, code, NULL);
+        }
+        t.carrier_hz = carrier_hz ? carrier_hz : DEFAULT_CARRIER_HZ;
+        t.gap_us = gap_us;
+        return ir_codedb_add_code(b, device, key, IR_CODEDB_PULSE_DISTANCE, bits, code, &t);
+    }
+
+    uint16_t *copy = malloc(count * sizeof(uint16_t));
+    ir_codedb_import_key_t *k = copy ? add_key(b, device, key) : NULL;
+    if (!k) {
+        free(copy);
+        return false;
+    }
+    memcpy(copy, raw, count * sizeof(uint16_t));
+    k->protocol = IR_CODEDB_RAW;
+    k->raw = copy;
+    k->raw_count = (uint16_t)count;
+    k->carrier_hz = (uint16_t)(carrier_hz > UINT16_MAX ? 0 : carrier_hz);
+    b->protocols[IR_CODEDB_RAW]++;
+    return true;
+}
+
+// Leitura de texto linha a linha
+
+typedef struct {
+    const char *p;
+    const char *end;
+} line_t;
+
+static bool next_line(const char **p, const char *end, line_t *line) {
+    if (*p >= end) {
+        return false;
+    }
+    const char *eol = memchr(*p, '\n', (size_t)(end - *p));
+    line->p = *p;
+    line->end = eol ? eol : end;
+    *p = eol ? eol + 1 : end;
+
+    // Comentários
+    const char *hash = memchr(line->p, '#', (size_t)(line->end - line->p));
+    if (hash) {
+        line->end = hash;
+    }
+    return true;
+}
+
+/**
+ * Próximo token da linha
+ *
+ * @return false no fim da linha
+ */
+static bool next_token(line_t *line, char *token) {
+    while (line->p < line->end && isspace((unsigned char)*line->p)) {
+        line->p++;
+    }
+    if (line->p == line->end) {
+        return false;
+    }
+    size_t n = 0;
+    while (line->p < line->end && !isspace((unsigned char)*line->p)) {
+        if (n < MAX_TOKEN - 1) {
+            token[n++] = *line->p;
+        }
+        line->p++;
+    }
+    token[n] = '\0';
+    return true;
+}
+
+static bool parse_number(const char *token, uint64_t *value) {
+    char *end;
+    *value = strtoull(token, &end, 0);
+    return end != token && *end == '\0';
+}
+
+// LIRC
+
+typedef struct {
+    char name[IR_CODEDB_MAX_NAME];
+    unsigned bits;
+    unsigned pre_bits;
+    unsigned post_bits;
+    uint64_t pre_data;
+    uint64_t post_data;
+    uint32_t header[2];
+    uint32_t one[2];
+    uint32_t zero[2];
+    uint32_t plead;
+    uint32_t ptrail;
+    uint32_t gap;
+    uint32_t frequency;
+    bool rc5;
+    bool rc6;
+    bool raw_codes;
+    bool reverse;
+    bool unsupported;                   // Codificação que o banco não representa, ou nome longo demais
+} lirc_remote_t;
+
+static void parse_flags(lirc_remote_t *r, const char *token) {
+    char flags[MAX_TOKEN];
+    snprintf(flags, sizeof(flags), "%s", token);
+    for (char *save, *flag = strtok_r(flags, "|", &save); flag; flag = strtok_r(NULL, "|", &save)) {
+        if (strcmp(flag, "RC5") == 0 || strcmp(flag, "SHIFT_ENC") == 0) {
+            r->rc5 = true;
+        } else if (strcmp(flag, "RC6") == 0) {
+            r->rc6 = true;
+        } else if (strcmp(flag, "RAW_CODES") == 0) {
+            r->raw_codes = true;
+        } else if (strcmp(flag, "REVERSE") == 0) {
+            r->reverse = true;
+        } else if (strcmp(flag, "RCMM") == 0 || strcmp(flag, "XMP") == 0 || strcmp(flag, "GOLDSTAR") == 0 ||
+                   strcmp(flag, "GRUNDIG") == 0 || strcmp(flag, "BO") == 0 || strcmp(flag, "SERIAL") == 0 ||
+                   strcmp(flag, "SPACE_FIRST") == 0) {
+            r->unsupported = true;
+        }
+    }
+}
+
+static void parse_remote_line(lirc_remote_t *r, const char *key, line_t *line) {
+    char token[MAX_TOKEN];
+    uint64_t v[2] = {0, 0};
+    size_t n = 0;
+    if (strcmp(key, "name") == 0) {
+        size_t length = next_token(line, token) ? strlen(token) : 0;
+        if (length >= sizeof(r->name)) {
+            // Nome maior que o campo: truncado, poderia colidir com outro
+            // controle, então as teclas são rejeitadas
+            r->unsupported = true;
+        } else if (length > 0) {
+            memcpy(r->name, token, length + 1);
+        }
+        return;
+    }
+    if (strcmp(key, "flags") == 0) {
+        while (next_token(line, token)) {
+            parse_flags(r, token);
+        }
+        return;
+    }
+    while (n < 2 && next_token(line, token) && parse_number(token, &v[n])) {
+        n++;
+    }
+
+    uint32_t first = (uint32_t)(v[0] > UINT32_MAX ? UINT32_MAX : v[0]);
+    if (strcmp(key, "bits") == 0) {
+        r->bits = first;
+    } else if (strcmp(key, "pre_data_bits") == 0) {
+        r->pre_bits = first;
+    } else if (strcmp(key, "post_data_bits") == 0) {
+        r->post_bits = first;
+    } else if (strcmp(key, "pre_data") == 0) {
+        r->pre_data = v[0];
+    } else if (strcmp(key, "post_data") == 0) {
+        r->post_data = v[0];
+    } else if (strcmp(key, "header") == 0 || strcmp(key, "one") == 0 || strcmp(key, "zero") == 0) {
+        uint32_t *pair = key[0] == 'h' ? r->header : key[0] == 'o' ? r->one : r->zero;
+        pair[0] = first;
+        pair[1] = (uint32_t)v[1];
+    } else if (strcmp(key, "plead") == 0) {
+        r->plead = first;
+    } else if (strcmp(key, "ptrail") == 0) {
+        r->ptrail = first;
+    } else if (strcmp(key, "gap") == 0) {
+        r->gap = first;
+    } else if (strcmp(key, "frequency") == 0) {
+        r->frequency = first;
+    }
+}
+
+/**
+ * Tempos de um código SPACE_ENC: cabeçalho, bits (o mais significativo
+ * primeiro, salvo REVERSE) e marca final
+ */
+static size_t lirc_expand(const lirc_remote_t *r, uint64_t value, unsigned bits, uint16_t *raw) {
+    size_t n = 0;
+    if (r->header[0] && r->header[1]) {
+        raw[n++] = (uint16_t)r->header[0];
+        raw[n++] = (uint16_t)r->header[1];
+    }
+    for (unsigned i = 0; i < bits; i++) {
+        unsigned bit = r->reverse ? i : bits - 1 - i;
+        const uint32_t *pair = value >> bit & 1 ? r->one : r->zero;
+        raw[n++] = (uint16_t)pair[0];
+        raw[n++] = (uint16_t)pair[1];
+    }
+    if (r->ptrail) {
+        raw[n++] = (uint16_t)r->ptrail;
+    }
+    return n;
+}
+
+static bool lirc_add_code(ir_codedb_builder_t *b, const lirc_remote_t *r, const char *key, uint64_t code) {
+    unsigned total = r->pre_bits + r->bits + r->post_bits;
+    if (r->unsupported || total == 0 || total > 64 || (r->plead > 0 && !r->rc5)) {
+        b->rejected++;
+        return false;
+    }
+    uint64_t value = r->pre_data;
+    value = r->bits < 64 ? value << r->bits | (code & ((1ull << r->bits) - 1)) : code;
+    value = r->post_bits ? value << r->post_bits | (r->post_data & ((1ull << r->post_bits) - 1)) : value;
+
+    // RC5: campo (comando bit 6 invertido), toggle, endereço e comando nos
+    // 13 bits finais
+    if (r->rc5) {
+        if (total < 13) {
+            b->rejected++;
+            return false;
+        }
+        uint8_t address = (uint8_t)(value >> 6 & 0x1F);
+        uint8_t command = (uint8_t)((value & 0x3F) | (value >> 12 & 1 ? 0 : 0x40));
+        return ir_codedb_add_code(b, r->name, key, IR_CODEDB_RC5, 14, (uint64_t)address << 8 | command, NULL);
+    }
+    // RC6 modo 0: bit de início, modo 000 e toggle no pre_data, endereço e
+    // comando nos 16 bits finais (21 bits); outros modos (RC6-6-32 e afins)
+    // não cabem no RC6 do banco
+    if (r->rc6) {
+        if (total != 21 || r->pre_bits < 5 || (value >> 17) != 0x8) {
+            b->rejected++;
+            return false;
+        }
+        return ir_codedb_add_code(b, r->name, key, IR_CODEDB_RC6, 16, value & 0xFFFF, NULL);
+    }
+
+    uint16_t raw[3 + 2 * 64];
+    if (!r->one[0] || !r->zero[0] || r->header[0] > UINT16_MAX || r->header[1] > UINT16_MAX ||
+        r->one[0] > UINT16_MAX || r->one[1] > UINT16_MAX || r->zero[0] > UINT16_MAX || r->zero[1] > UINT16_MAX ||
+        r->ptrail > UINT16_MAX) {
+        b->rejected++;
+        return false;
+    }
+    size_t count = lirc_expand(r, value, total, raw);
+    return ir_codedb_add_raw(b, r->name, key, raw, count, r->frequency, r->gap);
+}
+
+size_t ir_codedb_import_lirc(ir_codedb_builder_t *b, const char *text, size_t length) {
+    enum { OUTSIDE, REMOTE, CODES, RAW_CODES } state = OUTSIDE;
+    const char *p = text;
+    const char *end = text + length;
+    line_t line;
+    char token[MAX_TOKEN];
+    lirc_remote_t remote;
+    char raw_name[IR_CODEDB_MAX_NAME] = "";
+    static uint16_t raw[IR_CODEDB_MAX_RAW];
+    size_t raw_count = 0;
+    bool raw_overflow = false;
+    uint32_t accepted = b->keys;
+
+    while (next_line(&p, end, &line)) {
+        if (!next_token(&line, token)) {
+            continue;
+        }
+        bool begin = strcmp(token, "begin") == 0;
+        bool finish = strcmp(token, "end") == 0;
+        char block[MAX_TOKEN] = "";
+        if (begin || finish) {
+            next_token(&line, block);
+        }
+
+        // Fim de um sinal RAW: próximo name ou fim do bloco
+        if (state == RAW_CODES && raw_name[0] && (finish || strcmp(token, "name") == 0)) {
+            if (raw_overflow || !ir_codedb_add_raw(b, remote.name, raw_name, raw, raw_count, remote.frequency,
+                                                   remote.gap)) {
+                b->rejected++;
+            }
+            raw_name[0] = '\0';
+        }
+
+        switch (state) {
+            case OUTSIDE:
+                if (begin && strcmp(block, "remote") == 0) {
+                    memset(&remote, 0, sizeof(remote));
+                    state = REMOTE;
+                }
+                break;
+            case REMOTE:
+                if (begin && strcmp(block, "codes") == 0) {
+                    state = CODES;
+                } else if (begin && strcmp(block, "raw_codes") == 0) {
+                    state = RAW_CODES;
+                } else if (finish && strcmp(block, "remote") == 0) {
+                    state = OUTSIDE;
+                } else {
+                    parse_remote_line(&remote, token, &line);
+                }
+                break;
+            case CODES:
+                if (finish) {
+                    state = REMOTE;
+                } else {
+                    char value[MAX_TOKEN];
+                    uint64_t code;
+                    if (next_token(&line, value) && parse_number(value, &code)) {
+                        lirc_add_code(b, &remote, token, code);
+                    } else {
+                        b->rejected++;
+                    }
+                }
+                break;
+            case RAW_CODES:
+                if (finish) {
+                    state = REMOTE;
+                } else if (strcmp(token, "name") == 0) {
+                    raw_count = 0;
+                    raw_overflow = false;
+                    if (!next_token(&line, raw_name)) {
+                        raw_name[0] = '\0';
+                    }
+                    raw_name[IR_CODEDB_MAX_NAME - 1] = '\0';
+                } else if (raw_name[0]) {
+                    // A linha inteira são tempos (o primeiro já está em token)
+                    do {
+                        uint64_t v;
+                        if (!parse_number(token, &v) || v > UINT16_MAX || raw_count == IR_CODEDB_MAX_RAW) {
+                            raw_overflow = true;
+                        } else {
+                            raw[raw_count++] = (uint16_t)v;
+                        }
+                    } while (next_token(&line, token));
+                }
+                break;
+        }
+    }
+    return b->keys - accepted;
+}
+
+// Pronto
+
+size_t ir_codedb_import_pronto(ir_codedb_builder_t *b, const char *device, const char *text, size_t length) {
+    const char *p = text;
+    const char *end = text + length;
+    line_t line;
+    char name[MAX_TOKEN];
+    char token[MAX_TOKEN];
+    static uint16_t words[4 + IR_CODEDB_MAX_RAW];
+    static uint16_t raw[IR_CODEDB_MAX_RAW];
+    uint32_t accepted = b->keys;
+
+    while (next_line(&p, end, &line)) {
+        if (!next_token(&line, name)) {
+            continue;
+        }
+        size_t n = 0;
+        bool bad = false;
+        while (next_token(&line, token)) {
+            char *stop;
+            unsigned long w = strtoul(token, &stop, 16);
+            if (*stop || w > UINT16_MAX || n == sizeof(words) / sizeof(words[0])) {
+                bad = true;
+                break;
+            }
+            words[n++] = (uint16_t)w;
+        }
+        name[IR_CODEDB_MAX_NAME - 1] = '\0';
+        if (bad || n < 4 || words[1] == 0) {
+            b->rejected++;
+            continue;
+        }
+
+        // Carrier: uma unidade de tempo são words[1] períodos de 0,241246 us
+        double unit_us = words[1] * 0.241246;
+        uint32_t carrier_hz = (uint32_t)(1e6 / unit_us + 0.5);
+        size_t once = words[2];
+        size_t repeat = words[3];
+        bool ok = false;
+        if (words[0] == 0x0000 && n >= 4 + 2 * (once + repeat) && once + repeat > 0) {
+            // Sequência única, ou a de repetição quando não há
+            const uint16_t *seq = once ? &words[4] : &words[4 + 2 * once];
+            size_t count = 2 * (once ? once : repeat);
+            for (size_t i = 0; i < count; i++) {
+                double us = seq[i] * unit_us + 0.5;
+                raw[i] = (uint16_t)(us > UINT16_MAX ? UINT16_MAX : us);
+            }
+            ok = ir_codedb_add_raw(b, device, name, raw, count, carrier_hz, 0);
+        } else if ((words[0] == 0x5000 || words[0] == 0x6000) && n >= 6) {
+            // Formatos de protocolo: sistema e comando
+            bool rc5 = words[0] == 0x5000;
+            uint64_t code = rc5 ? (uint64_t)(words[4] & 0x1F) << 8 | (words[5] & 0x7F)
+                                : (uint64_t)(words[4] & 0xFF) << 8 | (words[5] & 0xFF);
+            ok = ir_codedb_add_code(b, device, name, rc5 ? IR_CODEDB_RC5 : IR_CODEDB_RC6, rc5 ? 14 : 16, code, NULL);
+        }
+        if (!ok) {
+            b->rejected++;
+        }
+    }
+    return b->keys - accepted;
+}
+
+// Montagem da imagem
+
+typedef struct {
+    uint8_t *data;
+    size_t size;
+    size_t capacity;
+} buffer_t;
+
+static bool reserve(buffer_t *buf, size_t extra) {
+    if (buf->size + extra <= buf->capacity) {
+        return true;
+    }
+    size_t capacity = buf->capacity ? buf->capacity : 4096;
+    while (capacity < buf->size + extra) {
+        capacity *= 2;
+    }
+    uint8_t *grown = realloc(buf->data, capacity);
+    if (!grown) {
+        return false;
+    }
+    buf->data = grown;
+    buf->capacity = capacity;
+    return true;
+}
+
+// Nomes repetidos (KEY_POWER em cada dispositivo) são gravados uma vez
+typedef struct {
+    buffer_t text;
+    uint32_t *slots;                    // Offset + 1 (0 = livre)
+    size_t mask;
+} string_pool_t;
+
+static uint32_t hash_name(const char *s) {
+    uint32_t h = 2166136261u;           // FNV-1a
+    for (; *s; s++) {
+        h = (h ^ (uint8_t)*s) * 16777619u;
+    }
+    return h;
+}
+
+static bool pool_add(string_pool_t *pool, const char *s, uint32_t *offset) {
+    size_t i = hash_name(s) & pool->mask;
+    while (pool->slots[i]) {
+        const char *existing = (const char *)pool->text.data + pool->slots[i] - 1;
+        if (strcmp(existing, s) == 0) {
+            *offset = pool->slots[i] - 1;
+            return true;
+        }
+        i = (i + 1) & pool->mask;
+    }
+    size_t length = strlen(s) + 1;
+    if (!reserve(&pool->text, length) || pool->text.size + length > UINT32_MAX) {
+        return false;
+    }
+    *offset = (uint32_t)pool->text.size;
+    memcpy(pool->text.data + pool->text.size, s, length);
+    pool->text.size += length;
+    pool->slots[i] = *offset + 1;
+    return true;
+}
+
+static bool same_timing(const ir_codedb_timing_t *a, const ir_codedb_timing_t *b) {
+    uint32_t tol = IR_CODEDB_LEVEL_TOLERANCE_PCT;
+    return near(a->carrier_hz, b->carrier_hz, tol) && near(a->header_mark_us, b->header_mark_us, tol) &&
+           near(a->header_space_us, b->header_space_us, tol) && near(a->bit_mark_us, b->bit_mark_us, tol) &&
+           near(a->zero_space_us, b->zero_space_us, tol) && near(a->one_space_us, b->one_space_us, tol) &&
+           near(a->gap_us, b->gap_us, tol);
+}
+
+static int compare_u16(const void *a, const void *b) {
+    return (int)*(const uint16_t *)a - (int)*(const uint16_t *)b;
+}
+
+/**
+ * Sinal RAW: tempos agrupados em níveis (cada grupo a até
+ * IR_CODEDB_LEVEL_TOLERANCE_PCT do menor tempo dele), um nibble por tempo; com
+ * mais de 16 níveis, varint
+ */
+static bool encode_raw(buffer_t *buf, const uint16_t *raw, size_t count, uint32_t *size) {
+    static uint16_t sorted[IR_CODEDB_MAX_RAW];
+    uint16_t levels[IR_CODEDB_RAW_LEVELS];
+    uint16_t upper[IR_CODEDB_RAW_LEVELS];       // Maior tempo de cada nível
+    size_t level_count = 0;
+
+    memcpy(sorted, raw, count * sizeof(uint16_t));
+    qsort(sorted, count, sizeof(uint16_t), compare_u16);
+    size_t start = 0;
+    for (size_t i = 1; i <= count && level_count <= IR_CODEDB_RAW_LEVELS; i++) {
+        if (i < count && near(sorted[i], sorted[start], IR_CODEDB_LEVEL_TOLERANCE_PCT)) {
+            continue;
+        }
+        if (level_count < IR_CODEDB_RAW_LEVELS) {
+            uint32_t sum = 0;
+            for (size_t j = start; j < i; j++) {
+                sum += sorted[j];
+            }
+            levels[level_count] = (uint16_t)((sum + (i - start) / 2) / (i - start));
+            upper[level_count] = sorted[i - 1];
+        }
+        level_count++;
+        start = i;
+    }
+
+    size_t before = buf->size;
+    if (level_count > IR_CODEDB_RAW_LEVELS) {
+        if (!reserve(buf, 1 + 3 * count)) {
+            return false;
+        }
+        buf->data[buf->size++] = 0;
+        buf->size += ir_capfile_encode(raw, count, buf->data + buf->size);
+    } else {
+        if (!reserve(buf, 1 + 2 * level_count + (count + 1) / 2)) {
+            return false;
+        }
+        uint8_t *p = buf->data + buf->size;
+        *p++ = (uint8_t)level_count;
+        for (size_t l = 0; l < level_count; l++) {
+            *p++ = (uint8_t)levels[l];
+            *p++ = (uint8_t)(levels[l] >> 8);
+        }
+        memset(p, 0, (count + 1) / 2);
+        for (size_t i = 0; i < count; i++) {
+            uint8_t l = 0;
+            while (raw[i] > upper[l]) {
+                l++;
+            }
+            p[i / 2] |= (uint8_t)(l << (i % 2 * 4));
+        }
+        buf->size = (size_t)(p - buf->data) + (count + 1) / 2;
+    }
+    *size = (uint32_t)(buf->size - before);
+    return true;
+}
+
+static int compare_keys(const void *a, const void *b) {
+    const ir_codedb_import_key_t *x = a;
+    const ir_codedb_import_key_t *y = b;
+    int cmp = strcasecmp(x->name, y->name);
+    return cmp ? cmp : (x->order > y->order) - (x->order < y->order);
+}
+
+static int compare_devices(const void *a, const void *b) {
+    return strcasecmp(((const ir_codedb_import_device_t *)a)->name, ((const ir_codedb_import_device_t *)b)->name);
+}
+
+uint8_t *ir_codedb_build(ir_codedb_builder_t *b, size_t *size) {
+    // Ordem de busca, sem repetidas
+    size_t key_count = 0;
+    for (size_t d = 0; d < b->device_count; d++) {
+        ir_codedb_import_device_t *dev = &b->devices[d];
+        qsort(dev->keys, dev->key_count, sizeof(dev->keys[0]), compare_keys);
+        size_t kept = 0;
+        for (size_t k = 0; k < dev->key_count; k++) {
+            if (kept && strcasecmp(dev->keys[kept - 1].name, dev->keys[k].name) == 0) {
+                free(dev->keys[k].raw);
+                b->duplicates++;
+                continue;
+            }
+            dev->keys[kept++] = dev->keys[k];
+        }
+        dev->key_count = kept;
+        key_count += kept;
+    }
+    qsort(b->devices, b->device_count, sizeof(b->devices[0]), compare_devices);
+    b->last_device = 0;
+
+    // Nomes, tempos e sinais RAW, com offsets relativos às suas áreas
+    size_t slots = 16;
+    while (slots < 2 * (b->device_count + key_count + 1)) {
+        slots *= 2;
+    }
+    string_pool_t pool = {{NULL, 0, 0}, calloc(slots, sizeof(uint32_t)), slots - 1};
+    buffer_t raw = {NULL, 0, 0};
+    ir_codedb_timing_t *timings = NULL;
+    size_t timing_count = 0;
+    uint32_t *device_names = malloc((b->device_count + 1) * sizeof(uint32_t));
+    uint32_t *key_names = malloc((key_count + 1) * sizeof(uint32_t));
+    uint16_t *key_timings = malloc((key_count + 1) * sizeof(uint16_t));
+    uint64_t *key_raw = malloc((key_count + 1) * sizeof(uint64_t));
+    uint8_t *image = NULL;
+    uint32_t empty;
+    bool ok = pool.slots && device_names && key_names && key_timings && key_raw && pool_add(&pool, "", &empty);
+
+    size_t key = 0;
+    for (size_t d = 0; ok && d < b->device_count; d++) {
+        ir_codedb_import_device_t *dev = &b->devices[d];
+        ok = pool_add(&pool, dev->name, &device_names[d]);
+        for (size_t k = 0; ok && k < dev->key_count; k++, key++) {
+            const ir_codedb_import_key_t *kk = &dev->keys[k];
+            ok = pool_add(&pool, kk->name, &key_names[key]);
+            if (!ok) {
+                break;
+            }
+            key_timings[key] = IR_CODEDB_NO_TIMING;
+            key_raw[key] = 0;
+            if (kk->protocol == IR_CODEDB_PULSE_DISTANCE) {
+                size_t t = 0;
+                while (t < timing_count && !same_timing(&timings[t], &kk->timing)) {
+                    t++;
+                }
+                if (t == timing_count) {
+                    ir_codedb_timing_t *grown = timing_count % 64 == 0
+                                                    ? realloc(timings, (timing_count + 64) * sizeof(*timings))
+                                                    : timings;
+                    ok = grown && timing_count < IR_CODEDB_NO_TIMING;
+                    if (!ok) {
+                        break;
+                    }
+                    timings = grown;
+                    timings[timing_count++] = kk->timing;
+                }
+                key_timings[key] = (uint16_t)t;
+            } else if (kk->protocol == IR_CODEDB_RAW) {
+                uint32_t offset = (uint32_t)raw.size;
+                uint32_t bytes = 0;
+                ok = encode_raw(&raw, kk->raw, kk->raw_count, &bytes);
+                if (!ok) {
+                    break;
+                }
+                key_raw[key] = (uint64_t)bytes << 32 | offset;
+            }
+        }
+    }
+
+    // Cabeçalho, tabelas, sinais RAW e nomes (o último termina em zero)
+    uint64_t tables = IR_CODEDB_HEADER_SIZE + (uint64_t)b->device_count * IR_CODEDB_DEVICE_SIZE +
+                      (uint64_t)key_count * IR_CODEDB_KEY_SIZE + (uint64_t)timing_count * IR_CODEDB_TIMING_SIZE;
+    uint64_t total = tables + raw.size + pool.text.size;
+    if (ok && total <= UINT32_MAX) {
+        image = malloc(total);
+    }
+    if (image) {
+        uint32_t names = (uint32_t)(tables + raw.size);
+        uint8_t *p = image;
+        ir_codedb_put_header(p, (uint32_t)b->device_count, (uint32_t)key_count, (uint32_t)timing_count,
+                             (uint32_t)total);
+        p += IR_CODEDB_HEADER_SIZE;
+        uint32_t first = 0;
+        for (size_t d = 0; d < b->device_count; d++) {
+            ir_codedb_put_device(p, names + device_names[d], first, (uint32_t)b->devices[d].key_count);
+            first += (uint32_t)b->devices[d].key_count;
+            p += IR_CODEDB_DEVICE_SIZE;
+        }
+        key = 0;
+        for (size_t d = 0; d < b->device_count; d++) {
+            for (size_t k = 0; k < b->devices[d].key_count; k++, key++) {
+                const ir_codedb_import_key_t *kk = &b->devices[d].keys[k];
+                ir_codedb_code_t code = {
+                    .protocol = kk->protocol,
+                    .bits = kk->bits,
+                    .code = kk->protocol == IR_CODEDB_RAW ? key_raw[key] + tables : kk->code,
+                    .raw_count = kk->raw_count,
+                    .carrier_hz = kk->carrier_hz,
+                };
+                ir_codedb_put_key(p, names + key_names[key], &code, key_timings[key]);
+                p += IR_CODEDB_KEY_SIZE;
+            }
+        }
+        for (size_t t = 0; t < timing_count; t++) {
+            ir_codedb_put_timing(p, &timings[t]);
+            p += IR_CODEDB_TIMING_SIZE;
+        }
+        if (raw.size) {
+            memcpy(p, raw.data, raw.size);
+        }
+        memcpy(p + raw.size, pool.text.data, pool.text.size);
+        *size = (size_t)total;
+    }
+
+    free(pool.slots);
+    free(pool.text.data);
+    free(raw.data);
+    free(timings);
+    free(device_names);
+    free(key_names);
+    free(key_timings);
+    free(key_raw);
+    return image;
+}
@@ -0,0 +1,122 @@
+/**
+ * ir_codedb_import.h - Importação de códigos LIRC e Pronto para o ir_codedb.h
+ *
+ * Cada código é normalizado para protocolo + código quando os tempos
+ * batem com NEC, SIRC ou distância de pulso genérica (RC5 e RC6 vêm das
+ * flags do LIRC ou dos formatos Pronto 5000/6000); o resto fica como RAW,
+ * com os tempos agrupados em até 16 níveis (um nibble por tempo) ou em
+ * varint.
+ *
+ *  - LIRC: arquivos .conf com "begin remote ... end remote" (SPACE_ENC,
+ *    RC5/SHIFT_ENC, RC6 modo 0 e RAW_CODES); o nome do dispositivo é o name
+ *    do remote;
+ *  - Pronto: uma tecla por linha, "<nome> <palavras em hexa>", nos formatos
+ *    0000 (aprendido), 5000 (RC5) e 6000 (RC6 modo 0); o dispositivo é
+ *    dado por quem chama.
+ *
+ * Teclas repetidas em um dispositivo (sem diferenciar maiúsculas de
+ * minúsculas) ficam com o primeiro código importado.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef IR_CODEDB_IMPORT_H
+#define IR_CODEDB_IMPORT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "ir_codedb.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define IR_CODEDB_MAX_NAME 64
+#define IR_CODEDB_MAX_RAW 1024                // Tempos de um código RAW
+#define IR_CODEDB_TOLERANCE_PCT 20            // Desvio aceito ao reconhecer protocolos (eps do LIRC é 30)
+#define IR_CODEDB_LEVEL_TOLERANCE_PCT 4       // Desvio de um tempo RAW para o nível dele
+
+// Tecla importada (raw alocado, só RAW)
+typedef struct {
+    char name[IR_CODEDB_MAX_NAME];
+    uint32_t order;                     // Ordem de importação (a primeira repetida fica)
+    ir_codedb_protocol_t protocol;
+    uint8_t bits;
+    uint64_t code;
+    ir_codedb_timing_t timing;
+    uint16_t carrier_hz;
+    uint16_t raw_count;
+    uint16_t *raw;
+} ir_codedb_import_key_t;
+
+typedef struct {
+    char name[IR_CODEDB_MAX_NAME];
+    ir_codedb_import_key_t *keys;
+    size_t key_count;
+    size_t key_capacity;
+} ir_codedb_import_device_t;
+
+typedef struct {
+    ir_codedb_import_device_t *devices;
+    size_t device_count;
+    size_t device_capacity;
+    size_t last_device;                 // Dispositivo do último código (importação em sequência)
+    uint32_t next_order;
+
+    // Contadores
+    uint32_t keys;                      // Códigos aceitos (inclusive repetidos)
+    uint32_t rejected;                  // Códigos em formato não suportado
+    uint32_t duplicates;                // Teclas repetidas descartadas (ir_codedb_build)
+    uint32_t protocols[IR_CODEDB_PROTOCOL_COUNT];
+} ir_codedb_builder_t;
+
+void ir_codedb_builder_init(ir_codedb_builder_t *b);
+void ir_codedb_builder_free(ir_codedb_builder_t *b);
+
+/**
+ * Normaliza e acrescenta um código capturado (marca, espaço, marca, ...)
+ *
+ * @param carrier_hz Carrier (0 = desconhecido; distância de pulso assume 38 kHz)
+ * @param gap_us Silêncio depois do quadro (0 = o último espaço de raw, se houver)
+ * @return false sem memória ou com count fora de 1..IR_CODEDB_MAX_RAW
+ */
+bool ir_codedb_add_raw(ir_codedb_builder_t *b, const char *device, const char *key, const uint16_t *raw,
+                       size_t count, uint32_t carrier_hz, uint32_t gap_us);
+
+/**
+ * Acrescenta um código já normalizado (protocolo diferente de RAW)
+ */
+bool ir_codedb_add_code(ir_codedb_builder_t *b, const char *device, const char *key, ir_codedb_protocol_t protocol,
+                        uint8_t bits, uint64_t code, const ir_codedb_timing_t *timing);
+
+/**
+ * Importa os remotes de um .conf do LIRC
+ *
+ * @return Códigos aceitos
+ */
+size_t ir_codedb_import_lirc(ir_codedb_builder_t *b, const char *text, size_t length);
+
+/**
+ * Importa códigos Pronto de um texto, todos no dispositivo dado
+ *
+ * @return Códigos aceitos
+ */
+size_t ir_codedb_import_pronto(ir_codedb_builder_t *b, const char *device, const char *text, size_t length);
+
+/**
+ * Monta a imagem: ordena dispositivos e teclas, descarta repetidas,
+ * compartilha nomes e tempos parecidos
+ *
+ * @param size Recebe o tamanho da imagem
+ * @return Imagem alocada (free), ou NULL sem memória ou acima de 4 GB
+ */
+uint8_t *ir_codedb_build(ir_codedb_builder_t *b, size_t *size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IR_CODEDB_IMPORT_H
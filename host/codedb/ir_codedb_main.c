@@ -0,0 +1,167 @@
+/**
+ * ir_codedb_main.c - Monta a imagem do banco de códigos (ir_codedb.h)
+ *
+ * Uso: ir_codedb -o <saida.irdb | saida.c> [--name <vetor>] [--list]
+ *                <remotes.conf | --pronto <dispositivo> <codigos.txt>>...
+ *
+ * Com saída .c, a imagem vira "const uint8_t <vetor>[]" (padrão
+ * ir_codedb_image) para entrar no firmware e ser aberta com
+ * ir_codedb_open(). --list imprime as teclas da imagem montada.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ir_codedb_import.h"
+
+static char *read_file(const char *path, size_t *size) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        return NULL;
+    }
+    char *text = NULL;
+    size_t used = 0;
+    size_t capacity = 0;
+    size_t n;
+    do {
+        if (used == capacity) {
+            capacity = capacity ? capacity * 2 : 65536;
+            char *grown = realloc(text, capacity);
+            if (!grown) {
+                free(text);
+                fclose(f);
+                return NULL;
+            }
+            text = grown;
+        }
+        n = fread(text + used, 1, capacity - used, f);
+        used += n;
+    } while (n > 0);
+    fclose(f);
+    *size = used;
+    return text;
+}
+
+static bool write_image(const char *path, const char *name, const uint8_t *image, size_t size) {
+    FILE *out = fopen(path, "wb");
+    if (!out) {
+        perror(path);
+        return false;
+    }
+    size_t length = strlen(path);
+    if (length > 2 && strcmp(path + length - 2, ".c") == 0) {
+        fprintf(out, "// Gerado por ir_codedb: abra com ir_codedb_open(&db, %s, sizeof(%s))\n\n", name, name);
+        fprintf(out, "#include <stdint.h>\n\n");
+        fprintf(out, "const uint8_t %s[%zu] __attribute__((aligned(4))) = {\n", name, size);
+        for (size_t i = 0; i < size; i++) {
+            fprintf(out, "%s0x%02X%s", i % 12 == 0 ? "    " : "", image[i],
+                    i == size - 1 ? "\n" : (i % 12 == 11 ? ",\n" : ", "));
+        }
+        fprintf(out, "};\n");
+    } else {
+        fwrite(image, 1, size, out);
+    }
+    return fclose(out) == 0;
+}
+
+static void list_image(const uint8_t *image, size_t size) {
+    ir_codedb_t db;
+    if (ir_codedb_open(&db, image, size) != IR_CODEDB_OK) {
+        return;
+    }
+    for (uint32_t d = 0; d < db.device_count; d++) {
+        ir_codedb_device_t dev;
+        ir_codedb_device(&db, d, &dev);
+        printf("%s (%u teclas)\n", dev.name, dev.key_count);
+        for (uint32_t k = 0; k < dev.key_count; k++) {
+            ir_codedb_code_t code;
+            if (!ir_codedb_key(&db, (int32_t)d, k, &code)) {
+                continue;
+            }
+            if (code.protocol == IR_CODEDB_RAW) {
+                printf("  %-24s RAW, %u tempos em %u bytes\n", code.name, code.raw_count, code.raw_size);
+            } else {
+                printf("  %-24s %s, %u bits, 0x%llX\n", code.name, ir_codedb_protocol_name(code.protocol), code.bits,
+                       (unsigned long long)code.code);
+            }
+        }
+    }
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "uso: %s -o <saida.irdb | saida.c> [--name <vetor>] [--list]\n"
+                    "       <remotes.conf | --pronto <dispositivo> <codigos.txt>>...\n", argv0);
+}
+
+int main(int argc, char **argv) {
+    const char *output = NULL;
+    const char *name = "ir_codedb_image";
+    bool list = false;
+    ir_codedb_builder_t b;
+    ir_codedb_builder_init(&b);
+
+    size_t inputs = 0;
+    for (int i = 1; i < argc; i++) {
+        const char *device = NULL;
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            output = argv[++i];
+            continue;
+        } else if (strcmp(argv[i], "--name") == 0 && i + 1 < argc) {
+            name = argv[++i];
+            continue;
+        } else if (strcmp(argv[i], "--list") == 0) {
+            list = true;
+            continue;
+        } else if (strcmp(argv[i], "--pronto") == 0 && i + 2 < argc) {
+            device = argv[++i];
+            i++;
+        } else if (argv[i][0] == '-') {
+            usage(argv[0]);
+            return 2;
+        }
+
+        size_t size;
+        char *text = read_file(argv[i], &size);
+        if (!text) {
+            perror(argv[i]);
+            return 1;
+        }
+        size_t accepted = device ? ir_codedb_import_pronto(&b, device, text, size)
+                                 : ir_codedb_import_lirc(&b, text, size);
+        printf("%s: %zu código(s)\n", argv[i], accepted);
+        free(text);
+        inputs++;
+    }
+    if (!output || inputs == 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    size_t size;
+    uint8_t *image = ir_codedb_build(&b, &size);
+    if (!image) {
+        fprintf(stderr, "ir_codedb: sem memória para a imagem\n");
+        return 1;
+    }
+    size_t keys = b.keys - b.duplicates;
+    printf("%zu dispositivo(s), %zu tecla(s) (%u repetida(s), %u código(s) não suportado(s))\n", b.device_count, keys,
+           b.duplicates, b.rejected);
+    for (int p = 0; p < IR_CODEDB_PROTOCOL_COUNT; p++) {
+        if (b.protocols[p]) {
+            printf("  %-20s %u\n", ir_codedb_protocol_name((ir_codedb_protocol_t)p), b.protocols[p]);
+        }
+    }
+    printf("%zu bytes (%.1f por tecla)\n", size, keys ? (double)size / keys : 0.0);
+    if (list) {
+        list_image(image, size);
+    }
+
+    bool ok = write_image(output, name, image, size);
+    free(image);
+    ir_codedb_builder_free(&b);
+    return ok ? 0 : 1;
+}
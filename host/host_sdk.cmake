@@ -0,0 +1,43 @@
+# Compilação para o host (Linux) sem o Pico SDK
+#
+# Define os mesmos alvos e funções que as bibliotecas do projeto usam no
+# firmware (pico_stdlib, hardware_*, pico_generate_pio_header), apontando para
+# o shim em host/sdk e para o montador host/pioasm. Assim os CMakeLists.txt das
+# bibliotecas são reaproveitados sem alteração.
+
+# Mesmo padrão do pico_sdk_init(): sem tipo de build, compila otimizado (os
+# benchmarks medem o código como ele roda no firmware)
+if (NOT CMAKE_BUILD_TYPE)
+    set(CMAKE_BUILD_TYPE Release)
+endif()
+
+add_executable(pioasm_lite ${CMAKE_CURRENT_LIST_DIR}/pioasm/pioasm_lite.c)
+
+add_library(host_sdk STATIC
+    ${CMAKE_CURRENT_LIST_DIR}/sdk/host_sdk.c
+    ${CMAKE_CURRENT_LIST_DIR}/sdk/host_pio.c
+    ${CMAKE_CURRENT_LIST_DIR}/sdk/host_dma.c
+)
+
+target_include_directories(host_sdk PUBLIC
+    ${CMAKE_CURRENT_LIST_DIR}/sdk/include
+    ${CMAKE_CURRENT_LIST_DIR}/sdk
+)
+
+foreach(LIB pico_stdlib pico_time hardware_gpio hardware_timer hardware_pio hardware_pwm hardware_clocks hardware_sync hardware_dma)
+    add_library(${LIB} INTERFACE)
+    target_link_libraries(${LIB} INTERFACE host_sdk)
+endforeach()
+
+# Mesma assinatura do SDK: gera <nome>.pio.h no diretório binário atual
+function(pico_generate_pio_header TARGET PIO)
+    get_filename_component(PIO_NAME ${PIO} NAME)
+    set(HEADER ${CMAKE_CURRENT_BINARY_DIR}/${PIO_NAME}.h)
+    add_custom_command(OUTPUT ${HEADER}
+        COMMAND pioasm_lite ${PIO} ${HEADER}
+        DEPENDS pioasm_lite ${PIO}
+        COMMENT "pioasm_lite ${PIO_NAME}"
+    )
+    add_custom_target(${TARGET}_${PIO_NAME}_h DEPENDS ${HEADER})
+    add_dependencies(${TARGET} ${TARGET}_${PIO_NAME}_h)
+endfunction()
@@ -0,0 +1,717 @@
+/**
+ * pioasm_lite.c - Montador PIO mínimo para a compilação no host
+ *
+ * Gera, a partir dos mesmos arquivos .pio usados no firmware, um cabeçalho
+ * compatível com o formato "c-sdk" do pioasm oficial (programa montado,
+ * *_program_get_default_config() e o bloco "% c-sdk"). Cobre o conjunto de
+ * instruções do PIO versão 0, .define, .wrap_target/.wrap, .side_set,
+ * .origin e rótulos públicos.
+ *
+ * Uso: pioasm_lite <entrada.pio> <saida.pio.h>
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#define MAX_LINES 2048
+#define MAX_SYMBOLS 128
+#define MAX_PROGRAMS 8
+#define MAX_TOKENS 32
+#define MAX_INSTR 32
+#define NAME_LEN 64
+#define CSDK_LEN 16384
+
+typedef struct {
+    char name[NAME_LEN];
+    long value;
+    bool is_public;
+    bool is_label;
+    int program;    // -1 = global
+} symbol_t;
+
+typedef struct {
+    char name[NAME_LEN];
+    uint16_t instr[MAX_INSTR];
+    char text[MAX_INSTR][96];
+    int length;
+    int wrap_target;
+    int wrap;
+    int origin;
+    int sideset_bits;
+    bool sideset_opt;
+    bool sideset_pindirs;
+    char csdk[CSDK_LEN];
+} program_t;
+
+static symbol_t symbols[MAX_SYMBOLS];
+static int symbol_count;
+static program_t programs[MAX_PROGRAMS];
+static int program_count;
+static int pio_version;
+
+static const char *input_path;
+static int line_no;
+
+static void die(const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    fprintf(stderr, "%s:%d: error: ", input_path, line_no);
+    vfprintf(stderr, fmt, ap);
+    fprintf(stderr, "\n");
+    va_end(ap);
+    exit(1);
+}
+
+// ---------------------------------------------------------------------------
+// Símbolos
+// ---------------------------------------------------------------------------
+
+static symbol_t *find_symbol(const char *name, int program) {
+    for (int i = 0; i < symbol_count; i++) {
+        if (strcmp(symbols[i].name, name) == 0 && (symbols[i].program == program || symbols[i].program == -1)) {
+            return &symbols[i];
+        }
+    }
+    return NULL;
+}
+
+static void add_symbol(const char *name, long value, bool is_public, bool is_label, int program) {
+    symbol_t *s = find_symbol(name, program);
+    if (!s) {
+        if (symbol_count >= MAX_SYMBOLS) {
+            die("too many symbols");
+        }
+        s = &symbols[symbol_count++];
+    }
+    snprintf(s->name, NAME_LEN, "%s", name);
+    s->value = value;
+    s->is_public = is_public;
+    s->is_label = is_label;
+    s->program = program;
+}
+
+// ---------------------------------------------------------------------------
+// Tokens e expressões
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    char tok[MAX_TOKENS][NAME_LEN];
+    int count;
+    int pos;
+} tokens_t;
+
+static void tokenize(const char *s, tokens_t *t) {
+    t->count = t->pos = 0;
+    while (*s) {
+        if (isspace((unsigned char)*s) || *s == ',') {
+            s++;
+            continue;
+        }
+        if (t->count >= MAX_TOKENS) {
+            die("line too long");
+        }
+        char *out = t->tok[t->count++];
+        if (isalnum((unsigned char)*s) || *s == '_') {
+            int n = 0;
+            while ((isalnum((unsigned char)*s) || *s == '_') && n < NAME_LEN - 1) {
+                out[n++] = *s++;
+            }
+            out[n] = '\0';
+        } else if ((s[0] == '-' && s[1] == '-') || (s[0] == '!' && s[1] == '=') || (s[0] == ':' && s[1] == ':') ||
+                   (s[0] == '<' && s[1] == '<') || (s[0] == '>' && s[1] == '>')) {
+            out[0] = s[0];
+            out[1] = s[1];
+            out[2] = '\0';
+            s += 2;
+        } else {
+            out[0] = *s++;
+            out[1] = '\0';
+        }
+    }
+}
+
+static const char *peek(tokens_t *t) {
+    return t->pos < t->count ? t->tok[t->pos] : "";
+}
+
+static const char *next(tokens_t *t) {
+    return t->pos < t->count ? t->tok[t->pos++] : "";
+}
+
+static bool accept(tokens_t *t, const char *s) {
+    if (strcasecmp(peek(t), s) == 0) {
+        t->pos++;
+        return true;
+    }
+    return false;
+}
+
+static int current_program = -1;
+static long parse_expr(tokens_t *t);
+
+static long parse_primary(tokens_t *t) {
+    const char *tok = next(t);
+    if (strcmp(tok, "(") == 0) {
+        long v = parse_expr(t);
+        if (!accept(t, ")")) {
+            die("expected ')'");
+        }
+        return v;
+    }
+    if (strcmp(tok, "-") == 0) {
+        return -parse_primary(t);
+    }
+    if (strcmp(tok, "~") == 0) {
+        return ~parse_primary(t);
+    }
+    if (isdigit((unsigned char)tok[0])) {
+        if (tok[0] == '0' && (tok[1] == 'b' || tok[1] == 'B')) {
+            return strtol(tok + 2, NULL, 2);
+        }
+        return strtol(tok, NULL, 0);
+    }
+    symbol_t *s = find_symbol(tok, current_program);
+    if (!s) {
+        die("undefined symbol '%s'", tok);
+    }
+    return s->value;
+}
+
+static long parse_term(tokens_t *t) {
+    long v = parse_primary(t);
+    while (true) {
+        if (accept(t, "*")) {
+            v *= parse_primary(t);
+        } else if (accept(t, "/")) {
+            v /= parse_primary(t);
+        } else if (accept(t, "%")) {
+            v %= parse_primary(t);
+        } else {
+            return v;
+        }
+    }
+}
+
+static long parse_sum(tokens_t *t) {
+    long v = parse_term(t);
+    while (true) {
+        if (accept(t, "+")) {
+            v += parse_term(t);
+        } else if (accept(t, "-")) {
+            v -= parse_term(t);
+        } else {
+            return v;
+        }
+    }
+}
+
+static long parse_expr(tokens_t *t) {
+    long v = parse_sum(t);
+    while (true) {
+        if (accept(t, "<<")) {
+            v <<= parse_sum(t);
+        } else if (accept(t, ">>")) {
+            v >>= parse_sum(t);
+        } else if (accept(t, "&")) {
+            v &= parse_sum(t);
+        } else if (accept(t, "|")) {
+            v |= parse_sum(t);
+        } else if (accept(t, "^")) {
+            v ^= parse_sum(t);
+        } else {
+            return v;
+        }
+    }
+}
+
+static bool at_end_of_operands(tokens_t *t) {
+    const char *p = peek(t);
+    return p[0] == '\0' || strcmp(p, "[") == 0 || strcasecmp(p, "side") == 0;
+}
+
+// ---------------------------------------------------------------------------
+// Codificação das instruções (RP2040 datasheet, seção 3.4)
+// ---------------------------------------------------------------------------
+
+static int lookup(const char *name, const char *const *table, int n) {
+    for (int i = 0; i < n; i++) {
+        if (table[i] && strcasecmp(name, table[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static uint16_t encode_jmp(tokens_t *t) {
+    int cond = 0;
+    const char *p = peek(t);
+    if (strcmp(p, "!") == 0) {
+        next(t);
+        const char *r = next(t);
+        if (strcasecmp(r, "x") == 0) {
+            cond = 1;
+        } else if (strcasecmp(r, "y") == 0) {
+            cond = 3;
+        } else if (strcasecmp(r, "osre") == 0) {
+            cond = 7;
+        } else {
+            die("bad jmp condition '!%s'", r);
+        }
+    } else if ((strcasecmp(p, "x") == 0 || strcasecmp(p, "y") == 0) && t->pos + 1 < t->count &&
+               (strcmp(t->tok[t->pos + 1], "--") == 0 || strcmp(t->tok[t->pos + 1], "!=") == 0)) {
+        bool is_x = strcasecmp(next(t), "x") == 0;
+        const char *op = next(t);
+        if (strcmp(op, "--") == 0) {
+            cond = is_x ? 2 : 4;
+        } else {
+            if (!is_x || strcasecmp(next(t), "y") != 0) {
+                die("only 'x!=y' is supported");
+            }
+            cond = 5;
+        }
+    } else if (strcasecmp(p, "pin") == 0) {
+        next(t);
+        cond = 6;
+    }
+    long target = parse_expr(t);
+    return (uint16_t)(0x0000 | (cond << 5) | (target & 0x1f));
+}
+
+static uint16_t encode_wait(tokens_t *t) {
+    long polarity = parse_expr(t);
+    static const char *const sources[] = {"gpio", "pin", "irq"};
+    int src = lookup(next(t), sources, 3);
+    if (src < 0) {
+        die("bad wait source");
+    }
+    long index = parse_expr(t);
+    if (src == 2 && accept(t, "rel")) {
+        index |= 0x10;
+    }
+    return (uint16_t)(0x2000 | ((polarity & 1) << 7) | (src << 5) | (index & 0x1f));
+}
+
+static uint16_t encode_in(tokens_t *t) {
+    static const char *const sources[] = {"pins", "x", "y", "null", NULL, NULL, "isr", "osr"};
+    int src = lookup(next(t), sources, 8);
+    if (src < 0) {
+        die("bad in source");
+    }
+    long count = parse_expr(t);
+    return (uint16_t)(0x4000 | (src << 5) | (count & 0x1f));
+}
+
+static uint16_t encode_out(tokens_t *t) {
+    static const char *const dests[] = {"pins", "x", "y", "null", "pindirs", "pc", "isr", "exec"};
+    int dst = lookup(next(t), dests, 8);
+    if (dst < 0) {
+        die("bad out destination");
+    }
+    long count = parse_expr(t);
+    return (uint16_t)(0x6000 | (dst << 5) | (count & 0x1f));
+}
+
+static uint16_t encode_push_pull(tokens_t *t, bool pull) {
+    bool cond = false;
+    bool block = true;
+    while (!at_end_of_operands(t)) {
+        const char *w = next(t);
+        if (strcasecmp(w, pull ? "ifempty" : "iffull") == 0) {
+            cond = true;
+        } else if (strcasecmp(w, "block") == 0) {
+            block = true;
+        } else if (strcasecmp(w, "noblock") == 0) {
+            block = false;
+        } else {
+            die("bad %s option '%s'", pull ? "pull" : "push", w);
+        }
+    }
+    return (uint16_t)(0x8000 | (pull ? 0x80 : 0) | (cond ? 0x40 : 0) | (block ? 0x20 : 0));
+}
+
+static uint16_t encode_mov(tokens_t *t) {
+    static const char *const dests[] = {"pins", "x", "y", NULL, "exec", "pc", "isr", "osr"};
+    static const char *const sources[] = {"pins", "x", "y", "null", NULL, "status", "isr", "osr"};
+    int dst = lookup(next(t), dests, 8);
+    if (dst < 0) {
+        die("bad mov destination");
+    }
+    int op = 0;
+    if (accept(t, "!") || accept(t, "~")) {
+        op = 1;
+    } else if (accept(t, "::")) {
+        op = 2;
+    }
+    int src = lookup(next(t), sources, 8);
+    if (src < 0) {
+        die("bad mov source");
+    }
+    return (uint16_t)(0xa000 | (dst << 5) | (op << 3) | src);
+}
+
+static uint16_t encode_irq(tokens_t *t) {
+    bool clear = false;
+    bool wait = false;
+    if (accept(t, "set") || accept(t, "nowait")) {
+    } else if (accept(t, "wait")) {
+        wait = true;
+    } else if (accept(t, "clear")) {
+        clear = true;
+    }
+    long index = parse_expr(t);
+    if (accept(t, "rel")) {
+        index |= 0x10;
+    }
+    return (uint16_t)(0xc000 | (clear ? 0x40 : 0) | (wait ? 0x20 : 0) | (index & 0x1f));
+}
+
+static uint16_t encode_set(tokens_t *t) {
+    static const char *const dests[] = {"pins", "x", "y", NULL, "pindirs"};
+    int dst = lookup(next(t), dests, 5);
+    if (dst < 0) {
+        die("bad set destination");
+    }
+    long value = parse_expr(t);
+    return (uint16_t)(0xe000 | (dst << 5) | (value & 0x1f));
+}
+
+static uint16_t encode_instruction(tokens_t *t, program_t *prog) {
+    const char *mnemonic = next(t);
+    uint16_t instr;
+
+    if (strcasecmp(mnemonic, "jmp") == 0) {
+        instr = encode_jmp(t);
+    } else if (strcasecmp(mnemonic, "wait") == 0) {
+        instr = encode_wait(t);
+    } else if (strcasecmp(mnemonic, "in") == 0) {
+        instr = encode_in(t);
+    } else if (strcasecmp(mnemonic, "out") == 0) {
+        instr = encode_out(t);
+    } else if (strcasecmp(mnemonic, "push") == 0) {
+        instr = encode_push_pull(t, false);
+    } else if (strcasecmp(mnemonic, "pull") == 0) {
+        instr = encode_push_pull(t, true);
+    } else if (strcasecmp(mnemonic, "mov") == 0) {
+        instr = encode_mov(t);
+    } else if (strcasecmp(mnemonic, "irq") == 0) {
+        instr = encode_irq(t);
+    } else if (strcasecmp(mnemonic, "set") == 0) {
+        instr = encode_set(t);
+    } else if (strcasecmp(mnemonic, "nop") == 0) {
+        instr = 0xa042;     // mov y, y
+    } else {
+        die("unknown instruction '%s'", mnemonic);
+    }
+
+    int side_bits = prog->sideset_bits + (prog->sideset_opt ? 1 : 0);
+    int delay_bits = 5 - side_bits;
+    long side = -1;
+    long delay = 0;
+
+    while (t->pos < t->count) {
+        if (accept(t, "side")) {
+            side = parse_expr(t);
+        } else if (accept(t, "[")) {
+            delay = parse_expr(t);
+            if (!accept(t, "]")) {
+                die("expected ']'");
+            }
+        } else {
+            die("unexpected '%s'", peek(t));
+        }
+    }
+
+    if (delay < 0 || delay >= (1L << delay_bits)) {
+        die("delay %ld does not fit in %d bits", delay, delay_bits);
+    }
+    if (side < 0 && side_bits > 0 && !prog->sideset_opt) {
+        die("side-set value required");
+    }
+
+    uint16_t field = (uint16_t)delay;
+    if (side >= 0) {
+        if (side_bits == 0) {
+            die("side-set used without .side_set");
+        }
+        if (prog->sideset_opt) {
+            field |= (uint16_t)(0x10 | ((side & ((1 << prog->sideset_bits) - 1)) << delay_bits));
+        } else {
+            field |= (uint16_t)((side & ((1 << side_bits) - 1)) << delay_bits);
+        }
+    }
+    return (uint16_t)(instr | (field << 8));
+}
+
+// ---------------------------------------------------------------------------
+// Leitura do arquivo
+// ---------------------------------------------------------------------------
+
+static char lines[MAX_LINES][256];
+static int line_count;
+
+static void strip_comment(char *s) {
+    for (char *p = s; *p; p++) {
+        if (*p == ';' || (p[0] == '/' && p[1] == '/')) {
+            *p = '\0';
+            return;
+        }
+    }
+}
+
+static char *trim(char *s) {
+    while (isspace((unsigned char)*s)) {
+        s++;
+    }
+    char *e = s + strlen(s);
+    while (e > s && isspace((unsigned char)e[-1])) {
+        *--e = '\0';
+    }
+    return s;
+}
+
+// Separa um rótulo no início da linha; devolve o resto
+static char *split_label(char *s, char *label, bool *is_public) {
+    *is_public = false;
+    label[0] = '\0';
+    char *p = s;
+    if (strncasecmp(p, "public ", 7) == 0) {
+        p += 7;
+        while (isspace((unsigned char)*p)) {
+            p++;
+        }
+    }
+    char *q = p;
+    while (isalnum((unsigned char)*q) || *q == '_') {
+        q++;
+    }
+    if (q > p && *q == ':' && q[1] != ':') {
+        *is_public = p != s;
+        snprintf(label, NAME_LEN, "%.*s", (int)(q - p), p);
+        return trim(q + 1);
+    }
+    return s;
+}
+
+static void assemble(bool emit) {
+    int prog_index = -1;
+    bool in_csdk = false;
+    current_program = -1;
+
+    for (line_no = 1; line_no <= line_count; line_no++) {
+        char buf[256];
+        snprintf(buf, sizeof(buf), "%s", lines[line_no - 1]);
+
+        if (in_csdk) {
+            if (strncmp(trim(buf), "%}", 2) == 0) {
+                in_csdk = false;
+            } else if (emit && prog_index >= 0) {
+                program_t *p = &programs[prog_index];
+                strncat(p->csdk, lines[line_no - 1], CSDK_LEN - strlen(p->csdk) - 2);
+                strcat(p->csdk, "\n");
+            }
+            continue;
+        }
+
+        char *s = trim(buf);
+        if (s[0] == '%') {
+            in_csdk = strstr(s, "c-sdk") != NULL;
+            if (!in_csdk) {
+                // blocos de outras linguagens são ignorados até o '%}'
+                while (line_no < line_count && strncmp(trim(lines[line_no]), "%}", 2) != 0) {
+                    line_no++;
+                }
+                line_no++;
+            }
+            continue;
+        }
+
+        strip_comment(s);
+        s = trim(s);
+        if (!*s) {
+            continue;
+        }
+
+        program_t *prog = prog_index >= 0 ? &programs[prog_index] : NULL;
+        tokens_t t;
+
+        if (s[0] == '.') {
+            char directive[NAME_LEN];
+            sscanf(s, "%63s", directive);
+            tokenize(s + strlen(directive), &t);
+
+            if (strcasecmp(directive, ".program") == 0) {
+                prog_index++;
+                if (!emit) {
+                    if (program_count >= MAX_PROGRAMS) {
+                        die("too many programs");
+                    }
+                    program_count++;
+                    snprintf(programs[prog_index].name, NAME_LEN, "%s", next(&t));
+                    programs[prog_index].wrap_target = -1;
+                    programs[prog_index].wrap = -1;
+                    programs[prog_index].origin = -1;
+                }
+                programs[prog_index].length = 0;
+                current_program = prog_index;
+            } else if (strcasecmp(directive, ".define") == 0) {
+                bool is_public = accept(&t, "public");
+                char name[NAME_LEN];
+                snprintf(name, NAME_LEN, "%s", next(&t));
+                add_symbol(name, parse_expr(&t), is_public, false, prog_index);
+            } else if (strcasecmp(directive, ".wrap_target") == 0) {
+                prog->wrap_target = prog->length;
+            } else if (strcasecmp(directive, ".wrap") == 0) {
+                prog->wrap = prog->length - 1;
+            } else if (strcasecmp(directive, ".origin") == 0) {
+                prog->origin = (int)parse_expr(&t);
+            } else if (strcasecmp(directive, ".side_set") == 0) {
+                prog->sideset_bits = (int)parse_expr(&t);
+                while (t.pos < t.count) {
+                    if (accept(&t, "opt")) {
+                        prog->sideset_opt = true;
+                    } else if (accept(&t, "pindirs")) {
+                        prog->sideset_pindirs = true;
+                    } else {
+                        die("bad .side_set option");
+                    }
+                }
+            } else if (strcasecmp(directive, ".pio_version") == 0) {
+                pio_version = (int)parse_expr(&t);
+            } else if (strcasecmp(directive, ".lang_opt") == 0 || strcasecmp(directive, ".clock_div") == 0 ||
+                       strcasecmp(directive, ".fifo") == 0 || strcasecmp(directive, ".in") == 0 ||
+                       strcasecmp(directive, ".out") == 0 || strcasecmp(directive, ".set") == 0 ||
+                       strcasecmp(directive, ".mov_status") == 0) {
+                // opções de configuração não usadas pelo projeto
+            } else {
+                die("unknown directive '%s'", directive);
+            }
+            continue;
+        }
+
+        if (!prog) {
+            die("instruction outside of .program");
+        }
+
+        char label[NAME_LEN];
+        bool is_public;
+        s = split_label(s, label, &is_public);
+        if (label[0]) {
+            if (!emit) {
+                add_symbol(label, prog->length, is_public, true, prog_index);
+            }
+            if (!*s) {
+                continue;
+            }
+        }
+
+        if (prog->length >= MAX_INSTR) {
+            die("program too long");
+        }
+        if (emit) {
+            tokenize(s, &t);
+            prog->instr[prog->length] = encode_instruction(&t, prog);
+            snprintf(prog->text[prog->length], sizeof(prog->text[0]), "%s", s);
+        }
+        prog->length++;
+    }
+}
+
+static void write_header(FILE *out) {
+    fprintf(out, "// -------------------------------------------------- //\n");
+    fprintf(out, "// This file is autogenerated by pioasm_lite; do not edit! //\n");
+    fprintf(out, "// -------------------------------------------------- //\n\n");
+    fprintf(out, "#pragma once\n\n");
+    fprintf(out, "#if !PICO_NO_HARDWARE\n#include \"hardware/pio.h\"\n#endif\n\n");
+
+    for (int i = 0; i < program_count; i++) {
+        program_t *p = &programs[i];
+        int wrap_target = p->wrap_target < 0 ? 0 : p->wrap_target;
+        int wrap = p->wrap < 0 ? p->length - 1 : p->wrap;
+
+        fprintf(out, "// %s\n\n", p->name);
+        fprintf(out, "#define %s_wrap_target %d\n", p->name, wrap_target);
+        fprintf(out, "#define %s_wrap %d\n", p->name, wrap);
+        fprintf(out, "#define %s_pio_version %d\n\n", p->name, pio_version);
+
+        for (int s = 0; s < symbol_count; s++) {
+            if (symbols[s].is_public && (symbols[s].program == i || symbols[s].program == -1)) {
+                if (symbols[s].is_label) {
+                    fprintf(out, "#define %s_offset_%s %ldu\n", p->name, symbols[s].name, symbols[s].value);
+                } else {
+                    fprintf(out, "#define %s_%s %ld\n", p->name, symbols[s].name, symbols[s].value);
+                }
+            }
+        }
+
+        fprintf(out, "\nstatic const uint16_t %s_program_instructions[] = {\n", p->name);
+        for (int n = 0; n < p->length; n++) {
+            if (n == wrap_target) {
+                fprintf(out, "            //     .wrap_target\n");
+            }
+            fprintf(out, "    0x%04x, // %2d: %s\n", p->instr[n], n, p->text[n]);
+            if (n == wrap) {
+                fprintf(out, "            //     .wrap\n");
+            }
+        }
+        fprintf(out, "};\n\n");
+
+        fprintf(out, "#if !PICO_NO_HARDWARE\n");
+        fprintf(out, "static const struct pio_program %s_program = {\n", p->name);
+        fprintf(out, "    .instructions = %s_program_instructions,\n", p->name);
+        fprintf(out, "    .length = %d,\n", p->length);
+        fprintf(out, "    .origin = %d,\n", p->origin);
+        fprintf(out, "    .pio_version = %d,\n", pio_version);
+        fprintf(out, "};\n\n");
+
+        fprintf(out, "static inline pio_sm_config %s_program_get_default_config(uint offset) {\n", p->name);
+        fprintf(out, "    pio_sm_config c = pio_get_default_sm_config();\n");
+        fprintf(out, "    sm_config_set_wrap(&c, offset + %s_wrap_target, offset + %s_wrap);\n", p->name, p->name);
+        if (p->sideset_bits > 0) {
+            fprintf(out, "    sm_config_set_sideset(&c, %d, %s, %s);\n", p->sideset_bits + (p->sideset_opt ? 1 : 0),
+                    p->sideset_opt ? "true" : "false", p->sideset_pindirs ? "true" : "false");
+        }
+        fprintf(out, "    return c;\n}\n");
+        fprintf(out, "%s", p->csdk);
+        fprintf(out, "#endif\n\n");
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc != 3) {
+        fprintf(stderr, "usage: %s <input.pio> <output.h>\n", argv[0]);
+        return 2;
+    }
+    input_path = argv[1];
+
+    FILE *in = fopen(input_path, "r");
+    if (!in) {
+        perror(input_path);
+        return 1;
+    }
+    while (line_count < MAX_LINES && fgets(lines[line_count], sizeof(lines[0]), in)) {
+        lines[line_count][strcspn(lines[line_count], "\r\n")] = '\0';
+        line_count++;
+    }
+    fclose(in);
+
+    assemble(false);    // primeira passada: rótulos, .define e tamanhos
+    assemble(true);     // segunda passada: monta as instruções
+
+    FILE *out = fopen(argv[2], "w");
+    if (!out) {
+        perror(argv[2]);
+        return 1;
+    }
+    write_header(out);
+    fclose(out);
+    return 0;
+}
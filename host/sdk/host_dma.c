@@ -0,0 +1,187 @@
+/**
+ * host_dma.c - Canais de DMA pagos pelos FIFOs dos PIOs simulados
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <string.h>
+
+#include "hardware/dma.h"
+#include "hardware/pio.h"
+#include "hardware/timer.h"
+#include "host_sdk.h"
+
+dma_channel_hw_t host_dma_channels[NUM_DMA_CHANNELS];
+timer_hw_t host_timer_hw;
+
+static dma_channel_config configs[NUM_DMA_CHANNELS];
+static uint32_t reload_counts[NUM_DMA_CHANNELS];   // Último TRANS_COUNT escrito
+static bool claimed[NUM_DMA_CHANNELS];
+
+void host_dma_reset(void) {
+    memset(host_dma_channels, 0, sizeof(host_dma_channels));
+    memset(configs, 0, sizeof(configs));
+    memset(reload_counts, 0, sizeof(reload_counts));
+    memset(claimed, 0, sizeof(claimed));
+}
+
+int dma_claim_unused_channel(bool required) {
+    (void)required;
+    for (uint ch = 0; ch < NUM_DMA_CHANNELS; ch++) {
+        if (!claimed[ch]) {
+            claimed[ch] = true;
+            return (int)ch;
+        }
+    }
+    return -1;
+}
+
+void dma_channel_claim(uint channel) {
+    claimed[channel] = true;
+}
+
+void dma_channel_unclaim(uint channel) {
+    claimed[channel] = false;
+}
+
+bool dma_channel_is_claimed(uint channel) {
+    return claimed[channel];
+}
+
+dma_channel_config dma_channel_get_default_config(uint channel) {
+    dma_channel_config c = {
+        .size = DMA_SIZE_32,
+        .read_increment = true,
+        .write_increment = false,
+        .dreq = DREQ_FORCE,
+        .chain_to = channel,
+        .enable = true,
+    };
+    return c;
+}
+
+bool host_dma_service(void);
+
+// Disparo: a contagem volta ao último valor escrito, os endereços continuam
+static void trigger(uint channel) {
+    host_dma_channels[channel].transfer_count = reload_counts[channel];
+    host_dma_channels[channel].busy = configs[channel].enable && reload_counts[channel] > 0;
+}
+
+void dma_channel_start(uint channel) {
+    trigger(channel);
+    host_dma_service();
+}
+
+void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr,
+                           const volatile void *read_addr, uint32_t transfer_count, bool trigger) {
+    configs[channel] = *config;
+    host_dma_channels[channel].write_addr = (uintptr_t)write_addr;
+    host_dma_channels[channel].read_addr = (uintptr_t)read_addr;
+    host_dma_channels[channel].transfer_count = transfer_count;
+    reload_counts[channel] = transfer_count;
+    if (trigger) {
+        dma_channel_start(channel);
+    }
+}
+
+void dma_channel_set_read_addr(uint channel, const volatile void *read_addr, bool trigger) {
+    host_dma_channels[channel].read_addr = (uintptr_t)read_addr;
+    if (trigger) {
+        dma_channel_start(channel);
+    }
+}
+
+void dma_channel_set_write_addr(uint channel, volatile void *write_addr, bool trigger) {
+    host_dma_channels[channel].write_addr = (uintptr_t)write_addr;
+    if (trigger) {
+        dma_channel_start(channel);
+    }
+}
+
+void dma_channel_set_trans_count(uint channel, uint32_t trans_count, bool trigger) {
+    reload_counts[channel] = trans_count;
+    if (trigger) {
+        dma_channel_start(channel);
+    }
+}
+
+void dma_channel_abort(uint channel) {
+    host_dma_channels[channel].busy = false;
+}
+
+// Avança um endereço; no lado do anel só os ring_bits baixos dão a volta
+static uintptr_t next_addr(const dma_channel_config *c, uintptr_t addr, bool is_write) {
+    uint size = 1u << c->size;
+    if (!(is_write ? c->write_increment : c->read_increment)) {
+        return addr;
+    }
+    if (c->ring_bits == 0 || c->ring_write != is_write) {
+        return addr + size;
+    }
+    uintptr_t mask = ((uintptr_t)1 << c->ring_bits) - 1;
+    return (addr & ~mask) | ((addr + size) & mask);
+}
+
+// Uma transferência; false se o DREQ não permite agora
+static bool transfer(uint channel) {
+    dma_channel_hw_t *hw = &host_dma_channels[channel];
+    const dma_channel_config *c = &configs[channel];
+    uint size = 1u << c->size;
+    uint32_t data = 0;
+
+    if (c->dreq != DREQ_FORCE) {
+        PIO pio = c->dreq >= DREQ_PIO1_TX0 ? pio1 : pio0;
+        uint index = c->dreq % DREQ_PIO1_TX0;
+        uint sm = index % NUM_PIO_STATE_MACHINES;
+        if (index >= DREQ_PIO0_RX0) {
+            // Lê do FIFO RX
+            if (pio_sm_is_rx_fifo_empty(pio, sm)) {
+                return false;
+            }
+            data = pio_sm_get(pio, sm);
+            memcpy((void *)hw->write_addr, &data, size);
+        } else {
+            // Escreve no FIFO TX
+            if (pio_sm_is_tx_fifo_full(pio, sm)) {
+                return false;
+            }
+            memcpy(&data, (const void *)hw->read_addr, size);
+            pio_sm_put(pio, sm, data);
+        }
+    } else {
+        memcpy((void *)hw->write_addr, (const void *)hw->read_addr, size);
+    }
+
+    hw->read_addr = next_addr(c, hw->read_addr, false);
+    hw->write_addr = next_addr(c, hw->write_addr, true);
+    if (--hw->transfer_count == 0) {
+        hw->busy = false;
+        if (c->chain_to != channel) {
+            trigger(c->chain_to);
+        }
+    }
+    return true;
+}
+
+// Atende todos os canais ativos até nada mais andar (um encadeamento pode
+// disparar um canal já visitado); true se algo foi transferido
+bool host_dma_service(void) {
+    uint64_t now = host_pio_time_us();
+    host_timer_hw.timerawl = (uint32_t)now;
+    host_timer_hw.timerawh = (uint32_t)(now >> 32);
+
+    bool moved = false;
+    bool again = true;
+    while (again) {
+        again = false;
+        for (uint ch = 0; ch < NUM_DMA_CHANNELS; ch++) {
+            while (host_dma_channels[ch].busy && transfer(ch)) {
+                again = true;
+            }
+        }
+        moved |= again;
+    }
+    return moved;
+}
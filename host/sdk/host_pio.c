@@ -0,0 +1,621 @@
+/**
+ * host_pio.c - Memória de instruções, state machines e FIFOs dos PIOs simulados
+ *
+ * As state machines marcadas com host_pio_simulate() executam o conjunto de
+ * instruções do PIO versão 0 a cada avanço do relógio virtual, em fatias de
+ * 1 us: em cada fatia cada state machine roda os ciclos do seu divisor de
+ * clock, na ordem do índice, e depois o DMA atende os FIFOs. Quando todas
+ * estão paradas (wait, FIFO, irq wait) o restante do intervalo é pulado,
+ * já que nada muda até o próximo evento externo.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <string.h>
+
+#include "hardware/pio.h"
+#include "hardware/clocks.h"
+#include "host_sdk.h"
+
+pio_hw_t host_pio_blocks[NUM_PIOS];
+
+void host_sdk_pio_output(uint gpio, bool level, uint64_t time_us);
+bool host_dma_service(void);
+void host_dma_reset(void);
+
+void host_pio_reset(void) {
+    memset(host_pio_blocks, 0, sizeof(host_pio_blocks));
+    host_dma_reset();
+}
+
+pio_sm_config pio_get_default_sm_config(void) {
+    pio_sm_config c;
+    memset(&c, 0, sizeof(c));
+    c.clkdiv = 1.0f;
+    c.wrap_target = 0;
+    c.wrap = PIO_INSTRUCTION_COUNT - 1;
+    c.in_shift_right = true;
+    c.out_shift_right = true;
+    c.push_threshold = 32;
+    c.pull_threshold = 32;
+    c.out_count = 32;
+    return c;
+}
+
+// ---------------------------------------------------------------------------
+// Memória de instruções
+// ---------------------------------------------------------------------------
+
+static uint32_t program_mask(const pio_program_t *program) {
+    return program->length >= 32 ? 0xffffffffu : ((1u << program->length) - 1u);
+}
+
+static int find_offset(PIO pio, const pio_program_t *program) {
+    uint32_t mask = program_mask(program);
+    if (program->origin >= 0) {
+        uint32_t m = mask << program->origin;
+        return (program->origin + program->length <= PIO_INSTRUCTION_COUNT && !(pio->used_instruction_mask & m))
+                   ? program->origin
+                   : -1;
+    }
+    // Como o SDK, procura o maior offset livre
+    for (int offset = PIO_INSTRUCTION_COUNT - program->length; offset >= 0; offset--) {
+        if (!(pio->used_instruction_mask & (mask << offset))) {
+            return offset;
+        }
+    }
+    return -1;
+}
+
+bool pio_can_add_program(PIO pio, const pio_program_t *program) {
+    return find_offset(pio, program) >= 0;
+}
+
+// Reloca os destinos de JMP, como pio_add_program() faz no hardware
+static uint16_t relocate(uint16_t instr, uint offset) {
+    if ((instr & 0xe000u) == 0x0000u) {
+        return (uint16_t)((instr & ~0x1fu) | (((instr & 0x1fu) + offset) & 0x1fu));
+    }
+    return instr;
+}
+
+uint pio_add_program(PIO pio, const pio_program_t *program) {
+    int offset = find_offset(pio, program);
+    if (offset < 0) {
+        return (uint)-1;
+    }
+    for (uint i = 0; i < program->length; i++) {
+        pio->instr_mem[offset + i] = relocate(program->instructions[i], (uint)offset);
+    }
+    pio->used_instruction_mask |= program_mask(program) << offset;
+    return (uint)offset;
+}
+
+void pio_remove_program(PIO pio, const pio_program_t *program, uint loaded_offset) {
+    pio->used_instruction_mask &= ~(program_mask(program) << loaded_offset);
+}
+
+void pio_clear_instruction_memory(PIO pio) {
+    pio->used_instruction_mask = 0;
+    memset(pio->instr_mem, 0, sizeof(pio->instr_mem));
+}
+
+// ---------------------------------------------------------------------------
+// State machines
+// ---------------------------------------------------------------------------
+
+void pio_sm_claim(PIO pio, uint sm) {
+    pio->sm[sm].claimed = true;
+}
+
+void pio_sm_unclaim(PIO pio, uint sm) {
+    pio->sm[sm].claimed = false;
+}
+
+bool pio_sm_is_claimed(PIO pio, uint sm) {
+    return pio->sm[sm].claimed;
+}
+
+int pio_claim_unused_sm(PIO pio, bool required) {
+    (void)required;
+    for (uint sm = 0; sm < NUM_PIO_STATE_MACHINES; sm++) {
+        if (!pio->sm[sm].claimed) {
+            pio->sm[sm].claimed = true;
+            return (int)sm;
+        }
+    }
+    return -1;
+}
+
+void pio_sm_set_config(PIO pio, uint sm, const pio_sm_config *config) {
+    pio->sm[sm].config = *config;
+}
+
+void pio_sm_clear_fifos(PIO pio, uint sm) {
+    pio_sm_state_t *s = &pio->sm[sm];
+    s->txf_head = s->txf_level = 0;
+    s->rxf_head = s->rxf_level = 0;
+}
+
+void pio_sm_restart(PIO pio, uint sm) {
+    pio_sm_state_t *s = &pio->sm[sm];
+    s->isr = s->osr = 0;
+    s->isr_count = 0;
+    s->osr_count = 32;
+    s->delay = 0;
+    s->clock_accumulator = 0;
+    s->stalled = false;
+    s->irq_waiting = false;
+}
+
+void pio_sm_init(PIO pio, uint sm, uint initial_pc, const pio_sm_config *config) {
+    pio_sm_state_t *s = &pio->sm[sm];
+    s->enabled = false;
+    pio_sm_set_config(pio, sm, config);
+    pio_sm_clear_fifos(pio, sm);
+    pio_sm_restart(pio, sm);
+    s->x = s->y = 0;
+    s->pc = initial_pc;
+    s->cycles = 0;
+}
+
+void pio_sm_set_enabled(PIO pio, uint sm, bool enabled) {
+    pio->sm[sm].enabled = enabled;
+}
+
+void pio_sm_set_clkdiv(PIO pio, uint sm, float div) {
+    pio->sm[sm].config.clkdiv = div;
+}
+
+void pio_gpio_init(PIO pio, uint pin) {
+    gpio_set_function(pin, pio == pio0 ? GPIO_FUNC_PIO0 : GPIO_FUNC_PIO1);
+    pio->pin_mask |= 1u << pin;
+}
+
+void pio_sm_set_consecutive_pindirs(PIO pio, uint sm, uint pin_base, uint pin_count, bool is_out) {
+    (void)sm;
+    for (uint i = 0; i < pin_count; i++) {
+        uint32_t bit = 1u << ((pin_base + i) % 32);
+        if (is_out) {
+            pio->pindir_mask |= bit;
+        } else {
+            pio->pindir_mask &= ~bit;
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// FIFOs
+// ---------------------------------------------------------------------------
+
+bool host_pio_tx_pop(PIO pio, uint sm, uint32_t *out) {
+    pio_sm_state_t *s = &pio->sm[sm];
+    if (s->txf_level == 0) {
+        return false;
+    }
+    *out = s->txf[s->txf_head];
+    s->txf_head = (s->txf_head + 1) % (2 * PIO_FIFO_DEPTH);
+    s->txf_level--;
+    return true;
+}
+
+bool host_pio_rx_push(PIO pio, uint sm, uint32_t data) {
+    pio_sm_state_t *s = &pio->sm[sm];
+    if (pio_sm_is_rx_fifo_full(pio, sm)) {
+        return false;
+    }
+    s->rxf[(s->rxf_head + s->rxf_level) % (2 * PIO_FIFO_DEPTH)] = data;
+    s->rxf_level++;
+    host_dma_service();
+    return true;
+}
+
+void pio_sm_put(PIO pio, uint sm, uint32_t data) {
+    pio_sm_state_t *s = &pio->sm[sm];
+    // Como no hardware, escrever com o FIFO cheio descarta o dado
+    if (pio_sm_is_tx_fifo_full(pio, sm)) {
+        return;
+    }
+    s->txf[(s->txf_head + s->txf_level) % (2 * PIO_FIFO_DEPTH)] = data;
+    s->txf_level++;
+}
+
+void pio_sm_put_blocking(PIO pio, uint sm, uint32_t data) {
+    // Sem uma state machine consumindo, o tempo avança até que haja espaço
+    for (int guard = 0; pio_sm_is_tx_fifo_full(pio, sm) && guard < 1000000; guard++) {
+        host_time_advance_us(10);
+    }
+    pio_sm_put(pio, sm, data);
+}
+
+uint32_t pio_sm_get(PIO pio, uint sm) {
+    pio_sm_state_t *s = &pio->sm[sm];
+    if (s->rxf_level == 0) {
+        return 0;
+    }
+    uint32_t data = s->rxf[s->rxf_head];
+    s->rxf_head = (s->rxf_head + 1) % (2 * PIO_FIFO_DEPTH);
+    s->rxf_level--;
+    return data;
+}
+
+uint32_t pio_sm_get_blocking(PIO pio, uint sm) {
+    for (int guard = 0; pio_sm_is_rx_fifo_empty(pio, sm) && guard < 1000000; guard++) {
+        host_time_advance_us(10);
+    }
+    return pio_sm_get(pio, sm);
+}
+
+// ---------------------------------------------------------------------------
+// Execução
+// ---------------------------------------------------------------------------
+
+static uint64_t exec_time_us;           // Fatia em execução (instante das saídas)
+static bool advancing;                  // Dentro de host_pio_advance()
+static bool exec_jumped;                // A última instrução escreveu o PC
+
+static uint32_t read_pins(uint base, uint count) {
+    uint32_t value = 0;
+    for (uint i = 0; i < count; i++) {
+        value |= (uint32_t)gpio_get((base + i) % NUM_BANK0_GPIOS) << i;
+    }
+    return value;
+}
+
+static void write_pins(PIO pio, uint base, uint count, uint32_t value) {
+    for (uint i = 0; i < count; i++) {
+        uint pin = (base + i) % 32;
+        bool level = (value >> i) & 1;
+        pio->pin_values = (pio->pin_values & ~(1u << pin)) | ((uint32_t)level << pin);
+        host_sdk_pio_output(pin, level, exec_time_us);
+    }
+}
+
+static void write_pindirs(PIO pio, uint base, uint count, uint32_t value) {
+    for (uint i = 0; i < count; i++) {
+        uint32_t bit = 1u << ((base + i) % 32);
+        pio->pindir_mask = ((value >> i) & 1) ? (pio->pindir_mask | bit) : (pio->pindir_mask & ~bit);
+    }
+}
+
+static uint irq_index(uint sm, uint index) {
+    // Modo relativo: soma o número da state machine aos dois bits baixos
+    return (index & 0x10) ? ((index & 4) | ((index + sm) & 3)) : (index & 7);
+}
+
+static uint32_t bit_reverse(uint32_t v) {
+    v = ((v >> 1) & 0x55555555u) | ((v & 0x55555555u) << 1);
+    v = ((v >> 2) & 0x33333333u) | ((v & 0x33333333u) << 2);
+    v = ((v >> 4) & 0x0f0f0f0fu) | ((v & 0x0f0f0f0fu) << 4);
+    v = ((v >> 8) & 0x00ff00ffu) | ((v & 0x00ff00ffu) << 8);
+    return (v >> 16) | (v << 16);
+}
+
+static bool rx_push(PIO pio, uint sm, uint32_t data) {
+    pio_sm_state_t *s = &pio->sm[sm];
+    if (pio_sm_is_rx_fifo_full(pio, sm)) {
+        return false;
+    }
+    s->rxf[(s->rxf_head + s->rxf_level) % (2 * PIO_FIFO_DEPTH)] = data;
+    s->rxf_level++;
+    return true;
+}
+
+static uint threshold(uint t) {
+    return t == 0 ? 32 : t;
+}
+
+static void shift_in(pio_sm_state_t *s, uint32_t data, uint n) {
+    uint32_t mask = n == 32 ? 0xffffffffu : ((1u << n) - 1u);
+    data &= mask;
+    if (n == 32) {
+        s->isr = data;
+    } else if (s->config.in_shift_right) {
+        s->isr = (s->isr >> n) | (data << (32 - n));
+    } else {
+        s->isr = (s->isr << n) | data;
+    }
+    s->isr_count = s->isr_count + n > 32 ? 32 : s->isr_count + n;
+}
+
+static uint32_t shift_out(pio_sm_state_t *s, uint n) {
+    uint32_t data;
+    if (n == 32) {
+        data = s->osr;
+        s->osr = 0;
+    } else if (s->config.out_shift_right) {
+        data = s->osr & ((1u << n) - 1u);
+        s->osr >>= n;
+    } else {
+        data = s->osr >> (32 - n);
+        s->osr <<= n;
+    }
+    s->osr_count = s->osr_count + n > 32 ? 32 : s->osr_count + n;
+    return data;
+}
+
+static uint32_t mov_source(PIO pio, uint sm, uint source) {
+    pio_sm_state_t *s = &pio->sm[sm];
+    switch (source) {
+        case 0: return read_pins(s->config.in_base, 32);
+        case 1: return s->x;
+        case 2: return s->y;
+        case 5: return 0;               // STATUS: sem .mov_status, nunca "cheio"
+        case 6: return s->isr;
+        case 7: return s->osr;
+        default: return 0;
+    }
+}
+
+// Executa uma instrução; false se ela ficou parada (repetida no próximo ciclo)
+static bool exec_instruction(PIO pio, uint sm, uint16_t instr) {
+    pio_sm_state_t *s = &pio->sm[sm];
+    pio_sm_config *c = &s->config;
+    uint op = instr >> 13;
+    uint arg1 = (instr >> 5) & 7;
+    uint arg2 = instr & 0x1f;
+    uint side_bits = c->sideset_bit_count;
+    uint delay_field = (instr >> 8) & 0x1f;
+    uint delay = delay_field & ((1u << (5 - side_bits)) - 1u);
+    bool jumped = false;
+
+    // Side-set vale já no primeiro ciclo, mesmo se a instrução parar
+    if (side_bits > 0) {
+        uint value_bits = side_bits - (c->sideset_optional ? 1 : 0);
+        uint side = delay_field >> (5 - side_bits);
+        if (!c->sideset_optional || (side >> value_bits) & 1) {
+            side &= (1u << value_bits) - 1u;
+            if (c->sideset_pindirs) {
+                write_pindirs(pio, c->sideset_base, value_bits, side);
+            } else {
+                write_pins(pio, c->sideset_base, value_bits, side);
+            }
+        }
+    }
+
+    switch (op) {
+        case 0: {                                       // JMP
+            bool take;
+            switch (arg1) {
+                case 0: take = true; break;
+                case 1: take = s->x == 0; break;
+                case 2: take = s->x != 0; s->x--; break;
+                case 3: take = s->y == 0; break;
+                case 4: take = s->y != 0; s->y--; break;
+                case 5: take = s->x != s->y; break;
+                case 6: take = gpio_get(c->jmp_pin); break;
+                default: take = s->osr_count < threshold(c->pull_threshold); break;
+            }
+            if (take) {
+                s->pc = arg2;
+                jumped = true;
+            }
+            break;
+        }
+        case 1: {                                       // WAIT
+            bool polarity = (instr >> 7) & 1;
+            uint source = (instr >> 5) & 3;
+            bool level;
+            if (source == 0) {
+                level = gpio_get(arg2);
+            } else if (source == 1) {
+                level = gpio_get((c->in_base + arg2) % NUM_BANK0_GPIOS);
+            } else {
+                uint irq = irq_index(sm, arg2);
+                level = (pio->irq >> irq) & 1;
+                if (polarity && level) {
+                    pio->irq &= (uint8_t)~(1u << irq);
+                }
+            }
+            if (level != polarity) {
+                return false;
+            }
+            break;
+        }
+        case 2: {                                       // IN
+            uint n = arg2 == 0 ? 32 : arg2;
+            uint32_t data;
+            switch (arg1) {
+                case 0: data = read_pins(c->in_base, n); break;
+                case 1: data = s->x; break;
+                case 2: data = s->y; break;
+                case 6: data = s->isr; break;
+                case 7: data = s->osr; break;
+                default: data = 0; break;
+            }
+            if (c->autopush && s->isr_count + n >= threshold(c->push_threshold) && pio_sm_is_rx_fifo_full(pio, sm)) {
+                return false;
+            }
+            shift_in(s, data, n);
+            if (c->autopush && s->isr_count >= threshold(c->push_threshold)) {
+                rx_push(pio, sm, s->isr);
+                s->isr = 0;
+                s->isr_count = 0;
+            }
+            break;
+        }
+        case 3: {                                       // OUT
+            uint n = arg2 == 0 ? 32 : arg2;
+            if (c->autopull && s->osr_count >= threshold(c->pull_threshold)) {
+                if (!host_pio_tx_pop(pio, sm, &s->osr)) {
+                    return false;
+                }
+                s->osr_count = 0;
+            }
+            uint32_t data = shift_out(s, n);
+            switch (arg1) {
+                case 0: write_pins(pio, c->out_base, c->out_count < n ? c->out_count : n, data); break;
+                case 1: s->x = data; break;
+                case 2: s->y = data; break;
+                case 4: write_pindirs(pio, c->out_base, n, data); break;
+                case 5: s->pc = data & 0x1f; jumped = true; break;
+                case 6: s->isr = data; s->isr_count = n; break;
+                case 7: return exec_instruction(pio, sm, (uint16_t)data);
+                default: break;
+            }
+            break;
+        }
+        case 4: {                                       // PUSH / PULL
+            bool is_pull = (instr >> 7) & 1;
+            bool if_flag = (instr >> 6) & 1;
+            bool block = (instr >> 5) & 1;
+            if (!is_pull) {
+                if (if_flag && s->isr_count < threshold(c->push_threshold)) {
+                    break;
+                }
+                if (pio_sm_is_rx_fifo_full(pio, sm)) {
+                    if (block) {
+                        return false;
+                    }
+                } else {
+                    rx_push(pio, sm, s->isr);
+                }
+                s->isr = 0;
+                s->isr_count = 0;
+            } else {
+                if (if_flag && s->osr_count < threshold(c->pull_threshold)) {
+                    break;
+                }
+                if (!host_pio_tx_pop(pio, sm, &s->osr)) {
+                    if (block) {
+                        return false;
+                    }
+                    s->osr = s->x;              // Sem bloqueio e FIFO vazio: copia X
+                }
+                s->osr_count = 0;
+            }
+            break;
+        }
+        case 5: {                                       // MOV
+            uint32_t value = mov_source(pio, sm, instr & 7);
+            uint operation = (instr >> 3) & 3;
+            if (operation == 1) {
+                value = ~value;
+            } else if (operation == 2) {
+                value = bit_reverse(value);
+            }
+            switch (arg1) {
+                case 0: write_pins(pio, c->out_base, c->out_count, value); break;
+                case 1: s->x = value; break;
+                case 2: s->y = value; break;
+                case 4: return exec_instruction(pio, sm, (uint16_t)value);
+                case 5: s->pc = value & 0x1f; jumped = true; break;
+                case 6: s->isr = value; s->isr_count = 0; break;
+                case 7: s->osr = value; s->osr_count = 0; break;
+                default: break;
+            }
+            break;
+        }
+        case 6: {                                       // IRQ
+            bool clear = (instr >> 6) & 1;
+            bool wait = (instr >> 5) & 1;
+            uint irq = irq_index(sm, arg2);
+            if (clear) {
+                pio->irq &= (uint8_t)~(1u << irq);
+            } else if (!s->irq_waiting) {
+                pio->irq |= (uint8_t)(1u << irq);
+            }
+            s->irq_waiting = !clear && wait && (pio->irq >> irq) & 1;
+            if (s->irq_waiting) {
+                return false;                   // Espera outra state machine limpar
+            }
+            break;
+        }
+        default: {                                      // SET
+            switch (arg1) {
+                case 0: write_pins(pio, c->set_base, c->set_count, arg2); break;
+                case 1: s->x = arg2; break;
+                case 2: s->y = arg2; break;
+                case 4: write_pindirs(pio, c->set_base, c->set_count, arg2); break;
+                default: break;
+            }
+            break;
+        }
+    }
+
+    exec_jumped = jumped;
+    if (!jumped) {
+        s->pc = s->pc == c->wrap ? c->wrap_target : (s->pc + 1) % PIO_INSTRUCTION_COUNT;
+    }
+    s->delay = delay;
+    return true;
+}
+
+static void run_cycle(PIO pio, uint sm) {
+    pio_sm_state_t *s = &pio->sm[sm];
+    s->cycles++;
+    if (s->delay > 0) {
+        s->delay--;
+        return;
+    }
+    s->stalled = !exec_instruction(pio, sm, pio->instr_mem[s->pc]);
+}
+
+void host_pio_simulate(PIO pio, uint sm, bool enabled) {
+    pio->sm[sm].simulated = enabled;
+    pio->sm[sm].stalled = false;
+}
+
+void host_pio_advance(uint64_t from_us, uint64_t to_us) {
+    bool any = false;
+    for (uint p = 0; p < NUM_PIOS; p++) {
+        for (uint sm = 0; sm < NUM_PIO_STATE_MACHINES; sm++) {
+            pio_sm_state_t *s = &host_pio_blocks[p].sm[sm];
+            // Pinos e FIFOs podem ter mudado fora do avanço: reavalia quem parou
+            s->stalled = false;
+            any |= s->simulated && s->enabled;
+        }
+    }
+    if (!any) {
+        return;
+    }
+
+    advancing = true;
+    for (exec_time_us = from_us; exec_time_us < to_us; exec_time_us++) {
+        bool all_stalled = true;
+        for (uint p = 0; p < NUM_PIOS; p++) {
+            PIO pio = &host_pio_blocks[p];
+            for (uint sm = 0; sm < NUM_PIO_STATE_MACHINES; sm++) {
+                pio_sm_state_t *s = &pio->sm[sm];
+                if (!s->simulated || !s->enabled) {
+                    continue;
+                }
+                s->clock_accumulator += (double)HOST_SYS_CLOCK_HZ / 1e6 / s->config.clkdiv;
+                while (s->clock_accumulator >= 1.0) {
+                    s->clock_accumulator -= 1.0;
+                    run_cycle(pio, sm);
+                }
+                all_stalled &= s->stalled && s->delay == 0;
+            }
+        }
+        if (host_dma_service()) {
+            all_stalled = false;                // FIFOs mudaram: quem esperava pode seguir
+        }
+        if (all_stalled) {
+            // Ninguém avança até algo externo mudar: pula o resto do intervalo
+            for (uint p = 0; p < NUM_PIOS; p++) {
+                for (uint sm = 0; sm < NUM_PIO_STATE_MACHINES; sm++) {
+                    host_pio_blocks[p].sm[sm].clock_accumulator = 0;
+                }
+            }
+            break;
+        }
+    }
+    advancing = false;
+}
+
+uint64_t host_pio_time_us(void) {
+    return advancing ? exec_time_us : get_absolute_time();
+}
+
+void pio_sm_exec(PIO pio, uint sm, uint instr) {
+    // Instrução forçada: não avança o PC (só um JMP/MOV PC o altera)
+    pio_sm_state_t *s = &pio->sm[sm];
+    uint pc = s->pc;
+    exec_time_us = get_absolute_time();
+    if (exec_instruction(pio, sm, (uint16_t)instr) && !exec_jumped) {
+        s->pc = pc;
+    }
+    s->delay = 0;
+}
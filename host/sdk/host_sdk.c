@@ -0,0 +1,449 @@
+/**
+ * host_sdk.c - Relógio virtual, alarmes, GPIO, PWM e stdio simulados
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "pico/stdio_usb.h"
+#include "hardware/gpio.h"
+#include "hardware/clocks.h"
+#include "hardware/pwm.h"
+#include "hardware/timer.h"
+#include "host_sdk.h"
+
+#define HOST_MAX_ALARMS 64
+#define HOST_STDIN_SIZE 256
+
+typedef struct {
+    bool active;
+    alarm_id_t id;
+    uint64_t target_us;
+    alarm_callback_t callback;
+    void *user_data;
+} host_alarm_t;
+
+typedef struct {
+    float clkdiv;
+    uint16_t wrap;
+    uint16_t level[2];
+    bool enabled;
+} host_pwm_slice_t;
+
+static uint64_t now_us;
+static host_alarm_t alarms[HOST_MAX_ALARMS];
+static alarm_id_t next_alarm_id = 1;
+static int callback_depth;
+
+static uint32_t sleep_overhead_us;
+static uint64_t sleep_calls;
+
+static host_edge_hook_t edge_hook;
+static void *edge_hook_ctx;
+static host_ticker_t ticker;
+
+static bool gpio_level[NUM_BANK0_GPIOS];
+static bool gpio_out[NUM_BANK0_GPIOS];
+static enum gpio_function gpio_fn[NUM_BANK0_GPIOS];
+static uint32_t gpio_irq_mask[NUM_BANK0_GPIOS];
+static gpio_irq_callback_t gpio_callback;
+
+static host_pwm_slice_t pwm_slices[NUM_PWM_SLICES];
+
+static char stdin_buf[HOST_STDIN_SIZE];
+static size_t stdin_head;
+static size_t stdin_len;
+static bool usb_connected = true;
+
+void host_pio_reset(void);
+void host_pio_advance(uint64_t from_us, uint64_t to_us);
+
+void host_sdk_reset(void) {
+    now_us = 0;
+    memset(alarms, 0, sizeof(alarms));
+    next_alarm_id = 1;
+    callback_depth = 0;
+    sleep_overhead_us = 0;
+    sleep_calls = 0;
+    edge_hook = NULL;
+    edge_hook_ctx = NULL;
+    ticker = NULL;
+    memset(gpio_level, 0, sizeof(gpio_level));
+    memset(gpio_out, 0, sizeof(gpio_out));
+    for (uint i = 0; i < NUM_BANK0_GPIOS; i++) {
+        gpio_fn[i] = GPIO_FUNC_NULL;
+    }
+    memset(gpio_irq_mask, 0, sizeof(gpio_irq_mask));
+    gpio_callback = NULL;
+    memset(pwm_slices, 0, sizeof(pwm_slices));
+    for (uint i = 0; i < NUM_PWM_SLICES; i++) {
+        pwm_slices[i].clkdiv = 1.0f;
+        pwm_slices[i].wrap = 0xffff;
+    }
+    stdin_head = stdin_len = 0;
+    usb_connected = true;
+    host_pio_reset();
+}
+
+void host_sdk_set_edge_hook(host_edge_hook_t hook, void *ctx) {
+    edge_hook = hook;
+    edge_hook_ctx = ctx;
+}
+
+void host_sdk_set_ticker(host_ticker_t t) {
+    ticker = t;
+}
+
+void host_sdk_set_sleep_overhead_us(uint32_t overhead_us) {
+    sleep_overhead_us = overhead_us;
+}
+
+uint64_t host_sdk_sleep_calls(void) {
+    return sleep_calls;
+}
+
+void host_sdk_emit_edge(uint gpio, bool level) {
+    if (edge_hook) {
+        edge_hook(gpio, level, now_us, edge_hook_ctx);
+    }
+}
+
+// Pino dirigido por uma state machine simulada, no instante da instrução
+void host_sdk_pio_output(uint gpio, bool level, uint64_t time_us) {
+    if (gpio_level[gpio] != level) {
+        gpio_level[gpio] = level;
+        if (edge_hook) {
+            edge_hook(gpio, level, time_us, edge_hook_ctx);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Relógio virtual e alarmes
+// ---------------------------------------------------------------------------
+
+absolute_time_t get_absolute_time(void) {
+    return now_us;
+}
+
+static host_alarm_t *earliest_alarm(void) {
+    host_alarm_t *best = NULL;
+    for (int i = 0; i < HOST_MAX_ALARMS; i++) {
+        if (alarms[i].active && (!best || alarms[i].target_us < best->target_us)) {
+            best = &alarms[i];
+        }
+    }
+    return best;
+}
+
+static void run_ticker(uint64_t to_us) {
+    if (to_us > now_us) {
+        host_pio_advance(now_us, to_us);
+    }
+    if (ticker && to_us > now_us) {
+        ticker(now_us, to_us);
+    }
+    if (to_us > now_us) {
+        now_us = to_us;
+    }
+}
+
+uint64_t host_time_next_alarm(void) {
+    host_alarm_t *a = earliest_alarm();
+    return a ? a->target_us : UINT64_MAX;
+}
+
+void host_time_advance_to(uint64_t time_us) {
+    // Dentro de um callback (contexto de IRQ) os alarmes não se aninham
+    if (callback_depth > 0) {
+        run_ticker(time_us);
+        return;
+    }
+
+    while (true) {
+        host_alarm_t *a = earliest_alarm();
+        if (!a || a->target_us > time_us) {
+            break;
+        }
+
+        run_ticker(a->target_us);
+
+        host_alarm_t fired = *a;
+        a->active = false;
+
+        callback_depth++;
+        int64_t ret = fired.callback(fired.id, fired.user_data);
+        callback_depth--;
+
+        if (ret != 0) {
+            uint64_t next = ret > 0 ? now_us + (uint64_t)ret : fired.target_us + (uint64_t)(-ret);
+            for (int i = 0; i < HOST_MAX_ALARMS; i++) {
+                if (!alarms[i].active) {
+                    alarms[i] = fired;
+                    alarms[i].active = true;
+                    alarms[i].target_us = next;
+                    break;
+                }
+            }
+        }
+    }
+
+    run_ticker(time_us);
+}
+
+void host_time_advance_us(uint64_t us) {
+    host_time_advance_to(now_us + us);
+}
+
+void sleep_us(uint64_t us) {
+    sleep_calls++;
+    host_time_advance_to(now_us + us + sleep_overhead_us);
+}
+
+void sleep_ms(uint32_t ms) {
+    sleep_us((uint64_t)ms * 1000);
+}
+
+void sleep_until(absolute_time_t t) {
+    sleep_calls++;
+    if (t > now_us) {
+        host_time_advance_to(t);
+    }
+}
+
+bool best_effort_wfe_or_timeout(absolute_time_t timeout_timestamp) {
+    // Dorme até o próximo evento (alarme) ou até o timeout
+    uint64_t next = host_time_next_alarm();
+    if (next < timeout_timestamp) {
+        host_time_advance_to(next > now_us ? next : now_us);
+        return false;
+    }
+    host_time_advance_to(timeout_timestamp);
+    return true;
+}
+
+alarm_id_t add_alarm_at(absolute_time_t time, alarm_callback_t callback, void *user_data, bool fire_if_past) {
+    if (time <= now_us && !fire_if_past) {
+        return 0;
+    }
+    for (int i = 0; i < HOST_MAX_ALARMS; i++) {
+        if (!alarms[i].active) {
+            alarms[i].active = true;
+            alarms[i].id = next_alarm_id++;
+            alarms[i].target_us = time < now_us ? now_us : time;
+            alarms[i].callback = callback;
+            alarms[i].user_data = user_data;
+            return alarms[i].id;
+        }
+    }
+    return -1;
+}
+
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void *user_data, bool fire_if_past) {
+    return add_alarm_at(now_us + us, callback, user_data, fire_if_past);
+}
+
+alarm_id_t add_alarm_in_ms(uint32_t ms, alarm_callback_t callback, void *user_data, bool fire_if_past) {
+    return add_alarm_at(now_us + (uint64_t)ms * 1000, callback, user_data, fire_if_past);
+}
+
+bool cancel_alarm(alarm_id_t alarm_id) {
+    for (int i = 0; i < HOST_MAX_ALARMS; i++) {
+        if (alarms[i].active && alarms[i].id == alarm_id) {
+            alarms[i].active = false;
+            return true;
+        }
+    }
+    return false;
+}
+
+static int64_t repeating_timer_alarm(alarm_id_t id, void *user_data) {
+    repeating_timer_t *rt = (repeating_timer_t *)user_data;
+    (void)id;
+    if (!rt->callback(rt)) {
+        return 0;
+    }
+    // delay > 0: medido a partir do fim do callback; delay < 0: do início
+    return rt->delay_us;
+}
+
+bool add_repeating_timer_us(int64_t delay_us, repeating_timer_callback_t callback, void *user_data, repeating_timer_t *out) {
+    if (delay_us == 0) {
+        delay_us = 1;
+    }
+    out->delay_us = delay_us;
+    out->callback = callback;
+    out->user_data = user_data;
+    out->alarm_id = add_alarm_in_us((uint64_t)(delay_us < 0 ? -delay_us : delay_us), repeating_timer_alarm, out, true);
+    return out->alarm_id > 0;
+}
+
+bool add_repeating_timer_ms(int32_t delay_ms, repeating_timer_callback_t callback, void *user_data, repeating_timer_t *out) {
+    return add_repeating_timer_us((int64_t)delay_ms * 1000, callback, user_data, out);
+}
+
+bool cancel_repeating_timer(repeating_timer_t *timer) {
+    // O id do alarme é preservado nos reagendamentos
+    bool ok = cancel_alarm(timer->alarm_id);
+    timer->alarm_id = 0;
+    return ok;
+}
+
+// ---------------------------------------------------------------------------
+// GPIO
+// ---------------------------------------------------------------------------
+
+void gpio_init(uint gpio) {
+    gpio_fn[gpio] = GPIO_FUNC_SIO;
+    gpio_out[gpio] = false;
+    gpio_level[gpio] = false;
+}
+
+void gpio_set_dir(uint gpio, bool out) {
+    gpio_out[gpio] = out;
+}
+
+void gpio_set_function(uint gpio, enum gpio_function fn) {
+    gpio_fn[gpio] = fn;
+}
+
+void gpio_put(uint gpio, bool value) {
+    if (gpio_level[gpio] != value) {
+        gpio_level[gpio] = value;
+        if (gpio_out[gpio]) {
+            host_sdk_emit_edge(gpio, value);
+        }
+    }
+}
+
+bool gpio_get(uint gpio) {
+    return gpio_level[gpio];
+}
+
+void gpio_pull_up(uint gpio) {
+    if (!gpio_out[gpio]) {
+        gpio_level[gpio] = true;
+    }
+}
+
+void gpio_pull_down(uint gpio) {
+    if (!gpio_out[gpio]) {
+        gpio_level[gpio] = false;
+    }
+}
+
+void gpio_disable_pulls(uint gpio) {
+    (void)gpio;
+}
+
+void gpio_set_irq_enabled(uint gpio, uint32_t event_mask, bool enabled) {
+    if (enabled) {
+        gpio_irq_mask[gpio] |= event_mask;
+    } else {
+        gpio_irq_mask[gpio] &= ~event_mask;
+    }
+}
+
+void gpio_set_irq_enabled_with_callback(uint gpio, uint32_t event_mask, bool enabled, gpio_irq_callback_t callback) {
+    gpio_set_irq_enabled(gpio, event_mask, enabled);
+    gpio_callback = callback;
+}
+
+void host_gpio_drive(uint gpio, bool level) {
+    if (gpio_level[gpio] == level) {
+        return;
+    }
+    gpio_level[gpio] = level;
+
+    uint32_t event = level ? GPIO_IRQ_EDGE_RISE : GPIO_IRQ_EDGE_FALL;
+    if (gpio_callback && (gpio_irq_mask[gpio] & event)) {
+        callback_depth++;
+        gpio_callback(gpio, event);
+        callback_depth--;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// PWM
+// ---------------------------------------------------------------------------
+
+static void pwm_emit(uint slice_num) {
+    host_pwm_slice_t *s = &pwm_slices[slice_num];
+    for (uint gpio = 0; gpio < NUM_BANK0_GPIOS; gpio++) {
+        if (gpio_fn[gpio] == GPIO_FUNC_PWM && pwm_gpio_to_slice_num(gpio) == slice_num) {
+            bool level = s->enabled && s->level[pwm_gpio_to_channel(gpio)] > 0;
+            if (gpio_level[gpio] != level) {
+                gpio_level[gpio] = level;
+                host_sdk_emit_edge(gpio, level);
+            }
+        }
+    }
+}
+
+void pwm_set_clkdiv(uint slice_num, float divider) {
+    pwm_slices[slice_num].clkdiv = divider;
+}
+
+void pwm_set_wrap(uint slice_num, uint16_t wrap) {
+    pwm_slices[slice_num].wrap = wrap;
+}
+
+void pwm_set_chan_level(uint slice_num, uint chan, uint16_t level) {
+    pwm_slices[slice_num].level[chan] = level;
+    pwm_emit(slice_num);
+}
+
+void pwm_set_gpio_level(uint gpio, uint16_t level) {
+    pwm_set_chan_level(pwm_gpio_to_slice_num(gpio), pwm_gpio_to_channel(gpio), level);
+}
+
+void pwm_set_enabled(uint slice_num, bool enabled) {
+    pwm_slices[slice_num].enabled = enabled;
+    pwm_emit(slice_num);
+}
+
+float host_pwm_frequency_hz(uint slice_num) {
+    host_pwm_slice_t *s = &pwm_slices[slice_num];
+    return (float)HOST_SYS_CLOCK_HZ / (s->clkdiv * ((float)s->wrap + 1.0f));
+}
+
+float host_pwm_duty(uint slice_num, uint chan) {
+    host_pwm_slice_t *s = &pwm_slices[slice_num];
+    return (float)s->level[chan] / ((float)s->wrap + 1.0f);
+}
+
+// ---------------------------------------------------------------------------
+// stdio
+// ---------------------------------------------------------------------------
+
+bool stdio_init_all(void) {
+    return true;
+}
+
+void host_stdin_push(const char *text) {
+    for (; *text && stdin_len < HOST_STDIN_SIZE; text++) {
+        stdin_buf[(stdin_head + stdin_len++) % HOST_STDIN_SIZE] = *text;
+    }
+}
+
+int getchar_timeout_us(uint32_t timeout_us) {
+    if (stdin_len > 0) {
+        char c = stdin_buf[stdin_head];
+        stdin_head = (stdin_head + 1) % HOST_STDIN_SIZE;
+        stdin_len--;
+        return (unsigned char)c;
+    }
+    host_time_advance_us(timeout_us);
+    return PICO_ERROR_TIMEOUT;
+}
+
+void host_usb_set_connected(bool connected) {
+    usb_connected = connected;
+}
+
+bool stdio_usb_connected(void) {
+    return usb_connected;
+}
@@ -0,0 +1,118 @@
+/**
+ * host_sdk.h - Controle da simulação do Pico SDK no host
+ *
+ * O shim em host/sdk implementa o subconjunto do SDK usado pelo projeto sobre
+ * um relógio virtual: sleep_us() apenas avança o tempo, os alarmes disparam em
+ * ordem cronológica e toda mudança de nível em um pino de saída (gpio_put,
+ * carrier PWM ligado/desligado) pode ser observada por um hook. Assim os
+ * benchmarks e simulações medem o custo de CPU do código real sem esperar o
+ * tempo de transmissão.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef HOST_SDK_H
+#define HOST_SDK_H
+
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Chamado a cada mudança de nível de um pino de saída
+typedef void (*host_edge_hook_t)(uint gpio, bool level, uint64_t time_us, void *ctx);
+
+// Avança periféricos simulados (ex.: PIO) de from_us até to_us
+typedef void (*host_ticker_t)(uint64_t from_us, uint64_t to_us);
+
+/**
+ * Volta o relógio virtual para zero e limpa alarmes, GPIO, PWM, PIO, stdin e USB
+ */
+void host_sdk_reset(void);
+
+/**
+ * Instala o hook de bordas de saída (NULL desativa)
+ */
+void host_sdk_set_edge_hook(host_edge_hook_t hook, void *ctx);
+
+/**
+ * Registra o avanço de um periférico simulado (NULL remove)
+ */
+void host_sdk_set_ticker(host_ticker_t ticker);
+
+/**
+ * Atraso extra aplicado a cada sleep_us()/busy_wait (modelo de overshoot)
+ */
+void host_sdk_set_sleep_overhead_us(uint32_t overhead_us);
+
+/**
+ * Quantidade de chamadas de espera (sleep/busy-wait) desde o último reset
+ */
+uint64_t host_sdk_sleep_calls(void);
+
+/**
+ * Avança o relógio virtual disparando alarmes vencidos no caminho
+ */
+void host_time_advance_to(uint64_t time_us);
+void host_time_advance_us(uint64_t us);
+
+/**
+ * Instante do próximo alarme pendente (UINT64_MAX se não houver)
+ */
+uint64_t host_time_next_alarm(void);
+
+/**
+ * Força o nível de um pino de entrada, disparando a IRQ de GPIO configurada
+ */
+void host_gpio_drive(uint gpio, bool level);
+
+/**
+ * Enfileira caracteres para getchar_timeout_us()
+ */
+void host_stdin_push(const char *text);
+
+/**
+ * Estado devolvido por stdio_usb_connected() (true após o reset)
+ */
+void host_usb_set_connected(bool connected);
+
+/**
+ * Frequência e duty do carrier configurado em um slice PWM
+ */
+float host_pwm_frequency_hz(uint slice_num);
+float host_pwm_duty(uint slice_num, uint chan);
+
+/**
+ * Notifica o hook de bordas (usado pelos periféricos simulados)
+ */
+void host_sdk_emit_edge(uint gpio, bool level);
+
+/**
+ * Passa a executar (ou para de executar) as instruções da state machine no
+ * avanço do relógio: pinos de entrada lidos do shim de GPIO, saídas com o
+ * hook de bordas, FIFOs, IRQs e DMA (hardware/dma.h) como no RP2040, com
+ * clk_sys de 125 MHz e resolução de 1 us entre state machines
+ */
+void host_pio_simulate(PIO pio, uint sm, bool enabled);
+
+/**
+ * Lado da state machine dos FIFOs de um PIO simulado: consome o que o
+ * firmware escreveu no TX e entrega dados no RX (false se vazio/cheio)
+ */
+bool host_pio_tx_pop(PIO pio, uint sm, uint32_t *out);
+bool host_pio_rx_push(PIO pio, uint sm, uint32_t data);
+
+/**
+ * Instante em que os PIOs simulados e o DMA estão (a fatia em execução
+ * durante o avanço do relógio, senão o relógio)
+ */
+uint64_t host_pio_time_us(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_SDK_H
@@ -0,0 +1,113 @@
+/**
+ * hardware/dma.h - Canais de DMA simulados no host
+ *
+ * Cobre o que os receptores e transmissores PIO usam: canal pago por DREQ de
+ * um FIFO de PIO (ou DREQ_FORCE, cópia imediata), tamanho de 8/16/32 bits,
+ * incremento de leitura/escrita, anel de endereços e encadeamento (chain_to).
+ * Como no RP2040, o disparo recarrega a contagem com o último valor escrito
+ * e a leitura de timer_hw->timerawl devolve o instante da transferência. O
+ * serviço roda a cada
+ * fatia de execução dos PIOs simulados e a cada host_pio_rx_push(). Os
+ * registradores de dma_channel_hw_addr() têm a largura de um ponteiro, para
+ * que o mesmo código do firmware converta o endereço de escrita no host.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef HOST_HARDWARE_DMA_H
+#define HOST_HARDWARE_DMA_H
+
+#include "pico/types.h"
+#include "hardware/pio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NUM_DMA_CHANNELS 12
+#define DREQ_FORCE 0x3f
+
+enum dma_channel_transfer_size {
+    DMA_SIZE_8 = 0,
+    DMA_SIZE_16 = 1,
+    DMA_SIZE_32 = 2,
+};
+
+typedef struct {
+    enum dma_channel_transfer_size size;
+    bool read_increment;
+    bool write_increment;
+    uint dreq;
+    uint ring_bits;                 // 0 = sem anel
+    bool ring_write;
+    uint chain_to;                  // O próprio canal = sem encadeamento
+    bool enable;
+} dma_channel_config;
+
+typedef struct {
+    uintptr_t read_addr;
+    uintptr_t write_addr;
+    uint32_t transfer_count;        // Transferências restantes
+    bool busy;
+} dma_channel_hw_t;
+
+extern dma_channel_hw_t host_dma_channels[NUM_DMA_CHANNELS];
+
+int dma_claim_unused_channel(bool required);
+void dma_channel_claim(uint channel);
+void dma_channel_unclaim(uint channel);
+bool dma_channel_is_claimed(uint channel);
+
+dma_channel_config dma_channel_get_default_config(uint channel);
+
+static inline void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size size) {
+    c->size = size;
+}
+
+static inline void channel_config_set_read_increment(dma_channel_config *c, bool incr) {
+    c->read_increment = incr;
+}
+
+static inline void channel_config_set_write_increment(dma_channel_config *c, bool incr) {
+    c->write_increment = incr;
+}
+
+static inline void channel_config_set_dreq(dma_channel_config *c, uint dreq) {
+    c->dreq = dreq;
+}
+
+static inline void channel_config_set_ring(dma_channel_config *c, bool write, uint size_bits) {
+    c->ring_write = write;
+    c->ring_bits = size_bits;
+}
+
+static inline void channel_config_set_chain_to(dma_channel_config *c, uint chain_to) {
+    c->chain_to = chain_to;
+}
+
+static inline void channel_config_set_enable(dma_channel_config *c, bool enable) {
+    c->enable = enable;
+}
+
+void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr,
+                           const volatile void *read_addr, uint32_t transfer_count, bool trigger);
+void dma_channel_set_read_addr(uint channel, const volatile void *read_addr, bool trigger);
+void dma_channel_set_write_addr(uint channel, volatile void *write_addr, bool trigger);
+void dma_channel_set_trans_count(uint channel, uint32_t trans_count, bool trigger);
+void dma_channel_start(uint channel);
+void dma_channel_abort(uint channel);
+
+static inline dma_channel_hw_t *dma_channel_hw_addr(uint channel) {
+    return &host_dma_channels[channel];
+}
+
+static inline bool dma_channel_is_busy(uint channel) {
+    return host_dma_channels[channel].busy;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_HARDWARE_DMA_H
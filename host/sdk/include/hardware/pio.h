@@ -0,0 +1,248 @@
+/**
+ * hardware/pio.h - Blocos PIO simulados no host
+ *
+ * Mantém a memória de instruções, as configurações das state machines e os
+ * FIFOs, de modo que as funções *_init geradas a partir dos arquivos .pio
+ * (host/pioasm) rodem sem alteração. As state machines marcadas com
+ * host_pio_simulate() (host_sdk.h) executam as instruções no avanço do
+ * relógio virtual; as demais só guardam o estado e os FIFOs.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef HOST_HARDWARE_PIO_H
+#define HOST_HARDWARE_PIO_H
+
+#include "pico/types.h"
+#include "hardware/gpio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NUM_PIOS 2
+#define NUM_PIO_STATE_MACHINES 4
+#define PIO_INSTRUCTION_COUNT 32
+#define PIO_FIFO_DEPTH 4
+
+// Pedidos de DMA dos FIFOs (mesma numeração do RP2040)
+#define DREQ_PIO0_TX0 0
+#define DREQ_PIO0_RX0 4
+#define DREQ_PIO1_TX0 8
+#define DREQ_PIO1_RX0 12
+
+enum pio_fifo_join {
+    PIO_FIFO_JOIN_NONE = 0,
+    PIO_FIFO_JOIN_TX = 1,
+    PIO_FIFO_JOIN_RX = 2,
+};
+
+typedef struct pio_program {
+    const uint16_t *instructions;
+    uint8_t length;
+    int8_t origin;
+    uint8_t pio_version;
+} pio_program_t;
+
+typedef struct {
+    float clkdiv;
+    uint wrap_target;
+    uint wrap;
+    uint sideset_bit_count;
+    bool sideset_optional;
+    bool sideset_pindirs;
+    uint sideset_base;
+    uint set_base;
+    uint set_count;
+    uint out_base;
+    uint out_count;
+    uint in_base;
+    uint jmp_pin;
+    bool in_shift_right;
+    bool autopush;
+    uint push_threshold;
+    bool out_shift_right;
+    bool autopull;
+    uint pull_threshold;
+    enum pio_fifo_join fifo_join;
+    bool out_sticky;
+} pio_sm_config;
+
+typedef struct {
+    pio_sm_config config;
+    bool claimed;
+    bool enabled;
+    uint pc;
+    uint32_t x;
+    uint32_t y;
+    uint32_t isr;
+    uint32_t osr;
+    uint isr_count;
+    uint osr_count;
+    uint32_t txf[2 * PIO_FIFO_DEPTH];
+    uint txf_head;
+    uint txf_level;
+    uint32_t rxf[2 * PIO_FIFO_DEPTH];
+    uint rxf_head;
+    uint rxf_level;
+    uint32_t delay;
+    double clock_accumulator;
+    uint64_t cycles;
+    bool simulated;                 // Executa as instruções (host_pio_simulate)
+    bool stalled;                   // Última instrução ficou parada (wait, FIFO)
+    bool irq_waiting;               // "irq wait" já levantou a flag e espera a limpeza
+} pio_sm_state_t;
+
+typedef struct pio_hw {
+    // Endereços dos FIFOs para o DMA; o canal identifica a state machine pelo DREQ
+    uint32_t txf[NUM_PIO_STATE_MACHINES];
+    uint32_t rxf[NUM_PIO_STATE_MACHINES];
+    uint16_t instr_mem[PIO_INSTRUCTION_COUNT];
+    uint32_t used_instruction_mask;
+    pio_sm_state_t sm[NUM_PIO_STATE_MACHINES];
+    uint8_t irq;
+    uint32_t pin_mask;
+    uint32_t pindir_mask;
+    uint32_t pin_values;
+} pio_hw_t;
+
+typedef pio_hw_t *PIO;
+
+extern pio_hw_t host_pio_blocks[NUM_PIOS];
+
+#define pio0 (&host_pio_blocks[0])
+#define pio1 (&host_pio_blocks[1])
+
+static inline uint pio_get_index(PIO pio) {
+    return pio == pio1 ? 1u : 0u;
+}
+
+static inline uint pio_get_dreq(PIO pio, uint sm, bool is_tx) {
+    return (pio == pio1 ? DREQ_PIO1_TX0 : DREQ_PIO0_TX0) + (is_tx ? 0 : DREQ_PIO0_RX0) + sm;
+}
+
+pio_sm_config pio_get_default_sm_config(void);
+
+static inline void sm_config_set_wrap(pio_sm_config *c, uint wrap_target, uint wrap) {
+    c->wrap_target = wrap_target;
+    c->wrap = wrap;
+}
+
+static inline void sm_config_set_sideset(pio_sm_config *c, uint bit_count, bool optional, bool pindirs) {
+    c->sideset_bit_count = bit_count;
+    c->sideset_optional = optional;
+    c->sideset_pindirs = pindirs;
+}
+
+static inline void sm_config_set_sideset_pins(pio_sm_config *c, uint sideset_base) {
+    c->sideset_base = sideset_base;
+}
+
+static inline void sm_config_set_set_pins(pio_sm_config *c, uint set_base, uint set_count) {
+    c->set_base = set_base;
+    c->set_count = set_count;
+}
+
+static inline void sm_config_set_out_pins(pio_sm_config *c, uint out_base, uint out_count) {
+    c->out_base = out_base;
+    c->out_count = out_count;
+}
+
+static inline void sm_config_set_in_pins(pio_sm_config *c, uint in_base) {
+    c->in_base = in_base;
+}
+
+static inline void sm_config_set_jmp_pin(pio_sm_config *c, uint pin) {
+    c->jmp_pin = pin;
+}
+
+static inline void sm_config_set_clkdiv(pio_sm_config *c, float div) {
+    c->clkdiv = div;
+}
+
+static inline void sm_config_set_in_shift(pio_sm_config *c, bool shift_right, bool autopush, uint push_threshold) {
+    c->in_shift_right = shift_right;
+    c->autopush = autopush;
+    c->push_threshold = push_threshold;
+}
+
+static inline void sm_config_set_out_shift(pio_sm_config *c, bool shift_right, bool autopull, uint pull_threshold) {
+    c->out_shift_right = shift_right;
+    c->autopull = autopull;
+    c->pull_threshold = pull_threshold;
+}
+
+static inline void sm_config_set_fifo_join(pio_sm_config *c, enum pio_fifo_join join) {
+    c->fifo_join = join;
+}
+
+static inline void sm_config_set_out_special(pio_sm_config *c, bool sticky, bool has_enable_pin, uint enable_pin_index) {
+    (void)has_enable_pin;
+    (void)enable_pin_index;
+    c->out_sticky = sticky;
+}
+
+bool pio_can_add_program(PIO pio, const pio_program_t *program);
+uint pio_add_program(PIO pio, const pio_program_t *program);
+void pio_remove_program(PIO pio, const pio_program_t *program, uint loaded_offset);
+void pio_clear_instruction_memory(PIO pio);
+
+void pio_sm_claim(PIO pio, uint sm);
+void pio_sm_unclaim(PIO pio, uint sm);
+int pio_claim_unused_sm(PIO pio, bool required);
+bool pio_sm_is_claimed(PIO pio, uint sm);
+
+void pio_sm_init(PIO pio, uint sm, uint initial_pc, const pio_sm_config *config);
+void pio_sm_set_config(PIO pio, uint sm, const pio_sm_config *config);
+void pio_sm_set_enabled(PIO pio, uint sm, bool enabled);
+void pio_sm_restart(PIO pio, uint sm);
+void pio_sm_set_clkdiv(PIO pio, uint sm, float div);
+void pio_sm_exec(PIO pio, uint sm, uint instr);
+
+void pio_gpio_init(PIO pio, uint pin);
+void pio_sm_set_consecutive_pindirs(PIO pio, uint sm, uint pin_base, uint pin_count, bool is_out);
+
+void pio_sm_put(PIO pio, uint sm, uint32_t data);
+void pio_sm_put_blocking(PIO pio, uint sm, uint32_t data);
+uint32_t pio_sm_get(PIO pio, uint sm);
+uint32_t pio_sm_get_blocking(PIO pio, uint sm);
+void pio_sm_clear_fifos(PIO pio, uint sm);
+
+static inline uint pio_sm_get_rx_fifo_level(PIO pio, uint sm) {
+    return pio->sm[sm].rxf_level;
+}
+
+static inline uint pio_sm_get_tx_fifo_level(PIO pio, uint sm) {
+    return pio->sm[sm].txf_level;
+}
+
+static inline uint host_pio_fifo_depth(PIO pio, uint sm, bool rx) {
+    enum pio_fifo_join join = pio->sm[sm].config.fifo_join;
+    if (join == PIO_FIFO_JOIN_NONE) {
+        return PIO_FIFO_DEPTH;
+    }
+    return (join == (rx ? PIO_FIFO_JOIN_RX : PIO_FIFO_JOIN_TX)) ? 2 * PIO_FIFO_DEPTH : 0;
+}
+
+static inline bool pio_sm_is_rx_fifo_empty(PIO pio, uint sm) {
+    return pio->sm[sm].rxf_level == 0;
+}
+
+static inline bool pio_sm_is_rx_fifo_full(PIO pio, uint sm) {
+    return pio->sm[sm].rxf_level >= host_pio_fifo_depth(pio, sm, true);
+}
+
+static inline bool pio_sm_is_tx_fifo_empty(PIO pio, uint sm) {
+    return pio->sm[sm].txf_level == 0;
+}
+
+static inline bool pio_sm_is_tx_fifo_full(PIO pio, uint sm) {
+    return pio->sm[sm].txf_level >= host_pio_fifo_depth(pio, sm, false);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_HARDWARE_PIO_H
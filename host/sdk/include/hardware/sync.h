@@ -0,0 +1,28 @@
+/**
+ * hardware/sync.h - Seções críticas do host
+ *
+ * No host não há interrupções de verdade (os alarmes rodam dentro de
+ * sleep_us), então desabilitar interrupções não precisa fazer nada.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef HOST_HARDWARE_SYNC_H
+#define HOST_HARDWARE_SYNC_H
+
+#include "pico/types.h"
+
+static inline uint32_t save_and_disable_interrupts(void) {
+    return 0;
+}
+
+static inline void restore_interrupts(uint32_t status) {
+    (void)status;
+}
+
+static inline void __dmb(void) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+#endif // HOST_HARDWARE_SYNC_H
@@ -0,0 +1,40 @@
+/**
+ * hardware/timer.h - Timer de microssegundos sobre o relógio virtual do host
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef HOST_HARDWARE_TIMER_H
+#define HOST_HARDWARE_TIMER_H
+
+#include "pico/types.h"
+#include "pico/time.h"
+
+// Registradores brutos do timer, só para leitura pelo DMA (atualizados a
+// cada transferência); a CPU usa time_us_32()/time_us_64()
+typedef struct {
+    volatile uint32_t timerawh;
+    volatile uint32_t timerawl;
+} timer_hw_t;
+
+extern timer_hw_t host_timer_hw;
+#define timer_hw (&host_timer_hw)
+
+static inline uint64_t time_us_64(void) {
+    return get_absolute_time();
+}
+
+static inline uint32_t time_us_32(void) {
+    return (uint32_t)get_absolute_time();
+}
+
+static inline void busy_wait_us_32(uint32_t delay_us) {
+    sleep_us(delay_us);
+}
+
+static inline void busy_wait_us(uint64_t delay_us) {
+    sleep_us(delay_us);
+}
+
+#endif // HOST_HARDWARE_TIMER_H
@@ -0,0 +1,25 @@
+/**
+ * pico/stdio_usb.h - Conexão do console USB simulada no host
+ *
+ * O estado vem de host_usb_set_connected() (host_sdk.h); começa conectado.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef HOST_PICO_STDIO_USB_H
+#define HOST_PICO_STDIO_USB_H
+
+#include "pico/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+bool stdio_usb_connected(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_PICO_STDIO_USB_H
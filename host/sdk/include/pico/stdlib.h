@@ -0,0 +1,34 @@
+/**
+ * pico/stdlib.h - Subconjunto do Pico SDK usado pelo projeto, compilado no host
+ *
+ * Só existe para que as bibliotecas do projeto (custom_ir.c, nec_*_library, ...)
+ * possam ser compiladas e medidas no Linux. O controle da simulação (relógio
+ * virtual, bordas registradas, entrada injetada) fica em host_sdk.h.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef HOST_PICO_STDLIB_H
+#define HOST_PICO_STDLIB_H
+
+#include <stdio.h>
+
+#include "pico/types.h"
+#include "pico/time.h"
+#include "hardware/gpio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+bool stdio_init_all(void);
+int getchar_timeout_us(uint32_t timeout_us);
+
+static inline void tight_loop_contents(void) {}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_PICO_STDLIB_H
@@ -0,0 +1,430 @@
+/**
+ * ir_sigc.c - Compila capturas em tabelas de ir_siglib.h para o firmware
+ *
+ * Uso: ir_sigc [--quantum <us>] [--raw] [--prefix <nome>] --out <dir> <capturas>...
+ *
+ * Lê os vetores impressos pelo receptor.c (texto, o nome de cada sinal é o
+ * identificador do vetor) ou arquivos .ircap (nome <arquivo>_<n>), repara as
+ * marcas perdidas como o receptor.c (ir_capture_repair) e saneia cada
+ * captura (ir_sanitize; nenhum dos dois com --raw), descarta as duplicadas e
+ * empacota o resto com ir_siglib_pack(). Gera em <dir>:
+ *
+ *  - <prefix>.h: um enum com o índice de cada sinal (as duplicadas viram
+ *    sinônimos do primeiro), a biblioteca, a busca por nome e o esticamento
+ *    de marca do sensor estimado nas capturas (ir_calib.h; 0 sem capturas
+ *    suficientes de protocolo conhecido);
+ *  - <prefix>.c: as tabelas e o índice de nomes ordenado.
+ *
+ * O tamanho das tabelas sai na saída padrão, que aparece no log do build.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ir_siglib.h"
+#include "ir_capture.h"
+#include "ir_calib.h"
+#include "ir_capfile_io.h"
+#include "philco_ac.h"
+
+#define SIGC_MAX_CAPTURES 256
+#define SIGC_MAX_TIMINGS 65536
+#define SIGC_GLITCH_US 100              // Pulsos menores são somados aos vizinhos pelo saneamento
+#define SIGC_MIN_TIMINGS 10             // Sinais mais curtos o receptor.c descarta
+
+typedef struct {
+    char name[IR_CAPFILE_TEXT_MAX_NAME];
+    uint16_t *data;
+    size_t length;
+    int same_as;                        // Índice da captura igual a esta, ou -1
+    int signal;                         // Índice na biblioteca
+} capture_t;
+
+static capture_t captures[SIGC_MAX_CAPTURES];
+static size_t capture_count;
+static uint16_t timings[SIGC_MAX_TIMINGS];
+static size_t timings_used;
+static size_t raw_timings;              // Antes do saneamento, de todas as capturas
+static uint16_t repaired[SIGC_MAX_TIMINGS];
+
+static bool raw_mode = false;
+static ir_calib_estimator_t estimator;  // Tempos antes do saneamento
+static ir_calib_t calib;
+
+static ir_siglib_builder_t builder;
+static ir_siglib_input_t inputs[IR_SIGLIB_MAX_SIGNALS];
+
+// Nome a partir do arquivo, sem diretório e extensão
+static void file_stem(char *out, size_t size, const char *path) {
+    const char *base = strrchr(path, '/');
+    base = base ? base + 1 : path;
+    size_t length = strcspn(base, ".");
+    length = length < size - 1 ? length : size - 1;
+    memcpy(out, base, length);
+    out[length] = '\0';
+}
+
+static bool add_capture(const char *name, const uint16_t *raw, size_t count) {
+    raw_timings += count;
+    if (count < SIGC_MIN_TIMINGS) {
+        fprintf(stderr, "ir_sigc: %s: %zu tempo(s), ignorado\n", name, count);
+        return true;
+    }
+    size_t length = count;
+    if (!raw_mode && count <= SIGC_MAX_TIMINGS) {
+        ir_repair_t r;
+        memcpy(repaired, raw, count * sizeof(uint16_t));
+        length = ir_capture_repair(repaired, count, SIGC_MAX_TIMINGS, philco_ac_check_timings, &r);
+    }
+    if (capture_count == SIGC_MAX_CAPTURES || timings_used + length > SIGC_MAX_TIMINGS) {
+        fprintf(stderr, "ir_sigc: capturas demais (máximo %d sinais, %d tempos)\n", SIGC_MAX_CAPTURES,
+                SIGC_MAX_TIMINGS);
+        return false;
+    }
+    for (size_t i = 0; i < capture_count; i++) {
+        if (strcmp(captures[i].name, name) == 0) {
+            fprintf(stderr, "ir_sigc: nome repetido: %s\n", name);
+            return false;
+        }
+    }
+
+    capture_t *c = &captures[capture_count++];
+    snprintf(c->name, sizeof(c->name), "%s", name);
+    ir_calib_add_capture(&estimator, raw, count);
+    c->data = &timings[timings_used];
+    if (raw_mode) {
+        memcpy(c->data, raw, count * sizeof(uint16_t));
+        c->length = count;
+    } else {
+        ir_sanitizer_t s;
+        ir_sanitizer_init(&s, SIGC_GLITCH_US);
+        c->length = ir_sanitize(repaired, length, c->data, &s);
+    }
+    c->same_as = -1;
+    timings_used += c->length;
+    return true;
+}
+
+static char *read_file(const char *path, size_t *size) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        return NULL;
+    }
+    char *text = NULL;
+    size_t used = 0;
+    size_t capacity = 0;
+    size_t n;
+    do {
+        if (used == capacity) {
+            capacity = capacity ? capacity * 2 : 65536;
+            char *grown = realloc(text, capacity);
+            if (!grown) {
+                free(text);
+                fclose(f);
+                return NULL;
+            }
+            text = grown;
+        }
+        n = fread(text + used, 1, capacity - used, f);
+        used += n;
+    } while (n > 0);
+    fclose(f);
+    *size = used;
+    return text;
+}
+
+static bool load_text(const char *path) {
+    size_t size;
+    char *text = read_file(path, &size);
+    if (!text) {
+        perror(path);
+        return false;
+    }
+
+    char stem[IR_CAPFILE_TEXT_MAX_NAME];
+    file_stem(stem, sizeof(stem), path);
+    ir_capfile_text_t t;
+    uint16_t raw[IR_CAPFILE_TEXT_MAX_TIMINGS];
+    size_t count;
+    unsigned number = 0;
+    bool ok = true;
+    ir_capfile_text_init(&t, text, size);
+    while (ok && (count = ir_capfile_text_next(&t, raw)) > 0) {
+        char name[IR_CAPFILE_TEXT_MAX_NAME];
+        number++;
+        if (t.name[0]) {
+            snprintf(name, sizeof(name), "%s", t.name);
+        } else {
+            snprintf(name, sizeof(name), "%.20s_%u", stem, number);
+        }
+        ok = add_capture(name, raw, count);
+    }
+    free(text);
+    return ok;
+}
+
+static bool load_capfile(const char *path) {
+    ir_capfile_map_t m;
+    ir_capfile_status_t status = ir_capfile_map_open(&m, path);
+    if (status != IR_CAPFILE_OK) {
+        fprintf(stderr, "%s: %s\n", path, ir_capfile_status_name(status));
+        return false;
+    }
+
+    char stem[IR_CAPFILE_TEXT_MAX_NAME];
+    file_stem(stem, sizeof(stem), path);
+    bool ok = true;
+    for (size_t i = 0; ok && i < m.file.frame_count; i++) {
+        ir_capfile_frame_t frame;
+        uint16_t raw[IR_CAPFILE_TEXT_MAX_TIMINGS];
+        char name[IR_CAPFILE_TEXT_MAX_NAME];
+        if (!ir_capfile_frame(&m.file, i, &frame)) {
+            fprintf(stderr, "%s: quadro %zu fora do arquivo\n", path, i);
+            ok = false;
+            break;
+        }
+        snprintf(name, sizeof(name), "%.20s_%zu", stem, i + 1);
+        ok = add_capture(name, raw, ir_capfile_decode(&frame, raw, IR_CAPFILE_TEXT_MAX_TIMINGS));
+    }
+    ir_capfile_map_close(&m);
+    return ok;
+}
+
+// Mesma quantidade de tempos, cada um dentro da tolerância do saneamento
+static bool same_signal(const capture_t *a, const capture_t *b) {
+    if (a->length != b->length) {
+        return false;
+    }
+    for (size_t i = 0; i < a->length; i++) {
+        uint32_t x = a->data[i];
+        uint32_t y = b->data[i];
+        uint32_t diff = x > y ? x - y : y - x;
+        if (diff * 100 > (x > y ? x : y) * IR_SANITIZE_TOLERANCE_PCT) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Identificador C em maiúsculas
+static void upper_identifier(char *out, size_t size, const char *name) {
+    size_t i = 0;
+    for (; name[i] && i < size - 1; i++) {
+        out[i] = isalnum((unsigned char)name[i]) ? (char)toupper((unsigned char)name[i]) : '_';
+    }
+    out[i] = '\0';
+}
+
+static int compare_names(const void *a, const void *b) {
+    const capture_t *x = *(const capture_t *const *)a;
+    const capture_t *y = *(const capture_t *const *)b;
+    return strcmp(x->name, y->name);
+}
+
+static void print_bytes(FILE *out, const uint8_t *data, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        fprintf(out, "%s0x%02X%s", i % 12 == 0 ? "    " : "", data[i],
+                i == size - 1 ? "\n" : (i % 12 == 11 ? ",\n" : ", "));
+    }
+}
+
+static bool write_header(const char *path, const char *prefix, const char *guard, const char *sources) {
+    FILE *out = fopen(path, "w");
+    if (!out) {
+        perror(path);
+        return false;
+    }
+    const ir_siglib_t *lib = &builder.lib;
+    char id[2 * IR_CAPFILE_TEXT_MAX_NAME + 2];
+    char upper[IR_CAPFILE_TEXT_MAX_NAME];
+
+    fprintf(out, "/**\n * %s.h - Gerado por ir_sigc a partir de%s\n *\n", prefix, sources);
+    fprintf(out, " * Não edite: mude as capturas e recompile.\n */\n\n");
+    fprintf(out, "#ifndef %s\n#define %s\n\n#include \"ir_siglib.h\"\n\n", guard, guard);
+    fprintf(out, "#ifdef __cplusplus\nextern \"C\" {\n#endif\n\n");
+
+    size_t total = 0;
+    for (size_t s = 0; s < lib->signal_count; s++) {
+        total += lib->signals[s].length;
+    }
+    upper_identifier(upper, sizeof(upper), prefix);
+    fprintf(out, "#define %s_COUNT %u\n", upper, lib->signal_count);
+    fprintf(out, "#define %s_TIMINGS %zu         // Soma dos tamanhos\n", upper, total);
+    fprintf(out, "#define %s_STRETCH_US %d        // Esticamento de marca do sensor nas capturas (%u pares)\n\n",
+            upper, calib.stretch_us, calib.samples);
+
+    fprintf(out, "// Índice de cada sinal na biblioteca (duplicadas apontam para o primeiro)\ntypedef enum {\n");
+    for (size_t i = 0; i < capture_count; i++) {
+        char name[IR_CAPFILE_TEXT_MAX_NAME];
+        upper_identifier(name, sizeof(name), captures[i].name);
+        snprintf(id, sizeof(id), "%s_%s", upper, name);
+        if (captures[i].same_as < 0) {
+            fprintf(out, "    %s = %d,\n", id, captures[i].signal);
+        } else {
+            fprintf(out, "    %s = %d,                // Igual a %s\n", id, captures[i].signal,
+                    captures[captures[i].same_as].name);
+        }
+    }
+    fprintf(out, "} %s_id_t;\n\n", prefix);
+
+    fprintf(out, "extern const ir_siglib_t %s_library;\n\n", prefix);
+    fprintf(out, "/**\n * Índice do sinal com o nome dado (inclusive duplicadas), ou -1\n */\n");
+    fprintf(out, "int %s_find(const char *name);\n\n", prefix);
+    fprintf(out, "#ifdef __cplusplus\n}\n#endif\n\n#endif // %s\n", guard);
+    return fclose(out) == 0;
+}
+
+static bool write_source(const char *path, const char *prefix, const char *sources) {
+    FILE *out = fopen(path, "w");
+    if (!out) {
+        perror(path);
+        return false;
+    }
+    const ir_siglib_t *lib = &builder.lib;
+
+    fprintf(out, "/**\n * %s.c - Gerado por ir_sigc a partir de%s\n *\n", prefix, sources);
+    fprintf(out, " * Não edite: mude as capturas e recompile.\n */\n\n");
+    fprintf(out, "#include <stdlib.h>\n#include <string.h>\n\n#include \"%s.h\"\n\n", prefix);
+
+    fprintf(out, "static const uint16_t levels[] = {");
+    for (size_t i = 0; i < lib->level_count; i++) {
+        fprintf(out, "%s%u", i ? ", " : "", lib->levels[i]);
+    }
+    fprintf(out, "};\n\nstatic const uint8_t base[] = {\n");
+    print_bytes(out, lib->base, (lib->base_length + 1u) / 2);
+    fprintf(out, "};\n\nstatic const uint8_t data[] = {\n");
+    print_bytes(out, lib->data, lib->data_size);
+    fprintf(out, "};\n\nstatic const ir_siglib_entry_t signals[] = {\n");
+    for (size_t s = 0; s < lib->signal_count; s++) {
+        fprintf(out, "    {\"%s\", %u, %u},\n", lib->signals[s].name, lib->signals[s].offset, lib->signals[s].length);
+    }
+    fprintf(out, "};\n\nconst ir_siglib_t %s_library = {\n", prefix);
+    fprintf(out, "    .quantum_us = %u,\n", lib->quantum_us);
+    fprintf(out, "    .level_count = sizeof(levels) / sizeof(levels[0]),\n    .levels = levels,\n");
+    fprintf(out, "    .base_length = %u,\n    .base = base,\n", lib->base_length);
+    fprintf(out, "    .signal_count = sizeof(signals) / sizeof(signals[0]),\n    .signals = signals,\n");
+    fprintf(out, "    .data_size = sizeof(data),\n    .data = data\n};\n\n");
+
+    // Índice de nomes ordenado, com as duplicadas
+    static const capture_t *sorted[SIGC_MAX_CAPTURES];
+    for (size_t i = 0; i < capture_count; i++) {
+        sorted[i] = &captures[i];
+    }
+    qsort(sorted, capture_count, sizeof(sorted[0]), compare_names);
+    fprintf(out, "typedef struct {\n    const char *name;\n    int index;\n} name_entry_t;\n\n");
+    fprintf(out, "static const name_entry_t names[] = {\n");
+    for (size_t i = 0; i < capture_count; i++) {
+        fprintf(out, "    {\"%s\", %d},\n", sorted[i]->name, sorted[i]->signal);
+    }
+    fprintf(out, "};\n\n");
+    fprintf(out, "static int compare_name(const void *key, const void *entry) {\n");
+    fprintf(out, "    return strcmp(key, ((const name_entry_t *)entry)->name);\n}\n\n");
+    fprintf(out, "int %s_find(const char *name) {\n", prefix);
+    fprintf(out, "    const name_entry_t *e = bsearch(name, names, sizeof(names) / sizeof(names[0]), sizeof(names[0]), "
+                 "compare_name);\n");
+    fprintf(out, "    return e ? e->index : -1;\n}\n");
+    return fclose(out) == 0;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "uso: %s [--quantum <us>] [--raw] [--prefix <nome>] --out <dir> <capturas.txt | .ircap>...\n",
+            argv0);
+}
+
+int main(int argc, char **argv) {
+    unsigned quantum = 8;
+    const char *prefix = "ir_signals";
+    const char *out_dir = NULL;
+    int i = 1;
+    for (; i < argc && strncmp(argv[i], "--", 2) == 0; i++) {
+        if (strcmp(argv[i], "--raw") == 0) {
+            raw_mode = true;
+        } else if (strcmp(argv[i], "--quantum") == 0 && i + 1 < argc) {
+            quantum = (unsigned)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--prefix") == 0 && i + 1 < argc) {
+            prefix = argv[++i];
+        } else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            out_dir = argv[++i];
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (!out_dir || i == argc || quantum > UINT8_MAX) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    // Capturas e a lista para o comentário dos arquivos gerados
+    char sources[1024] = "";
+    for (; i < argc; i++) {
+        const char *path = argv[i];
+        size_t length = strlen(path);
+        bool ok = length > 6 && strcmp(path + length - 6, ".ircap") == 0 ? load_capfile(path) : load_text(path);
+        if (!ok) {
+            return 1;
+        }
+        const char *base = strrchr(path, '/');
+        size_t used = strlen(sources);
+        snprintf(sources + used, sizeof(sources) - used, " %s", base ? base + 1 : path);
+    }
+
+    // Duplicadas: o primeiro sinal igual fica, os outros viram sinônimos
+    size_t unique = 0;
+    size_t unique_timings = 0;
+    for (size_t c = 0; c < capture_count; c++) {
+        for (size_t prev = 0; prev < c && captures[c].same_as < 0; prev++) {
+            if (captures[prev].same_as < 0 && same_signal(&captures[prev], &captures[c])) {
+                captures[c].same_as = (int)prev;
+                captures[c].signal = captures[prev].signal;
+            }
+        }
+        if (captures[c].same_as < 0) {
+            if (unique == IR_SIGLIB_MAX_SIGNALS) {
+                fprintf(stderr, "ir_sigc: mais de %d sinais diferentes\n", IR_SIGLIB_MAX_SIGNALS);
+                return 1;
+            }
+            captures[c].signal = (int)unique;
+            inputs[unique].name = captures[c].name;
+            inputs[unique].data = captures[c].data;
+            inputs[unique].length = captures[c].length;
+            unique_timings += captures[c].length;
+            unique++;
+        }
+    }
+    if (unique == 0 || !ir_siglib_pack(&builder, inputs, unique, (uint8_t)quantum)) {
+        fprintf(stderr, "ir_sigc: os sinais não cabem na biblioteca (ir_siglib.h)\n");
+        return 1;
+    }
+
+    // Desvio marca/espaço do sensor que gravou as capturas
+    if (!ir_calib_estimate(&estimator, &calib)) {
+        calib.stretch_us = 0;
+    }
+
+    char guard[IR_CAPFILE_TEXT_MAX_NAME + 3];
+    char path[4096];
+    upper_identifier(guard, sizeof(guard) - 2, prefix);
+    strcat(guard, "_H");
+    snprintf(path, sizeof(path), "%s/%s.h", out_dir, prefix);
+    if (!write_header(path, prefix, guard, sources)) {
+        return 1;
+    }
+    snprintf(path, sizeof(path), "%s/%s.c", out_dir, prefix);
+    if (!write_source(path, prefix, sources)) {
+        return 1;
+    }
+
+    printf("ir_sigc: %s: %zu captura(s), %zu duplicada(s), %zu sinal(is) com %zu tempos%s\n", prefix, capture_count,
+           capture_count - unique, unique, unique_timings, raw_mode ? "" : " saneados");
+    printf("ir_sigc: %s: esticamento de marca do sensor %d us (marcas %+d us, espaços %+d us, %u pares)\n", prefix,
+           calib.stretch_us, calib.mark_error_us, -calib.space_error_us, calib.samples);
+    printf("ir_sigc: %s: %zu bytes como uint16_t -> %zu bytes de tabelas (quantum %u us)\n", prefix,
+           raw_timings * sizeof(uint16_t), ir_siglib_size(&builder.lib), quantum);
+    return 0;
+}
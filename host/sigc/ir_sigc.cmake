@@ -0,0 +1,63 @@
+# Biblioteca de sinais gerada no build a partir das capturas
+#
+#   ir_sigc_add_library(<alvo> [QUANTUM <us>] [RAW] CAPTURES <arquivos>...)
+#
+# Roda o ir_sigc sobre as capturas (texto do receptor.c ou .ircap) e cria a
+# biblioteca estática <alvo> com <alvo>.c e <alvo>.h: o firmware e o host
+# usam as mesmas tabelas. O ir_sigc imprime o tamanho das tabelas no build.
+#
+# No host o ir_sigc é um alvo comum (host/sigc). No firmware ele é compilado
+# com o compilador nativo num ExternalProject, como o SDK faz com o pioasm.
+
+set(IR_SIGC_DIR ${CMAKE_CURRENT_LIST_DIR})
+
+function(ir_sigc_add_library TARGET)
+    cmake_parse_arguments(SIGC "RAW" "QUANTUM" "CAPTURES" ${ARGN})
+    if (NOT SIGC_QUANTUM)
+        set(SIGC_QUANTUM 8)
+    endif()
+    set(SIGC_FLAGS --quantum ${SIGC_QUANTUM} --prefix ${TARGET})
+    if (SIGC_RAW)
+        list(APPEND SIGC_FLAGS --raw)
+    endif()
+
+    if (TARGET ir_sigc)
+        set(SIGC_EXE $<TARGET_FILE:ir_sigc>)
+        set(SIGC_DEPENDS ir_sigc)
+    else()
+        if (NOT TARGET ir_sigc_build)
+            include(ExternalProject)
+            ExternalProject_Add(ir_sigc_build
+                PREFIX ir_sigc
+                SOURCE_DIR ${IR_SIGC_DIR}
+                BINARY_DIR ${CMAKE_BINARY_DIR}/ir_sigc
+                CMAKE_ARGS "-DCMAKE_MAKE_PROGRAM:FILEPATH=${CMAKE_MAKE_PROGRAM}"
+                BUILD_ALWAYS 1
+                INSTALL_COMMAND ""
+                BUILD_BYPRODUCTS ${CMAKE_BINARY_DIR}/ir_sigc/ir_sigc${CMAKE_HOST_EXECUTABLE_SUFFIX}
+            )
+        endif()
+        set(SIGC_EXE ${CMAKE_BINARY_DIR}/ir_sigc/ir_sigc${CMAKE_HOST_EXECUTABLE_SUFFIX})
+        set(SIGC_DEPENDS ir_sigc_build)
+    endif()
+
+    set(OUT_DIR ${CMAKE_CURRENT_BINARY_DIR}/${TARGET})
+    set(CAPTURES "")
+    foreach(CAPTURE ${SIGC_CAPTURES})
+        get_filename_component(CAPTURE ${CAPTURE} ABSOLUTE)
+        list(APPEND CAPTURES ${CAPTURE})
+    endforeach()
+
+    add_custom_command(OUTPUT ${OUT_DIR}/${TARGET}.c ${OUT_DIR}/${TARGET}.h
+        COMMAND ${CMAKE_COMMAND} -E make_directory ${OUT_DIR}
+        COMMAND ${SIGC_EXE} ${SIGC_FLAGS} --out ${OUT_DIR} ${CAPTURES}
+        DEPENDS ${SIGC_DEPENDS} ${CAPTURES}
+        COMMENT "ir_sigc ${TARGET}"
+    )
+
+    add_library(${TARGET} STATIC ${OUT_DIR}/${TARGET}.c)
+    target_include_directories(${TARGET} PUBLIC
+        ${OUT_DIR}
+        ${IR_SIGC_DIR}/../..
+    )
+endfunction()
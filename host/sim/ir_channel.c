@@ -0,0 +1,262 @@
+/**
+ * ir_channel.c - Efeitos do canal, forma de onda NEC e modelo do receptor PIO
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "host_sdk.h"
+#include "ir_channel.h"
+
+// NEC: 562,5 us por unidade, em meios us
+#define NEC_UNIT_HALF_US 1125
+
+// nec_receive.pio: 10 ticks por unidade NEC (56,25 us), em quartos de us
+#define RX_TICK 225
+#define RX_BURST_LOOPS 31               // BURST_LOOP_COUNTER + 1
+#define RX_SAMPLE_TICKS 16              // nop [BIT_SAMPLE_DELAY - 1] + in
+
+static uint32_t next_random(ir_channel_t *c) {
+    uint32_t x = c->seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    c->seed = x;
+    return x;
+}
+
+static int32_t jitter(ir_channel_t *c) {
+    uint32_t j = c->model.jitter_us;
+    return j ? (int32_t)(next_random(c) % (2 * j + 1)) - (int32_t)j : 0;
+}
+
+static void add_mark(ir_channel_t *c, size_t *n, uint32_t start, uint32_t end) {
+    if (*n < IR_CHANNEL_MAX_MARKS) {
+        c->starts[*n] = start;
+        c->ends[*n] = end;
+        (*n)++;
+    } else {
+        c->overflows++;
+    }
+}
+
+// Quase ordenado: só reflexos e pulsos ficam fora do lugar
+static void sort_marks(ir_channel_t *c, size_t n) {
+    for (size_t i = 1; i < n; i++) {
+        uint32_t s = c->starts[i];
+        uint32_t e = c->ends[i];
+        size_t j = i;
+        while (j > 0 && c->starts[j - 1] > s) {
+            c->starts[j] = c->starts[j - 1];
+            c->ends[j] = c->ends[j - 1];
+            j--;
+        }
+        c->starts[j] = s;
+        c->ends[j] = e;
+    }
+}
+
+void ir_channel_init(ir_channel_t *c, const ir_channel_model_t *model, uint32_t seed) {
+    memset(c, 0, sizeof(*c));
+    c->model = *model;
+    c->seed = seed ? seed : 1;
+}
+
+size_t ir_channel_apply(ir_channel_t *c, const uint16_t *in, size_t count, uint16_t *out, size_t max) {
+    const ir_channel_model_t *m = &c->model;
+    size_t n = 0;
+    uint32_t t = 0;
+
+    c->frames++;
+
+    // Ótico: marcas que chegam, reflexos e luz ambiente
+    for (size_t i = 0; i < count; i++) {
+        if (i % 2 == 0) {
+            if (m->dropout_ppm && next_random(c) % 1000000u < m->dropout_ppm) {
+                c->dropouts++;
+            } else {
+                add_mark(c, &n, t, t + in[i]);
+            }
+        }
+        t += in[i];
+    }
+    size_t direct = n;
+    if (m->echo_delay_us) {
+        for (size_t k = 0; k < direct; k++) {
+            if (next_random(c) % 100 < m->echo_pct) {
+                add_mark(c, &n, c->starts[k] + m->echo_delay_us, c->ends[k] + m->echo_delay_us);
+                c->echoes++;
+            }
+        }
+    }
+    if (m->glitch_per_s) {
+        // Chegadas de Poisson: intervalos exponenciais com média 1 s / taxa
+        float mean_us = 1e6f / m->glitch_per_s;
+        float g = 0;
+        while (true) {
+            g += -mean_us * logf((next_random(c) + 1.0f) / 4294967296.0f);
+            if (g >= t) {
+                break;
+            }
+            add_mark(c, &n, (uint32_t)g, (uint32_t)g + m->glitch_us);
+            c->glitches++;
+        }
+    }
+    if (n > direct) {
+        sort_marks(c, n);
+    }
+
+    // Receptor: une o que se sobrepõe no ar, estica as marcas e mexe nas bordas
+    size_t k = 0;
+    bool open = false;
+    int32_t cur_start = 0;
+    int32_t cur_end = 0;
+    int32_t prev_end = 0;
+    for (size_t i = 0; i <= n; i++) {
+        int32_t s = 0;
+        int32_t e = 0;
+        if (i < n) {
+            // Marcas sobrepostas no ar viram uma só antes do receptor
+            uint32_t os = c->starts[i];
+            uint32_t oe = c->ends[i];
+            while (i + 1 < n && c->starts[i + 1] <= oe) {
+                i++;
+                if (c->ends[i] > oe) {
+                    oe = c->ends[i];
+                }
+            }
+            s = (int32_t)os + jitter(c);
+            e = (int32_t)oe + m->mark_stretch_us + jitter(c);
+            if (e <= s) {
+                continue;               // Marca engolida pelo receptor
+            }
+            if (open && s <= cur_end) {
+                if (e > cur_end) {
+                    cur_end = e;
+                }
+                continue;
+            }
+        }
+        if (open) {
+            if (k > 0 && k < max) {
+                int32_t space = cur_start - prev_end;
+                out[k++] = space > UINT16_MAX ? UINT16_MAX : (uint16_t)space;
+            }
+            if (k < max) {
+                int32_t mark = cur_end - cur_start;
+                out[k++] = mark > UINT16_MAX ? UINT16_MAX : (uint16_t)mark;
+            }
+            prev_end = cur_end;
+        }
+        open = i < n;
+        cur_start = s;
+        cur_end = e;
+    }
+    return k;
+}
+
+size_t ir_channel_nec_waveform(uint32_t frame, uint16_t *out) {
+    uint8_t units[IR_CHANNEL_NEC_TIMINGS];
+    size_t n = 0;
+
+    units[n++] = 16;                    // Cabeçalho de 9 ms
+    units[n++] = 8;                     // Espaço de 4,5 ms
+    units[n++] = 1;
+    for (int bit = 0; bit < 32; bit++) {
+        units[n++] = (frame >> bit) & 1u ? 3 : 1;
+        units[n++] = 1;
+    }
+
+    // Tempos arredondados a partir do início, sem acumular o meio us
+    uint32_t half_us = 0;
+    uint32_t prev_us = 0;
+    for (size_t i = 0; i < n; i++) {
+        half_us += units[i] * NEC_UNIT_HALF_US;
+        uint32_t us = (half_us + 1) / 2;
+        out[i] = (uint16_t)(us - prev_us);
+        prev_us = us;
+    }
+    return n;
+}
+
+size_t ir_channel_nec_receive(const uint16_t *timings, size_t count, uint32_t *frames, size_t max) {
+    // Marcas em quartos de us
+    uint32_t starts[IR_CHANNEL_MAX_MARKS];
+    uint32_t ends[IR_CHANNEL_MAX_MARKS];
+    size_t marks = 0;
+    uint32_t t = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t d = (uint32_t)timings[i] * 4;
+        if (i % 2 == 0 && marks < IR_CHANNEL_MAX_MARKS) {
+            starts[marks] = t;
+            ends[marks] = t + d;
+            marks++;
+        }
+        t += d;
+    }
+
+    size_t pushed = 0;
+    uint32_t isr = 0;
+    int bits = 0;
+    uint32_t now = 0;
+    size_t m = 0;
+
+    while (true) {
+        now += RX_TICK;                 // set X
+
+        // wait 0 pin
+        while (m < marks && ends[m] <= now) {
+            m++;
+        }
+        if (m == marks) {
+            break;
+        }
+        uint32_t burst = starts[m] > now ? starts[m] : now;
+
+        // burst_loop: jmp pin no primeiro tick e a cada dois
+        uint32_t last_check = burst + RX_TICK * (1 + 2 * (RX_BURST_LOOPS - 1));
+        if (ends[m] > last_check) {
+            // Cabeçalho: zera o ISR e espera a marca acabar
+            isr = 0;
+            bits = 0;
+            now = ends[m] + RX_TICK;    // wait 1 pin + jmp
+            continue;
+        }
+        uint32_t first_check = burst + RX_TICK;
+        uint32_t k = ends[m] > first_check ? (ends[m] - first_check + 2 * RX_TICK - 1) / (2 * RX_TICK) : 0;
+        uint32_t sample = first_check + 2 * RX_TICK * k + RX_SAMPLE_TICKS * RX_TICK;
+
+        // in PINS: nível baixo (marca) = bit 0
+        bool low = false;
+        for (size_t j = m; j < marks && starts[j] <= sample; j++) {
+            if (ends[j] > sample) {
+                low = true;
+                break;
+            }
+        }
+        isr = (isr >> 1) | (low ? 0 : 0x80000000u);
+        if (++bits == 32) {
+            if (pushed < max) {
+                frames[pushed++] = isr;
+            }
+            bits = 0;
+        }
+        now = sample;
+    }
+    return pushed;
+}
+
+uint64_t ir_channel_play(const uint16_t *timings, size_t count, unsigned gpio, uint64_t start_us) {
+    uint64_t t = start_us;
+    for (size_t i = 0; i < count; i++) {
+        host_time_advance_to(t);
+        host_gpio_drive(gpio, i % 2 != 0);
+        t += timings[i];
+    }
+    host_time_advance_to(t);
+    host_gpio_drive(gpio, true);
+    return t;
+}
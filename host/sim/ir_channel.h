@@ -0,0 +1,109 @@
+/**
+ * ir_channel.h - Canal IR virtual entre a saída do transmissor e o receptor
+ *
+ * Recebe a forma de onda transmitida como envelope (tempos em us: marca,
+ * espaço, marca, ...), o mesmo formato de send_raw_signal() e do que o
+ * analisador de ir_txcheck.c demodula, e devolve o que a saída de um receptor
+ * TSOP entregaria, no mesmo formato. Os efeitos seguem a ordem física:
+ *
+ * 1. ótico: marcas perdidas (dropout), cópia atrasada de cada marca
+ *    (multipercurso) e pulsos de luz ambiente somam-se no ar; o atraso ótico
+ *    de um reflexo numa sala é desprezível, então atrasos de dezenas de us
+ *    representam a cauda do receptor saturado pelo reflexo, e atrasos maiores
+ *    um repetidor IR ou um segundo transmissor;
+ * 2. receptor: cada marca sai esticada (e o espaço seguinte encurtado), como
+ *    nas nossas capturas (marcas de ~400 us contra espaços de ~370 us num
+ *    protocolo de tempos iguais), e cada borda ganha um ruído uniforme.
+ *
+ * Nada é alocado por quadro e o gerador é determinístico pela semente, então
+ * varreduras de tolerância com milhões de quadros são reproduzíveis.
+ *
+ * O resultado pode ir direto a um decodificador de tempos, ao modelo do
+ * nec_receive.pio abaixo ou, por ir_channel_play(), às interrupções de GPIO
+ * do shim (receptor.c, ir_fusion.c).
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef IR_CHANNEL_H
+#define IR_CHANNEL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define IR_CHANNEL_MAX_MARKS 512        // Marcas por quadro, contando reflexos e pulsos
+#define IR_CHANNEL_NEC_TIMINGS 67       // Cabeçalho, 32 bits e pulso final
+
+typedef struct {
+    int16_t mark_stretch_us;            // Marca mais longa, espaço seguinte mais curto
+    uint16_t jitter_us;                 // Ruído uniforme de +-jitter em cada borda
+    uint32_t dropout_ppm;               // Chance de uma marca não chegar (por milhão)
+    uint16_t glitch_per_s;              // Pulsos de luz ambiente por segundo (média)
+    uint16_t glitch_us;                 // Duração de cada pulso
+    uint16_t echo_delay_us;             // Atraso do caminho refletido (0 = sem reflexo)
+    uint8_t echo_pct;                   // Marcas em que o reflexo chega forte o bastante
+} ir_channel_model_t;
+
+typedef struct {
+    ir_channel_model_t model;
+    uint32_t seed;
+
+    // Marcas do quadro em processamento (us desde o início)
+    uint32_t starts[IR_CHANNEL_MAX_MARKS];
+    uint32_t ends[IR_CHANNEL_MAX_MARKS];
+
+    // Contadores
+    uint64_t frames;
+    uint64_t dropouts;
+    uint64_t echoes;
+    uint64_t glitches;
+    uint64_t overflows;                 // Marcas descartadas por falta de espaço
+} ir_channel_t;
+
+void ir_channel_init(ir_channel_t *c, const ir_channel_model_t *model, uint32_t seed);
+
+/**
+ * Passa um quadro pelo canal
+ *
+ * @param in Tempos transmitidos, começando por uma marca
+ * @param out Tempos na saída do receptor (pode ser o próprio in)
+ * @param max Tamanho de out
+ * @return Quantidade de tempos em out (0 se nada chegou)
+ */
+size_t ir_channel_apply(ir_channel_t *c, const uint16_t *in, size_t count, uint16_t *out, size_t max);
+
+/**
+ * Forma de onda que o nec_carrier_control.pio transmite para um quadro
+ *
+ * @param out Recebe IR_CHANNEL_NEC_TIMINGS tempos
+ */
+size_t ir_channel_nec_waveform(uint32_t frame, uint16_t *out);
+
+/**
+ * Modelo do nec_receive.pio sobre tempos: mesma contagem de ticks para
+ * detectar o cabeçalho e mesmo instante de amostragem de cada bit
+ *
+ * @param frames Recebe cada palavra de 32 bits que o PIO empurraria ao FIFO
+ * @return Quantidade de palavras
+ */
+size_t ir_channel_nec_receive(const uint16_t *timings, size_t count, uint32_t *frames, size_t max);
+
+/**
+ * Reproduz os tempos como bordas em um pino de entrada do shim (saída ativa
+ * em nível baixo), avançando o relógio virtual a partir de start_us
+ *
+ * @return Instante do fim do último tempo
+ */
+uint64_t ir_channel_play(const uint16_t *timings, size_t count, unsigned gpio, uint64_t start_us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IR_CHANNEL_H
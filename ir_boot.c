@@ -0,0 +1,104 @@
+/**
+ * ir_boot.c - Etapas do boot e console guardado até a conexão USB
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "pico/stdio_usb.h"
+#include "hardware/timer.h"
+#include "ir_boot.h"
+
+ir_boot_t ir_boot;
+
+static const char *const stage_names[IR_BOOT_STAGES] = {
+    "TX pronto",
+    "RX pronto",
+    "primeiro quadro IR",
+    "console conectado",
+};
+
+void ir_boot_init(void) {
+    memset(&ir_boot, 0, sizeof(ir_boot));
+}
+
+void ir_boot_mark(ir_boot_stage_t stage) {
+    if (!ir_boot_reached(stage)) {
+        ir_boot.stage_us[stage] = time_us_64();
+        ir_boot.reached |= (uint8_t)(1u << stage);
+    }
+}
+
+void ir_boot_console_write(const char *text, size_t length) {
+    if (ir_boot.attached) {
+        fwrite(text, 1, length, stdout);
+        return;
+    }
+    size_t room = ir_boot.expired ? 0 : IR_BOOT_CONSOLE_BYTES - ir_boot.console_used;
+    size_t n = length < room ? length : room;
+    memcpy(ir_boot.console + ir_boot.console_used, text, n);
+    ir_boot.console_used += n;
+    ir_boot.console_lost += (uint32_t)(length - n);
+}
+
+void ir_boot_printf(const char *fmt, ...) {
+    char line[IR_BOOT_LINE_LEN];
+    va_list args;
+
+    va_start(args, fmt);
+    int n = vsnprintf(line, sizeof(line), fmt, args);
+    va_end(args);
+    if (n > 0) {
+        ir_boot_console_write(line, (size_t)n < sizeof(line) ? (size_t)n : sizeof(line) - 1);
+    }
+}
+
+bool ir_boot_poll(void) {
+    bool connected = stdio_usb_connected();
+
+    if (!connected) {
+        // Porta fechada de novo: volta a guardar
+        ir_boot.attached = false;
+        if (!ir_boot.expired && time_us_64() >= (uint64_t)IR_BOOT_CONSOLE_TIMEOUT_MS * 1000) {
+            ir_boot.expired = true;
+            ir_boot.console_lost += (uint32_t)ir_boot.console_used;
+            ir_boot.console_used = 0;
+        }
+        return false;
+    }
+    if (ir_boot.attached) {
+        return false;
+    }
+
+    ir_boot.attached = true;
+    ir_boot.expired = false;
+    ir_boot_mark(IR_BOOT_CONSOLE);
+    fwrite(ir_boot.console, 1, ir_boot.console_used, stdout);
+    if (ir_boot.console_lost) {
+        printf("[boot: %lu byte(s) do console perdidos antes da conexão]\n", (unsigned long)ir_boot.console_lost);
+    }
+    ir_boot.console_used = 0;
+    ir_boot.console_lost = 0;
+    return true;
+}
+
+void ir_boot_report(void) {
+    printf("Boot (desde o reset):\n");
+    for (int s = 0; s < IR_BOOT_STAGES; s++) {
+        if (ir_boot_reached((ir_boot_stage_t)s)) {
+            printf("  %-20s %8lu.%03lu ms\n", stage_names[s], (unsigned long)(ir_boot.stage_us[s] / 1000),
+                   (unsigned long)(ir_boot.stage_us[s] % 1000));
+        } else {
+            printf("  %-20s %12s\n", stage_names[s], "-");
+        }
+    }
+}
+
+const char *ir_boot_stage_name(ir_boot_stage_t stage) {
+    return stage < IR_BOOT_STAGES ? stage_names[stage] : "?";
+}
@@ -0,0 +1,103 @@
+/**
+ * ir_boot.h - Boot rápido: IR primeiro, console quando o host abrir a USB
+ *
+ * Os programas esperavam 2 a 3 s fixos (sleep_ms) pela USB antes de iniciar
+ * PIO e PWM, então depois de uma queda de energia o controle ficava surdo e
+ * mudo esse tempo todo. Agora o main() inicia os motores de TX/RX logo após
+ * stdio_init_all() e já atende a fila de comandos; o texto de início vai
+ * para o console de boot:
+ *
+ *  - ir_boot_printf() e ir_boot_console_write() (que serve de saída para o
+ *    ir_log) guardam o texto num buffer em RAM enquanto stdio_usb_connected()
+ *    for falso;
+ *  - ir_boot_poll(), no laço principal, entrega o buffer quando o host abre
+ *    a porta; passado IR_BOOT_CONSOLE_TIMEOUT_MS sem ninguém, o buffer é
+ *    descartado e o texto seguinte também, até alguém conectar. Com o buffer
+ *    cheio o começo (banner e ajuda) é mantido e o resto é contado como
+ *    perdido.
+ *
+ * ir_boot_mark() guarda o instante da primeira ocorrência de cada etapa
+ * (motores prontos, primeiro quadro IR, console conectado); ir_boot_report()
+ * mostra os tempos desde o reset.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef IR_BOOT_H
+#define IR_BOOT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define IR_BOOT_CONSOLE_BYTES 4096
+#define IR_BOOT_CONSOLE_TIMEOUT_MS 30000   // Sem host até aqui, o texto guardado é descartado
+#define IR_BOOT_LINE_LEN 160
+
+typedef enum {
+    IR_BOOT_TX_READY,
+    IR_BOOT_RX_READY,
+    IR_BOOT_FIRST_FRAME,               // Primeiro quadro IR entregue ao transmissor
+    IR_BOOT_CONSOLE,                   // Host abriu a porta USB
+    IR_BOOT_STAGES
+} ir_boot_stage_t;
+
+typedef struct {
+    uint64_t stage_us[IR_BOOT_STAGES]; // Desde o reset
+    uint8_t reached;                   // Máscara das etapas já marcadas
+
+    // Console
+    char console[IR_BOOT_CONSOLE_BYTES];
+    size_t console_used;
+    uint32_t console_lost;             // Bytes que não couberam ou expiraram
+    bool attached;
+    bool expired;
+} ir_boot_t;
+
+extern ir_boot_t ir_boot;
+
+/**
+ * Zera as etapas e o console (chamar logo após stdio_init_all())
+ */
+void ir_boot_init(void);
+
+/**
+ * Marca a etapa no instante atual (só a primeira chamada conta)
+ */
+void ir_boot_mark(ir_boot_stage_t stage);
+
+static inline bool ir_boot_reached(ir_boot_stage_t stage) {
+    return (ir_boot.reached >> stage) & 1;
+}
+
+/**
+ * Texto para o console: direto com o host conectado, senão no buffer
+ */
+void ir_boot_console_write(const char *text, size_t length);
+
+void ir_boot_printf(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+/**
+ * Confere a conexão USB e entrega o texto guardado (chamar no laço principal)
+ *
+ * @return true na chamada em que o host conectou
+ */
+bool ir_boot_poll(void);
+
+/**
+ * Imprime os tempos de cada etapa
+ */
+void ir_boot_report(void);
+
+const char *ir_boot_stage_name(ir_boot_stage_t stage);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IR_BOOT_H
@@ -0,0 +1,121 @@
+/**
+ * ir_calib.c - Estimativa e aplicação da correção marca/espaço
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <string.h>
+
+#include "ir_calib.h"
+#include "ir_capture.h"
+
+// Tempos nominais dos bits de cada protocolo
+typedef struct {
+    uint16_t mark_us;
+    uint16_t zero_space_us;
+    uint16_t one_space_us;
+} nominal_t;
+
+static const nominal_t nominals[IR_PROTOCOL_COUNT] = {
+    [IR_PROTOCOL_NEC] = {560, 560, 1690},
+    [IR_PROTOCOL_SAMSUNG] = {560, 560, 1690},
+    // Capturas antes do saneamento: marca ~403, espaços ~377 e ~1328 us
+    // (períodos de ~780 e ~1730 us)
+    [IR_PROTOCOL_PHILCO_AC] = {390, 390, 1340},
+};
+
+static bool in_window(uint32_t value, uint32_t nominal) {
+    uint32_t diff = value > nominal ? value - nominal : nominal - value;
+    return diff * 100 <= nominal * IR_CALIB_WINDOW_PCT;
+}
+
+void ir_calib_estimator_init(ir_calib_estimator_t *e) {
+    memset(e, 0, sizeof(*e));
+}
+
+void ir_calib_begin(ir_calib_estimator_t *e) {
+    e->position = 0;
+    e->previous_is_mark = false;
+    e->protocol = IR_PROTOCOL_UNKNOWN;
+}
+
+/**
+ * Par marca/espaço de um bit; cabeçalhos, pulso final e silêncios ficam
+ * fora da janela (vale também para os quadros repetidos da captura)
+ */
+static bool add_pair(ir_calib_estimator_t *e, const nominal_t *n, uint16_t mark, uint16_t space) {
+    uint16_t nominal = (uint32_t)space * 2 < (uint32_t)n->zero_space_us + n->one_space_us ? n->zero_space_us
+                                                                                           : n->one_space_us;
+    if (!in_window(mark, n->mark_us) || !in_window(space, nominal)) {
+        return false;
+    }
+    e->mark_sum_us += (int32_t)mark - n->mark_us;
+    e->space_sum_us += (int32_t)nominal - space;
+    e->samples++;
+
+    if (e->samples >= IR_CALIB_MAX_SAMPLES) {
+        e->mark_sum_us /= 2;
+        e->space_sum_us /= 2;
+        e->samples /= 2;
+    }
+    return true;
+}
+
+bool ir_calib_push(ir_calib_estimator_t *e, uint16_t us, bool mark) {
+    bool used = false;
+    if (e->position == 1 && !mark && e->previous_is_mark) {
+        // Cabeçalho: identifica o protocolo
+        uint16_t header[2] = {e->previous_us, us};
+        e->protocol = (uint8_t)ir_capture_identify(header, 2, NULL);
+        if (nominals[e->protocol].mark_us) {
+            e->captures++;
+        } else {
+            e->ignored++;
+        }
+    } else if (e->position > 1 && !mark && e->previous_is_mark && nominals[e->protocol].mark_us) {
+        used = add_pair(e, &nominals[e->protocol], e->previous_us, us);
+    }
+
+    e->previous_us = us;
+    e->previous_is_mark = mark;
+    if (e->position < UINT16_MAX) {
+        e->position++;
+    }
+    return used;
+}
+
+size_t ir_calib_add_capture(ir_calib_estimator_t *e, const uint16_t *raw, size_t count) {
+    size_t used = 0;
+    ir_calib_begin(e);
+    for (size_t i = 0; i < count; i++) {
+        used += ir_calib_push(e, raw[i], i % 2 == 0);
+    }
+    return used;
+}
+
+static int16_t rounded_div(int32_t sum, int32_t count) {
+    return (int16_t)(sum >= 0 ? (sum + count / 2) / count : (sum - count / 2) / count);
+}
+
+bool ir_calib_estimate(const ir_calib_estimator_t *e, ir_calib_t *out) {
+    memset(out, 0, sizeof(*out));
+    if (e->samples == 0) {
+        return false;
+    }
+    int32_t n = (int32_t)e->samples;
+    out->mark_error_us = rounded_div(e->mark_sum_us, n);
+    out->space_error_us = rounded_div(e->space_sum_us, n);
+    out->stretch_us = rounded_div(e->mark_sum_us + e->space_sum_us, 2 * n);
+    out->samples = e->samples > UINT16_MAX ? UINT16_MAX : (uint16_t)e->samples;
+    return e->samples >= IR_CALIB_MIN_SAMPLES;
+}
+
+void ir_calib_apply(const ir_calib_t *c, uint16_t *raw, size_t count) {
+    if (c->stretch_us == 0) {
+        return;
+    }
+    for (size_t i = 0; i < count; i++) {
+        raw[i] = ir_calib_correct_us(c, raw[i], i % 2 == 0);
+    }
+}
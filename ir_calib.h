@@ -0,0 +1,122 @@
+/**
+ * ir_calib.h - Calibração do desvio marca/espaço do receptor IR
+ *
+ * O demodulador de um receptor TSOP atrasa mais a borda de subida da saída
+ * que a de descida: cada marca sai mais longa e o espaço seguinte mais curto
+ * na mesma medida. Nas nossas capturas as marcas dos bits ficam em ~400-430
+ * us e os espaços equivalentes em ~345-375 us. Reenviar a captura como está
+ * leva o desvio junto, e o receptor do aparelho soma o dele.
+ *
+ * A estimativa usa capturas de protocolos conhecidos (identificados pelo
+ * cabeçalho, ir_capture_identify()): cada par marca/espaço de bit é
+ * comparado aos tempos nominais do protocolo. Nos três protocolos a marca e
+ * o espaço curto são iguais na origem, então o esticamento sai da diferença
+ * entre os dois, sem depender da escala de tempo do controle; o espaço longo
+ * entra pelo período nominal do bit. O Philco não tem especificação
+ * publicada: o nominal é a média da marca e do espaço curto capturados, com
+ * o período do bit medido.
+ *
+ * A estimativa precisa dos tempos como saem do sensor: o saneamento de
+ * ir_capture.c ajusta os tempos à grade e trata um esticamento grande como
+ * borda deslocada, passando o erro da marca ao espaço. Por isso os tempos
+ * entram um a um, na interrupção, antes do saneamento (ir_calib_push()), e
+ * a correção também é aplicada ali, antes do saneamento.
+ *
+ * A correção é guardada por sensor (ir_calib_t) e aplicada ao aprender um
+ * sinal (receptor.c, ir_fusion.c) e, opcionalmente, ao transmitir capturas
+ * que foram gravadas sem correção (custom_ir_set_tx_calib()).
+ *
+ * Nenhuma chamada de hardware: o mesmo código roda no firmware, no ir_sigc
+ * e sobre o canal virtual no host.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef IR_CALIB_H
+#define IR_CALIB_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define IR_CALIB_MIN_SAMPLES 64         // Pares marca/espaço para aceitar a estimativa (dois quadros NEC)
+#define IR_CALIB_MAX_SAMPLES 4096       // Acima disso as somas caem pela metade (pesa as capturas recentes)
+#define IR_CALIB_WINDOW_PCT 40          // Desvio do nominal aceito para um tempo entrar na estimativa
+
+// Somas acumuladas das capturas de um sensor
+typedef struct {
+    int32_t mark_sum_us;                // Soma de (marca - nominal)
+    int32_t space_sum_us;               // Soma de (nominal - espaço)
+    uint32_t samples;                   // Pares marca/espaço nas somas
+    uint32_t captures;                  // Capturas de protocolo conhecido
+    uint32_t ignored;                   // Capturas de protocolo desconhecido
+
+    // Captura em andamento
+    uint16_t position;                  // Tempos recebidos (satura)
+    uint16_t previous_us;               // Marca aguardando o espaço
+    bool previous_is_mark;
+    uint8_t protocol;                   // ir_protocol_t pelo cabeçalho
+} ir_calib_estimator_t;
+
+// Correção de um sensor
+typedef struct {
+    int16_t stretch_us;                 // Marca mais longa e espaço seguinte mais curto na saída
+    int16_t mark_error_us;              // Erro médio das marcas em relação ao nominal
+    int16_t space_error_us;             // Encurtamento médio dos espaços
+    uint16_t samples;                   // Pares usados na estimativa
+} ir_calib_t;
+
+void ir_calib_estimator_init(ir_calib_estimator_t *e);
+
+/**
+ * Início de uma captura (a próxima marca é a do cabeçalho)
+ */
+void ir_calib_begin(ir_calib_estimator_t *e);
+
+/**
+ * Próximo tempo da captura, como saiu do sensor
+ *
+ * @param mark Nível do tempo (o pulso de um glitch não troca a paridade)
+ * @return true se o tempo fechou um par marca/espaço aproveitado
+ */
+bool ir_calib_push(ir_calib_estimator_t *e, uint16_t us, bool mark);
+
+/**
+ * Acumula uma captura inteira (tempos sem correção nem saneamento, começando
+ * pela marca do cabeçalho)
+ *
+ * @return Pares marca/espaço aproveitados (0 se o protocolo é desconhecido)
+ */
+size_t ir_calib_add_capture(ir_calib_estimator_t *e, const uint16_t *raw, size_t count);
+
+/**
+ * Correção pelas somas acumuladas
+ *
+ * @param out Recebe a estimativa, mesmo com poucas amostras
+ * @return true se há pelo menos IR_CALIB_MIN_SAMPLES pares
+ */
+bool ir_calib_estimate(const ir_calib_estimator_t *e, ir_calib_t *out);
+
+/**
+ * Um tempo corrigido: a marca perde o esticamento e o espaço o recupera
+ */
+static inline uint16_t ir_calib_correct_us(const ir_calib_t *c, uint16_t us, bool mark) {
+    int32_t v = mark ? (int32_t)us - c->stretch_us : (int32_t)us + c->stretch_us;
+    return v < 1 ? 1 : (v > UINT16_MAX ? UINT16_MAX : (uint16_t)v);
+}
+
+/**
+ * Corrige os tempos no lugar (índices pares são marcas)
+ */
+void ir_calib_apply(const ir_calib_t *c, uint16_t *raw, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IR_CALIB_H
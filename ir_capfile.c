@@ -0,0 +1,176 @@
+/**
+ * ir_capfile.c - Leitura e montagem do contêiner binário de capturas
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "ir_capfile.h"
+
+static inline uint16_t get16(const uint8_t *p) {
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+static inline uint32_t get32(const uint8_t *p) {
+    return (uint32_t)get16(p) | (uint32_t)get16(p + 2) << 16;
+}
+
+static inline uint64_t get64(const uint8_t *p) {
+    return (uint64_t)get32(p) | (uint64_t)get32(p + 4) << 32;
+}
+
+static inline void put16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void put32(uint8_t *p, uint32_t v) {
+    put16(p, (uint16_t)v);
+    put16(p + 2, (uint16_t)(v >> 16));
+}
+
+static inline void put64(uint8_t *p, uint64_t v) {
+    put32(p, (uint32_t)v);
+    put32(p + 4, (uint32_t)(v >> 32));
+}
+
+ir_capfile_status_t ir_capfile_open(ir_capfile_t *f, const uint8_t *data, size_t size) {
+    if (size < IR_CAPFILE_HEADER_SIZE) {
+        return IR_CAPFILE_TRUNCATED;
+    }
+    if (get32(data) != IR_CAPFILE_MAGIC) {
+        return IR_CAPFILE_BAD_MAGIC;
+    }
+
+    uint16_t version = get16(data + 4);
+    uint16_t header_size = get16(data + 6);
+    uint16_t entry_size = get16(data + 8);
+    if (version != IR_CAPFILE_VERSION || header_size < IR_CAPFILE_HEADER_SIZE || entry_size < IR_CAPFILE_ENTRY_SIZE) {
+        return IR_CAPFILE_BAD_VERSION;
+    }
+
+    uint32_t frame_count = get32(data + 12);
+    uint64_t index_offset = get64(data + 16);
+    if (index_offset < header_size || index_offset > size ||
+        (size - index_offset) / entry_size < frame_count) {
+        return IR_CAPFILE_TRUNCATED;
+    }
+
+    f->data = data;
+    f->size = size;
+    f->index = data + index_offset;
+    f->frame_count = frame_count;
+    f->version = version;
+    f->entry_size = entry_size;
+    return IR_CAPFILE_OK;
+}
+
+bool ir_capfile_frame(const ir_capfile_t *f, size_t index, ir_capfile_frame_t *out) {
+    if (index >= f->frame_count) {
+        return false;
+    }
+    const uint8_t *e = f->index + index * f->entry_size;
+    uint64_t offset = get64(e);
+    uint32_t size = get32(e + 16);
+    if (offset > (uint64_t)(f->index - f->data) || size > (uint64_t)(f->index - f->data) - offset) {
+        return false;
+    }
+    out->time_us = get64(e + 8);
+    out->data = f->data + offset;
+    out->size = size;
+    out->count = get16(e + 20);
+    out->pin = e[22];
+    return true;
+}
+
+void ir_capfile_cursor_init(ir_capfile_cursor_t *c, const ir_capfile_frame_t *frame) {
+    c->p = frame->data;
+    c->end = frame->data + frame->size;
+    c->remaining = frame->count;
+}
+
+bool ir_capfile_next(ir_capfile_cursor_t *c, uint32_t *duration_us) {
+    if (c->remaining == 0) {
+        return false;
+    }
+
+    // Caminho comum: tempos de 128 a 16383 us ocupam 2 bytes
+    const uint8_t *p = c->p;
+    if (c->end - p >= 2 && !(p[1] & 0x80) && (p[0] & 0x80)) {
+        *duration_us = (uint32_t)(p[0] & 0x7F) | (uint32_t)p[1] << 7;
+        c->p = p + 2;
+        c->remaining--;
+        return true;
+    }
+
+    uint32_t v = 0;
+    for (unsigned shift = 0; shift < 7 * IR_CAPFILE_MAX_VARINT && p < c->end; shift += 7) {
+        uint8_t b = *p++;
+        v |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) {
+            *duration_us = v;
+            c->p = p;
+            c->remaining--;
+            return true;
+        }
+    }
+    c->remaining = 0;
+    return false;
+}
+
+size_t ir_capfile_decode(const ir_capfile_frame_t *frame, uint16_t *out, size_t max) {
+    ir_capfile_cursor_t c;
+    uint32_t v;
+    size_t n = 0;
+
+    ir_capfile_cursor_init(&c, frame);
+    while (n < max && ir_capfile_next(&c, &v)) {
+        out[n++] = (uint16_t)(v > UINT16_MAX ? UINT16_MAX : v);
+    }
+    return n;
+}
+
+size_t ir_capfile_encode(const uint16_t *raw, size_t count, uint8_t *out) {
+    uint8_t *p = out;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t v = raw[i];
+        while (v >= 0x80) {
+            *p++ = (uint8_t)(v | 0x80);
+            v >>= 7;
+        }
+        *p++ = (uint8_t)v;
+    }
+    return (size_t)(p - out);
+}
+
+void ir_capfile_put_header(uint8_t *out, uint32_t frame_count, uint64_t index_offset) {
+    put32(out, IR_CAPFILE_MAGIC);
+    put16(out + 4, IR_CAPFILE_VERSION);
+    put16(out + 6, IR_CAPFILE_HEADER_SIZE);
+    put16(out + 8, IR_CAPFILE_ENTRY_SIZE);
+    put16(out + 10, 0);
+    put32(out + 12, frame_count);
+    put64(out + 16, index_offset);
+}
+
+void ir_capfile_put_entry(uint8_t *out, uint64_t offset, const ir_capfile_frame_t *frame) {
+    put64(out, offset);
+    put64(out + 8, frame->time_us);
+    put32(out + 16, frame->size);
+    put16(out + 20, frame->count);
+    out[22] = frame->pin;
+    out[23] = 0;
+}
+
+const char *ir_capfile_status_name(ir_capfile_status_t status) {
+    switch (status) {
+        case IR_CAPFILE_OK:
+            return "ok";
+        case IR_CAPFILE_BAD_MAGIC:
+            return "não é um arquivo de capturas";
+        case IR_CAPFILE_BAD_VERSION:
+            return "versão não suportada";
+        default:
+            return "arquivo truncado";
+    }
+}
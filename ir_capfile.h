@@ -0,0 +1,147 @@
+/**
+ * ir_capfile.h - Contêiner binário de capturas RAW
+ *
+ * Substitui o texto "uint16_t rawSignalN[] = {...}" do receptor.c como
+ * formato de troca. Tudo em little-endian:
+ *
+ *   cabeçalho   IR_CAPFILE_HEADER_SIZE bytes
+ *   tempos      os tempos de cada quadro em varint (LEB128), quadro a quadro
+ *   índice      uma entrada por quadro, na ordem de gravação
+ *
+ * Cabeçalho:
+ *
+ *    0  "IRCF"
+ *    4  uint16  versão (IR_CAPFILE_VERSION)
+ *    6  uint16  tamanho do cabeçalho
+ *    8  uint16  tamanho de cada entrada do índice
+ *   10  uint16  reservado (0)
+ *   12  uint32  quantidade de quadros
+ *   16  uint64  offset do índice
+ *
+ * Entrada do índice:
+ *
+ *    0  uint64  offset dos tempos do quadro
+ *    8  uint64  instante do início do quadro (us desde o boot do receptor)
+ *   16  uint32  bytes dos tempos
+ *   20  uint16  quantidade de tempos (marca, espaço, marca, ...)
+ *   22  uint8   pino de origem
+ *   23  uint8   reservado (0)
+ *
+ * Campos novos só entram no fim do cabeçalho ou da entrada, aumentando o
+ * tamanho gravado, e leitores antigos os ignoram; mudança incompatível sobe
+ * a versão. O índice fica no fim para o gravador escrever os tempos em
+ * fluxo e o leitor chegar a qualquer quadro sem percorrer os anteriores.
+ *
+ * A leitura trabalha sobre o arquivo inteiro em memória (o mapeamento de
+ * host/capfile, ou flash): nada é copiado nem alocado, os tempos são lidos
+ * direto do varint por um cursor.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef IR_CAPFILE_H
+#define IR_CAPFILE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define IR_CAPFILE_MAGIC 0x46435249u          // "IRCF"
+#define IR_CAPFILE_VERSION 1
+#define IR_CAPFILE_HEADER_SIZE 24
+#define IR_CAPFILE_ENTRY_SIZE 24
+#define IR_CAPFILE_MAX_VARINT 5               // Bytes de um tempo de 32 bits
+
+typedef enum {
+    IR_CAPFILE_OK,
+    IR_CAPFILE_BAD_MAGIC,
+    IR_CAPFILE_BAD_VERSION,
+    IR_CAPFILE_TRUNCATED
+} ir_capfile_status_t;
+
+// Arquivo aberto sobre a memória
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+    const uint8_t *index;
+    uint32_t frame_count;
+    uint16_t version;
+    uint16_t entry_size;
+} ir_capfile_t;
+
+// Quadro (os tempos apontam para dentro do arquivo)
+typedef struct {
+    uint64_t time_us;
+    const uint8_t *data;
+    uint32_t size;
+    uint16_t count;
+    uint8_t pin;
+} ir_capfile_frame_t;
+
+// Leitura dos tempos de um quadro
+typedef struct {
+    const uint8_t *p;
+    const uint8_t *end;
+    uint16_t remaining;
+} ir_capfile_cursor_t;
+
+/**
+ * Confere o cabeçalho e os limites do índice
+ */
+ir_capfile_status_t ir_capfile_open(ir_capfile_t *f, const uint8_t *data, size_t size);
+
+/**
+ * Entrada index do índice
+ *
+ * @return false se o índice não existe ou aponta para fora do arquivo
+ */
+bool ir_capfile_frame(const ir_capfile_t *f, size_t index, ir_capfile_frame_t *out);
+
+void ir_capfile_cursor_init(ir_capfile_cursor_t *c, const ir_capfile_frame_t *frame);
+
+/**
+ * Próximo tempo do quadro
+ *
+ * @return false no fim do quadro ou em varint truncado
+ */
+bool ir_capfile_next(ir_capfile_cursor_t *c, uint32_t *duration_us);
+
+/**
+ * Expande os tempos de um quadro (acima de 65535 us ficam em 65535)
+ *
+ * @return Quantidade de tempos escritos (no máximo max)
+ */
+size_t ir_capfile_decode(const ir_capfile_frame_t *frame, uint16_t *out, size_t max);
+
+/**
+ * Tempos em varint
+ *
+ * @param out Destino com 3 bytes por tempo no pior caso
+ * @return Bytes escritos
+ */
+size_t ir_capfile_encode(const uint16_t *raw, size_t count, uint8_t *out);
+
+/**
+ * Monta o cabeçalho (IR_CAPFILE_HEADER_SIZE bytes)
+ */
+void ir_capfile_put_header(uint8_t *out, uint32_t frame_count, uint64_t index_offset);
+
+/**
+ * Monta uma entrada do índice (IR_CAPFILE_ENTRY_SIZE bytes)
+ *
+ * @param offset Posição dos tempos no arquivo
+ */
+void ir_capfile_put_entry(uint8_t *out, uint64_t offset, const ir_capfile_frame_t *frame);
+
+const char *ir_capfile_status_name(ir_capfile_status_t status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IR_CAPFILE_H
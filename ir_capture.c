@@ -0,0 +1,633 @@
+/**
+ * ir_capture.c - Pós-processamento dos sinais RAW capturados pelo receptor
+ */
+
+#include <string.h>
+
+#include "ir_capture.h"
+
+/**
+ * Estatísticas básicas (mínimo, máximo e médio)
+ */
+void ir_capture_compute_stats(const uint16_t *raw, size_t count, ir_capture_stats_t *stats) {
+    if (count == 0) {
+        stats->min_us = 0;
+        stats->max_us = 0;
+        stats->sum_us = 0;
+        stats->mean_us = 0;
+        return;
+    }
+
+    uint16_t min_time = raw[0];
+    uint16_t max_time = raw[0];
+    uint32_t sum_time = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        if (raw[i] < min_time) min_time = raw[i];
+        if (raw[i] > max_time) max_time = raw[i];
+        sum_time += raw[i];
+    }
+
+    stats->min_us = min_time;
+    stats->max_us = max_time;
+    stats->sum_us = sum_time;
+    stats->mean_us = (uint16_t)(sum_time / count);
+}
+
+// ---------------------------------------------------------------------------
+// Saneamento (glitches e grade de tempos)
+// ---------------------------------------------------------------------------
+
+#define SEED_LEVEL_WEIGHT 4    // Peso inicial dos níveis conhecidos do protocolo
+#define MAX_LEVEL_WEIGHT 16    // Janela da média móvel de cada nível
+#define HEADER_TOLERANCE_PCT 15
+
+// Tempos característicos de cada protocolo (listas terminadas em 0)
+typedef struct {
+    ir_protocol_t protocol;
+    const char *name;
+    uint16_t header_mark_us;
+    uint16_t header_space_us;
+    uint16_t frame_count;        // Tempos por quadro, do cabeçalho à marca final
+    uint16_t marks[2];           // Níveis dos bits
+    uint16_t spaces[3];
+} ir_protocol_info_t;
+
+static const ir_protocol_info_t protocol_table[] = {
+    {IR_PROTOCOL_NEC, "NEC", 9000, 4500, 67, {560, 0}, {1690, 560, 0}},
+    {IR_PROTOCOL_NEC, "NEC", 9000, 2250, 3, {560, 0}, {0}},      // Repetição
+    {IR_PROTOCOL_SAMSUNG, "Samsung", 4500, 4500, 67, {560, 0}, {1690, 560, 0}},
+    {IR_PROTOCOL_PHILCO_AC, "Philco AC", 3600, 1750, 227, {420, 0}, {1300, 350, 0}},
+};
+
+#define NO_FORMAT 0xFF
+
+static bool within_tolerance(uint32_t value, uint32_t center) {
+    uint32_t diff = value > center ? value - center : center - value;
+    return diff * 100 <= center * IR_SANITIZE_TOLERANCE_PCT;
+}
+
+static uint32_t distance(uint32_t a, uint32_t b) {
+    return a > b ? a - b : b - a;
+}
+
+static int nearest_level(const ir_grid_level_t *levels, uint8_t count, uint32_t value) {
+    int best = -1;
+    for (int i = 0; i < count; i++) {
+        if (best < 0 || distance(value, levels[i].center_us) < distance(value, levels[best].center_us)) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+static void learn_level(ir_grid_level_t *level, uint32_t value) {
+    if (level->count < MAX_LEVEL_WEIGHT) {
+        level->count++;
+    }
+    level->center_us = (uint16_t)((int32_t)level->center_us + ((int32_t)value - (int32_t)level->center_us) / level->count);
+}
+
+static uint8_t seed_levels(ir_grid_level_t *levels, const uint16_t *centers) {
+    uint8_t n = 0;
+    while (n < IR_SANITIZE_MAX_LEVELS && centers[n] != 0) {
+        levels[n].center_us = centers[n];
+        levels[n].count = SEED_LEVEL_WEIGHT;
+        n++;
+    }
+    return n;
+}
+
+/**
+ * Entrada da tabela de protocolos pela marca do cabeçalho (o espaço desempata)
+ */
+static uint8_t find_format(uint32_t mark_us, uint32_t space_us) {
+    uint8_t format = NO_FORMAT;
+    for (size_t i = 0; i < sizeof(protocol_table) / sizeof(protocol_table[0]); i++) {
+        const ir_protocol_info_t *info = &protocol_table[i];
+        if (distance(mark_us, info->header_mark_us) * 100 > info->header_mark_us * HEADER_TOLERANCE_PCT) {
+            continue;
+        }
+        if (format == NO_FORMAT ||
+            distance(space_us, info->header_space_us) < distance(space_us, protocol_table[format].header_space_us)) {
+            format = (uint8_t)i;
+        }
+    }
+    return format;
+}
+
+/**
+ * Identifica o protocolo pelo cabeçalho e carrega a grade dos bits dele
+ */
+static void identify_protocol(ir_sanitizer_t *s, uint32_t mark_us, uint32_t space_us) {
+    s->protocol = IR_PROTOCOL_UNKNOWN;
+    s->frame_format = find_format(mark_us, space_us);
+    if (s->frame_format != NO_FORMAT) {
+        const ir_protocol_info_t *info = &protocol_table[s->frame_format];
+        s->protocol = info->protocol;
+        s->mark_levels = seed_levels(s->marks, info->marks);
+        s->space_levels = seed_levels(s->spaces, info->spaces);
+    }
+}
+
+ir_protocol_t ir_capture_identify(const uint16_t *raw, size_t count, bool *repeat) {
+    uint8_t format = count >= 2 ? find_format(raw[0], raw[1]) : NO_FORMAT;
+    if (repeat) {
+        // Só a repetição não tem níveis de espaço
+        *repeat = format != NO_FORMAT && protocol_table[format].spaces[0] == 0;
+    }
+    return format != NO_FORMAT ? protocol_table[format].protocol : IR_PROTOCOL_UNKNOWN;
+}
+
+/**
+ * Ajusta a marca ou o espaço do cabeçalho ao valor nominal do protocolo
+ */
+static bool snap_header(ir_sanitizer_t *s, uint32_t value, uint16_t *snapped, int32_t *carry) {
+    if (s->frame_format == NO_FORMAT) {
+        return false;
+    }
+    const ir_protocol_info_t *info = &protocol_table[s->frame_format];
+    uint16_t nominal = s->pending_is_mark ? info->header_mark_us : info->header_space_us;
+    if (!within_tolerance(value, nominal)) {
+        return false;
+    }
+    *snapped = nominal;
+    *carry = (int32_t)value - nominal;
+    s->snapped++;
+    return true;
+}
+
+/**
+ * Fecha o quadro atual e confere a quantidade de tempos
+ */
+static void end_frame(ir_sanitizer_t *s) {
+    if (s->frame_count == 0) {
+        return;
+    }
+    if (s->frame_format != NO_FORMAT && s->frame_count != protocol_table[s->frame_format].frame_count) {
+        s->count_mismatch = true;
+    }
+    s->frames++;
+    s->frame_count = 0;
+    s->header_seen = false;
+}
+
+static uint16_t clamp_us(uint32_t value) {
+    return value > UINT16_MAX ? UINT16_MAX : (uint16_t)value;
+}
+
+/**
+ * Decide o valor do tempo pendente
+ *
+ * @param next Próximo tempo (nível oposto), se has_next
+ * @param carry Recebe o erro a repassar ao próximo tempo
+ */
+static uint16_t resolve_pending(ir_sanitizer_t *s, uint32_t next, bool has_next, int32_t *carry) {
+    uint32_t value = s->pending_us;
+    ir_grid_level_t *levels = s->pending_is_mark ? s->marks : s->spaces;
+    uint8_t *level_count = s->pending_is_mark ? &s->mark_levels : &s->space_levels;
+    ir_grid_level_t *other = s->pending_is_mark ? s->spaces : s->marks;
+    uint8_t other_count = s->pending_is_mark ? s->space_levels : s->mark_levels;
+
+    *carry = 0;
+
+    // Silêncio entre quadros não entra na grade
+    if (!s->pending_is_mark && value >= IR_SANITIZE_FRAME_GAP_US) {
+        return clamp_us(value);
+    }
+
+    // Cabeçalho tem valores próprios, fora da grade dos bits
+    uint16_t snapped;
+    if (s->frame_count < 2) {
+        if (snap_header(s, value, &snapped, carry)) {
+            return snapped;
+        }
+        s->off_grid++;
+        return clamp_us(value);
+    }
+
+    int i = nearest_level(levels, *level_count, value);
+    // Dentro da tolerância: o desvio é jitter do próprio tempo, não repassa
+    if (i >= 0 && within_tolerance(value, levels[i].center_us)) {
+        learn_level(&levels[i], value);
+        s->snapped++;
+        return levels[i].center_us;
+    }
+
+    // Borda deslocada: com o erro repassado, o próximo tempo cai na grade
+    if (i >= 0 && has_next) {
+        int32_t err = (int32_t)value - levels[i].center_us;
+        int32_t corrected = (int32_t)next + err;
+        if (corrected >= s->glitch_us) {
+            int j = nearest_level(other, other_count, (uint32_t)corrected);
+            int k = nearest_level(other, other_count, next);
+            if (j >= 0 && within_tolerance((uint32_t)corrected, other[j].center_us) &&
+                distance((uint32_t)corrected, other[j].center_us) < distance(next, other[k].center_us)) {
+                *carry = err;
+                s->edge_shifts++;
+                return levels[i].center_us;
+            }
+        }
+    }
+
+    // Fora da grade: em protocolo desconhecido pode ser um nível novo
+    if (s->frame_format == NO_FORMAT && *level_count < IR_SANITIZE_MAX_LEVELS) {
+        levels[*level_count].center_us = clamp_us(value);
+        levels[*level_count].count = 1;
+        (*level_count)++;
+    }
+    s->off_grid++;
+    return clamp_us(value);
+}
+
+static void emit_pending(ir_sanitizer_t *s, uint16_t value, uint16_t *out) {
+    bool gap = !s->pending_is_mark && value >= IR_SANITIZE_FRAME_GAP_US;
+    if (gap) {
+        end_frame(s);
+    } else {
+        s->frame_count++;
+    }
+    *out = value;
+}
+
+void ir_sanitizer_init(ir_sanitizer_t *s, uint16_t glitch_us) {
+    memset(s, 0, sizeof(*s));
+    s->glitch_us = glitch_us;
+    s->frame_format = NO_FORMAT;
+}
+
+/**
+ * Distância do tempo até o nível mais próximo
+ */
+static uint32_t fit_cost(const ir_grid_level_t *levels, uint8_t count, uint32_t value) {
+    return distance(value, levels[nearest_level(levels, count, value)].center_us);
+}
+
+/**
+ * Decide se o pulso curto entre o pendente e o próximo tempo é glitch: sem
+ * grade, qualquer pulso curto é; com grade, só se a soma dos três cair num
+ * nível e se ajustar melhor que os três separados (um espaço curto de verdade,
+ * com jitter, fica)
+ */
+static bool is_glitch(const ir_sanitizer_t *s, uint32_t glitch, uint32_t next) {
+    const ir_grid_level_t *levels = s->pending_is_mark ? s->marks : s->spaces;
+    uint8_t level_count = s->pending_is_mark ? s->mark_levels : s->space_levels;
+    const ir_grid_level_t *other = s->pending_is_mark ? s->spaces : s->marks;
+    uint8_t other_count = s->pending_is_mark ? s->space_levels : s->mark_levels;
+
+    if (s->frame_format == NO_FORMAT || s->frame_count < 2 || level_count == 0 || other_count == 0) {
+        return true;
+    }
+    uint32_t sum = s->pending_us + glitch + next;
+    int i = nearest_level(levels, level_count, sum);
+    if (!within_tolerance(sum, levels[i].center_us)) {
+        return false;
+    }
+    uint32_t split = fit_cost(levels, level_count, s->pending_us) + fit_cost(other, other_count, glitch) +
+                     fit_cost(levels, level_count, next);
+    return distance(sum, levels[i].center_us) <= split;
+}
+
+/**
+ * Passo normal: resolve o pendente com o próximo tempo conhecido
+ */
+static size_t advance(ir_sanitizer_t *s, uint16_t duration_us, uint16_t *out) {
+    // Marca e espaço do cabeçalho definem o protocolo do quadro
+    if (s->pending_is_mark && !s->header_seen) {
+        identify_protocol(s, s->pending_us, duration_us);
+        s->header_seen = true;
+    }
+
+    int32_t carry;
+    uint16_t value = resolve_pending(s, duration_us, true, &carry);
+    emit_pending(s, value, out);
+
+    int32_t next = (int32_t)duration_us + carry;
+    s->pending_us = next > 0 ? (uint32_t)next : 0;
+    s->pending_is_mark = !s->pending_is_mark;
+    return 1;
+}
+
+size_t ir_sanitizer_push(ir_sanitizer_t *s, uint16_t duration_us, uint16_t *out) {
+    if (!s->has_pending) {
+        s->pending_us = duration_us;
+        s->has_pending = true;
+        s->pending_is_mark = true;
+        return 0;
+    }
+
+    // Pulso curto anterior: agora que o tempo seguinte é conhecido, decide
+    if (s->has_glitch) {
+        s->has_glitch = false;
+        if (is_glitch(s, s->glitch_us_pending, duration_us)) {
+            s->pending_us += s->glitch_us_pending + duration_us;
+            s->glitches_merged++;
+            return 0;
+        }
+        size_t n = advance(s, s->glitch_us_pending, out);
+        return n + advance(s, duration_us, &out[n]);
+    }
+
+    if (duration_us < s->glitch_us) {
+        s->glitch_us_pending = duration_us;
+        s->has_glitch = true;
+        return 0;
+    }
+    return advance(s, duration_us, out);
+}
+
+size_t ir_sanitizer_finish(ir_sanitizer_t *s, uint16_t *out) {
+    size_t n = 0;
+    if (s->has_glitch) {
+        // Pulso curto no fim do sinal: não há tempo seguinte para somar
+        s->has_glitch = false;
+        if (s->has_pending) {
+            n = advance(s, s->glitch_us_pending, out);
+        }
+    }
+    if (s->has_pending) {
+        int32_t carry;
+        uint16_t value = resolve_pending(s, 0, false, &carry);
+        emit_pending(s, value, &out[n]);
+        s->has_pending = false;
+        n++;
+    }
+    end_frame(s);
+    return n;
+}
+
+size_t ir_sanitize(const uint16_t *raw, size_t count, uint16_t *out, ir_sanitizer_t *s) {
+    size_t n = 0;
+    for (size_t i = 0; i < count; i++) {
+        n += ir_sanitizer_push(s, raw[i], &out[n]);
+    }
+    n += ir_sanitizer_finish(s, &out[n]);
+    return n;
+}
+
+// ---------------------------------------------------------------------------
+// Reparo (marcas perdidas)
+// ---------------------------------------------------------------------------
+
+#define MAX_FRAME_SPACES 128   // Espaços por quadro reparável
+
+// Bits de um espaço reconstruído com 0 e 1 (ordem desconhecida)
+typedef struct {
+    size_t position;           // Espaço do primeiro bit
+    uint8_t bits;
+    uint8_t ones;
+} mixed_group_t;
+
+/**
+ * Tempo de um espaço com `lost` marcas perdidas e `ones` bits longos; no
+ * cabeçalho o primeiro pedaço é o espaço do cabeçalho, não um bit
+ */
+static uint32_t composite_us(const ir_protocol_info_t *info, bool header, uint8_t lost, uint8_t ones) {
+    uint8_t bits = header ? lost : lost + 1;
+    uint32_t first = header ? info->header_space_us : 0;
+    return first + (uint32_t)lost * info->marks[0] + (uint32_t)ones * info->spaces[0] +
+           (uint32_t)(bits - ones) * info->spaces[1];
+}
+
+/**
+ * Menor distância do espaço até um composto com `lost` marcas perdidas
+ *
+ * @param ones Recebe a quantidade de bits longos do composto mais próximo
+ */
+static uint32_t composite_cost(const ir_protocol_info_t *info, bool header, uint32_t value, uint8_t lost,
+                               uint8_t *ones) {
+    uint8_t bits = header ? lost : lost + 1;
+    uint32_t best = UINT32_MAX;
+    for (uint8_t o = 0; o <= bits; o++) {
+        uint32_t cost = distance(value, composite_us(info, header, lost, o));
+        if (cost < best) {
+            best = cost;
+            if (ones) {
+                *ones = o;
+            }
+        }
+    }
+    return best;
+}
+
+/**
+ * Distância do espaço até o composto mais próximo, com ou sem marcas perdidas
+ */
+static uint32_t space_cost(const ir_protocol_info_t *info, bool header, uint32_t value) {
+    uint32_t best = UINT32_MAX;
+    for (uint8_t lost = 0; lost <= IR_REPAIR_MAX_LOST; lost++) {
+        uint32_t cost = composite_cost(info, header, value, lost, NULL);
+        best = cost < best ? cost : best;
+    }
+    return best;
+}
+
+/**
+ * Marcas curtas demais: a borda de início atrasou e o atraso ficou no
+ * espaço anterior
+ */
+static uint16_t shift_late_marks(const ir_protocol_info_t *info, uint16_t *frame, size_t len) {
+    uint16_t shifts = 0;
+    uint16_t mark = info->marks[0];
+    for (size_t i = 2; i < len; i += 2) {
+        if (frame[i] >= mark || within_tolerance(frame[i], mark)) {
+            continue;
+        }
+        uint16_t delay = mark - frame[i];
+        if (frame[i - 1] <= delay) {
+            continue;
+        }
+        bool header = i == 2;
+        if (space_cost(info, header, frame[i - 1] - delay) < space_cost(info, header, frame[i - 1])) {
+            frame[i - 1] -= delay;
+            frame[i] = mark;
+            shifts++;
+        }
+    }
+    return shifts;
+}
+
+/**
+ * Espaços dos bits de um grupo misto na ordem `order` (índice entre as
+ * combinações com `ones` bits longos, da menor máscara para a maior)
+ */
+static void write_group(const ir_protocol_info_t *info, uint16_t *raw, const mixed_group_t *g, uint16_t order) {
+    for (uint8_t mask = 0; mask < 1u << g->bits; mask++) {
+        uint8_t ones = 0;
+        for (uint8_t b = 0; b < g->bits; b++) {
+            ones += (mask >> b) & 1;
+        }
+        if (ones != g->ones) {
+            continue;
+        }
+        if (order-- == 0) {
+            for (uint8_t b = 0; b < g->bits; b++) {
+                raw[g->position + 2 * b] = (mask >> b) & 1 ? info->spaces[0] : info->spaces[1];
+            }
+            return;
+        }
+    }
+}
+
+static uint16_t binomial(uint8_t n, uint8_t k) {
+    uint16_t c = 1;
+    for (uint8_t i = 1; i <= k; i++) {
+        c = (uint16_t)(c * (n - k + i) / i);
+    }
+    return c;
+}
+
+/**
+ * Escolhe a ordem dos grupos mistos que a conferência aceita
+ *
+ * @return true se alguma ordem foi aceita (senão fica a primeira)
+ */
+static bool order_groups(const ir_protocol_info_t *info, uint16_t *raw, size_t start, size_t len,
+                         const mixed_group_t *groups, uint8_t count, ir_frame_check_t check) {
+    uint32_t total = 1;
+    for (uint8_t g = 0; g < count; g++) {
+        total *= binomial(groups[g].bits, groups[g].ones);
+    }
+    if (total <= IR_REPAIR_MAX_ORDERS) {
+        for (uint32_t n = 0; n < total; n++) {
+            uint32_t rest = n;
+            for (uint8_t g = 0; g < count; g++) {
+                uint16_t options = binomial(groups[g].bits, groups[g].ones);
+                write_group(info, raw, &groups[g], (uint16_t)(rest % options));
+                rest /= options;
+            }
+            if (check(&raw[start], len)) {
+                return true;
+            }
+        }
+    }
+    for (uint8_t g = 0; g < count; g++) {
+        write_group(info, raw, &groups[g], 0);
+    }
+    return false;
+}
+
+/**
+ * Repara um quadro curto que começa em raw[start]
+ *
+ * @return Tempos acrescentados
+ */
+static size_t repair_frame(const ir_protocol_info_t *info, uint16_t *raw, size_t count, size_t max, size_t start,
+                           size_t len, ir_frame_check_t check, ir_repair_t *r) {
+    size_t missing = info->frame_count - len;
+    size_t spaces = len / 2;
+    if (missing % 2 != 0 || spaces > MAX_FRAME_SPACES || count + missing > max) {
+        return 0;
+    }
+    r->edge_shifts += shift_late_marks(info, &raw[start], len);
+
+    // Marcas perdidas vão para os espaços que mais se aproximam da grade com elas
+    uint8_t lost[MAX_FRAME_SPACES] = {0};
+    for (size_t n = 0; n < missing / 2; n++) {
+        size_t best = spaces;
+        uint32_t best_gain = 0;
+        for (size_t i = 0; i < spaces; i++) {
+            uint32_t value = raw[start + 1 + 2 * i];
+            if (lost[i] == IR_REPAIR_MAX_LOST) {
+                continue;
+            }
+            uint32_t now = composite_cost(info, i == 0, value, lost[i], NULL);
+            uint32_t next = composite_cost(info, i == 0, value, lost[i] + 1, NULL);
+            if (next < now && now - next > best_gain) {
+                best_gain = now - next;
+                best = i;
+            }
+        }
+        if (best == spaces) {
+            return 0;
+        }
+        lost[best]++;
+    }
+
+    // Cada espaço composto vira espaço + marca + espaço, com os tempos nominais
+    mixed_group_t groups[IR_REPAIR_MAX_MIXED];
+    uint8_t group_count = 0;
+    bool unordered = false;
+    size_t added = 0;
+    for (size_t i = 0; i < spaces; i++) {
+        if (lost[i] == 0) {
+            continue;
+        }
+        size_t pos = start + 1 + 2 * i + added;
+        bool header = i == 0;
+        uint8_t ones = 0;
+        uint32_t value = raw[pos];
+        composite_cost(info, header, value, lost[i], &ones);
+        size_t grow = 2 * (size_t)lost[i];
+        memmove(&raw[pos + 1 + grow], &raw[pos + 1], (count + added - pos - 1) * sizeof(raw[0]));
+        for (size_t k = 0; k < grow; k += 2) {
+            raw[pos + 1 + k] = info->marks[0];
+        }
+        added += grow;
+        r->marks_rebuilt += lost[i];
+
+        mixed_group_t g = {header ? pos + 2 : pos, header ? lost[i] : lost[i] + 1, ones};
+        write_group(info, raw, &g, 0);
+        if (header) {
+            // O cabeçalho fica com a sobra do composto
+            uint32_t bits = composite_us(info, true, lost[i], ones) - info->header_space_us;
+            raw[pos] = value > bits ? clamp_us(value - bits) : info->header_space_us;
+        }
+        if (g.ones != 0 && g.ones != g.bits) {
+            r->mixed++;
+            if (group_count < IR_REPAIR_MAX_MIXED) {
+                groups[group_count++] = g;
+            } else {
+                unordered = true;
+            }
+        }
+    }
+
+    if (group_count > 0 && check) {
+        unordered |= !order_groups(info, raw, start, len + added, groups, group_count, check);
+    }
+    if (unordered) {
+        r->unordered++;
+    }
+    return added;
+}
+
+size_t ir_capture_repair(uint16_t *raw, size_t count, size_t max, ir_frame_check_t check, ir_repair_t *r) {
+    memset(r, 0, sizeof(*r));
+    size_t start = 0;
+    while (start + 1 < count) {
+        size_t end = start + 1;
+        while (end < count && raw[end] < IR_SANITIZE_FRAME_GAP_US) {
+            end += 2;
+        }
+        if (end > count) {
+            end = count;
+        }
+
+        uint8_t format = find_format(raw[start], raw[start + 1]);
+        if (format != NO_FORMAT) {
+            const ir_protocol_info_t *info = &protocol_table[format];
+            size_t len = end - start;
+            if (len < info->frame_count && info->spaces[0] != 0 && info->spaces[1] != 0) {
+                size_t added = repair_frame(info, raw, count, max, start, len, check, r);
+                count += added;
+                end += added;
+                len += added;
+            }
+            r->protocol = info->protocol;
+            r->count_mismatch |= len != info->frame_count;
+        }
+        r->frames++;
+        start = end + 1;
+    }
+    return count;
+}
+
+const char *ir_protocol_name(ir_protocol_t protocol) {
+    for (size_t i = 0; i < sizeof(protocol_table) / sizeof(protocol_table[0]); i++) {
+        if (protocol_table[i].protocol == protocol) {
+            return protocol_table[i].name;
+        }
+    }
+    return "desconhecido";
+}
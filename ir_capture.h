@@ -0,0 +1,184 @@
+/**
+ * ir_capture.h - Pós-processamento dos sinais RAW capturados pelo receptor
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef IR_CAPTURE_H
+#define IR_CAPTURE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Estatísticas básicas de um sinal RAW
+typedef struct {
+    uint16_t min_us;     // Menor tempo
+    uint16_t max_us;     // Maior tempo
+    uint32_t sum_us;     // Soma de todos os tempos
+    uint16_t mean_us;    // Tempo médio
+} ir_capture_stats_t;
+
+// Protocolos reconhecidos pelo cabeçalho
+typedef enum {
+    IR_PROTOCOL_UNKNOWN,
+    IR_PROTOCOL_NEC,
+    IR_PROTOCOL_SAMSUNG,
+    IR_PROTOCOL_PHILCO_AC,
+    IR_PROTOCOL_COUNT
+} ir_protocol_t;
+
+#define IR_SANITIZE_MAX_LEVELS 6          // Níveis da grade por tipo (marca/espaço)
+#define IR_SANITIZE_TOLERANCE_PCT 10      // Desvio aceito em relação a um nível (espaço composto
+                                          // por marca perdida fica a ~14% de um bit longo)
+#define IR_SANITIZE_FRAME_GAP_US 5000     // Espaço que separa quadros repetidos
+
+#define IR_REPAIR_MAX_LOST 2              // Marcas perdidas seguidas num mesmo espaço
+#define IR_REPAIR_MAX_MIXED 6             // Grupos de bits 0 e 1 com ordem a decidir, por quadro
+#define IR_REPAIR_MAX_ORDERS 729          // Ordens conferidas por quadro (3 por grupo de 3 bits)
+
+// Nível da grade de tempos (média móvel dos tempos que caem nele)
+typedef struct {
+    uint16_t center_us;
+    uint16_t count;
+} ir_grid_level_t;
+
+/**
+ * Estado do saneamento de um sinal
+ *
+ * Processa um tempo por vez, com memória constante: pulsos abaixo de
+ * glitch_us que não se ajustam à grade do protocolo são somados aos
+ * vizinhos e cada tempo próximo de um nível da grade é ajustado a ele. Um
+ * tempo fora da grade cujo erro, passado ao tempo seguinte, coloca os dois na
+ * grade é tratado como borda deslocada. Os demais passam sem alteração.
+ */
+typedef struct {
+    // Configuração
+    uint16_t glitch_us;
+
+    // Estado
+    uint32_t pending_us;                  // Tempo aguardando o próximo para ser decidido
+    bool has_pending;
+    bool pending_is_mark;
+    uint16_t glitch_us_pending;           // Pulso curto aguardando o tempo seguinte
+    bool has_glitch;
+    bool header_seen;                     // Cabeçalho do quadro atual já tratado
+    uint8_t frame_format;                 // Entrada da tabela de protocolos do quadro atual
+    ir_grid_level_t marks[IR_SANITIZE_MAX_LEVELS];
+    ir_grid_level_t spaces[IR_SANITIZE_MAX_LEVELS];
+    uint8_t mark_levels;
+    uint8_t space_levels;
+    uint16_t frame_count;                 // Tempos emitidos no quadro atual
+
+    // Resultado
+    ir_protocol_t protocol;               // Protocolo do último quadro
+    uint16_t frames;
+    uint16_t glitches_merged;
+    uint16_t snapped;                     // Tempos ajustados à grade
+    uint16_t edge_shifts;                 // Ajustes fora da tolerância explicados por borda deslocada
+    uint16_t off_grid;                    // Tempos mantidos sem ajuste
+    bool count_mismatch;                  // Algum quadro com quantidade de tempos inesperada
+} ir_sanitizer_t;
+
+/**
+ * Prepara o saneamento de um novo sinal
+ *
+ * @param s Estado
+ * @param glitch_us Pulsos menores que isso são considerados glitch
+ */
+void ir_sanitizer_init(ir_sanitizer_t *s, uint16_t glitch_us);
+
+/**
+ * Entrega o próximo tempo capturado (começando por uma marca)
+ *
+ * @param out Recebe os tempos saneados anteriores, se houver (espaço para 2)
+ * @return Quantidade de tempos escritos em out (0 a 2)
+ */
+size_t ir_sanitizer_push(ir_sanitizer_t *s, uint16_t duration_us, uint16_t *out);
+
+/**
+ * Finaliza o sinal, liberando os tempos pendentes
+ *
+ * @return Quantidade de tempos escritos em out (0 a 2)
+ */
+size_t ir_sanitizer_finish(ir_sanitizer_t *s, uint16_t *out);
+
+/**
+ * Saneia um sinal completo
+ *
+ * @param raw Tempos capturados
+ * @param count Quantidade de tempos
+ * @param out Destino (pode ser o próprio raw; nunca recebe mais que count tempos)
+ * @param s Estado, com os contadores ao final
+ * @return Quantidade de tempos em out
+ */
+size_t ir_sanitize(const uint16_t *raw, size_t count, uint16_t *out, ir_sanitizer_t *s);
+
+/**
+ * Confere um quadro reparado (assinatura, checksum), do cabeçalho à marca final
+ */
+typedef bool (*ir_frame_check_t)(const uint16_t *frame, size_t count);
+
+// Resultado do reparo de um sinal
+typedef struct {
+    ir_protocol_t protocol;               // Protocolo do último quadro
+    uint16_t frames;
+    uint16_t edge_shifts;                 // Marcas curtas cujo início atrasou (o espaço anterior devolve o atraso)
+    uint16_t marks_rebuilt;               // Marcas perdidas recolocadas
+    uint16_t mixed;                       // Grupos reconstruídos com bits 0 e 1
+    uint16_t unordered;                   // Quadros com grupos mistos que a conferência não aceitou
+    bool count_mismatch;                  // Algum quadro continua com quantidade de tempos inesperada
+} ir_repair_t;
+
+/**
+ * Repara os quadros de protocolo conhecido que chegaram com tempos a menos
+ *
+ * Roda sobre o sinal completo, fora da interrupção: só a quantidade de tempos
+ * do quadro separa uma marca perdida (espaço + marca + espaço lidos como um
+ * espaço só) de um espaço longo com jitter. Num quadro curto, primeiro cada
+ * marca curta demais cuja borda de início atrasou recebe o atraso de volta
+ * do espaço anterior, quando isso aproxima o espaço da grade; depois os
+ * espaços que mais ganham ao virar vários bits recebem as marcas que faltam,
+ * até completar o quadro. A ordem dos bits 0 e 1 de um mesmo espaço não fica
+ * no sinal: as ordens possíveis passam por check e fica a primeira aceita.
+ *
+ * @param raw Tempos capturados (começando por uma marca), reparados no lugar
+ * @param count Quantidade de tempos
+ * @param max Capacidade de raw (cada marca recolocada acrescenta dois tempos)
+ * @param check Conferência do quadro do protocolo (NULL mantém a ordem)
+ * @param r Recebe os contadores
+ * @return Quantidade de tempos em raw
+ */
+size_t ir_capture_repair(uint16_t *raw, size_t count, size_t max, ir_frame_check_t check, ir_repair_t *r);
+
+/**
+ * Protocolo de um quadro pela marca e pelo espaço do cabeçalho
+ *
+ * @param repeat Recebe true se o quadro é um código de repetição (pode ser NULL)
+ */
+ir_protocol_t ir_capture_identify(const uint16_t *raw, size_t count, bool *repeat);
+
+/**
+ * Nome do protocolo
+ */
+const char *ir_protocol_name(ir_protocol_t protocol);
+
+/**
+ * Calcula mínimo, máximo, soma e média dos tempos de um sinal RAW
+ *
+ * @param raw Array com os tempos em microssegundos
+ * @param count Quantidade de elementos no array
+ * @param stats Estrutura que recebe as estatísticas (zerada se count == 0)
+ */
+void ir_capture_compute_stats(const uint16_t *raw, size_t count, ir_capture_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IR_CAPTURE_H
@@ -0,0 +1,285 @@
+/**
+ * ir_codedb.c - Consulta e montagem da imagem do banco de códigos
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <strings.h>
+
+#include "ir_codedb.h"
+#include "ir_capfile.h"
+
+static inline uint16_t get16(const uint8_t *p) {
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+static inline uint32_t get32(const uint8_t *p) {
+    return (uint32_t)get16(p) | (uint32_t)get16(p + 2) << 16;
+}
+
+static inline uint64_t get64(const uint8_t *p) {
+    return (uint64_t)get32(p) | (uint64_t)get32(p + 4) << 32;
+}
+
+static inline void put16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void put32(uint8_t *p, uint32_t v) {
+    put16(p, (uint16_t)v);
+    put16(p + 2, (uint16_t)(v >> 16));
+}
+
+static inline void put64(uint8_t *p, uint64_t v) {
+    put32(p, (uint32_t)v);
+    put32(p + 4, (uint32_t)(v >> 32));
+}
+
+ir_codedb_status_t ir_codedb_open(ir_codedb_t *db, const uint8_t *data, size_t size) {
+    if (size < IR_CODEDB_HEADER_SIZE) {
+        return IR_CODEDB_TRUNCATED;
+    }
+    if (get32(data) != IR_CODEDB_MAGIC) {
+        return IR_CODEDB_BAD_MAGIC;
+    }
+
+    uint16_t version = get16(data + 4);
+    uint16_t header_size = get16(data + 6);
+    uint16_t device_size = get16(data + 8);
+    uint16_t key_size = get16(data + 10);
+    uint16_t timing_size = get16(data + 12);
+    if (version != IR_CODEDB_VERSION || header_size < IR_CODEDB_HEADER_SIZE || device_size < IR_CODEDB_DEVICE_SIZE ||
+        key_size < IR_CODEDB_KEY_SIZE || timing_size < IR_CODEDB_TIMING_SIZE) {
+        return IR_CODEDB_BAD_VERSION;
+    }
+
+    // Tabelas dentro da imagem, e a imagem terminada em zero (nenhum nome
+    // passa do fim)
+    uint32_t device_count = get32(data + 16);
+    uint32_t key_count = get32(data + 20);
+    uint32_t timing_count = get32(data + 24);
+    uint64_t tables = header_size + (uint64_t)device_count * device_size + (uint64_t)key_count * key_size +
+                      (uint64_t)timing_count * timing_size;
+    if (get32(data + 28) != size || tables >= size || data[size - 1] != 0) {
+        return IR_CODEDB_TRUNCATED;
+    }
+
+    db->data = data;
+    db->size = size;
+    db->devices = data + header_size;
+    db->keys = db->devices + (size_t)device_count * device_size;
+    db->timings = db->keys + (size_t)key_count * key_size;
+    db->device_count = device_count;
+    db->key_count = key_count;
+    db->timing_count = timing_count;
+    db->device_size = device_size;
+    db->key_size = key_size;
+    db->timing_size = timing_size;
+    return IR_CODEDB_OK;
+}
+
+// Nome no offset dado ("" fora da imagem)
+static inline const char *name_at(const ir_codedb_t *db, uint32_t offset) {
+    return offset < db->size ? (const char *)db->data + offset : "";
+}
+
+int32_t ir_codedb_find_device(const ir_codedb_t *db, const char *name) {
+    uint32_t low = 0;
+    uint32_t high = db->device_count;
+    while (low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        int cmp = strcasecmp(name, name_at(db, get32(db->devices + (size_t)mid * db->device_size)));
+        if (cmp == 0) {
+            return (int32_t)mid;
+        }
+        if (cmp < 0) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+    return -1;
+}
+
+bool ir_codedb_device(const ir_codedb_t *db, uint32_t index, ir_codedb_device_t *out) {
+    if (index >= db->device_count) {
+        return false;
+    }
+    const uint8_t *e = db->devices + (size_t)index * db->device_size;
+    uint32_t first = get32(e + 4);
+    uint32_t count = get32(e + 8);
+    if (first > db->key_count || count > db->key_count - first) {
+        return false;
+    }
+    out->name = name_at(db, get32(e));
+    out->first_key = first;
+    out->key_count = count;
+    return true;
+}
+
+static bool read_key(const ir_codedb_t *db, const uint8_t *e, ir_codedb_code_t *out) {
+    out->name = name_at(db, get32(e));
+    out->protocol = (ir_codedb_protocol_t)e[4];
+    out->bits = e[5];
+    out->code = get64(e + 8);
+    out->raw = NULL;
+    out->raw_size = 0;
+    out->raw_count = 0;
+    out->carrier_hz = 0;
+
+    if (out->protocol == IR_CODEDB_RAW) {
+        uint32_t offset = (uint32_t)out->code;
+        uint32_t size = (uint32_t)(out->code >> 32);
+        if (offset > db->size || size > db->size - offset) {
+            return false;
+        }
+        out->raw = db->data + offset;
+        out->raw_size = size;
+        out->raw_count = get16(e + 16);
+        out->carrier_hz = get16(e + 18);
+    } else if (out->protocol == IR_CODEDB_PULSE_DISTANCE) {
+        uint16_t timing = get16(e + 6);
+        if (timing >= db->timing_count) {
+            return false;
+        }
+        const uint8_t *t = db->timings + (size_t)timing * db->timing_size;
+        out->timing.carrier_hz = get32(t);
+        out->timing.header_mark_us = get16(t + 4);
+        out->timing.header_space_us = get16(t + 6);
+        out->timing.bit_mark_us = get16(t + 8);
+        out->timing.zero_space_us = get16(t + 10);
+        out->timing.one_space_us = get16(t + 12);
+        out->timing.gap_us = get32(t + 16);
+    }
+    return out->protocol < IR_CODEDB_PROTOCOL_COUNT;
+}
+
+bool ir_codedb_find_key(const ir_codedb_t *db, int32_t device, const char *name, ir_codedb_code_t *out) {
+    ir_codedb_device_t d;
+    if (device < 0 || !ir_codedb_device(db, (uint32_t)device, &d)) {
+        return false;
+    }
+    uint32_t low = d.first_key;
+    uint32_t high = d.first_key + d.key_count;
+    while (low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        const uint8_t *e = db->keys + (size_t)mid * db->key_size;
+        int cmp = strcasecmp(name, name_at(db, get32(e)));
+        if (cmp == 0) {
+            return read_key(db, e, out);
+        }
+        if (cmp < 0) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+    return false;
+}
+
+bool ir_codedb_key(const ir_codedb_t *db, int32_t device, uint32_t index, ir_codedb_code_t *out) {
+    ir_codedb_device_t d;
+    if (device < 0 || !ir_codedb_device(db, (uint32_t)device, &d) || index >= d.key_count) {
+        return false;
+    }
+    return read_key(db, db->keys + (size_t)(d.first_key + index) * db->key_size, out);
+}
+
+bool ir_codedb_lookup(const ir_codedb_t *db, const char *device, const char *key, ir_codedb_code_t *out) {
+    return ir_codedb_find_key(db, ir_codedb_find_device(db, device), key, out);
+}
+
+size_t ir_codedb_raw_decode(const ir_codedb_code_t *code, uint16_t *out, size_t max) {
+    if (code->protocol != IR_CODEDB_RAW || code->raw_size == 0) {
+        return 0;
+    }
+
+    size_t levels = code->raw[0];
+    if (levels == 0) {
+        ir_capfile_frame_t frame = {.data = code->raw + 1, .size = code->raw_size - 1, .count = code->raw_count};
+        return ir_capfile_decode(&frame, out, max);
+    }
+
+    // Níveis e um nibble por tempo
+    const uint8_t *nibbles = code->raw + 1 + 2 * levels;
+    size_t count = code->raw_count < max ? code->raw_count : max;
+    if (levels > IR_CODEDB_RAW_LEVELS || 1 + 2 * levels + (count + 1) / 2 > code->raw_size) {
+        return 0;
+    }
+    for (size_t i = 0; i < count; i++) {
+        uint8_t level = (uint8_t)(nibbles[i / 2] >> (i % 2 * 4) & 0x0F);
+        out[i] = level < levels ? get16(code->raw + 1 + 2 * level) : 0;
+    }
+    return count;
+}
+
+void ir_codedb_put_header(uint8_t *out, uint32_t device_count, uint32_t key_count, uint32_t timing_count,
+                          uint32_t size) {
+    put32(out, IR_CODEDB_MAGIC);
+    put16(out + 4, IR_CODEDB_VERSION);
+    put16(out + 6, IR_CODEDB_HEADER_SIZE);
+    put16(out + 8, IR_CODEDB_DEVICE_SIZE);
+    put16(out + 10, IR_CODEDB_KEY_SIZE);
+    put16(out + 12, IR_CODEDB_TIMING_SIZE);
+    put16(out + 14, 0);
+    put32(out + 16, device_count);
+    put32(out + 20, key_count);
+    put32(out + 24, timing_count);
+    put32(out + 28, size);
+}
+
+void ir_codedb_put_device(uint8_t *out, uint32_t name_offset, uint32_t first_key, uint32_t key_count) {
+    put32(out, name_offset);
+    put32(out + 4, first_key);
+    put32(out + 8, key_count);
+    put32(out + 12, 0);
+}
+
+void ir_codedb_put_key(uint8_t *out, uint32_t name_offset, const ir_codedb_code_t *code, uint16_t timing) {
+    put32(out, name_offset);
+    out[4] = (uint8_t)code->protocol;
+    out[5] = code->bits;
+    put16(out + 6, timing);
+    put64(out + 8, code->code);
+    put16(out + 16, code->raw_count);
+    put16(out + 18, code->carrier_hz);
+    put32(out + 20, 0);
+}
+
+void ir_codedb_put_timing(uint8_t *out, const ir_codedb_timing_t *timing) {
+    put32(out, timing->carrier_hz);
+    put16(out + 4, timing->header_mark_us);
+    put16(out + 6, timing->header_space_us);
+    put16(out + 8, timing->bit_mark_us);
+    put16(out + 10, timing->zero_space_us);
+    put16(out + 12, timing->one_space_us);
+    put16(out + 14, 0);
+    put32(out + 16, timing->gap_us);
+}
+
+const char *ir_codedb_status_name(ir_codedb_status_t status) {
+    switch (status) {
+        case IR_CODEDB_OK:
+            return "ok";
+        case IR_CODEDB_BAD_MAGIC:
+            return "não é um banco de códigos";
+        case IR_CODEDB_BAD_VERSION:
+            return "versão não suportada";
+        default:
+            return "imagem truncada";
+    }
+}
+
+const char *ir_codedb_protocol_name(ir_codedb_protocol_t protocol) {
+    static const char *const names[IR_CODEDB_PROTOCOL_COUNT] = {
+        [IR_CODEDB_NEC] = "NEC",
+        [IR_CODEDB_RC5] = "RC5",
+        [IR_CODEDB_RC6] = "RC6",
+        [IR_CODEDB_SIRC] = "SIRC",
+        [IR_CODEDB_PULSE_DISTANCE] = "distância de pulso",
+        [IR_CODEDB_RAW] = "RAW",
+    };
+    return protocol < IR_CODEDB_PROTOCOL_COUNT ? names[protocol] : "desconhecido";
+}
@@ -0,0 +1,229 @@
+/**
+ * ir_codedb.h - Banco de códigos de controles remotos para a flash
+ *
+ * Imagem montada no host (host/codedb, a partir de arquivos .conf do LIRC e
+ * de códigos Pronto) e consultada no firmware direto da flash, sem parsing
+ * nem cópia: dispositivos ordenados por nome, as teclas de cada dispositivo
+ * ordenadas por nome, as duas buscas binárias (sem diferenciar maiúsculas de
+ * minúsculas, como ir_find_command()). Tudo em little-endian:
+ *
+ *   cabeçalho    IR_CODEDB_HEADER_SIZE bytes
+ *   dispositivos uma entrada por dispositivo, em ordem de nome
+ *   teclas       as teclas de cada dispositivo, em ordem de nome
+ *   tempos       configurações de distância de pulso, compartilhadas
+ *   dados        sinais RAW e nomes (terminados em zero); a imagem termina
+ *                em zero
+ *
+ * Cabeçalho:
+ *
+ *    0  "IRDB"
+ *    4  uint16  versão (IR_CODEDB_VERSION)
+ *    6  uint16  tamanho do cabeçalho
+ *    8  uint16  tamanho da entrada de dispositivo
+ *   10  uint16  tamanho da entrada de tecla
+ *   12  uint16  tamanho da entrada de tempos
+ *   14  uint16  reservado (0)
+ *   16  uint32  quantidade de dispositivos
+ *   20  uint32  quantidade de teclas
+ *   24  uint32  quantidade de entradas de tempos
+ *   28  uint32  tamanho da imagem
+ *
+ * Dispositivo:
+ *
+ *    0  uint32  offset do nome
+ *    4  uint32  primeira tecla
+ *    8  uint32  quantidade de teclas
+ *   12  uint32  reservado (0)
+ *
+ * Tecla:
+ *
+ *    0  uint32  offset do nome
+ *    4  uint8   protocolo (ir_codedb_protocol_t)
+ *    5  uint8   bits do código
+ *    6  uint16  entrada de tempos (distância de pulso) ou IR_CODEDB_NO_TIMING
+ *    8  uint64  código, bits na ordem de transmissão a partir do bit 0
+ *               (RAW: offset dos dados nos 32 bits baixos, bytes nos altos)
+ *   16  uint16  quantidade de tempos (RAW)
+ *   18  uint16  carrier em Hz (RAW; 0 = desconhecido)
+ *   20  uint32  reservado (0)
+ *
+ * Tempos: uint32 carrier em Hz, uint16 marca e espaço do cabeçalho, marca
+ * dos bits, espaço do 0 e espaço do 1, uint16 reservado e uint32 silêncio
+ * mínimo depois do quadro (os campos de pd_tx_config_t).
+ *
+ * Sinal RAW: um byte com a quantidade de níveis. De 1 a 16, seguem os
+ * níveis (uint16) e um nibble por tempo com o nível dele, o primeiro no
+ * nibble baixo; com 0, seguem os tempos em varint (ir_capfile_encode()).
+ *
+ * Códigos por protocolo:
+ *
+ *  - NEC: o quadro de 32 bits como nec_encode_frame() monta;
+ *  - RC5, RC6 (modo 0): endereço nos bits 8-15, comando nos bits 0-7;
+ *  - SIRC: comando nos bits 0-6, endereço a partir do bit 7 (12, 15 ou 20
+ *    bits);
+ *  - distância de pulso: bytes para pd_tx_send(), com os tempos da entrada.
+ *
+ * Mesma política de versão do ir_capfile.h: campos novos só no fim das
+ * entradas, aumentando o tamanho gravado.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef IR_CODEDB_H
+#define IR_CODEDB_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define IR_CODEDB_MAGIC 0x42445249u           // "IRDB"
+#define IR_CODEDB_VERSION 1
+#define IR_CODEDB_HEADER_SIZE 32
+#define IR_CODEDB_DEVICE_SIZE 16
+#define IR_CODEDB_KEY_SIZE 24
+#define IR_CODEDB_TIMING_SIZE 20
+#define IR_CODEDB_NO_TIMING 0xFFFF
+#define IR_CODEDB_RAW_LEVELS 16               // Níveis do sinal RAW com um nibble por tempo
+
+typedef enum {
+    IR_CODEDB_OK,
+    IR_CODEDB_BAD_MAGIC,
+    IR_CODEDB_BAD_VERSION,
+    IR_CODEDB_TRUNCATED
+} ir_codedb_status_t;
+
+typedef enum {
+    IR_CODEDB_NEC,
+    IR_CODEDB_RC5,
+    IR_CODEDB_RC6,
+    IR_CODEDB_SIRC,
+    IR_CODEDB_PULSE_DISTANCE,
+    IR_CODEDB_RAW,
+    IR_CODEDB_PROTOCOL_COUNT
+} ir_codedb_protocol_t;
+
+// Imagem aberta sobre a memória
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+    const uint8_t *devices;
+    const uint8_t *keys;
+    const uint8_t *timings;
+    uint32_t device_count;
+    uint32_t key_count;
+    uint32_t timing_count;
+    uint16_t device_size;
+    uint16_t key_size;
+    uint16_t timing_size;
+} ir_codedb_t;
+
+typedef struct {
+    const char *name;
+    uint32_t first_key;
+    uint32_t key_count;
+} ir_codedb_device_t;
+
+// Mesmos campos de pd_tx_config_t
+typedef struct {
+    uint32_t carrier_hz;
+    uint16_t header_mark_us;
+    uint16_t header_space_us;
+    uint16_t bit_mark_us;
+    uint16_t zero_space_us;
+    uint16_t one_space_us;
+    uint32_t gap_us;
+} ir_codedb_timing_t;
+
+// Tecla (nome e dados RAW apontam para dentro da imagem)
+typedef struct {
+    const char *name;
+    ir_codedb_protocol_t protocol;
+    uint8_t bits;
+    uint64_t code;
+    ir_codedb_timing_t timing;          // Só distância de pulso
+    const uint8_t *raw;                 // Só RAW
+    uint32_t raw_size;
+    uint16_t raw_count;
+    uint16_t carrier_hz;
+} ir_codedb_code_t;
+
+/**
+ * Confere o cabeçalho e os limites das tabelas
+ */
+ir_codedb_status_t ir_codedb_open(ir_codedb_t *db, const uint8_t *data, size_t size);
+
+/**
+ * Dispositivo pelo nome (busca binária)
+ *
+ * @return Índice do dispositivo, ou -1
+ */
+int32_t ir_codedb_find_device(const ir_codedb_t *db, const char *name);
+
+/**
+ * Dispositivo pela posição (0 a device_count - 1, em ordem de nome)
+ */
+bool ir_codedb_device(const ir_codedb_t *db, uint32_t index, ir_codedb_device_t *out);
+
+/**
+ * Tecla de um dispositivo pelo nome (busca binária)
+ *
+ * @return false se o dispositivo ou a tecla não existem, ou se a entrada
+ *         aponta para fora da imagem
+ */
+bool ir_codedb_find_key(const ir_codedb_t *db, int32_t device, const char *name, ir_codedb_code_t *out);
+
+/**
+ * Tecla de um dispositivo pela posição (em ordem de nome)
+ */
+bool ir_codedb_key(const ir_codedb_t *db, int32_t device, uint32_t index, ir_codedb_code_t *out);
+
+/**
+ * Dispositivo e tecla pelos nomes
+ */
+bool ir_codedb_lookup(const ir_codedb_t *db, const char *device, const char *key, ir_codedb_code_t *out);
+
+/**
+ * Expande os tempos de uma tecla RAW
+ *
+ * @return Quantidade de tempos escritos (no máximo max; 0 se não é RAW)
+ */
+size_t ir_codedb_raw_decode(const ir_codedb_code_t *code, uint16_t *out, size_t max);
+
+/**
+ * Monta o cabeçalho (IR_CODEDB_HEADER_SIZE bytes)
+ */
+void ir_codedb_put_header(uint8_t *out, uint32_t device_count, uint32_t key_count, uint32_t timing_count,
+                          uint32_t size);
+
+/**
+ * Monta uma entrada de dispositivo (IR_CODEDB_DEVICE_SIZE bytes)
+ */
+void ir_codedb_put_device(uint8_t *out, uint32_t name_offset, uint32_t first_key, uint32_t key_count);
+
+/**
+ * Monta uma entrada de tecla (IR_CODEDB_KEY_SIZE bytes)
+ *
+ * @param code Protocolo, bits, código e, se RAW, raw_count e carrier_hz (os
+ *             ponteiros são ignorados)
+ * @param timing Entrada de tempos ou IR_CODEDB_NO_TIMING
+ */
+void ir_codedb_put_key(uint8_t *out, uint32_t name_offset, const ir_codedb_code_t *code, uint16_t timing);
+
+/**
+ * Monta uma entrada de tempos (IR_CODEDB_TIMING_SIZE bytes)
+ */
+void ir_codedb_put_timing(uint8_t *out, const ir_codedb_timing_t *timing);
+
+const char *ir_codedb_status_name(ir_codedb_status_t status);
+const char *ir_codedb_protocol_name(ir_codedb_protocol_t protocol);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IR_CODEDB_H
@@ -0,0 +1,52 @@
+/**
+ * ir_commands.c - Tabela de comandos NEC do controle remoto
+ */
+
+#include <string.h>
+#include <strings.h>
+
+#include "ir_commands.h"
+
+// Tabela de comandos
+const ir_command_t ir_command_table[] = {
+    {"KEY_8",           "NEC80-14",  0x80, 0x14},
+    {"KEY_9",           "NEC80-15",  0x80, 0x15},
+    {"PRENSAR",         "NEC80-16",  0x80, 0x16},
+    {"KEY_INFO",        "NEC80-17",  0x80, 0x17},
+    {"SEIVA",           "NEC80-18",  0x80, 0x18},
+    {"TVAV",            "NEC80-19",  0x80, 0x19},
+    {"ULTIMA",          "NEC80-110", 0x80, 0x110},
+    {"KEY_MUTE",        "NEC80-111", 0x80, 0x111},
+    {"KEY_0",           "NEC80-112", 0x80, 0x112},
+    {"KEY_1",           "NEC80-113", 0x80, 0x113},
+    {"KEY_2",           "NEC80-114", 0x80, 0x114},
+    {"KEY_3",           "NEC80-115", 0x80, 0x115},
+    {"EXPOSICAO",       "NEC80-116", 0x80, 0x116},
+    {"TEMPORIZADOR",    "NEC80-117", 0x80, 0x117},
+    {"KEY_VOLUMEUP",    "NEC80-118", 0x80, 0x118},
+    {"PREF",            "NEC80-119", 0x80, 0x119},
+    {"KEY_VOLUMEDOWN",  "NEC80-121", 0x80, 0x121},
+    {"KEY_POWER",       "NEC80-123", 0x80, 0x123},
+    {"KEY_CHANNELDOWN", "NEC80-124", 0x80, 0x124},
+    {"KEY_CHANNELUP",   "NEC80-125", 0x80, 0x125},
+    {"KEY_4",           "NEC80-128", 0x80, 0x128},
+    {"KEY_5",           "NEC80-129", 0x80, 0x129},
+    {"KEY_6",           "NEC80-130", 0x80, 0x130},
+    {"KEY_7",           "NEC80-131", 0x80, 0x131},
+    {"MAGIA",           "NEC80-191", 0x80, 0x191},
+    {"KEY_MENU",        "NEC80-194", 0x80, 0x194},
+};
+
+const size_t ir_command_count = sizeof(ir_command_table) / sizeof(ir_command_t);
+
+/**
+ * Busca comando por nome
+ */
+const ir_command_t* ir_find_command(const char *name) {
+    for (size_t i = 0; i < ir_command_count; i++) {
+        if (strcasecmp(ir_command_table[i].name, name) == 0) {
+            return &ir_command_table[i];
+        }
+    }
+    return NULL;
+}
@@ -0,0 +1,45 @@
+/**
+ * ir_commands.h - Tabela de comandos NEC do controle remoto (dispositivo 0x80)
+ *
+ * Compartilhada por Envio_philco.c e Philco.c.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef IR_COMMANDS_H
+#define IR_COMMANDS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Estrutura para mapear comandos
+typedef struct {
+    const char *name;
+    const char *protocol_code;
+    uint8_t device;
+    uint16_t function;
+} ir_command_t;
+
+// Tabela de comandos e quantidade de entradas
+extern const ir_command_t ir_command_table[];
+extern const size_t ir_command_count;
+
+/**
+ * Busca comando por nome (sem diferenciar maiúsculas/minúsculas)
+ *
+ * @param name Nome do comando (ex: "KEY_POWER")
+ * @return Ponteiro para o comando, ou NULL se não encontrado
+ */
+const ir_command_t* ir_find_command(const char *name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IR_COMMANDS_H
@@ -0,0 +1,81 @@
+/**
+ * ir_echo.c - Janelas de transmissão e classificação dos quadros recebidos
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <string.h>
+
+#include "ir_echo.h"
+
+static ir_echo_window_t *window_at(ir_echo_t *e, uint8_t i) {
+    return &e->windows[(e->head + i) % IR_ECHO_WINDOWS];
+}
+
+// Remove as janelas que terminaram (com a folga) antes de before_us
+static void expire(ir_echo_t *e, uint64_t before_us) {
+    while (e->count > 0 && window_at(e, 0)->end_us + e->guard_us < before_us) {
+        e->head = (e->head + 1) % IR_ECHO_WINDOWS;
+        e->count--;
+    }
+}
+
+void ir_echo_init(ir_echo_t *e, uint32_t guard_us) {
+    memset(e, 0, sizeof(*e));
+    e->guard_us = guard_us ? guard_us : IR_ECHO_GUARD_US;
+}
+
+void ir_echo_publish(ir_echo_t *e, uint64_t now_us, uint32_t duration_us, uint32_t frame) {
+    expire(e, now_us);
+    if (e->count == IR_ECHO_WINDOWS) {
+        e->head = (e->head + 1) % IR_ECHO_WINDOWS;
+        e->count--;
+        e->overwritten++;
+    }
+
+    uint64_t start = now_us > e->tx_free_us ? now_us : e->tx_free_us;
+    ir_echo_window_t *w = window_at(e, e->count);
+    w->start_us = start;
+    w->end_us = start + duration_us;
+    w->frame = frame;
+    w->matched = false;
+    e->count++;
+    e->tx_free_us = w->end_us;
+    e->published++;
+}
+
+ir_echo_result_t ir_echo_classify(ir_echo_t *e, uint64_t start_us, uint64_t end_us, uint32_t frame) {
+    expire(e, start_us);
+
+    bool overlap = false;
+    for (uint8_t i = 0; i < e->count; i++) {
+        ir_echo_window_t *w = window_at(e, i);
+        if (start_us > w->end_us + e->guard_us || end_us < w->start_us) {
+            continue;
+        }
+        if (!w->matched && w->frame == frame) {
+            w->matched = true;
+            e->echoes++;
+            return IR_ECHO_SELF;
+        }
+        overlap = true;
+    }
+
+    if (overlap) {
+        e->overlaps++;
+        return IR_ECHO_OVERLAP;
+    }
+    e->external++;
+    return IR_ECHO_EXTERNAL;
+}
+
+bool ir_echo_tx_active(const ir_echo_t *e, uint64_t now_us) {
+    for (uint8_t i = 0; i < e->count; i++) {
+        const ir_echo_window_t *w = &e->windows[(e->head + i) % IR_ECHO_WINDOWS];
+        if (now_us >= w->start_us && now_us <= w->end_us + e->guard_us) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,100 @@
+/**
+ * ir_echo.h - Supressão do eco das próprias transmissões
+ *
+ * Com TX e RX no mesmo PIO (Philco.c), o receptor vê cada quadro que o
+ * próprio LED emite. O lado do envio publica aqui a janela de cada
+ * transmissão (início, fim e o quadro enviado); o lado da recepção classifica
+ * cada quadro recebido pelo intervalo que ele ocupou no ar:
+ *
+ * - fora de qualquer janela: quadro externo (controle real);
+ * - dentro de uma janela e igual ao quadro enviado: eco, descartado; a janela
+ *   é consumida, então um mesmo envio nunca é reconhecido duas vezes e um
+ *   quadro externo igual, depois dela, volta a ser aceito;
+ * - dentro de uma janela e diferente: marcado como sobreposto (colisão com
+ *   outro controle ou eco corrompido), entregue para quem decidir.
+ *
+ * Os tempos chegam por parâmetro (us desde o boot), então o mesmo código roda
+ * no firmware e na simulação do host.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef IR_ECHO_H
+#define IR_ECHO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define IR_ECHO_WINDOWS 8           // Envios em andamento ou na fila do PIO
+#define IR_ECHO_GUARD_US 20000      // Folga após a janela (atraso do receptor e da leitura do FIFO)
+
+// Quadro NEC: 9 ms + 4,5 ms de início, 16 bits "1" (2,25 ms) e 16 bits "0"
+// (1,125 ms), pois endereço e dado vão também invertidos, e o pulso final
+#define IR_ECHO_NEC_FRAME_US 68063
+
+typedef enum {
+    IR_ECHO_EXTERNAL,               // Nenhum envio no ar
+    IR_ECHO_SELF,                   // Eco de um envio próprio: descartar
+    IR_ECHO_OVERLAP                 // Recebido durante um envio, mas diferente dele
+} ir_echo_result_t;
+
+typedef struct {
+    uint64_t start_us;
+    uint64_t end_us;
+    uint32_t frame;
+    bool matched;
+} ir_echo_window_t;
+
+typedef struct {
+    ir_echo_window_t windows[IR_ECHO_WINDOWS];
+    uint8_t head;                   // Janela mais antiga
+    uint8_t count;
+    uint32_t guard_us;
+    uint64_t tx_free_us;            // Fim da última janela: envios na fila começam depois dela
+
+    // Contadores
+    uint32_t published;
+    uint32_t overwritten;           // Janela descartada com o histórico cheio
+    uint32_t echoes;
+    uint32_t overlaps;
+    uint32_t external;
+} ir_echo_t;
+
+/**
+ * Prepara o supressor
+ *
+ * @param guard_us Folga após cada janela (0 = IR_ECHO_GUARD_US)
+ */
+void ir_echo_init(ir_echo_t *e, uint32_t guard_us);
+
+/**
+ * Publica uma transmissão entregue ao transmissor em now_us
+ *
+ * Se o transmissor ainda está ocupado com envios anteriores, a janela começa
+ * quando eles terminam (fila do PIO).
+ *
+ * @param duration_us Duração do quadro no ar
+ * @param frame Quadro enviado, comparado com o que for recebido
+ */
+void ir_echo_publish(ir_echo_t *e, uint64_t now_us, uint32_t duration_us, uint32_t frame);
+
+/**
+ * Classifica um quadro recebido que ocupou o ar de start_us a end_us
+ */
+ir_echo_result_t ir_echo_classify(ir_echo_t *e, uint64_t start_us, uint64_t end_us, uint32_t frame);
+
+/**
+ * true se há uma transmissão (com a folga) em andamento em now_us
+ */
+bool ir_echo_tx_active(const ir_echo_t *e, uint64_t now_us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IR_ECHO_H
@@ -0,0 +1,301 @@
+/**
+ * ir_fusion.c - Montagem dos quadros por sensor e fusão em eventos
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "hardware/gpio.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+#include "ir_fusion.h"
+
+// Instância ligada às interrupções de GPIO
+static ir_fusion_t *attached;
+
+// ---------------------------------------------------------------------------
+// Montagem (interrupção)
+// ---------------------------------------------------------------------------
+
+static void store(ir_fusion_sensor_t *s, ir_fusion_frame_t *fr, const uint16_t *values, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        if (fr->count < IR_FUSION_MAX_TIMINGS) {
+            fr->raw[fr->count++] = values[i];
+        } else if (!s->overflow) {
+            s->overflow = true;
+            s->health.truncated++;
+        }
+    }
+}
+
+/**
+ * Penalidade de uma cópia pelos ajustes que o saneamento precisou fazer
+ */
+static uint16_t frame_quality(const ir_sanitizer_t *z) {
+    uint32_t q = z->glitches_merged * 4u + z->edge_shifts * 2u + z->off_grid;
+    if (z->count_mismatch) {
+        q += 256;                       // Tempo perdido ou a mais
+    }
+    if (z->protocol == IR_PROTOCOL_UNKNOWN) {
+        q += 64;                        // Cabeçalho perdido
+    }
+    return q > UINT16_MAX ? UINT16_MAX : (uint16_t)q;
+}
+
+static void close_frame(ir_fusion_sensor_t *s) {
+    s->capturing = false;
+    if (s->discarding) {
+        return;
+    }
+
+    ir_fusion_frame_t *fr = &s->frames[s->assembling];
+    uint16_t last[2];
+    store(s, fr, last, ir_sanitizer_finish(&s->sanitizer, last));
+
+    if (fr->count < IR_FUSION_MIN_TIMINGS) {
+        s->health.noise++;
+        fr->count = 0;
+        return;
+    }
+
+    fr->protocol = s->sanitizer.protocol;
+    fr->quality = frame_quality(&s->sanitizer);
+    fr->ready = true;
+    s->assembling ^= 1;
+
+    s->health.frames++;
+    s->health.glitches += s->sanitizer.glitches_merged;
+    s->health.edge_shifts += s->sanitizer.edge_shifts;
+    s->health.mismatches += s->sanitizer.count_mismatch;
+    s->health.last_frame_us = fr->start_us;
+}
+
+void ir_fusion_edge(ir_fusion_t *f, uint8_t sensor, bool level, uint64_t now_us) {
+    ir_fusion_sensor_t *s = &f->sensors[sensor];
+
+    if (s->capturing) {
+        uint64_t duration = now_us - s->last_edge_us;
+        if (level || duration <= IR_FUSION_GAP_US) {
+            s->last_edge_us = now_us;
+            if (!s->discarding) {
+                // Estimativa com o tempo do sensor, saneamento com o corrigido
+                uint16_t clean[2];
+                uint16_t d = duration > UINT16_MAX ? UINT16_MAX : (uint16_t)duration;
+                ir_calib_push(&s->estimator, d, level);
+                d = ir_calib_correct_us(&s->calib, d, level);
+                store(s, &s->frames[s->assembling], clean, ir_sanitizer_push(&s->sanitizer, d, clean));
+            }
+            return;
+        }
+        // Novo quadro depois de um silêncio que o poll ainda não viu
+        close_frame(s);
+    }
+
+    // Quadros começam com uma marca (nível baixo)
+    if (level) {
+        return;
+    }
+    ir_fusion_frame_t *fr = &s->frames[s->assembling];
+    s->capturing = true;
+    s->last_edge_us = now_us;
+    s->overflow = false;
+    if (fr->ready || fr->grouped) {
+        s->discarding = true;
+        s->health.busy_drops++;
+        return;
+    }
+    s->discarding = false;
+    fr->count = 0;
+    fr->start_us = now_us;
+    ir_sanitizer_init(&s->sanitizer, IR_FUSION_GLITCH_US);
+    ir_calib_begin(&s->estimator);
+}
+
+// ---------------------------------------------------------------------------
+// Fusão (laço principal)
+// ---------------------------------------------------------------------------
+
+static ir_fusion_frame_t *grouped_frame(ir_fusion_sensor_t *s) {
+    for (int b = 0; b < 2; b++) {
+        if (s->frames[b].grouped) {
+            return &s->frames[b];
+        }
+    }
+    return NULL;
+}
+
+static void emit_group(ir_fusion_t *f) {
+    ir_fusion_frame_t *best = grouped_frame(&f->sensors[f->group_best]);
+
+    if (f->event_count == IR_FUSION_EVENTS) {
+        f->event_drops++;
+    } else {
+        ir_fusion_event_t *ev = &f->events[(f->event_head + f->event_count) % IR_FUSION_EVENTS];
+        ev->start_us = f->group_start_us;
+        memcpy(ev->raw, best->raw, best->count * sizeof(uint16_t));
+        ev->count = best->count;
+        ev->protocol = best->protocol;
+        ev->quality = best->quality;
+        ev->sensors = f->group_mask;
+        ev->best = (uint8_t)f->group_best;
+        f->event_count++;
+    }
+
+    for (uint8_t i = 0; i < f->sensor_count; i++) {
+        ir_fusion_sensor_t *s = &f->sensors[i];
+        if (f->group_mask & (1u << i)) {
+            ir_fusion_frame_t *fr = grouped_frame(s);
+            fr->grouped = false;
+            fr->ready = false;
+            s->health.events_seen++;
+        } else {
+            s->health.events_missed++;
+        }
+    }
+    f->sensors[f->group_best].health.best++;
+    f->group_open = false;
+    f->emitted++;
+}
+
+static void add_to_group(ir_fusion_t *f, uint8_t sensor, ir_fusion_frame_t *fr, uint64_t now_us) {
+    uint64_t start = fr->start_us;
+    bool same = f->group_open && !(f->group_mask & (1u << sensor)) &&
+                (start > f->group_start_us ? start - f->group_start_us : f->group_start_us - start) <=
+                    IR_FUSION_WINDOW_US;
+
+    if (!same) {
+        if (f->group_open) {
+            emit_group(f);
+        }
+        f->group_open = true;
+        f->group_start_us = start;
+        f->group_deadline_us = now_us + IR_FUSION_WINDOW_US;
+        f->group_mask = 0;
+        f->group_best = -1;
+    } else {
+        f->merged_frames++;
+    }
+
+    fr->grouped = true;
+    f->group_mask |= 1u << sensor;
+    if (start < f->group_start_us) {
+        f->group_start_us = start;
+    }
+
+    ir_fusion_frame_t *best = f->group_best >= 0 ? grouped_frame(&f->sensors[f->group_best]) : NULL;
+    if (!best || fr->quality < best->quality || (fr->quality == best->quality && start < best->start_us)) {
+        f->group_best = (int8_t)sensor;
+    }
+}
+
+bool ir_fusion_poll(ir_fusion_t *f, uint64_t now_us) {
+    // Fecha os quadros em silêncio (a interrupção pode estar mexendo no mesmo sensor)
+    for (uint8_t i = 0; i < f->sensor_count; i++) {
+        ir_fusion_sensor_t *s = &f->sensors[i];
+        uint32_t status = save_and_disable_interrupts();
+        if (s->capturing && now_us > s->last_edge_us && now_us - s->last_edge_us > IR_FUSION_GAP_US) {
+            close_frame(s);
+        }
+        restore_interrupts(status);
+    }
+
+    // Quadros fechados entram nos eventos em ordem de início
+    while (true) {
+        ir_fusion_frame_t *next = NULL;
+        uint8_t next_sensor = 0;
+        for (uint8_t i = 0; i < f->sensor_count; i++) {
+            for (int b = 0; b < 2; b++) {
+                ir_fusion_frame_t *fr = &f->sensors[i].frames[b];
+                if (fr->ready && !fr->grouped && (!next || fr->start_us < next->start_us)) {
+                    next = fr;
+                    next_sensor = i;
+                }
+            }
+        }
+        if (!next) {
+            break;
+        }
+        add_to_group(f, next_sensor, next, now_us);
+    }
+
+    if (f->group_open && now_us >= f->group_deadline_us) {
+        emit_group(f);
+    }
+    return f->event_count > 0;
+}
+
+const ir_fusion_event_t *ir_fusion_peek(const ir_fusion_t *f) {
+    return f->event_count ? &f->events[f->event_head] : NULL;
+}
+
+void ir_fusion_release(ir_fusion_t *f) {
+    if (f->event_count) {
+        f->event_head = (f->event_head + 1) % IR_FUSION_EVENTS;
+        f->event_count--;
+    }
+}
+
+uint8_t ir_fusion_health_pct(const ir_fusion_t *f, uint8_t sensor) {
+    const ir_fusion_health_t *h = &f->sensors[sensor].health;
+    uint32_t total = h->events_seen + h->events_missed;
+    return total ? (uint8_t)(h->events_seen * 100u / total) : 100;
+}
+
+uint8_t ir_fusion_calibrate(ir_fusion_t *f) {
+    uint8_t mask = 0;
+    // As somas e a correção mudam na interrupção de bordas
+    uint32_t status = save_and_disable_interrupts();
+    for (uint8_t i = 0; i < f->sensor_count; i++) {
+        ir_calib_t estimate;
+        if (ir_calib_estimate(&f->sensors[i].estimator, &estimate)) {
+            f->sensors[i].calib = estimate;
+            mask |= 1u << i;
+        }
+    }
+    restore_interrupts(status);
+    return mask;
+}
+
+void ir_fusion_set_calib(ir_fusion_t *f, uint8_t sensor, const ir_calib_t *calib) {
+    if (sensor < f->sensor_count) {
+        f->sensors[sensor].calib = *calib;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Inicialização
+// ---------------------------------------------------------------------------
+
+void ir_fusion_init(ir_fusion_t *f, const uint8_t *gpios, uint8_t count) {
+    memset(f, 0, sizeof(*f));
+    f->sensor_count = count > IR_FUSION_MAX_SENSORS ? IR_FUSION_MAX_SENSORS : count;
+    for (uint8_t i = 0; i < f->sensor_count; i++) {
+        f->sensors[i].gpio = gpios[i];
+    }
+}
+
+static void fusion_gpio_callback(uint gpio, uint32_t events) {
+    ir_fusion_t *f = attached;
+    uint64_t now = time_us_64();
+    for (uint8_t i = 0; f && i < f->sensor_count; i++) {
+        if (f->sensors[i].gpio == gpio) {
+            ir_fusion_edge(f, i, gpio_get(gpio), now);
+            return;
+        }
+    }
+}
+
+void ir_fusion_attach_gpio(ir_fusion_t *f) {
+    attached = f;
+    for (uint8_t i = 0; i < f->sensor_count; i++) {
+        uint pin = f->sensors[i].gpio;
+        gpio_init(pin);
+        gpio_set_dir(pin, GPIO_IN);
+        gpio_disable_pulls(pin);    // Sensores TSOP têm pull-up interno
+        gpio_set_irq_enabled_with_callback(pin, GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL, true,
+                                           &fusion_gpio_callback);
+    }
+}
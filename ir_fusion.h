@@ -0,0 +1,180 @@
+/**
+ * ir_fusion.h - Recepção com vários sensores IR ao mesmo tempo
+ *
+ * Cada sensor (um pino com receptor TSOP, saída ativa em nível baixo) monta
+ * seus quadros pelas bordas, como o receptor.c, passando os tempos pelo
+ * saneamento de ir_capture.c. Quadros de sensores diferentes que começam
+ * dentro de IR_FUSION_WINDOW_US são o mesmo comando visto de lugares
+ * diferentes: viram um único evento, com a cópia de melhor qualidade
+ * (menos glitches, bordas deslocadas e quantidade de tempos esperada) e a
+ * máscara dos sensores que o viram.
+ *
+ * Cada sensor acumula estatísticas de saúde: quadros, eventos vistos e
+ * perdidos, vezes em que deu a melhor cópia e defeitos encontrados. Um sensor
+ * que passa a perder eventos que os outros veem está obstruído ou com defeito.
+ *
+ * Cada sensor também estima o próprio desvio marca/espaço (ir_calib.h) com
+ * os tempos dos quadros de protocolo conhecido, antes do saneamento.
+ * ir_fusion_calibrate() transforma as estimativas em correções, aplicadas
+ * a cada tempo do sensor antes do saneamento.
+ *
+ * ir_fusion_edge() roda na interrupção de GPIO; ir_fusion_poll() no laço
+ * principal fecha os quadros pelo silêncio e entrega os eventos. Os tempos
+ * chegam por parâmetro, então o mesmo código roda com bordas sintéticas no
+ * host.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef IR_FUSION_H
+#define IR_FUSION_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "ir_capture.h"
+#include "ir_calib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define IR_FUSION_MAX_SENSORS 4
+#define IR_FUSION_MAX_TIMINGS 512       // Tempos por quadro
+#define IR_FUSION_EVENTS 4              // Eventos aguardando o laço principal
+#define IR_FUSION_GAP_US 30000          // Silêncio que encerra um quadro (igual ao receptor.c)
+#define IR_FUSION_WINDOW_US 20000       // Diferença de início aceita para o mesmo comando
+#define IR_FUSION_GLITCH_US 100         // Saneamento (mesmo valor do receptor.c)
+#define IR_FUSION_MIN_TIMINGS 10        // Quadros menores são ruído
+
+// Quadro de um sensor
+typedef struct {
+    uint16_t raw[IR_FUSION_MAX_TIMINGS];
+    uint16_t count;
+    uint64_t start_us;
+    uint16_t quality;                   // Penalidade (menor = melhor)
+    ir_protocol_t protocol;
+    bool ready;                         // Fechado, aguardando a fusão
+    bool grouped;                       // Faz parte do evento em formação
+} ir_fusion_frame_t;
+
+typedef struct {
+    uint32_t frames;                    // Quadros fechados
+    uint32_t events_seen;
+    uint32_t events_missed;             // Eventos vistos só pelos outros sensores
+    uint32_t best;                      // Vezes em que deu a melhor cópia
+    uint32_t glitches;
+    uint32_t edge_shifts;
+    uint32_t mismatches;                // Quadros com quantidade de tempos inesperada
+    uint32_t noise;                     // Quadros curtos descartados
+    uint32_t truncated;                 // Quadros maiores que IR_FUSION_MAX_TIMINGS
+    uint32_t busy_drops;                // Quadro perdido com os dois buffers ocupados
+    uint64_t last_frame_us;
+} ir_fusion_health_t;
+
+typedef struct {
+    uint8_t gpio;
+
+    // Montagem (interrupção)
+    ir_sanitizer_t sanitizer;
+    ir_fusion_frame_t frames[2];
+    uint8_t assembling;                 // Buffer em montagem
+    bool capturing;
+    bool discarding;                    // Quadro sem buffer livre: ignora até o silêncio
+    bool overflow;                      // Quadro atual passou de IR_FUSION_MAX_TIMINGS
+    uint64_t last_edge_us;
+
+    ir_fusion_health_t health;
+
+    // Desvio marca/espaço (interrupção)
+    ir_calib_estimator_t estimator;
+    ir_calib_t calib;
+} ir_fusion_sensor_t;
+
+typedef struct {
+    uint64_t start_us;
+    uint16_t raw[IR_FUSION_MAX_TIMINGS]; // Melhor cópia
+    uint16_t count;
+    ir_protocol_t protocol;
+    uint16_t quality;
+    uint8_t sensors;                    // Máscara dos sensores que viram
+    uint8_t best;                       // Sensor da melhor cópia
+} ir_fusion_event_t;
+
+typedef struct {
+    ir_fusion_sensor_t sensors[IR_FUSION_MAX_SENSORS];
+    uint8_t sensor_count;
+
+    // Evento em formação
+    bool group_open;
+    uint64_t group_start_us;
+    uint64_t group_deadline_us;
+    uint8_t group_mask;
+    int8_t group_best;
+
+    ir_fusion_event_t events[IR_FUSION_EVENTS];
+    uint8_t event_head;
+    uint8_t event_count;
+
+    // Contadores
+    uint32_t emitted;
+    uint32_t merged_frames;             // Cópias absorvidas em um evento existente
+    uint32_t event_drops;               // Fila de eventos cheia
+} ir_fusion_t;
+
+/**
+ * Prepara a fusão para os pinos dados (até IR_FUSION_MAX_SENSORS)
+ */
+void ir_fusion_init(ir_fusion_t *f, const uint8_t *gpios, uint8_t count);
+
+/**
+ * Configura os pinos como entrada e instala a interrupção de bordas
+ *
+ * Apenas uma instância por vez pode estar ligada às interrupções.
+ */
+void ir_fusion_attach_gpio(ir_fusion_t *f);
+
+/**
+ * Entrega uma borda do sensor (nível após a borda)
+ */
+void ir_fusion_edge(ir_fusion_t *f, uint8_t sensor, bool level, uint64_t now_us);
+
+/**
+ * Fecha quadros em silêncio e forma eventos (chamar a cada poucos ms)
+ *
+ * @return true se há evento disponível
+ */
+bool ir_fusion_poll(ir_fusion_t *f, uint64_t now_us);
+
+/**
+ * Evento mais antigo (NULL se não houver); válido até ir_fusion_release()
+ */
+const ir_fusion_event_t *ir_fusion_peek(const ir_fusion_t *f);
+
+void ir_fusion_release(ir_fusion_t *f);
+
+/**
+ * Porcentagem dos eventos que o sensor viu (100 sem eventos)
+ */
+uint8_t ir_fusion_health_pct(const ir_fusion_t *f, uint8_t sensor);
+
+/**
+ * Troca a correção de cada sensor com amostras suficientes pela estimativa
+ * acumulada
+ *
+ * @return Máscara dos sensores calibrados
+ */
+uint8_t ir_fusion_calibrate(ir_fusion_t *f);
+
+/**
+ * Correção de um sensor medida antes (por exemplo, gravada no código)
+ */
+void ir_fusion_set_calib(ir_fusion_t *f, uint8_t sensor, const ir_calib_t *calib);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IR_FUSION_H
@@ -0,0 +1,121 @@
+/**
+ * ir_health.c - Janela de medidas do sensor IR e classificação
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <string.h>
+
+#include "ir_health.h"
+
+void ir_health_init(ir_health_t *h) {
+    memset(h, 0, sizeof(*h));
+}
+
+uint32_t ir_health_bin(uint32_t duration_us) {
+    if (duration_us < IR_HEALTH_BIN_BASE_US) {
+        return 0;
+    }
+    // 64-127 us na faixa 1, dobrando a cada faixa
+    uint32_t bin = 32 - (uint32_t)__builtin_clz(duration_us / IR_HEALTH_BIN_BASE_US);
+    return bin < IR_HEALTH_BINS ? bin : IR_HEALTH_BINS - 1;
+}
+
+uint32_t ir_health_bin_floor_us(uint32_t bin) {
+    return bin == 0 ? 0 : IR_HEALTH_BIN_BASE_US << (bin - 1);
+}
+
+// Fecha a rajada atual: poucas marcas entre silêncios não formam quadro
+static void close_burst(ir_health_t *h) {
+    if (h->burst_marks >= IR_HEALTH_FRAME_MIN_MARKS) {
+        h->signal_bursts++;
+    } else {
+        h->noise_marks += h->burst_marks;
+        h->noise_low_us += h->burst_low_us;
+    }
+    h->burst_marks = 0;
+    h->burst_low_us = 0;
+}
+
+void ir_health_push(ir_health_t *h, bool level, uint32_t duration_us) {
+    uint32_t bin = ir_health_bin(duration_us);
+    h->edges++;
+
+    if (level) {
+        h->high_us += duration_us;
+        h->space_hist[bin]++;
+        if (duration_us >= IR_HEALTH_FRAME_GAP_US) {
+            close_burst(h);
+        }
+        return;
+    }
+
+    h->low_us += duration_us;
+    h->mark_hist[bin]++;
+    if (duration_us > h->longest_low_us) {
+        h->longest_low_us = duration_us;
+    }
+    if (h->shortest_mark_us == 0 || duration_us < h->shortest_mark_us) {
+        h->shortest_mark_us = duration_us;
+    }
+    if (duration_us < IR_HEALTH_NOISE_MARK_US) {
+        h->noise_marks++;
+        h->noise_low_us += duration_us;
+    } else {
+        h->burst_marks++;
+        h->burst_low_us += duration_us;
+    }
+}
+
+void ir_health_report(const ir_health_t *h, bool level_now, uint32_t level_now_us, ir_health_report_t *report) {
+    // O trecho aberto entra numa cópia, sem contar como borda
+    ir_health_t w = *h;
+    if (level_now) {
+        w.high_us += level_now_us;
+        if (level_now_us >= IR_HEALTH_FRAME_GAP_US) {
+            close_burst(&w);
+        }
+    } else {
+        w.low_us += level_now_us;
+        if (level_now_us > w.longest_low_us) {
+            w.longest_low_us = level_now_us;
+        }
+    }
+
+    uint64_t window_us = w.high_us + w.low_us;
+    memset(report, 0, sizeof(*report));
+    report->window_ms = (uint32_t)(window_us / 1000);
+    report->edges = w.edges;
+    report->idle_high = w.high_us >= w.low_us;
+    report->noise_marks = w.noise_marks;
+    report->signal_bursts = w.signal_bursts;
+    report->longest_low_us = w.longest_low_us;
+    report->shortest_mark_us = w.shortest_mark_us;
+    if (window_us > 0) {
+        report->edges_per_s = (uint32_t)((uint64_t)w.edges * 1000000 / window_us);
+        report->high_permille = (uint16_t)(w.high_us * 1000 / window_us);
+        report->noise_per_min = (uint32_t)((uint64_t)w.noise_marks * 60000000 / window_us);
+        report->noise_low_ppm = (uint32_t)(w.noise_low_us * 1000000 / window_us);
+    }
+
+    if (w.longest_low_us >= IR_HEALTH_STUCK_LOW_US || !report->idle_high) {
+        report->status = IR_HEALTH_DEAD;
+    } else if (report->noise_per_min >= IR_HEALTH_NOISY_PER_MIN) {
+        report->status = IR_HEALTH_NOISY;
+    } else if (w.edges == 0) {
+        report->status = IR_HEALTH_SILENT;
+    } else {
+        report->status = IR_HEALTH_OK;
+    }
+}
+
+const char *ir_health_status_name(ir_health_status_t status) {
+    switch (status) {
+        case IR_HEALTH_OK: return "OK";
+        case IR_HEALTH_SILENT: return "SEM ATIVIDADE";
+        case IR_HEALTH_NOISY: return "INTERFERÊNCIA (sol ou lâmpada)";
+        case IR_HEALTH_DEAD: return "SENSOR MORTO OU TRAVADO";
+        default: return "?";
+    }
+}
@@ -0,0 +1,120 @@
+/**
+ * ir_health.h - Diagnóstico do sensor IR a partir da duração dos níveis
+ *
+ * Recebe cada trecho em nível alto ou baixo da saída do receptor (medido pelo
+ * edge_capture, pelo shim no host ou por qualquer outra fonte) e acumula uma
+ * janela: bordas, distribuição das larguras de marca e de espaço, fração do
+ * tempo em repouso e o piso de ruído, isto é, marcas que não formam quadro:
+ * mais curtas que qualquer protocolo ou isoladas entre silêncios. O relatório
+ * classifica o sensor:
+ *
+ * - morto: nível baixo por mais tempo que qualquer protocolo, ou repouso em
+ *   nível baixo (sensor sem alimentação, em curto ou invertido);
+ * - interferência: ruído acima do limite (sol direto ou lâmpada fluorescente
+ *   fazendo o AGC do receptor disparar);
+ * - sem atividade: nenhuma borda com o pino em repouso (sensor bom sem
+ *   controle à frente, ou pino desconectado que flutua em nível alto);
+ * - ok: bordas, e o ruído abaixo do limite.
+ *
+ * Nenhuma chamada de hardware, então a mesma análise roda no firmware e
+ * sobre traços sintéticos no host.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef IR_HEALTH_H
+#define IR_HEALTH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define IR_HEALTH_BINS 10                   // Faixas de largura: < 64 us, 64-128 us, ... , >= 16 ms
+#define IR_HEALTH_BIN_BASE_US 64
+#define IR_HEALTH_NOISE_MARK_US 150         // Marca mais curta que a de qualquer protocolo
+#define IR_HEALTH_FRAME_GAP_US 20000        // Silêncio que separa rajadas
+#define IR_HEALTH_FRAME_MIN_MARKS 2         // Rajada com menos marcas é ruído (repetição NEC tem 2)
+#define IR_HEALTH_STUCK_LOW_US 100000       // Nenhum protocolo fica tanto tempo em marca (NEC: 9 ms)
+#define IR_HEALTH_NOISY_PER_MIN 120         // Marcas de ruído por minuto para acusar interferência
+
+typedef enum {
+    IR_HEALTH_OK,
+    IR_HEALTH_SILENT,
+    IR_HEALTH_NOISY,
+    IR_HEALTH_DEAD
+} ir_health_status_t;
+
+typedef struct {
+    uint64_t high_us;                       // Tempo em nível alto (repouso)
+    uint64_t low_us;                        // Tempo em nível baixo (marca)
+    uint32_t edges;
+    uint32_t mark_hist[IR_HEALTH_BINS];
+    uint32_t space_hist[IR_HEALTH_BINS];
+    uint32_t longest_low_us;
+    uint32_t shortest_mark_us;
+    uint32_t noise_marks;                   // Curtas demais ou isoladas
+    uint64_t noise_low_us;
+    uint32_t signal_bursts;                 // Rajadas com cara de quadro
+
+    // Rajada em andamento
+    uint32_t burst_marks;
+    uint32_t burst_low_us;
+} ir_health_t;
+
+typedef struct {
+    ir_health_status_t status;
+    uint32_t window_ms;
+    uint32_t edges;
+    uint32_t edges_per_s;
+    bool idle_high;                         // Nível em que o pino passa mais tempo
+    uint16_t high_permille;                 // Fração do tempo em nível alto
+    uint32_t noise_marks;
+    uint32_t noise_per_min;                 // Piso de ruído
+    uint32_t noise_low_ppm;                 // Fração do tempo em marcas de ruído
+    uint32_t signal_bursts;
+    uint32_t longest_low_us;
+    uint32_t shortest_mark_us;              // 0 sem marcas
+} ir_health_report_t;
+
+/**
+ * Começa uma janela nova
+ */
+void ir_health_init(ir_health_t *h);
+
+/**
+ * Acrescenta um trecho medido
+ *
+ * @param level Nível do trecho (true = alto, repouso do receptor)
+ * @param duration_us Duração do trecho
+ */
+void ir_health_push(ir_health_t *h, bool level, uint32_t duration_us);
+
+/**
+ * Relatório da janela, sem alterá-la
+ *
+ * @param level_now Nível atual do pino
+ * @param level_now_us Tempo desde a última borda (o trecho ainda aberto, que
+ *                     também conta: um sensor travado não gera bordas)
+ */
+void ir_health_report(const ir_health_t *h, bool level_now, uint32_t level_now_us, ir_health_report_t *report);
+
+/**
+ * Faixa do histograma de uma largura e o limite inferior de uma faixa
+ */
+uint32_t ir_health_bin(uint32_t duration_us);
+uint32_t ir_health_bin_floor_us(uint32_t bin);
+
+/**
+ * Nome do diagnóstico
+ */
+const char *ir_health_status_name(ir_health_status_t status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IR_HEALTH_H
@@ -0,0 +1,140 @@
+/**
+ * ir_log.c - Anel do log binário e formatação no flush
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+#include "ir_log.h"
+
+#define RING_MASK (IR_LOG_ENTRIES - 1)
+
+ir_log_t ir_log = {.level = IR_LOG_LEVEL_INFO};
+
+static void stdout_output(const char *text, size_t length) {
+    fwrite(text, 1, length, stdout);
+}
+
+void ir_log_init(ir_log_level_t level) {
+    memset(&ir_log, 0, sizeof(ir_log));
+    ir_log.level = level;
+    ir_log.output = stdout_output;
+}
+
+void ir_log_set_level(ir_log_level_t level) {
+    ir_log.level = level;
+}
+
+void ir_log_set_output(ir_log_output_t output) {
+    ir_log.output = output ? output : stdout_output;
+}
+
+/**
+ * Reserva a próxima posição (NULL com o anel cheio)
+ */
+static ir_log_entry_t *reserve(void) {
+    uint32_t status = save_and_disable_interrupts();
+    uint32_t head = ir_log.head;
+    if (head - ir_log.tail >= IR_LOG_ENTRIES) {
+        ir_log.dropped++;
+        restore_interrupts(status);
+        return NULL;
+    }
+    ir_log.head = head + 1;
+    // Contado aqui, com as interrupções desligadas: ISRs e o laço principal
+    // escrevem ao mesmo tempo
+    ir_log.written++;
+    restore_interrupts(status);
+    return &ir_log.ring[head & RING_MASK];
+}
+
+static void publish(ir_log_entry_t *e) {
+    __dmb();
+    e->ready = true;
+}
+
+void ir_log_write(uint8_t level, const char *fmt, ir_log_arg_t a0, ir_log_arg_t a1, ir_log_arg_t a2,
+                  ir_log_arg_t a3) {
+    ir_log_entry_t *e = reserve();
+    if (!e) {
+        return;
+    }
+    e->fmt = fmt;
+    e->time_us = time_us_32();
+    e->args[0] = a0;
+    e->args[1] = a1;
+    e->args[2] = a2;
+    e->args[3] = a3;
+    e->level = level;
+    e->has_text = false;
+    publish(e);
+}
+
+void ir_log_write_text(uint8_t level, const char *fmt, const char *text, ir_log_arg_t a1, ir_log_arg_t a2,
+                       ir_log_arg_t a3) {
+    ir_log_entry_t *e = reserve();
+    if (!e) {
+        return;
+    }
+    e->fmt = fmt;
+    e->time_us = time_us_32();
+    size_t i = 0;
+    for (; text && text[i] && i < IR_LOG_TEXT_LEN - 1; i++) {
+        e->text[i] = text[i];
+    }
+    e->text[i] = '\0';
+    e->args[1] = a1;
+    e->args[2] = a2;
+    e->args[3] = a3;
+    e->level = level;
+    e->has_text = true;
+    publish(e);
+}
+
+size_t ir_log_pending(void) {
+    return ir_log.head - ir_log.tail;
+}
+
+size_t ir_log_flush(size_t max_entries) {
+    char line[IR_LOG_LINE_LEN];
+    size_t count = 0;
+
+    if (!ir_log.output) {
+        ir_log.output = stdout_output;
+    }
+
+    // Perdas desde o último flush, antes das mensagens que sobraram
+    uint32_t dropped = ir_log.dropped;
+    if (dropped != ir_log.dropped_reported) {
+        int n = snprintf(line, sizeof(line), "[log] %lu mensagem(ns) perdida(s)\n",
+                         (unsigned long)(dropped - ir_log.dropped_reported));
+        ir_log.output(line, (size_t)n < sizeof(line) ? (size_t)n : sizeof(line) - 1);
+        ir_log.dropped_reported = dropped;
+    }
+
+    while (ir_log.tail != ir_log.head && (max_entries == 0 || count < max_entries)) {
+        ir_log_entry_t *e = &ir_log.ring[ir_log.tail & RING_MASK];
+        if (!e->ready) {
+            break;      // Reservada por uma interrupção que ainda não publicou
+        }
+        __dmb();
+
+        ir_log_arg_t a0 = e->has_text ? (ir_log_arg_t)e->text : e->args[0];
+        int n = snprintf(line, sizeof(line), e->fmt, a0, e->args[1], e->args[2], e->args[3]);
+        if (n > 0) {
+            ir_log.output(line, (size_t)n < sizeof(line) ? (size_t)n : sizeof(line) - 1);
+        }
+
+        e->ready = false;
+        __dmb();
+        ir_log.tail++;
+        count++;
+    }
+    return count;
+}
@@ -0,0 +1,153 @@
+/**
+ * ir_log.h - Log binário adiado
+ *
+ * IR_LOG_*() não formata nada: grava o ponteiro do formato (um literal em
+ * flash, que serve de identificador), o instante e até 4 argumentos inteiros
+ * num anel de entradas fixas. A formatação e a saída pela USB ficam para
+ * ir_log_flush(), chamada quando o laço principal está ocioso. Assim os
+ * callbacks de interrupção e os trechos sensíveis a tempo não pagam printf
+ * nem esperam a USB CDC.
+ *
+ * Gravar reserva a posição numa seção crítica de poucas instruções (o
+ * Cortex-M0+ não tem instruções atômicas de leitura-escrita) e copia os
+ * argumentos fora dela; o leitor só avança até a primeira entrada ainda não
+ * publicada. Com o anel cheio a mensagem é descartada e contada, e o próximo
+ * flush informa quantas se perderam.
+ *
+ * Argumentos são inteiros ou ponteiros para textos constantes. Texto em
+ * buffer que muda (linha digitada, etc.) vai com IR_LOG_TEXT, que copia até
+ * IR_LOG_TEXT_LEN - 1 caracteres para a entrada e o usa como primeiro
+ * argumento.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef IR_LOG_H
+#define IR_LOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    IR_LOG_LEVEL_ERROR,
+    IR_LOG_LEVEL_WARN,
+    IR_LOG_LEVEL_INFO,
+    IR_LOG_LEVEL_DEBUG
+} ir_log_level_t;
+
+// Níveis acima deste nem são compilados
+#ifndef IR_LOG_COMPILE_LEVEL
+#define IR_LOG_COMPILE_LEVEL IR_LOG_LEVEL_DEBUG
+#endif
+
+#define IR_LOG_ENTRIES 64           // Potência de 2
+#define IR_LOG_MAX_ARGS 4
+#define IR_LOG_TEXT_LEN 16
+#define IR_LOG_LINE_LEN 160         // Linha formatada no flush
+
+typedef uintptr_t ir_log_arg_t;
+
+typedef struct {
+    const char *fmt;
+    uint32_t time_us;
+    ir_log_arg_t args[IR_LOG_MAX_ARGS];
+    char text[IR_LOG_TEXT_LEN];     // Cópia de IR_LOG_TEXT
+    uint8_t level;
+    bool has_text;
+    volatile bool ready;            // Publicada pelo escritor
+} ir_log_entry_t;
+
+/**
+ * Saída do texto formatado (padrão: stdout)
+ */
+typedef void (*ir_log_output_t)(const char *text, size_t length);
+
+typedef struct {
+    ir_log_entry_t ring[IR_LOG_ENTRIES];
+    volatile uint32_t head;         // Próxima posição a reservar
+    volatile uint32_t tail;         // Próxima posição a formatar
+    volatile uint8_t level;         // Nível em tempo de execução
+    ir_log_output_t output;
+
+    // Contadores
+    volatile uint32_t written;
+    volatile uint32_t dropped;      // Anel cheio
+    uint32_t dropped_reported;
+} ir_log_t;
+
+extern ir_log_t ir_log;
+
+/**
+ * Prepara o anel
+ *
+ * @param level Mensagens acima deste nível são ignoradas
+ */
+void ir_log_init(ir_log_level_t level);
+
+void ir_log_set_level(ir_log_level_t level);
+
+void ir_log_set_output(ir_log_output_t output);
+
+/**
+ * Grava uma entrada (use as macros)
+ */
+void ir_log_write(uint8_t level, const char *fmt, ir_log_arg_t a0, ir_log_arg_t a1, ir_log_arg_t a2,
+                  ir_log_arg_t a3);
+
+/**
+ * Grava uma entrada copiando text (primeiro argumento do formato, %s)
+ */
+void ir_log_write_text(uint8_t level, const char *fmt, const char *text, ir_log_arg_t a1, ir_log_arg_t a2,
+                       ir_log_arg_t a3);
+
+/**
+ * Formata e envia até max_entries entradas (0 = todas as publicadas)
+ *
+ * Chamar fora de interrupção, quando o laço estiver ocioso.
+ *
+ * @return Entradas formatadas
+ */
+size_t ir_log_flush(size_t max_entries);
+
+/**
+ * Entradas aguardando o flush
+ */
+size_t ir_log_pending(void);
+
+#define IR_LOG_ARGS_(fmt, a0, a1, a2, a3, ...) \
+    (fmt), (ir_log_arg_t)(a0), (ir_log_arg_t)(a1), (ir_log_arg_t)(a2), (ir_log_arg_t)(a3)
+
+#define IR_LOG_TEXT_ARGS_(dummy, a1, a2, a3, ...) \
+    (ir_log_arg_t)(a1), (ir_log_arg_t)(a2), (ir_log_arg_t)(a3)
+
+#define IR_LOG(lvl, ...)                                                            \
+    do {                                                                            \
+        if ((lvl) <= IR_LOG_COMPILE_LEVEL && (lvl) <= ir_log.level) {               \
+            ir_log_write((lvl), IR_LOG_ARGS_(__VA_ARGS__, 0, 0, 0, 0, 0));          \
+        }                                                                           \
+    } while (0)
+
+#define IR_LOG_TEXT(lvl, fmt, text, ...)                                            \
+    do {                                                                            \
+        if ((lvl) <= IR_LOG_COMPILE_LEVEL && (lvl) <= ir_log.level) {               \
+            ir_log_write_text((lvl), (fmt), (text),                                 \
+                              IR_LOG_TEXT_ARGS_(0, ##__VA_ARGS__, 0, 0, 0));        \
+        }                                                                           \
+    } while (0)
+
+#define IR_LOG_ERROR(...) IR_LOG(IR_LOG_LEVEL_ERROR, __VA_ARGS__)
+#define IR_LOG_WARN(...) IR_LOG(IR_LOG_LEVEL_WARN, __VA_ARGS__)
+#define IR_LOG_INFO(...) IR_LOG(IR_LOG_LEVEL_INFO, __VA_ARGS__)
+#define IR_LOG_DEBUG(...) IR_LOG(IR_LOG_LEVEL_DEBUG, __VA_ARGS__)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IR_LOG_H
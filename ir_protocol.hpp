@@ -0,0 +1,285 @@
+/**
+ * ir_protocol.hpp - Protocolos IR descritos como tipos em tempo de compilação
+ *
+ * Cada protocolo é uma struct só com constantes: carrier, cabeçalho
+ * (marca/espaço), codificação do bit 0 e do bit 1, ordem dos bits, marca
+ * final e repetição, além de uma função que monta os bytes do quadro. Os
+ * números que aparecem soltos no firmware (562,5 us em nec_transmit.c,
+ * NUM_CYCLES no nec_carrier_burst.pio, IR_CARRIER_FREQ 38000, os vetores
+ * capturados) continuam lá; o ir_bench confere esses números contra as
+ * descrições daqui (bench_protocol.cpp).
+ *
+ * Encoder<P> gera a partir dessas constantes um codificador especializado:
+ * tabelas de tempos por valor de bit calculadas na compilação, ordem dos bits
+ * resolvida por if constexpr e laços de tamanho fixo, sem desvio por bit. A
+ * saída é a lista de tempos (marca, espaço, ..., em us, o formato de
+ * send_raw_signal()) ou as palavras de 32 bits que um programa PIO de
+ * distância de pulso consome deslocando o OSR para a direita (o
+ * nec_carrier_control.pio, para o NEC).
+ *
+ * Os tempos são descritos em ns para representar a unidade de 562,5 us do NEC
+ * sem erro. Quando algum tempo não é um número inteiro de us, o arredondamento
+ * é feito sobre o tempo acumulado desde o início do quadro, para não somar
+ * meio us a cada símbolo.
+ *
+ * Só o código C++ do host (ir_bench) inclui este cabeçalho por enquanto.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef IR_PROTOCOL_HPP
+#define IR_PROTOCOL_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "philco_ac.h"
+
+namespace ir {
+
+enum class BitOrder {
+    LsbFirst,
+    MsbFirst
+};
+
+enum class Repeat {
+    None,                               // Quadro enviado uma vez
+    Code,                               // Código curto enquanto a tecla segue pressionada
+    Frame                               // O próprio quadro de novo
+};
+
+// Marca seguida de espaço (ns)
+struct Pulse {
+    uint32_t mark_ns;
+    uint32_t space_ns;
+};
+
+constexpr uint32_t us(uint32_t v) {
+    return v * 1000;
+}
+
+/**
+ * NEC (nec_transmit_library): 32 bits, LSB primeiro, endereço e comando
+ * seguidos dos seus complementos
+ */
+struct Nec {
+    static constexpr uint32_t carrier_hz = 38222;     // nec_tx_init()
+    static constexpr uint32_t unit_ns = 562500;       // 2 ticks do nec_carrier_control.pio
+    static constexpr Pulse header = {16 * unit_ns, 8 * unit_ns};
+    static constexpr Pulse zero = {unit_ns, unit_ns};
+    static constexpr Pulse one = {unit_ns, 3 * unit_ns};
+    static constexpr uint32_t trailer_ns = unit_ns;
+    static constexpr BitOrder order = BitOrder::LsbFirst;
+    static constexpr size_t bytes = 4;
+
+    static constexpr Repeat repeat = Repeat::Code;
+    static constexpr Pulse repeat_header = {16 * unit_ns, 4 * unit_ns};
+    static constexpr uint32_t period_ns = us(108000);  // Início a início
+
+    using payload_t = std::array<uint8_t, bytes>;
+
+    static constexpr payload_t payload(uint8_t address, uint8_t command) {
+        return {address, uint8_t(~address), command, uint8_t(~command)};
+    }
+};
+
+/**
+ * Ar condicionado Philco (philco_ac.h): 14 bytes, LSB primeiro, o último é a
+ * soma dos 13 anteriores
+ */
+struct PhilcoAc {
+    static constexpr uint32_t carrier_hz = 38000;     // IR_CARRIER_FREQ
+    static constexpr Pulse header = {us(PHILCO_AC_HDR_MARK), us(PHILCO_AC_HDR_SPACE)};
+    static constexpr Pulse zero = {us(PHILCO_AC_BIT_MARK), us(PHILCO_AC_ZERO_SPACE)};
+    static constexpr Pulse one = {us(PHILCO_AC_BIT_MARK), us(PHILCO_AC_ONE_SPACE)};
+    static constexpr uint32_t trailer_ns = us(PHILCO_AC_BIT_MARK);
+    static constexpr BitOrder order = BitOrder::LsbFirst;
+    static constexpr size_t bytes = PHILCO_AC_FRAME_BYTES;
+
+    static constexpr Repeat repeat = Repeat::None;
+
+    using payload_t = std::array<uint8_t, bytes>;
+
+    // Copia os 13 bytes de estado e acrescenta o checksum
+    static constexpr payload_t payload(const uint8_t *state) {
+        payload_t p{};
+        uint8_t sum = 0;
+        for (size_t i = 0; i < bytes - 1; i++) {
+            p[i] = state[i];
+            sum = uint8_t(sum + state[i]);
+        }
+        p[bytes - 1] = sum;
+        return p;
+    }
+};
+
+/**
+ * Samsung (TVs): 32 bits, LSB primeiro, endereço repetido e comando seguido
+ * do complemento; enquanto a tecla segue pressionada o quadro inteiro repete
+ */
+struct Samsung {
+    static constexpr uint32_t carrier_hz = 38000;
+    static constexpr Pulse header = {us(4500), us(4500)};
+    static constexpr Pulse zero = {us(560), us(560)};
+    static constexpr Pulse one = {us(560), us(1690)};
+    static constexpr uint32_t trailer_ns = us(560);
+    static constexpr BitOrder order = BitOrder::LsbFirst;
+    static constexpr size_t bytes = 4;
+
+    static constexpr Repeat repeat = Repeat::Frame;
+    static constexpr uint32_t period_ns = us(108000);
+
+    using payload_t = std::array<uint8_t, bytes>;
+
+    static constexpr payload_t payload(uint8_t address, uint8_t command) {
+        return {address, address, command, uint8_t(~command)};
+    }
+};
+
+/**
+ * Codificador gerado para o protocolo P
+ */
+template <typename P>
+struct Encoder {
+    using payload_t = typename P::payload_t;
+
+    static constexpr size_t bits = P::bytes * 8;
+    static constexpr size_t timings = 2 + 2 * bits + 1;   // Cabeçalho, bits e marca final
+    static constexpr size_t words = (bits + 31) / 32;
+
+    static constexpr bool whole(uint32_t ns) {
+        return ns % 1000 == 0;
+    }
+
+    // Com todos os tempos em us inteiros as tabelas já são a saída
+    static constexpr bool whole_us = whole(P::header.mark_ns) && whole(P::header.space_ns) &&
+                                     whole(P::zero.mark_ns) && whole(P::zero.space_ns) &&
+                                     whole(P::one.mark_ns) && whole(P::one.space_ns) && whole(P::trailer_ns);
+
+    // Tabelas indexadas pelo valor do bit
+    static constexpr uint32_t mark_ns[2] = {P::zero.mark_ns, P::one.mark_ns};
+    static constexpr uint32_t space_ns[2] = {P::zero.space_ns, P::one.space_ns};
+    static constexpr uint16_t mark_us[2] = {uint16_t(P::zero.mark_ns / 1000), uint16_t(P::one.mark_ns / 1000)};
+    static constexpr uint16_t space_us[2] = {uint16_t(P::zero.space_ns / 1000), uint16_t(P::one.space_ns / 1000)};
+
+    static_assert(P::header.mark_ns / 1000 <= UINT16_MAX && P::header.space_ns / 1000 <= UINT16_MAX,
+                  "tempo maior que o formato de send_raw_signal()");
+
+    /**
+     * Ciclos de carrier em uma marca de ns (NUM_CYCLES do nec_carrier_burst.pio
+     * para a unidade do NEC)
+     */
+    static constexpr uint32_t carrier_cycles(uint32_t ns) {
+        return uint32_t(uint64_t(ns) * P::carrier_hz / 1000000000u);
+    }
+
+    static constexpr uint32_t bit_mark_cycles = carrier_cycles(P::zero.mark_ns);
+
+    // Bit b do byte, na ordem de transmissão
+    static constexpr unsigned shift(unsigned b) {
+        if constexpr (P::order == BitOrder::LsbFirst) {
+            return b;
+        } else {
+            return 7 - b;
+        }
+    }
+
+    // Byte com os bits na ordem de transmissão a partir do LSB
+    static constexpr uint32_t wire_byte(uint8_t v) {
+        if constexpr (P::order == BitOrder::LsbFirst) {
+            return v;
+        } else {
+            uint32_t r = v;
+            r = (r & 0xF0u) >> 4 | (r & 0x0Fu) << 4;
+            r = (r & 0xCCu) >> 2 | (r & 0x33u) << 2;
+            r = (r & 0xAAu) >> 1 | (r & 0x55u) << 1;
+            return r;
+        }
+    }
+
+    // Relógio de saída: acumula em ns e arredonda a partir do início
+    struct Clock {
+        uint32_t ns = 0;
+        uint32_t us = 0;
+
+        constexpr uint16_t step(uint32_t d_ns, uint16_t d_us) {
+            if constexpr (whole_us) {
+                return d_us;
+            } else {
+                ns += d_ns;
+                uint32_t end = (ns + 500) / 1000;
+                uint16_t d = uint16_t(end - us);
+                us = end;
+                return d;
+            }
+        }
+    };
+
+    /**
+     * Tempos do quadro
+     *
+     * @param out Recebe timings tempos (us)
+     * @return timings
+     */
+    static constexpr size_t durations(const payload_t &payload, uint16_t *out) {
+        Clock clock;
+        uint16_t *o = out;
+
+        *o++ = clock.step(P::header.mark_ns, uint16_t(P::header.mark_ns / 1000));
+        *o++ = clock.step(P::header.space_ns, uint16_t(P::header.space_ns / 1000));
+        for (size_t i = 0; i < P::bytes; i++) {
+            uint32_t byte = payload[i];
+            for (unsigned b = 0; b < 8; b++) {
+                uint32_t bit = (byte >> shift(b)) & 1u;
+                *o++ = clock.step(mark_ns[bit], mark_us[bit]);
+                *o++ = clock.step(space_ns[bit], space_us[bit]);
+            }
+        }
+        *o++ = clock.step(P::trailer_ns, uint16_t(P::trailer_ns / 1000));
+        return timings;
+    }
+
+    static constexpr std::array<uint16_t, timings> waveform(const payload_t &payload) {
+        std::array<uint16_t, timings> out{};
+        durations(payload, out.data());
+        return out;
+    }
+
+    /**
+     * Palavras para o FIFO do PIO: bits na ordem de transmissão a partir do LSB
+     * (OSR deslocando para a direita), 32 por palavra
+     */
+    static constexpr std::array<uint32_t, words> pio_words(const payload_t &payload) {
+        std::array<uint32_t, words> w{};
+        for (size_t i = 0; i < P::bytes; i++) {
+            w[i / 4] |= wire_byte(payload[i]) << (8 * (i % 4));
+        }
+        return w;
+    }
+
+    /**
+     * Código de repetição (marca, espaço, marca final)
+     */
+    static constexpr std::array<uint16_t, 3> repeat_code() {
+        static_assert(P::repeat == Repeat::Code, "protocolo sem código de repetição");
+        Clock clock;
+        return {clock.step(P::repeat_header.mark_ns, uint16_t(P::repeat_header.mark_ns / 1000)),
+                clock.step(P::repeat_header.space_ns, uint16_t(P::repeat_header.space_ns / 1000)),
+                clock.step(P::trailer_ns, uint16_t(P::trailer_ns / 1000))};
+    }
+
+    /**
+     * Silêncio depois de um quadro (ou código de repetição) de frame_us até a
+     * próxima repetição
+     */
+    static constexpr uint32_t repeat_gap_us(uint32_t frame_us) {
+        static_assert(P::repeat != Repeat::None, "protocolo sem repetição");
+        return P::period_ns / 1000 - frame_us;
+    }
+};
+
+} // namespace ir
+
+#endif // IR_PROTOCOL_HPP
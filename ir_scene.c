@@ -0,0 +1,367 @@
+/**
+ * ir_scene.c - Motor de cenas e gravação de sessões
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "custom_ir.h"
+#include "ir_scene.h"
+
+static uint16_t read_u16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+// ---------------------------------------------------------------------------
+// Execução
+// ---------------------------------------------------------------------------
+
+static void scene_job(ir_scheduler_t *s, ir_job_id_t job, uint32_t late_ms, void *ctx);
+
+static void scene_end(ir_scene_t *sc) {
+    sc->running = false;
+    sc->job = -1;
+}
+
+static void scene_error(ir_scene_engine_t *e, ir_scene_t *sc) {
+    e->errors++;
+    scene_end(sc);
+}
+
+static void scene_schedule(ir_scene_engine_t *e, ir_scene_t *sc, uint64_t at_ms) {
+    sc->job = ir_scheduler_at(e->scheduler, at_ms, scene_job, sc);
+    if (sc->job < 0) {
+        scene_error(e, sc);
+    }
+}
+
+static bool enqueue(ir_scene_engine_t *e, const ir_scene_pending_t *pending) {
+    if (e->queue_count == IR_SCENE_QUEUE) {
+        return false;
+    }
+    e->queue[(e->queue_head + e->queue_count) % IR_SCENE_QUEUE] = *pending;
+    e->queue_count++;
+    return true;
+}
+
+/**
+ * Executa instruções até uma espera, o fim ou o limite por vez
+ *
+ * @param due_ms Vencimento da espera anterior: as esperas contam a partir
+ *               dele, então o atraso de atendimento não se acumula
+ */
+static void scene_run(ir_scene_engine_t *e, ir_scene_t *sc, uint64_t due_ms) {
+    uint8_t index = (uint8_t)(sc - e->scenes);
+
+    for (unsigned n = 0; n < IR_SCENE_STEP_LIMIT; n++) {
+        if (sc->pc >= sc->length) {
+            scene_error(e, sc);
+            return;
+        }
+        const uint8_t *p = &sc->code[sc->pc];
+        size_t left = sc->length - sc->pc;
+        e->steps++;
+
+        switch (p[0]) {
+            case IR_SCENE_OP_END:
+                scene_end(sc);
+                return;
+
+            case IR_SCENE_OP_SEND: {
+                if (left < 4) {
+                    scene_error(e, sc);
+                    return;
+                }
+                ir_scene_pending_t pending = {index, p[1], read_u16(&p[2]), NULL, 0};
+                if (!enqueue(e, &pending)) {
+                    e->stalls++;
+                    scene_schedule(e, sc, e->scheduler->now_ms + IR_SCENE_RETRY_MS);
+                    return;
+                }
+                sc->pc += 4;
+                break;
+            }
+
+            case IR_SCENE_OP_RAW: {
+                uint16_t count = left >= 3 ? read_u16(&p[1]) : 0;
+                if (left < 3 || count > IR_SCENE_MAX_RAW || left < 3 + 2 * (size_t)count) {
+                    scene_error(e, sc);
+                    return;
+                }
+                ir_scene_pending_t pending = {index, IR_SCENE_INLINE, 0, &p[3], count};
+                if (!enqueue(e, &pending)) {
+                    e->stalls++;
+                    scene_schedule(e, sc, e->scheduler->now_ms + IR_SCENE_RETRY_MS);
+                    return;
+                }
+                sc->pc += 3 + 2 * (size_t)count;
+                break;
+            }
+
+            case IR_SCENE_OP_WAIT:
+            case IR_SCENE_OP_WAIT_S: {
+                if (left < 3) {
+                    scene_error(e, sc);
+                    return;
+                }
+                uint32_t ms = read_u16(&p[1]);
+                if (p[0] == IR_SCENE_OP_WAIT_S) {
+                    ms *= 1000;
+                }
+                sc->pc += 3;
+                scene_schedule(e, sc, due_ms + ms);
+                return;
+            }
+
+            case IR_SCENE_OP_REPEAT:
+                if (left < 2 || sc->depth == IR_SCENE_MAX_DEPTH) {
+                    scene_error(e, sc);
+                    return;
+                }
+                sc->pc += 2;
+                sc->loop_start[sc->depth] = (uint16_t)sc->pc;
+                sc->loop_left[sc->depth] = p[1];
+                sc->depth++;
+                break;
+
+            case IR_SCENE_OP_NEXT: {
+                if (sc->depth == 0) {
+                    scene_error(e, sc);
+                    return;
+                }
+                uint8_t top = sc->depth - 1;
+                // 0 = sem fim
+                if (sc->loop_left[top] == 0 || --sc->loop_left[top] > 0) {
+                    sc->pc = sc->loop_start[top];
+                } else {
+                    sc->depth--;
+                    sc->pc++;
+                }
+                break;
+            }
+
+            default:
+                scene_error(e, sc);
+                return;
+        }
+    }
+
+    // Laço sem espera: cede para as outras tarefas e continua no próximo ms
+    scene_schedule(e, sc, e->scheduler->now_ms + 1);
+}
+
+static void scene_job(ir_scheduler_t *s, ir_job_id_t job, uint32_t late_ms, void *ctx) {
+    ir_scene_t *sc = ctx;
+    sc->job = -1;
+    scene_run(sc->engine, sc, s->now_ms - late_ms);
+}
+
+void ir_scene_engine_init(ir_scene_engine_t *e, ir_scheduler_t *scheduler, ir_scene_send_fn_t send, void *ctx) {
+    memset(e, 0, sizeof(*e));
+    e->scheduler = scheduler;
+    e->send = send;
+    e->send_ctx = ctx;
+    for (int i = 0; i < IR_SCENE_MAX_RUNNING; i++) {
+        e->scenes[i].engine = e;
+        e->scenes[i].job = -1;
+    }
+}
+
+int ir_scene_start(ir_scene_engine_t *e, const uint8_t *code, size_t length) {
+    for (int i = 0; i < IR_SCENE_MAX_RUNNING; i++) {
+        ir_scene_t *sc = &e->scenes[i];
+        if (sc->running) {
+            continue;
+        }
+        sc->code = code;
+        sc->length = length;
+        sc->pc = 0;
+        sc->depth = 0;
+        sc->running = true;
+        scene_schedule(e, sc, e->scheduler->now_ms);
+        return sc->running ? i : -1;
+    }
+    return -1;
+}
+
+bool ir_scene_stop(ir_scene_engine_t *e, int scene) {
+    if (!ir_scene_running(e, scene)) {
+        return false;
+    }
+    ir_scene_t *sc = &e->scenes[scene];
+    if (sc->job >= 0) {
+        ir_scheduler_cancel(e->scheduler, sc->job);
+    }
+    scene_end(sc);
+    return true;
+}
+
+bool ir_scene_running(const ir_scene_engine_t *e, int scene) {
+    return scene >= 0 && scene < IR_SCENE_MAX_RUNNING && e->scenes[scene].running;
+}
+
+bool ir_scene_pump(ir_scene_engine_t *e) {
+    if (e->queue_count == 0) {
+        return false;
+    }
+    const ir_scene_pending_t *pending = &e->queue[e->queue_head];
+    ir_scene_frame_t frame = {pending->target, pending->code, NULL, 0, pending->scene};
+
+    // Tempos gravados saem do bytecode (sem alinhamento) para o buffer livre
+    if (pending->target == IR_SCENE_INLINE) {
+        uint16_t *buf = e->raw_buf[e->raw_next];
+        for (uint16_t i = 0; i < pending->raw_length; i++) {
+            buf[i] = read_u16(&pending->raw[2 * i]);
+        }
+        frame.raw = buf;
+        frame.raw_length = pending->raw_length;
+    }
+
+    ir_scene_send_result_t result = e->send(&frame, e->send_ctx);
+    if (result == IR_SCENE_BUSY) {
+        return false;
+    }
+    if (result == IR_SCENE_SENT && pending->target == IR_SCENE_INLINE) {
+        e->raw_next ^= 1;
+    }
+    e->queue_head = (e->queue_head + 1) % IR_SCENE_QUEUE;
+    e->queue_count--;
+    if (result == IR_SCENE_UNSUPPORTED) {
+        e->unsupported++;
+        return false;
+    }
+    e->frames++;
+    return true;
+}
+
+ir_scene_send_result_t ir_scene_send_raw(const ir_scene_frame_t *frame, void *ctx) {
+    if (ir_send_busy()) {
+        return IR_SCENE_BUSY;
+    }
+
+    // Capturas saem direto da biblioteca compactada; sem transmissor para o
+    // alvo, o quadro é recusado em vez de travar a fila
+    switch (frame->target) {
+        case IR_SCENE_AC:
+            send_ir_command_async((ir_signal_type_t)frame->code);
+            break;
+        case IR_SCENE_CAPTURE:
+            send_captured_signal_async(frame->code);
+            break;
+        case IR_SCENE_INLINE:
+            send_raw_signal_async(frame->raw, frame->raw_length);
+            break;
+        default:
+            return IR_SCENE_UNSUPPORTED;
+    }
+    return IR_SCENE_SENT;
+}
+
+// ---------------------------------------------------------------------------
+// Gravação
+// ---------------------------------------------------------------------------
+
+int ir_scene_match_capture(const uint16_t *raw, size_t count) {
+    const ir_siglib_t *library = get_signal_library();
+
+    // Cada captura é lida em fluxo da biblioteca, sem expandir na RAM
+    for (size_t s = 0; s < library->signal_count; s++) {
+        ir_siglib_reader_t reader;
+        if (!ir_siglib_open(&reader, library, s) || ir_siglib_remaining(&reader) != count) {
+            continue;
+        }
+        size_t i = 0;
+        for (; i < count; i++) {
+            uint32_t ref = ir_siglib_next(&reader);
+            uint32_t tolerance = ref * IR_SCENE_MATCH_PCT / 100;
+            if (tolerance < IR_SCENE_MATCH_MIN_US) {
+                tolerance = IR_SCENE_MATCH_MIN_US;
+            }
+            uint32_t diff = raw[i] > ref ? raw[i] - ref : ref - raw[i];
+            if (diff > tolerance) {
+                break;
+            }
+        }
+        if (i == count) {
+            return (int)s;
+        }
+    }
+    return -1;
+}
+
+void ir_scene_record_init(ir_scene_recorder_t *r, uint8_t *out, size_t capacity) {
+    memset(r, 0, sizeof(*r));
+    r->out = out;
+    r->capacity = capacity;
+}
+
+// Reserva sempre um byte para o IR_SCENE_OP_END
+static bool emit(ir_scene_recorder_t *r, const uint8_t *bytes, size_t n) {
+    if (r->length + n + 1 > r->capacity) {
+        r->overflow = true;
+        return false;
+    }
+    memcpy(&r->out[r->length], bytes, n);
+    r->length += n;
+    return true;
+}
+
+static bool emit_wait(ir_scene_recorder_t *r, uint32_t gap_ms) {
+    while (gap_ms > UINT16_MAX) {
+        uint32_t seconds = gap_ms / 1000 > UINT16_MAX ? UINT16_MAX : gap_ms / 1000;
+        const uint8_t op[] = {IR_SCENE_WAIT_S(seconds)};
+        if (!emit(r, op, sizeof(op))) {
+            return false;
+        }
+        gap_ms -= seconds * 1000;
+    }
+    if (gap_ms > 0) {
+        const uint8_t op[] = {IR_SCENE_WAIT_MS(gap_ms)};
+        return emit(r, op, sizeof(op));
+    }
+    return true;
+}
+
+bool ir_scene_record_frame(ir_scene_recorder_t *r, const uint16_t *raw, size_t count, uint32_t time_ms) {
+    size_t rollback = r->length;
+
+    if (r->has_last && !emit_wait(r, time_ms - r->last_ms)) {
+        r->length = rollback;
+        return false;
+    }
+
+    int capture = ir_scene_match_capture(raw, count);
+    if (capture >= 0) {
+        const uint8_t op[] = {IR_SCENE_SEND(IR_SCENE_CAPTURE, capture)};
+        if (!emit(r, op, sizeof(op))) {
+            r->length = rollback;
+            return false;
+        }
+        r->matched++;
+    } else {
+        const uint8_t op[] = {IR_SCENE_OP_RAW, IR_SCENE_U16(count)};
+        if (count > IR_SCENE_MAX_RAW || r->length + sizeof(op) + 2 * count + 1 > r->capacity) {
+            r->overflow = true;
+            r->length = rollback;
+            return false;
+        }
+        emit(r, op, sizeof(op));
+        for (size_t i = 0; i < count; i++) {
+            const uint8_t t[] = {IR_SCENE_U16(raw[i])};
+            emit(r, t, sizeof(t));
+        }
+        r->inlined++;
+    }
+
+    r->last_ms = time_ms;
+    r->has_last = true;
+    return true;
+}
+
+size_t ir_scene_record_finish(ir_scene_recorder_t *r) {
+    r->out[r->length++] = IR_SCENE_OP_END;
+    return r->length;
+}
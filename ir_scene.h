@@ -0,0 +1,223 @@
+/**
+ * ir_scene.h - Cenas: sequências de comandos IR compiladas em bytecode
+ *
+ * Uma cena é um programa curto (enviar X, esperar, enviar Y para outro
+ * aparelho, repetir N vezes) codificado em bytes com as macros IR_SCENE_*,
+ * de modo que fica em flash junto com os sinais. O motor executa as cenas
+ * pela agenda de ir_scheduler.c: cada espera vira uma tarefa única e os
+ * envios entram numa fila que só transmite quando o transmissor está livre.
+ * Nada bloqueia, e várias cenas rodam ao mesmo tempo.
+ *
+ * O gravador faz o caminho inverso: recebe os quadros capturados de um
+ * controle real com seus instantes e gera a cena que reproduz a sessão,
+ * referenciando as capturas conhecidas quando o quadro confere e guardando
+ * os tempos no próprio bytecode quando não confere.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef IR_SCENE_H
+#define IR_SCENE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "ir_scheduler.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Instruções (argumentos de 16 bits em little-endian)
+#define IR_SCENE_OP_END 0x00        // Fim da cena
+#define IR_SCENE_OP_SEND 0x01       // alvo, código (16 bits)
+#define IR_SCENE_OP_WAIT 0x02       // ms (16 bits)
+#define IR_SCENE_OP_WAIT_S 0x03     // segundos (16 bits)
+#define IR_SCENE_OP_REPEAT 0x04     // vezes (8 bits; 0 = sem fim), até o NEXT correspondente
+#define IR_SCENE_OP_NEXT 0x05
+#define IR_SCENE_OP_RAW 0x06        // quantidade (16 bits) e os tempos em us (16 bits cada)
+
+// Alvos do IR_SCENE_OP_SEND
+typedef enum {
+    IR_SCENE_AC,                    // Código = ir_signal_type_t (custom_ir.h)
+    IR_SCENE_CAPTURE,               // Código = índice em get_captured_signals()
+    IR_SCENE_NEC,                   // Código = dispositivo << 8 | função
+    IR_SCENE_INLINE                 // Só no quadro entregue ao envio: tempos de IR_SCENE_OP_RAW
+} ir_scene_target_t;
+
+#define IR_SCENE_U16(v) (uint8_t)((v) & 0xFF), (uint8_t)(((v) >> 8) & 0xFF)
+// O próprio valor; não compila (vetor de tamanho negativo) se não cabe em 8 bits
+#define IR_SCENE_U8_CHECKED(v) ((v) + 0 * sizeof(char[(v) <= 0xFF ? 1 : -1]))
+
+#define IR_SCENE_SEND(target, code) IR_SCENE_OP_SEND, (uint8_t)(target), IR_SCENE_U16(code)
+#define IR_SCENE_SEND_AC(command) IR_SCENE_SEND(IR_SCENE_AC, command)
+#define IR_SCENE_SEND_NEC(device, function) \
+    IR_SCENE_SEND(IR_SCENE_NEC, (IR_SCENE_U8_CHECKED(device) << 8) | IR_SCENE_U8_CHECKED(function))
+#define IR_SCENE_WAIT_MS(ms) IR_SCENE_OP_WAIT, IR_SCENE_U16(ms)
+#define IR_SCENE_WAIT_S(s) IR_SCENE_OP_WAIT_S, IR_SCENE_U16(s)
+#define IR_SCENE_REPEAT(n) IR_SCENE_OP_REPEAT, (uint8_t)(n)
+#define IR_SCENE_NEXT IR_SCENE_OP_NEXT
+#define IR_SCENE_END IR_SCENE_OP_END
+
+#define IR_SCENE_MAX_RUNNING 4      // Cenas simultâneas
+#define IR_SCENE_MAX_DEPTH 4        // REPEAT aninhados
+#define IR_SCENE_QUEUE 8            // Envios aguardando o transmissor
+#define IR_SCENE_MAX_RAW 512        // Tempos de um quadro IR_SCENE_OP_RAW
+#define IR_SCENE_STEP_LIMIT 64      // Instruções por vez antes de ceder (laço sem espera)
+#define IR_SCENE_RETRY_MS 10        // Nova tentativa quando a fila está cheia
+
+// Quadro entregue à função de envio
+typedef struct {
+    uint8_t target;                 // ir_scene_target_t
+    uint16_t code;
+    const uint16_t *raw;            // IR_SCENE_INLINE: tempos
+    size_t raw_length;
+    uint8_t scene;                  // Cena de origem
+} ir_scene_frame_t;
+
+// Resultado da função de envio
+typedef enum {
+    IR_SCENE_SENT,
+    IR_SCENE_BUSY,                  // Transmissor ocupado: o motor tenta de novo depois
+    IR_SCENE_UNSUPPORTED            // Sem transmissor para o alvo: o quadro sai da fila e conta em unsupported
+} ir_scene_send_result_t;
+
+/**
+ * Inicia a transmissão de um quadro sem bloquear
+ */
+typedef ir_scene_send_result_t (*ir_scene_send_fn_t)(const ir_scene_frame_t *frame, void *ctx);
+
+typedef struct {
+    struct ir_scene_engine *engine;
+    const uint8_t *code;
+    size_t length;
+    size_t pc;
+    uint8_t depth;
+    uint16_t loop_start[IR_SCENE_MAX_DEPTH];
+    uint8_t loop_left[IR_SCENE_MAX_DEPTH];
+    ir_job_id_t job;
+    bool running;
+} ir_scene_t;
+
+typedef struct {
+    uint8_t scene;
+    uint8_t target;
+    uint16_t code;
+    const uint8_t *raw;             // IR_SCENE_OP_RAW: tempos ainda no bytecode
+    uint16_t raw_length;
+} ir_scene_pending_t;
+
+typedef struct ir_scene_engine {
+    ir_scheduler_t *scheduler;
+    ir_scene_send_fn_t send;
+    void *send_ctx;
+    ir_scene_t scenes[IR_SCENE_MAX_RUNNING];
+    ir_scene_pending_t queue[IR_SCENE_QUEUE];
+    uint8_t queue_head;
+    uint8_t queue_count;
+    uint16_t raw_buf[2][IR_SCENE_MAX_RAW];   // Um em transmissão, outro para o próximo quadro
+    uint8_t raw_next;
+
+    // Contadores
+    uint32_t steps;                 // Instruções executadas
+    uint32_t frames;                // Quadros entregues ao envio
+    uint32_t stalls;                // Esperas por fila cheia
+    uint32_t errors;                // Bytecode inválido (cena encerrada)
+    uint32_t unsupported;           // Quadros descartados por falta de transmissor para o alvo
+} ir_scene_engine_t;
+
+/**
+ * Prepara o motor
+ *
+ * @param scheduler Agenda usada para as esperas
+ * @param send Função de envio (ex: ir_scene_send_raw)
+ */
+void ir_scene_engine_init(ir_scene_engine_t *e, ir_scheduler_t *scheduler, ir_scene_send_fn_t send, void *ctx);
+
+/**
+ * Inicia uma cena (a primeira instrução roda no próximo advance da agenda)
+ *
+ * @param code Bytecode; precisa continuar válido enquanto a cena roda
+ * @return Índice da cena, ou -1 se não há espaço
+ */
+int ir_scene_start(ir_scene_engine_t *e, const uint8_t *code, size_t length);
+
+/**
+ * Encerra uma cena (envios já na fila ainda saem)
+ */
+bool ir_scene_stop(ir_scene_engine_t *e, int scene);
+
+bool ir_scene_running(const ir_scene_engine_t *e, int scene);
+
+/**
+ * Entrega o próximo envio da fila se o transmissor estiver livre
+ *
+ * Chamar no laço principal, depois de ir_scheduler_advance().
+ *
+ * @return true se um quadro foi entregue
+ */
+bool ir_scene_pump(ir_scene_engine_t *e);
+
+/**
+ * Função de envio para os sinais de custom_ir.c (capturas da biblioteca e
+ * sinais RAW avulsos)
+ *
+ * Quadros IR_SCENE_NEC voltam como IR_SCENE_UNSUPPORTED; quem tem
+ * transmissor NEC passa a própria função de envio.
+ */
+ir_scene_send_result_t ir_scene_send_raw(const ir_scene_frame_t *frame, void *ctx);
+
+// ---------------------------------------------------------------------------
+// Gravação de sessões
+// ---------------------------------------------------------------------------
+
+#define IR_SCENE_MATCH_PCT 25       // Tolerância por tempo para reconhecer uma captura
+#define IR_SCENE_MATCH_MIN_US 150
+
+typedef struct {
+    uint8_t *out;
+    size_t capacity;
+    size_t length;
+    uint32_t last_ms;
+    bool has_last;
+    bool overflow;                  // Faltou espaço: a cena foi truncada
+
+    // Contadores
+    uint32_t matched;               // Quadros gravados como IR_SCENE_CAPTURE
+    uint32_t inlined;               // Quadros gravados com os tempos
+} ir_scene_recorder_t;
+
+/**
+ * Prepara a gravação em out (capacity bytes)
+ */
+void ir_scene_record_init(ir_scene_recorder_t *r, uint8_t *out, size_t capacity);
+
+/**
+ * Acrescenta um quadro recebido no instante time_ms (início do quadro)
+ *
+ * @return false se não coube
+ */
+bool ir_scene_record_frame(ir_scene_recorder_t *r, const uint16_t *raw, size_t count, uint32_t time_ms);
+
+/**
+ * Fecha a cena com IR_SCENE_OP_END
+ *
+ * @return Tamanho do bytecode
+ */
+size_t ir_scene_record_finish(ir_scene_recorder_t *r);
+
+/**
+ * Captura de custom_ir.c que confere com os tempos (mesma quantidade e cada
+ * tempo dentro da tolerância)
+ *
+ * @return Índice em get_captured_signals(), ou -1
+ */
+int ir_scene_match_capture(const uint16_t *raw, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IR_SCENE_H
@@ -0,0 +1,298 @@
+/**
+ * ir_scheduler.c - Roda de temporização hierárquica para tarefas IR
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <string.h>
+
+#include "ir_scheduler.h"
+
+#define SLOT_BITS 6
+#define SLOT_MASK (IR_SCHED_SLOTS - 1)
+#define NO_JOB (-1)
+#define LEVEL_OVERFLOW IR_SCHED_LEVELS          // Além do alcance da roda
+#define LEVEL_DUE (IR_SCHED_LEVELS + 1)         // Na lista de disparo
+#define WHEEL_SPAN (1ull << (SLOT_BITS * IR_SCHED_LEVELS))
+
+static unsigned digit(uint64_t t, unsigned level) {
+    return (unsigned)(t >> (SLOT_BITS * level)) & SLOT_MASK;
+}
+
+static int lowest_bit(uint64_t bits) {
+    return __builtin_ctzll(bits);
+}
+
+// ---------------------------------------------------------------------------
+// Listas das posições
+// ---------------------------------------------------------------------------
+
+static int16_t *list_head(ir_scheduler_t *s, unsigned level, unsigned slot) {
+    return level == LEVEL_OVERFLOW ? &s->overflow : &s->slots[level][slot];
+}
+
+static void slot_push(ir_scheduler_t *s, int16_t id, unsigned level, unsigned slot) {
+    ir_job_t *job = &s->jobs[id];
+    int16_t *head = list_head(s, level, slot);
+    job->level = (uint8_t)level;
+    job->slot = (uint8_t)slot;
+    job->prev = NO_JOB;
+    job->next = *head;
+    if (job->next != NO_JOB) {
+        s->jobs[job->next].prev = id;
+    }
+    *head = id;
+    if (level < IR_SCHED_LEVELS) {
+        s->occupied[level] |= 1ull << slot;
+    }
+}
+
+static void slot_remove(ir_scheduler_t *s, int16_t id) {
+    ir_job_t *job = &s->jobs[id];
+    if (job->prev != NO_JOB) {
+        s->jobs[job->prev].next = job->next;
+    } else {
+        *list_head(s, job->level, job->slot) = job->next;
+        if (job->next == NO_JOB && job->level < IR_SCHED_LEVELS) {
+            s->occupied[job->level] &= ~(1ull << job->slot);
+        }
+    }
+    if (job->next != NO_JOB) {
+        s->jobs[job->next].prev = job->prev;
+    }
+}
+
+/**
+ * Coloca a tarefa no nível do dígito mais significativo em que o vencimento
+ * difere do tempo atual; vencida, vai para a lista de disparo
+ */
+static void place(ir_scheduler_t *s, int16_t id) {
+    ir_job_t *job = &s->jobs[id];
+    if (job->expires_ms <= s->now_ms) {
+        job->level = LEVEL_DUE;
+        job->next = s->due;
+        s->due = id;
+        return;
+    }
+    uint64_t diff = job->expires_ms ^ s->now_ms;
+    unsigned level = (unsigned)(63 - __builtin_clzll(diff)) / SLOT_BITS;
+    if (level >= IR_SCHED_LEVELS) {
+        // Recolocada quando o tempo cruzar o próximo múltiplo de WHEEL_SPAN
+        slot_push(s, id, LEVEL_OVERFLOW, 0);
+        return;
+    }
+    slot_push(s, id, level, digit(job->expires_ms, level));
+}
+
+static ir_job_id_t alloc_job(ir_scheduler_t *s, ir_job_kind_t kind, uint64_t expires_ms, uint32_t period_ms,
+                             ir_job_fn_t fn, void *ctx) {
+    if (s->free_list == NO_JOB) {
+        return -1;
+    }
+    int16_t id = s->free_list;
+    ir_job_t *job = &s->jobs[id];
+    s->free_list = job->next;
+
+    job->expires_ms = expires_ms;
+    job->period_ms = period_ms;
+    job->fn = fn;
+    job->ctx = ctx;
+    job->kind = (uint8_t)kind;
+    job->weekdays = IR_SCHED_EVERY_DAY;
+    s->active++;
+    place(s, id);
+    return id;
+}
+
+static void free_job(ir_scheduler_t *s, int16_t id) {
+    ir_job_t *job = &s->jobs[id];
+    job->kind = IR_JOB_FREE;
+    job->next = s->free_list;
+    s->free_list = id;
+    s->active--;
+}
+
+// ---------------------------------------------------------------------------
+// API
+// ---------------------------------------------------------------------------
+
+void ir_scheduler_init(ir_scheduler_t *s, uint64_t now_ms) {
+    memset(s, 0, sizeof(*s));
+    s->now_ms = now_ms;
+    memset(s->slots, 0xFF, sizeof(s->slots));
+    s->overflow = NO_JOB;
+    s->due = NO_JOB;
+    for (int i = 0; i < IR_SCHED_MAX_JOBS; i++) {
+        s->jobs[i].next = i + 1 < IR_SCHED_MAX_JOBS ? (int16_t)(i + 1) : NO_JOB;
+    }
+    s->free_list = 0;
+}
+
+void ir_scheduler_set_wall_clock(ir_scheduler_t *s, uint32_t ms_of_day, uint8_t weekday) {
+    // (now_ms + wall_offset_ms) conta ms de parede; o dia da semana sai do número do dia
+    s->wall_offset_ms = (uint32_t)((ms_of_day % IR_SCHED_DAY_MS + IR_SCHED_DAY_MS - s->now_ms % IR_SCHED_DAY_MS) %
+                                   IR_SCHED_DAY_MS);
+    uint64_t day = (s->now_ms + s->wall_offset_ms) / IR_SCHED_DAY_MS;
+    s->wall_weekday = (uint8_t)((weekday % 7 + 7 - day % 7) % 7);
+}
+
+ir_job_id_t ir_scheduler_every(ir_scheduler_t *s, uint32_t period_ms, ir_job_fn_t fn, void *ctx) {
+    if (period_ms == 0) {
+        return -1;
+    }
+    return alloc_job(s, IR_JOB_PERIODIC, s->now_ms + period_ms, period_ms, fn, ctx);
+}
+
+ir_job_id_t ir_scheduler_at(ir_scheduler_t *s, uint64_t at_ms, ir_job_fn_t fn, void *ctx) {
+    return alloc_job(s, IR_JOB_ONCE, at_ms, 0, fn, ctx);
+}
+
+ir_job_id_t ir_scheduler_daily(ir_scheduler_t *s, uint32_t ms_of_day, uint8_t weekdays, ir_job_fn_t fn,
+                               void *ctx) {
+    uint32_t now_of_day = (uint32_t)((s->now_ms + s->wall_offset_ms) % IR_SCHED_DAY_MS);
+    uint32_t wait = (ms_of_day % IR_SCHED_DAY_MS + IR_SCHED_DAY_MS - now_of_day) % IR_SCHED_DAY_MS;
+    if (wait == 0) {
+        wait = IR_SCHED_DAY_MS;
+    }
+    ir_job_id_t id = alloc_job(s, IR_JOB_DAILY, s->now_ms + wait, IR_SCHED_DAY_MS, fn, ctx);
+    if (id >= 0) {
+        s->jobs[id].weekdays = weekdays & IR_SCHED_EVERY_DAY;
+    }
+    return id;
+}
+
+bool ir_scheduler_cancel(ir_scheduler_t *s, ir_job_id_t job) {
+    if (job < 0 || job >= IR_SCHED_MAX_JOBS || s->jobs[job].kind == IR_JOB_FREE) {
+        return false;
+    }
+    if (s->jobs[job].level != LEVEL_DUE) {
+        slot_remove(s, job);
+    } else {
+        // Na lista de disparo: só marca, advance() descarta
+        s->jobs[job].fn = NULL;
+        s->jobs[job].kind = IR_JOB_ONCE;
+        return true;
+    }
+    free_job(s, job);
+    return true;
+}
+
+uint64_t ir_scheduler_next_event_ms(const ir_scheduler_t *s) {
+    if (s->due != NO_JOB) {
+        return s->now_ms;
+    }
+    // Em cada nível, a primeira posição ocupada depois do dígito atual
+    for (unsigned level = 0; level < IR_SCHED_LEVELS; level++) {
+        unsigned current = digit(s->now_ms, level);
+        uint64_t ahead = current == SLOT_MASK ? 0 : s->occupied[level] & (~0ull << (current + 1));
+        if (ahead) {
+            uint64_t span = 1ull << (SLOT_BITS * level);
+            uint64_t base = s->now_ms & ~((span << SLOT_BITS) - 1);
+            return base + (uint64_t)lowest_bit(ahead) * span;
+        }
+    }
+    return s->overflow != NO_JOB ? (s->now_ms | (WHEEL_SPAN - 1)) + 1 : IR_SCHED_NO_EVENT;
+}
+
+/**
+ * Desce as tarefas das posições que vencem em now_ms (do nível mais alto
+ * para o mais baixo); as que vencem agora vão para a lista de disparo
+ */
+static void cascade(ir_scheduler_t *s) {
+    if ((s->now_ms & (WHEEL_SPAN - 1)) == 0 && s->overflow != NO_JOB) {
+        int16_t id = s->overflow;
+        s->overflow = NO_JOB;
+        while (id != NO_JOB) {
+            int16_t next = s->jobs[id].next;
+            place(s, id);
+            id = next;
+        }
+    }
+    for (int level = IR_SCHED_LEVELS - 1; level >= 1; level--) {
+        uint64_t low = (1ull << (SLOT_BITS * level)) - 1;
+        if (s->now_ms & low) {
+            continue;
+        }
+        unsigned slot = digit(s->now_ms, level);
+        if (!(s->occupied[level] & (1ull << slot))) {
+            continue;
+        }
+        int16_t id = s->slots[level][slot];
+        s->slots[level][slot] = NO_JOB;
+        s->occupied[level] &= ~(1ull << slot);
+        while (id != NO_JOB) {
+            int16_t next = s->jobs[id].next;
+            place(s, id);
+            s->cascaded++;
+            id = next;
+        }
+    }
+    unsigned slot = digit(s->now_ms, 0);
+    if (s->occupied[0] & (1ull << slot)) {
+        int16_t id = s->slots[0][slot];
+        s->slots[0][slot] = NO_JOB;
+        s->occupied[0] &= ~(1ull << slot);
+        while (id != NO_JOB) {
+            int16_t next = s->jobs[id].next;
+            place(s, id);
+            id = next;
+        }
+    }
+}
+
+static bool weekday_allowed(const ir_scheduler_t *s, const ir_job_t *job) {
+    uint64_t day = (job->expires_ms + s->wall_offset_ms) / IR_SCHED_DAY_MS;
+    unsigned weekday = (unsigned)((s->wall_weekday + day) % 7);
+    return job->weekdays & (1u << weekday);
+}
+
+static size_t run_due(ir_scheduler_t *s) {
+    size_t count = 0;
+    while (s->due != NO_JOB) {
+        int16_t id = s->due;
+        ir_job_t *job = &s->jobs[id];
+        s->due = job->next;
+
+        uint32_t late = (uint32_t)(s->now_ms - job->expires_ms);
+        ir_job_fn_t fn = job->fn;
+        void *ctx = job->ctx;
+        bool run = fn && (job->kind != IR_JOB_DAILY || weekday_allowed(s, job));
+
+        // Reagenda antes do callback, que pode cancelar a própria tarefa
+        if (job->kind == IR_JOB_PERIODIC || job->kind == IR_JOB_DAILY) {
+            job->expires_ms += job->period_ms;
+            while (job->expires_ms <= s->now_ms) {
+                job->expires_ms += job->period_ms;
+                s->overruns++;
+            }
+            place(s, id);
+        } else {
+            free_job(s, id);
+        }
+
+        if (run) {
+            fn(s, id, late, ctx);
+            s->fired++;
+            count++;
+        }
+    }
+    return count;
+}
+
+size_t ir_scheduler_advance(ir_scheduler_t *s, uint64_t now_ms) {
+    size_t count = run_due(s);
+    while (true) {
+        uint64_t next = ir_scheduler_next_event_ms(s);
+        if (next > now_ms) {
+            break;
+        }
+        s->now_ms = next;
+        cascade(s);
+        count += run_due(s);
+    }
+    if (now_ms > s->now_ms) {
+        s->now_ms = now_ms;
+    }
+    return count;
+}
@@ -0,0 +1,151 @@
+/**
+ * ir_scheduler.h - Agenda de transmissões IR em roda de temporização hierárquica
+ *
+ * Tarefas periódicas, únicas (em um instante absoluto) e diárias (hora do dia,
+ * com filtro de dias da semana) ficam em 6 níveis de 64 posições com
+ * resolução de 1 ms. Cada tarefa fica no nível do dígito mais significativo
+ * (base 64) em que seu vencimento difere do tempo atual; ao chegar nesse
+ * dígito ela desce de nível, até disparar no nível 0. Inserir, cancelar e
+ * disparar são O(1), e ir_scheduler_next_event_ms() diz quando acordar, de
+ * modo que o laço principal dorme até o próximo evento em vez de consultar o
+ * relógio.
+ *
+ * O tempo chega por parâmetro (ms desde o boot), então a mesma agenda roda no
+ * firmware e na simulação do host.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef IR_SCHEDULER_H
+#define IR_SCHEDULER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define IR_SCHED_MAX_JOBS 512
+#define IR_SCHED_LEVELS 6                 // 64^6 ms: ~2 anos à frente
+#define IR_SCHED_SLOTS 64
+#define IR_SCHED_DAY_MS 86400000u
+#define IR_SCHED_NO_EVENT UINT64_MAX
+
+#define IR_SCHED_EVERY_DAY 0x7F           // Máscara de dias (bit 0 = domingo)
+
+typedef int16_t ir_job_id_t;              // -1 = erro
+
+typedef struct ir_scheduler ir_scheduler_t;
+
+/**
+ * Chamado quando a tarefa vence (fora de interrupção, dentro de advance)
+ *
+ * @param late_ms Atraso entre o vencimento e o disparo
+ */
+typedef void (*ir_job_fn_t)(ir_scheduler_t *s, ir_job_id_t job, uint32_t late_ms, void *ctx);
+
+typedef enum {
+    IR_JOB_FREE,
+    IR_JOB_ONCE,
+    IR_JOB_PERIODIC,
+    IR_JOB_DAILY
+} ir_job_kind_t;
+
+typedef struct {
+    uint64_t expires_ms;
+    uint32_t period_ms;
+    ir_job_fn_t fn;
+    void *ctx;
+    int16_t next;                         // Lista da posição (ou lista livre)
+    int16_t prev;
+    uint8_t level;
+    uint8_t slot;
+    uint8_t kind;
+    uint8_t weekdays;
+} ir_job_t;
+
+struct ir_scheduler {
+    uint64_t now_ms;
+    int16_t slots[IR_SCHED_LEVELS][IR_SCHED_SLOTS];
+    uint64_t occupied[IR_SCHED_LEVELS];   // Bit por posição não vazia
+    int16_t overflow;                     // Tarefas além do alcance da roda
+    ir_job_t jobs[IR_SCHED_MAX_JOBS];
+    int16_t free_list;
+    int16_t due;                          // Tarefas vencidas aguardando o callback
+
+    // Relógio de parede: (now_ms + wall_offset_ms) é o tempo de parede; wall_weekday é o dia 0
+    uint32_t wall_offset_ms;
+    uint8_t wall_weekday;
+
+    // Contadores
+    uint32_t active;
+    uint32_t fired;
+    uint32_t cascaded;                    // Tarefas que desceram de nível
+    uint32_t overruns;                    // Períodos pulados por atraso
+};
+
+/**
+ * Prepara a agenda vazia
+ *
+ * @param now_ms Tempo atual (ms desde o boot)
+ */
+void ir_scheduler_init(ir_scheduler_t *s, uint64_t now_ms);
+
+/**
+ * Ajusta o relógio de parede usado pelas tarefas diárias
+ *
+ * @param ms_of_day Hora atual do dia, em ms desde a meia-noite
+ * @param weekday Dia da semana atual (0 = domingo)
+ */
+void ir_scheduler_set_wall_clock(ir_scheduler_t *s, uint32_t ms_of_day, uint8_t weekday);
+
+/**
+ * Tarefa periódica; o primeiro disparo é em now + period_ms
+ *
+ * @return Identificador da tarefa, ou -1 se a agenda estiver cheia
+ */
+ir_job_id_t ir_scheduler_every(ir_scheduler_t *s, uint32_t period_ms, ir_job_fn_t fn, void *ctx);
+
+/**
+ * Tarefa única em um instante absoluto (ms desde o boot; no passado dispara
+ * no próximo advance)
+ */
+ir_job_id_t ir_scheduler_at(ir_scheduler_t *s, uint64_t at_ms, ir_job_fn_t fn, void *ctx);
+
+/**
+ * Tarefa diária na hora indicada, nos dias da máscara weekdays
+ *
+ * @param ms_of_day Hora do disparo em ms desde a meia-noite
+ * @param weekdays Máscara de dias (bit 0 = domingo; IR_SCHED_EVERY_DAY = todos)
+ */
+ir_job_id_t ir_scheduler_daily(ir_scheduler_t *s, uint32_t ms_of_day, uint8_t weekdays, ir_job_fn_t fn,
+                               void *ctx);
+
+/**
+ * Remove uma tarefa (pode ser chamada dentro do callback)
+ *
+ * @return false se o identificador não corresponde a uma tarefa ativa
+ */
+bool ir_scheduler_cancel(ir_scheduler_t *s, ir_job_id_t job);
+
+/**
+ * Avança a agenda até now_ms e executa os callbacks das tarefas vencidas
+ *
+ * @return Quantidade de callbacks executados
+ */
+size_t ir_scheduler_advance(ir_scheduler_t *s, uint64_t now_ms);
+
+/**
+ * Próximo instante em que a agenda precisa de advance (disparo ou descida de
+ * nível), ou IR_SCHED_NO_EVENT se estiver vazia
+ */
+uint64_t ir_scheduler_next_event_ms(const ir_scheduler_t *s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IR_SCHEDULER_H
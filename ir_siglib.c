@@ -0,0 +1,372 @@
+/**
+ * ir_siglib.c - Leitura em fluxo e empacotador da biblioteca compactada
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "ir_siglib.h"
+
+#define SHORT_RESIDUE 10                // Maior zigzag do resíduo curto
+#define CLUSTER_GAP_PCT 15              // Salto entre valores ordenados que abre um novo nível
+#define ALIGN_WINDOW 16                 // Tempos conferidos antes de deslocar o quadro base
+#define ALIGN_MAX_SHIFT 8
+#define RUN_MAX 16
+
+enum {
+    TOKEN_LONG = 0xB,
+    TOKEN_RUN = 0xC,
+    TOKEN_LEVEL = 0xD,
+    TOKEN_SHIFT = 0xE,
+    TOKEN_LITERAL = 0xF
+};
+
+static inline uint8_t nibble_at(const uint8_t *p, uint32_t n) {
+    return (p[n >> 1] >> ((n & 1) * 4)) & 0xF;
+}
+
+static inline int32_t unzigzag(uint32_t z) {
+    return (int32_t)(z >> 1) ^ -(int32_t)(z & 1);
+}
+
+static inline uint32_t zigzag(int32_t v) {
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+// ---------------------------------------------------------------------------
+// Leitura
+// ---------------------------------------------------------------------------
+
+static inline uint8_t read_nibble(ir_siglib_reader_t *r) {
+    return nibble_at(r->data, r->nibble++);
+}
+
+static inline uint8_t read_byte(ir_siglib_reader_t *r) {
+    uint8_t lo = read_nibble(r);
+    return lo | read_nibble(r) << 4;
+}
+
+static inline uint8_t base_level(const ir_siglib_reader_t *r) {
+    return r->base < r->lib->base_length ? nibble_at(r->lib->base, r->base) : 0;
+}
+
+static inline uint16_t level_value(const ir_siglib_t *lib, uint8_t level, uint32_t zz) {
+    return (uint16_t)(lib->levels[level] + unzigzag(zz) * lib->quantum_us);
+}
+
+bool ir_siglib_open(ir_siglib_reader_t *r, const ir_siglib_t *lib, size_t index) {
+    if (index >= lib->signal_count) {
+        return false;
+    }
+    r->lib = lib;
+    r->data = lib->data + lib->signals[index].offset;
+    r->nibble = 0;
+    r->base = 0;
+    r->remaining = lib->signals[index].length;
+    r->run = 0;
+    return true;
+}
+
+uint16_t ir_siglib_next(ir_siglib_reader_t *r) {
+    if (r->remaining == 0) {
+        return 0;
+    }
+    r->remaining--;
+
+    const ir_siglib_t *lib = r->lib;
+    uint16_t v;
+    if (r->run > 0) {
+        r->run--;
+        v = lib->levels[base_level(r)];
+    } else {
+        uint8_t t = read_nibble(r);
+        while (t == TOKEN_SHIFT) {
+            r->base = (uint16_t)(r->base + (int8_t)read_byte(r));
+            t = read_nibble(r);
+        }
+        if (t <= SHORT_RESIDUE) {
+            v = level_value(lib, base_level(r), t);
+        } else if (t == TOKEN_LONG) {
+            v = level_value(lib, base_level(r), read_byte(r));
+        } else if (t == TOKEN_RUN) {
+            r->run = read_nibble(r);
+            v = lib->levels[base_level(r)];
+        } else if (t == TOKEN_LEVEL) {
+            uint8_t level = read_nibble(r);
+            v = level_value(lib, level, read_nibble(r));
+        } else {
+            v = read_byte(r);
+            v |= (uint16_t)read_byte(r) << 8;
+        }
+    }
+    r->base++;
+    return v;
+}
+
+size_t ir_siglib_unpack(const ir_siglib_t *lib, size_t index, uint16_t *out, size_t max) {
+    ir_siglib_reader_t r;
+    if (!ir_siglib_open(&r, lib, index)) {
+        return 0;
+    }
+    size_t n = 0;
+    while (n < max && ir_siglib_remaining(&r) > 0) {
+        out[n++] = ir_siglib_next(&r);
+    }
+    return n;
+}
+
+int ir_siglib_find(const ir_siglib_t *lib, const char *name) {
+    for (size_t i = 0; i < lib->signal_count; i++) {
+        if (strcmp(lib->signals[i].name, name) == 0) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+size_t ir_siglib_size(const ir_siglib_t *lib) {
+    return lib->level_count * sizeof(uint16_t) + (lib->base_length + 1u) / 2 + lib->data_size +
+           lib->signal_count * 2 * sizeof(uint16_t);
+}
+
+// ---------------------------------------------------------------------------
+// Empacotador
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    ir_siglib_builder_t *b;
+    uint32_t nibble;
+    bool overflow;
+} writer_t;
+
+static void put(writer_t *w, uint8_t v) {
+    if (w->nibble >= 2u * IR_SIGLIB_MAX_DATA) {
+        w->overflow = true;
+        return;
+    }
+    uint8_t *p = &w->b->data[w->nibble >> 1];
+    *p = (w->nibble & 1) ? (uint8_t)(*p | v << 4) : v;
+    w->nibble++;
+}
+
+static void put_byte(writer_t *w, uint8_t v) {
+    put(w, v & 0xF);
+    put(w, v >> 4);
+}
+
+static int compare_u16(const void *a, const void *b) {
+    return (int)*(const uint16_t *)a - (int)*(const uint16_t *)b;
+}
+
+/**
+ * Níveis de marcas (parity 0) ou de espaços (parity 1): agrupa os valores
+ * ordenados, abrindo um grupo a cada salto maior que CLUSTER_GAP_PCT, e usa a
+ * média de cada grupo
+ */
+static bool find_levels(ir_siglib_builder_t *b, const ir_siglib_input_t *signals, size_t count, int parity) {
+    size_t total = 0;
+    for (size_t s = 0; s < count; s++) {
+        total += signals[s].length;
+    }
+    uint16_t *sorted = malloc(total * sizeof(uint16_t));
+    if (!sorted) {
+        return false;
+    }
+    size_t n = 0;
+    for (size_t s = 0; s < count; s++) {
+        for (size_t i = parity; i < signals[s].length; i += 2) {
+            sorted[n++] = signals[s].data[i];
+        }
+    }
+    qsort(sorted, n, sizeof(uint16_t), compare_u16);
+
+    uint32_t sum = 0;
+    uint32_t members = 0;
+    for (size_t i = 0; i <= n; i++) {
+        if ((i == n && members > 0) ||
+            (i < n && members > 0 && sorted[i] > sorted[i - 1] + sorted[i - 1] * CLUSTER_GAP_PCT / 100)) {
+            if (b->lib.level_count == IR_SIGLIB_MAX_LEVELS) {
+                free(sorted);
+                return false;
+            }
+            if (parity == 0) {
+                b->mark_levels |= 1u << b->lib.level_count;
+            }
+            b->levels[b->lib.level_count++] = (uint16_t)((sum + members / 2) / members);
+            sum = 0;
+            members = 0;
+        }
+        if (i < n) {
+            sum += sorted[i];
+            members++;
+        }
+    }
+    free(sorted);
+    return true;
+}
+
+// Nível mais próximo entre os de marcas (i par) ou de espaços (i ímpar)
+static uint8_t nearest_level(const ir_siglib_builder_t *b, const ir_siglib_input_t *sig, size_t i) {
+    uint16_t v = sig->data[i];
+    bool mark = (i & 1) == 0;
+    int best = -1;
+    for (int l = 0; l < b->lib.level_count; l++) {
+        if (((b->mark_levels >> l) & 1) == mark &&
+            (best < 0 || abs((int)v - b->levels[l]) < abs((int)v - b->levels[best]))) {
+            best = l;
+        }
+    }
+    return (uint8_t)best;
+}
+
+static uint8_t base_at(const ir_siglib_builder_t *b, int32_t pos) {
+    return pos >= 0 && pos < b->lib.base_length ? nibble_at(b->base, (uint32_t)pos) : 0xFF;
+}
+
+/**
+ * Resíduo em passos de quantum sobre o nível (false se o valor resultante
+ * não cabe em 16 bits)
+ */
+static bool residue(const ir_siglib_builder_t *b, uint16_t v, uint8_t level, int32_t *q) {
+    uint8_t step = b->lib.quantum_us;
+    int32_t d = (int32_t)v - b->levels[level];
+    *q = step == 0 ? 0 : d >= 0 ? (d + step / 2) / step : -((-d + step / 2) / step);
+    int32_t out = b->levels[level] + *q * step;
+    return out > 0 && out <= UINT16_MAX;
+}
+
+// Os próximos tempos de sig a partir de i seguem o quadro base a partir de pos
+static bool window_matches(const ir_siglib_builder_t *b, const ir_siglib_input_t *sig, size_t i, int32_t pos) {
+    for (size_t k = 0; k < ALIGN_WINDOW && i + k < sig->length; k++) {
+        if (base_at(b, pos + (int32_t)k) != nearest_level(b, sig, i + k)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void encode_signal(writer_t *w, const ir_siglib_input_t *sig) {
+    const ir_siglib_builder_t *b = w->b;
+    int32_t pos = 0;
+    size_t i = 0;
+
+    while (i < sig->length) {
+        uint16_t v = sig->data[i];
+        uint8_t level = nearest_level(b, sig, i);
+        bool on_base = base_at(b, pos) == level;
+
+        // Fora do quadro base e sem voltar a ele logo depois: tenta realinhar
+        if (!on_base && !window_matches(b, sig, i + 1, pos + 1)) {
+            for (int32_t shift = 1; shift <= ALIGN_MAX_SHIFT && !on_base; shift++) {
+                for (int32_t d = shift; d >= -shift; d -= 2 * shift) {
+                    if (pos + d >= 0 && window_matches(b, sig, i, pos + d)) {
+                        put(w, TOKEN_SHIFT);
+                        put_byte(w, (uint8_t)(int8_t)d);
+                        pos += d;
+                        on_base = true;
+                        break;
+                    }
+                }
+            }
+        }
+
+        int32_t q;
+        uint32_t zz = residue(b, v, level, &q) ? zigzag(q) : UINT32_MAX;
+        if (on_base && zz == 0) {
+            size_t run = 1;
+            int32_t rq;
+            while (run < RUN_MAX && i + run < sig->length) {
+                uint8_t next_level = nearest_level(b, sig, i + run);
+                if (base_at(b, pos + (int32_t)run) != next_level || !residue(b, sig->data[i + run], next_level, &rq) ||
+                    rq != 0) {
+                    break;
+                }
+                run++;
+            }
+            if (run > 1) {
+                put(w, TOKEN_RUN);
+                put(w, (uint8_t)(run - 1));
+                i += run;
+                pos += (int32_t)run;
+                continue;
+            }
+        }
+
+        if (on_base && zz <= SHORT_RESIDUE) {
+            put(w, (uint8_t)zz);
+        } else if (on_base && zz <= UINT8_MAX) {
+            put(w, TOKEN_LONG);
+            put_byte(w, (uint8_t)zz);
+        } else if (!on_base && zz <= 0xF) {
+            put(w, TOKEN_LEVEL);
+            put(w, level);
+            put(w, (uint8_t)zz);
+        } else {
+            put(w, TOKEN_LITERAL);
+            put_byte(w, (uint8_t)v);
+            put_byte(w, (uint8_t)(v >> 8));
+        }
+        i++;
+        pos++;
+    }
+}
+
+bool ir_siglib_pack(ir_siglib_builder_t *b, const ir_siglib_input_t *signals, size_t count, uint8_t quantum_us) {
+    memset(b, 0, sizeof(*b));
+    if (count == 0 || count > IR_SIGLIB_MAX_SIGNALS) {
+        return false;
+    }
+    b->lib.quantum_us = quantum_us;
+    b->lib.levels = b->levels;
+    b->lib.base = b->base;
+    b->lib.signals = b->entries;
+    b->lib.data = b->data;
+    b->lib.signal_count = (uint16_t)count;
+
+    size_t base_length = 0;
+    for (size_t s = 0; s < count; s++) {
+        if (signals[s].length > UINT16_MAX) {
+            return false;
+        }
+        if (signals[s].length > base_length) {
+            base_length = signals[s].length;
+        }
+    }
+    if (base_length > IR_SIGLIB_MAX_BASE || !find_levels(b, signals, count, 0) ||
+        !find_levels(b, signals, count, 1)) {
+        return false;
+    }
+
+    // Quadro base: o nível mais comum em cada posição
+    b->lib.base_length = (uint16_t)base_length;
+    for (size_t i = 0; i < base_length; i++) {
+        uint16_t votes[IR_SIGLIB_MAX_LEVELS] = {0};
+        uint8_t best = 0;
+        for (size_t s = 0; s < count; s++) {
+            if (i < signals[s].length) {
+                uint8_t level = nearest_level(b, &signals[s], i);
+                if (++votes[level] > votes[best]) {
+                    best = level;
+                }
+            }
+        }
+        b->base[i / 2] |= (uint8_t)(best << ((i & 1) * 4));
+    }
+
+    writer_t w = {.b = b};
+    for (size_t s = 0; s < count; s++) {
+        w.nibble = (w.nibble + 1) & ~1u;    // Cada sinal começa em um byte
+        b->entries[s].name = signals[s].name;
+        b->entries[s].offset = (uint16_t)(w.nibble / 2);
+        b->entries[s].length = (uint16_t)signals[s].length;
+        encode_signal(&w, &signals[s]);
+    }
+    if (w.overflow) {
+        return false;
+    }
+    b->lib.data_size = (uint16_t)((w.nibble + 1) / 2);
+    return true;
+}
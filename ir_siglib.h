@@ -0,0 +1,143 @@
+/**
+ * ir_siglib.h - Biblioteca de sinais RAW compactada
+ *
+ * As capturas do Philco repetem o mesmo cabeçalho (~3600/1760 us) e longos
+ * trechos de campos iguais, e cada tempo é só um valor nominal mais o ruído
+ * da captura. A biblioteca guarda isso separado:
+ *
+ *  - níveis: as durações nominais da biblioteca (até IR_SIGLIB_MAX_LEVELS);
+ *  - quadro base: o nível de cada posição do quadro (o mais comum entre os
+ *    sinais), guardado uma vez só, em nibbles;
+ *  - sinais: para cada tempo, só a diferença em relação ao quadro base, em
+ *    um fluxo de nibbles (LSB primeiro):
+ *
+ *    0x0 a 0xA     resíduo curto (zigzag 0 a 10) sobre o nível do quadro base
+ *    0xB z z       resíduo longo (zigzag 8 bits)
+ *    0xC n         n + 1 tempos seguidos iguais ao quadro base, sem resíduo
+ *    0xD s z       nível s no lugar do quadro base, resíduo curto z (zigzag 4 bits)
+ *    0xE d d       desloca a posição no quadro base em d (8 bits com sinal),
+ *                  sem emitir tempo (marca perdida ou a mais na captura)
+ *    0xF v v v v   tempo literal de 16 bits
+ *
+ * O tempo é nível + resíduo * quantum_us: com quantum 1 a biblioteca é exata,
+ * com quantum q o erro fica em até q / 2 us, e com quantum 0 só os níveis são
+ * guardados (sinal limpo). Cada sinal é lido em uma passada, um tempo por
+ * chamada de ir_siglib_next(), sem tabela intermediária em RAM: o envio
+ * assíncrono de custom_ir.c lê o próximo tempo dentro do próprio alarme.
+ *
+ * O empacotador (ir_siglib_pack) roda no host e produz as tabelas que vão
+ * para o código do firmware.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef IR_SIGLIB_H
+#define IR_SIGLIB_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define IR_SIGLIB_MAX_LEVELS 16         // Um nibble por nível
+#define IR_SIGLIB_MAX_BASE 512          // Tempos do quadro base (empacotador)
+#define IR_SIGLIB_MAX_SIGNALS 64        // Sinais por biblioteca (empacotador)
+#define IR_SIGLIB_MAX_DATA 16384        // Bytes dos fluxos (empacotador)
+
+// Sinal da biblioteca: fluxo a partir de data[offset]
+typedef struct {
+    const char *name;
+    uint16_t offset;
+    uint16_t length;                    // Tempos
+} ir_siglib_entry_t;
+
+typedef struct {
+    uint8_t quantum_us;                 // Passo do resíduo (0 = só os níveis)
+    uint8_t level_count;
+    const uint16_t *levels;
+    uint16_t base_length;
+    const uint8_t *base;                // Nível de cada posição, 2 por byte
+    uint16_t signal_count;
+    const ir_siglib_entry_t *signals;
+    uint16_t data_size;
+    const uint8_t *data;
+} ir_siglib_t;
+
+// Leitura de um sinal em andamento
+typedef struct {
+    const ir_siglib_t *lib;
+    const uint8_t *data;
+    uint32_t nibble;                    // Próximo nibble do fluxo
+    uint16_t base;                      // Posição no quadro base
+    uint16_t remaining;                 // Tempos que faltam
+    uint8_t run;                        // Tempos que faltam de uma sequência 0xC
+} ir_siglib_reader_t;
+
+/**
+ * Posiciona a leitura no início de um sinal
+ *
+ * @return false se o índice não existe
+ */
+bool ir_siglib_open(ir_siglib_reader_t *r, const ir_siglib_t *lib, size_t index);
+
+/**
+ * Próximo tempo do sinal (us), ou 0 no fim
+ */
+uint16_t ir_siglib_next(ir_siglib_reader_t *r);
+
+static inline uint16_t ir_siglib_remaining(const ir_siglib_reader_t *r) {
+    return r->remaining;
+}
+
+/**
+ * Expande um sinal inteiro
+ *
+ * @return Tempos escritos em out (no máximo max)
+ */
+size_t ir_siglib_unpack(const ir_siglib_t *lib, size_t index, uint16_t *out, size_t max);
+
+/**
+ * Índice do sinal com o nome dado, ou -1
+ */
+int ir_siglib_find(const ir_siglib_t *lib, const char *name);
+
+/**
+ * Bytes de flash das tabelas (níveis, quadro base, fluxos e índice, sem os
+ * nomes)
+ */
+size_t ir_siglib_size(const ir_siglib_t *lib);
+
+// Sinal de entrada do empacotador
+typedef struct {
+    const char *name;
+    const uint16_t *data;
+    size_t length;
+} ir_siglib_input_t;
+
+// Biblioteca montada pelo empacotador (lib aponta para os vetores abaixo)
+typedef struct {
+    ir_siglib_t lib;
+    uint16_t levels[IR_SIGLIB_MAX_LEVELS];
+    uint16_t mark_levels;               // Níveis vindos das marcas (bit por nível)
+    uint8_t base[IR_SIGLIB_MAX_BASE / 2];
+    ir_siglib_entry_t entries[IR_SIGLIB_MAX_SIGNALS];
+    uint8_t data[IR_SIGLIB_MAX_DATA];
+} ir_siglib_builder_t;
+
+/**
+ * Empacota os sinais (host)
+ *
+ * @param quantum_us Passo do resíduo (1 = exato, 0 = só os níveis)
+ * @return false se os sinais não cabem nos limites acima
+ */
+bool ir_siglib_pack(ir_siglib_builder_t *b, const ir_siglib_input_t *signals, size_t count, uint8_t quantum_us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IR_SIGLIB_H
@@ -0,0 +1,213 @@
+/**
+ * ir_txcheck.c - Demodulação das bordas registradas e comparação com os tempos
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "ir_txcheck.h"
+
+#define ERROR_HIST_FIRST_US -64
+#define ERROR_HIST_WIDTH_US 8
+#define DRIFT_HIST_FIRST_US -512
+#define DRIFT_HIST_WIDTH_US 64
+
+void ir_txcheck_recorder_init(ir_txcheck_recorder_t *r, uint32_t *buffer, size_t capacity) {
+    r->edges = buffer;
+    r->capacity = capacity;
+    r->count = 0;
+    r->dropped = 0;
+}
+
+static void hist_init(ir_txcheck_hist_t *h, int32_t first_us, uint16_t width_us) {
+    memset(h, 0, sizeof(*h));
+    h->first_us = first_us;
+    h->width_us = width_us;
+}
+
+static void hist_add(ir_txcheck_hist_t *h, int32_t value) {
+    if (value < h->first_us) {
+        h->under++;
+        return;
+    }
+    uint32_t bin = (uint32_t)(value - h->first_us) / h->width_us;
+    if (bin >= IR_TXCHECK_BINS) {
+        h->over++;
+    } else {
+        h->bins[bin]++;
+    }
+}
+
+static uint32_t edge_time(uint32_t e) {
+    return e >> 1;
+}
+
+static bool edge_level(uint32_t e) {
+    return e & 1u;
+}
+
+// Diferença entre dois tempos do registro (31 bits, com volta do contador)
+static uint32_t elapsed(uint32_t from, uint32_t to) {
+    return (to - from) & 0x7FFFFFFFu;
+}
+
+// Estado da comparação, tempo a tempo
+typedef struct {
+    ir_txcheck_report_t *report;
+    const uint16_t *intended;
+    size_t length;
+    size_t index;                       // Tempos medidos até agora
+    uint32_t first_edge;
+    uint32_t previous_end;
+    int64_t intended_elapsed;
+    int64_t error_sum;
+    uint64_t error_abs_sum;
+    int32_t drift_abs_max;
+} compare_t;
+
+/**
+ * Um tempo medido (marca ou espaço) terminou em end_us
+ */
+static void compare_timing(compare_t *c, uint32_t end_us) {
+    ir_txcheck_report_t *r = c->report;
+
+    if (c->index < c->length) {
+        int32_t actual = (int32_t)elapsed(c->previous_end, end_us);
+        int32_t error = actual - (int32_t)c->intended[c->index];
+        int32_t drift = (int32_t)((int64_t)elapsed(c->first_edge, c->previous_end) - c->intended_elapsed);
+
+        hist_add(&r->error_hist, error);
+        hist_add(&r->drift_hist, drift);
+        if (error < r->error_min_us) {
+            r->error_min_us = error;
+        }
+        if (error > r->error_max_us) {
+            r->error_max_us = error;
+        }
+        c->error_sum += error;
+        c->error_abs_sum += error < 0 ? -error : error;
+        if (error >= -IR_TXCHECK_TOLERANCE_US && error <= IR_TXCHECK_TOLERANCE_US) {
+            r->within_tolerance++;
+        }
+
+        int32_t drift_abs = drift < 0 ? -drift : drift;
+        if (drift_abs > c->drift_abs_max) {
+            c->drift_abs_max = drift_abs;
+            r->drift_max_us = drift;
+        }
+        c->intended_elapsed += c->intended[c->index];
+    }
+    c->index++;
+    c->previous_end = end_us;
+}
+
+bool ir_txcheck_analyze(const uint32_t *edges, size_t count, const uint16_t *intended, size_t length,
+                        uint32_t demod_gap_us, ir_txcheck_report_t *report) {
+    if (demod_gap_us == 0) {
+        demod_gap_us = IR_TXCHECK_DEMOD_GAP_US;
+    }
+    memset(report, 0, sizeof(*report));
+    report->intended = length;
+    report->error_min_us = INT32_MAX;
+    report->error_max_us = INT32_MIN;
+    hist_init(&report->error_hist, ERROR_HIST_FIRST_US, ERROR_HIST_WIDTH_US);
+    hist_init(&report->drift_hist, DRIFT_HIST_FIRST_US, DRIFT_HIST_WIDTH_US);
+
+    compare_t c = {.report = report, .intended = intended, .length = length, .drift_abs_max = -1};
+    bool started = false;
+    uint32_t last_rise = 0;
+    uint32_t last_fall = 0;
+    uint64_t period_sum = 0;
+    uint64_t high_sum = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        uint32_t t = edge_time(edges[i]);
+        if (!edge_level(edges[i])) {
+            last_fall = t;
+            continue;
+        }
+        if (!started) {
+            // Primeira subida: início da transmissão
+            started = true;
+            c.first_edge = c.previous_end = t;
+        } else if (elapsed(last_fall, t) > demod_gap_us) {
+            // Pausa longa: a marca terminou na última descida e o espaço agora
+            compare_timing(&c, last_fall);
+            compare_timing(&c, t);
+        } else {
+            // Ciclo do carrier: subida a subida, com o tempo alto no meio
+            period_sum += elapsed(last_rise, t);
+            high_sum += elapsed(last_rise, last_fall);
+            report->carrier_cycles++;
+        }
+        last_rise = t;
+    }
+    if (!started) {
+        report->error_min_us = report->error_max_us = 0;
+        return false;
+    }
+    compare_timing(&c, last_fall);
+
+    size_t compared = c.index < length ? c.index : length;
+    report->measured = c.index;
+    if (compared > 0) {
+        report->error_mean_us = (float)c.error_sum / compared;
+        report->error_abs_mean_us = (float)c.error_abs_sum / compared;
+    } else {
+        report->error_min_us = report->error_max_us = 0;
+    }
+    report->drift_final_us = (int32_t)((int64_t)elapsed(c.first_edge, c.previous_end) - c.intended_elapsed);
+    if (report->carrier_cycles > 0) {
+        report->carrier_hz = 1e6f * report->carrier_cycles / (float)period_sum;
+        report->duty_pct = 100.0f * (float)high_sum / (float)period_sum;
+    }
+    return true;
+}
+
+static void print_hist(const char *title, const ir_txcheck_hist_t *h) {
+    uint32_t peak = h->under > h->over ? h->under : h->over;
+    for (int i = 0; i < IR_TXCHECK_BINS; i++) {
+        if (h->bins[i] > peak) {
+            peak = h->bins[i];
+        }
+    }
+    printf("%s\n", title);
+    if (h->under) {
+        printf("  %6s < %5ld us |%lu\n", "", (long)h->first_us, (unsigned long)h->under);
+    }
+    for (int i = 0; i < IR_TXCHECK_BINS; i++) {
+        if (h->bins[i] == 0) {
+            continue;
+        }
+        long lo = (long)h->first_us + (long)i * h->width_us;
+        int bar = peak ? (int)(40u * h->bins[i] / peak) : 0;
+        printf("  %6ld .. %5ld us |%.*s %lu\n", lo, lo + h->width_us - 1, bar,
+               "########################################", (unsigned long)h->bins[i]);
+    }
+    if (h->over) {
+        printf("  %6s >= %5ld us |%lu\n", "",
+               (long)h->first_us + (long)IR_TXCHECK_BINS * h->width_us, (unsigned long)h->over);
+    }
+}
+
+void ir_txcheck_print(const ir_txcheck_report_t *r) {
+    printf("\n=== Fidelidade da transmissão ===\n");
+    printf("Tempos: %u pretendidos, %u medidos%s\n", (unsigned)r->intended, (unsigned)r->measured,
+           r->intended == r->measured ? "" : " (DIFERENTE)");
+    printf("Erro por tempo: min %ld us, máx %ld us, médio %.1f us, |médio| %.1f us\n",
+           (long)r->error_min_us, (long)r->error_max_us, r->error_mean_us, r->error_abs_mean_us);
+    printf("Dentro de %d us: %u de %u\n", IR_TXCHECK_TOLERANCE_US, (unsigned)r->within_tolerance,
+           (unsigned)(r->measured < r->intended ? r->measured : r->intended));
+    printf("Deriva: máx %ld us, final %ld us\n", (long)r->drift_max_us, (long)r->drift_final_us);
+    if (r->carrier_cycles > 0) {
+        printf("Carrier: %.0f Hz, duty %.1f%% (%lu ciclos)\n", r->carrier_hz, r->duty_pct,
+               (unsigned long)r->carrier_cycles);
+    } else {
+        printf("Carrier: não medido (bordas só do envelope)\n");
+    }
+    print_hist("Histograma do erro por tempo:", &r->error_hist);
+    print_hist("Histograma da deriva:", &r->drift_hist);
+}
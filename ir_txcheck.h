@@ -0,0 +1,113 @@
+/**
+ * ir_txcheck.h - Fidelidade de tempo das transmissões IR
+ *
+ * Compara as bordas que realmente saíram no pino do LED com o array de
+ * tempos que se pretendia transmitir. As bordas vêm de um registro (a
+ * interrupção de GPIO no próprio pino de TX, no firmware, ou o hook de bordas
+ * do shim, no host). O analisador demodula o carrier: uma marca vai da
+ * primeira subida até a última descida de uma rajada, e pausas menores que
+ * demod_gap_us são ciclos do carrier, não espaços. Com carrier, a marca
+ * medida termina na última descida, então sai cerca de meio período mais
+ * curta que o envelope. Motores que só ligam e desligam o PWM aparecem como
+ * um pulso por marca e ficam sem medição de carrier.
+ *
+ * O relatório traz o erro de cada tempo, a deriva acumulada (início de cada
+ * tempo em relação ao início pretendido), frequência e duty do carrier, e
+ * histogramas de erro e deriva.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef IR_TXCHECK_H
+#define IR_TXCHECK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define IR_TXCHECK_BINS 16
+#define IR_TXCHECK_DEMOD_GAP_US 100     // ~4 períodos de 38 kHz
+#define IR_TXCHECK_TOLERANCE_US 5       // Erro considerado fiel
+
+// Histograma de faixas fixas: [first + i * width, first + (i + 1) * width)
+typedef struct {
+    int32_t first_us;
+    uint16_t width_us;
+    uint32_t bins[IR_TXCHECK_BINS];
+    uint32_t under;
+    uint32_t over;
+} ir_txcheck_hist_t;
+
+typedef struct {
+    size_t intended;                    // Tempos pretendidos
+    size_t measured;                    // Tempos demodulados das bordas
+    int32_t error_min_us;
+    int32_t error_max_us;
+    float error_mean_us;
+    float error_abs_mean_us;
+    size_t within_tolerance;            // Tempos com |erro| <= IR_TXCHECK_TOLERANCE_US
+    int32_t drift_max_us;               // Maior deriva em módulo (com sinal)
+    int32_t drift_final_us;             // Duração total medida - pretendida
+
+    // Carrier (0 quando as bordas são só o envelope)
+    uint32_t carrier_cycles;
+    float carrier_hz;
+    float duty_pct;
+
+    ir_txcheck_hist_t error_hist;       // Erro por tempo
+    ir_txcheck_hist_t drift_hist;       // Deriva no início de cada tempo
+} ir_txcheck_report_t;
+
+// Registro de bordas: tempo em us << 1 | nível
+typedef struct {
+    uint32_t *edges;
+    size_t capacity;
+    volatile size_t count;
+    volatile uint32_t dropped;
+} ir_txcheck_recorder_t;
+
+void ir_txcheck_recorder_init(ir_txcheck_recorder_t *r, uint32_t *buffer, size_t capacity);
+
+/**
+ * Registra uma borda (chamar da interrupção de GPIO do pino de TX)
+ */
+static inline void ir_txcheck_record(ir_txcheck_recorder_t *r, bool level, uint32_t time_us) {
+    if (r->count < r->capacity) {
+        r->edges[r->count] = (time_us << 1) | (level ? 1u : 0u);
+        r->count++;
+    } else {
+        r->dropped++;
+    }
+}
+
+static inline void ir_txcheck_recorder_clear(ir_txcheck_recorder_t *r) {
+    r->count = 0;
+    r->dropped = 0;
+}
+
+/**
+ * Analisa as bordas registradas contra os tempos pretendidos
+ *
+ * @param edges Bordas no formato do registro, em ordem
+ * @param intended Tempos pretendidos (marca, espaço, marca, ...)
+ * @param demod_gap_us Pausa máxima dentro de uma marca (0 = IR_TXCHECK_DEMOD_GAP_US)
+ * @return false se não há nenhuma marca nas bordas
+ */
+bool ir_txcheck_analyze(const uint32_t *edges, size_t count, const uint16_t *intended, size_t length,
+                        uint32_t demod_gap_us, ir_txcheck_report_t *report);
+
+/**
+ * Imprime o relatório com os histogramas em barras de texto
+ */
+void ir_txcheck_print(const ir_txcheck_report_t *report);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IR_TXCHECK_H
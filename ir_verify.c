@@ -0,0 +1,135 @@
+/**
+ * ir_verify.c - Espera pelo retorno, repetição e estatísticas de entrega
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <string.h>
+
+#include "ir_verify.h"
+
+static uint32_t next_random(ir_verify_t *v) {
+    uint32_t x = v->seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    v->seed = x;
+    return x;
+}
+
+static ir_verify_stats_t *command_stats(ir_verify_t *v) {
+    return &v->commands[v->command < IR_VERIFY_COMMANDS ? v->command : IR_VERIFY_UNLISTED];
+}
+
+/**
+ * Coloca o quadro no ar e abre a espera pelo retorno
+ */
+static bool transmit(ir_verify_t *v, uint64_t now_us) {
+    if (!v->send(v->frame, v->ctx)) {
+        return false;
+    }
+    v->attempt++;
+    command_stats(v)->attempts++;
+    v->channels[v->channel].attempts++;
+    v->state = IR_VERIFY_WAITING;
+    v->deadline_us = now_us + v->frame_us + IR_VERIFY_TIMEOUT_US;
+    return true;
+}
+
+static void finish(ir_verify_t *v, ir_verify_result_t result, uint64_t now_us) {
+    ir_verify_stats_t *cmd = command_stats(v);
+    ir_verify_stats_t *ch = &v->channels[v->channel];
+
+    if (result == IR_VERIFY_DELIVERED) {
+        cmd->delivered++;
+        ch->delivered++;
+        if (v->attempt == 1) {
+            cmd->first_try++;
+            ch->first_try++;
+        }
+        v->last_latency_us = now_us - v->requested_us;
+    } else {
+        cmd->failed++;
+        ch->failed++;
+    }
+    v->last_attempts = v->attempt;
+    v->result = result;
+    v->state = IR_VERIFY_IDLE;
+}
+
+void ir_verify_init(ir_verify_t *v, ir_verify_send_t send, void *ctx, uint8_t max_attempts) {
+    memset(v, 0, sizeof(*v));
+    v->send = send;
+    v->ctx = ctx;
+    v->max_attempts = max_attempts ? max_attempts : IR_VERIFY_ATTEMPTS;
+    v->seed = 0x2545F491u;
+}
+
+bool ir_verify_send(ir_verify_t *v, uint32_t frame, uint32_t frame_us, uint16_t command, uint8_t channel,
+                    uint64_t now_us) {
+    if (v->state != IR_VERIFY_IDLE || channel >= IR_VERIFY_CHANNELS) {
+        return false;
+    }
+    v->frame = frame;
+    v->frame_us = frame_us;
+    v->command = command;
+    v->channel = channel;
+    v->attempt = 0;
+    v->requested_us = now_us;
+    v->result = IR_VERIFY_NONE;
+
+    if (!transmit(v, now_us)) {
+        return false;
+    }
+    command_stats(v)->requests++;
+    v->channels[channel].requests++;
+    return true;
+}
+
+bool ir_verify_on_rx(ir_verify_t *v, uint32_t frame, uint64_t now_us) {
+    if (frame != v->frame || v->attempt == 0) {
+        return false;
+    }
+    if (v->state == IR_VERIFY_WAITING) {
+        finish(v, IR_VERIFY_DELIVERED, now_us);
+        return true;
+    }
+    // Retorno de uma tentativa já dada como perdida
+    if (v->state == IR_VERIFY_BACKOFF) {
+        v->late_echoes++;
+        finish(v, IR_VERIFY_DELIVERED, now_us);
+        return true;
+    }
+    return false;
+}
+
+ir_verify_result_t ir_verify_poll(ir_verify_t *v, uint64_t now_us) {
+    if (v->state != IR_VERIFY_IDLE && now_us >= v->deadline_us) {
+        if (v->state == IR_VERIFY_BACKOFF) {
+            if (!transmit(v, now_us)) {
+                v->deadline_us = now_us + IR_VERIFY_BACKOFF_US; // Transmissor ocupado: tenta depois
+            }
+        } else if (v->attempt >= v->max_attempts) {
+            finish(v, IR_VERIFY_FAILED, now_us);
+        } else {
+            // Espera dobrada a cada tentativa (até IR_VERIFY_BACKOFF_DOUBLINGS:
+            // max_attempts vai a 255), mais até uma espera base aleatória
+            uint8_t doublings = v->attempt - 1;
+            if (doublings > IR_VERIFY_BACKOFF_DOUBLINGS) {
+                doublings = IR_VERIFY_BACKOFF_DOUBLINGS;
+            }
+            uint32_t wait = (IR_VERIFY_BACKOFF_US << doublings) + next_random(v) % IR_VERIFY_BACKOFF_US;
+            v->state = IR_VERIFY_BACKOFF;
+            v->deadline_us = now_us + wait;
+        }
+    }
+
+    ir_verify_result_t result = v->result;
+    v->result = IR_VERIFY_NONE;
+    return result;
+}
+
+uint8_t ir_verify_success_pct(const ir_verify_stats_t *s) {
+    return s->requests ? (uint8_t)(s->delivered * 100u / s->requests) : 100;
+}
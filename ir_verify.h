@@ -0,0 +1,136 @@
+/**
+ * ir_verify.h - Envio verificado pelo receptor ao lado do LED
+ *
+ * Com o receptor IR apontado para o próprio LED (Philco.c: RX no GPIO 15), o
+ * quadro enviado volta decodificado pelo RX. Aqui cada envio espera por esse
+ * retorno até um prazo (duração do quadro + IR_VERIFY_TIMEOUT_US); sem ele, o
+ * quadro é repetido depois de uma espera que dobra a cada tentativa (com uma
+ * parcela aleatória, para não repetir em sincronia com outra fonte que esteja
+ * ocupando o ar), até max_attempts.
+ *
+ * Cada envio conta nas estatísticas do comando (índice na tabela de
+ * ir_commands.c) e do canal (LED/transmissor usado): pedidos, entregues,
+ * entregues de primeira, transmissões e desistências.
+ *
+ * Nada aqui acessa o hardware: o quadro sai pela função de envio dada, os
+ * quadros recebidos chegam por ir_verify_on_rx() e os tempos por parâmetro,
+ * então o mesmo código roda no firmware e com um canal simulado no host.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef IR_VERIFY_H
+#define IR_VERIFY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define IR_VERIFY_COMMANDS 32           // Comandos com estatística própria
+#define IR_VERIFY_UNLISTED IR_VERIFY_COMMANDS // Envios fora da tabela (raw, protocol)
+#define IR_VERIFY_CHANNELS 4
+#define IR_VERIFY_ATTEMPTS 4            // Padrão de tentativas por envio
+#define IR_VERIFY_TIMEOUT_US 30000      // Espera após o fim do quadro (receptor + leitura do FIFO)
+#define IR_VERIFY_BACKOFF_US 25000      // Espera antes da primeira repetição
+#define IR_VERIFY_BACKOFF_DOUBLINGS 6   // A espera para de dobrar aqui (25 ms << 6 = 1,6 s)
+
+// Transmite um quadro (false se o transmissor não aceitou)
+typedef bool (*ir_verify_send_t)(uint32_t frame, void *ctx);
+
+typedef enum {
+    IR_VERIFY_IDLE,
+    IR_VERIFY_WAITING,                  // Quadro no ar, aguardando o retorno
+    IR_VERIFY_BACKOFF                   // Sem retorno, aguardando para repetir
+} ir_verify_state_t;
+
+typedef enum {
+    IR_VERIFY_NONE,                     // Nada terminou nesta chamada
+    IR_VERIFY_DELIVERED,
+    IR_VERIFY_FAILED
+} ir_verify_result_t;
+
+typedef struct {
+    uint32_t requests;
+    uint32_t delivered;
+    uint32_t first_try;                 // Entregues sem repetição
+    uint32_t attempts;                  // Transmissões, contando as repetições
+    uint32_t failed;
+} ir_verify_stats_t;
+
+typedef struct {
+    ir_verify_send_t send;
+    void *ctx;
+    uint8_t max_attempts;
+    uint32_t seed;                      // Parcela aleatória da espera
+
+    // Envio em andamento
+    ir_verify_state_t state;
+    uint32_t frame;
+    uint32_t frame_us;
+    uint16_t command;
+    uint8_t channel;
+    uint8_t attempt;                    // Tentativas feitas
+    uint64_t requested_us;
+    uint64_t deadline_us;               // Fim da espera pelo retorno ou da espera para repetir
+    ir_verify_result_t result;          // Resultado a entregar em ir_verify_poll()
+
+    // Último envio terminado
+    uint8_t last_attempts;
+    uint64_t last_latency_us;           // Do pedido até a confirmação
+
+    ir_verify_stats_t commands[IR_VERIFY_COMMANDS + 1];
+    ir_verify_stats_t channels[IR_VERIFY_CHANNELS];
+    uint32_t late_echoes;               // Retornos que chegaram depois do prazo
+} ir_verify_t;
+
+/**
+ * Prepara o envio verificado
+ *
+ * @param send Função que coloca um quadro no transmissor
+ * @param max_attempts Tentativas por envio (0 = IR_VERIFY_ATTEMPTS)
+ */
+void ir_verify_init(ir_verify_t *v, ir_verify_send_t send, void *ctx, uint8_t max_attempts);
+
+/**
+ * Inicia um envio verificado
+ *
+ * @param frame_us Duração do quadro no ar
+ * @param command Índice do comando (IR_VERIFY_UNLISTED fora da tabela)
+ * @param channel Canal de transmissão (< IR_VERIFY_CHANNELS)
+ * @return false se já há um envio em andamento ou o transmissor recusou
+ */
+bool ir_verify_send(ir_verify_t *v, uint32_t frame, uint32_t frame_us, uint16_t command, uint8_t channel,
+                    uint64_t now_us);
+
+/**
+ * Entrega um quadro decodificado pelo receptor
+ *
+ * @return true se era o retorno do envio em andamento
+ */
+bool ir_verify_on_rx(ir_verify_t *v, uint32_t frame, uint64_t now_us);
+
+/**
+ * Confere prazos e repete quando preciso (chamar no laço principal)
+ *
+ * @return Resultado do envio que terminou desde a última chamada
+ */
+ir_verify_result_t ir_verify_poll(ir_verify_t *v, uint64_t now_us);
+
+static inline bool ir_verify_busy(const ir_verify_t *v) {
+    return v->state != IR_VERIFY_IDLE;
+}
+
+/**
+ * Porcentagem de envios entregues (100 sem envios)
+ */
+uint8_t ir_verify_success_pct(const ir_verify_stats_t *s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IR_VERIFY_H
@@ -5,9 +5,12 @@
  */
 
 // SDK types and declarations
+#include <string.h>
 #include "pico/stdlib.h"
 #include "hardware/pio.h"
 #include "hardware/clocks.h"    // for clock_get_hz()
+#include "hardware/dma.h"
+#include "hardware/timer.h"     // for timer_hw
 
 #include "nec_receive.h"
 
@@ -77,3 +80,91 @@ bool nec_decode_frame(uint32_t frame, uint8_t *p_address, uint8_t *p_data) {
 
     return true;
 }
+
+
+// Claim two DMA channels and start moving frames from the RX FIFO of the
+// given state machine into the ring of `stream`. The frame channel copies one
+// word when the FIFO has data and then triggers the timestamp channel, which
+// copies the timer and triggers the frame channel again.
+//
+// Returns: `true` on success, `false` if two DMA channels were not available
+bool nec_rx_stream_init(nec_rx_stream_t *stream, PIO pio, uint sm) {
+
+    memset(stream, 0, sizeof(*stream));
+    stream->frame_chan = dma_claim_unused_channel(false);
+    stream->stamp_chan = dma_claim_unused_channel(false);
+    if (stream->frame_chan < 0 || stream->stamp_chan < 0) {
+        // give back the one channel that was claimed, if any
+        if (stream->frame_chan >= 0) {
+            dma_channel_unclaim(stream->frame_chan);
+        }
+        if (stream->stamp_chan >= 0) {
+            dma_channel_unclaim(stream->stamp_chan);
+        }
+        return false;
+    }
+
+    // the timestamp channel waits to be triggered by the frame channel
+    //
+    dma_channel_config c = dma_channel_get_default_config(stream->stamp_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, true);
+    channel_config_set_ring(&c, true, NEC_RX_RING_BITS);
+    channel_config_set_chain_to(&c, stream->frame_chan);
+    dma_channel_configure(stream->stamp_chan, &c, stream->stamps, &timer_hw->timerawl, 1, false);
+
+    // the frame channel is paced by the RX FIFO and starts right away
+    //
+    c = dma_channel_get_default_config(stream->frame_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, true);
+    channel_config_set_ring(&c, true, NEC_RX_RING_BITS);
+    channel_config_set_dreq(&c, pio_get_dreq(pio, sm, false));
+    channel_config_set_chain_to(&c, stream->stamp_chan);
+    dma_channel_configure(stream->frame_chan, &c, stream->frames, &pio->rxf[sm], 1, true);
+
+    return true;
+}
+
+
+// Fetch the oldest unread frame from the ring without blocking.
+//
+// Returns: `true` if an event was stored, `false` if the ring is empty
+bool nec_rx_stream_next(nec_rx_stream_t *stream, nec_rx_event_t *event) {
+
+    // the timestamp is written last, so its write address marks complete entries
+    //
+    uintptr_t write_addr = dma_channel_hw_addr(stream->stamp_chan)->write_addr;
+    uint32_t written = (uint32_t)(write_addr - (uintptr_t)stream->stamps) / sizeof(uint32_t);
+
+    // before the DMA can overwrite an unread entry it has to overwrite the one
+    // we read last: if that timestamp changed, keep the newest frames
+    //
+    uint32_t previous = (stream->read_index + NEC_RX_RING_FRAMES - 1) % NEC_RX_RING_FRAMES;
+    if (stream->stamps[previous] != stream->last_stamp) {
+        stream->overflows++;
+        stream->read_index = (written + 1) % NEC_RX_RING_FRAMES;
+        stream->last_stamp = stream->stamps[written];
+    }
+
+    if (stream->read_index == written) {
+        return false;
+    }
+
+    uint32_t stamp = stream->stamps[stream->read_index];
+    event->frame = stream->frames[stream->read_index];
+    stream->read_index = (stream->read_index + 1) % NEC_RX_RING_FRAMES;
+    stream->last_stamp = stamp;
+
+    // widen the 32-bit timestamp using the current 64-bit time
+    //
+    uint64_t now = time_us_64();
+    event->time_us = now - (uint32_t)((uint32_t)now - stamp);
+
+    event->address = 0;
+    event->data = 0;
+    event->valid = nec_decode_frame(event->frame, &event->address, &event->data);
+    return true;
+}
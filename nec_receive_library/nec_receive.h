@@ -11,3 +11,35 @@
 
 int nec_rx_init(PIO pio, uint pin);
 bool nec_decode_frame(uint32_t sm, uint8_t *p_address, uint8_t *p_data);
+
+// optional DMA frame ring
+//
+// Two chained DMA channels move every frame from the RX FIFO into a RAM ring
+// together with the value of the microsecond timer at that moment, so frames
+// are neither lost nor delayed while the main loop is busy. The ring holds
+// NEC_RX_RING_FRAMES - 1 unread frames (about 6 seconds of back-to-back
+// frames); beyond that the oldest ones are dropped and `overflows` counts it.
+
+#define NEC_RX_RING_BITS 8                                      // 2^8 bytes per ring
+#define NEC_RX_RING_FRAMES ((1u << NEC_RX_RING_BITS) / sizeof(uint32_t))
+
+typedef struct {
+    uint32_t frame;                 // the 32-bit frame as pushed by the state machine
+    uint64_t time_us;               // when the frame left the RX FIFO (just after its last bit)
+    bool valid;                     // nec_decode_frame() accepted the frame
+    uint8_t address;
+    uint8_t data;
+} nec_rx_event_t;
+
+typedef struct {
+    uint32_t frames[NEC_RX_RING_FRAMES] __attribute__((aligned(1u << NEC_RX_RING_BITS)));
+    uint32_t stamps[NEC_RX_RING_FRAMES] __attribute__((aligned(1u << NEC_RX_RING_BITS)));
+    int frame_chan;
+    int stamp_chan;
+    uint32_t read_index;            // next entry to read
+    uint32_t last_stamp;            // timestamp of the entry before `read_index`
+    uint32_t overflows;             // times the DMA overwrote unread frames
+} nec_rx_stream_t;
+
+bool nec_rx_stream_init(nec_rx_stream_t *stream, PIO pio, uint sm);
+bool nec_rx_stream_next(nec_rx_stream_t *stream, nec_rx_event_t *event);
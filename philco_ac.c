@@ -0,0 +1,454 @@
+/**
+ * philco_ac.c - Quadro do ar condicionado Philco e decodificador tolerante a ruído
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "philco_ac.h"
+
+#define GLITCH_MARK_US (PHILCO_AC_BIT_MARK / 3)   // Marcas menores que isso são sempre glitch
+#define SHORT_MARK_US (PHILCO_AC_BIT_MARK / 2)    // Marcas menores que isso podem ser glitch
+#define MAX_SPACES (PHILCO_AC_FRAME_BITS + 16)     // Espaços lidos por cópia
+#define MAX_BITS_PER_SPACE 3                       // Bits cabíveis em um espaço composto
+#define MARGINAL_CONFIDENCE 64                     // Só bits abaixo disso podem ser corrigidos
+#define MAX_CANDIDATES 6                           // Bits marginais avaliados na correção
+#define MAX_FLIPS 3                                // Máximo de bits invertidos por quadro
+
+// Bytes fixos do início do quadro
+static const uint8_t frame_signature[] = {0x23, 0xCB, 0x26, 0x01, 0x00};
+
+// Espaços de uma cópia do quadro, já sem o cabeçalho
+typedef struct {
+    int32_t spaces[MAX_SPACES];
+    size_t count;
+    int32_t zero_space;      // Centro do agrupamento de espaços curtos
+    int32_t one_space;       // Centro do agrupamento de espaços longos
+    int32_t bit_mark;        // Marca média
+} frame_spaces_t;
+
+// Melhor hipótese de um espaço como vários bits com marcas perdidas no meio
+typedef struct {
+    int32_t gain;            // Quanto ajusta melhor que um bit único (< 0 = pior)
+    uint8_t bits;
+    uint8_t ones;
+    int8_t conf;
+} space_fit_t;
+
+uint8_t philco_ac_checksum(const uint8_t *bytes) {
+    uint8_t sum = 0;
+    for (int i = 0; i < PHILCO_AC_FRAME_BYTES - 1; i++) {
+        sum += bytes[i];
+    }
+    return sum;
+}
+
+bool philco_ac_frame_ok(const uint8_t *bytes) {
+    return memcmp(bytes, frame_signature, sizeof(frame_signature)) == 0 &&
+           bytes[PHILCO_AC_FRAME_BYTES - 1] == philco_ac_checksum(bytes);
+}
+
+bool philco_ac_check_timings(const uint16_t *raw, size_t count) {
+    if (count < 3 + 2 * PHILCO_AC_FRAME_BITS) {
+        return false;
+    }
+    uint8_t bytes[PHILCO_AC_FRAME_BYTES] = {0};
+    for (int i = 0; i < PHILCO_AC_FRAME_BITS; i++) {
+        if (raw[3 + 2 * i] * 2 > PHILCO_AC_ZERO_SPACE + PHILCO_AC_ONE_SPACE) {
+            bytes[i / 8] |= 1 << (i % 8);
+        }
+    }
+    return philco_ac_frame_ok(bytes);
+}
+
+/**
+ * Monta os bytes a partir do sinal de cada bit (LSB primeiro)
+ */
+static void pack_bits(philco_ac_frame_t *frame) {
+    memset(frame->bytes, 0, sizeof(frame->bytes));
+    for (int i = 0; i < PHILCO_AC_FRAME_BITS; i++) {
+        if (frame->soft[i] > 0) {
+            frame->bytes[i / 8] |= 1 << (i % 8);
+        }
+    }
+}
+
+/**
+ * Confiança (0 a 127) de uma escolha com erro err_best contra a alternativa err_other
+ */
+static int8_t confidence(int32_t err_best, int32_t err_other) {
+    int32_t total = err_best + err_other;
+    return total > 0 ? (int8_t)(127 * (err_other - err_best) / total) : 0;
+}
+
+/**
+ * Distância de um espaço até o tempo de bit nominal mais próximo
+ */
+static int32_t grid_error(int32_t space) {
+    int32_t d0 = abs(space - PHILCO_AC_ZERO_SPACE);
+    int32_t d1 = abs(space - PHILCO_AC_ONE_SPACE);
+    return d0 < d1 ? d0 : d1;
+}
+
+/**
+ * Marca curta que dividiu um espaço ao meio
+ *
+ * Abaixo de GLITCH_MARK_US é sempre glitch. Até SHORT_MARK_US pode ser uma
+ * marca real com jitter, e só é descartada se os dois espaços somados ficarem
+ * mais perto de um tempo de bit do que cada um separado. No modo estrito
+ * toda marca é aceita.
+ */
+static bool is_glitch(int32_t space, uint16_t mark, uint16_t next_space, bool in_header, bool strict) {
+    if (strict) {
+        return false;
+    }
+    if (mark < GLITCH_MARK_US) {
+        return true;
+    }
+    if (mark >= SHORT_MARK_US || in_header) {
+        return false;
+    }
+    return grid_error(space + mark + next_space) < grid_error(space) + grid_error(next_space);
+}
+
+/**
+ * Lê uma cópia do quadro a partir da marca de cabeçalho seguinte a *pos
+ *
+ * Marcas de glitch são somadas ao espaço em volta. A leitura termina em
+ * um silêncio longo, em outra marca de cabeçalho ou no fim do sinal.
+ */
+static bool collect_frame(const uint16_t *raw, size_t count, size_t *pos, bool strict, frame_spaces_t *out) {
+    size_t i = *pos;
+    uint32_t mark_sum = 0;
+    uint32_t mark_count = 0;
+    int32_t header_space = -1;
+
+    // Procura a marca do cabeçalho (marcas nos índices pares)
+    while (i + 1 < count && raw[i] < PHILCO_AC_HDR_MARK / 2) {
+        i += 2;
+    }
+    if (i + 1 >= count) {
+        *pos = count;
+        return false;
+    }
+
+    out->count = 0;
+    i++;
+
+    while (i < count) {
+        int32_t space = raw[i++];
+        while (i + 1 < count && is_glitch(space, raw[i], raw[i + 1], header_space < 0, strict)) {
+            space += raw[i] + raw[i + 1];
+            i += 2;
+        }
+        if (space >= PHILCO_AC_FRAME_GAP) {
+            break;
+        }
+        if (header_space < 0) {
+            header_space = space;
+        } else if (out->count < MAX_SPACES) {
+            out->spaces[out->count++] = space;
+        }
+        if (i >= count || raw[i] >= PHILCO_AC_HDR_MARK / 2) {
+            break;
+        }
+        mark_sum += raw[i++];
+        mark_count++;
+    }
+    *pos = i;
+
+    out->bit_mark = mark_count ? (int32_t)(mark_sum / mark_count) : PHILCO_AC_BIT_MARK;
+    out->zero_space = PHILCO_AC_ZERO_SPACE;
+    out->one_space = PHILCO_AC_ONE_SPACE;
+
+    // Agrupamentos dos espaços curtos e longos deste quadro (k-means com k = 2)
+    for (int iter = 0; iter < 3; iter++) {
+        int32_t limit = 2 * out->one_space - out->zero_space;
+        int32_t sum[2] = {0, 0};
+        int32_t n[2] = {0, 0};
+        for (size_t s = 0; s < out->count; s++) {
+            int32_t space = out->spaces[s];
+            if (space >= limit) {
+                continue;
+            }
+            int c = abs(space - out->one_space) < abs(space - out->zero_space);
+            sum[c] += space;
+            n[c]++;
+        }
+        if (n[0] > 0) {
+            out->zero_space = sum[0] / n[0];
+        }
+        if (n[1] > 0) {
+            out->one_space = sum[1] / n[1];
+        }
+    }
+
+    // Espaço do cabeçalho grande demais: a marca do primeiro bit se perdeu
+    int32_t extra = header_space - PHILCO_AC_HDR_SPACE - out->bit_mark;
+    if (extra > out->zero_space / 2 && out->count < MAX_SPACES) {
+        memmove(&out->spaces[1], &out->spaces[0], out->count * sizeof(out->spaces[0]));
+        out->spaces[0] = extra;
+        out->count++;
+    }
+    return true;
+}
+
+/**
+ * Compara o espaço como bit único com a melhor hipótese de 2 ou mais bits
+ */
+static void fit_space(const frame_spaces_t *f, int32_t space, space_fit_t *fit) {
+    int32_t single_err = abs(space - f->zero_space);
+    if (abs(space - f->one_space) < single_err) {
+        single_err = abs(space - f->one_space);
+    }
+
+    int32_t best_err = INT32_MAX;
+    for (int k = 2; k <= MAX_BITS_PER_SPACE; k++) {
+        for (int ones = 0; ones <= k; ones++) {
+            int32_t expected = ones * f->one_space + (k - ones) * f->zero_space + (k - 1) * f->bit_mark;
+            int32_t err = abs(space - expected);
+            if (err < best_err) {
+                best_err = err;
+                fit->bits = (uint8_t)k;
+                fit->ones = (uint8_t)ones;
+            }
+        }
+    }
+    fit->gain = single_err - best_err;
+    fit->conf = confidence(best_err, single_err);
+}
+
+static void put_bit(philco_ac_frame_t *frame, int8_t soft) {
+    if (frame->bit_count < PHILCO_AC_FRAME_BITS) {
+        frame->soft[frame->bit_count++] = soft;
+    }
+}
+
+/**
+ * Converte os espaços de uma cópia em bits
+ *
+ * Cada espaço vira um bit com confiança pela distância aos agrupamentos. Se
+ * faltarem bits para completar o quadro, os espaços que melhor se ajustam a
+ * vários bits são expandidos; um par 0/1 assim tem ordem desconhecida e fica
+ * registrado em swaps para a correção decidir.
+ */
+static void decode_frame(const frame_spaces_t *in, philco_ac_frame_t *frame) {
+    bool expand[MAX_SPACES] = {false};
+    int32_t missing = PHILCO_AC_FRAME_BITS - (int32_t)in->count;
+    space_fit_t fit;
+
+    memset(frame, 0, sizeof(*frame));
+    frame->copies = 1;
+
+    while (missing > 0) {
+        int32_t best_gain = 0;
+        size_t best = in->count;
+        for (size_t s = 0; s < in->count; s++) {
+            if (expand[s]) {
+                continue;
+            }
+            fit_space(in, in->spaces[s], &fit);
+            if (fit.gain > best_gain) {
+                best_gain = fit.gain;
+                best = s;
+            }
+        }
+        if (best == in->count) {
+            break;
+        }
+        fit_space(in, in->spaces[best], &fit);
+        expand[best] = true;
+        missing -= fit.bits - 1;
+    }
+
+    for (size_t s = 0; s < in->count; s++) {
+        int32_t space = in->spaces[s];
+        if (!expand[s]) {
+            int32_t d0 = abs(space - in->zero_space);
+            int32_t d1 = abs(space - in->one_space);
+            put_bit(frame, d1 < d0 ? confidence(d1, d0) : -confidence(d0, d1));
+            continue;
+        }
+
+        fit_space(in, space, &fit);
+        if (fit.ones == 1 && fit.bits == 2 && frame->swap_count < PHILCO_AC_MAX_SWAPS &&
+            frame->bit_count + 1 < PHILCO_AC_FRAME_BITS) {
+            frame->swaps[frame->swap_count++] = frame->bit_count;
+        }
+        for (int b = 0; b < fit.bits; b++) {
+            if (fit.ones == 0 || fit.ones == fit.bits) {
+                put_bit(frame, fit.ones ? fit.conf : -fit.conf);
+            } else {
+                put_bit(frame, b < fit.ones ? 1 : -1);
+            }
+        }
+    }
+
+    // Bits faltando no fim ficam com confiança zero
+    pack_bits(frame);
+    frame->valid = philco_ac_frame_ok(frame->bytes);
+}
+
+size_t philco_ac_soft_decode(const uint16_t *raw, size_t count, philco_ac_frame_t *copies, size_t max_copies) {
+    frame_spaces_t spaces;
+    size_t pos = 0;
+    size_t found = 0;
+
+    while (found < max_copies) {
+        // Com exatamente um espaço por bit o quadro não tem glitch: aceita todas as marcas
+        size_t start = pos;
+        if (!collect_frame(raw, count, &pos, true, &spaces)) {
+            break;
+        }
+        if (spaces.count != PHILCO_AC_FRAME_BITS) {
+            pos = start;
+            collect_frame(raw, count, &pos, false, &spaces);
+        }
+        decode_frame(&spaces, &copies[found]);
+        // Ignora rajadas curtas de ruído
+        if (copies[found].bit_count >= 8) {
+            found++;
+        }
+    }
+    return found;
+}
+
+/**
+ * Corrige o quadro pela combinação de menor custo (soma das confianças) que
+ * torne assinatura e checksum válidos, invertendo bits marginais e trocando a
+ * ordem dos pares 0/1 vindos de marcas perdidas
+ */
+static bool correct_frame(philco_ac_frame_t *frame) {
+    if (philco_ac_frame_ok(frame->bytes)) {
+        return true;
+    }
+
+    // Cada candidato inverte 1 bit ou um par de bits
+    uint8_t first[MAX_CANDIDATES + PHILCO_AC_MAX_SWAPS];
+    uint8_t width[MAX_CANDIDATES + PHILCO_AC_MAX_SWAPS];
+    int32_t costs[MAX_CANDIDATES + PHILCO_AC_MAX_SWAPS];
+    int n = 0;
+
+    // Bits marginais em ordem crescente de confiança
+    for (int i = 0; i < PHILCO_AC_FRAME_BITS; i++) {
+        int32_t conf = abs(frame->soft[i]);
+        if (conf >= MARGINAL_CONFIDENCE || (n == MAX_CANDIDATES && conf >= costs[n - 1])) {
+            continue;
+        }
+        int j = n < MAX_CANDIDATES ? n++ : n - 1;
+        while (j > 0 && costs[j - 1] > conf) {
+            first[j] = first[j - 1];
+            costs[j] = costs[j - 1];
+            j--;
+        }
+        first[j] = (uint8_t)i;
+        costs[j] = conf;
+    }
+    int singles = n;
+    for (int i = 0; i < singles; i++) {
+        width[i] = 1;
+    }
+
+    // Pares que ainda estão com bits diferentes
+    for (int s = 0; s < frame->swap_count; s++) {
+        uint8_t bit = frame->swaps[s];
+        if ((frame->soft[bit] > 0) != (frame->soft[bit + 1] > 0)) {
+            first[n] = bit;
+            width[n] = 2;
+            costs[n] = abs(frame->soft[bit]) + abs(frame->soft[bit + 1]);
+            n++;
+        }
+    }
+
+    uint32_t best_mask = 0;
+    int32_t best_cost = INT32_MAX;
+    uint8_t bytes[PHILCO_AC_FRAME_BYTES];
+
+    for (uint32_t mask = 1; mask < (1u << n); mask++) {
+        int flips = 0;
+        int32_t cost = 0;
+        memcpy(bytes, frame->bytes, sizeof(bytes));
+        for (int c = 0; c < n; c++) {
+            if (mask & (1u << c)) {
+                flips += c < singles;
+                cost += costs[c];
+                for (int b = first[c]; b < first[c] + width[c]; b++) {
+                    bytes[b / 8] ^= 1 << (b % 8);
+                }
+            }
+        }
+        if (flips <= MAX_FLIPS && cost < best_cost && philco_ac_frame_ok(bytes)) {
+            best_mask = mask;
+            best_cost = cost;
+        }
+    }
+
+    if (best_mask == 0) {
+        return false;
+    }
+
+    for (int c = 0; c < n; c++) {
+        if (best_mask & (1u << c)) {
+            for (int b = first[c]; b < first[c] + width[c]; b++) {
+                frame->soft[b] = frame->soft[b] > 0 ? -1 : 1;
+                frame->corrected_bits++;
+            }
+        }
+    }
+    pack_bits(frame);
+    return true;
+}
+
+bool philco_ac_combine(const philco_ac_frame_t *copies, size_t count, philco_ac_frame_t *out) {
+    memset(out, 0, sizeof(*out));
+
+    for (size_t c = 0; c < count; c++) {
+        // Cópias com bits faltando demais estão desalinhadas e não votam
+        if (copies[c].bit_count + MAX_FLIPS < PHILCO_AC_FRAME_BITS) {
+            continue;
+        }
+        out->copies++;
+        if (copies[c].bit_count > out->bit_count) {
+            out->bit_count = copies[c].bit_count;
+        }
+        for (int s = 0; s < copies[c].swap_count && out->swap_count < PHILCO_AC_MAX_SWAPS; s++) {
+            if (memchr(out->swaps, copies[c].swaps[s], out->swap_count) == NULL) {
+                out->swaps[out->swap_count++] = copies[c].swaps[s];
+            }
+        }
+    }
+    if (out->copies == 0) {
+        return false;
+    }
+
+    for (int i = 0; i < PHILCO_AC_FRAME_BITS; i++) {
+        int32_t sum = 0;
+        for (size_t c = 0; c < count; c++) {
+            if (copies[c].bit_count + MAX_FLIPS >= PHILCO_AC_FRAME_BITS) {
+                sum += copies[c].soft[i];
+            }
+        }
+        out->soft[i] = (int8_t)(sum > 127 ? 127 : (sum < -127 ? -127 : sum));
+    }
+
+    pack_bits(out);
+    out->valid = correct_frame(out);
+    return out->valid;
+}
+
+bool philco_ac_decode(const uint16_t *raw, size_t count, philco_ac_frame_t *out) {
+    philco_ac_frame_t copies[PHILCO_AC_MAX_COPIES];
+    size_t found = philco_ac_soft_decode(raw, count, copies, PHILCO_AC_MAX_COPIES);
+
+    if (philco_ac_combine(copies, found, out)) {
+        return true;
+    }
+
+    // A votação falhou: tenta cada cópia sozinha
+    for (size_t c = 0; c < found && found > 1; c++) {
+        if (philco_ac_combine(&copies[c], 1, out)) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,104 @@
+/**
+ * philco_ac.h - Quadro do ar condicionado Philco e decodificador tolerante a ruído
+ *
+ * O controle envia 14 bytes (112 bits, LSB primeiro) em distância de pulso:
+ * cabeçalho de ~3600/1750 us e bits com marca de ~420 us seguida de um espaço
+ * curto (0) ou longo (1). O último byte é a soma dos 13 anteriores.
+ *
+ * O decodificador atribui a cada bit uma confiança proporcional à distância do
+ * espaço medido até os dois agrupamentos (curto/longo) do próprio quadro.
+ * Marcas muito curtas são tratadas como glitch e, quando faltam bits para
+ * completar o quadro, os espaços que melhor se ajustam a mais de um bit (marca
+ * perdida) são expandidos. Bits marginais são corrigidos usando o
+ * checksum e, quando o controle repete o quadro, as cópias são combinadas por
+ * votação ponderada pela confiança.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef PHILCO_AC_H
+#define PHILCO_AC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Temporização nominal (us)
+#define PHILCO_AC_HDR_MARK 3600
+#define PHILCO_AC_HDR_SPACE 1750
+#define PHILCO_AC_BIT_MARK 420
+#define PHILCO_AC_ZERO_SPACE 350
+#define PHILCO_AC_ONE_SPACE 1300
+#define PHILCO_AC_FRAME_GAP 5000     // Silêncio mínimo entre cópias do quadro
+
+#define PHILCO_AC_FRAME_BYTES 14
+#define PHILCO_AC_FRAME_BITS (PHILCO_AC_FRAME_BYTES * 8)
+#define PHILCO_AC_MAX_COPIES 4       // Cópias consideradas na votação
+#define PHILCO_AC_MAX_SWAPS 6        // Pares de bits com ordem desconhecida por quadro
+
+// Quadro decodificado
+typedef struct {
+    uint8_t bytes[PHILCO_AC_FRAME_BYTES];
+    int8_t soft[PHILCO_AC_FRAME_BITS];   // > 0 = bit 1, <= 0 = bit 0; módulo = confiança (0 a 127)
+    uint8_t bit_count;                   // Bits recuperados do sinal
+    uint8_t corrected_bits;              // Bits invertidos pela correção via checksum
+    uint8_t copies;                      // Cópias combinadas
+    uint8_t swaps[PHILCO_AC_MAX_SWAPS];  // Primeiro bit de cada par 0/1 de ordem desconhecida (marca perdida)
+    uint8_t swap_count;
+    bool valid;                          // Assinatura e checksum conferem
+} philco_ac_frame_t;
+
+/**
+ * Checksum do quadro (soma dos bytes 0 a 12)
+ */
+uint8_t philco_ac_checksum(const uint8_t *bytes);
+
+/**
+ * Confere assinatura fixa (bytes 0 a 4) e checksum
+ */
+bool philco_ac_frame_ok(const uint8_t *bytes);
+
+/**
+ * Confere um quadro em tempos já na grade (cabeçalho, bits e marca final),
+ * sem tolerância a ruído: é a conferência do reparo de ir_capture_repair()
+ */
+bool philco_ac_check_timings(const uint16_t *raw, size_t count);
+
+/**
+ * Decodifica cada cópia do quadro presente no sinal, sem correção
+ *
+ * @param raw Tempos em microssegundos, começando por uma marca
+ * @param count Quantidade de elementos no array
+ * @param copies Recebe uma entrada por cópia encontrada
+ * @param max_copies Tamanho do array copies
+ * @return Quantidade de cópias encontradas
+ */
+size_t philco_ac_soft_decode(const uint16_t *raw, size_t count, philco_ac_frame_t *copies, size_t max_copies);
+
+/**
+ * Combina cópias por votação ponderada e corrige bits marginais pelo checksum
+ *
+ * @param copies Cópias obtidas com philco_ac_soft_decode()
+ * @param count Quantidade de cópias
+ * @param out Quadro resultante
+ * @return true se o quadro resultante for válido
+ */
+bool philco_ac_combine(const philco_ac_frame_t *copies, size_t count, philco_ac_frame_t *out);
+
+/**
+ * Decodifica um sinal RAW completo (todas as cópias + correção)
+ *
+ * @return true se um quadro válido foi recuperado
+ */
+bool philco_ac_decode(const uint16_t *raw, size_t count, philco_ac_frame_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PHILCO_AC_H
@@ -0,0 +1,147 @@
+/**
+ * pulse_distance_receive.c - Recepção por PIO + DMA de quadros por distância de pulso
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+#include "hardware/dma.h"
+#include "hardware/clocks.h"
+
+#include "pulse_distance_receive.h"
+#include "pulse_distance_receive.pio.h"
+
+#define PD_RX_DMA_COUNT 0xFFFFFFFFu     // Transferências por disparo (rearmado ao esgotar)
+
+int pd_rx_init(PIO pio, uint pin, const pd_rx_config_t *config) {
+    gpio_disable_pulls(pin);
+
+    if (!pio_can_add_program(pio, &pulse_distance_receive_program)) {
+        return -1;
+    }
+    uint offset = pio_add_program(pio, &pulse_distance_receive_program);
+
+    int sm = pio_claim_unused_sm(pio, true);
+    if (sm == -1) {
+        return -1;
+    }
+
+    // O limiar de bit cai em THRESHOLD_TICKS ticks do clock da state machine
+    float tick_us = (float)config->bit_threshold_us / pulse_distance_receive_THRESHOLD_TICKS;
+    float div = clock_get_hz(clk_sys) * tick_us / 1e6f;
+    pulse_distance_receive_program_init(pio, sm, offset, pin, div);
+
+    // Primeira palavra do FIFO TX: voltas do laço do cabeçalho
+    uint32_t header_loops = (uint32_t)(config->header_mark_min_us / (tick_us * pulse_distance_receive_HEADER_LOOP_TICKS));
+    pio_sm_put(pio, sm, header_loops);
+    pio_sm_set_enabled(pio, sm, true);
+
+    return sm;
+}
+
+uint32_t pd_rx_frame_gap_us(const pd_rx_config_t *config) {
+    return config->bit_threshold_us * pulse_distance_receive_GAP_TICKS / pulse_distance_receive_THRESHOLD_TICKS;
+}
+
+void pd_rx_frame_reset(pd_rx_frame_t *frame) {
+    memset(frame, 0, sizeof(*frame));
+}
+
+bool pd_rx_frame_push_word(pd_rx_frame_t *frame, uint32_t word) {
+    uint32_t data;
+    uint count;
+    bool end = (word & 1) == 0;
+
+    if (!end) {
+        data = word >> 1;
+        count = 31;
+    } else if (word == 0) {
+        data = 0;                       // Sem sentinela: nada a acrescentar
+        count = 0;
+    } else {
+        // A sentinela fica logo abaixo dos bits recebidos
+        uint sentinel = (uint)__builtin_ctz(word);
+        data = sentinel == 31 ? 0 : word >> (sentinel + 1);
+        count = 31 - sentinel;
+    }
+
+    uint room = PD_RX_MAX_BITS - frame->bit_count;
+    if (count > room) {
+        count = room;
+        frame->truncated = true;
+    }
+
+    // Até 31 bits a partir de um bit qualquer: espalha byte a byte
+    uint pos = frame->bit_count;
+    frame->bit_count += count;
+    while (count > 0) {
+        uint shift = pos % 8;
+        uint take = 8 - shift < count ? 8 - shift : count;
+        frame->bytes[pos / 8] |= (uint8_t)((data & ((1u << take) - 1)) << shift);
+        data >>= take;
+        pos += take;
+        count -= take;
+    }
+    return end;
+}
+
+bool pd_rx_stream_init(pd_rx_stream_t *stream, PIO pio, uint sm) {
+    memset(stream, 0, sizeof(*stream));
+    stream->pio = pio;
+    stream->sm = sm;
+    stream->dma_chan = dma_claim_unused_channel(false);
+    if (stream->dma_chan < 0) {
+        return false;
+    }
+
+    dma_channel_config c = dma_channel_get_default_config(stream->dma_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, true);
+    channel_config_set_ring(&c, true, PD_RX_RING_BITS);
+    channel_config_set_dreq(&c, pio_get_dreq(pio, sm, false));
+    dma_channel_configure(stream->dma_chan, &c, stream->ring, &pio->rxf[sm], PD_RX_DMA_COUNT, true);
+    return true;
+}
+
+// Palavras escritas pelo DMA desde o início (módulo 2^32)
+static uint32_t words_written(pd_rx_stream_t *stream) {
+    uint32_t written = stream->armed_total + (PD_RX_DMA_COUNT - dma_channel_hw_addr(stream->dma_chan)->transfer_count);
+    if (!dma_channel_is_busy(stream->dma_chan)) {
+        // Contagem esgotada: rearma, o endereço continua no mesmo ponto do anel
+        stream->armed_total = written;
+        dma_channel_set_trans_count(stream->dma_chan, PD_RX_DMA_COUNT, true);
+    }
+    return written;
+}
+
+bool pd_rx_stream_next(pd_rx_stream_t *stream, pd_rx_frame_t *frame) {
+    uint32_t written = words_written(stream);
+
+    if (written - stream->read_total > PD_RX_RING_WORDS) {
+        // O DMA deu a volta: o quadro em montagem perdeu palavras
+        stream->overflows++;
+        stream->read_total = written - PD_RX_RING_WORDS;
+        stream->resync = true;
+        pd_rx_frame_reset(&stream->partial);
+    }
+
+    while (stream->read_total != written) {
+        uint32_t word = stream->ring[stream->read_total % PD_RX_RING_WORDS];
+        stream->read_total++;
+        if (stream->resync) {
+            stream->resync = (word & 1) != 0;
+            continue;
+        }
+        if (pd_rx_frame_push_word(&stream->partial, word)) {
+            *frame = stream->partial;
+            pd_rx_frame_reset(&stream->partial);
+            return true;
+        }
+    }
+    return false;
+}
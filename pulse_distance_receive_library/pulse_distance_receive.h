@@ -0,0 +1,108 @@
+/**
+ * pulse_distance_receive.h - Recepção por PIO + DMA de quadros por distância de pulso
+ *
+ * Para protocolos com marca fixa e o bit no comprimento do espaço (Philco,
+ * NEC e a maioria dos controles de ar condicionado), com cabeçalho e limiar
+ * configuráveis. Diferente do nec_receive (32 bits, sincronismo de 9 ms), o
+ * programa aceita quadros de qualquer tamanho: os bits entram no FIFO RX em
+ * palavras de 31 bits e a palavra que fecha o quadro é marcada pelo silêncio
+ * depois da última marca. Um canal de DMA copia as palavras para um anel na
+ * RAM, então a CPU só trabalha quando lê um quadro completo.
+ *
+ * O programa ocupa 25 das 32 instruções de um PIO; com PD_RX_CONFIG_NEC ele
+ * também substitui o nec_receive (bytes[0..3] = quadro de nec_decode_frame).
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef PULSE_DISTANCE_RECEIVE_H
+#define PULSE_DISTANCE_RECEIVE_H
+
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PD_RX_MAX_BITS 256              // Bits guardados por quadro (o resto é descartado)
+#define PD_RX_RING_BITS 8               // Anel do DMA: 2^8 bytes alinhados
+#define PD_RX_RING_WORDS ((1u << PD_RX_RING_BITS) / sizeof(uint32_t))
+
+typedef struct {
+    uint32_t header_mark_min_us;        // Marca mais curta aceita como cabeçalho
+    uint32_t bit_threshold_us;          // Espaço acima disto = bit 1
+} pd_rx_config_t;
+
+// Philco: cabeçalho de 3600 us, espaços de 350/1300 us
+#define PD_RX_CONFIG_PHILCO ((pd_rx_config_t){2000, 825})
+// NEC: cabeçalho de 9 ms, espaços de 562,5/1687,5 us
+#define PD_RX_CONFIG_NEC ((pd_rx_config_t){4500, 1125})
+
+// Quadro montado a partir das palavras do FIFO (bits em ordem de chegada,
+// a partir do bit menos significativo de bytes[0])
+typedef struct {
+    uint8_t bytes[PD_RX_MAX_BITS / 8];
+    uint16_t bit_count;
+    bool truncated;                     // O quadro tinha mais de PD_RX_MAX_BITS bits
+} pd_rx_frame_t;
+
+// Anel preenchido pelo DMA e o quadro em montagem
+typedef struct {
+    uint32_t ring[PD_RX_RING_WORDS] __attribute__((aligned(1u << PD_RX_RING_BITS)));
+    PIO pio;
+    uint sm;
+    int dma_chan;
+    uint32_t read_total;                // Palavras consumidas desde o início
+    uint32_t armed_total;               // Palavras escritas antes do último rearme do DMA
+    uint32_t overflows;                 // Vezes que o DMA deu a volta no anel antes da leitura
+    bool resync;                        // Descartando até o próximo fim de quadro
+    pd_rx_frame_t partial;
+} pd_rx_stream_t;
+
+/**
+ * Carrega o programa, configura uma state machine livre e a liga
+ *
+ * @return Número da state machine, ou -1 se não houver espaço no PIO
+ */
+int pd_rx_init(PIO pio, uint pin, const pd_rx_config_t *config);
+
+/**
+ * Silêncio que encerra um quadro com esta configuração
+ */
+uint32_t pd_rx_frame_gap_us(const pd_rx_config_t *config);
+
+/**
+ * Zera um quadro antes da primeira palavra
+ */
+void pd_rx_frame_reset(pd_rx_frame_t *frame);
+
+/**
+ * Acrescenta ao quadro os bits de uma palavra do FIFO RX
+ *
+ * @return true se a palavra encerrou o quadro
+ */
+bool pd_rx_frame_push_word(pd_rx_frame_t *frame, uint32_t word);
+
+/**
+ * Liga um canal de DMA do FIFO RX da state machine ao anel do stream
+ *
+ * @param stream Estrutura com o anel (precisa continuar válida)
+ * @return false se não houver canal de DMA livre
+ */
+bool pd_rx_stream_init(pd_rx_stream_t *stream, PIO pio, uint sm);
+
+/**
+ * Monta o próximo quadro completo a partir do anel, sem bloquear
+ *
+ * @param frame Recebe o quadro
+ * @return true se um quadro foi concluído
+ */
+bool pd_rx_stream_next(pd_rx_stream_t *stream, pd_rx_frame_t *frame);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PULSE_DISTANCE_RECEIVE_H
@@ -0,0 +1,118 @@
+/**
+ * pulse_distance_transmit.c - Transmissão por PIO de quadros por distância de pulso
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+#include "hardware/clocks.h"
+
+#include "pulse_distance_transmit.h"
+#include "pulse_distance_burst.pio.h"
+#include "pulse_distance_control.pio.h"
+
+/**
+ * Contagem do laço para um tempo: o tempo medido é
+ * contagem * TICKS_PER_PERIOD + fixed_ticks
+ */
+static uint32_t loop_count(float tick_us, float us, int32_t fixed_ticks, uint32_t max) {
+    float count = (us / tick_us - (float)fixed_ticks) / pulse_distance_control_TICKS_PER_PERIOD;
+    if (count < 0.5f) {
+        return 0;
+    }
+    uint32_t n = (uint32_t)(count + 0.5f);
+    return n > max ? max : n;
+}
+
+static uint8_t reverse8(uint32_t v) {
+    uint8_t r = 0;
+    for (int i = 0; i < 8; i++) {
+        r = (uint8_t)((r << 1) | ((v >> i) & 1));
+    }
+    return r;
+}
+
+bool pd_tx_init(pd_tx_t *tx, PIO pio, uint pin, const pd_tx_config_t *config) {
+    if (!pio_can_add_program(pio, &pulse_distance_burst_program)) {
+        return false;
+    }
+    uint burst_offset = pio_add_program(pio, &pulse_distance_burst_program);
+    int burst_sm = pio_claim_unused_sm(pio, false);
+    if (burst_sm < 0) {
+        return false;
+    }
+
+    if (!pio_can_add_program(pio, &pulse_distance_control_program)) {
+        return false;
+    }
+    uint control_offset = pio_add_program(pio, &pulse_distance_control_program);
+    int control_sm = pio_claim_unused_sm(pio, false);
+    if (control_sm < 0) {
+        return false;
+    }
+
+    // Tempos em ticks de um quarto de período do carrier
+    float tick_rate = (float)config->carrier_hz * pulse_distance_control_TICKS_PER_PERIOD;
+    float tick_us = 1e6f / tick_rate;
+
+    uint32_t mark = loop_count(tick_us, (float)config->bit_mark_us, pulse_distance_control_MARK_TICKS, 0xff);
+    uint32_t zero = loop_count(tick_us, (float)config->zero_space_us, pulse_distance_control_SPACE_TICKS, 0xff);
+    uint32_t one = loop_count(tick_us, (float)config->one_space_us, pulse_distance_control_SPACE_TICKS, 0xff);
+    tx->timing_word = mark | one << 8 | (uint32_t)reverse8(zero) << 16 | (uint32_t)reverse8(mark) << 24;
+
+    // O silêncio começa depois da marca final, que é um bit 0 com o seu espaço
+    float gap_us = (float)config->gap_us - (float)(zero * pulse_distance_control_TICKS_PER_PERIOD) * tick_us;
+    uint32_t gap = loop_count(tick_us, gap_us, pulse_distance_control_GAP_TICKS, 0xfff);
+    uint32_t header_mark = loop_count(tick_us, (float)config->header_mark_us, pulse_distance_control_MARK_TICKS, 0x3ff);
+    uint32_t header_space =
+        loop_count(tick_us, (float)config->header_space_us, pulse_distance_control_HEADER_SPACE_TICKS, 0x3ff);
+    tx->header_word = gap | header_mark << 12 | header_space << 22;
+
+    pulse_distance_burst_program_init(pio, (uint)burst_sm, burst_offset, pin, (float)config->carrier_hz);
+    pulse_distance_control_program_init(pio, (uint)control_sm, control_offset, tick_rate);
+
+    // Primeira palavra: tempos dos bits, guardados em Y pelo programa
+    pio_sm_put(pio, (uint)control_sm, tx->timing_word);
+    pio_sm_set_enabled(pio, (uint)control_sm, true);
+
+    tx->pio = pio;
+    tx->sm = (uint)control_sm;
+    return true;
+}
+
+size_t pd_tx_encode(const pd_tx_t *tx, const uint8_t *bytes, size_t bit_count, uint32_t *words) {
+    if (bit_count > PD_TX_MAX_BITS) {
+        return 0;
+    }
+
+    size_t n = 0;
+    words[n++] = tx->header_word;
+
+    // Bits do quadro mais a marca final (um 0), 31 por palavra
+    size_t total = bit_count + 1;
+    for (size_t first = 0; first < total; first += 31) {
+        size_t count = total - first < 31 ? total - first : 31;
+        uint32_t word = 0;
+        for (size_t i = 0; i < count; i++) {
+            size_t bit = first + i;
+            if (bit < bit_count && (bytes[bit / 8] >> (bit % 8)) & 1) {
+                word |= 1u << i;
+            }
+        }
+        words[n++] = word | 1u << count;        // Sentinela
+    }
+
+    words[n++] = 0;
+    return n;
+}
+
+bool pd_tx_send(const pd_tx_t *tx, const uint8_t *bytes, size_t bit_count) {
+    uint32_t words[PD_TX_MAX_WORDS];
+    size_t n = pd_tx_encode(tx, bytes, bit_count, words);
+    for (size_t i = 0; i < n; i++) {
+        pio_sm_put_blocking(tx->pio, tx->sm, words[i]);
+    }
+    return n > 0;
+}
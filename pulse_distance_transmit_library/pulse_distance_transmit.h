@@ -0,0 +1,81 @@
+/**
+ * pulse_distance_transmit.h - Transmissão por PIO de quadros por distância de pulso
+ *
+ * O quadro vai ao PIO como bits empacotados: uma palavra de cabeçalho, até
+ * 31 bits por palavra e uma palavra de fim. Cabeçalho, marcas, espaços e o
+ * carrier saem das state machines (pulse_distance_control.pio +
+ * pulse_distance_burst.pio, no mesmo estilo do nec_transmit), com tempos
+ * múltiplos de um período do carrier e sem depender da CPU. Um quadro
+ * Philco são 6 escritas no FIFO, contra 227 tempos lidos da biblioteca de
+ * capturas e um alarme por transição.
+ *
+ * Os dois programas ocupam 30 das 32 instruções de um PIO.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef PULSE_DISTANCE_TRANSMIT_H
+#define PULSE_DISTANCE_TRANSMIT_H
+
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PD_TX_MAX_BITS 256
+#define PD_TX_MAX_WORDS (2 + (PD_TX_MAX_BITS + 1 + 30) / 31)
+
+typedef struct {
+    uint32_t carrier_hz;
+    uint16_t header_mark_us;
+    uint16_t header_space_us;
+    uint16_t bit_mark_us;
+    uint16_t zero_space_us;
+    uint16_t one_space_us;
+    uint32_t gap_us;                    // Silêncio mínimo entre a marca final e o próximo quadro
+} pd_tx_config_t;
+
+// Philco (philco_ac.h)
+#define PD_TX_CONFIG_PHILCO ((pd_tx_config_t){38000, 3600, 1750, 420, 350, 1300, 5000})
+// NEC: 9 ms + 4,5 ms, bits de 562,5 us, quadros a cada 108 ms
+#define PD_TX_CONFIG_NEC ((pd_tx_config_t){38222, 9000, 4500, 562, 562, 1687, 40000})
+
+typedef struct {
+    PIO pio;
+    uint sm;                            // State machine de controle
+    uint32_t header_word;               // Silêncio | marca | espaço do cabeçalho, em voltas
+    uint32_t timing_word;               // Tempos dos bits no formato do pulse_distance_control.pio
+} pd_tx_t;
+
+/**
+ * Carrega os dois programas e liga as state machines
+ *
+ * @return false se não houver espaço no PIO ou state machines livres
+ */
+bool pd_tx_init(pd_tx_t *tx, PIO pio, uint pin, const pd_tx_config_t *config);
+
+/**
+ * Monta as palavras de um quadro para o FIFO (ou para um canal de DMA)
+ *
+ * @param bytes Bits do quadro, a partir do bit menos significativo de bytes[0]
+ * @param bit_count Bits a enviar (até PD_TX_MAX_BITS)
+ * @param words Recebe até PD_TX_MAX_WORDS palavras
+ * @return Quantidade de palavras (0 se bit_count é grande demais)
+ */
+size_t pd_tx_encode(const pd_tx_t *tx, const uint8_t *bytes, size_t bit_count, uint32_t *words);
+
+/**
+ * Envia um quadro: escreve as palavras no FIFO, esperando espaço se preciso
+ *
+ * @return false se bit_count é grande demais
+ */
+bool pd_tx_send(const pd_tx_t *tx, const uint8_t *bytes, size_t bit_count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PULSE_DISTANCE_TRANSMIT_H
@@ -1,6 +1,6 @@
 /**
  * RECEPTOR DE SINAIS IR - Raspberry Pi Pico
- * Captura at 5 sinais IR e exibe dados no formato rawSignal[]
+ * Captura até 5 sinais IR e exibe dados no formato rawSignal[]
  * FORMATO: uint16_t rawSignal[] = {tempo1, tempo2, tempo3, ...}
  */
 
@@ -10,33 +10,46 @@
 #include "pico/stdlib.h"
 #include "hardware/gpio.h"
 #include "hardware/timer.h"
+#include "hardware/pio.h"
+#include "hardware/sync.h"
+#include "edge_capture.h"
+#include "ir_capture.h"
+#include "ir_calib.h"
+#include "ir_health.h"
+#include "philco_ac.h"
+#include "ir_scene.h"
+#include "ir_log.h"
+#include "ir_boot.h"
 
-// Bibliotecas do display (se disponvel)
+// Bibliotecas do display (se disponível)
 #ifdef USE_DISPLAY
 #include "ssd1306.h"
 #include "font.h"
 #endif
 
-// Configuraes
+// Configurações
 #define IR_RX_PIN 17        // Sensor IR
 #define LED_STATUS 25       // LED onboard
-#define MAX_TRANSITIONS 1024 // Mximo de transies por sinal (aumentado)
-#define MIN_SIGNAL_GAP_US 30000   // 30ms de silncio = fim de comando (aumentado)
-#define MAX_PULSE_US 100000        // Mximo 100ms por pulso (aumentado)
-#define MIN_PULSE_US 50           // Mnimo 50us por pulso (diminudo)
-#define MAX_SIGNALS 5             // Mximo de sinais para capturar
+#define MAX_TRANSITIONS 1024 // Máximo de transições por sinal (aumentado)
+#define MIN_SIGNAL_GAP_US 30000   // 30ms de silêncio = fim de comando (aumentado)
+#define MAX_PULSE_US 100000        // Máximo 100ms por pulso (aumentado)
+#define MAX_SIGNALS 5             // Máximo de sinais para capturar
 #define DEBOUNCE_TIME_US 20       // Tempo de debounce em microssegundos
+#define HEALTH_WINDOW_MS 10000    // Janela do diagnóstico do sensor ('t')
+#define IR_RX_STRETCH_US 0        // Esticamento de marca do sensor medido com 'c' (0 = sem correção)
 
 // Estrutura do sinal capturado no formato RAW
 typedef struct {
     uint16_t raw_data[MAX_TRANSITIONS];  // Tempos em microssegundos
-    uint16_t count;                      // Nmero de tempos
-    uint32_t total_duration_ms;          // Durao total
+    uint16_t count;                      // Número de tempos
+    uint32_t total_duration_ms;          // Duração total
     bool is_complete;                    // Sinal completo?
     char name[32];                       // Nome do sinal
+    ir_protocol_t protocol;              // Protocolo identificado no reparo
+    bool count_mismatch;                 // Quantidade de tempos não confere com o protocolo
 } ir_raw_signal_t;
 
-// Variveis globais
+// Variáveis globais
 volatile ir_raw_signal_t current_signal;
 volatile bool signal_ready = false;
 volatile bool capturing = false;
@@ -53,13 +66,32 @@ uint8_t signal_count = 0;
 // Timer para detectar fim de sinal
 repeating_timer_t signal_timer;
 
+// Calibração: as capturas de protocolo conhecido estimam o desvio do sensor,
+// e a correção vale para os sinais aprendidos
+static ir_calib_estimator_t calib_estimator;
+static ir_calib_t rx_calib = {.stretch_us = IR_RX_STRETCH_US};
+
+// Gravação de sessão: os quadros e as pausas entre eles viram uma cena
+#define SESSION_CAPACITY 8192
+static uint8_t session_code[SESSION_CAPACITY];
+static ir_scene_recorder_t session;
+static bool recording = false;
+
+// Diagnóstico do sensor: o PIO mede cada nível do pino em paralelo à IRQ
+static edge_cap_stream_t health_stream;
+static ir_health_t health;
+static bool health_available = false;     // State machine e DMA obtidos
+static bool health_pending = false;       // Janela pedida pelo 't' em andamento
+static uint32_t health_start_ms = 0;
+static uint32_t health_edge_us = 0;       // Leitura que trouxe a última borda
+
 // Callback do timer para detectar fim de sinal
 bool signal_timeout_callback(repeating_timer_t *rt) {
     if (capturing) {
         uint32_t now = to_us_since_boot(get_absolute_time());
         uint32_t silence_time = now - last_transition_time;
         
-        // Se passou tempo suficiente sem transies, finaliza o sinal
+        // Se passou tempo suficiente sem transições, finaliza o sinal
         if (silence_time > MIN_SIGNAL_GAP_US && current_signal.count > 10) {
             current_signal.is_complete = true;
             current_signal.total_duration_ms = (now - signal_start_time) / 1000;
@@ -67,15 +99,16 @@ bool signal_timeout_callback(repeating_timer_t *rt) {
             capturing = false;
             gpio_put(LED_STATUS, 0);
             
-            printf(">>> Sinal finalizado!\n");
-            printf("Tempos: %d | Durao: %d ms | Silncio: %d us\n", 
-                   current_signal.count, current_signal.total_duration_ms, silence_time);
+            // Dentro do timer: só grava no log, o laço principal imprime
+            IR_LOG_INFO(">>> Sinal finalizado!\n");
+            IR_LOG_INFO("Tempos: %d | Duração: %d ms | Silêncio: %d us\n", 
+                        current_signal.count, current_signal.total_duration_ms, silence_time);
         }
     }
     return true;
 }
 
-// Callback de interrupo do IR - VERSO RAW
+// Callback de interrupção do IR - VERSÃO RAW
 void ir_transition_callback(uint gpio, uint32_t events) {
     uint32_t now = to_us_since_boot(get_absolute_time());
     bool current_state = gpio_get(IR_RX_PIN);
@@ -86,55 +119,61 @@ void ir_transition_callback(uint gpio, uint32_t events) {
     }
     last_debounce_time = now;
     
-    // Debug: mostra mudanas de estado
+    // Debug: mostra mudanças de estado
     if (transition_count < 20) {
-        printf("GPIO=%d, State=%d, Time=%lu\n", gpio, current_state, now);
+        IR_LOG_DEBUG("GPIO=%d, State=%d, Time=%u\n", gpio, current_state, now);
         transition_count++;
     }
     
     if (capturing) {
-        // Calcula durao desde a ltima transio
+        // Calcula duração desde a última transição
         uint32_t duration = now - last_transition_time;
         
-        // Verifica se a durao est dentro dos limites
-        if (duration >= MIN_PULSE_US && duration <= MAX_PULSE_US) {
+        // Verifica se a duração está dentro dos limites (pulsos curtos ficam:
+        // descartá-los troca marca por espaço no resto do sinal)
+        if (duration <= MAX_PULSE_US) {
             if (current_signal.count < MAX_TRANSITIONS - 1) {
-                // Armazena apenas o tempo (formato raw)
-                current_signal.raw_data[current_signal.count] = (uint16_t)duration;
+                // Armazena apenas o tempo (formato raw); a estimativa recebe o
+                // tempo do sensor e o sinal, o corrigido
+                bool mark = !last_state;
+                ir_calib_push(&calib_estimator, (uint16_t)duration, mark);
+                current_signal.raw_data[current_signal.count] = ir_calib_correct_us(&rx_calib, (uint16_t)duration, mark);
                 current_signal.count++;
                 
                 // Debug dos primeiros tempos
                 if (current_signal.count <= 20) {
-                    printf("Tempo %d: %dus (%s->%s)\n", 
-                           current_signal.count, 
-                           duration,
-                           last_state ? "HIGH" : "LOW",
-                           current_state ? "HIGH" : "LOW");
+                    IR_LOG_DEBUG("Tempo %d: %dus (%s->%s)\n", 
+                                 current_signal.count, 
+                                 duration,
+                                 last_state ? "HIGH" : "LOW",
+                                 current_state ? "HIGH" : "LOW");
                 }
             } else {
-                printf(">>> AVISO: Mximo de tempos atingido!\n");
+                IR_LOG_WARN(">>> AVISO: Máximo de tempos atingido!\n");
                 current_signal.is_complete = true;
                 signal_ready = true;
                 capturing = false;
                 gpio_put(LED_STATUS, 0);
             }
         } else if (duration > MAX_PULSE_US) {
-            printf(">>> AVISO: Pulso muito longo: %dus (max %dus)\n", duration, MAX_PULSE_US);
+            IR_LOG_WARN(">>> AVISO: Pulso muito longo: %dus (max %dus)\n", duration, MAX_PULSE_US);
         }
     } else {
-        // Detecta incio de sinal - tradicionalmente LOW no receptor TSOP
-        if (!current_state) { // Sinal IR detectado (LOW)
-            printf("\n>>> NOVO SINAL IR DETECTADO!\n");
-            printf("Estado inicial: %s\n", current_state ? "HIGH" : "LOW");
+        // Detecta início de sinal - tradicionalmente LOW no receptor TSOP;
+        // a captura anterior ainda não impressa (host não conectado) é mantida
+        if (!current_state && !signal_ready) { // Sinal IR detectado (LOW)
+            IR_LOG_INFO("\n>>> NOVO SINAL IR DETECTADO!\n");
+            IR_LOG_INFO("Estado inicial: %s\n", current_state ? "HIGH" : "LOW");
             
             capturing = true;
             signal_start_time = now;
             current_signal.count = 0;
             current_signal.is_complete = false;
+            ir_calib_begin(&calib_estimator);
             transition_count = 0;
             gpio_put(LED_STATUS, 1);
             
-            printf("Iniciando captura...\n");
+            IR_LOG_INFO("Iniciando captura...\n");
         }
     }
     
@@ -143,58 +182,103 @@ void ir_transition_callback(uint gpio, uint32_t events) {
     last_transition_time = now;
 }
 
-// Testa o pino IR manualmente
-void test_ir_pin(void) {
-    printf("\n>>> TESTE DO PINO IR (%d)\n", IR_RX_PIN);
-    printf("Monitore as mudanas por 10 segundos...\n");
-    printf("Aponte o controle e pressione botes.\n");
-    
-    bool last_reading = gpio_get(IR_RX_PIN);
-    printf("Estado inicial: %s\n", last_reading ? "HIGH" : "LOW");
-    
-    uint32_t start_time = to_ms_since_boot(get_absolute_time());
-    uint32_t change_count = 0;
-    
-    while ((to_ms_since_boot(get_absolute_time()) - start_time) < 10000) {
-        bool current_reading = gpio_get(IR_RX_PIN);
-        
-        if (current_reading != last_reading) {
-            change_count++;
-            printf("Mudana %lu: %s -> %s\n", 
-                   change_count,
-                   last_reading ? "HIGH" : "LOW", 
-                   current_reading ? "HIGH" : "LOW");
-            last_reading = current_reading;
-            
-            // Pisca LED a cada mudana
-            gpio_put(LED_STATUS, !gpio_get(LED_STATUS));
+// Passa as medidas novas do PIO para a janela do diagnóstico
+void health_poll(void) {
+    if (!health_available) {
+        return;
+    }
+    uint32_t words[32];
+    size_t n;
+    while ((n = edge_cap_stream_read(&health_stream, words, count_of(words))) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            ir_health_push(&health, edge_cap_level(words[i]), edge_cap_duration_us(words[i]));
         }
-        
-        sleep_ms(1);
+        health_edge_us = to_us_since_boot(get_absolute_time());
     }
-    
-    printf("Teste concludo. Total de mudanas: %lu\n", change_count);
-    gpio_put(LED_STATUS, 0);
-    
-    if (change_count == 0) {
-        printf(">>> PROBLEMA: Nenhuma mudana detectada!\n");
-        printf("Verifique:\n");
-        printf("- Conexo do sensor IR no pino %d\n", IR_RX_PIN);
-        printf("- Alimentao do sensor (3.3V)\n");
-        printf("- Sensor funcionando\n");
-    } else {
-        printf(">>> Sensor respondendo normalmente!\n");
+}
+
+// Imprime o diagnóstico da janela atual
+void print_health_report(void) {
+    ir_health_report_t report;
+    bool level = gpio_get(IR_RX_PIN);
+    uint32_t open_us = to_us_since_boot(get_absolute_time()) - health_edge_us;
+    ir_health_report(&health, level, open_us, &report);
+
+    printf("\n>>> DIAGNÓSTICO DO SENSOR IR (pino %d)\n", IR_RX_PIN);
+    printf("Janela: %lu ms | Bordas: %lu (%lu/s)\n",
+           (unsigned long)report.window_ms, (unsigned long)report.edges, (unsigned long)report.edges_per_s);
+    printf("Repouso: %s | Tempo em nível alto: %u.%u%% | Pino agora: %s\n",
+           report.idle_high ? "HIGH" : "LOW", report.high_permille / 10, report.high_permille % 10,
+           level ? "HIGH" : "LOW");
+    printf("Piso de ruído: %lu marca(s) fora de quadros (%lu/min, %lu ppm do tempo)\n",
+           (unsigned long)report.noise_marks, (unsigned long)report.noise_per_min,
+           (unsigned long)report.noise_low_ppm);
+    printf("Rajadas com cara de quadro: %lu\n", (unsigned long)report.signal_bursts);
+    printf("Marca mais curta: %lu us | Nível baixo mais longo: %lu us\n",
+           (unsigned long)report.shortest_mark_us, (unsigned long)report.longest_low_us);
+
+    printf("Larguras      marcas  espaços\n");
+    for (uint32_t bin = 0; bin < IR_HEALTH_BINS; bin++) {
+        if (health.mark_hist[bin] || health.space_hist[bin]) {
+            printf("  >= %5lu us %7lu %8lu\n", (unsigned long)ir_health_bin_floor_us(bin),
+                   (unsigned long)health.mark_hist[bin], (unsigned long)health.space_hist[bin]);
+        }
+    }
+    if (health_stream.overflows) {
+        printf("Medidas perdidas (anel do DMA cheio): %lu vez(es)\n", (unsigned long)health_stream.overflows);
+    }
+
+    printf("Diagnóstico: %s\n", ir_health_status_name(report.status));
+    switch (report.status) {
+        case IR_HEALTH_DEAD:
+            printf("Verifique:\n");
+            printf("- Conexão do sensor IR no pino %d\n", IR_RX_PIN);
+            printf("- Alimentação do sensor (3.3V)\n");
+            printf("- Sensor funcionando\n");
+            break;
+        case IR_HEALTH_NOISY:
+            printf("Afaste o sensor de sol direto e lâmpadas fluorescentes/LED\n");
+            break;
+        case IR_HEALTH_SILENT:
+            printf("Nenhuma borda: aponte o controle e repita o teste\n");
+            break;
+        default:
+            break;
+    }
+}
+
+// Pede uma janela nova do diagnóstico (o resultado sai no laço principal)
+void start_health_check(void) {
+    if (!health_available) {
+        printf(">>> Diagnóstico indisponível: sem state machine ou canal de DMA livre\n");
+        return;
+    }
+    health_poll();
+    ir_health_init(&health);
+    health_start_ms = to_ms_since_boot(get_absolute_time());
+    health_pending = true;
+    printf("\n>>> DIAGNÓSTICO DO SENSOR IR (%d) por %d s - a captura continua\n",
+           IR_RX_PIN, HEALTH_WINDOW_MS / 1000);
+    printf("Deixe sem controle para medir o ruído, ou aponte o controle e pressione botões.\n");
+}
+
+// Lê as medidas e imprime o diagnóstico quando a janela termina
+void health_task(void) {
+    health_poll();
+    if (health_pending && to_ms_since_boot(get_absolute_time()) - health_start_ms >= HEALTH_WINDOW_MS) {
+        health_pending = false;
+        print_health_report();
     }
 }
 
-// Exibe os dados do sinal no formato RAW para cpia direta
+// Exibe os dados do sinal no formato RAW para cópia direta
 void print_raw_signal_data(const ir_raw_signal_t* signal, int signal_num) {
     printf("\n=====================================\n");
-    printf("SINAL %d - FORMATO RAW PARA CPIA:\n", signal_num + 1);
+    printf("SINAL %d - FORMATO RAW PARA CÓPIA:\n", signal_num + 1);
     printf("=====================================\n");
     printf("// Sinal %d: %s\n", signal_num + 1, signal->name);
-    printf("// Tempos: %d | Durao: %d ms\n", signal->count, signal->total_duration_ms);
-    printf("// Primeira posio = ON, depois alterna ON/OFF/ON/OFF...\n");
+    printf("// Tempos: %d | Duração: %d ms\n", signal->count, signal->total_duration_ms);
+    printf("// Primeira posição = ON, depois alterna ON/OFF/ON/OFF...\n");
     
     printf("uint16_t rawSignal%d[] = {\n", signal_num + 1);
     
@@ -214,31 +298,36 @@ void print_raw_signal_data(const ir_raw_signal_t* signal, int signal_num) {
     printf("};\n");
     printf("#define RAW_SIGNAL%d_LENGTH %d\n", signal_num + 1, signal->count);
     
-    // Anlise do sinal
-    printf("\n// ANLISE:\n");
+    // Análise do sinal
+    printf("\n// ANÁLISE:\n");
     printf("// - Total de tempos: %d\n", signal->count);
-    printf("// - Durao total: %d ms\n", signal->total_duration_ms);
+    printf("// - Duração total: %d ms\n", signal->total_duration_ms);
     printf("// - Primeiro tempo: %dus (ON)\n", signal->raw_data[0]);
     if (signal->count > 1) {
-        printf("// - ltimo tempo: %dus (%s)\n", 
+        printf("// - Último tempo: %dus (%s)\n", 
                signal->raw_data[signal->count-1],
                (signal->count % 2 == 1) ? "ON" : "OFF");
     }
     
-    // Estatsticas bsicas
-    uint16_t min_time = signal->raw_data[0];
-    uint16_t max_time = signal->raw_data[0];
-    uint32_t sum_time = 0;
-    
-    for (int i = 0; i < signal->count; i++) {
-        if (signal->raw_data[i] < min_time) min_time = signal->raw_data[i];
-        if (signal->raw_data[i] > max_time) max_time = signal->raw_data[i];
-        sum_time += signal->raw_data[i];
+    // Estatísticas básicas
+    ir_capture_stats_t stats;
+    ir_capture_compute_stats(signal->raw_data, signal->count, &stats);
+    
+    printf("// - Tempo mín: %dus, máx: %dus, médio: %dus\n", 
+           stats.min_us, stats.max_us, stats.mean_us);
+    printf("// - Protocolo: %s%s\n", ir_protocol_name(signal->protocol),
+           signal->count_mismatch ? " (quantidade de tempos inesperada, possível marca perdida)" : "");
+    
+    // Quadro do ar condicionado Philco (com correção de bits marginais)
+    philco_ac_frame_t frame;
+    if (philco_ac_decode(signal->raw_data, signal->count, &frame)) {
+        printf("// - Philco AC:");
+        for (int i = 0; i < PHILCO_AC_FRAME_BYTES; i++) {
+            printf(" %02X", frame.bytes[i]);
+        }
+        printf(" (%d cópia(s), %d bit(s) corrigido(s))\n", frame.copies, frame.corrected_bits);
     }
     
-    printf("// - Tempo mn: %dus, mx: %dus, mdio: %dus\n", 
-           min_time, max_time, sum_time / signal->count);
-    
     printf("=====================================\n");
 }
 
@@ -255,10 +344,10 @@ void print_all_raw_signals_data() {
     }
     
     printf("\n// EXEMPLO DE USO NO TRANSMISSOR:\n");
-    printf("// Substitua o rawSignal[] no seu cdigo transmissor\n");
+    printf("// Substitua o rawSignal[] no seu código transmissor\n");
     printf("// por qualquer um dos arrays acima (rawSignal1[], rawSignal2[], etc.)\n\n");
     
-    printf("// Para usar mltiplos sinais, voc pode criar um array de ponteiros:\n");
+    printf("// Para usar múltiplos sinais, você pode criar um array de ponteiros:\n");
     printf("uint16_t* all_raw_signals[%d] = {\n", signal_count);
     for (int i = 0; i < signal_count; i++) {
         printf("    rawSignal%d", i + 1);
@@ -277,16 +366,57 @@ void print_all_raw_signals_data() {
     
     printf("\n###########################################\n");
     printf("COPIE OS DADOS ACIMA PARA O TRANSMISSOR\n");
-    printf("FORMATO COMPATVEL: uint16_t rawSignal[]\n");
+    printf("FORMATO COMPATÍVEL: uint16_t rawSignal[]\n");
     printf("###########################################\n");
 }
 
+// Imprime a cena gravada no formato para colar em custom_ir.c
+void print_session(void) {
+    size_t length = ir_scene_record_finish(&session);
+    printf("\n// Sessão gravada: %lu quadro(s) reconhecido(s), %lu com os tempos%s\n",
+           (unsigned long)session.matched, (unsigned long)session.inlined,
+           session.overflow ? " (TRUNCADA)" : "");
+    printf("static const uint8_t scene_gravada[] = {\n");
+    for (size_t i = 0; i < length; i++) {
+        if (i % 16 == 0) printf("    ");
+        printf("0x%02X", session_code[i]);
+        if (i < length - 1) printf(", ");
+        if ((i + 1) % 16 == 0 || i == length - 1) printf("\n");
+    }
+    printf("};\n");
+}
+
 // Processa comandos
+// Estimativa do desvio marca/espaço; com amostras suficientes, passa a
+// corrigir as próximas capturas
+void print_calibration(void) {
+    ir_calib_t estimate;
+    uint32_t status = save_and_disable_interrupts();
+    bool ok = ir_calib_estimate(&calib_estimator, &estimate);
+    if (ok) {
+        rx_calib = estimate;
+    }
+    restore_interrupts(status);
+
+    printf(">>> Calibração do sensor: %u captura(s) de protocolo conhecido, %u ignorada(s), %u par(es) marca/espaço\n",
+           calib_estimator.captures, calib_estimator.ignored, calib_estimator.samples);
+    if (!ok) {
+        printf("Correção atual: %d us\n", rx_calib.stretch_us);
+        printf("Amostras insuficientes (mínimo %d): capture mais sinais NEC, Samsung ou Philco\n",
+               IR_CALIB_MIN_SAMPLES);
+        return;
+    }
+    printf("Marcas: %+d us | Espaços: %+d us | Esticamento: %d us\n", estimate.mark_error_us,
+           -estimate.space_error_us, estimate.stretch_us);
+    printf("Correção aplicada às próximas capturas; para mantê-la, use #define IR_RX_STRETCH_US %d\n",
+           estimate.stretch_us);
+}
+
 void process_commands(void) {
     int c = getchar_timeout_us(1000);
     if (c != PICO_ERROR_TIMEOUT) {
         if (c == 't' || c == 'T') {
-            test_ir_pin();
+            start_health_check();
         } else if (c == 'r' || c == 'R') {
             printf(">>> Reset - reiniciando captura...\n");
             signal_count = 0;
@@ -297,15 +427,28 @@ void process_commands(void) {
         } else if (c == 's' || c == 'S') {
             printf(">>> Estado atual:\n");
             printf("Sinais capturados: %d/%d\n", signal_count, MAX_SIGNALS);
-            printf("Capturando: %s\n", capturing ? "SIM" : "NO");
-            printf("Sinal pronto: %s\n", signal_ready ? "SIM" : "NO");
+            printf("Capturando: %s\n", capturing ? "SIM" : "NÃO");
+            printf("Sinal pronto: %s\n", signal_ready ? "SIM" : "NÃO");
             printf("Estado do pino IR: %s\n", gpio_get(IR_RX_PIN) ? "HIGH" : "LOW");
             printf("Tempos no sinal atual: %d\n", current_signal.count);
+        } else if (c == 'g' || c == 'G') {
+            if (!recording) {
+                ir_scene_record_init(&session, session_code, sizeof(session_code));
+                recording = true;
+                printf(">>> Gravando sessão: use o controle normalmente e digite 'g' para terminar\n");
+            } else {
+                recording = false;
+                print_session();
+            }
+        } else if (c == 'c' || c == 'C') {
+            print_calibration();
         } else if (c == 'h' || c == 'H') {
-            printf("\n>>> COMANDOS DISPONVEIS:\n");
-            printf("t - Teste do pino IR\n");
+            printf("\n>>> COMANDOS DISPONÍVEIS:\n");
+            printf("t - Diagnóstico do sensor IR (%d s)\n", HEALTH_WINDOW_MS / 1000);
             printf("r - Reset da captura\n");
             printf("s - Status atual\n");
+            printf("g - Gravar sessão (cena) / terminar gravação\n");
+            printf("c - Calibrar o sensor com as capturas (NEC, Samsung, Philco)\n");
             printf("h - Ajuda\n");
         }
     }
@@ -313,27 +456,27 @@ void process_commands(void) {
 
 int main() {
     stdio_init_all();
-    sleep_ms(3000);
+    ir_boot_init();
+    ir_log_init(IR_LOG_LEVEL_DEBUG);
+    // Sem esperar a USB: o texto fica guardado até o host abrir a porta
+    ir_log_set_output(ir_boot_console_write);
     
-    printf("\n>>> RECEPTOR IR - FORMATO RAW uint16_t[]\n");
-    printf("=========================================\n");
-    printf(">> Receptor IR no pino %d\n", IR_RX_PIN);
-    printf(">> LED de status no pino %d\n", LED_STATUS);
-    printf(">> Captura at %d sinais\n", MAX_SIGNALS);
-    printf(">> Formato: uint16_t rawSignal[]\n");
-    printf("=========================================\n");
-    
-    // Configura hardware
-    gpio_init(LED_STATUS);
-    gpio_set_dir(LED_STATUS, GPIO_OUT);
-    gpio_put(LED_STATUS, 0);
+    // Inicializa variáveis antes de ligar a interrupção
+    current_signal.count = 0;
+    current_signal.is_complete = false;
+    signal_ready = false;
+    capturing = false;
+    signal_count = 0;
     
+    // Receptor primeiro: capturas feitas antes do host conectar ficam
+    // guardadas até a impressão
     gpio_init(IR_RX_PIN);
     gpio_set_dir(IR_RX_PIN, GPIO_IN);
     // Remove pulls - importante para sensores TSOP
     gpio_disable_pulls(IR_RX_PIN);
+    last_state = gpio_get(IR_RX_PIN);
     
-    // Configura interrupo para ambas as bordas
+    // Configura interrupção para ambas as bordas
     gpio_set_irq_enabled_with_callback(IR_RX_PIN, 
                                       GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL, 
                                       true, 
@@ -341,36 +484,54 @@ int main() {
     
     // Timer para detectar fim de sinal (verifica a cada 5ms)
     add_repeating_timer_ms(5, signal_timeout_callback, NULL, &signal_timer);
+
+    // Diagnóstico no PIO, lendo o mesmo pino sem mexer na IRQ
+    int health_sm = edge_cap_init(pio0, IR_RX_PIN);
+    health_available = health_sm >= 0 && edge_cap_stream_init(&health_stream, pio0, (uint)health_sm);
+    ir_health_init(&health);
+    ir_calib_estimator_init(&calib_estimator);
+    ir_boot_mark(IR_BOOT_RX_READY);
     
-    // Inicializa variveis
-    current_signal.count = 0;
-    current_signal.is_complete = false;
-    signal_ready = false;
-    capturing = false;
-    signal_count = 0;
-    last_state = gpio_get(IR_RX_PIN);
+    // Configura hardware
+    gpio_init(LED_STATUS);
+    gpio_set_dir(LED_STATUS, GPIO_OUT);
+    gpio_put(LED_STATUS, 0);
     
-    printf("\n>>> INSTRUES:\n");
-    printf("1. Aponte o controle remoto para o sensor\n");
-    printf("2. Pressione um boto por vez\n");
-    printf("3. Aguarde a captura completa\n");
-    printf("4. Repita at capturar %d sinais\n", MAX_SIGNALS);
-    printf("5. Digite 't' para testar o sensor\n");
-    printf("6. Digite 'h' para ver mais comandos\n");
-    printf("=========================================\n");
+    ir_boot_printf("\n>>> RECEPTOR IR - FORMATO RAW uint16_t[]\n");
+    ir_boot_printf("=========================================\n");
+    ir_boot_printf(">> Receptor IR no pino %d\n", IR_RX_PIN);
+    ir_boot_printf(">> LED de status no pino %d\n", LED_STATUS);
+    ir_boot_printf(">> Captura até %d sinais\n", MAX_SIGNALS);
+    ir_boot_printf(">> Correção do sensor: %d us (IR_RX_STRETCH_US)\n", IR_RX_STRETCH_US);
+    ir_boot_printf(">> Formato: uint16_t rawSignal[]\n");
+    ir_boot_printf("=========================================\n");
+    
+    ir_boot_printf("\n>>> INSTRUÇÕES:\n");
+    ir_boot_printf("1. Aponte o controle remoto para o sensor\n");
+    ir_boot_printf("2. Pressione um botão por vez\n");
+    ir_boot_printf("3. Aguarde a captura completa\n");
+    ir_boot_printf("4. Repita até capturar %d sinais\n", MAX_SIGNALS);
+    ir_boot_printf("5. Digite 't' para o diagnóstico do sensor\n");
+    ir_boot_printf("6. Digite 'h' para ver mais comandos\n");
+    ir_boot_printf("=========================================\n");
     
     // Teste inicial do pino
-    printf("\n>>> Estado inicial do pino IR: %s\n", gpio_get(IR_RX_PIN) ? "HIGH" : "LOW");
+    ir_boot_printf("\n>>> Estado inicial do pino IR: %s\n", gpio_get(IR_RX_PIN) ? "HIGH" : "LOW");
     
-    printf("\n>>> Aguardando sinais IR... (%d/%d capturados)\n", signal_count, MAX_SIGNALS);
-    printf(">>> Digite 't' para testar o sensor primeiro!\n");
+    ir_boot_printf("\n>>> Aguardando sinais IR... (%d/%d capturados)\n", signal_count, MAX_SIGNALS);
+    ir_boot_printf(">>> Digite 't' para diagnosticar o sensor primeiro!\n");
     
     while (signal_count < MAX_SIGNALS) {
-        // Processa comandos do usurio
+        // Processa comandos do usuário
         process_commands();
+        health_task();
         
-        // Processa sinal capturado
-        if (signal_ready) {
+        // Mensagens das interrupções, antes de qualquer impressão do laço
+        ir_boot_poll();
+        ir_log_flush(0);
+
+        // Processa sinal capturado (só com alguém lendo: a captura espera o host)
+        if (signal_ready && ir_boot.attached) {
             // Valida se o sinal tem dados suficientes
             if (current_signal.count < 10) {
                 printf(">>> AVISO: Sinal muito curto (%d tempos), ignorando...\n", 
@@ -379,7 +540,25 @@ int main() {
                 current_signal.count = 0;
                 continue;
             }
+
+            // Marcas perdidas: fora da interrupção, com o quadro inteiro à mão
+            ir_repair_t repair;
+            current_signal.count = (uint16_t)ir_capture_repair((uint16_t*)current_signal.raw_data,
+                                                               current_signal.count, MAX_TRANSITIONS - 1,
+                                                               philco_ac_check_timings, &repair);
+            current_signal.protocol = repair.protocol;
+            current_signal.count_mismatch = repair.count_mismatch;
+            if (repair.marks_rebuilt || repair.edge_shifts) {
+                printf("Reparo: %d marca(s) perdida(s), %d borda(s) deslocada(s), %d grupo(s) 0/1%s\n",
+                       repair.marks_rebuilt, repair.edge_shifts, repair.mixed,
+                       repair.unordered ? " (ordem não confirmada)" : "");
+            }
             
+            if (recording) {
+                ir_scene_record_frame(&session, (const uint16_t*)current_signal.raw_data,
+                                      current_signal.count, signal_start_time / 1000);
+            }
+
             // Cria nome para o sinal
             snprintf(captured_signals[signal_count].name, 32, "SINAL_RAW_%d", signal_count + 1);
             
@@ -389,22 +568,22 @@ int main() {
             printf("\n>>> SINAL %d CAPTURADO COM SUCESSO!\n", signal_count + 1);
             printf("Nome: %s\n", captured_signals[signal_count].name);
             printf("Tempos: %d\n", captured_signals[signal_count].count);
-            printf("Durao: %d ms\n", captured_signals[signal_count].total_duration_ms);
+            printf("Duração: %d ms\n", captured_signals[signal_count].total_duration_ms);
             
             signal_count++;
             
             // Exibe dados do sinal atual no formato RAW
             print_raw_signal_data(&captured_signals[signal_count - 1], signal_count - 1);
             
-            // Reset para prximo sinal
+            // Reset para próximo sinal
             signal_ready = false;
             current_signal.count = 0;
             current_signal.is_complete = false;
             
             if (signal_count < MAX_SIGNALS) {
-                printf("\n>>> Aguardando prximo sinal... (%d/%d capturados)\n", 
+                printf("\n>>> Aguardando próximo sinal... (%d/%d capturados)\n", 
                        signal_count, MAX_SIGNALS);
-                printf(">>> Pressione outro boto do controle!\n");
+                printf(">>> Pressione outro botão do controle!\n");
             }
         }
         
@@ -412,12 +591,12 @@ int main() {
     }
     
     // Exibe todos os dados capturados no formato RAW
-    printf("\n\n>>> CAPTURA CONCLUDA! %d sinais capturados.\n", signal_count);
+    printf("\n\n>>> CAPTURA CONCLUÍDA! %d sinais capturados.\n", signal_count);
     print_all_raw_signals_data();
     
     printf("\n>>> CAPTURA FINALIZADA!\n");
-    printf("Agora copie os dados rawSignal[] e cole no cdigo transmissor.\n");
-    printf("Formato totalmente compatvel com o transmissor!\n");
+    printf("Agora copie os dados rawSignal[] e cole no código transmissor.\n");
+    printf("Formato totalmente compatível com o transmissor!\n");
     
     // Pisca LED para indicar fim
     while (true) {
@@ -427,7 +606,9 @@ int main() {
         sleep_ms(250);
         
         // Continua processando comandos
+        ir_log_flush(0);
         process_commands();
+        health_task();
     }
     
     return 0;
@@ -0,0 +1,169 @@
+/**
+ * slot_transmit.c - Transmissão por PIO de RC5, RC6 e SIRC
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+#include "hardware/clocks.h"
+
+#include "slot_transmit.h"
+#include "slot_burst.pio.h"
+#include "slot_control.pio.h"
+
+// Intervalo entre inícios de quadros repetidos, em unidades
+#define RC5_PERIOD_UNITS 128            // 113,8 ms
+#define RC6_PERIOD_UNITS 240            // 106,7 ms
+#define SIRC_PERIOD_UNITS 75            // 45 ms
+
+typedef struct {
+    uint32_t *words;
+    size_t slots;
+} slot_builder_t;
+
+static void builder_start(slot_builder_t *b, uint32_t *words) {
+    memset(words, 0, SLOT_TX_MAX_WORDS * sizeof(uint32_t));
+    b->words = words;
+    b->slots = 0;
+}
+
+static void put_slots(slot_builder_t *b, bool mark, uint count) {
+    for (uint i = 0; i < count && b->slots < SLOT_TX_MAX_SLOTS; i++) {
+        if (mark) {
+            b->words[1 + b->slots / 32] |= 1u << (b->slots % 32);
+        }
+        b->slots++;
+    }
+}
+
+// Bit Manchester: first_mark = o bit começa com marca
+static void put_manchester(slot_builder_t *b, bool first_mark, uint width) {
+    put_slots(b, first_mark, width);
+    put_slots(b, !first_mark, width);
+}
+
+static size_t builder_finish(slot_builder_t *b, uint period_units) {
+    // O cabeçalho toma um slot do intervalo
+    uint32_t gap = period_units > b->slots + 1 ? period_units - b->slots - 1 : 1;
+    b->words[0] = (uint32_t)(b->slots - 1) | (gap - 1) << 16;
+    return 1 + (b->slots + 31) / 32;
+}
+
+bool slot_tx_init(slot_tx_t *tx, PIO pio, uint pin, const slot_tx_config_t *config) {
+    if (!pio_can_add_program(pio, &slot_burst_program)) {
+        return false;
+    }
+    uint burst_offset = pio_add_program(pio, &slot_burst_program);
+    int burst_sm = pio_claim_unused_sm(pio, false);
+    if (burst_sm < 0) {
+        return false;
+    }
+
+    if (!pio_can_add_program(pio, &slot_control_program)) {
+        return false;
+    }
+    uint control_offset = pio_add_program(pio, &slot_control_program);
+    int control_sm = pio_claim_unused_sm(pio, false);
+    if (control_sm < 0) {
+        return false;
+    }
+
+    // Rajada: períodos por unidade, lidos uma vez pelo programa
+    slot_burst_program_init(pio, (uint)burst_sm, burst_offset, pin, (float)config->carrier_hz);
+    pio_sm_put(pio, (uint)burst_sm, config->unit_cycles - 1u);
+    pio_sm_set_enabled(pio, (uint)burst_sm, true);
+
+    float slot_rate = (float)config->carrier_hz / config->unit_cycles;
+    slot_control_program_init(pio, (uint)control_sm, control_offset, slot_rate);
+
+    tx->pio = pio;
+    tx->sm = (uint)control_sm;
+    tx->toggle = false;
+    return true;
+}
+
+size_t slot_tx_encode_rc5(slot_tx_t *tx, uint8_t address, uint8_t command, bool repeat, uint32_t *words) {
+    if (!repeat) {
+        tx->toggle = !tx->toggle;
+    }
+
+    // S1, S2 (comando 6 invertido no RC5X), toggle, 5 de endereço, 6 de comando
+    uint32_t frame = 1u << 13 | (uint32_t)!(command & 0x40) << 12 | (uint32_t)tx->toggle << 11 |
+                     (uint32_t)(address & 0x1f) << 6 | (command & 0x3f);
+
+    slot_builder_t b;
+    builder_start(&b, words);
+    for (int i = 13; i >= 0; i--) {
+        put_manchester(&b, !((frame >> i) & 1), 1);   // RC5: 1 = silêncio, marca
+    }
+    return builder_finish(&b, RC5_PERIOD_UNITS);
+}
+
+size_t slot_tx_encode_rc6(slot_tx_t *tx, uint8_t address, uint8_t command, bool repeat, uint32_t *words) {
+    if (!repeat) {
+        tx->toggle = !tx->toggle;
+    }
+
+    slot_builder_t b;
+    builder_start(&b, words);
+    put_slots(&b, true, 6);                         // Cabeçalho
+    put_slots(&b, false, 2);
+    put_manchester(&b, true, 1);                    // Bit de início (1)
+    for (int i = 0; i < 3; i++) {
+        put_manchester(&b, false, 1);               // Modo 0
+    }
+    put_manchester(&b, tx->toggle, 2);              // Toggle, largura dupla
+
+    uint16_t data = (uint16_t)(address << 8 | command);
+    for (int i = 15; i >= 0; i--) {
+        put_manchester(&b, (data >> i) & 1, 1);     // RC6: 1 = marca, silêncio
+    }
+    return builder_finish(&b, RC6_PERIOD_UNITS);
+}
+
+size_t slot_tx_encode_sirc(const slot_tx_t *tx, uint bits, uint8_t command, uint16_t address, uint32_t *words) {
+    (void)tx;
+    if (bits != 12 && bits != 15 && bits != 20) {
+        return 0;
+    }
+
+    slot_builder_t b;
+    builder_start(&b, words);
+    put_slots(&b, true, 4);                         // Cabeçalho de 2,4 ms
+    put_slots(&b, false, 1);
+
+    // Comando e endereço a partir do bit menos significativo
+    uint32_t data = (uint32_t)(command & 0x7f) | (uint32_t)address << 7;
+    for (uint i = 0; i < bits; i++) {
+        put_slots(&b, true, (data >> i) & 1 ? 2 : 1);
+        put_slots(&b, false, 1);
+    }
+    return builder_finish(&b, SIRC_PERIOD_UNITS);
+}
+
+void slot_tx_send_words(const slot_tx_t *tx, const uint32_t *words, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        pio_sm_put_blocking(tx->pio, tx->sm, words[i]);
+    }
+}
+
+void slot_tx_send_rc5(slot_tx_t *tx, uint8_t address, uint8_t command, bool repeat) {
+    uint32_t words[SLOT_TX_MAX_WORDS];
+    slot_tx_send_words(tx, words, slot_tx_encode_rc5(tx, address, command, repeat, words));
+}
+
+void slot_tx_send_rc6(slot_tx_t *tx, uint8_t address, uint8_t command, bool repeat) {
+    uint32_t words[SLOT_TX_MAX_WORDS];
+    slot_tx_send_words(tx, words, slot_tx_encode_rc6(tx, address, command, repeat, words));
+}
+
+bool slot_tx_send_sirc(const slot_tx_t *tx, uint bits, uint8_t command, uint16_t address) {
+    uint32_t words[SLOT_TX_MAX_WORDS];
+    size_t n = slot_tx_encode_sirc(tx, bits, command, address, words);
+    slot_tx_send_words(tx, words, n);
+    return n > 0;
+}
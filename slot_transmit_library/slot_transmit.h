@@ -0,0 +1,96 @@
+/**
+ * slot_transmit.h - Transmissão por PIO de RC5, RC6 e SIRC
+ *
+ * Os três protocolos são sequências de unidades de tempo com marca ou
+ * silêncio: RC5 (Manchester, unidade de 889 us) e RC6 modo 0 (Manchester com
+ * cabeçalho e bit de toggle de largura dupla, unidade de 444 us) a 36 kHz, e
+ * SIRC (largura de pulso, unidade de 600 us) a 40 kHz. O quadro vai ao PIO
+ * como um bit por unidade (slot_control.pio), e as rajadas de carrier saem de
+ * outra state machine (slot_burst.pio), na mesma divisão controle/rajada do
+ * nec_transmit. Um quadro são 2 a 4 escritas no FIFO, já com o intervalo até
+ * a repetição, e nenhum trabalho da CPU por bit.
+ *
+ * O toggle do RC5/RC6 fica no slot_tx_t: muda a cada tecla nova e se
+ * mantém nas repetições (repeat = true).
+ *
+ * Os dois programas ocupam 19 das 32 instruções de um PIO.
+ *
+ * Copyright (c) 2024
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef SLOT_TRANSMIT_H
+#define SLOT_TRANSMIT_H
+
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SLOT_TX_MAX_SLOTS 96
+#define SLOT_TX_MAX_WORDS (1 + SLOT_TX_MAX_SLOTS / 32)
+
+typedef struct {
+    uint32_t carrier_hz;
+    uint16_t unit_cycles;               // Períodos de carrier por unidade de tempo
+} slot_tx_config_t;
+
+#define SLOT_TX_CONFIG_RC5 ((slot_tx_config_t){36000, 32})     // 889 us
+#define SLOT_TX_CONFIG_RC6 ((slot_tx_config_t){36000, 16})     // 444 us
+#define SLOT_TX_CONFIG_SIRC ((slot_tx_config_t){40000, 24})    // 600 us
+
+typedef struct {
+    PIO pio;
+    uint sm;                            // State machine de controle
+    bool toggle;                        // Último toggle enviado (RC5/RC6)
+} slot_tx_t;
+
+/**
+ * Carrega os dois programas e liga as state machines
+ *
+ * @return false se não houver espaço no PIO ou state machines livres
+ */
+bool slot_tx_init(slot_tx_t *tx, PIO pio, uint pin, const slot_tx_config_t *config);
+
+/**
+ * Monta as palavras de um quadro RC5 (RC5X para comandos acima de 63)
+ *
+ * @param address Endereço (5 bits)
+ * @param command Comando (7 bits)
+ * @param repeat false em uma tecla nova (inverte o toggle)
+ * @param words Recebe até SLOT_TX_MAX_WORDS palavras
+ * @return Quantidade de palavras
+ */
+size_t slot_tx_encode_rc5(slot_tx_t *tx, uint8_t address, uint8_t command, bool repeat, uint32_t *words);
+
+/**
+ * Monta as palavras de um quadro RC6 modo 0 (8 bits de endereço e comando)
+ */
+size_t slot_tx_encode_rc6(slot_tx_t *tx, uint8_t address, uint8_t command, bool repeat, uint32_t *words);
+
+/**
+ * Monta as palavras de um quadro SIRC
+ *
+ * @param bits 12, 15 ou 20
+ * @param command Comando (7 bits)
+ * @param address Endereço (5, 8 ou 13 bits, conforme bits)
+ * @return Quantidade de palavras (0 se bits não é 12, 15 ou 20)
+ */
+size_t slot_tx_encode_sirc(const slot_tx_t *tx, uint bits, uint8_t command, uint16_t address, uint32_t *words);
+
+/**
+ * Escreve as palavras de um quadro no FIFO, esperando espaço se preciso
+ */
+void slot_tx_send_words(const slot_tx_t *tx, const uint32_t *words, size_t count);
+
+void slot_tx_send_rc5(slot_tx_t *tx, uint8_t address, uint8_t command, bool repeat);
+void slot_tx_send_rc6(slot_tx_t *tx, uint8_t address, uint8_t command, bool repeat);
+bool slot_tx_send_sirc(const slot_tx_t *tx, uint bits, uint8_t command, uint16_t address);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SLOT_TRANSMIT_H